@@ -7,11 +7,15 @@ psycommando@gmail.com
 Description:
     This is used to access a blob, aka unstructured data piled up, of DSE containers like SWDL, SMDL, and SEDL.
     Can also be used on NDS ROMs directly, but only when the data doesn't uses a main bank, unless the main bank name is specified.
+    For large files, use a BlobScanner<const uint8_t*> over a utils::io::MappedFile, so the file never has to be loaded entirely.
 */
 #include <string>
 #include <vector>
 #include <iostream>
 #include <iomanip>
+#include <iterator>
+#include <algorithm>
+#include <cstring>
 #include <dse/dse_common.hpp>
 #include <dse/dse_containers.hpp>
 
@@ -35,6 +39,8 @@ namespace DSE
         };
 
         static const uint8_t FirstCharacterDSEMagicNum = 0x73;
+        static const size_t  OffsetDSECntFileLen       = 8;
+        static const size_t  OffsetDSECntVersion       = 12;
         static const size_t  OffsetDSECntFilename      = 32;
         static const size_t  FilenameLength            = 16;
         
@@ -50,7 +56,6 @@ namespace DSE
         size_t Scan( bool bquiet = false )
         {
             using namespace std;
-            size_t offset = 0;
 
             if( utils::LibWide().isLogOn() )
             {
@@ -59,43 +64,28 @@ namespace DSE
                      <<"========================================\n";
             }
 
-            for( auto itby = m_srcbeg; itby != m_srcend;  )
+            for( auto itby = FindNextMagicCandidate(m_srcbeg); itby != m_srcend; itby = FindNextMagicCandidate(itby) )
             {
-                if( *itby == FirstCharacterDSEMagicNum )
+                //Try to see if its indeed the beginning of a DSE header!
+                eDSEContainers cntty = ValidateContainerHeader(itby);
+                if( cntty != eDSEContainers::invalid )
                 {
-                    //Try to see if its indeed the beginning of a DSE header!
-                    uint32_t fullmagic   = 0;
-                    auto     itbefmagicn = itby; //Save our position before the magic number
-                    auto     aftermagicn = utils::ReadIntFromBytes( fullmagic, itby, m_srcend, false );
+                    const size_t possibleoffset = static_cast<size_t>( std::distance( m_srcbeg, itby ) );
+                    itby = HandleContainer( itby, cntty );
 
-                    eDSEContainers cntty = IntToContainerMagicNum( fullmagic );
-                    if( cntty != eDSEContainers::invalid )
+                    if(!bquiet)
                     {
-                        size_t possibleoffset = offset;
-                        itby = HandleContainer( aftermagicn, itbefmagicn, cntty, offset );
+                        stringstream sstr;
+                        sstr << "<*>- Found container off: 0x" <<hex <<uppercase <<possibleoffset <<nouppercase <<dec <<", " <<m_toc.back()._name <<", of type " <<hex <<showbase <<cntty <<noshowbase <<dec <<" !\n";
+                        string txt = sstr.str();
+                        cout << txt;
 
-                        if(!bquiet)
-                        {
-                            stringstream sstr;
-                            sstr << "<*>- Found container off: 0x" <<hex <<uppercase <<possibleoffset <<nouppercase <<dec <<", " <<m_toc.back()._name <<", of type " <<hex <<showbase <<cntty <<noshowbase <<dec <<" !\n";
-                            string txt = sstr.str();
-                            cout << txt;
-
-                            if( utils::LibWide().isLogOn() )
-                                clog << txt;
-                        }
-                    }
-                    else
-                    {
-                        ++itby; 
-                        ++offset;
+                        if( utils::LibWide().isLogOn() )
+                            clog << txt;
                     }
                 }
                 else
-                {
-                    ++itby; 
-                    ++offset;
-                }
+                    ++itby;
             }
 
             if( utils::LibWide().isLogOn() )
@@ -104,6 +94,30 @@ namespace DSE
             return m_toc.size();
         }
 
+        /*
+            GetToC
+                Returns all the containers found by the last scan, in the order they appear in the blob.
+                Nothing is parsed, the entries only refer to the blob's data.
+        */
+        inline const std::vector<FoundContainer> & GetToC()const
+        {
+            return m_toc;
+        }
+
+        /*
+            ListContainersOfType
+                Returns only the containers of the type specified, so callers can parse just what they need.
+        */
+        std::vector<FoundContainer> ListContainersOfType( eDSEContainers cntty )
+        {
+            if( m_toc.empty() )
+                Scan();
+
+            std::vector<FoundContainer> matches;
+            std::copy_if( m_toc.begin(), m_toc.end(), std::back_inserter(matches), [cntty]( const FoundContainer & cn ){ return cn._type == cntty; } );
+            return matches;
+        }
+
         std::vector<std::pair<FoundContainer,FoundContainer>> ListAllMatchingSMDLPairs()
         {
             using namespace std;
@@ -183,13 +197,69 @@ namespace DSE
 
     private:
 
-        inputiterator HandleContainer( inputiterator itaftermagicnum, inputiterator itbefmagicnum, eDSEContainers cnty, size_t & offset )
+        /*
+            FindNextMagicCandidate
+                Returns the position of the next byte that could be the first character of a DSE magic number.
+                Contiguous data, like a mapped file, is searched with memchr, which the C runtime implements 
+                with SIMD instructions.
+        */
+        inputiterator FindNextMagicCandidate( inputiterator itfrom )const
+        {
+            if constexpr( std::contiguous_iterator<inputiterator> )
+            {
+                if( itfrom == m_srcend )
+                    return m_srcend;
+                const uint8_t * pfrom  = reinterpret_cast<const uint8_t*>( std::to_address(itfrom) );
+                const void    * pfound = std::memchr( pfrom, FirstCharacterDSEMagicNum, static_cast<size_t>( std::distance(itfrom, m_srcend) ) );
+                if( pfound == nullptr )
+                    return m_srcend;
+                return std::next( itfrom, static_cast<const uint8_t*>(pfound) - pfrom );
+            }
+            else
+                return std::find( itfrom, m_srcend, FirstCharacterDSEMagicNum );
+        }
+
+        /*
+            ValidateContainerHeader
+                Checks the magic number, and the fields of the common DSE header, at the position specified.
+                Returns eDSEContainers::invalid if the data there is not a DSE container header.
+        */
+        eDSEContainers ValidateContainerHeader( inputiterator itbeg )const
+        {
+            //Must at least fit the header up to the end of the filename
+            if( static_cast<size_t>( std::distance( itbeg, m_srcend ) ) < (OffsetDSECntFilename + FilenameLength) )
+                return eDSEContainers::invalid;
+
+            uint32_t magicn  = 0;
+            uint32_t flen    = 0;
+            uint16_t version = 0;
+            utils::ReadIntFromBytes( magicn, itbeg, m_srcend, false );
+            eDSEContainers cntty = IntToContainerMagicNum( magicn );
+            if( cntty == eDSEContainers::invalid )
+                return eDSEContainers::invalid;
+
+            //A non-zero file length can't be smaller than the header itself
+            utils::ReadIntFromBytes( flen, std::next(itbeg, OffsetDSECntFileLen), m_srcend );
+            if( flen != 0 && flen < (OffsetDSECntFilename + FilenameLength) )
+                return eDSEContainers::invalid;
+
+            //sadl files don't use the same versioning scheme
+            utils::ReadIntFromBytes( version, std::next(itbeg, OffsetDSECntVersion), m_srcend );
+            if( cntty != eDSEContainers::sadl && intToDseVer(version) == eDSEVersion::VInvalid )
+            {
+                if( utils::LibWide().isLogOn() && utils::LibWide().isVerboseOn() )
+                    std::clog << "<!>- BlobScanner: Ignored DSE magic number with unknown version 0x" <<std::hex <<version <<std::dec <<"!\n";
+                return eDSEContainers::invalid;
+            }
+            return cntty;
+        }
+
+        inputiterator HandleContainer( inputiterator itbefmagicnum, eDSEContainers cnty )
         {
             using namespace std;
-            //All DSE containers have a filesize 4 bytes after their magic number
-            std::advance( itaftermagicnum, 4 );
+            //All DSE containers have a filesize 8 bytes from their magic number
             uint32_t flen = 0;
-            itaftermagicnum = utils::ReadIntFromBytes( flen, itaftermagicnum, m_srcend, true );
+            utils::ReadIntFromBytes( flen, std::next(itbefmagicnum, OffsetDSECntFileLen), m_srcend );
 
             //Readfilename
             inputiterator itname = itbefmagicnum;
@@ -205,19 +275,16 @@ namespace DSE
                     clog << "<!>- Warning: DSE container has an illegal size of 0!\n\tFalling back to end chunk search to determine size!\n";
 
                 //Search for the eoc/eod chunk manually
-                inputiterator itfound = DSE::FindEndChunk( itaftermagicnum, m_srcend, cnty );
+                inputiterator itfound = DSE::FindEndChunk( std::next(itbefmagicnum, OffsetDSECntVersion), m_srcend, cnty );
                 if( itfound != m_srcend)
                     itend = utils::advAsMuchAsPossible( itfound, m_srcend, DSE::ChunkHeader::Size ); //Skip over the end chunk
                 else
                     itend = m_srcend;
-
-                offset += static_cast<size_t>(std::distance( itbefmagicnum, itend ));
             }
             else
             {
                 //Find the end, and add the entry to the ToC!
                 itend = utils::advAsMuchAsPossible( itbefmagicnum, m_srcend, flen );
-                offset += flen;
             }
             m_toc.push_back( FoundContainer{ string(itname, itnameed), cnty, itbefmagicnum, itend } );
             return itend;
@@ -255,6 +255,23 @@ namespace DSE
         volprop_t  sustain;
         timeprop_t decay2;
         timeprop_t release;
+
+        inline bool operator==( const DSEEnvelope & other )const
+        {
+            return ( envmulti == other.envmulti && 
+                     atkvol   == other.atkvol   && 
+                     attack   == other.attack   && 
+                     hold     == other.hold     && 
+                     decay    == other.decay    && 
+                     sustain  == other.sustain  && 
+                     decay2   == other.decay2   && 
+                     release  == other.release  );
+        }
+
+        inline bool operator!=( const DSEEnvelope & other )const
+        {
+            return !( operator==(other));
+        }
     };
 
     /****************************************************************************************
@@ -275,26 +292,23 @@ namespace DSE
         bool                hasLength ()const { return (datlen != SpecialChunkLen); } //Returns whether this chunk has a valid data length
         eDSEChunks          GetChunkID()const { return IntToChunkID( label ); } //Returns the enum value representing this chunk's identity, judging from the label
 
+        typedef utils::binlayout< utils::binfield<&ChunkHeader::label, utils::eByteOrder::Big>,
+                                  utils::binfield<&ChunkHeader::param1>,
+                                  utils::binfield<&ChunkHeader::param2>,
+                                  utils::binfield<&ChunkHeader::datlen> > layout_t;
+
         //Write the structure using an iterator to a byte container
         template<class _outit>
             _outit WriteToContainer( _outit itwriteto )const
         {
-            itwriteto = utils::WriteIntToBytes( label,  itwriteto, false );
-            itwriteto = utils::WriteIntToBytes( param1, itwriteto );
-            itwriteto = utils::WriteIntToBytes( param2, itwriteto );
-            itwriteto = utils::WriteIntToBytes( datlen, itwriteto );
-            return itwriteto;
+            return layout_t::Write( *this, itwriteto );
         }
 
         //Read the structure from an iterator on a byte container
         template<class _init>
             _init ReadFromContainer(  _init itReadfrom, _init itpastend )
         {
-            label   = utils::ReadIntFromBytes<decltype(label)> (itReadfrom, itpastend, false ); //iterator is incremented
-            param1  = utils::ReadIntFromBytes<decltype(param1)>(itReadfrom, itpastend);
-            param2  = utils::ReadIntFromBytes<decltype(param2)>(itReadfrom, itpastend);
-            datlen  = utils::ReadIntFromBytes<decltype(datlen)>(itReadfrom, itpastend);
-            return itReadfrom;
+            return layout_t::Read( *this, itReadfrom, itpastend );
         }
     };
 
@@ -347,6 +361,37 @@ namespace DSE
         int8_t      hold       = 0;
         int8_t      decay2     = 0;
         int8_t      release    = 0;
+
+        inline bool operator==( const WavInfo & other )const
+        {
+            return ( id       == other.id       && 
+                     ftune    == other.ftune    && 
+                     ctune    == other.ctune    && 
+                     rootkey  == other.rootkey  && 
+                     ktps     == other.ktps     && 
+                     vol      == other.vol      && 
+                     pan      == other.pan      && 
+                     smplfmt  == other.smplfmt  && 
+                     smplloop == other.smplloop && 
+                     smplrate == other.smplrate && 
+                     smplpos  == other.smplpos  && 
+                     loopbeg  == other.loopbeg  && 
+                     looplen  == other.looplen  && 
+                     envon    == other.envon    && 
+                     envmult  == other.envmult  && 
+                     atkvol   == other.atkvol   && 
+                     attack   == other.attack   && 
+                     decay    == other.decay    && 
+                     sustain  == other.sustain  && 
+                     hold     == other.hold     && 
+                     decay2   == other.decay2   && 
+                     release  == other.release  );
+        }
+
+        inline bool operator!=( const WavInfo & other )const
+        {
+            return !( operator==(other));
+        }
     };
 
 
@@ -440,6 +485,25 @@ namespace DSE
                         unk33 != 0 );
         }
 
+        inline bool operator==( const LFOTblEntry & other )const
+        {
+            return ( unk34  == other.unk34  && 
+                     unk52  == other.unk52  && 
+                     dest   == other.dest   && 
+                     wshape == other.wshape && 
+                     rate   == other.rate   && 
+                     unk29  == other.unk29  && 
+                     depth  == other.depth  && 
+                     delay  == other.delay  && 
+                     unk32  == other.unk32  && 
+                     unk33  == other.unk33  );
+        }
+
+        inline bool operator!=( const LFOTblEntry & other )const
+        {
+            return !( operator==(other));
+        }
+
         template<class _outit>
             _outit WriteToContainer( _outit itwriteto )const
         {
@@ -501,6 +565,36 @@ namespace DSE
         uint8_t     kgrpid    = 0; //0x1A
         uint8_t     envon     = 0; //0x20
         DSEEnvelope env;
+
+        inline bool operator==( const SplitEntry & other )const
+        {
+            return ( id      == other.id      && 
+                     unk11   == other.unk11   && 
+                     unk25   == other.unk25   && 
+                     lowkey  == other.lowkey  && 
+                     hikey   == other.hikey   && 
+                     lowkey2 == other.lowkey2 && 
+                     hikey2  == other.hikey2  && 
+                     lovel   == other.lovel   && 
+                     hivel   == other.hivel   && 
+                     lovel2  == other.lovel2  && 
+                     hivel2  == other.hivel2  && 
+                     smplid  == other.smplid  && 
+                     ftune   == other.ftune   && 
+                     ctune   == other.ctune   && 
+                     rootkey == other.rootkey && 
+                     ktps    == other.ktps    && 
+                     smplvol == other.smplvol && 
+                     smplpan == other.smplpan && 
+                     kgrpid  == other.kgrpid  && 
+                     envon   == other.envon   && 
+                     env     == other.env     );
+        }
+
+        inline bool operator!=( const SplitEntry & other )const
+        {
+            return !( operator==(other));
+        }
     };
 
     /*****************************************************************************************
@@ -522,6 +616,23 @@ namespace DSE
 
         std::vector<LFOTblEntry> m_lfotbl;
         std::vector<SplitEntry>  m_splitstbl;
+
+        inline bool operator==( const ProgramInfo & other )const
+        {
+            return ( id          == other.id          && 
+                     prgvol      == other.prgvol      && 
+                     prgpan      == other.prgpan      && 
+                     unkpoly     == other.unkpoly     && 
+                     unk4        == other.unk4        && 
+                     padbyte     == other.padbyte     && 
+                     m_lfotbl    == other.m_lfotbl    && 
+                     m_splitstbl == other.m_splitstbl );
+        }
+
+        inline bool operator!=( const ProgramInfo & other )const
+        {
+            return !( operator==(other));
+        }
     };
 
 
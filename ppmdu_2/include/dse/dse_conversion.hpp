@@ -246,6 +246,13 @@ namespace DSE
         */
         void ExportMIDIs( const std::string & destdir, const std::string & cvinfopath = "", int nbloops = 0 );
 
+        /*
+            ExportWAVs
+                Render all the loaded sequences to 32 bits float WAVE files, using the master bank's samples
+                if one was loaded. Sequences are rendered in parallel.
+        */
+        void ExportWAVs( const std::string & destdir, int nbloops = 0 );
+
     //
     //
     //
@@ -519,8 +526,12 @@ void PresetBankToXML( const DSE::PresetBank & srcbnk, const std::string & destdi
 /*
     XMLToPresetBank
         Read the 3 XML files for a given set of presets and samples.
+        The second version applies the XML files over the preset bank they were exported from, and returns it.
+        The sample data and the fields that aren't exported are kept from "basebnk". Samples missing from 
+        "basebnk" can't be added this way.
 */
 DSE::PresetBank XMLToPresetBank( const std::string & srcdir );
+DSE::PresetBank XMLToPresetBank( const std::string & srcdir, DSE::PresetBank && basebnk );
 
 };
 
@@ -29,7 +29,7 @@ namespace DSE
 
     inline uint32_t ConvertMicrosecPerQuarterNoteToBPM( uint32_t mpqn )
     {
-        return mpqn / NbMicrosecPerMinute;
+        return NbMicrosecPerMinute / mpqn;
     }
 
 //===============================================================================
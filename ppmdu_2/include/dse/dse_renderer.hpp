@@ -0,0 +1,101 @@
+#ifndef DSE_RENDERER_HPP
+#define DSE_RENDERER_HPP
+/*
+dse_renderer.hpp
+2016/07/02
+psycommando@gmail.com
+Description: Offline software renderer for DSE music sequences. Plays back the events of a MusicSequence
+             using the programs and samples of a SWDL, and mixes everything into a stereo floating point
+             bus that can be written to a WAVE file.
+
+             This is meant for making quick reference renders, not for emulating the NDS mixer bit for bit.
+*/
+#include <dse/dse_common.hpp>
+#include <dse/dse_containers.hpp>
+#include <cstdint>
+#include <vector>
+#include <string>
+
+namespace DSE
+{
+//====================================================================================================
+//  Constants
+//====================================================================================================
+    const uint32_t DSE_RenderDefSmplRate  = 44100;   //Default output sample rate of the renderer
+    const uint32_t DSE_RenderBlockLen     = 256;     //Nb of output samples processed at once by the mixer kernels
+
+//====================================================================================================
+//  Structs
+//====================================================================================================
+
+    /*
+        RenderParams
+            Settings for the offline renderer.
+    */
+    struct RenderParams
+    {
+        uint32_t samplerate = DSE_RenderDefSmplRate;
+        int      nbloops    = 0;        //Nb of times to play the looped section of a track. 0 plays the song once, ignoring loop points.
+        float    fadeoutsec = 8.0f;     //Duration of the fade out applied once all loops were played. Unused when nbloops is 0.
+        float    maxlensec  = 900.0f;   //Hard limit on the length of a render, in case a sequence never ends.
+        float    mastergain = 0.5f;     //Gain applied to the whole mix, to leave some headroom.
+        bool     lfoenabled = true;     //Whether LFOs from the program's LFO table are applied.
+    };
+
+    /*
+        RenderedAudio
+            The result of a render. One vector of samples per stereo channel.
+    */
+    struct RenderedAudio
+    {
+        uint32_t           samplerate = 0;
+        std::vector<float> left;
+        std::vector<float> right;
+    };
+
+    /*
+        RenderJob
+            A single sequence to render as part of a batch.
+            The sequence's program bank, and the sample bank its splits refer to, are passed separately,
+            since in PMD2 most songs get their samples from the master bank.
+            All pointed objects must stay alive until the batch completes.
+    */
+    struct RenderJob
+    {
+        const MusicSequence * pseq   = nullptr;
+        const ProgramBank   * pprgms = nullptr;
+        const SampleBank    * psmpls = nullptr;
+        std::string           outpath;
+    };
+
+//====================================================================================================
+//  Functions
+//====================================================================================================
+
+    /*
+        RenderSequence
+            Plays back the sequence using the programs and samples specified, and returns the mixed
+            stereo output.
+    */
+    RenderedAudio RenderSequence( const MusicSequence & seq,
+                                  const ProgramBank   & prgms,
+                                  const SampleBank    & smpls,
+                                  const RenderParams  & params = RenderParams() );
+
+    /*
+        WriteRenderToWave
+            Writes a rendered sequence as a 32 bits IEEE float stereo WAVE file.
+    */
+    void WriteRenderToWave( const RenderedAudio & audio, const std::string & fpath );
+
+    /*
+        RenderSequencesToWave
+            Renders every jobs in the list and writes each of them to their output path.
+            Jobs are spread over the number of threads set in the library wide settings.
+            Samples are decoded only once per sample bank, and shared between the jobs using it.
+    */
+    void RenderSequencesToWave( const std::vector<RenderJob> & jobs, const RenderParams & params = RenderParams() );
+
+};
+
+#endif
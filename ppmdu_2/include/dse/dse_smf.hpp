@@ -0,0 +1,78 @@
+#ifndef DSE_SMF_HPP
+#define DSE_SMF_HPP
+/*
+dse_smf.hpp
+2016/07/09
+psycommando@gmail.com
+Description: Direct Standard MIDI File writer and reader for DSE music sequences.
+             Unlike the converter in dse_interpreter.cpp, this doesn't go through jdksmidi's multitrack objects.
+             Each DSE track is turned into a MIDI track chunk in a single pass over its events, and MIDI files are
+             parsed as a stream of bytes, straight into DSE events.
+
+             The GM channel re-arranging of the jdksmidi converter isn't supported here, so GM exports still go
+             through the old converter.
+*/
+#include <dse/dse_common.hpp>
+#include <dse/dse_containers.hpp>
+#include <dse/dse_conversion_info.hpp>
+#include <dse/dse_interpreter.hpp>
+#include <cstdint>
+#include <vector>
+#include <string>
+
+namespace DSE
+{
+//====================================================================================================
+//  Constants
+//====================================================================================================
+    static const uint32_t SMF_MagicHeader = 0x4D546864; //"MThd"
+    static const uint32_t SMF_MagicTrack  = 0x4D54726B; //"MTrk"
+    static const uint32_t SMF_HeaderLen   = 6;          //Length of the data of the MThd chunk
+
+//====================================================================================================
+//  Functions
+//====================================================================================================
+
+    /*************************************************************************************************
+        SequenceToSMFData
+            Converts the sequence into the raw bytes of a format 1 standard MIDI file.
+            The first MIDI track holds the global events along with the events of the first DSE track,
+            and every other DSE tracks get their own MIDI track.
+                - seq       : The MusicSequence to export.
+                - premap    : Information on how each DSE presets translate to MIDI presets. Can be null.
+                - nbloop    : Nb of times to repeat the looped section of the song. Negative values throw.
+                - midmode   : The MIDI sub-standard to use. GM isn't supported here.
+    *************************************************************************************************/
+    std::vector<uint8_t> SequenceToSMFData( const MusicSequence            & seq,
+                                            const SMDLPresetConversionInfo * premap,
+                                            int                              nbloop  = 0,
+                                            eMIDIMode                        midmode = eMIDIMode::GS );
+
+    /*************************************************************************************************
+        SequenceToSMF
+            Same as above, but writes the result to the file specified.
+    *************************************************************************************************/
+    void SequenceToSMF( const std::string              & outmidi,
+                        const MusicSequence            & seq,
+                        const SMDLPresetConversionInfo * premap,
+                        int                              nbloop  = 0,
+                        eMIDIMode                        midmode = eMIDIMode::GS );
+
+    /*************************************************************************************************
+        ParseSMF
+            Converts the standard MIDI file in the range into a DSE sequence.
+            Format 0 files get one DSE track per MIDI channel, while format 1 files get one DSE track per
+            MIDI track.
+                - seqname : The name to give the resulting sequence.
+    *************************************************************************************************/
+    MusicSequence ParseSMF( const uint8_t * itbeg, const uint8_t * itend, const std::string & seqname );
+
+    /*************************************************************************************************
+        SMFToSequence
+            Same as above, but reads the MIDI file at the path specified.
+    *************************************************************************************************/
+    MusicSequence SMFToSequence( const std::string & inmidi );
+
+};
+
+#endif
@@ -15,7 +15,44 @@ namespace audio
 //====================================================================================================
 //  Constants
 //====================================================================================================
-    static const uint32_t IMA_ADPCM_PreambleLen = 4;//bytes
+    static const uint32_t IMA_ADPCM_PreambleLen   = 4;//bytes
+    static const uint32_t ADPCM_NDS_SmplAlignment = 8;//Nb of 4 bits samples in a 32 bits word
+
+    /*
+        eADPCMEncoder
+            The method used to pick the ADPCM nibble for each sample when encoding.
+            - Greedy  : Picks the nibble getting closest to the current sample. Fast, but the error adds up.
+            - Trellis : Keeps several candidate encoder states, and picks the path with the lowest squared 
+                        error over a bounded lookahead. Much slower, but the result is a lot cleaner.
+    */
+    enum struct eADPCMEncoder
+    {
+        Greedy,
+        Trellis,
+    };
+
+    /*
+        ADPCMEncoderParams
+            - lookahead : Nb of samples a nibble is kept undecided for, before being committed. (Trellis only, max 32)
+            - nbnodes   : Nb of candidate states kept alive for each sample. (Trellis only)
+    */
+    struct ADPCMEncoderParams
+    {
+        eADPCMEncoder encoder   = eADPCMEncoder::Trellis;
+        unsigned int  lookahead = 8;
+        unsigned int  nbnodes   = 8;
+    };
+
+    /*
+        ADPCMEncodeResult
+            The encoded sample, along with the signal to noise ratio in dB of the encoded 
+            sample compared to the original. 
+    */
+    struct ADPCMEncodeResult
+    {
+        std::vector<uint8_t> data;
+        double               snr = 0.0;
+    };
 
 //====================================================================================================
 // Functions
@@ -43,6 +80,33 @@ namespace audio
     //
     //  NDS ADPCM
     //
+
+    /*
+        EncodeADPCM_NDS
+            Encode mono PCM16 samples to NDS ADPCM, preamble included.
+            The samples are padded with the last sample to a multiple of ADPCM_NDS_SmplAlignment, 
+            so the data is 32 bits aligned like the DSE expects.
+    */
+    std::vector<uint8_t> EncodeADPCM_NDS( const std::vector<int16_t> & pcmdata,
+                                          const ADPCMEncoderParams   & params = ADPCMEncoderParams() );
+
+    /*
+        EncodeADPCM_NDS_Batch
+            Encode several mono samples in parallel, using as many threads as the library is allowed.
+            If bcomputesnr is true, each result is decoded back and its SNR computed. The SNRs are also
+            written to the log if logging is on.
+    */
+    std::vector<ADPCMEncodeResult> EncodeADPCM_NDS_Batch( const std::vector<std::vector<int16_t>> & samples,
+                                                          const ADPCMEncoderParams                & params      = ADPCMEncoderParams(),
+                                                          bool                                      bcomputesnr = true );
+
+    /*
+        ComputeSNR
+            Returns the signal to noise ratio in dB of the decoded samples, compared to the reference.
+            Only the samples both have in common are compared.
+    */
+    double ComputeSNR( const std::vector<int16_t> & reference, const std::vector<int16_t> & decoded );
+
     /*
         DecodeADPCM_NDS
             The NDS's ADPCM format has a slight difference in the way it clamps the 
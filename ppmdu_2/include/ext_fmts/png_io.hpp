@@ -58,6 +58,13 @@ namespace utils{ namespace io
         bool ExportToPNG( const _TImg_t     & in_indexed,
                           const std::string & filepath );
 
+    /*
+        Returns the content of the PNG file ExportToPNG would write, so it can be written
+        later, by a FileSink for example. Throws on error.
+    */
+    template<class _TImg_t>
+        std::vector<uint8_t> EncodeToPNG( const _TImg_t & in_indexed );
+
     /*
     */
     template<class _TImgTy>
@@ -10,6 +10,8 @@ Description:
 #include <cstdint>
 #include <vector>
 #include <string>
+#include <cstring>
+#include <deque>
 #include <ext_fmts/riff.hpp>
 
 namespace wave
@@ -324,6 +326,36 @@ namespace wave
 
     };
 
+    /************************************************
+        WaveTrait_IEEEFloat32
+            Trait for a 32 bits IEEE float wav file!
+    ************************************************/
+    class WaveTrait_IEEEFloat32 : public WaveTrait< 32, float, eAudioFormat::IEEE_FLOAT, true>
+    {
+    public:
+        template<class _init>
+           static sample_t ParseASample( _init & itread )
+        {
+            uint32_t rawsmpl = 0;
+            for( unsigned int i = 0; i < sizeof(uint32_t); ++i, ++itread )
+                rawsmpl |= static_cast<uint32_t>( static_cast<uint8_t>(*itread) ) << (i * 8);
+            sample_t tmpsmpl = 0;
+            std::memcpy( &tmpsmpl, &rawsmpl, sizeof(sample_t) );
+            return tmpsmpl;
+        }
+
+        template<class _outit>
+           static _outit WriteASample( sample_t smpl, _outit itwrite  )
+        {
+            uint32_t rawsmpl = 0;
+            std::memcpy( &rawsmpl, &smpl, sizeof(sample_t) );
+            for( unsigned int i = 0; i < sizeof(uint32_t); ++i, ++itwrite )
+                (*itwrite) = static_cast<uint8_t>(rawsmpl >> (i * 8));
+            return itwrite;
+        }
+
+    };
+
     /*************************************************************************
         WaveFile
             Represent a wave file and operations that can be performed on it.
@@ -513,6 +545,7 @@ namespace wave
 //=============================================================================
     typedef WaveFile<WaveTrait_PCM16s> PCM16sWaveFile;
     typedef WaveFile<WaveTrait_PCM8>   PCM8WaveFile;
+    typedef WaveFile<WaveTrait_IEEEFloat32> IEEEFloatWaveFile;
 };
 
 
@@ -181,9 +181,14 @@ namespace pmd2 { namespace stats
     //                                 std::vector<std::string>::const_iterator  itenditemlongdesc,
     //                                 const std::string                       & destdir );
 
+    /*
+        - bparallel : If true, the xml files are built and written on several threads.
+                      Errors are collected, and reported all at once after every file was attempted.
+    */
     void      ExportItemsToXML     ( const ItemsDB                           & srcitems,
                                      const GameText                          * pgametext,
-                                     const std::string                       & destdir );
+                                     const std::string                       & destdir,
+                                     bool                                      bparallel = false );
 
     /*
         Import item data from xml files.
@@ -196,8 +201,12 @@ namespace pmd2 { namespace stats
     //                                 std::vector<std::string>::iterator  itbegitemlongdesc,
     //                                 std::vector<std::string>::iterator  itenditemlongdesc );
 
+    /*
+        - bparallel : If true, the xml files are loaded and parsed on several threads.
+    */
     ItemsDB   ImportItemsFromXML   ( const std::string                  & srcdir, 
-                                     GameText                           * pgametext );
+                                     GameText                           * pgametext,
+                                     bool                                 bparallel = false );
 
 
 
@@ -90,18 +90,23 @@ namespace pmd2{ namespace stats
 //=====================================================================================
     /*
         Export move data to XML files.
+            - bparallel : If true, the xml files are built and written on several threads.
+                          Errors are collected, and reported all at once after every file was attempted.
     */
     void      ExportMovesToXML     ( const MoveDB                            & src1,
                                      const MoveDB                            * src2,
                                      const GameText                          * gtext,
-                                     const std::string                       & destdir );
+                                     const std::string                       & destdir,
+                                     bool                                      bparallel = false );
 
     /*
         Import move data from xml files.
+            - bparallel : If true, the xml files are loaded and parsed on several threads.
     */
     void      ImportMovesFromXML   ( const std::string                  & srcdir, 
                                      MoveDB                             & out_mvdb1,
                                      MoveDB                             * out_mvdb2,
-                                     GameText                           * gtext );
+                                     GameText                           * gtext,
+                                     bool                                 bparallel = false );
 };};
 #endif
\ No newline at end of file
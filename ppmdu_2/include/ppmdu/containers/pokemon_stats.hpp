@@ -460,9 +460,14 @@ namespace pmd2 { namespace stats
     //                                 std::vector<std::string>::const_iterator  itbegcat,
     //                                 const std::string                       & destdir );
 
+    /*
+        - bparallel : If true, the xml files are built and written on several threads. 
+                      Errors are collected, and reported all at once after every file was attempted.
+    */
     void      ExportPokemonsToXML  ( const PokemonDB                         & src,
                                      const GameText                          * gtext,
-                                     const std::string                       & destdir );
+                                     const std::string                       & destdir,
+                                     bool                                      bparallel = false );
 
     /*
         Read pokemon data from several xml files in a directory, into a PokemonDB.
@@ -475,9 +480,13 @@ namespace pmd2 { namespace stats
     //                                 std::vector<std::string>::iterator   itbegcat,
     //                                 std::vector<std::string>::iterator   itendcat );
 
+    /*
+        - bparallel : If true, the xml files are loaded and parsed on several threads.
+    */
     void      ImportPokemonsFromXML ( const std::string                 & srcdir, 
                                       PokemonDB                         & out_pkdb,
-                                      GameText                          * inout_gtext );
+                                      GameText                          * inout_gtext,
+                                      bool                                bparallel = false );
 
     /*
         Export pokemon data to XML
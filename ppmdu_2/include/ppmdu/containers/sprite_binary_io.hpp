@@ -0,0 +1,61 @@
+#ifndef SPRITE_BINARY_IO_HPP
+#define SPRITE_BINARY_IO_HPP
+/*
+sprite_binary_io.hpp
+2016/07/13
+psycommando@gmail.com
+Description:
+    Binary serialization of sprite data.
+    Meant as a much faster alternative to the xml/images directory, for tools that need to convert
+    sprites back and forth often. Everything is stored in a single file, that is read in one go.
+    The format isn't meant to be edited by hand, and isn't stable between versions of the format.
+*/
+#include <ppmdu/containers/sprite_data.hpp>
+#include <vector>
+#include <string>
+#include <memory>
+#include <cstdint>
+
+namespace pmd2 { namespace graphics
+{
+//==============================================================================================
+// Constants
+//==============================================================================================
+    static const std::string SPRITE_Binary_FileExtension = "sprbin";
+    static const uint32_t    SPRITE_Binary_MagicNumber   = 0x53505242; //"SPRB"
+    static const uint16_t    SPRITE_Binary_Version       = 1;
+
+//==============================================================================================
+// Functions
+//==============================================================================================
+
+    /*
+        SerializeSpriteToBinary
+            Writes all the data of the sprite into a byte vector, in the binary sprite format.
+    */
+    std::vector<uint8_t> SerializeSpriteToBinary( const BaseSprite * srcspr );
+
+    /*
+        ParseSpriteFromBinary
+            Rebuilds a sprite from data in the binary sprite format.
+            Returns a SpriteData<gimg::tiled_image_i4bpp> or a SpriteData<gimg::tiled_image_i8bpp>
+            depending on the sprite type stored in the data.
+            Throws if the data isn't in the expected format, or is of another version.
+    */
+    std::unique_ptr<BaseSprite> ParseSpriteFromBinary( const std::vector<uint8_t> & data );
+
+    /*
+        Export/Import a sprite to/from a binary sprite file.
+    */
+    void                        ExportSpriteToBinary  ( const BaseSprite * srcspr, const std::string & filepath );
+    std::unique_ptr<BaseSprite> ImportSpriteFromBinary( const std::string & filepath );
+
+    /*
+        IsSpriteBinaryData
+            Whether the data begins with the binary sprite format's magic number.
+    */
+    bool IsSpriteBinaryData( std::vector<uint8_t>::const_iterator itbeg, std::vector<uint8_t>::const_iterator itend );
+
+};};
+
+#endif
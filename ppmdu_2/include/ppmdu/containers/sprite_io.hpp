@@ -39,6 +39,8 @@ namespace pmd2 { namespace graphics
     static const std::string SPRITE_IMGs_DIR          = "imgs";         //Name of the sub-folder for the images
     static const std::string SPRITE_Palette_fname     = "palette.pal";
     static const std::string SPRITE_ImgsInfo_fname    = "imgsinfo.xml"; 
+    static const std::string SPRITE_Atlas_fname       = "atlas.png";    //Sheet with all the frames, in the images sub-folder
+    static const std::string SPRITE_AtlasManifest_fname = "atlas.xml";  //Position of each frames on the sheet, in the images sub-folder
 
 //=============================================================================================
 //  Structs
@@ -57,6 +59,33 @@ namespace pmd2 { namespace graphics
         uint32_t totalAnimFrms = 0;
         uint32_t totalAnimSeqs = 0;
     };
+
+    /**************************************************************
+    Position of a single frame on a sprite atlas sheet.
+        -palette : Index of the frame's palette in the manifest's 
+                   palette list, or -1 if the frame uses the 
+                   sheet's palette.
+    **************************************************************/
+    struct SpriteAtlasFrame
+    {
+        uint32_t x       = 0;
+        uint32_t y       = 0;
+        uint32_t width   = 0;
+        uint32_t height  = 0;
+        int32_t  palette = -1;
+    };
+
+    /**************************************************************
+    Content of the manifest that goes along with a sprite atlas sheet.
+    Frames are stored in image index order.
+    **************************************************************/
+    struct SpriteAtlasManifest
+    {
+        uint32_t                                        sheetwidth  = 0;
+        uint32_t                                        sheetheight = 0;
+        std::vector<SpriteAtlasFrame>                   frames;
+        std::vector<std::vector<gimg::colorRGB24>>      palettes;   //Only palettes differing from the sheet's
+    };
     
 //=============================================================================================
 // Sprite IO Handling
@@ -69,19 +98,24 @@ namespace pmd2 { namespace graphics
                      RIFF palette.
         -progress  : An atomic integer to increment all the way to 100, to indicate
                      current progress with export.
+        -useatlas  : If true, all the frames are packed into a single PNG sheet, along with
+                     a manifest listing the position of each frames, instead of one image
+                     per frame. imgtype is ignored in that case.
     */
     template<class _Sprite_T>
         void ExportSpriteToDirectory( const _Sprite_T            & srcspr, 
                                       const std::string          & outpath, 
                                       utils::io::eSUPPORT_IMG_IO   imgtype     = utils::io::eSUPPORT_IMG_IO::PNG,
                                       bool                         usexmlpal   = false,
-                                      std::atomic<uint32_t>      * progresscnt = nullptr );
+                                      std::atomic<uint32_t>      * progresscnt = nullptr,
+                                      bool                         useatlas    = false );
 
     void ExportSpriteToDirectoryPtr( const graphics::BaseSprite * srcspr, 
                                       const std::string          & outpath, 
                                       utils::io::eSUPPORT_IMG_IO   imgtype     = utils::io::eSUPPORT_IMG_IO::PNG,
                                       bool                         usexmlpal   = false,
-                                      std::atomic<uint32_t>      * progresscnt = nullptr );
+                                      std::atomic<uint32_t>      * progresscnt = nullptr,
+                                      bool                         useatlas    = false );
 
     /*
         ImportSpriteFromDirectory
@@ -94,6 +128,9 @@ namespace pmd2 { namespace graphics
             -bParseXmlPal    : Whether we should try parsing a palette from xml!
             -bNoResAutoFix   : If true, when a resolution mismatch between an image and a meta-frame occur
                                the meta-frame resolution will not be changed to match the image's!
+
+            If the images sub-folder contains an atlas manifest, the frames are cut from the atlas 
+            sheet instead, and bReadImgByIndex is ignored.
     */
     template<class _Sprite_T>
         _Sprite_T ImportSpriteFromDirectory( const std::string     & inpath, 
@@ -135,6 +172,25 @@ namespace pmd2 { namespace graphics
     eSpriteImgType QuerySpriteImgTypeFromDirectory( const std::string & dirpath );
 
 
+//=============================================================================================
+//  Sprite Atlas
+//=============================================================================================
+
+    /*
+        PackSpriteAtlas
+            Places the frames of the specified resolutions on a sheet, using shelf packing.
+            Frames are placed on 8 pixels boundaries, and the sheet's resolution is a
+            multiple of 8, so it can be stored into a tiled image.
+            Returns the manifest, with the sheet size and each frame's rectangle filled.
+    */
+    SpriteAtlasManifest PackSpriteAtlas( const std::vector<utils::Resolution> & frameres );
+
+    /*
+        Read/Write the atlas manifest xml file.
+    */
+    SpriteAtlasManifest ParseSpriteAtlasManifest( const std::string & manifestpath );
+    void                WriteSpriteAtlasManifest( const SpriteAtlasManifest & manifest, const std::string & manifestpath );
+
 //=============================================================================================
 //  XML Handling
 //=============================================================================================
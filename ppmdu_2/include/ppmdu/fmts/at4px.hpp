@@ -48,50 +48,22 @@ namespace filetypes
         inline unsigned int                  size()const {return HEADER_SZ;}
 
         //Implementations specific to at4px_header
+        typedef utils::binlayout< utils::binfield<&at4px_header::magicn>,
+                                  utils::binfield<&at4px_header::compressedsz>,
+                                  utils::binfield<&at4px_header::flaglist>,
+                                  utils::binfield<&at4px_header::decompsz> > layout_t;
+        static_assert( layout_t::Size == HEADER_SZ, "at4px_header: Layout doesn't match the header size!" );
+
         template<class _outit>
             _outit WriteToContainer( _outit itwriteto )const
         {
-
-            for( const uint8_t & abyte : magicn )
-            {
-                *itwriteto = abyte; 
-                ++itwriteto;
-            }
-
-            itwriteto = utils::WriteIntToBytes( compressedsz, itwriteto );
-
-            for( const uint8_t & aflag : flaglist )
-            {
-                *itwriteto = aflag; 
-                ++itwriteto;
-            }
-
-            itwriteto = utils::WriteIntToBytes( decompsz, itwriteto );
-
-            return itwriteto;
+            return layout_t::Write( *this, itwriteto );
         }
 
         template<class _init>
-            _init ReadFromContainer(  _init itReadfrom, _init itpastend )
+            _init ReadFromContainer( _init itReadfrom, _init itpastend )
         {
-            for( uint8_t & abyte : magicn )
-            {
-                abyte = utils::ReadIntFromBytes<uint8_t>(itReadfrom, itpastend);
-                //abyte = *itReadfrom; 
-                //++itReadfrom;
-            }
-
-            compressedsz = utils::ReadIntFromBytes<decltype(compressedsz)>(itReadfrom, itpastend); //iterator is incremented
-
-            for( uint8_t & aflag : flaglist )
-            {
-                aflag = *itReadfrom; 
-                ++itReadfrom;
-            }
-
-            decompsz = utils::ReadIntFromBytes<decltype(decompsz)>(itReadfrom, itpastend); //iterator is incremented
-
-            return itReadfrom;
+            return layout_t::Read( *this, itReadfrom, itpastend );
         }
 
         operator compression::px_info_header()const 
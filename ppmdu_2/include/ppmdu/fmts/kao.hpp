@@ -18,6 +18,7 @@ https://github.com/Zhorken
 #include <utils/utility.hpp>
 #include <ppmdu/containers/tiled_image.hpp>
 #include <ext_fmts/supported_io.hpp>
+#include <utils/file_sink.hpp>
 #include <vector>
 #include <string>
 #include <utility>
@@ -86,15 +87,19 @@ namespace filetypes
             A functor for loading/importing a kaomado file into a CKaomado object
                 * If path is folder it tries to import the folder structure.
                 * If path is a kaomado.kao file it imports the file.
+
+            In parallel mode, the portraits of a kaomado.kao file are decompressed 
+            concurrently, using the number of threads set in the library wide settings.
     ********************************************************************************/
     class KaoParser
     {
         typedef kao_toc_entry::subentry_t                         tocsubentry_t;
         typedef std::vector<kao_toc_entry::subentry_t>::size_type tocsz_t; 
+        typedef gimg::tiled_indexed_image<gimg::pixel_indexed_4bpp, gimg::colorRGB24> portrait_t; //Same as CKaomado::data_t
         static const unsigned int SUBENTRY_SIZE = kao_toc_entry::SUBENTRY_SIZE;
     public:
-        KaoParser( bool bequiet = false, bool bverbose = false )
-            :m_pImportTo(nullptr), m_bQuiet(bequiet), m_bVerbose(bverbose)
+        KaoParser( bool bequiet = false, bool bverbose = false, bool bparallel = false )
+            :m_pImportTo(nullptr), m_bQuiet(bequiet), m_bVerbose(bverbose), m_bParallel(bparallel)
         {}
 
         void operator()( const std::string & importfrom, CKaomado & importto );
@@ -102,6 +107,8 @@ namespace filetypes
     private:
 
         void                 ParseKaomado();
+        void                 ParseKaomadoParallel();
+        void                 ParsePortrait( tocsubentry_t offset, portrait_t & outimg, std::vector<uint8_t> & imgbuf );
         std::vector<uint8_t>::const_iterator ParseToCEntry( std::vector<kao_toc_entry>::size_type  & indexentry, 
                                                             std::vector<uint8_t>::const_iterator     itrawtocentry );
         uint32_t             GetLenRawPortraitData( std::vector<uint8_t>::const_iterator itdatabeg, 
@@ -122,6 +129,7 @@ namespace filetypes
         CKaomado * m_pImportTo;
         bool       m_bQuiet;
         bool       m_bVerbose;
+        bool       m_bParallel;         //Whether portraits are decompressed on several threads
 
         //Temporary variables - Parse Kaomado
         std::vector<uint8_t>                 m_kaomadoBuff;     //Buffer containing the kaomado file's raw data.
@@ -136,11 +144,16 @@ namespace filetypes
     /******************************************************************************** 
         KaoWriter
             A functor for writing/exporting portraits data into a kaomado.kao file!
+
+            In parallel mode, portraits are compressed concurrently first, and the ToC
+            and data section are assembled in order afterwards. The output is identical 
+            to the one made in sequential mode.
     ********************************************************************************/
     class KaoWriter
     {
         typedef kao_toc_entry::subentry_t                         tocsubentry_t;
         typedef std::vector<kao_toc_entry::subentry_t>::size_type tocsz_t; 
+        typedef gimg::tiled_indexed_image<gimg::pixel_indexed_4bpp, gimg::colorRGB24> portrait_t; //Same as CKaomado::data_t
         static const unsigned int SUBENTRY_SIZE = kao_toc_entry::SUBENTRY_SIZE;
     public:
 
@@ -149,7 +162,8 @@ namespace filetypes
                    const std::vector<std::string> *  psubentrynames   = nullptr,
                    bool                              zealousstrsearch = true, 
                    bool                              bequiet          = false,
-                   bool                              bverbose         = false )
+                   bool                              bverbose         = false,
+                   bool                              bparallel        = false )
             :m_bZealousStrSearch(zealousstrsearch), 
              m_pExportFrom(nullptr), 
              m_bQuiet(bequiet),
@@ -157,7 +171,9 @@ namespace filetypes
              m_pSubEntryNames(psubentrynames),
              m_itImgBuffPushBack(std::back_inserter(m_imgBuff)),
              m_itOutBuffPushBack(std::back_inserter(m_outBuff)),
-             m_bVerbose(bverbose)
+             m_bVerbose(bverbose),
+             m_bParallel(bparallel),
+             m_pSink(nullptr)
         {}
 
         //This will export a CKaomado to a "kaomado.kao" file, but will return the buffer directly
@@ -177,7 +193,13 @@ namespace filetypes
         void ExportAToCEntry( const std::vector<tocsubentry_t> & entry, const std::string & directoryname );
 
         std::vector<uint8_t> WriteToKaomado();
-        void                 WriteAPortrait( const kao_toc_entry::subentry_t & portrait );
+        void                 WriteAPortrait( const kao_toc_entry::subentry_t & portrait, const std::vector<uint8_t> * pencoded = nullptr );
+
+        //Compress all portraits referred to in the ToC concurrently. Entries for unused data slots are left empty.
+        std::vector<std::vector<uint8_t>> EncodePortraitsParallel();
+
+        //Writes the palette and the compressed image of a portrait to the output.
+        void EncodePortrait( const portrait_t & img, std::back_insert_iterator<std::vector<uint8_t>> itout, std::vector<uint8_t> & imgbuf )const;
 
     private:
         //
@@ -188,6 +210,7 @@ namespace filetypes
         bool                            m_bZealousStrSearch;    //Whether compression will use zealous string search
         bool                            m_bQuiet;               //Whether we should print at the console
         bool                            m_bVerbose;             //Whether to print more verbose output
+        bool                            m_bParallel;            //Whether portraits are compressed on several threads
         
         //Temporary variables - kaomado.kao output
         std::vector<uint8_t>                            m_outBuff;             //Kaomado output buffer
@@ -198,7 +221,8 @@ namespace filetypes
         uint32_t                                        m_curOffTocSub;        //This is the offset to write at in the output buffer the next pointer in the ToC
 
         //Temporary variables - folder output
-        eSUPPORT_IMG_IO m_exportType;
+        eSUPPORT_IMG_IO      m_exportType;
+        utils::io::FileSink *m_pSink;           //Writes the exported PNGs in the background, while exporting to folders
     };
 
 
@@ -0,0 +1,250 @@
+#ifndef NITROFS_HPP
+#define NITROFS_HPP
+/*
+nitrofs.hpp
+2016/08/05
+psycommando@gmail.com
+Description: Reads the file system of a NDS ROM image (NitroFS), so the game's files can be loaded straight
+             from the .nds file, without extracting it first. Replaced files can be patched back into the
+             image in place.
+*/
+#include <utils/binary_cursor.hpp>
+#include <utils/gfileio.hpp>
+#include <utils/virtual_fs.hpp>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace filetypes
+{
+    const std::string NDS_FileExt = "nds";
+
+    //Names of the files in the extracted ROM tree, the same as ndstool uses
+    const std::string NDS_FName_ARM9       = "arm9.bin";
+    const std::string NDS_FName_ARM7       = "arm7.bin";
+    const std::string NDS_FName_ARM9OvrTbl = "y9.bin";
+    const std::string NDS_FName_ARM7OvrTbl = "y7.bin";
+    const std::string NDS_FName_Header     = "header.bin";
+    const std::string NDS_FName_Banner     = "banner.bin";
+    const std::string NDS_DirName_Overlay  = "overlay";
+    const std::string NDS_DirName_Data     = "data";
+
+    const size_t   NDS_HeaderLen        = 0x200;
+    const size_t   NDS_BannerLen        = 0x840;
+    const size_t   NDS_FATEntryLen      = 8;
+    const size_t   NDS_OverlayEntryLen  = 32;
+    const size_t   NDS_OverlayFileIDOff = 0x18;     //Offset of the file id within an overlay table entry
+    const uint16_t NDS_FNTDirIDBase     = 0xF000;   //Directory ids in the FNT are their index plus this
+    const uint32_t NDS_FileAlignment    = 0x200;    //Where relocated files are placed, same as ndstool
+
+//======================================================================================
+//  nds_header
+//======================================================================================
+    /*
+        The part of the ROM header that locates things in the image.
+        Everything before the ARM9 binary's offset and past the header size is left out.
+    */
+    struct nds_header
+    {
+        uint32_t arm9off    = 0;
+        uint32_t arm9entry  = 0;
+        uint32_t arm9load   = 0;
+        uint32_t arm9len    = 0;
+        uint32_t arm7off    = 0;
+        uint32_t arm7entry  = 0;
+        uint32_t arm7load   = 0;
+        uint32_t arm7len    = 0;
+        uint32_t fntoff     = 0;
+        uint32_t fntlen     = 0;
+        uint32_t fatoff     = 0;
+        uint32_t fatlen     = 0;
+        uint32_t ovt9off    = 0;
+        uint32_t ovt9len    = 0;
+        uint32_t ovt7off    = 0;
+        uint32_t ovt7len    = 0;
+        uint32_t banneroff  = 0;
+        uint32_t romsize    = 0;    //Size of the used part of the image
+        uint32_t headersize = 0;
+
+        typedef utils::binlayout< utils::binpad<0x20>,
+                                  utils::binfield<&nds_header::arm9off>,
+                                  utils::binfield<&nds_header::arm9entry>,
+                                  utils::binfield<&nds_header::arm9load>,
+                                  utils::binfield<&nds_header::arm9len>,
+                                  utils::binfield<&nds_header::arm7off>,
+                                  utils::binfield<&nds_header::arm7entry>,
+                                  utils::binfield<&nds_header::arm7load>,
+                                  utils::binfield<&nds_header::arm7len>,
+                                  utils::binfield<&nds_header::fntoff>,
+                                  utils::binfield<&nds_header::fntlen>,
+                                  utils::binfield<&nds_header::fatoff>,
+                                  utils::binfield<&nds_header::fatlen>,
+                                  utils::binfield<&nds_header::ovt9off>,
+                                  utils::binfield<&nds_header::ovt9len>,
+                                  utils::binfield<&nds_header::ovt7off>,
+                                  utils::binfield<&nds_header::ovt7len>,
+                                  utils::binpad<8>,
+                                  utils::binfield<&nds_header::banneroff>,
+                                  utils::binpad<0x14>,
+                                  utils::binfield<&nds_header::romsize>,
+                                  utils::binfield<&nds_header::headersize> > layout_t;
+
+        //Offsets of the fields the patcher changes
+        static const size_t DevCapacityOff = 0x14;
+        static const size_t ARM9LenOff     = 0x2C;
+        static const size_t ARM7LenOff     = 0x3C;
+        static const size_t Ovt9LenOff     = 0x54;
+        static const size_t Ovt7LenOff     = 0x5C;
+        static const size_t RomSizeOff     = 0x80;
+        static const size_t HeaderCRCOff   = 0x15E;    //CRC16 of everything before it
+    };
+
+    /*
+        A FAT entry. The offsets are absolute, and "end" is one past the last byte.
+    */
+    struct nds_fatentry
+    {
+        uint32_t beg = 0;
+        uint32_t end = 0;
+    };
+
+//======================================================================================
+//  NitroROM
+//======================================================================================
+    /*
+        NitroROM
+            Maps a .nds file, and presents its content as the same tree ndstool extracts:
+
+                arm9.bin, arm7.bin, y9.bin, y7.bin, header.bin, banner.bin
+                overlay/overlay_0000.bin ...
+                data/...
+
+            Files are pointers into the mapped image, so nothing is read until it's used.
+            Mount it with utils::io::MountVirtualFS() to make the file utilities see it.
+
+            Files written to it are kept in memory, and read back from there, until
+            CommitChanges() patches them into the image. Files can be replaced, but
+            not added or removed, since that would change the FNT.
+    */
+    class NitroROM : public utils::io::VirtualFS
+    {
+    public:
+        static const int NoFileID = -1;
+
+        explicit NitroROM( const std::string & rompath );
+
+        bool GetFile( const std::string & relpath, const uint8_t *& out_pdata, size_t & out_len )const override;
+        bool IsDir  ( const std::string & relpath )const override;
+        bool ListDir( const std::string & relpath, std::vector<std::string> & out_names )const override;
+        bool PutFile( const std::string & relpath, const uint8_t * pdata, size_t len )override;
+
+        /*
+            Writes the replaced files into the .nds file, and reloads it.
+            A file that fits in its current slot stays there. The others go into the
+            space freed by the files that moved, or are appended after the used part
+            of the image. The FAT, the header's lengths and ROM size, and the header
+            CRC are updated to match.
+
+            The binaries outside the FAT, like arm9.bin, can only be replaced in place.
+            The data returned by GetFile() before the call isn't valid afterwards, and
+            nothing else may use the ROM while it runs.
+        */
+        void CommitChanges();
+        void DiscardChanges();
+        bool HasChanges()const;
+
+        /*
+            Returns the index in the FAT of the file at relpath, or NoFileID if it's not a FAT file.
+        */
+        int  GetFileID( const std::string & relpath )const;
+
+        inline const std::string               & GetPath  ()const { return m_rompath; }
+        inline const nds_header                & GetHeader()const { return m_hdr;     }
+        inline const std::vector<nds_fatentry> & GetFAT   ()const { return m_fat;     }
+        inline const utils::io::MappedFile     & GetImage ()const { return m_image;   }
+
+        /*
+            Lists the paths of all the files, in FAT order first, then the files outside the FAT.
+        */
+        std::vector<std::string> ListAllFiles()const;
+
+    private:
+        struct rom_node
+        {
+            bool                     isdir  = false;
+            uint32_t                 beg    = 0;
+            uint32_t                 end    = 0;
+            int                      fileid = NoFileID;
+            std::vector<std::string> children;      //Names only, directories end with a '/'
+        };
+
+        void Load();
+        void ParseHeader();
+        void ParseFAT();
+        void ParseFNT();
+        void ParseOverlayTable( uint32_t tbloff, uint32_t tbllen, const std::string & prefix );
+
+        void AddDir ( const std::string & path );
+        void AddFile( const std::string & path, uint32_t beg, uint32_t end, int fileid );
+        void AddFATFile( const std::string & path, uint32_t fileid );
+
+        const rom_node * FindNode( const std::string & relpath )const;
+
+        std::string                                   m_rompath;
+        utils::io::MappedFile                         m_image;
+        nds_header                                    m_hdr;
+        std::vector<nds_fatentry>                     m_fat;
+        std::vector<std::string>                      m_fatpaths;   //Path of each FAT entry, empty if unnamed
+        std::unordered_map<std::string, rom_node>     m_nodes;
+
+        mutable std::mutex                            m_stagedmtx;
+        std::map<std::string, std::vector<uint8_t>>   m_staged;     //Replaced files, by path
+    };
+
+//======================================================================================
+//  NitroROMMount
+//======================================================================================
+    /*
+        NitroROMMount
+            Mounts the .nds image a path is, or points into, for the lifetime of the
+            object. Ex: "game.nds/data/FONT/kaomado.kao" mounts "game.nds".
+            Lets the tools take a path inside a ROM image for input or output.
+
+            Writes to the mounted image are only saved by Commit(). They're dropped if
+            the object is destroyed first, so a failed import leaves the image as it was.
+    */
+    class NitroROMMount
+    {
+    public:
+        NitroROMMount(){}
+        explicit NitroROMMount( const std::string & path );
+        ~NitroROMMount();
+
+        NitroROMMount( const NitroROMMount & )             = delete;
+        NitroROMMount & operator=( const NitroROMMount & ) = delete;
+
+        /*
+            Returns false if there's no .nds file in the path, or if it's already mounted.
+        */
+        bool Mount( const std::string & path );
+        void Unmount();
+        void Commit();
+
+        inline bool                              IsMounted()const { return m_prom != nullptr; }
+        inline const std::shared_ptr<NitroROM> & GetROM   ()const { return m_prom; }
+
+    private:
+        std::shared_ptr<NitroROM> m_prom;
+    };
+
+    /*
+        Returns whether the path has the .nds extension.
+    */
+    bool IsNitroROMPath( const std::string & path );
+};
+
+#endif
@@ -199,8 +199,8 @@ namespace filetypes
         //Write all the file's data in the subfiles vector to the uint8_t vector passed as parameter, at the position pointed by the iterator  
         std::vector<uint8_t>::iterator WriteFileData( std::vector<uint8_t>::iterator writeat ); //#todo: it should be const, but a stupid mistake with the CPack file makes it fail..
 
-        //Write a subfile from the subfile vector to the specified file. 
-        void WriteSubFileToFile( std::vector<uint8_t> & file, const std::string & path, unsigned int fileindex );
+        //Write a subfile from the subfile vector to the specified file. "fext" is the file extension to give the file, without the dot.
+        void WriteSubFileToFile( std::vector<uint8_t> & file, const std::string & path, unsigned int fileindex, const std::string & fext );
 
         //-------------------------------
         //Variables
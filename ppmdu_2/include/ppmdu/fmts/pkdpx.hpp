@@ -50,49 +50,22 @@ namespace filetypes
         //std::vector<uint8_t>::const_iterator ReadFromContainer(  std::vector<uint8_t>::const_iterator itReadfrom );
 
         //Implementations specific to pkdpx_header
+        typedef utils::binlayout< utils::binfield<&pkdpx_header::magicn>,
+                                  utils::binfield<&pkdpx_header::compressedsz>,
+                                  utils::binfield<&pkdpx_header::flaglist>,
+                                  utils::binfield<&pkdpx_header::decompsz> > layout_t;
+        static_assert( layout_t::Size == HEADER_SZ, "pkdpx_header: Layout doesn't match the header size!" );
+
         template<class _outit>
             _outit WriteToContainer( _outit itwriteto )const
         {
-            for( const uint8_t & abyte : magicn )
-            {
-                *itwriteto = abyte; 
-                ++itwriteto;
-            }
-
-            itwriteto = utils::WriteIntToBytes( compressedsz, itwriteto );
-
-            for( const uint8_t & aflag : flaglist )
-            {
-                *itwriteto = aflag; 
-                ++itwriteto;
-            }
-
-            itwriteto = utils::WriteIntToBytes( decompsz, itwriteto );
-
-            return itwriteto;
+            return layout_t::Write( *this, itwriteto );
         }
 
         template<class _init>
             _init ReadFromContainer( _init itReadfrom, _init itPastEnd )
         {
-            for( uint8_t & abyte : magicn )
-            {
-                abyte = utils::ReadIntFromBytes<uint8_t>(itReadfrom,itPastEnd);
-                //abyte = *itReadfrom; 
-                //++itReadfrom;
-            }
-
-            compressedsz = utils::ReadIntFromBytes<decltype(compressedsz)>(itReadfrom,itPastEnd); //iterator is incremented
-
-            for( uint8_t & aflag : flaglist )
-            {
-                aflag = *itReadfrom; 
-                ++itReadfrom;
-            }
-
-            decompsz = utils::ReadIntFromBytes<decltype(decompsz)>(itReadfrom,itPastEnd); //iterator is incremented
-
-            return itReadfrom;
+            return layout_t::Read( *this, itReadfrom, itPastEnd );
         }
 
         operator compression::px_info_header()const 
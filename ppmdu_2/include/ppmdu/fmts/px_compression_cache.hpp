@@ -0,0 +1,148 @@
+#ifndef PX_COMPRESSION_CACHE_HPP
+#define PX_COMPRESSION_CACHE_HPP
+/*
+px_compression_cache.hpp
+2016/07/12
+psycommando@gmail.com
+Description: A persistent cache of PX compressed data, so images that didn't change since the last build
+             don't have to be compressed again. Entries are keyed on a hash of the raw data, the container
+             format, and the compression settings.
+
+             The cache is disabled until a cache file is loaded. It can be shared between threads.
+             Once the compressed data it holds goes over its maximum size, the least recently used
+             entries are evicted.
+*/
+#include <ppmdu/fmts/px_compression.hpp>
+#include <cstdint>
+#include <vector>
+#include <string>
+#include <map>
+#include <mutex>
+
+namespace compression
+{
+//=========================================
+// Constants
+//=========================================
+    static const uint32_t PXCache_MagicNumber = 0x50584343; //"PXCC"
+    static const uint32_t PXCache_Version     = 1;
+    static const size_t   PXCache_DefMaxSize  = 64 * 1024 * 1024; //Default maximum total length of the compressed data kept
+
+    /*
+        ePXContainer
+            The file format the PX compressed data is stored into.
+    */
+    enum struct ePXContainer : uint8_t
+    {
+        AT4PX,
+        PKDPX,
+    };
+
+//=========================================
+// Classes
+//=========================================
+    /*
+        PXCompressionCache
+            Global cache of compressed data, indexed on the data before compression.
+    */
+    class PXCompressionCache
+    {
+    public:
+        struct key_t
+        {
+            uint64_t     hash1   = 0;   //FNV-1a hash of the raw data
+            uint64_t     hash2   = 0;   //Second, independent hash of the raw data, to make collisions unlikely
+            uint32_t     rawlen  = 0;
+            ePXContainer fmt     = ePXContainer::AT4PX;
+            ePXCompLevel lvl     = ePXCompLevel::LEVEL_3;
+            bool         zealous = false;
+
+            bool operator<( const key_t & other )const;
+        };
+
+        struct entry_t
+        {
+            px_info_header       info;
+            std::vector<uint8_t> data;  //PX compressed data, without the container's header
+        };
+
+        static PXCompressionCache & GetInstance();
+
+        /*
+            Load
+                Enables the cache, and loads the entries in the file specified if it exists.
+                Save() writes back to the same file. A file that isn't a cache file, or is truncated,
+                only loses the entries that couldn't be read.
+        */
+        void Load( const std::string & cachefile );
+
+        /*
+            Save
+                Writes the cache back to the file it was loaded from, if any entries were added or evicted.
+                Entries are written from the least to the most recently used, so the order survives reloading.
+        */
+        void Save();
+
+        /*
+            SetMaxSize
+                Sets the maximum total length of the compressed data kept. When it is exceeded, the least
+                recently used entries are evicted until the cache is down to 3/4 of it. 
+        */
+        void SetMaxSize( size_t maxbytes );
+
+        bool IsEnabled()const;
+
+        bool Find  ( const key_t & key, entry_t & out );
+        void Insert( const key_t & key, entry_t && entry );
+
+        static key_t MakeKey( std::vector<uint8_t>::const_iterator itbeg,
+                              std::vector<uint8_t>::const_iterator itend,
+                              ePXContainer                         fmt,
+                              ePXCompLevel                         lvl,
+                              bool                                 bzealous );
+
+    private:
+        PXCompressionCache();
+        PXCompressionCache( const PXCompressionCache & )            = delete;
+        PXCompressionCache & operator=( const PXCompressionCache & ) = delete;
+
+        struct cached_t
+        {
+            entry_t  entry;
+            uint64_t lastuse = 0;   //Value of m_usetick when the entry was last looked up or inserted
+        };
+
+        bool ReadEntries( const std::vector<uint8_t> & filedata ); //Returns false if the data ended early
+        void EvictOverBudget();                                   //Both must be called with m_mtx locked
+
+        mutable std::mutex        m_mtx;
+        std::map<key_t, cached_t> m_entries;
+        std::string               m_cachefile;
+        bool                      m_benabled;
+        bool                      m_bmodified;
+        size_t                    m_nbhits;
+        size_t                    m_totalsize;  //Total length of the compressed data in the cache
+        size_t                    m_maxsize;
+        uint64_t                  m_usetick;
+    };
+
+//=========================================
+// Functions
+//=========================================
+    /*
+        CompressPXCached
+            Same as CompressPX, but looks the data up in the PXCompressionCache first when it is enabled.
+            Data that wasn't in the cache is compressed and then added to it.
+                - fmt : The container the data will be put into. Part of the cache key.
+    */
+    px_info_header CompressPXCached( ePXContainer                                    fmt,
+                                     std::vector<uint8_t>::const_iterator            itdatabeg,
+                                     std::vector<uint8_t>::const_iterator            itdataend,
+                                     std::back_insert_iterator<std::vector<uint8_t>> itoutbeg,
+                                     ePXCompLevel                                    compressionlvl  = ePXCompLevel::LEVEL_3,
+                                     bool                                            bZealousSearch  = false,
+                                     bool                                            displayprogress = true,
+                                     bool                                            blogenabled     = false );
+};
+
+#endif
@@ -0,0 +1,107 @@
+#ifndef ROM_PATCH_HPP
+#define ROM_PATCH_HPP
+/*
+rom_patch.hpp
+2016/08/09
+psycommando@gmail.com
+Description: Makes and applies patches between two versions of the game's files. Either version may be
+             an extracted ROM directory, or a .nds image. Each changed file is stored as a binary delta,
+             so mods can be distributed without the whole rebuilt files.
+
+             PX compressed files are compared decompressed, since a small change to their content
+             changes most of the compressed data.
+*/
+#include <ppmdu/fmts/px_compression_cache.hpp>
+#include <utils/binary_cursor.hpp>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace filetypes
+{
+    const std::string RomPatch_FileExt     = "pmdpatch";
+    const uint32_t    RomPatch_MagicNumber = 0x504D4450;   //"PMDP"
+    const uint16_t    RomPatch_Version     = 1;
+
+    /*
+        eRomPatchOp
+            What an entry does to its file.
+    */
+    enum struct eRomPatchOp : uint8_t
+    {
+        Add,        //The payload is the whole new file
+        Remove,     //No payload
+        Delta,      //The payload is a binary delta from the old file
+        PXDelta,    //The payload is a binary delta from the old file's decompressed content, which is then compressed again
+    };
+
+    /*
+        rompatch_entry
+            The change to a single file.
+    */
+    struct rompatch_entry
+    {
+        std::string               path;         //Relative to the root, with '/' as separator
+        eRomPatchOp               op        = eRomPatchOp::Delta;
+        compression::ePXContainer pxfmt     = compression::ePXContainer::PKDPX;    //For PXDelta, the settings that compress to the new file
+        compression::ePXCompLevel pxlvl     = compression::ePXCompLevel::LEVEL_3;
+        uint8_t                   pxzealous = 0;
+        uint32_t                  srclen    = 0;            //Length and hash of the old file, checked before patching it
+        uint64_t                  srchash   = 0;
+        uint32_t                  dstlen    = 0;            //Length and hash of the new file, checked after patching
+        uint64_t                  dsthash   = 0;
+        std::vector<uint8_t>      payload;
+
+        //Everything but the path and payload, which are stored after it, each preceded by their length
+        typedef utils::binlayout< utils::binfield<&rompatch_entry::op>,
+                                  utils::binfield<&rompatch_entry::pxfmt>,
+                                  utils::binfield<&rompatch_entry::pxlvl>,
+                                  utils::binfield<&rompatch_entry::pxzealous>,
+                                  utils::binfield<&rompatch_entry::srclen>,
+                                  utils::binfield<&rompatch_entry::srchash>,
+                                  utils::binfield<&rompatch_entry::dstlen>,
+                                  utils::binfield<&rompatch_entry::dsthash> > layout_t;
+    };
+
+    /*
+        rom_patch
+            The changed files, sorted by path. Unchanged files aren't in it.
+    */
+    struct rom_patch
+    {
+        std::vector<rompatch_entry> entries;
+    };
+
+    /************************************************************************
+        MakeRomPatch
+            Compares all the files under the two roots, and returns the
+            changes turning the old one into the new one.
+            Files are compared on all the threads the library is set to use.
+                - bpxaware : Whether PX compressed files are compared
+                             decompressed, when that makes a smaller patch.
+    ************************************************************************/
+    rom_patch MakeRomPatch( const std::string & oldroot, const std::string & newroot, bool bpxaware = true );
+
+    /************************************************************************
+        ApplyRomPatch
+            Patches the files under root. Every file is checked against the
+            hash in the patch, and all the new files are built, before any
+            is written. Throws if a file doesn't match, so a root the patch
+            wasn't made for is left untouched.
+
+            When root is a .nds image, the files are patched into it in
+            place. Files can't be added to, or removed from one, and its
+            header.bin is left to the image, which updates it itself.
+    ************************************************************************/
+    void ApplyRomPatch( const rom_patch & patch, const std::string & root );
+
+    /*
+        Reads and writes the patch file format:
+            - magic number, version and number of entries
+            - each entry's fixed part, then its path and payload, each preceded by their length
+    */
+    rom_patch ReadRomPatch ( const std::string & path );
+    void      WriteRomPatch( const std::string & path, const rom_patch & patch );
+};
+
+#endif
@@ -14,8 +14,10 @@ No crappyrights. All wrongs reversed !
 //#include <ppmdu/pmd2/pmd2_filetypes.hpp>
 #include <types/content_type_analyser.hpp>
 #include <utils/utility.hpp>
+#include <utils/binary_cursor.hpp>
 //#include <map>
 #include <deque>
+#include <vector>
 
 namespace filetypes
 {
@@ -50,24 +52,27 @@ namespace filetypes
             :magic(magicnumber), subheaderptr(subhdroffset), ptrPtrOffsetLst(offptrlst)
         {}
 
+        //The magic number and end zero are constants on write. They're only read for validation.
+        typedef utils::binlayout< utils::binconst<uint32_t, MagicNumber_SIR0, utils::eByteOrder::Big>,
+                                  utils::binfield<&sir0_header::subheaderptr>,
+                                  utils::binfield<&sir0_header::ptrPtrOffsetLst>,
+                                  utils::binconst<uint32_t, 0> > writelayout_t;
+        typedef utils::binlayout< utils::binfield<&sir0_header::magic, utils::eByteOrder::Big>,
+                                  utils::binfield<&sir0_header::subheaderptr>,
+                                  utils::binfield<&sir0_header::ptrPtrOffsetLst> > readlayout_t;
+
         //Implementations specific to sir0_header
         template<class _outit>
             _outit WriteToContainer( _outit itw )const    //! #TODO: Shorten name to "Write"
         {
-            itw = utils::WriteIntToBytes( MAGIC_NUMBER,    itw, false ); //Force this, to avoid bad surprises
-            itw = utils::WriteIntToBytes( subheaderptr,    itw );
-            itw = utils::WriteIntToBytes( ptrPtrOffsetLst, itw );
-            itw = utils::WriteIntToBytes( uint32_t(0),     itw ); //Force this, to avoid bad surprises
-            return itw;
+            return writelayout_t::Write( *this, itw );
         }
 
         //Reading the magic number, and endzero value is solely for validating on read. iterator past the end is just to avoid catastrophic overflow.
         template<class _init>
             _init ReadFromContainer( _init itr, _init itpastend ) //! #TODO: Shorten name to "Read"
         {
-            magic           = utils::ReadIntFromBytes<decltype(magic)>          (itr, itpastend, false ); //iterator is incremented
-            subheaderptr    = utils::ReadIntFromBytes<decltype(subheaderptr)>   (itr, itpastend ); //iterator is incremented
-            ptrPtrOffsetLst = utils::ReadIntFromBytes<decltype(ptrPtrOffsetLst)>(itr, itpastend ); //iterator is incremented
+            itr = readlayout_t::Read( *this, itr, itpastend );
             uint32_t endzero= utils::ReadIntFromBytes<decltype(endzero)>        (itr, itpastend ); //iterator is incremented
             if(endzero != 0)
                 throw std::logic_error("sir0_header::Read(): The ending zero dword for the header was not 0!!");
@@ -219,6 +224,74 @@ namespace filetypes
     ***************************************************************************/
     std::vector<uint32_t> DecodeSIR0PtrOffsetList( const std::vector<uint8_t>  &ptroffsetslst  );
 
+    /**************************************************************************
+        DecodeSIR0PtrOffsets
+            Description:
+                Decodes the encoded list of pointer offsets between pbeg 
+                and pend, appending them to out_offsets, up to the 
+                closing 0. Offsets encoded on a single byte, which are 
+                most of them, are checked and decoded 8 at a time.
+                Returns a pointer past the closing 0, or pend if there 
+                was none.
+    ***************************************************************************/
+    const uint8_t * DecodeSIR0PtrOffsets( const uint8_t * pbeg, const uint8_t * pend, std::vector<uint32_t> & out_offsets );
+
+    /***************************************************************************
+        SIR0View
+            Reads a SIR0 container in place, over a buffer it doesn't own, 
+            and that must outlive it. 
+
+            The header is validated, and the pointer offset list decoded 
+            into a sorted index, on construction. Parsers can then follow 
+            the pointers in the content and read what they point to 
+            directly from the buffer, with every pointer bounds checked.
+            Throws std::runtime_error if the container is invalid.
+    ***************************************************************************/
+    class SIR0View
+    {
+    public:
+        SIR0View( const uint8_t * pdata, size_t len );
+        explicit SIR0View( const std::vector<uint8_t> & data )
+            :SIR0View( data.data(), data.size() )
+        {}
+        SIR0View( std::vector<uint8_t> && ) = delete;   //The view would outlive the data
+
+        inline const sir0_header & Header()const { return m_hdr; }
+        inline const uint8_t     * Data  ()const { return m_pdata; }
+        inline size_t              Size  ()const { return m_len; }
+
+        //Offset of the sub-header, and the end of the content, where the encoded pointer offsets begin.
+        inline uint32_t SubHeaderOffset()const { return m_hdr.subheaderptr; }
+        inline uint32_t ContentEnd     ()const { return m_hdr.ptrPtrOffsetLst; }
+
+        //Offsets of all the pointers in the container, in increasing order. Includes the 2 in the SIR0 header.
+        inline const std::vector<uint32_t> & PointerOffsets()const { return m_ptroffsets; }
+
+        //Whether the pointer offset list has a pointer at "offset".
+        bool IsPointerAt( uint32_t offset )const;
+
+        /*
+            Returns the pointer stored at "offset" in the content. Null pointers are returned as 0. 
+            Throws if the offset, or the pointer, is out of the content.
+        */
+        uint32_t ReadPointer( size_t offset )const;
+
+        /*
+            Returns a cursor over the content from "offset" up to the end of the content.
+            Follow() does the same at the offset the pointer at "ptroffset" points to.
+        */
+        utils::BinaryCursor CursorAt( size_t offset )const;
+
+        inline utils::BinaryCursor SubHeader()const                 { return CursorAt( SubHeaderOffset() ); }
+        inline utils::BinaryCursor Follow   ( size_t ptroffset )const { return CursorAt( ReadPointer(ptroffset) ); }
+
+    private:
+        const uint8_t *       m_pdata;
+        size_t                m_len;
+        sir0_header           m_hdr;
+        std::vector<uint32_t> m_ptroffsets;
+    };
+
     /*
         Test a sir0_header struct to verify if its from a valid SIR0 container.
     */
@@ -326,6 +399,9 @@ namespace filetypes
             Registering those formats here will make sure that when the CContentHandler
             scans files to see if they are a SIR0, the formats that are wrapped by an SIR0
             container won't be ignored.
+
+            Rules registered here return the magic number of the SIR0 sub-header
+            they expect from getMagicNumbers(), instead of the SIR0 magic number.
     */
     class SIR0DerivHandler
     {
@@ -339,10 +415,14 @@ namespace filetypes
 
         ContentBlock AnalyseContent( const analysis_parameter & parameters );
 
+    private:
+        void RebuildDispatchTable();
+
     private:
         typedef std::map<cntRID_t,std::unique_ptr<IContentHandlingRule>> container_t;
-        cntRID_t    m_currentRID;
-        container_t m_rules;
+        cntRID_t                 m_currentRID;
+        container_t              m_rules;
+        ContentRuleDispatchTable m_dispatch;    //Rules indexed on the magic number of the sub-header
 
         static const cntRID_t INVALID_RID = -1;
     private:
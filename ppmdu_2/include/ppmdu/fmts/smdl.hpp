@@ -198,6 +198,7 @@ namespace DSE
     void          WriteSMDL( const std::string & file, const MusicSequence & seq );
 
     MusicSequence ParseSMDL( std::vector<uint8_t>::const_iterator itbeg, std::vector<uint8_t>::const_iterator itend );
+    MusicSequence ParseSMDL( const uint8_t * itbeg, const uint8_t * itend );
 
 };
 
@@ -35,30 +35,26 @@ namespace filetypes
         uint16_t strtbllen    = 0; //Counted in 16bits words
         uint16_t unk1         = 0;
 
+        typedef utils::binlayout< utils::binfield<&ssb_header::nbconst>,
+                                  utils::binfield<&ssb_header::nbstrs>,
+                                  utils::binfield<&ssb_header::scriptdatlen>,
+                                  utils::binfield<&ssb_header::consttbllen>,
+                                  utils::binfield<&ssb_header::strtbllen>,
+                                  utils::binfield<&ssb_header::unk1> > layout_t;
+        static_assert( layout_t::Size == LEN, "ssb_header: Layout doesn't match the header length!" );
+
         //
         template<class _outit>
         _outit WriteToContainer(_outit itwriteto)const
         {
-            itwriteto = utils::WriteIntToBytes(nbconst,      itwriteto);
-            itwriteto = utils::WriteIntToBytes(nbstrs,       itwriteto);
-            itwriteto = utils::WriteIntToBytes(scriptdatlen, itwriteto);
-            itwriteto = utils::WriteIntToBytes(consttbllen,  itwriteto);
-            itwriteto = utils::WriteIntToBytes(strtbllen,    itwriteto);
-            itwriteto = utils::WriteIntToBytes(unk1,         itwriteto);
-            return itwriteto;
+            return layout_t::Write(*this, itwriteto);
         }
 
         //
         template<class _init>
         _init ReadFromContainer(_init itReadfrom, _init itpastend)
         {
-            itReadfrom = utils::ReadIntFromBytes(nbconst,       itReadfrom, itpastend );
-            itReadfrom = utils::ReadIntFromBytes(nbstrs,        itReadfrom, itpastend );
-            itReadfrom = utils::ReadIntFromBytes(scriptdatlen,  itReadfrom, itpastend );
-            itReadfrom = utils::ReadIntFromBytes(consttbllen,   itReadfrom, itpastend );
-            itReadfrom = utils::ReadIntFromBytes(strtbllen,     itReadfrom, itpastend );
-            itReadfrom = utils::ReadIntFromBytes(unk1,          itReadfrom, itpastend );
-            return itReadfrom;
+            return layout_t::Read(*this, itReadfrom, itpastend);
         }
     };
 
@@ -81,36 +77,29 @@ namespace filetypes
         uint16_t stritalen    = 0; //Counted in 16bits words
         uint16_t strspalen    = 0; //Counted in 16bits words
 
+        typedef utils::binlayout< utils::binfield<&ssb_header_pal::nbconst>,
+                                  utils::binfield<&ssb_header_pal::nbstrs>,
+                                  utils::binfield<&ssb_header_pal::scriptdatlen>,
+                                  utils::binfield<&ssb_header_pal::consttbllen>,
+                                  utils::binfield<&ssb_header_pal::strenglen>,
+                                  utils::binfield<&ssb_header_pal::strfrelen>,
+                                  utils::binfield<&ssb_header_pal::strgerlen>,
+                                  utils::binfield<&ssb_header_pal::stritalen>,
+                                  utils::binfield<&ssb_header_pal::strspalen> > layout_t;
+        static_assert( layout_t::Size == LEN, "ssb_header_pal: Layout doesn't match the header length!" );
+
         //
         template<class _outit>
         _outit WriteToContainer(_outit itwriteto)const
         {
-            itwriteto = utils::WriteIntToBytes(nbconst,      itwriteto);
-            itwriteto = utils::WriteIntToBytes(nbstrs,       itwriteto);
-            itwriteto = utils::WriteIntToBytes(scriptdatlen, itwriteto);
-            itwriteto = utils::WriteIntToBytes(consttbllen,  itwriteto);
-            itwriteto = utils::WriteIntToBytes(strenglen,    itwriteto);
-            itwriteto = utils::WriteIntToBytes(strfrelen,    itwriteto);
-            itwriteto = utils::WriteIntToBytes(strgerlen,    itwriteto);
-            itwriteto = utils::WriteIntToBytes(stritalen,    itwriteto);
-            itwriteto = utils::WriteIntToBytes(strspalen,    itwriteto);
-            return itwriteto;
+            return layout_t::Write(*this, itwriteto);
         }
 
         //
         template<class _init>
         _init ReadFromContainer(_init itReadfrom, _init itpastend)
         {
-            itReadfrom = utils::ReadIntFromBytes(nbconst,       itReadfrom, itpastend );
-            itReadfrom = utils::ReadIntFromBytes(nbstrs,        itReadfrom, itpastend );
-            itReadfrom = utils::ReadIntFromBytes(scriptdatlen,  itReadfrom, itpastend );
-            itReadfrom = utils::ReadIntFromBytes(consttbllen,   itReadfrom, itpastend );
-            itReadfrom = utils::ReadIntFromBytes(strenglen,     itReadfrom, itpastend );
-            itReadfrom = utils::ReadIntFromBytes(strfrelen,     itReadfrom, itpastend );
-            itReadfrom = utils::ReadIntFromBytes(strgerlen,     itReadfrom, itpastend );
-            itReadfrom = utils::ReadIntFromBytes(stritalen,     itReadfrom, itpastend );
-            itReadfrom = utils::ReadIntFromBytes(strspalen,     itReadfrom, itpastend );
-            return itReadfrom;
+            return layout_t::Read(*this, itReadfrom, itpastend);
         }
     };
 
@@ -694,6 +694,20 @@ namespace DSE
     PresetBank ParseSWDL( std::vector<uint8_t>::const_iterator itbeg, 
                           std::vector<uint8_t>::const_iterator itend );
 
+    //Parse from raw memory, like a mapped file.
+    PresetBank ParseSWDL( const uint8_t * itbeg, 
+                          const uint8_t * itend );
+
+    /*
+        WriteSWDLIncremental
+            Writes the preset bank using the SWDL file "basefile" as a starting point.
+            Samples, sample entries and programs that weren't modified are copied straight from the base file,
+            so only what changed gets re-serialized. "filename" and "basefile" may be the same file.
+            The new file is written next to "filename", and then renamed over it, so "filename" is 
+            never left half written. Only DSE version 0x415 base files are supported.
+    */
+    void WriteSWDLIncremental( const std::string & filename, const PresetBank & audiodata, const std::string & basefile );
+
     /*
         ReadSwdlHeader
             Reads only the SWDL header from a file.
@@ -23,6 +23,7 @@ Description: Utilities for reading ".wan" sprite files, and its derivatives.
 #include <type_traits>
 #include <iomanip>
 #include <functional>
+#include <future>
 
 namespace filetypes 
 {
@@ -423,7 +424,8 @@ namespace filetypes
         using namespace std;
         using namespace utils;
         ImgAsmTblEntry entry;
-        uint32_t nb_bytesread = 0;
+        uint32_t       nb_bytesread = 0;
+        const size_t   filelen      = static_cast<size_t>( std::distance(filebeg, fileend) );
 
         do
         {
@@ -431,15 +433,14 @@ namespace filetypes
 
             if( !(entry.isNull()) )
             {
-                //Exec the entry!
+                //Exec the entry! Copies of the pixel reader all advance the original's output position, so the returned iterators are ignored
                 if( entry.pixelsrc == 0  )
-                    std::fill_n( itinsertat, entry.pixamt, 0 );
+                    std::fill_n( itinsertat, entry.pixamt, static_cast<uint8_t>(0) );
                 else
                 {
-                    //std::copy_n( filebeg + entry.pixelsrc, entry.pixamt, itinsertat );
-                    auto itcopy = std::next(filebeg, entry.pixelsrc);
-                    for( size_t cntcp = 0; cntcp < entry.pixamt; ++cntcp, ++itcopy, ++itinsertat )
-                        (*itinsertat) = (*itcopy);
+                    if( entry.pixelsrc > filelen || entry.pixamt > (filelen - entry.pixelsrc) )
+                        throw std::runtime_error( "ParseZeroStrippedTImg(): Pixel strip is out of the file's bounds!" );
+                    std::copy_n( std::next(filebeg, entry.pixelsrc), entry.pixamt, itinsertat );
                 }
                 nb_bytesread += entry.pixamt;
             }
@@ -542,12 +543,14 @@ namespace filetypes
         //This parse all images of the sprite as 4bpp!
         pmd2::graphics::SpriteData<gimg::tiled_image_i4bpp> ParseAs4bpp( std::atomic<uint32_t> * pProgress = nullptr)
         {
+            utils::TraceScope trace("wan parse 4bpp");
             return Parse<gimg::tiled_image_i4bpp>(pProgress);
         }
 
         //This parse all images of the sprite as 8bpp!
         pmd2::graphics::SpriteData<gimg::tiled_image_i8bpp> ParseAs8bpp(std::atomic<uint32_t> * pProgress = nullptr)
         {
+            utils::TraceScope trace("wan parse 8bpp");
             return Parse<gimg::tiled_image_i8bpp>(pProgress);
         }
 
@@ -823,6 +826,21 @@ namespace filetypes
             bool isZeroEntry = true; //Whether this entry is for copying zeroes or actual bytes.
         };
 
+        /*
+            A frame already split into its pixel strips and assembly table.
+            The pixel sources in the table are relative to the beginning of the strips.
+        */
+        struct encoded_frame
+        {
+            std::vector<uint8_t>            pixelstrips;
+            std::vector<ImgAsmTbl_WithOpTy> asmtable;
+
+            //Length in the file, including the null entry ending the table
+            inline size_t size()const { return pixelstrips.size() + ((asmtable.size() + 1) * ImgAsmTblEntry::LENGTH); }
+        };
+
+        static const size_t MinFramesPerThread = 16; //Below this, starting a thread costs more than encoding the frames
+
         /*
             WriteAPointer
                 To make things simpler, always use this method to write the value of a pointer to the buffer at the current pos !
@@ -855,50 +873,98 @@ namespace filetypes
 
 
         /*
-            This writes all the image data, stripping them of their zeros when neccessary.
+            Sizing pass for the image data, which makes up most of the file.
+            Splits all the frames into zero and pixel strips ahead of time, so the exact length of the
+            image block is known before allocating the output. Frames don't depend on each others,
+            so they're split between several threads.
         */
         template<class _frmTy>
-            void WriteFramesBlock( const std::vector<_frmTy> & frms )
+            void EncodeFrames( const std::vector<_frmTy> & frms )
         {
-            //utils::MrChronometer chronoTotal("WriteWanFrames");
-            std::vector<uint8_t> imgbuff; //This contains the raw bytes of the current frame
-            imgbuff.reserve( MAX_NB_PIXELS_SPRITE_IMG ); //Reserve the maximum frame size
+            utils::TraceScope trace("wan encode frames");
+            const std::vector<pmd2::graphics::ImageInfo> & imgsinfo = static_cast<const pmd2::graphics::BaseSprite*>(m_pSprite)->getImgsInfo();
+            m_encodedFrms.resize( frms.size() );
 
-            uint32_t cptfrmindex = 0;
-            for( const auto & afrm : frms )
+            auto lambdaEncode = [&]( size_t beg, size_t end )
             {
-                gimg::WriteTiledImg( std::back_inserter(imgbuff), afrm, WAN_REVERSED_PIX_ORDER );
-                WriteACompressedFrm( imgbuff, m_pSprite->getImgsInfo()[cptfrmindex].zindex );
-                imgbuff.resize(0);
-                ++cptfrmindex;
-            }
+                std::vector<uint8_t>                           imgbuff; //This contains the raw bytes of the current frame
+                std::vector<pmd2::compression::zero_strip_run> runs;
+                imgbuff.reserve( MAX_NB_PIXELS_SPRITE_IMG ); //Reserve the maximum frame size
+                for( size_t i = beg; i < end; ++i )
+                {
+                    PackFramePixels( frms[i], imgbuff );
+                    EncodeAFrame( imgbuff, imgsinfo[i].zindex, runs, m_encodedFrms[i] );
+                }
+            };
+
+            const size_t nbthreads = std::max<size_t>( 1, std::min<size_t>( utils::LibWide().getNbThreadsToUse(), frms.size() / MinFramesPerThread ) );
+            const size_t perthread = (frms.size() + nbthreads - 1) / nbthreads;
+            std::vector<std::future<void>> workers;
+            for( size_t beg = perthread; beg < frms.size(); beg += perthread )
+                workers.push_back( std::async( std::launch::async, lambdaEncode, beg, std::min( beg + perthread, frms.size() ) ) );
+            lambdaEncode( 0, std::min( perthread, frms.size() ) );
+            for( auto & worker : workers )
+                worker.get(); //Rethrows anything the worker threw
         }
 
         /*
-            This insert the next sequence into the zero strip table.
-            If its a sequence of zero, it won't write into the pixel strip table. If it is, it will.
+            This writes all the image data, encoded beforehand by EncodeFrames().
         */
-        ImgAsmTbl_WithOpTy MakeImgAsmTableEntry( std::vector<uint8_t>::const_iterator & itReadAt, 
-                                                         std::vector<uint8_t>::const_iterator   itEnd,
-                                                         std::vector<uint8_t>                 & pixStrips,
-                                                         uint32_t                             & totalbytecnt,
-                                                         uint32_t                               imgZIndex );
+        void WriteFramesBlock();
 
         /*
-            Same as above, but it simply makes a single assembly table entry for the whole image, not stripping the image of 
+            Packs the pixels of the frame into a contiguous buffer, in tile order.
+            Same output as gimg::WriteTiledImg with WAN_REVERSED_PIX_ORDER, but handles whole 
+            bytes instead of single bits.
+        */
+        template<class _frmTy>
+            static void PackFramePixels( const _frmTy & frm, std::vector<uint8_t> & out_bytes )
+        {
+            static const unsigned int BitsPerPixel = _frmTy::pixel_t::mypixeltrait_t::BITS_PER_PIXEL;
+            static_assert( BitsPerPixel == 4 || BitsPerPixel == 8, "WAN_Writer::PackFramePixels(): Only 4 and 8 bpp images are supported!" );
+            const unsigned int nbpixels = frm.getNbPixelWidth() * frm.getNbPixelHeight();
+
+            if( BitsPerPixel == 4 )
+            {
+                out_bytes.resize( (nbpixels + 1) / 2 );
+                for( unsigned int i = 0; i < nbpixels; i += 2 )
+                {
+                    uint8_t lownybble  = static_cast<uint8_t>( frm[i].getWholePixelData() & 0xF );
+                    uint8_t highnybble = (i + 1 < nbpixels)? static_cast<uint8_t>( frm[i + 1].getWholePixelData() & 0xF ) : 0;
+                    out_bytes[i / 2] = WAN_REVERSED_PIX_ORDER? (lownybble | (highnybble << 4)) : ((lownybble << 4) | highnybble);
+                }
+            }
+            else
+            {
+                out_bytes.resize( nbpixels );
+                for( unsigned int i = 0; i < nbpixels; ++i )
+                    out_bytes[i] = static_cast<uint8_t>( frm[i].getWholePixelData() );
+            }
+        }
+
+        /*
+            Makes a single assembly table entry for the whole image, not stripping the image of 
             any zeroes. Essentially bypassing the whole purpose of the assembly table.
         */
-        ImgAsmTbl_WithOpTy MakeImgAsmTableEntryNoStripping( std::vector<uint8_t>::const_iterator & itReadAt, 
-                                                                    std::vector<uint8_t>::const_iterator   itEnd,
-                                                                    std::vector<uint8_t>                 & pixStrips,
-                                                                    uint32_t                             & totalbytecnt,
-                                                                    uint32_t                               imgZIndex );
+        static ImgAsmTbl_WithOpTy MakeImgAsmTableEntryNoStripping( std::vector<uint8_t>::const_iterator & itReadAt, 
+                                                                   std::vector<uint8_t>::const_iterator   itEnd,
+                                                                   std::vector<uint8_t>                 & pixStrips,
+                                                                   uint32_t                             & totalbytecnt,
+                                                                   uint32_t                               imgZIndex );
 
         /*
+            Splits a frame into pixel strips, and builds its assembly table.
+            "runs" is scratch space, reused between frames.
         , -dontStripZeros: if set to true, the frame will be saved as a is, without stripping the zero
                            but in a way the game can load it. Used for UI sprites !
         */
-        void WriteACompressedFrm( const std::vector<uint8_t> & frm, uint32_t imgZIndex, bool dontStripZeros = false );
+        static void EncodeAFrame( const std::vector<uint8_t>                     & frm, 
+                                  uint32_t                                         imgZIndex, 
+                                  std::vector<pmd2::compression::zero_strip_run> & runs,
+                                  encoded_frame                                  & out_frm,
+                                  bool                                             dontStripZeros = false );
+
+        void WriteACompressedFrm( const encoded_frame & frm );
 
         /*
         */
@@ -955,6 +1021,7 @@ namespace filetypes
         std::vector<uint32_t>  m_AnimSequencesListOffset; //Keep tracks of where each animation group's sequences ptr table begins at!
 
         std::vector<uint32_t>  m_CompImagesTblOffsets;    //The places where the zero-strip table for each compressed image is at
+        std::vector<encoded_frame> m_encodedFrms;         //All the frames, encoded by the sizing pass
 
         std::vector<uint32_t>  m_ptrOffsetTblToEncode;      //List of all the pointers offsets in the resulting raw file !
     };
@@ -98,6 +98,13 @@ namespace pmd2
         void                         Items( stats::ItemsDB       && newdata )   { m_itemsData = newdata; }
         void                         Items( const stats::ItemsDB &  newdata )   { m_itemsData = newdata; }
 
+        //Accessors Moves. The second move list is only used by Explorers of Sky.
+        inline const stats::MoveDB & Moves1()const                              { return m_moveData1;    }
+        inline const stats::MoveDB & Moves2()const                              { return m_moveData2;    }
+
+        //Accessors Game Text. Returns null if no strings were loaded.
+        inline const GameText      * Strings()const                             { return m_gameStrings.get(); }
+
         //Accessors
         void                setRomRootDir( const std::string & path ); //{ m_romrootdir = path; }
         inline const std::string & getRomRootDir()const                      { return m_romrootdir; }
@@ -135,24 +142,26 @@ namespace pmd2
             The Current data directory must be set to the game data
             folder the data is exported from !
             Unless everything was loaded!
+            If bparallel is true, the xml files for each Pokemon, move and item are written on several threads.
         */
-        void ExportAll  ( const std::string & directory );
-        void ExportPkmn ( const std::string & directory );
-        void ExportMoves( const std::string & directory );
+        void ExportAll  ( const std::string & directory, bool bparallel = false );
+        void ExportPkmn ( const std::string & directory, bool bparallel = false );
+        void ExportMoves( const std::string & directory, bool bparallel = false );
         void ExportText ( const std::string & directory );
-        void ExportItems( const std::string & directory );
+        void ExportItems( const std::string & directory, bool bparallel = false );
 
         //Import
         /*
             The Current data directory must be set to the game data
             folder where the data will be imported to ! This is
             to allow determining the target game version, nothing will be overwritten!
+            If bparallel is true, the xml files for each Pokemon, move and item are loaded on several threads.
         */
-        void ImportAll  ( const std::string & directory );
-        void ImportPkmn ( const std::string & directory );
-        void ImportMoves( const std::string & directory );
+        void ImportAll  ( const std::string & directory, bool bparallel = false );
+        void ImportPkmn ( const std::string & directory, bool bparallel = false );
+        void ImportMoves( const std::string & directory, bool bparallel = false );
         void ImportText ( const std::string & directory );
-        void ImportItems( const std::string & directory );
+        void ImportItems( const std::string & directory, bool bparallel = false );
 
         /*
             Analyze the current data folder to find out what game, and language it is, 
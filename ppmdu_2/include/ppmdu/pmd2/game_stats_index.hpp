@@ -0,0 +1,240 @@
+#ifndef GAME_STATS_INDEX_HPP
+#define GAME_STATS_INDEX_HPP
+/*
+game_stats_index.hpp
+2016/07/14
+psycommando@gmail.com
+Description:
+    A read-only, column oriented index over the Pokemon, move and item data loaded in a GameStats object.
+    Meant for running queries over the whole data set, like "every Pokemon learning move X by level N",
+    without having to walk the nested structures of the PokemonDB every time.
+*/
+#include <ppmdu/containers/pokemon_stats.hpp>
+#include <ppmdu/containers/move_data.hpp>
+#include <ppmdu/containers/item_data.hpp>
+#include <cstdint>
+#include <vector>
+#include <array>
+#include <string>
+#include <utility>
+
+namespace pmd2
+{
+    class GameStats;
+
+//==================================================================================
+//  Constants
+//==================================================================================
+    /*
+        eLearnMethod
+            How a Pokemon learns the move of a learnset entry.
+    */
+    enum struct eLearnMethod : uint8_t
+    {
+        LevelUp = 0,
+        HmTm    = 1,
+        Egg     = 2,
+    };
+
+    //Filenames of the csv files written by GameStatsIndex::WriteCSV
+    extern const std::string StatsIndex_PkmnCSV;
+    extern const std::string StatsIndex_LearnsetCSV;
+    extern const std::string StatsIndex_MovesCSV;
+    extern const std::string StatsIndex_ItemsCSV;
+
+//==================================================================================
+//  GameStatsIndex
+//==================================================================================
+    /************************************************************************
+        GameStatsIndex
+            Copies the stats of a GameStats object into flat arrays, one per
+            field, all indexed by entry index. Learnsets are flattened into
+            a single table, and inverted indices map moves, types, exclusive
+            items and item categories to the entries refering to them.
+
+            The index doesn't refer to the GameStats it was built from, and
+            must be rebuilt if the data changes.
+    ************************************************************************/
+    class GameStatsIndex
+    {
+    public:
+        typedef std::vector<uint32_t>::const_iterator rowit_t;
+        typedef std::pair<rowit_t, rowit_t>           rowrange_t;   //Range of row indices returned by lookups
+
+        /*
+            Pokemon columns, indexed on the Pokemon's entity index.
+            Values are from the primary gender entry of each Pokemon.
+        */
+        struct pkmn_columns
+        {
+            std::vector<std::string> name;
+            std::vector<uint16_t>    dexNb;
+            std::vector<uint8_t>     primaryTy;
+            std::vector<uint8_t>     secondaryTy;
+            std::vector<uint8_t>     primAbility;
+            std::vector<uint8_t>     secAbility;
+            std::vector<uint8_t>     IQGrp;
+            std::vector<uint8_t>     moveTy;
+            std::vector<uint8_t>     bodySize;
+            std::vector<uint16_t>    expYield;
+            std::vector<int16_t>     recruitRate1;
+            std::vector<int16_t>     recruitRate2;
+            std::vector<uint16_t>    baseHP;
+            std::vector<uint8_t>     baseAtk;
+            std::vector<uint8_t>     baseSpAtk;
+            std::vector<uint8_t>     baseDef;
+            std::vector<uint8_t>     baseSpDef;
+            std::vector<uint16_t>    weight;
+            std::vector<uint16_t>    size;
+            std::vector<uint16_t>    preEvoIndex;
+            std::vector<uint16_t>    evoMethod;
+            std::vector<uint16_t>    evoParam1;
+            std::vector<uint16_t>    evoParam2;
+            std::vector<uint16_t>    basePkmn;
+            std::vector<uint8_t>     has2Genders;
+            std::array<std::vector<uint16_t>,4> exclusiveItems;
+
+            inline size_t Count()const { return dexNb.size(); }
+        };
+
+        /*
+            Flattened learnsets of all Pokemon. Sorted on Pokemon index, then moveset, then learn method, then level.
+        */
+        struct learnset_columns
+        {
+            std::vector<uint16_t>        pkmn;
+            std::vector<stats::moveid_t> move;
+            std::vector<stats::level_t>  level;   //0 for anything but level-up moves
+            std::vector<eLearnMethod>    method;
+            std::vector<uint8_t>         moveset; //0 for waza_p.bin, 1 for waza_p2.bin
+
+            inline size_t Count()const { return pkmn.size(); }
+        };
+
+        /*
+            Move columns, indexed on move index. Taken from waza_p.bin.
+        */
+        struct move_columns
+        {
+            std::vector<std::string> name;
+            std::vector<int16_t>     basePower;
+            std::vector<uint8_t>     type;
+            std::vector<uint8_t>     category;
+            std::vector<uint8_t>     basePP;
+            std::vector<uint8_t>     accuracy;
+            std::vector<uint16_t>    moveID;
+
+            inline size_t Count()const { return basePower.size(); }
+        };
+
+        /*
+            Item columns, indexed on item index.
+        */
+        struct item_columns
+        {
+            std::vector<std::string> name;
+            std::vector<uint16_t>    buyPrice;
+            std::vector<uint16_t>    sellPrice;
+            std::vector<uint8_t>     category;
+            std::vector<uint8_t>     spriteID;
+            std::vector<uint16_t>    itemID;
+            std::vector<uint16_t>    param1;
+            std::vector<uint8_t>     param2;
+            std::vector<uint8_t>     param3;
+
+            inline size_t Count()const { return buyPrice.size(); }
+        };
+
+    public:
+        /*
+            Builds the index from the data currently loaded in the GameStats object.
+            Names are only filled if the game strings were loaded.
+        */
+        explicit GameStatsIndex( const GameStats & src );
+
+        inline const pkmn_columns     & Pokemon  ()const { return m_pkmn;      }
+        inline const learnset_columns & Learnsets()const { return m_learnsets; }
+        inline const move_columns     & Moves    ()const { return m_moves;     }
+        inline const item_columns     & Items    ()const { return m_items;     }
+
+        //
+        //  Queries
+        //
+        /*
+            Returns the rows of the learnset table that refer to the move, in the learnset table's order.
+        */
+        rowrange_t LearnsetRowsForMove( stats::moveid_t mvid )const;
+
+        /*
+            Returns the sorted list of Pokemon that can learn the move with the method specified,
+            without duplicates. For level-up moves, only moves learned at or below "bylevel" are considered.
+        */
+        std::vector<uint16_t> PokemonLearningMove( stats::moveid_t mvid,
+                                                   eLearnMethod    method  = eLearnMethod::LevelUp,
+                                                   stats::level_t  bylevel = stats::PkmnMaxLevel )const;
+
+        /*
+            Returns the Pokemon having the type as either their primary or secondary type, sorted.
+        */
+        rowrange_t PokemonOfType( uint8_t type )const;
+
+        /*
+            Returns the Pokemon that have the item in their exclusive items list, sorted.
+        */
+        rowrange_t PokemonWithExclusiveItem( uint16_t itemid )const;
+
+        /*
+            Returns the moves with the type specified, sorted.
+        */
+        rowrange_t MovesOfType( uint8_t type )const;
+
+        /*
+            Returns the items in the category specified, sorted.
+        */
+        rowrange_t ItemsOfCategory( uint8_t category )const;
+
+        //
+        //  Output
+        //
+        /*
+            Writes every table to its own csv file in the directory. One line per row, one column per field.
+        */
+        void WriteCSV( const std::string & destdir )const;
+
+    private:
+        /*
+            Maps keys in [0, maxkey] to lists of rows, stored contiguously.
+            The rows for key k are rows[offsets[k]] to rows[offsets[k+1]].
+        */
+        struct inverted_index
+        {
+            std::vector<uint32_t> offsets;
+            std::vector<uint32_t> rows;
+
+            rowrange_t Find( uint32_t key )const;
+        };
+
+        template<class _KeyFun>
+            static inverted_index BuildInvertedIndex( size_t nbrows, size_t nbkeysperrow, _KeyFun && getkey );
+
+        void IndexPokemon ( const GameStats & src );
+        void IndexMoves   ( const GameStats & src );
+        void IndexItems   ( const GameStats & src );
+        void AppendMoveSet( uint16_t pkmn, uint8_t setid, const stats::PokeMoveSet & mvset );
+
+    private:
+        pkmn_columns     m_pkmn;
+        learnset_columns m_learnsets;
+        move_columns     m_moves;
+        item_columns     m_items;
+
+        inverted_index   m_learnersByMove;
+        inverted_index   m_pkmnByType;
+        inverted_index   m_pkmnByExItem;
+        inverted_index   m_movesByType;
+        inverted_index   m_itemsByCategory;
+    };
+
+};
+
+#endif
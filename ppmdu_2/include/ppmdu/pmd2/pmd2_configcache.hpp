@@ -0,0 +1,69 @@
+#ifndef PMD2_CONFIG_CACHE_HPP
+#define PMD2_CONFIG_CACHE_HPP
+/*
+pmd2_configcache.hpp
+2016/07/15
+psycommando@gmail.com
+Description:
+    Binary snapshot of the data a ConfigLoader loaded from the xml configuration files, for a single game version.
+    Loading it back is a single file read and a linear decode, instead of parsing pmd2data.xml and all its external files.
+
+    The snapshot stores the path and a hash of every xml file that was parsed to make it. It's only used if
+    all those files still exist and are unchanged. The format isn't stable between versions of the format.
+*/
+#include <ppmdu/pmd2/pmd2_configloader.hpp>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace pmd2
+{
+//========================================================================================
+//  Constants
+//========================================================================================
+    const std::string ConfigCache_FExt        = "bincache";
+    const uint32_t    ConfigCache_MagicNumber = 0x50434643; //"PCFC"
+    const uint32_t    ConfigCache_Version     = 1;
+
+//========================================================================================
+//  ConfigBinaryCache
+//========================================================================================
+    /*
+        ConfigBinaryCache
+            Reads and writes ConfigLoader snapshots.
+    */
+    class ConfigBinaryCache
+    {
+    public:
+        /*
+            MakeCachePath
+                Returns the path of the snapshot for the config file and game selection.
+                The selector is a short string identifying how the game version was picked.
+        */
+        static std::string MakeCachePath( const std::string & configfile, const std::string & selector );
+
+        /*
+            Load
+                Fills the target's configuration data from the snapshot.
+                Returns false, and leaves the target unchanged, if there's no snapshot, if it can't be read,
+                or if any of the source files changed since it was made.
+        */
+        static bool Load( const std::string & cachefile, ConfigLoader & target );
+
+        /*
+            Save
+                Writes a snapshot of the configuration data in "src".
+                - srcfiles : Every xml file that was parsed to obtain the data.
+        */
+        static void Save( const std::string & cachefile, const ConfigLoader & src, const std::vector<std::string> & srcfiles );
+
+        /*
+            HashFile
+                Returns the hash of the file's content, used to detect changes to the source files.
+        */
+        static uint64_t HashFile( const std::string & fpath );
+    };
+
+};
+
+#endif
@@ -14,11 +14,14 @@ Description: Loads on demand certain values from the config file!
 #include <sstream>
 #include <iomanip>
 #include <limits>
+#include <functional>
 
 namespace pmd2
 {
     const std::string DefConfigFileName = "pmd2data.xml";
 
+    class ConfigXMLParser;
+
 //========================================================================================
 //  Entries in the configuration file
 //========================================================================================
@@ -377,6 +380,7 @@ namespace pmd2
         }
 
         inline const std::string & GetConstAsString(eGameConstants cnst)const { return m_constants.at(cnst); }
+        inline const constcnt_t  & Constants()const                           { return m_constants; }
         
         template<typename _IntegerTy>
             _IntegerTy GetConstAsInt(eGameConstants cnst)const
@@ -459,6 +463,8 @@ namespace pmd2
                 return nullptr;
         }
 
+        inline const binfilesinf_t & Binaries()const { return m_info; }
+
         binarylocatioinfo FindInfoByLocation(eBinaryLocations location)const
         {
             binarylocatioinfo inf;
@@ -657,6 +663,7 @@ namespace pmd2
     class GameScriptData
     {
         friend class ConfigXMLParser;
+        friend class ConfigBinaryCache;
     public:
         typedef NamedDataEntry<gamevariable_info>   gvar_t;
         typedef NamedDataEntry<livesent_info>       livesent_t;
@@ -753,6 +760,7 @@ namespace pmd2
     class ConfigLoader
     {
         friend class ConfigXMLParser;
+        friend class ConfigBinaryCache;
 
         typedef std::unordered_map<eGameConstants,  std::string> constcnt_t;
     public:
@@ -798,6 +806,9 @@ namespace pmd2
         void Parse(uint16_t arm9off14);
         void Parse(eGameVersion version, eGameRegion region);
 
+        //Parse the xml config with the parser function, unless a valid binary cache for the same selection exists.
+        void ParseOrLoadCache( const std::string & selector, const std::function<void(ConfigXMLParser&)> & fparse );
+
     private:
         std::string         m_conffile;
         uint16_t            m_arm9off14;
@@ -139,6 +139,9 @@ namespace pmd2 { namespace filetypes
                                              std::vector<uint8_t>::const_iterator & itdataend );
     std::string GetAppropriateFileExtension(std::vector<uint8_t>::const_iterator&& itdatabeg,
                                             std::vector<uint8_t>::const_iterator&& itdataend);
+
+    //Returns the file extension for a content type that was already determined, or an empty string
+    std::string GetFileExtensionForContentType( ::filetypes::cnt_t type );
     //#TODO: Deprecate this !
     //Returns a short string identifying what is the type of content is in this kind of file !
     //std::string GetContentTypeName( e_ContentType type );
@@ -23,6 +23,8 @@ Description:
 //!         interface for a possible shared library. If the dependencies and implementation can be
 //!         pimpl-ifed.
 
+namespace filetypes { class NitroROMMount; };
+
 namespace pmd2
 {
 //
@@ -65,6 +67,7 @@ namespace pmd2
         void AnalyseGame();
 
         //Set ROM Root Dir (Directory conatining arm9.bin, data, and overlay directory)
+        //Can also be the path to a .nds file, which is then read from directly.
         void                SetRomRoot( const std::string & romroot );
         const std::string & GetRomRoot()const;
 
@@ -94,6 +97,21 @@ namespace pmd2
         void DeInitAudio();
         //void DeInitAsm();
 
+        /*
+            When the rom root is a .nds file, the files written by the DeInit calls are kept in memory
+            until this patches them into the image. The DeInit calls already do it after writing.
+        */
+        void CommitRomImage();
+
+        /*
+            Discards the loaded data of a module without writing it, so the next Init call reloads it from the files.
+            Unloading the text also unloads the stats and scripts, since they refer to it.
+            Unloading the scripts also unloads the levels.
+        */
+        void UnloadGameText();
+        void UnloadScripts();
+        void UnloadStats();
+
         /*
             Access to the sub-sections of the game's data
         */
@@ -127,6 +145,8 @@ namespace pmd2
     private:
         
         bool LoadConfigUsingARM9();
+        void MountRomImage();
+        void UnmountRomImage();
         //Code common to all init methods!
         void DoCommonInit(bool bcheckdata = true);
 
@@ -140,6 +160,7 @@ namespace pmd2
         std::unique_ptr<PMD2_ASM>            m_asmmanip;
 
         std::string                          m_romroot;
+        std::unique_ptr<::filetypes::NitroROMMount> m_rommount; //The .nds file we mounted, if any
         std::string                          m_datadiroverride; //Contains the name of the data directory if name non-default
         std::string                          m_configfile;
 
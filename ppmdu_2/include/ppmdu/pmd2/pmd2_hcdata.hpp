@@ -84,7 +84,7 @@ namespace pmd2
             return itbeg;
         }
 
-        void Read( std::ifstream & istrm, uint32_t arm9loadoffset )
+        void Read( std::istream & istrm, uint32_t arm9loadoffset )
         {
             using namespace std;
             using namespace utils;
@@ -210,7 +210,7 @@ namespace pmd2
             return itbeg;
         }
 
-        void Read( std::ifstream & istrm, uint32_t arm9loadoffset )
+        void Read( std::istream & istrm, uint32_t arm9loadoffset )
         {
             using namespace std;
             using namespace utils;
@@ -349,7 +349,7 @@ namespace pmd2
             return itbeg;
         }
 
-        void Read( std::ifstream & istrm, uint32_t arm9loadoffset )
+        void Read( std::istream & istrm, uint32_t arm9loadoffset )
         {
             using namespace std;
             using namespace utils;
@@ -495,7 +495,7 @@ struct ObjectFileListEntry
         return itbeg;
     }
 
-    void Read( std::ifstream & istrm, uint32_t arm9loadoffset )
+    void Read( std::istream & istrm, uint32_t arm9loadoffset )
     {
         using namespace std;
         using namespace utils;
@@ -15,6 +15,7 @@ No crappyrights. All wrong reversed!
 #include <ppmdu/pmd2/pmd2_palettes.hpp>
 #include <utils/handymath.hpp>
 #include <utils/utility.hpp>
+#include <utils/binary_cursor.hpp>
 #include <ppmdu/pmd2/pmd2_image_formats.hpp>
 #include <ppmdu/pmd2/pmd2_filetypes.hpp>
 #include <ppmdu/fmts/sir0.hpp>
@@ -56,34 +57,27 @@ namespace pmd2{ namespace graphics
         std::string toString()const;
 
 
+        typedef utils::binlayout< utils::binfield<&sprite_info_data::ptr_ptrstable_e>,
+                                  utils::binfield<&sprite_info_data::ptr_offset_f>,
+                                  utils::binfield<&sprite_info_data::ptr_offset_g>,
+                                  utils::binfield<&sprite_info_data::nb_blocks_in_offset_g>,
+                                  utils::binfield<&sprite_info_data::nb_entries_offset_e>,
+                                  utils::binfield<&sprite_info_data::unknown1>,
+                                  utils::binfield<&sprite_info_data::unknown2>,
+                                  utils::binfield<&sprite_info_data::unknown3>,
+                                  utils::binfield<&sprite_info_data::unknown4> > layout_t;
+        static_assert( layout_t::Size == DATA_LEN, "sprite_info_data: Layout doesn't match the entry size!" );
+
         template<class _outit>
             _outit WriteToContainer( _outit itwriteto )const
         {
-            itwriteto = utils::WriteIntToBytes( ptr_ptrstable_e,       itwriteto );
-            itwriteto = utils::WriteIntToBytes( ptr_offset_f,          itwriteto );
-            itwriteto = utils::WriteIntToBytes( ptr_offset_g,          itwriteto );
-            itwriteto = utils::WriteIntToBytes( nb_blocks_in_offset_g, itwriteto );
-            itwriteto = utils::WriteIntToBytes( nb_entries_offset_e,   itwriteto );
-            itwriteto = utils::WriteIntToBytes( unknown1,              itwriteto );
-            itwriteto = utils::WriteIntToBytes( unknown2,              itwriteto );
-            itwriteto = utils::WriteIntToBytes( unknown3,              itwriteto );
-            itwriteto = utils::WriteIntToBytes( unknown4,              itwriteto );
-            return itwriteto;
+            return layout_t::Write( *this, itwriteto );
         }
 
         template<class _init>
             _init ReadFromContainer( _init itReadfrom, _init itPastEnd )
         {
-            itReadfrom = utils::ReadIntFromBytes( ptr_ptrstable_e,       itReadfrom, itPastEnd );
-            itReadfrom = utils::ReadIntFromBytes( ptr_offset_f,          itReadfrom, itPastEnd );
-            itReadfrom = utils::ReadIntFromBytes( ptr_offset_g,          itReadfrom, itPastEnd );
-            itReadfrom = utils::ReadIntFromBytes( nb_blocks_in_offset_g, itReadfrom, itPastEnd );
-            itReadfrom = utils::ReadIntFromBytes( nb_entries_offset_e,   itReadfrom, itPastEnd );
-            itReadfrom = utils::ReadIntFromBytes( unknown1,              itReadfrom, itPastEnd );
-            itReadfrom = utils::ReadIntFromBytes( unknown2,              itReadfrom, itPastEnd );
-            itReadfrom = utils::ReadIntFromBytes( unknown3,              itReadfrom, itPastEnd );
-            itReadfrom = utils::ReadIntFromBytes( unknown4,              itReadfrom, itPastEnd );
-            return itReadfrom;
+            return layout_t::Read( *this, itReadfrom, itPastEnd );
         }
 
     };
@@ -108,28 +102,24 @@ namespace pmd2{ namespace graphics
         unsigned int size()const{return DATA_LEN;}
         std::string toString()const;
 
+        typedef utils::binlayout< utils::binfield<&sprite_frame_data::ptr_frm_ptrs_table>,
+                                  utils::binfield<&sprite_frame_data::ptrPal>,
+                                  utils::binfield<&sprite_frame_data::unkn_1>,
+                                  utils::binfield<&sprite_frame_data::unkn_2>,
+                                  utils::binfield<&sprite_frame_data::unkn_3>,
+                                  utils::binfield<&sprite_frame_data::nbImgsTblPtr> > layout_t;
+        static_assert( layout_t::Size == DATA_LEN, "sprite_frame_data: Layout doesn't match the entry size!" );
+
         template<class _outit>
             _outit WriteToContainer( _outit itwriteto )const
         {
-            itwriteto = utils::WriteIntToBytes( ptr_frm_ptrs_table, itwriteto );
-            itwriteto = utils::WriteIntToBytes( ptrPal,             itwriteto );
-            itwriteto = utils::WriteIntToBytes( unkn_1,             itwriteto );
-            itwriteto = utils::WriteIntToBytes( unkn_2,             itwriteto );
-            itwriteto = utils::WriteIntToBytes( unkn_3,             itwriteto );
-            itwriteto = utils::WriteIntToBytes( nbImgsTblPtr,       itwriteto );
-            return itwriteto;
+            return layout_t::Write( *this, itwriteto );
         }
 
         template<class _init>
             _init ReadFromContainer( _init itReadfrom, _init itPastEnd )
         {
-            itReadfrom = utils::ReadIntFromBytes( ptr_frm_ptrs_table, itReadfrom, itPastEnd );
-            itReadfrom = utils::ReadIntFromBytes( ptrPal,             itReadfrom, itPastEnd );
-            itReadfrom = utils::ReadIntFromBytes( unkn_1,             itReadfrom, itPastEnd );
-            itReadfrom = utils::ReadIntFromBytes( unkn_2,             itReadfrom, itPastEnd );
-            itReadfrom = utils::ReadIntFromBytes( unkn_3,             itReadfrom, itPastEnd );
-            itReadfrom = utils::ReadIntFromBytes( nbImgsTblPtr,       itReadfrom, itPastEnd );
-            return itReadfrom;
+            return layout_t::Read( *this, itReadfrom, itPastEnd );
         }
 
         //std::vector<uint8_t>::iterator       WriteToContainer(  std::vector<uint8_t>::iterator       itwriteto )const;
@@ -153,24 +143,22 @@ namespace pmd2{ namespace graphics
         unsigned int size()const{return DATA_LEN;}
         std::string toString()const;
 
+        typedef utils::binlayout< utils::binfield<&sprite_data_header::spr_ptr_info>,
+                                  utils::binfield<&sprite_data_header::spr_ptr_frames>,
+                                  utils::binfield<&sprite_data_header::unknown0>,
+                                  utils::binfield<&sprite_data_header::unknown1> > layout_t;
+        static_assert( layout_t::Size == DATA_LEN, "sprite_data_header: Layout doesn't match the entry size!" );
+
         template<class _outit>
             _outit WriteToContainer( _outit itwriteto )const
         {
-            itwriteto = utils::WriteIntToBytes( spr_ptr_info,   itwriteto );
-            itwriteto = utils::WriteIntToBytes( spr_ptr_frames, itwriteto );
-            itwriteto = utils::WriteIntToBytes( unknown0,       itwriteto );
-            itwriteto = utils::WriteIntToBytes( unknown1,       itwriteto );
-            return itwriteto;
+            return layout_t::Write( *this, itwriteto );
         }
 
         template<class _init>
             _init ReadFromContainer( _init itReadfrom, _init itPastEnd )
         {
-            itReadfrom = utils::ReadIntFromBytes( spr_ptr_info,   itReadfrom, itPastEnd);
-            itReadfrom = utils::ReadIntFromBytes( spr_ptr_frames, itReadfrom, itPastEnd);
-            itReadfrom = utils::ReadIntFromBytes( unknown0,       itReadfrom, itPastEnd);
-            itReadfrom = utils::ReadIntFromBytes( unknown1,       itReadfrom, itPastEnd);
-            return itReadfrom;
+            return layout_t::Read( *this, itReadfrom, itPastEnd );
         }
 
         //std::vector<uint8_t>::iterator       WriteToContainer(  std::vector<uint8_t>::iterator       itwriteto )const;
@@ -11,9 +11,16 @@ Description: Utilites for handling the RLE compression used on sprites in PMD2.
 */
 #include <ppmdu/pmd2/pmd2_image_formats.hpp>
 #include <utils/utility.hpp>
+#include <utils/binary_cursor.hpp>
+#include <vector>
+#include <cstdint>
 
 namespace pmd2 { namespace compression
 {
+//====================================================================================================
+// Constants
+//====================================================================================================
+    static const size_t ZeroStrip_BlockLen = 32; //Sprite images are stripped of their zeros in blocks of 32 bytes. A whole row of 4bpp tile.
 
 //====================================================================================================
 // Struct
@@ -29,25 +36,57 @@ namespace pmd2 { namespace compression
         unsigned int    size()const   { return LENGTH; }
         bool            isNull()const { return (!pixelsrc && !pixamt && !unknown); } //Whether its a null entry or not 
 
+        typedef utils::binlayout< utils::binfield<&rle_table_entry::pixelsrc>,
+                                  utils::binfield<&rle_table_entry::pixamt>,
+                                  utils::binfield<&rle_table_entry::unknown> > layout_t;
+        static_assert( layout_t::Size == LENGTH, "rle_table_entry: Layout doesn't match the entry size!" );
+
         template<class _outit>
             _outit WriteToContainer( _outit itwriteto )const
         {
-            itwriteto = utils::WriteIntToBytes( pixelsrc, itwriteto );
-            itwriteto = utils::WriteIntToBytes( pixamt,   itwriteto );
-            itwriteto = utils::WriteIntToBytes( unknown,  itwriteto );
-            return itwriteto;
+            return layout_t::Write( *this, itwriteto );
         }
 
         template<class _init>
             _init ReadFromContainer( _init itReadfrom, _init itPastEnd )
         {
-            itReadfrom = utils::ReadIntFromBytes( pixelsrc, itReadfrom, itPastEnd );
-            itReadfrom = utils::ReadIntFromBytes( pixamt,   itReadfrom, itPastEnd );
-            itReadfrom = utils::ReadIntFromBytes( unknown,  itReadfrom, itPastEnd );
-            return itReadfrom;
+            return layout_t::Read( *this, itReadfrom, itPastEnd );
         }
     };
 
+    /*
+        A run of consecutive blocks that are either all zeros, or contain pixels.
+        Offset and length are in bytes, relative to the beginning of the image data.
+    */
+    struct zero_strip_run
+    {
+        bool     iszero;
+        uint32_t offset;
+        uint32_t length;
+    };
+
+//====================================================================================================
+// Zero Strip Kernels
+//====================================================================================================
+    /*
+        IsZeroBlock
+            Returns whether all the bytes in the range are 0. 
+            Compares 8 bytes at a time, so a whole block is checked in a handful of instructions.
+    */
+    bool IsZeroBlock( const uint8_t * pbeg, size_t len );
+
+    /*
+        FindZeroStripRuns
+            Splits the image data into blocks of "blocklen" bytes, and groups consecutive 
+            blocks of the same kind into runs. A block is a zero block only if all its bytes are 0.
+            If the data length isn't a multiple of the block length, the last block is shorter.
+            The runs are appended to out_runs.
+    */
+    void FindZeroStripRuns( const uint8_t               * pbeg, 
+                            const uint8_t               * pend, 
+                            std::vector<zero_strip_run> & out_runs, 
+                            size_t                        blocklen = ZeroStrip_BlockLen );
+
 //====================================================================================================
 // Functors
 //====================================================================================================
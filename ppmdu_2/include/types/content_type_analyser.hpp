@@ -13,6 +13,7 @@ All wrongs reversed, no crappyrights :P
 #include <vector>
 #include <types/contentid_generator.hpp>
 #include <memory>
+#include <unordered_map>
 
 namespace filetypes
 {
@@ -137,6 +138,48 @@ namespace filetypes
         virtual bool isMatch(  std::vector<uint8_t>::const_iterator   itdatabeg, 
                                std::vector<uint8_t>::const_iterator   itdataend,
                                const std::string                     & filext ) = 0;
+
+        //Returns the magic numbers the data must begin with for isMatch to ever return true. Read as a 4 bytes big endian integer.
+        // Its used by the handler to skip rules that can't possibly match. 
+        // Rules that don't depend on a magic number, like the ones matching on file extension, should return an empty list,
+        // and will be tried on any data.
+        virtual std::vector<uint32_t> getMagicNumbers()const { return std::vector<uint32_t>(); }
+    };
+
+
+    /*************************************************************************************
+        ContentRuleDispatchTable
+            Lookup table from the magic number at the beginning of some data,
+            to the list of rules that may match that data.
+
+            Each list contains the rules returning that magic number in 
+            getMagicNumbers(), and the rules without magic numbers, in the
+            same relative order they were in when the table was built. 
+            So the first rule matching in a list is the same one that would 
+            match first when trying every rules in order.
+    *************************************************************************************/
+    class ContentRuleDispatchTable
+    {
+    public:
+        typedef std::vector<IContentHandlingRule*> rulelist_t;
+
+        //Rebuild the table from the rules, in the order they should be tried in.
+        void Build( const rulelist_t & rules );
+
+        //Returns the rules to try on data beginning with the magic number.
+        const rulelist_t & Candidates( uint32_t magic )const;
+
+        //Returns the rules to try on data that's too short to have a magic number.
+        inline const rulelist_t & Generic()const { return m_generic; }
+
+        //Read the 4 bytes big endian magic number at the beginning of the data. Returns false if the data is too short.
+        static bool ReadMagic( std::vector<uint8_t>::const_iterator itdatabeg, 
+                               std::vector<uint8_t>::const_iterator itdataend, 
+                               uint32_t                           & outmagic );
+
+    private:
+        std::unordered_map<uint32_t, rulelist_t> m_bymagic;
+        rulelist_t                               m_generic;
     };
 
 
@@ -173,12 +216,23 @@ namespace filetypes
         //ContentBlock AnalyseContent( vector<uint8_t>::const_iterator itdatabeg, vector<uint8_t>::const_iterator itdataend );
         ContentBlock AnalyseContent( const analysis_parameter & parameters );
 
+        /*
+            Analyse several independent pieces of data in one go, like all the sub-files of a pack file.
+            Results are in the same order as the parameters. 
+            When bparallel is true, the analysis is split between several threads.
+            Rules must not be registered or unregistered while this runs.
+        */
+        std::vector<ContentBlock> AnalyseContents( const std::vector<analysis_parameter> & parameters, bool bparallel = true );
+
     private:
         CContentHandler(); //no contruction for outsiders
         CContentHandler( const CContentHandler & ); //no copy
 
+        void RebuildDispatchTable();
+
         //The list of rules 
         std::vector< std::unique_ptr<IContentHandlingRule> > m_vRules;
+        ContentRuleDispatchTable                             m_dispatch;
 
         //The current rule id counter, for assigning ruleids
         cntRID_t m_current_ruleid;
@@ -220,6 +274,19 @@ namespace filetypes
         return CContentHandler::GetInstance().AnalyseContent( analysis_parameter(itbegdata,itenddata,filext) );
     }
 
+    /*
+        Determine the content type of every file in the list, in parallel.
+        Meant for classifying all the sub-files of a pack file at once.
+    */
+    inline std::vector<ContentBlock> DetermineCntTys( const std::vector<std::vector<uint8_t>> & files, bool bparallel = true )
+    {
+        std::vector<analysis_parameter> params;
+        params.reserve(files.size());
+        for( const auto & f : files )
+            params.push_back( analysis_parameter( f.begin(), f.end() ) );
+        return CContentHandler::GetInstance().AnalyseContents( params, bparallel );
+    }
+
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,123 @@
+#ifndef ASYNC_LOGGER_HPP
+#define ASYNC_LOGGER_HPP
+/*
+async_logger.hpp
+2016/08/02
+psycommando@gmail.com
+Description: A logger that hands log records off to a background thread, which writes them to disk.
+             Meant for the long multi-threaded runs, where buffering everything until exit isn't an option.
+*/
+#include <utils/multithread_logger.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace logging
+{
+    /*
+        eOverflowPolicy
+            What a thread does when its log buffer is full.
+    */
+    enum struct eOverflowPolicy
+    {
+        Block,  //Wait for the background thread to make room. Nothing is lost.
+        Drop,   //Drop the record. The number of dropped records is written to the log.
+    };
+
+    /***********************************************************************************
+        AsyncLogger
+            Each thread writes complete lines into its own fixed size ring buffer,
+            and a background thread drains all the buffers to the output. Writing a
+            record never takes a lock, and memory use is bounded by the ring size
+            times the number of threads that logged something.
+
+            Records are cut at line ends, or when a line gets longer than MaxRecordLen.
+            Lines from different threads can interleave, but lines from a same
+            thread stay in order.
+
+            Records under the minimum level are discarded before being formatted.
+    ***********************************************************************************/
+    class AsyncLogger : public BaseLogger
+    {
+    public:
+        static const size_t DefRingCapacity = 256 * 1024;
+        static const size_t MaxRecordLen    = 1024;
+
+        /*
+            Writes the log to the file at "outpath".
+        */
+        AsyncLogger( const std::string & outpath,
+                     eLogLevel           minlvl   = eLogLevel::Info,
+                     eOverflowPolicy     policy   = eOverflowPolicy::Block,
+                     size_t              ringsize = DefRingCapacity );
+
+        /*
+            Writes the log to "output". Only the background thread may write to it
+            until the logger is destroyed.
+        */
+        AsyncLogger( std::ostream    * output,
+                     eLogLevel         minlvl   = eLogLevel::Info,
+                     eOverflowPolicy   policy   = eOverflowPolicy::Block,
+                     size_t            ringsize = DefRingCapacity );
+
+        ~AsyncLogger();
+
+        using BaseLogger::Log;
+        std::ostream & Log()override;
+        std::ostream & Log( eLogLevel lvl )override;
+        bool           ShouldLog( eLogLevel lvl )const override;
+
+        /*
+            Blocks until everything the calling thread logged so far was written to the output.
+        */
+        void Flush()override;
+
+        void      SetMinLevel( eLogLevel lvl );
+        eLogLevel GetMinLevel()const;
+
+        uint64_t  NbDropped()const { return m_nbdropped.load(std::memory_order_relaxed); }
+
+    private:
+        class  record_ring;
+        class  record_streambuf;
+        struct thread_log;
+
+        AsyncLogger( const AsyncLogger & )             = delete;
+        AsyncLogger & operator=( const AsyncLogger & ) = delete;
+
+        void         Start();
+        void         Stop();
+        thread_log & ThisThreadLog();
+        void         Commit( thread_log & tl );
+        void         DrainLoop();
+        bool         DrainAll();
+
+        std::unique_ptr<std::ofstream>           m_pownedout;
+        std::ostream                           * m_pout;
+        std::atomic<int>                         m_minlvl;
+        eOverflowPolicy                          m_policy;
+        size_t                                   m_ringsize;
+        uint64_t                                 m_id;
+        std::atomic<uint64_t>                    m_nbdropped;
+
+        std::mutex                               m_registrymtx;
+        std::vector<std::unique_ptr<thread_log>> m_logs;
+        std::vector<thread_log*>                 m_drainlist;   //Only used by the background thread
+
+        std::thread                              m_drainthread;
+        std::atomic<bool>                        m_brunning;
+        std::mutex                               m_drainmtx;
+        std::condition_variable                  m_wakecv;
+        std::condition_variable                  m_passcv;
+        bool                                     m_bwake;
+        uint64_t                                 m_nbpasses;
+    };
+};
+
+#endif
@@ -0,0 +1,360 @@
+#ifndef BINARY_CURSOR_HPP
+#define BINARY_CURSOR_HPP
+/*
+binary_cursor.hpp
+2016/08/03
+psycommando@gmail.com
+Description: Fast little/big endian loads and stores, a cursor over a span of bytes that checks its
+             bounds once per block instead of once per byte, and compile-time layouts describing how
+             a struct's fields are laid out in a file.
+*/
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+namespace utils
+{
+    enum struct eByteOrder
+    {
+        Little,
+        Big,
+    };
+
+//==========================================================================================
+//  Loads and Stores
+//==========================================================================================
+    template<class T>
+        constexpr T ByteSwap( T val )
+    {
+        static_assert( std::is_integral<T>::value, "ByteSwap(): T is not an integer!" );
+        typedef typename std::make_unsigned<T>::type uns_t;
+        uns_t src = static_cast<uns_t>(val);
+        uns_t res = 0;
+        for( size_t i = 0; i < sizeof(T); ++i, src >>= 8 )
+            res = static_cast<uns_t>( (res << 8) | (src & 0xFFu) );
+        return static_cast<T>(res);
+    }
+
+    /*
+        Load/Store
+            Reads or writes an integer at any address, aligned or not, in the specified byte order.
+            The memcpy compiles down to a single load or store.
+    */
+    template<class T, eByteOrder _Order = eByteOrder::Little>
+        inline T Load( const uint8_t * psrc )
+    {
+        static_assert( std::is_integral<T>::value, "Load(): T is not an integer!" );
+        T val;
+        std::memcpy( &val, psrc, sizeof(T) );
+        if constexpr( (_Order == eByteOrder::Little) != (std::endian::native == std::endian::little) )
+            val = ByteSwap(val);
+        return val;
+    }
+
+    template<class T, eByteOrder _Order = eByteOrder::Little>
+        inline void Store( uint8_t * pdest, T val )
+    {
+        static_assert( std::is_integral<T>::value, "Store(): T is not an integer!" );
+        if constexpr( (_Order == eByteOrder::Little) != (std::endian::native == std::endian::little) )
+            val = ByteSwap(val);
+        std::memcpy( pdest, &val, sizeof(T) );
+    }
+
+    /*
+        byte_span_iterator
+            Iterators over contiguous bytes, which can be turned into a plain pointer.
+    */
+    template<class _ItTy>
+        concept byte_span_iterator = std::contiguous_iterator<_ItTy> && (sizeof(std::iter_value_t<_ItTy>) == 1);
+
+//==========================================================================================
+//  BinaryCursor
+//==========================================================================================
+    /*
+        BinaryCursor
+            Reads values from a span of bytes. Each read checks the bounds once, and throws
+            std::runtime_error if there's not enough bytes left.
+
+            Use Require() to check the bounds of a whole block at once, then the Unchecked
+            reads inside it.
+    */
+    class BinaryCursor
+    {
+    public:
+        BinaryCursor( const uint8_t * pbeg, const uint8_t * pend )
+            :m_pbeg(pbeg), m_pcur(pbeg), m_pend(pend)
+        {}
+
+        template<class _init>
+            BinaryCursor( _init itbeg, _init itend )
+            :BinaryCursor( ToPtr(itbeg), ToPtr(itbeg) + std::distance(itbeg, itend) )
+        {
+            static_assert( byte_span_iterator<_init>, "BinaryCursor(): The iterators must be over contiguous bytes!" );
+        }
+
+        inline size_t Tell     ()const { return static_cast<size_t>(m_pcur - m_pbeg); }
+        inline size_t Remaining()const { return static_cast<size_t>(m_pend - m_pcur); }
+        inline const uint8_t * Ptr()const { return m_pcur; }
+
+        inline void Require( size_t len )const
+        {
+            if( Remaining() < len )
+            {
+                throw std::runtime_error( "BinaryCursor::Require(): Tried to read " + std::to_string(len) + " bytes at offset " +
+                                         std::to_string(Tell()) + ", but only " + std::to_string(Remaining()) + " are left!" );
+            }
+        }
+
+        inline void Seek( size_t offset )
+        {
+            if( offset > static_cast<size_t>(m_pend - m_pbeg) )
+                throw std::runtime_error("BinaryCursor::Seek(): Offset out of range!");
+            m_pcur = m_pbeg + offset;
+        }
+
+        inline void Skip( size_t len )
+        {
+            Require(len);
+            m_pcur += len;
+        }
+
+        template<class T, eByteOrder _Order = eByteOrder::Little>
+            inline T Read()
+        {
+            Require(sizeof(T));
+            return ReadUnchecked<T,_Order>();
+        }
+
+        template<class T, eByteOrder _Order = eByteOrder::Little>
+            inline T ReadUnchecked()
+        {
+            const T val = Load<T,_Order>(m_pcur);
+            m_pcur += sizeof(T);
+            return val;
+        }
+
+        /*
+            Returns a pointer to the next "len" bytes, after checking they're all there.
+        */
+        inline const uint8_t * Take( size_t len )
+        {
+            Require(len);
+            const uint8_t * pblock = m_pcur;
+            m_pcur += len;
+            return pblock;
+        }
+
+    private:
+        template<class _init>
+            static const uint8_t * ToPtr( _init it )
+        {
+            return reinterpret_cast<const uint8_t*>( std::to_address(it) );
+        }
+
+        const uint8_t * m_pbeg;
+        const uint8_t * m_pcur;
+        const uint8_t * m_pend;
+    };
+
+//==========================================================================================
+//  Binary Layouts
+//==========================================================================================
+    /*
+        binary_codec
+            How a single field type is stored. Integers and enums are stored as their integer type,
+            and arrays one element after the other.
+    */
+    template<class T, class = void>
+        struct binary_codec;
+
+    template<class T>
+        struct binary_codec<T, typename std::enable_if<std::is_integral<T>::value>::type>
+    {
+        static constexpr size_t Size = sizeof(T);
+        template<eByteOrder _Order> static inline void Load ( T & dest, const uint8_t * psrc ) { dest = ::utils::Load<T,_Order>(psrc); }
+        template<eByteOrder _Order> static inline void Store( const T & src, uint8_t * pdest ) { ::utils::Store<T,_Order>(pdest, src); }
+    };
+
+    template<class T>
+        struct binary_codec<T, typename std::enable_if<std::is_enum<T>::value>::type>
+    {
+        typedef typename std::underlying_type<T>::type int_t;
+        static constexpr size_t Size = sizeof(int_t);
+        template<eByteOrder _Order> static inline void Load ( T & dest, const uint8_t * psrc ) { dest = static_cast<T>( ::utils::Load<int_t,_Order>(psrc) ); }
+        template<eByteOrder _Order> static inline void Store( const T & src, uint8_t * pdest ) { ::utils::Store<int_t,_Order>(pdest, static_cast<int_t>(src)); }
+    };
+
+    template<class T, size_t _Len>
+        struct binary_codec<std::array<T,_Len>, void>
+    {
+        static constexpr size_t Size = binary_codec<T>::Size * _Len;
+
+        template<eByteOrder _Order> static inline void Load( std::array<T,_Len> & dest, const uint8_t * psrc )
+        {
+            if constexpr( sizeof(T) == 1 )
+                std::memcpy( dest.data(), psrc, _Len );
+            else
+            {
+                for( size_t i = 0; i < _Len; ++i )
+                    binary_codec<T>::template Load<_Order>( dest[i], psrc + (i * binary_codec<T>::Size) );
+            }
+        }
+
+        template<eByteOrder _Order> static inline void Store( const std::array<T,_Len> & src, uint8_t * pdest )
+        {
+            if constexpr( sizeof(T) == 1 )
+                std::memcpy( pdest, src.data(), _Len );
+            else
+            {
+                for( size_t i = 0; i < _Len; ++i )
+                    binary_codec<T>::template Store<_Order>( src[i], pdest + (i * binary_codec<T>::Size) );
+            }
+        }
+    };
+
+    template<class _MemberPtrTy> struct member_ptr_traits;
+    template<class _StructTy, class _MemberTy>
+        struct member_ptr_traits<_MemberTy _StructTy::*>
+    {
+        typedef _StructTy struct_t;
+        typedef _MemberTy member_t;
+    };
+
+    /*
+        binfield
+            A struct member, stored in the specified byte order.
+    */
+    template<auto _MemberPtr, eByteOrder _Order = eByteOrder::Little>
+        struct binfield
+    {
+        typedef typename member_ptr_traits<decltype(_MemberPtr)>::struct_t struct_t;
+        typedef typename member_ptr_traits<decltype(_MemberPtr)>::member_t member_t;
+        static constexpr size_t Size = binary_codec<member_t>::Size;
+
+        template<class _StructTy> static inline void Load ( _StructTy & dest, const uint8_t * psrc ) { binary_codec<member_t>::template Load<_Order>( dest.*_MemberPtr, psrc ); }
+        template<class _StructTy> static inline void Store( const _StructTy & src, uint8_t * pdest ) { binary_codec<member_t>::template Store<_Order>( src.*_MemberPtr, pdest ); }
+    };
+
+    /*
+        binconst
+            A value that isn't kept in the struct. Written as-is, and skipped on read.
+            Handy for magic numbers and reserved zeros.
+    */
+    template<class T, T _Value, eByteOrder _Order = eByteOrder::Little>
+        struct binconst
+    {
+        static constexpr size_t Size = sizeof(T);
+        template<class _StructTy> static inline void Load ( _StructTy &, const uint8_t * ) {}
+        template<class _StructTy> static inline void Store( const _StructTy &, uint8_t * pdest ) { ::utils::Store<T,_Order>( pdest, _Value ); }
+    };
+
+    /*
+        binpad
+            Padding bytes. Written as zeros, and skipped on read.
+    */
+    template<size_t _Len>
+        struct binpad
+    {
+        static constexpr size_t Size = _Len;
+        template<class _StructTy> static inline void Load ( _StructTy &, const uint8_t * ) {}
+        template<class _StructTy> static inline void Store( const _StructTy &, uint8_t * pdest ) { std::memset( pdest, 0, _Len ); }
+    };
+
+    /*
+        binlayout
+            The fields of a struct, in the order they're stored in. The offset of each field is
+            known at compile time, so reading or writing the whole struct compiles down to one
+            load or store per field, after a single bounds check.
+
+            Ex:
+                typedef utils::binlayout< utils::binfield<&hdr::magic, utils::eByteOrder::Big>,
+                                          utils::binfield<&hdr::length>,
+                                          utils::binpad<4> > layout_t;
+    */
+    template<class ... _Fields>
+        struct binlayout
+    {
+        static constexpr size_t Size = (_Fields::Size + ... + 0);
+
+        template<class _StructTy>
+            static inline void Load( _StructTy & dest, const uint8_t * psrc )
+        {
+            size_t offset = 0;
+            ( ( _Fields::Load( dest, psrc + offset ), offset += _Fields::Size ), ... );
+        }
+
+        template<class _StructTy>
+            static inline void Store( const _StructTy & src, uint8_t * pdest )
+        {
+            size_t offset = 0;
+            ( ( _Fields::Store( src, pdest + offset ), offset += _Fields::Size ), ... );
+        }
+
+        template<class _StructTy>
+            static inline void Read( _StructTy & dest, BinaryCursor & cursor )
+        {
+            Load( dest, cursor.Take(Size) );
+        }
+
+        /*
+            Reads the struct from a pair of iterators over bytes, and returns the iterator past it.
+            Throws std::runtime_error if there aren't enough bytes.
+        */
+        template<class _StructTy, class _init>
+            static _init Read( _StructTy & dest, _init itbeg, _init itend )
+        {
+            if constexpr( byte_span_iterator<_init> )
+            {
+                if( std::distance(itbeg, itend) < static_cast<std::ptrdiff_t>(Size) )
+                    throw std::runtime_error("binlayout::Read(): Not enough bytes to read the structure!");
+                Load( dest, reinterpret_cast<const uint8_t*>( std::to_address(itbeg) ) );
+                return std::next( itbeg, Size );
+            }
+            else
+            {
+                std::array<uint8_t,Size> buf;
+                for( size_t i = 0; i < Size; ++i, ++itbeg )
+                {
+                    if( itbeg == itend )
+                        throw std::runtime_error("binlayout::Read(): Not enough bytes to read the structure!");
+                    buf[i] = static_cast<uint8_t>(*itbeg);
+                }
+                Load( dest, buf.data() );
+                return itbeg;
+            }
+        }
+
+        /*
+            Writes the struct to an output iterator, and returns the iterator past it.
+            Like the rest of the output iterator based writers, the room isn't checked.
+        */
+        template<class _StructTy, class _outit>
+            static _outit Write( const _StructTy & src, _outit itw )
+        {
+            if constexpr( byte_span_iterator<_outit> )
+            {
+                Store( src, reinterpret_cast<uint8_t*>( std::to_address(itw) ) );
+                return std::next( itw, Size );
+            }
+            else
+            {
+                std::array<uint8_t,Size> buf;
+                Store( src, buf.data() );
+                for( uint8_t abyte : buf )
+                {
+                    *itw = abyte;
+                    ++itw;
+                }
+                return itw;
+            }
+        }
+    };
+};
+
+#endif
@@ -0,0 +1,46 @@
+#ifndef BINARY_DELTA_HPP
+#define BINARY_DELTA_HPP
+/*
+binary_delta.hpp
+2016/08/09
+psycommando@gmail.com
+Description: Makes and applies compact binary deltas between two versions of a file. The blocks
+             the new version shares with the old one are found with a rolling hash, so moved and
+             partly changed data is encoded as copies from the old file.
+*/
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+namespace utils
+{
+    /*
+        Size of the blocks of the old file that are indexed. Shorter matches aren't found.
+    */
+    const size_t BinaryDelta_BlockLen = 16;
+
+    /************************************************************************
+        MakeBinaryDelta
+            Returns a delta turning "src" into "dst". The delta is a list of
+            copies from src and of literal bytes, with the integers encoded
+            on as few bytes as possible:
+
+                - Length of dst
+                - For each operation: (length << 1) | iscopy
+                    - Copy    : The signed distance from the end of the
+                                previous copy to the source offset, as a
+                                zigzag integer.
+                    - Literal : The bytes.
+    ************************************************************************/
+    std::vector<uint8_t> MakeBinaryDelta( const uint8_t * psrc, size_t srclen, const uint8_t * pdst, size_t dstlen );
+
+    /************************************************************************
+        ApplyBinaryDelta
+            Rebuilds the file a delta was made against "src" for.
+            Throws std::runtime_error if the delta is corrupted, or refers to
+            data past the end of src.
+    ************************************************************************/
+    std::vector<uint8_t> ApplyBinaryDelta( const uint8_t * psrc, size_t srclen, const uint8_t * pdelta, size_t deltalen );
+};
+
+#endif
@@ -0,0 +1,111 @@
+#ifndef FILE_SINK_HPP
+#define FILE_SINK_HPP
+/*
+file_sink.hpp
+2016/08/10
+psycommando@gmail.com
+Description: A service that takes finished file buffers from the export code, and writes them to disk
+             in batches on background threads, so the threads converting the data never wait on the
+             filesystem. Meant for exports writing thousands of small files, like sprite frames,
+             portraits, or one xml file per entry.
+*/
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace utils{ namespace io
+{
+    /***********************************************************************************
+        FileSink
+            Write() queues a file's whole content, and returns right away. Background
+            threads pick up the queued files in batches, and write them. On Linux,
+            each batch is submitted at once through io_uring, if the kernel allows it.
+            Otherwise, or on other systems, the files are written one after the other
+            with the usual system calls.
+
+            The directory a file goes into is created by Write() itself, before the
+            file is queued, so the writer threads only ever create files. Created
+            directories are remembered, so each is only checked once.
+
+            Queued files count towards a cap on the memory held by the sink. Write()
+            blocks while the cap is reached, until enough was written.
+
+            Errors are collected, and thrown by Flush() once everything queued before
+            it was written. Paths under a mounted VirtualFS are handed to it directly.
+            Write() may be called from any number of threads at once.
+    ***********************************************************************************/
+    class FileSink
+    {
+    public:
+        static const size_t DefMaxInFlight = 64 * 1024 * 1024;  //bytes
+        static const size_t DefBatchLen    = 32;                //files
+        static const size_t DefNbWriters   = 2;
+
+        FileSink( size_t maxinflight = DefMaxInFlight, size_t batchlen = DefBatchLen, size_t nbwriters = DefNbWriters );
+
+        /*
+            Waits for all the queued files to be written. Errors are logged, not thrown.
+        */
+        ~FileSink();
+
+        FileSink( const FileSink & )             = delete;
+        FileSink & operator=( const FileSink & ) = delete;
+
+        /*
+            Queues "data" to be written to "path", replacing any existing file.
+        */
+        void Write( const std::string & path, std::vector<uint8_t> && data );
+
+        /*
+            Creates the directory and its parents if they don't exist yet.
+        */
+        void PrepareDirectory( const std::string & dirpath );
+
+        /*
+            Blocks until everything queued so far was written. Throws std::runtime_error
+            listing the files that couldn't be written since the last call, if any.
+        */
+        void Flush();
+
+        //Whether the batches are written through io_uring.
+        bool UsesIoUring()const;
+
+        //A queued file. Used by the writer backends.
+        struct job_t
+        {
+            std::string          path;
+            std::vector<uint8_t> data;
+        };
+        class backend_t;
+
+    private:
+        void WriterThread( backend_t & backend );
+        void CreateDirectories( const std::string & dirpath );
+
+    private:
+        std::vector<std::unique_ptr<backend_t>> m_backends;     //One per writer thread
+        std::vector<std::thread>                m_writers;
+
+        std::mutex                              m_mtx;
+        std::condition_variable                 m_cvjobs;       //Signaled when files are queued, or on exit
+        std::condition_variable                 m_cvdone;       //Signaled when files were written
+        std::deque<job_t>                       m_jobs;
+        size_t                                  m_inflight;     //Bytes queued or being written
+        size_t                                  m_nbpending;    //Files queued or being written
+        const size_t                            m_maxinflight;
+        const size_t                            m_batchlen;
+        bool                                    m_bexit;
+        std::vector<std::string>                m_errors;
+
+        std::mutex                              m_dirmtx;
+        std::set<std::string>                   m_knowndirs;
+    };
+};};
+
+#endif
@@ -17,6 +17,7 @@ A bunch of simple tools for doing common tasks when manipulating bytes.
 #include <cassert>
 #include <stdexcept>
 #include <cmath>
+#include <utils/binary_cursor.hpp>
 
 namespace utils 
 {
@@ -54,12 +55,23 @@ namespace utils
         WriteIntToBytes
             Tool to write integer values into a byte vector!
             Returns the new pos of the iterator after the operation.
+            Iterators over contiguous bytes get a single store.
     *********************************************************************************************/
     template<class T, class _outit>
         inline _outit WriteIntToBytes( T val, _outit itout, bool basLittleEndian = true )
     {
         static_assert( std::numeric_limits<T>::is_integer, "WriteIntToBytes() : Type T is not an integer!" );
 
+        if constexpr( byte_span_iterator<_outit> && std::is_integral<T>::value && !std::is_same<T,bool>::value )
+        {
+            uint8_t * pdest = reinterpret_cast<uint8_t*>( std::to_address(itout) );
+            if( basLittleEndian )
+                Store<T, eByteOrder::Little>( pdest, val );
+            else
+                Store<T, eByteOrder::Big>( pdest, val );
+            return std::next( itout, sizeof(T) );
+        }
+
         ////#FIXME: Why is this even necessary?
         //auto lambdaShiftAssign = [&val]( unsigned int shiftamt )->uint8_t
         //{
@@ -157,11 +169,27 @@ namespace utils
         ReadIntFromBytes
             Tool to read integer values from a byte vector!
             ** The iterator's passed as input, has its position changed !!
+            Iterators over contiguous bytes get a single bounds check and load.
     *********************************************************************************************/
     template<class T, class _init> 
         inline T ReadIntFromBytes( _init & itin, _init itend, bool basLittleEndian = true )
     {
         static_assert( std::numeric_limits<T>::is_integer, "ReadIntFromBytes() : Type T is not an integer!" );
+
+        if constexpr( byte_span_iterator<_init> && std::is_integral<T>::value && !std::is_same<T,bool>::value )
+        {
+            if( std::distance( itin, itend ) < static_cast<std::ptrdiff_t>(sizeof(T)) )
+            {
+#ifdef _DEBUG
+                assert(false);
+#endif
+                throw std::runtime_error( "ReadIntFromBytes(): Not enough bytes to read from the source container!" );
+            }
+            const uint8_t * psrc = reinterpret_cast<const uint8_t*>( std::to_address(itin) );
+            itin = std::next( itin, sizeof(T) );
+            return basLittleEndian? Load<T, eByteOrder::Little>(psrc) : Load<T, eByteOrder::Big>(psrc);
+        }
+
         T out_val = 0;
 
         if( basLittleEndian )
@@ -170,7 +198,7 @@ namespace utils
             for( ; (itin != itend) && (i < sizeof(T)); ++i, ++itin )
             {
                 T tmp = (*itin);
-                out_val |= ( tmp << (i * 8) ) & ( 0xFF << (i*8) );
+                out_val |= ( tmp << (i * 8) ) & ( static_cast<T>(0xFF) << (i*8) );
             }
 
             if( i != sizeof(T) )
@@ -187,7 +215,7 @@ namespace utils
             for( ; (itin != itend) && (i >= 0); --i, ++itin )
             {
                 T tmp = (*itin);
-                out_val |= ( tmp << (i * 8) ) & ( 0xFF << (i*8) );
+                out_val |= ( tmp << (i * 8) ) & ( static_cast<T>(0xFF) << (i*8) );
             }
 
             if( i != -1 )
@@ -10,15 +10,21 @@ Description: A few utilities to encapsulate writing stuff to files.
 #include <string>
 #include <cstdint>
 #include <locale>
+#include <istream>
+#include <memory>
 //#include <iostream>
 
 namespace utils{ namespace io
 {
+    class VirtualFS;
+
     /************************************************************************
         ReadFileToByteVector
             Read the file content straight into a byte vector, with no
             processing at all. Takes the path to the file and a vector to
             put the data as parameters.
+
+            Files under a mounted VirtualFS are copied from it.
     ************************************************************************/
     void                 ReadFileToByteVector(const std::string & path, std::vector<uint8_t> & out_filedata);
     std::vector<uint8_t> ReadFileToByteVector(const std::string & path );
@@ -31,6 +37,51 @@ namespace utils{ namespace io
     ************************************************************************/
     void WriteByteVectorToFile(const std::string & path, const std::vector<uint8_t> & in_filedata);
 
+    /************************************************************************
+        MappedFile
+            Maps a whole file read-only into the address space, so it can be
+            accessed as a byte array without reading it all in first. 
+            The OS only pages in the parts that are actually touched, which
+            keeps memory use bounded when scanning huge files like ROMs.
+
+            Files under a mounted VirtualFS aren't mapped again, the view
+            points into the VirtualFS's data, and keeps it alive.
+    ************************************************************************/
+    class MappedFile
+    {
+    public:
+        MappedFile(){}
+        explicit MappedFile( const std::string & path );
+        MappedFile( MappedFile && mv );
+        MappedFile & operator=( MappedFile && mv );
+        ~MappedFile();
+
+        MappedFile( const MappedFile & )             = delete;
+        MappedFile & operator=( const MappedFile & ) = delete;
+
+        void Open ( const std::string & path );
+        void Close();
+
+        inline const uint8_t * data ()const { return m_pdata; }
+        inline size_t          size ()const { return m_size;  }
+        inline bool            empty()const { return m_size == 0; }
+        inline const uint8_t * begin()const { return m_pdata; }
+        inline const uint8_t * end  ()const { return m_pdata + m_size; }
+
+    private:
+        const uint8_t                    * m_pdata = nullptr;
+        size_t                             m_size  = 0;
+        std::shared_ptr<const VirtualFS>   m_pvfs;          //Set when the data belongs to a VirtualFS
+    };
+
+    /************************************************************************
+        OpenInputFile
+            Opens a file as a seekable binary input stream. Files under a 
+            mounted VirtualFS are read from memory, without a copy.
+            Throws if the file can't be opened.
+    ************************************************************************/
+    std::unique_ptr<std::istream> OpenInputFile( const std::string & path );
+
 
     /*
         Reads a file line by line, and put each lines into a vector of string.
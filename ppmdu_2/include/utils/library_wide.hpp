@@ -138,6 +138,11 @@ namespace utils
         {
             return ::utils::LibWide().Logger().Log();
         }
+
+        inline std::ostream & slog( logging::eLogLevel lvl )
+        {
+            return ::utils::LibWide().Logger().Log(lvl);
+        }
     };
 };
 
@@ -0,0 +1,61 @@
+#ifndef LOCAL_SERVER_HPP
+#define LOCAL_SERVER_HPP
+/*
+local_server.hpp
+2016/07/16
+psycommando@gmail.com
+Description: A minimal line based server listening on a local (Unix domain) socket.
+             Meant for letting other programs on the same machine send commands to a long running tool.
+*/
+#include <string>
+#include <functional>
+
+namespace utils
+{
+    /************************************************************************
+        LocalLineServer
+            Listens on a Unix domain socket, and hands every line received to
+            a handler. The handler's reply is sent back as a single line.
+
+            Clients are served one at a time, in the order they connect, and
+            each client may send as many requests as it wants before
+            disconnecting. So the handler never runs concurrently with itself.
+
+            The socket file is created when the server starts, and removed
+            when it's destroyed. Not supported on Windows.
+    ************************************************************************/
+    class LocalLineServer
+    {
+    public:
+        /*
+            Receives the request line, without the line ending, and fills the reply.
+            Returning false stops the server after the reply is sent.
+        */
+        typedef std::function<bool(const std::string & request, std::string & reply)> handler_t;
+
+        /*
+            Starts listening on the socket file. Throws if the socket can't be
+            created, or if the path already exists and isn't a socket.
+        */
+        explicit LocalLineServer( const std::string & sockpath );
+        ~LocalLineServer();
+
+        LocalLineServer( const LocalLineServer & )             = delete;
+        LocalLineServer & operator=( const LocalLineServer & ) = delete;
+
+        /*
+            Serves clients until the handler returns false.
+        */
+        void Run( handler_t handler );
+
+        inline const std::string & SocketPath()const { return m_sockpath; }
+
+    private:
+        bool ServeClient( int clientfd, handler_t & handler );
+
+        std::string m_sockpath;
+        int         m_listenfd;
+    };
+};
+
+#endif
@@ -31,6 +31,18 @@ namespace logging
         class OneOutputForAll{};
     };
 
+    /***********************************************************************************
+        eLogLevel
+            Severity of a log record. Plain Log() calls log at the Info level.
+    ***********************************************************************************/
+    enum struct eLogLevel : int
+    {
+        Debug,
+        Info,
+        Warning,
+        Error,
+    };
+
     /***********************************************************************************
         BaseLogger
             Interface for loggers.
@@ -41,6 +53,13 @@ namespace logging
         virtual ~BaseLogger(){}
         virtual std::ostream & Log(){ return std::clog; }
 
+        /*
+            Loggers filtering on severity return a stream discarding everything for levels
+            that are filtered out. Use ShouldLog() to skip building expensive messages.
+        */
+        virtual std::ostream & Log( eLogLevel lvl ){ return Log(); }
+        virtual bool           ShouldLog( eLogLevel lvl )const { return true; }
+
         virtual void Flush(){};
         //inline operator std::ostream&()
         //{
@@ -7,12 +7,15 @@ psycommando@gmail.com
 Description: A set of utilities for handling multi-threaded tasks execution. Meant to replace the previous implementation.
 */
 #include <utils/library_wide.hpp>
+#include <utils/trace_profiler.hpp>
 #include <thread>
 #include <mutex>
 #include <condition_variable>
 #include <vector>
 #include <deque>
 #include <future>
+#include <functional>
+#include <string>
 
 namespace utils
 {
@@ -221,6 +224,8 @@ namespace utils
     private:
         void Work()
         {
+            if( Profiler().IsEnabled() )
+                Profiler().SetThreadName("worker");
             while(!m_ptasks->empty() && m_bshouldwork)
             {
                 TaskQueue::task_t mytask;
@@ -228,6 +233,7 @@ namespace utils
                 {
                     try
                     {
+                        TraceScope trace("task");
                         mytask();
                     }
                     catch(const std::exception &)
@@ -302,6 +308,14 @@ namespace utils
         std::vector<AsyncWorker>    m_workers;
         std::atomic_bool            m_bshouldrun;
     };
+
+    /*
+        RunIndexedTasks
+            Runs "task" once for every index in [0, nbtasks), on an AsyncTaskHandler, and waits until all of them are done.
+            A task throwing doesn't stop the others. Once everything ran, if any task failed, a single runtime_error is thrown,
+            starting with "errorheader", and listing the errors of every failed task in index order.
+    */
+    void RunIndexedTasks( size_t nbtasks, const std::function<void(size_t)> & task, const std::string & errorheader );
 };
 
 #endif
@@ -6,6 +6,7 @@ poco_wrapper.hpp
 psycommando@gmail.com
 Description: A wrapper to avoid including POCO for doing some common file operations.
 */
+#include <cstdint>
 #include <string>
 #include <vector>
 
@@ -110,6 +111,26 @@ namespace utils
     */
     std::string MakeAbsolutePath( const std::string & relp, const std::string & absbasep );
     std::string MakeAbsolutePath( const std::string & relp );
+
+    /************************************************************************
+        GetPathStateStamp
+            Returns a value that changes whenever the file, or anything in 
+            the directory and its sub-directories, is added, removed, 
+            resized or modified. Only the file sizes and last modification
+            times are looked at, the content isn't read.
+            Returns 0 if the path doesn't exist.
+    ************************************************************************/
+    uint64_t GetPathStateStamp( const std::string & path );
+
+    /************************************************************************
+        ReplaceFile
+            Moves the file at "srcpath" over "destpath" in a single rename,
+            replacing it if it exists. Both paths must be on the same 
+            volume. Readers of "destpath" see either the old or the new
+            file, never a partially written one.
+            Throws on failure.
+    ************************************************************************/
+    void ReplaceFile( const std::string & srcpath, const std::string & destpath );
 };
 
 #endif
\ No newline at end of file
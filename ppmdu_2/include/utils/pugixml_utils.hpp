@@ -8,11 +8,14 @@ Description:
     A bunch of tools for doing repetitive things with the pugixml lib!
     Don't include in another header!!
 */
+#include <cstdint>
 #include <string>
 #include <pugixml.hpp>
 #include <codecvt>
 #include <locale>
 #include <sstream>
+#include <vector>
+#include <memory>
 
 namespace pugixmlutils
 {
@@ -210,6 +213,23 @@ namespace pugixmlutils
             If there were no errors while parsing does nothing. Otherwise throws an appropriate exception!
     */
     void HandleParsingError( const pugi::xml_parse_result & result, const std::string & xmlpath );
+
+    /*
+        LoadXMLDocuments
+            Loads all the xml files in the list. The documents are returned in the same order as the files.
+            If bparallel is true, the files are loaded and parsed on several threads.
+            All files are attempted, and a single exception listing every file that failed to load is thrown at the end.
+    */
+    std::vector<std::unique_ptr<pugi::xml_document>> LoadXMLDocuments( const std::vector<std::string> & files, bool bparallel );
+
+    /*
+        SaveXMLToBuffer
+            Returns the document exactly as save_file() would write it, so it can be written later, by a FileSink for example.
+    */
+    std::vector<uint8_t> SaveXMLToBuffer( const pugi::xml_document & doc, 
+                                          const pugi::char_t        * indent   = "\t", 
+                                          unsigned int                flags    = pugi::format_default, 
+                                          pugi::xml_encoding          encoding = pugi::encoding_auto );
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,182 @@
+#ifndef TRACE_PROFILER_HPP
+#define TRACE_PROFILER_HPP
+/*
+trace_profiler.hpp
+2016/07/18
+psycommando@gmail.com
+Description: A lightweight tracing profiler. Records timed spans and counters from any thread,
+             and writes them in the Chrome trace event JSON format, which chrome://tracing and
+             Perfetto can both open.
+*/
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace utils
+{
+    /************************************************************************
+        TraceProfiler
+            Singleton collecting the trace events of the whole program.
+
+            Every thread records into its own buffer, which only that thread
+            ever writes to, so recording never takes a lock. The buffers are
+            owned by the profiler, and outlive the threads that filled them.
+
+            Recording is off until Enable() is called. While off, spans and
+            counters cost a single relaxed atomic load.
+    ************************************************************************/
+    class TraceProfiler
+    {
+    public:
+        typedef std::chrono::steady_clock clock_t;
+
+        static TraceProfiler & GetInstance();
+
+        /*
+            Starts recording. The trace is written to "outputpath" by Finish().
+        */
+        void Enable( const std::string & outputpath );
+        inline bool IsEnabled()const { return m_benabled.load(std::memory_order_relaxed); }
+
+        /*
+            Stops recording and writes the trace file, if recording was enabled.
+            Spans still open at that point are left out.
+        */
+        void Finish();
+
+        /*
+            Writes everything recorded so far as a Chrome trace JSON object.
+        */
+        void WriteChromeTrace( std::ostream & os )const;
+
+        /*
+            The name pointers must stay valid until the trace is written. String literals, or
+            the result of InternName().
+        */
+        void RecordSpan   ( const char * name, clock_t::time_point beg, clock_t::time_point end );
+        void RecordCounter( const char * name, int64_t value );
+
+        /*
+            Names the calling thread in the trace.
+        */
+        void SetThreadName( const std::string & name );
+
+        /*
+            Returns a pointer to a copy of the string that lives as long as the profiler.
+            Takes a lock, so keep it out of hot loops.
+        */
+        const char * InternName( const std::string & name );
+
+    private:
+        struct trace_event
+        {
+            const char * name;
+            uint64_t     tsns;
+            int64_t      durorval;  //Duration in nanoseconds for spans, value for counters
+            char         phase;     //'X' for spans, 'C' for counters
+        };
+
+        /*
+            Events are appended to fixed size chunks. The count is published after the event
+            is written, so the buffer can be read while its thread is still recording.
+        */
+        struct trace_chunk
+        {
+            static const size_t       Capacity = 4096;
+            trace_event               events[Capacity];
+            std::atomic<size_t>       nbused {0};
+            std::atomic<trace_chunk*> next   {nullptr};
+        };
+
+        struct thread_buffer
+        {
+            uint32_t                                  tid    = 0;
+            std::atomic<const char*>                  tname  {nullptr};
+            trace_chunk                             * pfirst = nullptr;
+            trace_chunk                             * pcur   = nullptr;   //Chunk being filled. Only used by the owning thread
+            std::vector<std::unique_ptr<trace_chunk>> chunks;             //Owns the chunks. Only the owning thread adds to it
+        };
+
+        TraceProfiler();
+        TraceProfiler( const TraceProfiler & )             = delete;
+        TraceProfiler & operator=( const TraceProfiler & ) = delete;
+
+        thread_buffer & ThisThreadBuffer();
+        void            Push( const trace_event & ev );
+
+        std::atomic<bool>                            m_benabled;
+        clock_t::time_point                          m_start;
+        std::string                                  m_outpath;
+
+        mutable std::mutex                           m_registrymtx;
+        std::vector<std::unique_ptr<thread_buffer>>  m_buffers;
+
+        std::mutex                                   m_namesmtx;
+        std::unordered_set<std::string>              m_names;
+    };
+
+    inline TraceProfiler & Profiler() { return TraceProfiler::GetInstance(); }
+
+    /************************************************************************
+        TraceScope
+            Records a span from its construction to its destruction.
+            The name must be a string literal, or come from InternName().
+    ************************************************************************/
+    class TraceScope
+    {
+    public:
+        explicit TraceScope( const char * name )
+            :m_name(name), m_brecording(Profiler().IsEnabled())
+        {
+            if( m_brecording )
+                m_start = TraceProfiler::clock_t::now();
+        }
+
+        ~TraceScope()
+        {
+            if( m_brecording )
+                Profiler().RecordSpan( m_name, m_start, TraceProfiler::clock_t::now() );
+        }
+
+        TraceScope( const TraceScope & )             = delete;
+        TraceScope & operator=( const TraceScope & ) = delete;
+
+    private:
+        const char                        * m_name;
+        bool                                m_brecording;
+        TraceProfiler::clock_t::time_point  m_start;
+    };
+
+    /************************************************************************
+        TraceCounter
+            A named running total, shown as a graph in the trace.
+            Meant to be declared once as a static, and added to from anywhere.
+    ************************************************************************/
+    class TraceCounter
+    {
+    public:
+        explicit TraceCounter( const char * name )
+            :m_name(name), m_total(0)
+        {}
+
+        inline void Add( int64_t amount )
+        {
+            if( Profiler().IsEnabled() )
+                Profiler().RecordCounter( m_name, m_total.fetch_add(amount, std::memory_order_relaxed) + amount );
+        }
+
+        inline int64_t Total()const { return m_total.load(std::memory_order_relaxed); }
+
+    private:
+        const char           * m_name;
+        std::atomic<int64_t>   m_total;
+    };
+};
+
+#endif
@@ -12,6 +12,7 @@ Description: A header with a bunch of useful includes for the PPMD utilities.
 #include "gbyteutils.hpp"
 #include "poco_wrapper.hpp"
 #include "common_suffixes.hpp"
+#include "trace_profiler.hpp"
 #include <chrono>
 #include <string>
 #include <iostream>
@@ -73,6 +74,7 @@ namespace utils
         ChronoRAII
             A small utility RAII class that that tells the time elapsed 
             between its construction and destruction.
+            When profiling is on, the scope is also recorded as a span in the trace.
     ************************************************************************/
     template<class TimescaleT = std::chrono::milliseconds>
         struct ChronoRAII
@@ -92,7 +94,10 @@ namespace utils
 
         ~ChronoRAII()
         {
-            auto myduration = std::chrono::steady_clock::now() - _start;
+            const auto end        = std::chrono::steady_clock::now();
+            auto       myduration = end - _start;
+            if( Profiler().IsEnabled() )
+                Profiler().RecordSpan( Profiler().InternName(_name), _start, end );
             (*_output) << "#" <<_name << ": Time elapsed : " << std::chrono::duration_cast<timescale_t>( myduration ).count() 
                        << gtimesymbol<timescale_t>::symbol << "\n";
         }
@@ -0,0 +1,86 @@
+#ifndef VIRTUAL_FS_HPP
+#define VIRTUAL_FS_HPP
+/*
+virtual_fs.hpp
+2016/08/05
+psycommando@gmail.com
+Description: Lets file trees that don't exist on disk, like the content of a ROM image, be mounted
+             under a path, so the usual file utilities can read from them.
+*/
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace utils{ namespace io
+{
+    /************************************************************************
+        VirtualFS
+            A file tree, whose files are already in memory. Writing to it is
+            optional.
+
+            Paths passed to it are relative to the mount point, use '/' as
+            separator, and have no leading or trailing slash. The empty
+            string is the root directory.
+    ************************************************************************/
+    class VirtualFS
+    {
+    public:
+        virtual ~VirtualFS(){}
+
+        /*
+            Returns false if there's no file at relpath. The data stays valid as long as the VirtualFS exists.
+        */
+        virtual bool GetFile( const std::string & relpath, const uint8_t *& out_pdata, size_t & out_len )const = 0;
+        virtual bool IsDir  ( const std::string & relpath )const = 0;
+
+        /*
+            Returns false if there's no directory at relpath. Directory names end with a '/'.
+        */
+        virtual bool ListDir( const std::string & relpath, std::vector<std::string> & out_names )const = 0;
+
+        /*
+            Replaces the content of the file at relpath. Returns false if the VirtualFS is read-only.
+            The data GetFile returned for that file before may not be valid anymore afterwards.
+        */
+        virtual bool PutFile( const std::string & /*relpath*/, const uint8_t * /*pdata*/, size_t /*len*/ ) { return false; }
+    };
+
+    /************************************************************************
+        MountVirtualFS
+            Makes the content of the VirtualFS visible under "mountpoint".
+            The mount point may be the path of an existing file, typically
+            the image the VirtualFS was loaded from. It is then seen as a
+            directory by the file utilities, except when mapping or reading
+            the file itself.
+
+            Mounting on a path that is already mounted replaces the previous
+            VirtualFS.
+    ************************************************************************/
+    void MountVirtualFS  ( const std::string & mountpoint, std::shared_ptr<VirtualFS> vfs );
+    void UnmountVirtualFS( const std::string & mountpoint );
+
+    /************************************************************************
+        FindVirtualFS
+            Returns the VirtualFS mounted over "path", and puts the part of
+            the path relative to the mount point into "out_relpath".
+            Returns null if the path isn't under any mount point.
+    ************************************************************************/
+    std::shared_ptr<VirtualFS> FindVirtualFS( const std::string & path, std::string & out_relpath );
+
+    /************************************************************************
+        WriteToVirtualFS
+            If the path is under a mount point, hands the data to the 
+            VirtualFS and returns true. Returns false if the path isn't
+            under any mount point, so the caller writes it to disk.
+            Throws if the VirtualFS is read-only.
+    ************************************************************************/
+    bool WriteToVirtualFS( const std::string & path, const uint8_t * pdata, size_t len );
+
+    /*
+        Turns back slashes into slashes, and removes repeated slashes, "." components and the trailing slash.
+    */
+    std::string NormalizeVirtualPath( const std::string & path );
+};};
+
+#endif
@@ -6,6 +6,7 @@
 #include <sstream>
 #include <fstream>
 #include <array>
+#include <algorithm>
 #include <iostream>
 #include <types/content_type_analyser.hpp>
 #include <utils/library_wide.hpp>
@@ -97,23 +98,19 @@ namespace DSE
     std::pair<PresetBank, MusicSequence> ReadBgmContainer( const std::string & filepath )
     {
         vector<uint8_t> fdata( move( utils::io::ReadFileToByteVector( filepath ) ) );
-        sir0_header     hdr;
+        const SIR0View  sir0(fdata);
 
-        hdr.ReadFromContainer( fdata.begin(), fdata.end() );
+        //The sub-header is the pointers to the 2 containers, which are read in place
+        const std::array<uint32_t,2> offsets = 
+        {{
+            sir0.ReadPointer( sir0.SubHeaderOffset() ),
+            sir0.ReadPointer( sir0.SubHeaderOffset() + sizeof(uint32_t) ),
+        }};
+        if( std::max( offsets[0], offsets[1] ) > sir0.SubHeaderOffset() )
+            throw runtime_error( "ReadBgmContainer() : The containers aren't before the sub-header in \"" + filepath + "\"!" );
 
-        if( hdr.magic != sir0_header::MAGIC_NUMBER )
-            throw runtime_error( "ReadBgmContainer() : File is missing SIR0 header!" );
-            
-        auto        offsets = ReadOffsetsSubHeader( fdata.begin(), fdata.end(), hdr.subheaderptr );
-
-        //SWDL_Header swdhdr;
-        //SMDL_Header smdhdr;
-        //swdhdr.ReadFromContainer( fdata.begin() + offsets[0] );
-        //smdhdr.ReadFromContainer( fdata.begin() + offsets[1] );
-        uint32_t magicn1 = 0;
-        uint32_t magicn2 = 0;
-        utils::ReadIntFromBytes(magicn1, fdata.begin() + offsets[0], fdata.end(), false);
-        utils::ReadIntFromBytes(magicn2, fdata.begin() + offsets[1], fdata.end(), false);
+        const uint32_t magicn1 = sir0.CursorAt(offsets[0]).Read<uint32_t, utils::eByteOrder::Big>();
+        const uint32_t magicn2 = sir0.CursorAt(offsets[1]).Read<uint32_t, utils::eByteOrder::Big>();
 
         size_t smdloffset = 0;
         size_t swdloffset = 0;
@@ -158,12 +155,13 @@ namespace DSE
             throw runtime_error( sstrerror.str() );
         }
 
-        auto itbegswdl = fdata.begin() + swdloffset;
-        auto itendswdl = fdata.begin() + smdloffset;
-        auto itbegsmdl = itendswdl;
-        auto itendsmdl = fdata.begin() + hdr.subheaderptr;
+        //Each container ends where the next one, or the sub-header, begins
+        const uint8_t * pbegswdl = sir0.Data() + swdloffset;
+        const uint8_t * pendswdl = sir0.Data() + ( (swdloffset < smdloffset)? smdloffset : sir0.SubHeaderOffset() );
+        const uint8_t * pbegsmdl = sir0.Data() + smdloffset;
+        const uint8_t * pendsmdl = sir0.Data() + ( (smdloffset < swdloffset)? swdloffset : sir0.SubHeaderOffset() );
 
-        return move( make_pair( move(ParseSWDL( itbegswdl, itendswdl )), move(ParseSMDL( itbegsmdl, itendsmdl )) ) );               
+        return move( make_pair( move(ParseSWDL( pbegswdl, pendswdl )), move(ParseSMDL( pbegsmdl, pendsmdl )) ) );               
     }
 
     /*
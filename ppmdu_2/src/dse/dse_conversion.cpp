@@ -2,8 +2,10 @@
 #include <dse/dse_common.hpp>
 #include <dse/dse_sequence.hpp>
 #include <dse/dse_interpreter.hpp>
+#include <dse/dse_renderer.hpp>
 #include <dse/dse_containers.hpp>
 #include <utils/library_wide.hpp>
+#include <utils/trace_profiler.hpp>
 #include <utils/audio_utilities.hpp>
 #include <utils/poco_wrapper.hpp>
 
@@ -1411,6 +1413,7 @@ namespace DSE
     ***************************************************************************************/
     vector<SMDLPresetConversionInfo> BatchAudioLoader::ExportSoundfontBakedSamples( const std::string & destf )
     {
+        utils::TraceScope trace("dse export soundfont baked");
         using namespace sf2;
         vector<SMDLPresetConversionInfo> trackprgconvlist;
         m_stats = audiostats(); //reset stats
@@ -1542,6 +1545,7 @@ namespace DSE
     ***************************************************************************************/
     vector<SMDLPresetConversionInfo> BatchAudioLoader::ExportSoundfont( const std::string & destf )
     {
+        utils::TraceScope trace("dse export soundfont");
         using namespace sf2;
 
         if((m_pairs.size() > std::numeric_limits<int8_t>::max()) && !m_bSingleSF2)
@@ -1635,6 +1639,7 @@ namespace DSE
     ***************************************************************************************/
     void BatchAudioLoader::ExportXMLPrograms( const std::string & destf )
     {
+        utils::TraceScope trace("dse export xml programs");
         //static const string _DefaultMainSampleDirName = "mainbank";
         //static const string _DefaultSWDLSmplDirName   = "samples";
 
@@ -1678,6 +1683,7 @@ namespace DSE
     ***************************************************************************************/
     void BatchAudioLoader::ExportSoundfontAndMIDIs( const std::string & destdir, int nbloops, bool bbakesamples )
     {
+        utils::TraceScope trace("dse export soundfont and midis");
         //Export the soundfont first
 
         Poco::Path outsoundfont(destdir);
@@ -1714,6 +1720,7 @@ namespace DSE
     ***************************************************************************************/
     void BatchAudioLoader::ExportXMLAndMIDIs( const std::string & destdir, int nbloops )
     {
+        utils::TraceScope trace("dse export xml and midis");
         static const string _DefaultMainSampleDirName = "mainbank";
 
         if( IsMasterBankLoaded() )
@@ -1767,6 +1774,7 @@ namespace DSE
     ***************************************************************************************/
     void BatchAudioLoader::BuildMasterFromPairs()
     {
+        utils::TraceScope trace("dse build master bank");
         vector<SampleBank::smpldata_t> smpldata;
         bool                           bnosmpldata = true;
 
@@ -1891,6 +1899,7 @@ namespace DSE
     ***************************************************************************************/
     void BatchAudioLoader::LoadMatchedSMDLSWDLPairs( const std::string & swdldir, const std::string & smdldir )
     {
+        utils::TraceScope trace("dse load smdl swdl pairs");
         //Grab all the swd and smd pairs in the folder
         Poco::DirectoryIterator dirit(smdldir);
         Poco::DirectoryIterator diritend;
@@ -1953,6 +1962,7 @@ namespace DSE
     */
     void BatchAudioLoader::LoadBgmContainers( const std::string & bgmdir, const std::string & ext )
     {
+        utils::TraceScope trace("dse load bgm containers");
         //Grab all the bgm containers in here
         Poco::DirectoryIterator dirit(bgmdir);
         Poco::DirectoryIterator diritend;
@@ -2040,6 +2050,7 @@ namespace DSE
     */
     void BatchAudioLoader::ExportMIDIs( const std::string & destdir, const std::string & cvinfopath, int nbloops )
     {
+        utils::TraceScope trace("dse export midis");
         DSE::SMDLConvInfoDB cvinf;
 
         if( ! cvinfopath.empty() )
@@ -2083,15 +2094,51 @@ namespace DSE
         }
     }
 
+    void BatchAudioLoader::ExportWAVs( const std::string & destdir, int nbloops )
+    {
+        utils::TraceScope trace("dse export wavs");
+        auto pmastersmpls = m_master.smplbank().lock();
+        std::vector<DSE::RenderJob> jobs;
+        jobs.reserve(m_pairs.size());
+
+        for( size_t i = 0; i < m_pairs.size(); ++i )
+        {
+            auto pprgms = m_pairs[i].second.prgmbank().lock();
+            auto psmpls = (pmastersmpls != nullptr)? pmastersmpls : m_pairs[i].second.smplbank().lock();
+
+            if( pprgms == nullptr || psmpls == nullptr )
+            {
+                clog <<"<!>- BatchAudioLoader::ExportWAVs(): Pair #" <<i <<" has no programs or samples to play! Skipping!\n";
+                continue;
+            }
+
+            Poco::Path fpath(destdir);
+            fpath.append( to_string(i) + "_" + m_pairs[i].first.metadata().fname).makeFile().setExtension("wav");
+
+            DSE::RenderJob job;
+            job.pseq    = &m_pairs[i].first;
+            job.pprgms  = pprgms.get();
+            job.psmpls  = psmpls.get();
+            job.outpath = fpath.toString();
+            jobs.push_back(std::move(job));
+        }
+
+        DSE::RenderParams params;
+        params.nbloops = nbloops;
+        cout <<"<*>- Rendering " <<jobs.size() <<" sequences to " <<destdir <<"..\n";
+        DSE::RenderSequencesToWave( jobs, params );
+    }
+
 
     /*
     */
     void BatchAudioLoader::LoadFromBlobFile(const std::string & blob, bool matchbyname)
     {
 
-        vector<uint8_t> filedata = utils::io::ReadFileToByteVector( blob );
+        //Map the blob instead of loading it, since it may be a whole ROM or RAM dump
+        utils::io::MappedFile filedata( blob );
 
-        BlobScanner<vector<uint8_t>::const_iterator> blobscan( filedata.begin(), filedata.end(), matchbyname);
+        BlobScanner<const uint8_t*> blobscan( filedata.begin(), filedata.end(), matchbyname);
         blobscan.Scan();
         auto foundpairs = blobscan.ListAllMatchingSMDLPairs();
 
@@ -2157,9 +2204,9 @@ namespace DSE
     */
     void BatchAudioLoader::LoadSMDLSWDLPairsAndBankFromBlob( const std::string & blob, const std::string & bankname )
     {
-        vector<uint8_t> filedata = utils::io::ReadFileToByteVector( blob );
+        utils::io::MappedFile filedata( blob );
 
-        BlobScanner<vector<uint8_t>::const_iterator> blobscan( filedata.begin(), filedata.end() );
+        BlobScanner<const uint8_t*> blobscan( filedata.begin(), filedata.end() );
         blobscan.Scan();
         auto foundpairs = blobscan.ListAllMatchingSMDLPairs();
 
@@ -2189,8 +2236,8 @@ namespace DSE
         }
 
         string fixedbankname;
-        if( bankname.size() > BlobScanner<vector<uint8_t>::const_iterator>::FilenameLength )
-            fixedbankname = bankname.substr( 0, BlobScanner<vector<uint8_t>::const_iterator>::FilenameLength );
+        if( bankname.size() > BlobScanner<const uint8_t*>::FilenameLength )
+            fixedbankname = bankname.substr( 0, BlobScanner<const uint8_t*>::FilenameLength );
 
         auto foundBank = blobscan.FindSWDL( fixedbankname );
 
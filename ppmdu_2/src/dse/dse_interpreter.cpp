@@ -1,6 +1,7 @@
 #include <dse/dse_interpreter.hpp>
 #include <utils/poco_wrapper.hpp>
 #include <dse/dse_conversion.hpp>
+#include <dse/dse_smf.hpp>
 
 #include <jdksmidi/world.h>
 #include <jdksmidi/track.h>
@@ -2198,7 +2199,13 @@ namespace DSE
                  << "Converting SMDL to MIDI " <<outmidi << "\n"
                  << "================================================================================\n";
         }
-        DSESequenceToMidi( outmidi, seq, remapdata, /*midfmt,*/ midmode, nbloop )();
+        if( nbloop < 0 )
+            throw std::runtime_error("SequenceToMidi(): The number of loops can't be negative!");
+        //Only GM needs the channel re-arranging of the jdksmidi converter
+        if( midmode == eMIDIMode::GM )
+            DSESequenceToMidi( outmidi, seq, remapdata, /*midfmt,*/ midmode, nbloop )();
+        else
+            SequenceToSMF( outmidi, seq, &remapdata, nbloop, midmode );
     }
 
     void SequenceToMidi( const std::string              & outmidi, 
@@ -2213,7 +2220,12 @@ namespace DSE
                  << "Converting SMDL to MIDI " <<outmidi << "\n"
                  << "================================================================================\n";
         }
-        DSESequenceToMidi( outmidi, seq, /*midfmt,*/ midmode, nbloop )();
+        if( nbloop < 0 )
+            throw std::runtime_error("SequenceToMidi(): The number of loops can't be negative!");
+        if( midmode == eMIDIMode::GM )
+            DSESequenceToMidi( outmidi, seq, /*midfmt,*/ midmode, nbloop )();
+        else
+            SequenceToSMF( outmidi, seq, nullptr, nbloop, midmode );
     }
 
 
@@ -2230,6 +2242,6 @@ namespace DSE
                  << "Converting MIDI " <<inmidi << "to SMDL\n"
                  << "================================================================================\n";
         }
-        return MIDIToDSE(inmidi)();
+        return SMFToSequence(inmidi);
     }
 };
\ No newline at end of file
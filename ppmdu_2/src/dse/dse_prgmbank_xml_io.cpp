@@ -7,6 +7,7 @@
 #include <iostream>
 #include <iomanip>
 #include <fstream>
+#include <algorithm>
 #include <Poco/DirectoryIterator.h>
 #include <Poco/File.h>
 #include <Poco/Path.h>
@@ -50,6 +51,7 @@ namespace DSE
         const string NODE_LFOTable     = "LFOTable";
 
         const string NODE_LFOEntry     = "LFOEntry";
+        const string PROP_LFOUnk34     = "Unk34";
         const string PROP_LFOEnabled   = "Enabled";
         const string PROP_LFOModDest   = "ModulationDestination";
         const string PROP_LFOWaveShape = "WaveformShape";
@@ -124,70 +126,339 @@ namespace DSE
 class ProgramBankXMLParser
 {
 public:
-    ProgramBankXMLParser( const string & dirpath )
-        :m_path(dirpath)
+    /*
+        The XML data is applied over the "basebnk" preset bank, so it must be the bank the XML was exported from.
+        The XML files don't contain the sample data, or the fields we don't know the meaning of, so those are kept from the base.
+    */
+    ProgramBankXMLParser( const string & dirpath, PresetBank && basebnk )
+        :m_path(dirpath), m_bank(std::move(basebnk))
     {}
 
     PresetBank Parse()
     {
-        vector< unique_ptr<ProgramInfo> > prgmbank;
-        vector<KeyGroup>                  kgrp;
-        vector<SampleBank::smpldata_t>    sampledata;
-
-        ParsePrograms(prgmbank);
-        ParseKeygroups(kgrp);
-        ParseSampleInfos(sampledata);
-
-        return move( PresetBank( move(DSE_MetaDataSWDL()), 
-                                 move(unique_ptr<ProgramBank>(new ProgramBank(move(prgmbank), 
-                                                                              move(kgrp)))),
-                                 move(unique_ptr<SampleBank>(new SampleBank(move(sampledata)))) 
-                                 ) );
+        if( m_bank.prgmbank().expired() )
+            m_bank.prgmbank( unique_ptr<ProgramBank>( new ProgramBank( vector<ProgramBank::ptrprg_t>(), vector<KeyGroup>() ) ) );
+
+        auto ptrprgms = m_bank.prgmbank().lock();
+        ParsePrograms ( ptrprgms->PrgmInfo() );
+        ParseKeygroups( ptrprgms->Keygrps() );
+
+        auto ptrsmpls = m_bank.smplbank().lock();
+        if( ptrsmpls != nullptr )
+            ParseSampleInfos( *ptrsmpls );
+        else if( Poco::File( MakeFilePath(DEF_WavInfoFname) ).exists() )
+            clog << "ProgramBankXMLParser::Parse(): The base preset bank has no samples, ignoring " <<DEF_WavInfoFname <<"!\n";
+
+        return std::move(m_bank);
     }
 
 private:
 
-    void ParsePrograms( vector< unique_ptr<ProgramInfo> > & prgmbank )
+    string MakeFilePath( const string & fname )const
     {
-        ParseAProgram();
+        return utils::TryAppendSlash(m_path) + fname;
     }
 
-    void ParseAProgram()
+    //Loads the xml document, and returns false if the file doesn't exist
+    bool LoadDocument( const string & fname, xml_document & doc )const
     {
-        ParseALFO();
-        ParseASplit();
+        const string fpath = MakeFilePath(fname);
+        if( !Poco::File(fpath).exists() )
+            return false;
+        HandleParsingError( doc.load_file( fpath.c_str() ), fpath );
+        return true;
     }
 
-    void ParseALFO()
+    void ParsePrograms( vector< ProgramBank::ptrprg_t > & prgmbank )
     {
+        using namespace PrgmXML;
+        xml_document doc;
+        if( !LoadDocument( DEF_ProgramsFname, doc ) )
+            return;
+
+        for( auto & prgnode : doc.child(ROOT_Programs.c_str()).children(NODE_Program.c_str()) )
+        {
+            xml_node idnode = prgnode.child(PROP_ID.c_str());
+            if( !idnode )
+            {
+                clog << "<!>- Ignored a " <<NODE_Program <<" node because there was no program ID specified!\n";
+                continue;
+            }
+            const uint16_t prgid = utils::parseHexaValToValue<uint16_t>( idnode.child_value() );
+
+            //Programs are placed in the slot matching their ID
+            if( prgid >= prgmbank.size() )
+                prgmbank.resize( prgid + 1 );
+            if( prgmbank[prgid] == nullptr )
+                prgmbank[prgid].reset( new ProgramInfo );
+            prgmbank[prgid]->id = prgid;
+            ParseAProgram( prgnode, *prgmbank[prgid] );
+        }
     }
 
-    void ParseASplit()
+    void ParseAProgram( xml_node & prgnode, ProgramInfo & prog )
     {
+        using namespace PrgmXML;
+        for( auto & curnode : prgnode.children() )
+        {
+            if( curnode.name() == PROP_Volume )
+                utils::parseHexaValToValue( curnode.child_value(), prog.prgvol );
+            else if( curnode.name() == PROP_Pan )
+                utils::parseHexaValToValue( curnode.child_value(), prog.prgpan );
+            else if( curnode.name() == PROP_PrgmUnkPoly )
+                utils::parseHexaValToValue( curnode.child_value(), prog.unkpoly );
+            else if( curnode.name() == NODE_LFOTable )
+                ParseTable( curnode, NODE_LFOEntry, prog.m_lfotbl, &ProgramBankXMLParser::ParseALFO );
+            else if( curnode.name() == NODE_SplitTable )
+                ParseTable( curnode, NODE_Split, prog.m_splitstbl, &ProgramBankXMLParser::ParseASplit );
+        }
     }
 
+    /*
+        The entries of a table are matched with the existing ones by index. A table with no entries in the XML is left as-is.
+    */
+    template<class _EntryTy>
+        void ParseTable( xml_node & tblnode, const string & entryname, vector<_EntryTy> & table, void (ProgramBankXMLParser::*parseentry)( xml_node &, _EntryTy &, bool ) )
+    {
+        const size_t nbentries = static_cast<size_t>( std::distance( tblnode.children(entryname.c_str()).begin(), tblnode.children(entryname.c_str()).end() ) );
+        if( nbentries == 0 )
+            return;
+
+        const size_t nbexisting = table.size();
+        table.resize(nbentries);
+        size_t cnt = 0;
+        for( auto & entrynode : tblnode.children(entryname.c_str()) )
+        {
+            (this->*parseentry)( entrynode, table[cnt], cnt >= nbexisting );
+            ++cnt;
+        }
+    }
 
-    void ParseSampleInfos( vector<SampleBank::smpldata_t> & sampledata )
+    void ParseALFO( xml_node & lfonode, LFOTblEntry & lfo, bool /*isnew*/ )
     {
-        ParseASample();
+        using namespace PrgmXML;
+        for( auto & curnode : lfonode.children() )
+        {
+            if( curnode.name() == PROP_LFOUnk34 )
+                utils::parseHexaValToValue( curnode.child_value(), lfo.unk34 );
+            else if( curnode.name() == PROP_LFOEnabled )
+                utils::parseHexaValToValue( curnode.child_value(), lfo.unk52 );
+            else if( curnode.name() == PROP_LFOModDest )
+                utils::parseHexaValToValue( curnode.child_value(), lfo.dest );
+            else if( curnode.name() == PROP_LFOWaveShape )
+                utils::parseHexaValToValue( curnode.child_value(), lfo.wshape );
+            else if( curnode.name() == PROP_LFORate )
+                utils::parseHexaValToValue( curnode.child_value(), lfo.rate );
+            else if( curnode.name() == PROP_LFOUnk29 )
+                utils::parseHexaValToValue( curnode.child_value(), lfo.unk29 );
+            else if( curnode.name() == PROP_LFODepth )
+                utils::parseHexaValToValue( curnode.child_value(), lfo.depth );
+            else if( curnode.name() == PROP_LFODelay )
+                utils::parseHexaValToValue( curnode.child_value(), lfo.delay );
+            else if( curnode.name() == PROP_LFOUnk32 )
+                utils::parseHexaValToValue( curnode.child_value(), lfo.unk32 );
+            else if( curnode.name() == PROP_LFOUnk33 )
+                utils::parseHexaValToValue( curnode.child_value(), lfo.unk33 );
+        }
     }
 
-    void ParseASample()
+    void ParseASplit( xml_node & splitnode, SplitEntry & split, bool isnew )
     {
+        using namespace PrgmXML;
+        for( auto & curnode : splitnode.children() )
+        {
+            if( curnode.name() == PROP_ID )
+                utils::parseHexaValToValue( curnode.child_value(), split.id );
+            else if( curnode.name() == PROP_SplitUnk11 )
+                utils::parseHexaValToValue( curnode.child_value(), split.unk11 );
+            else if( curnode.name() == PROP_SplitUnk25 )
+                utils::parseHexaValToValue( curnode.child_value(), split.unk25 );
+            else if( curnode.name() == PROP_SplitLowKey )
+                utils::parseHexaValToValue( curnode.child_value(), split.lowkey );
+            else if( curnode.name() == PROP_SplitHighKey )
+                utils::parseHexaValToValue( curnode.child_value(), split.hikey );
+            else if( curnode.name() == PROP_SplitLowVel )
+                utils::parseHexaValToValue( curnode.child_value(), split.lovel );
+            else if( curnode.name() == PROP_SplitHighVel )
+                utils::parseHexaValToValue( curnode.child_value(), split.hivel );
+            else if( curnode.name() == PROP_SplitSmplID )
+                utils::parseHexaValToValue( curnode.child_value(), split.smplid );
+            else if( curnode.name() == PROP_FTune )
+                utils::parseHexaValToValue( curnode.child_value(), split.ftune );
+            else if( curnode.name() == PROP_CTune )
+                utils::parseHexaValToValue( curnode.child_value(), split.ctune );
+            else if( curnode.name() == PROP_RootKey )
+                utils::parseHexaValToValue( curnode.child_value(), split.rootkey );
+            else if( curnode.name() == PROP_KeyTrans )
+                utils::parseHexaValToValue( curnode.child_value(), split.ktps );
+            else if( curnode.name() == PROP_Volume )
+                utils::parseHexaValToValue( curnode.child_value(), split.smplvol );
+            else if( curnode.name() == PROP_Pan )
+                utils::parseHexaValToValue( curnode.child_value(), split.smplpan );
+            else if( curnode.name() == PROP_SplitKGrp )
+                utils::parseHexaValToValue( curnode.child_value(), split.kgrpid );
+            else if( curnode.name() == PROP_EnvOn )
+                utils::parseHexaValToValue( curnode.child_value(), split.envon );
+            else if( curnode.name() == PROP_EnvMulti )
+                utils::parseHexaValToValue( curnode.child_value(), split.env.envmulti );
+            else if( curnode.name() == PROP_EnvAtkVol )
+                utils::parseHexaValToValue( curnode.child_value(), split.env.atkvol );
+            else if( curnode.name() == PROP_EnvAtk )
+                utils::parseHexaValToValue( curnode.child_value(), split.env.attack );
+            else if( curnode.name() == PROP_EnvDecay )
+                utils::parseHexaValToValue( curnode.child_value(), split.env.decay );
+            else if( curnode.name() == PROP_EnvSustain )
+                utils::parseHexaValToValue( curnode.child_value(), split.env.sustain );
+            else if( curnode.name() == PROP_EnvHold )
+                utils::parseHexaValToValue( curnode.child_value(), split.env.hold );
+            else if( curnode.name() == PROP_EnvDecay2 )
+                utils::parseHexaValToValue( curnode.child_value(), split.env.decay2 );
+            else if( curnode.name() == PROP_EnvRelease )
+                utils::parseHexaValToValue( curnode.child_value(), split.env.release );
+        }
+
+        //The second key and velocity ranges aren't exported, and usually match the first ones
+        if( isnew )
+        {
+            split.lowkey2 = split.lowkey;
+            split.hikey2  = split.hikey;
+            split.lovel2  = split.lovel;
+            split.hivel2  = split.hivel;
+        }
     }
 
-    void ParseKeygroups( vector<KeyGroup> & kgrp )
+    void ParseSampleInfos( SampleBank & smplbank )
     {
-        ParseAKeygroup();
+        using namespace PrgmXML;
+        xml_document doc;
+        if( !LoadDocument( DEF_WavInfoFname, doc ) )
+            return;
+
+        for( auto & smplnode : doc.child(ROOT_WavInfo.c_str()).children(NODE_Sample.c_str()) )
+        {
+            xml_node idnode = smplnode.child(PROP_ID.c_str());
+            if( !idnode )
+            {
+                clog << "<!>- Ignored a " <<NODE_Sample <<" node because there was no sample ID specified!\n";
+                continue;
+            }
+            const uint16_t smplid = utils::parseHexaValToValue<uint16_t>( idnode.child_value() );
+
+            //Samples can't be added from the XML, since it doesn't contain their data
+            WavInfo * ptrwinf = nullptr;
+            for( size_t cntslot = 0; cntslot < smplbank.NbSlots() && ptrwinf == nullptr; ++cntslot )
+            {
+                WavInfo * ptrcur = smplbank.sampleInfo(cntslot);
+                if( ptrcur != nullptr && ptrcur->id == smplid )
+                    ptrwinf = ptrcur;
+            }
+
+            if( ptrwinf != nullptr )
+                ParseASample( smplnode, *ptrwinf );
+            else
+                clog << "<!>- Ignored " <<NODE_Sample <<" #" <<smplid <<", because there is no sample with that ID in the base preset bank!\n";
+        }
     }
 
-    void ParseAKeygroup()
+    void ParseASample( xml_node & smplnode, WavInfo & winfo )
     {
+        using namespace PrgmXML;
+        for( auto & curnode : smplnode.children() )
+        {
+            if( curnode.name() == PROP_FTune )
+                utils::parseHexaValToValue( curnode.child_value(), winfo.ftune );
+            else if( curnode.name() == PROP_CTune )
+                utils::parseHexaValToValue( curnode.child_value(), winfo.ctune );
+            else if( curnode.name() == PROP_RootKey )
+                utils::parseHexaValToValue( curnode.child_value(), winfo.rootkey );
+            else if( curnode.name() == PROP_KeyTrans )
+                utils::parseHexaValToValue( curnode.child_value(), winfo.ktps );
+            else if( curnode.name() == PROP_Volume )
+                utils::parseHexaValToValue( curnode.child_value(), winfo.vol );
+            else if( curnode.name() == PROP_Pan )
+                utils::parseHexaValToValue( curnode.child_value(), winfo.pan );
+            else if( curnode.name() == PROP_SmplLoop )
+                winfo.smplloop = utils::parseHexaValToValue<uint16_t>( curnode.child_value() ) != 0;
+            else if( curnode.name() == PROP_LoopBeg )
+                winfo.loopbeg = PCM16PosToLoopPos( winfo.smplfmt, utils::parseHexaValToValue<uint32_t>( curnode.child_value() ) );
+            else if( curnode.name() == PROP_LoopLen )
+                winfo.looplen = PCM16PosToLoopPos( winfo.smplfmt, utils::parseHexaValToValue<uint32_t>( curnode.child_value() ) );
+            else if( curnode.name() == PROP_EnvOn )
+                utils::parseHexaValToValue( curnode.child_value(), winfo.envon );
+            else if( curnode.name() == PROP_EnvMulti )
+                utils::parseHexaValToValue( curnode.child_value(), winfo.envmult );
+            else if( curnode.name() == PROP_EnvAtkVol )
+                utils::parseHexaValToValue( curnode.child_value(), winfo.atkvol );
+            else if( curnode.name() == PROP_EnvAtk )
+                utils::parseHexaValToValue( curnode.child_value(), winfo.attack );
+            else if( curnode.name() == PROP_EnvDecay )
+                utils::parseHexaValToValue( curnode.child_value(), winfo.decay );
+            else if( curnode.name() == PROP_EnvSustain )
+                utils::parseHexaValToValue( curnode.child_value(), winfo.sustain );
+            else if( curnode.name() == PROP_EnvHold )
+                utils::parseHexaValToValue( curnode.child_value(), winfo.hold );
+            else if( curnode.name() == PROP_EnvDecay2 )
+                utils::parseHexaValToValue( curnode.child_value(), winfo.decay2 );
+            else if( curnode.name() == PROP_EnvRelease )
+                utils::parseHexaValToValue( curnode.child_value(), winfo.release );
+        }
     }
 
-private:
-    string m_path;
+    //Undoes the correction the writer applies to the loop points, since the samples were exported to PCM16
+    static uint32_t PCM16PosToLoopPos( eDSESmplFmt fmt, uint32_t pos )
+    {
+        if( fmt == eDSESmplFmt::pcm8 )
+            return pos / 2;
+        else if( fmt == eDSESmplFmt::ima_adpcm )
+            return (pos >= ::audio::IMA_ADPCM_PreambleLen)? (pos - ::audio::IMA_ADPCM_PreambleLen) / 4 : 0;
+        else
+            return pos;
+    }
+
+    void ParseKeygroups( KeyGroupList & kgrps )
+    {
+        using namespace PrgmXML;
+        xml_document doc;
+        if( !LoadDocument( DEF_KeygroupFname, doc ) )
+            return;
+
+        for( auto & kgrpnode : doc.child(ROOT_KeyGroups.c_str()).children(NODE_KGrp.c_str()) )
+        {
+            xml_node idnode = kgrpnode.child(PROP_ID.c_str());
+            if( !idnode )
+            {
+                clog << "<!>- Ignored a " <<NODE_KGrp <<" node because there was no keygroup ID specified!\n";
+                continue;
+            }
+            const uint16_t kgrpid = utils::parseHexaValToValue<uint16_t>( idnode.child_value() );
+
+            auto itfound = std::find_if( kgrps.begin(), kgrps.end(), [&]( const KeyGroup & grp ){ return grp.id == kgrpid; } );
+            if( itfound != kgrps.end() )
+                ParseAKeygroup( kgrpnode, *itfound );
+            else
+                clog << "<!>- Ignored " <<NODE_KGrp <<" #" <<kgrpid <<", because there is no keygroup with that ID in the base preset bank!\n";
+        }
+    }
+
+    void ParseAKeygroup( xml_node & kgrpnode, KeyGroup & grp )
+    {
+        using namespace PrgmXML;
+        for( auto & curnode : kgrpnode.children() )
+        {
+            if( curnode.name() == NODE_KGrpPoly )
+                utils::parseHexaValToValue( curnode.child_value(), grp.poly );
+            else if( curnode.name() == NODE_KGrpPrio )
+                utils::parseHexaValToValue( curnode.child_value(), grp.priority );
+            else if( curnode.name() == NODE_KGrVcLow )
+                utils::parseHexaValToValue( curnode.child_value(), grp.vclow );
+            else if( curnode.name() == NODE_KGrVcHi )
+                utils::parseHexaValToValue( curnode.child_value(), grp.vchigh );
+        }
+    }
 
+private:
+    string     m_path;
+    PresetBank m_bank;
 };
 
 //====================================================================================================
@@ -265,34 +536,34 @@ private:
         
     }
 
-    void WriteALFO( xml_node & parent, const LFOTblEntry & curlfo )
+    void WriteALFO( xml_node & lfotblnode, const LFOTblEntry & curlfo )
     {
         using namespace PrgmXML;
+        //Every LFO slot is written, so they can be matched by index when parsed back
+        xml_node     parent = lfotblnode.append_child( NODE_LFOEntry.c_str() );
+        stringstream sstrunkcv;
 
-        if( curlfo.isLFONonDefault() )
-        {
-            stringstream sstrunkcv;
-
-            WriteNodeWithValue( parent, PROP_LFOEnabled,    curlfo.unk52  );
-            WriteNodeWithValue( parent, PROP_LFOModDest,    curlfo.dest   );
-            WriteNodeWithValue( parent, PROP_LFOWaveShape,  curlfo.wshape );
-            WriteNodeWithValue( parent, PROP_LFORate,       curlfo.rate   );
+        WriteNodeWithValue( parent, PROP_LFOUnk34,      curlfo.unk34  );
+        WriteNodeWithValue( parent, PROP_LFOEnabled,    curlfo.unk52  );
+        WriteNodeWithValue( parent, PROP_LFOModDest,    curlfo.dest   );
+        WriteNodeWithValue( parent, PROP_LFOWaveShape,  curlfo.wshape );
+        WriteNodeWithValue( parent, PROP_LFORate,       curlfo.rate   );
 
-            //unk29 is different
-            sstrunkcv <<hex <<showbase <<curlfo.unk29;
-            parent.append_child(PROP_LFOUnk29.c_str()).append_child(node_pcdata).set_value( sstrunkcv.str().c_str() );
+        //unk29 is different
+        sstrunkcv <<hex <<showbase <<curlfo.unk29;
+        parent.append_child(PROP_LFOUnk29.c_str()).append_child(node_pcdata).set_value( sstrunkcv.str().c_str() );
 
-            WriteNodeWithValue( parent, PROP_LFODepth,      curlfo.depth  );
-            WriteNodeWithValue( parent, PROP_LFODelay,      curlfo.delay  );
-            WriteNodeWithValue( parent, PROP_LFOUnk32,      curlfo.unk32  );
-            WriteNodeWithValue( parent, PROP_LFOUnk33,      curlfo.unk33  );
-        }
+        WriteNodeWithValue( parent, PROP_LFODepth,      curlfo.depth  );
+        WriteNodeWithValue( parent, PROP_LFODelay,      curlfo.delay  );
+        WriteNodeWithValue( parent, PROP_LFOUnk32,      curlfo.unk32  );
+        WriteNodeWithValue( parent, PROP_LFOUnk33,      curlfo.unk33  );
     }
 
-    void WriteASplit( xml_node & parent, const SplitEntry & cursplit )
+    void WriteASplit( xml_node & splittblnode, const SplitEntry & cursplit )
     {
         using namespace PrgmXML;
-        WriteCommentNode( parent, "Split Sample " + to_string(cursplit.smplid) );
+        WriteCommentNode( splittblnode, "Split Sample " + to_string(cursplit.smplid) );
+        xml_node parent = splittblnode.append_child( NODE_Split.c_str() );
 
         WriteNodeWithValue( parent, PROP_ID,                cursplit.id );
         WriteNodeWithValue( parent, PROP_SplitUnk11,        cursplit.unk11 );
@@ -508,6 +779,11 @@ private:
     */
     DSE::PresetBank XMLToPresetBank( const std::string & srcdir )
     {
-        return ProgramBankXMLParser(srcdir).Parse();
+        return ProgramBankXMLParser( srcdir, DSE::PresetBank() ).Parse();
+    }
+
+    DSE::PresetBank XMLToPresetBank( const std::string & srcdir, DSE::PresetBank && basebnk )
+    {
+        return ProgramBankXMLParser( srcdir, std::move(basebnk) ).Parse();
     }
 };
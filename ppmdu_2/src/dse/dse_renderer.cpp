@@ -0,0 +1,941 @@
+#include <dse/dse_renderer.hpp>
+#include <dse/dse_sequence.hpp>
+#include <dse/dse_conversion.hpp>
+#include <ext_fmts/wav_io.hpp>
+#include <utils/parallel_tasks.hpp>
+#include <utils/library_wide.hpp>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <map>
+#include <cmath>
+using namespace std;
+
+namespace DSE
+{
+//====================================================================================================
+//  Constants
+//====================================================================================================
+    const double   DSE_RenderDefTempo      = 120.0;  //BPM used until a track sets the tempo
+    const uint16_t DSE_RenderDefTPQN       = 48;     //Used when a sequence has no tpqn set
+    const size_t   DSE_RenderMaxVoices     = 32;     //Max nb of voices playing at once. Oldest voices are stolen past that.
+    const int8_t   DSE_EnvInfiniteDur      = 0x7F;   //Decay and decay2 with this value never end
+    const uint32_t DSE_RenderNoEnvRelease  = 10;     //Release time in ms used for splits with their envelope disabled
+    const uint32_t DSE_RenderMaxEvPerTick  = 65536;  //Nb of events a track may process in a single tick before it is considered stuck
+    const uint8_t  DSE_RenderDefBendRange  = 2;      //Pitch bend range in semitones, until changed by an event
+    const float    DSE_RenderPCM16Scale    = 1.0f / 32768.0f;
+    const float    DSE_RenderPi            = 3.14159265358979f;
+
+//====================================================================================================
+//  Mixer Kernels
+//====================================================================================================
+    /*
+        Those are kept as plain loops over contiguous float arrays, with no branching or aliasing
+        ambiguity inside the loop body, so the compiler can turn them into SIMD code on every target.
+    */
+
+    /*
+        MixRampStereo
+            Adds a mono source to the stereo bus, while linearly ramping the gain of each channels
+            over the block to avoid zipper noise.
+    */
+    inline void MixRampStereo( const float * src, float * outl, float * outr, size_t len,
+                               float gl0, float gl1, float gr0, float gr1 )
+    {
+        const float invlen = 1.0f / static_cast<float>(len);
+        const float stepl  = (gl1 - gl0) * invlen;
+        const float stepr  = (gr1 - gr0) * invlen;
+        for( size_t i = 0; i < len; ++i )
+        {
+            const float t = static_cast<float>(i);
+            outl[i] += src[i] * (gl0 + stepl * t);
+            outr[i] += src[i] * (gr0 + stepr * t);
+        }
+    }
+
+    /*
+        ApplyGainRamp
+            Multiplies the samples by a gain going linearly from g0 to g1.
+    */
+    inline void ApplyGainRamp( float * buf, size_t len, float g0, float g1 )
+    {
+        const float step = (g1 - g0) / static_cast<float>(len);
+        for( size_t i = 0; i < len; ++i )
+            buf[i] *= g0 + step * static_cast<float>(i);
+    }
+
+    /*
+        InterpolateLinear
+            Resamples len samples starting at the fractional position pos, moving by step every output sample.
+            The caller must make sure the last position read, plus one, is within the source.
+    */
+    inline void InterpolateLinear( const float * src, double pos, double step, float * dst, size_t len )
+    {
+        for( size_t i = 0; i < len; ++i )
+        {
+            const double p    = pos + step * static_cast<double>(i);
+            const size_t idx  = static_cast<size_t>(p);
+            const float  frac = static_cast<float>(p - static_cast<double>(idx));
+            dst[i] = src[idx] + (src[idx + 1] - src[idx]) * frac;
+        }
+    }
+
+//====================================================================================================
+//  RenderSampleCache
+//====================================================================================================
+    /*
+        DecodedSample
+            A sample converted to normalized floats, with its loop points in sample points.
+            The data has guard points past the loop end, so the interpolator never needs to wrap mid-kernel.
+    */
+    struct DecodedSample
+    {
+        std::vector<float> data;
+        size_t             loopbeg  = 0;
+        size_t             loopend  = 0;
+        bool               looped   = false;
+        uint32_t           smplrate = 0;
+    };
+
+    /*
+        RenderSampleCache
+            Decodes samples from a SampleBank on first use. Safe to share between several render threads,
+            each slot is decoded exactly once.
+    */
+    class RenderSampleCache
+    {
+    public:
+        RenderSampleCache( const SampleBank & bank )
+            :m_bank(bank), m_smpls(bank.NbSlots()), m_decoded(bank.NbSlots())
+        {}
+
+        const DecodedSample * Get( unsigned int smplid )
+        {
+            if( smplid >= m_smpls.size() )
+                return nullptr;
+            std::call_once( m_decoded[smplid], [this, smplid](){ Decode(smplid); } );
+            return m_smpls[smplid].data.empty() ? nullptr : &m_smpls[smplid];
+        }
+
+    private:
+        void Decode( unsigned int smplid )
+        {
+            const WavInfo              * pinf = m_bank.sampleInfo(smplid);
+            const std::vector<uint8_t> * praw = m_bank.sample(smplid);
+            if( pinf == nullptr || praw == nullptr || pinf->smplrate == 0 )
+                return;
+
+            DSESampleConvertionInfo cvinf;
+            std::vector<int16_t>    pcm;
+            eDSESmplFmt             fmt = ConvertDSESample( static_cast<int16_t>(pinf->smplfmt), pinf->loopbeg, *praw, cvinf, pcm );
+            if( fmt == eDSESmplFmt::invalid || fmt == eDSESmplFmt::psg || pcm.empty() )
+                return;
+
+            DecodedSample & smpl = m_smpls[smplid];
+            smpl.smplrate = pinf->smplrate;
+            smpl.loopend  = pcm.size();
+            smpl.loopbeg  = std::min( cvinf.loopbeg_, pcm.size() - 1 );
+            smpl.looped   = pinf->smplloop;
+            smpl.data.resize( pcm.size() + 2 );
+
+            for( size_t i = 0; i < pcm.size(); ++i )
+                smpl.data[i] = static_cast<float>(pcm[i]) * DSE_RenderPCM16Scale;
+
+            //Guard points continue into the loop, or fade to silence for one-shot samples
+            smpl.data[pcm.size()]     = smpl.looped ? smpl.data[smpl.loopbeg]                              : 0.0f;
+            smpl.data[pcm.size() + 1] = smpl.looped ? smpl.data[std::min(smpl.loopbeg + 1, pcm.size() - 1)] : 0.0f;
+        }
+
+    private:
+        const SampleBank             & m_bank;
+        std::vector<DecodedSample>     m_smpls;
+        std::vector<std::once_flag>    m_decoded;
+    };
+
+//====================================================================================================
+//  RenderEnvelope
+//====================================================================================================
+    /*
+        RenderEnvelope
+            Runs a split's DSE envelope as a series of linear segments, in output samples.
+    */
+    class RenderEnvelope
+    {
+        enum struct eStage
+        {
+            Attack,
+            Hold,
+            Decay,
+            Sustain,
+            Release,
+            Done,
+        };
+
+    public:
+        void Init( const SplitEntry & split, uint32_t outrate )
+        {
+            m_outrate  = outrate;
+            m_env      = split.env;
+            m_envon    = split.envon != 0;
+            m_level    = m_envon ? NormVol(m_env.atkvol) : 1.0f;
+
+            if( m_envon )
+                EnterStage( eStage::Attack );
+            else
+                EnterStage( eStage::Sustain );
+        }
+
+        void Release()
+        {
+            if( m_stage != eStage::Release && m_stage != eStage::Done )
+                EnterStage( eStage::Release );
+        }
+
+        /*
+            Advances the envelope by the nb of samples specified, and return the level reached.
+        */
+        float Advance( uint32_t nbsmpls )
+        {
+            while( nbsmpls > 0 && m_stage != eStage::Done )
+            {
+                if( m_infinite )
+                    break;
+
+                const uint32_t step = std::min( nbsmpls, m_remaining );
+                m_level     += m_delta * static_cast<float>(step);
+                m_remaining -= step;
+                nbsmpls     -= step;
+
+                if( m_remaining == 0 )
+                {
+                    m_level = m_target;
+                    NextStage();
+                }
+            }
+            return m_level;
+        }
+
+        inline float Level ()const { return m_level; }
+        inline bool  IsDone()const { return m_stage == eStage::Done; }
+
+    private:
+        static inline float NormVol( int8_t vol )
+        {
+            return static_cast<float>( utils::Clamp<int>(vol, 0, 127) ) / 127.0f;
+        }
+
+        inline uint32_t DurToSmpls( DSEEnvelope::timeprop_t dur )const
+        {
+            const int32_t msec = DSEEnveloppeDurationToMSec( static_cast<int8_t>(dur), m_env.envmulti );
+            return static_cast<uint32_t>( (static_cast<uint64_t>(std::max(msec, 0)) * m_outrate) / 1000 );
+        }
+
+        void NextStage()
+        {
+            switch(m_stage)
+            {
+                case eStage::Attack:  { EnterStage(eStage::Hold);    break; }
+                case eStage::Hold:    { EnterStage(eStage::Decay);   break; }
+                case eStage::Decay:   { EnterStage(eStage::Sustain); break; }
+                default:              { EnterStage(eStage::Done);    break; }
+            };
+        }
+
+        void EnterStage( eStage stage )
+        {
+            uint32_t len = 0;
+            m_stage    = stage;
+            m_infinite = false;
+
+            switch(stage)
+            {
+                case eStage::Attack:
+                {
+                    m_target = 1.0f;
+                    len      = DurToSmpls(m_env.attack);
+                    break;
+                }
+                case eStage::Hold:
+                {
+                    m_target = 1.0f;
+                    len      = DurToSmpls(m_env.hold);
+                    break;
+                }
+                case eStage::Decay:
+                {
+                    m_target   = NormVol(m_env.sustain);
+                    m_infinite = (m_env.decay == DSE_EnvInfiniteDur);
+                    len        = DurToSmpls(m_env.decay);
+                    break;
+                }
+                case eStage::Sustain:
+                {
+                    m_target   = 0.0f;
+                    m_infinite = !m_envon || (m_env.decay2 == DSE_EnvInfiniteDur);
+                    len        = m_envon ? DurToSmpls(m_env.decay2) : 0;
+                    break;
+                }
+                case eStage::Release:
+                {
+                    m_target = 0.0f;
+                    len      = m_envon ? DurToSmpls(m_env.release) : (DSE_RenderNoEnvRelease * m_outrate) / 1000;
+                    break;
+                }
+                case eStage::Done:
+                {
+                    m_target = 0.0f;
+                    m_level  = 0.0f;
+                    break;
+                }
+            };
+
+            m_remaining = std::max<uint32_t>( len, 1 );
+            m_delta     = (m_target - m_level) / static_cast<float>(m_remaining);
+        }
+
+    private:
+        DSEEnvelope m_env;
+        bool        m_envon     = false;
+        uint32_t    m_outrate   = DSE_RenderDefSmplRate;
+        eStage      m_stage     = eStage::Done;
+        bool        m_infinite  = false;
+        float       m_level     = 0.0f;
+        float       m_target    = 0.0f;
+        float       m_delta     = 0.0f;
+        uint32_t    m_remaining = 0;
+    };
+
+//====================================================================================================
+//  SequenceRenderer
+//====================================================================================================
+    /*
+        SequenceRenderer
+            Walks all the tracks of a sequence tick by tick, triggers voices for note events, and mixes
+            the voices into the output bus in blocks.
+    */
+    class SequenceRenderer
+    {
+        struct RenderLFO
+        {
+            uint8_t  dest      = 0;
+            float    phase     = 0.0f;  //In cycles
+            float    phaseinc  = 0.0f;  //Cycles per output sample
+            float    depth     = 0.0f;  //Cents for pitch, centibels for volume, pan units for panning
+            uint32_t delay     = 0;     //Samples before the LFO kicks in
+        };
+
+        struct Voice
+        {
+            const DecodedSample  * psmpl     = nullptr;
+            size_t                 trkidx    = 0;
+            double                 pos       = 0.0;
+            double                 basestep  = 0.0;    //Source samples per output sample, before bend and LFO
+            float                  gain      = 0.0f;   //Velocity and program/split volume
+            int                    panoffset = 0;      //Split and program panning, relative to center
+            uint64_t               offtick   = 0;
+            bool                   released  = false;
+            bool                   finished  = false;
+            bool                   hasgains  = false;
+            float                  lastgl    = 0.0f;
+            float                  lastgr    = 0.0f;
+            RenderEnvelope         env;
+            std::vector<RenderLFO> lfos;
+        };
+
+        struct TrkState
+        {
+            const MusicTrack   * ptrk       = nullptr;
+            size_t               evpos      = 0;
+            uint64_t             nexttick   = 0;
+            uint32_t             lastpause  = 0;
+            uint32_t             lasthold   = 0;
+            uint64_t             lastnoteoff= 0;
+            int8_t               octave     = 0;
+            const ProgramInfo  * pprgm      = nullptr;
+            int                  vol        = 127;
+            int                  expr       = 127;
+            int                  pan        = 64;
+            int16_t              bend       = 0;
+            uint8_t              bendrng    = DSE_RenderDefBendRange;
+            bool                 hasloop    = false;
+            size_t               looppos    = 0;
+            int                  loopsdone  = 0;
+            bool                 ended      = false;
+        };
+
+    public:
+        SequenceRenderer( const MusicSequence & seq, const ProgramBank & prgms, RenderSampleCache & cache, const RenderParams & params )
+            :m_seq(seq), m_prgms(prgms), m_cache(cache), m_params(params)
+        {
+            if( m_params.samplerate == 0 )
+                throw std::runtime_error("SequenceRenderer::SequenceRenderer(): Output sample rate can't be 0!");
+            m_tpqn = (seq.metadata().tpqn != 0)? seq.metadata().tpqn : DSE_RenderDefTPQN;
+        }
+
+        RenderedAudio operator()()
+        {
+            Init();
+            const uint64_t maxsmpls  = static_cast<uint64_t>(m_params.maxlensec * m_params.samplerate);
+            const uint64_t fadesmpls = static_cast<uint64_t>(m_params.fadeoutsec * m_params.samplerate);
+            uint64_t       fadepos   = 0;
+            bool           fading    = false;
+            double         smplfrac  = 0.0;
+
+            for( uint64_t curtick = 0; m_out.left.size() < maxsmpls; ++curtick )
+            {
+                ProcessTracks(curtick);
+                ReleaseDueNotes(curtick);
+
+                if( !fading && ShouldStartFade() )
+                {
+                    //Without a fade out, the render ends right where the last loop does
+                    if( fadesmpls == 0 )
+                        break;
+                    fading = true;
+                }
+
+                if( fading && fadepos >= fadesmpls )
+                    break;
+                if( !fading && AllTracksEnded() && m_voices.empty() )
+                    break;
+
+                //Render the samples for this tick
+                smplfrac += SamplesPerTick();
+                const size_t nbsmpls = static_cast<size_t>(smplfrac);
+                smplfrac -= nbsmpls;
+
+                const size_t begpos = m_out.left.size();
+                m_out.left .resize( begpos + nbsmpls, 0.0f );
+                m_out.right.resize( begpos + nbsmpls, 0.0f );
+
+                for( size_t done = 0; done < nbsmpls; )
+                {
+                    const size_t blklen = std::min<size_t>( DSE_RenderBlockLen, nbsmpls - done );
+                    float      * pl     = m_out.left .data() + begpos + done;
+                    float      * pr     = m_out.right.data() + begpos + done;
+                    MixBlock( pl, pr, blklen );
+
+                    if( fading )
+                    {
+                        const size_t fadelen = static_cast<size_t>( std::min<uint64_t>( blklen, fadesmpls - std::min(fadepos, fadesmpls) ) );
+                        const float  g0      = 1.0f - static_cast<float>(fadepos) / fadesmpls;
+                        const float  g1      = 1.0f - static_cast<float>(fadepos + fadelen) / fadesmpls;
+                        if( fadelen != 0 )
+                        {
+                            ApplyGainRamp( pl, fadelen, g0, g1 );
+                            ApplyGainRamp( pr, fadelen, g0, g1 );
+                        }
+                        std::fill( pl + fadelen, pl + blklen, 0.0f );
+                        std::fill( pr + fadelen, pr + blklen, 0.0f );
+                        fadepos += blklen;
+                    }
+                    done += blklen;
+                }
+            }
+
+            m_out.samplerate = m_params.samplerate;
+            return std::move(m_out);
+        }
+
+    private:
+        void Init()
+        {
+            m_tempo = DSE_RenderDefTempo;
+            m_trks.resize( m_seq.getNbTracks() );
+            for( size_t i = 0; i < m_trks.size(); ++i )
+            {
+                m_trks[i].ptrk = &m_seq.track(i);
+                for( size_t cntev = 0; cntev < m_trks[i].ptrk->size(); ++cntev )
+                {
+                    if( (*m_trks[i].ptrk)[cntev].evcode == static_cast<uint8_t>(eTrkEventCodes::LoopPointSet) )
+                    {
+                        m_trks[i].hasloop = true;
+                        break;
+                    }
+                }
+            }
+            m_scratch.resize( DSE_RenderBlockLen );
+            m_out.left .reserve( static_cast<size_t>(m_params.samplerate) * 180 );
+            m_out.right.reserve( static_cast<size_t>(m_params.samplerate) * 180 );
+        }
+
+        inline double SamplesPerTick()const
+        {
+            return (static_cast<double>(m_params.samplerate) * 60.0) / (m_tempo * m_tpqn);
+        }
+
+        inline bool AllTracksEnded()const
+        {
+            for( const auto & trk : m_trks )
+                if( !trk.ended ) return false;
+            return true;
+        }
+
+        /*
+            The fade begins once every loopable track has played its loop the amount of times requested.
+        */
+        inline bool ShouldStartFade()const
+        {
+            if( m_params.nbloops <= 0 )
+                return false;
+            bool anyloop = false;
+            for( const auto & trk : m_trks )
+            {
+                if( !trk.hasloop )
+                    continue;
+                anyloop = true;
+                if( trk.loopsdone < m_params.nbloops )
+                    return false;
+            }
+            return anyloop;
+        }
+
+    //----------------------------------------------------------------
+    //  Event Handling
+    //----------------------------------------------------------------
+        void ProcessTracks( uint64_t curtick )
+        {
+            for( size_t trkidx = 0; trkidx < m_trks.size(); ++trkidx )
+            {
+                TrkState & trk    = m_trks[trkidx];
+                uint32_t   cntevs = 0;
+                while( !trk.ended && trk.nexttick <= curtick )
+                {
+                    if( trk.evpos >= trk.ptrk->size() )
+                    {
+                        HandleEndOfTrack(trk);
+                        continue;
+                    }
+                    HandleEvent( trkidx, trk, (*trk.ptrk)[trk.evpos++], curtick );
+
+                    if( ++cntevs > DSE_RenderMaxEvPerTick )
+                    {
+                        if( utils::LibWide().isLogOn() )
+                            clog << "<!>- SequenceRenderer::ProcessTracks(): Track #" <<trkidx <<" doesn't advance in time! Stopping it.\n";
+                        trk.ended = true;
+                    }
+                }
+            }
+        }
+
+        void HandleEndOfTrack( TrkState & trk )
+        {
+            if( m_params.nbloops > 0 && trk.hasloop )
+            {
+                trk.evpos = trk.looppos;
+                ++trk.loopsdone;
+            }
+            else
+                trk.ended = true;
+        }
+
+        void HandleEvent( size_t trkidx, TrkState & trk, const TrkEvent & ev, uint64_t curtick )
+        {
+            const eTrkEventCodes code = static_cast<eTrkEventCodes>(ev.evcode);
+
+            if( code >= eTrkEventCodes::NoteOnBeg && code <= eTrkEventCodes::NoteOnEnd )
+            {
+                HandlePlayNote( trkidx, trk, ev, curtick );
+                return;
+            }
+            else if( code >= eTrkEventCodes::Delay_HN && code <= eTrkEventCodes::Delay_64N )
+            {
+                trk.lastpause = static_cast<uint8_t>( TrkDelayCodeVals.at(ev.evcode) );
+                trk.nexttick += trk.lastpause;
+                return;
+            }
+
+            switch(code)
+            {
+                case eTrkEventCodes::RepeatLastPause:
+                {
+                    trk.nexttick += trk.lastpause;
+                    break;
+                }
+                case eTrkEventCodes::AddToLastPause:
+                {
+                    const int newpause = static_cast<int>(trk.lastpause) + static_cast<int8_t>(ev.params.front());
+                    trk.lastpause  = static_cast<uint32_t>( std::max(newpause, 0) );
+                    trk.nexttick  += trk.lastpause;
+                    break;
+                }
+                case eTrkEventCodes::Pause8Bits:
+                {
+                    trk.lastpause  = ev.params.front();
+                    trk.nexttick  += trk.lastpause;
+                    break;
+                }
+                case eTrkEventCodes::Pause16Bits:
+                {
+                    trk.lastpause  = (static_cast<uint16_t>(ev.params.back()) << 8) | ev.params.front();
+                    trk.nexttick  += trk.lastpause;
+                    break;
+                }
+                case eTrkEventCodes::Pause24Bits:
+                {
+                    trk.lastpause  = (static_cast<uint32_t>(ev.params[2]) << 16) | (static_cast<uint32_t>(ev.params[1]) << 8) | ev.params[0];
+                    trk.nexttick  += trk.lastpause;
+                    break;
+                }
+                case eTrkEventCodes::PauseUntilRel:
+                {
+                    //Wait for the last note to be released, or at least the check interval
+                    trk.nexttick = std::max<uint64_t>( trk.nexttick + ev.params.front(), trk.lastnoteoff );
+                    break;
+                }
+                case eTrkEventCodes::EndOfTrack:
+                {
+                    HandleEndOfTrack(trk);
+                    break;
+                }
+                case eTrkEventCodes::LoopPointSet:
+                {
+                    trk.looppos = trk.evpos; //evpos already points past the loop marker
+                    break;
+                }
+                case eTrkEventCodes::SetOctave:
+                {
+                    trk.octave = static_cast<int8_t>(ev.params.front());
+                    break;
+                }
+                case eTrkEventCodes::AddOctave:
+                {
+                    trk.octave += static_cast<int8_t>(ev.params.front());
+                    break;
+                }
+                case eTrkEventCodes::SetTempo:
+                case eTrkEventCodes::SetTempo2:
+                {
+                    if( ev.params.front() != 0 )
+                        m_tempo = ev.params.front();
+                    break;
+                }
+                case eTrkEventCodes::SetPreset:
+                {
+                    const size_t prgid = ev.params.front();
+                    trk.pprgm = ( prgid < m_prgms.PrgmInfo().size() )? m_prgms.PrgmInfo()[prgid].get() : nullptr;
+                    if( trk.pprgm == nullptr && utils::LibWide().isLogOn() && utils::LibWide().isVerboseOn() )
+                        clog << "<!>- SequenceRenderer: Track #" <<trkidx <<" selected missing program #" <<prgid <<"!\n";
+                    break;
+                }
+                case eTrkEventCodes::SetTrkVol:
+                case eTrkEventCodes::SetChanVol:
+                {
+                    trk.vol = ev.params.front() & 0x7F;
+                    break;
+                }
+                case eTrkEventCodes::AddTrkVol:
+                {
+                    trk.vol = utils::Clamp( trk.vol + static_cast<int8_t>(ev.params.front()), 0, 127 );
+                    break;
+                }
+                case eTrkEventCodes::SetExpress:
+                {
+                    trk.expr = ev.params.front() & 0x7F;
+                    break;
+                }
+                case eTrkEventCodes::SetTrkPan:
+                case eTrkEventCodes::SetChanPan:
+                {
+                    trk.pan = ev.params.front() & 0x7F;
+                    break;
+                }
+                case eTrkEventCodes::AddTrkPan:
+                {
+                    trk.pan = utils::Clamp( trk.pan + static_cast<int8_t>(ev.params.front()), 0, 127 );
+                    break;
+                }
+                case eTrkEventCodes::SetPitchBend:
+                {
+                    trk.bend = static_cast<int16_t>( (static_cast<uint16_t>(ev.params.front()) << 8) | ev.params.back() );
+                    break;
+                }
+                case eTrkEventCodes::SetPitchBendRng:
+                {
+                    trk.bendrng = ev.params.front();
+                    break;
+                }
+                default:
+                {
+                    //Everything else has no audible effect in this renderer
+                }
+            };
+        }
+
+        void HandlePlayNote( size_t trkidx, TrkState & trk, const TrkEvent & ev, uint64_t curtick )
+        {
+            int8_t  octmod    = 0;
+            uint8_t param2len = 0;
+            uint8_t parsedkey = 0;
+            ParsePlayNoteParam1( ev.params.front(), octmod, param2len, parsedkey );
+
+            if( parsedkey >= static_cast<uint8_t>(eNote::nbNotes) )
+                return;
+
+            trk.octave += octmod;
+            const int key = ( trk.octave * static_cast<int>(eNote::nbNotes) ) + parsedkey;
+
+            uint32_t holdtime = 0;
+            for( int cntby = 0; cntby < param2len && (cntby + 1) < static_cast<int>(ev.params.size()); ++cntby )
+                holdtime = (holdtime << 8) | ev.params[cntby + 1];
+            if( param2len != 0 )
+                trk.lasthold = holdtime;
+
+            trk.lastnoteoff = curtick + trk.lasthold;
+
+            if( trk.pprgm == nullptr )
+                return;
+
+            const uint8_t velocity = ev.evcode & 0x7F;
+            for( const auto & split : trk.pprgm->m_splitstbl )
+            {
+                if( key < split.lowkey || key > split.hikey || velocity < split.lovel || velocity > split.hivel )
+                    continue;
+                StartVoice( trkidx, trk, split, key, velocity );
+            }
+        }
+
+        void StartVoice( size_t trkidx, const TrkState & trk, const SplitEntry & split, int key, uint8_t velocity )
+        {
+            const DecodedSample * psmpl = m_cache.Get(split.smplid);
+            if( psmpl == nullptr )
+                return;
+
+            if( m_voices.size() >= DSE_RenderMaxVoices )
+                m_voices.erase( m_voices.begin() );
+
+            Voice vc;
+            vc.psmpl     = psmpl;
+            vc.trkidx    = trkidx;
+            vc.offtick   = trk.lastnoteoff;
+            vc.basestep  = ( static_cast<double>(psmpl->smplrate) / m_params.samplerate ) * std::exp2( (key - split.rootkey) / 12.0 );
+            vc.gain      = ( velocity / 127.0f ) * ( split.smplvol / 127.0f ) * ( trk.pprgm->prgvol / 127.0f );
+            vc.panoffset = ( static_cast<int>(split.smplpan) - 64 ) + ( static_cast<int>(trk.pprgm->prgpan) - 64 );
+            vc.env.Init( split, m_params.samplerate );
+
+            if( m_params.lfoenabled )
+            {
+                for( const auto & lfo : trk.pprgm->m_lfotbl )
+                {
+                    if( lfo.unk52 == 0 || lfo.rate == 0 || lfo.depth == 0 )
+                        continue;
+                    if( lfo.dest != static_cast<uint8_t>(LFOTblEntry::eLFODest::Pitch) &&
+                        lfo.dest != static_cast<uint8_t>(LFOTblEntry::eLFODest::Volume) &&
+                        lfo.dest != static_cast<uint8_t>(LFOTblEntry::eLFODest::Pan) )
+                        continue;
+
+                    RenderLFO rlfo;
+                    rlfo.dest     = lfo.dest;
+                    rlfo.phaseinc = static_cast<float>(lfo.rate) / m_params.samplerate;
+                    rlfo.depth    = static_cast<float>(lfo.depth) / 12.0f; //Same scale as the soundfont export
+                    rlfo.delay    = static_cast<uint32_t>( (static_cast<uint64_t>(lfo.delay) * m_params.samplerate) / 1000 );
+                    vc.lfos.push_back(rlfo);
+                }
+            }
+            m_voices.push_back( std::move(vc) );
+        }
+
+        void ReleaseDueNotes( uint64_t curtick )
+        {
+            for( auto & vc : m_voices )
+            {
+                if( !vc.released && vc.offtick <= curtick )
+                {
+                    vc.env.Release();
+                    vc.released = true;
+                }
+            }
+        }
+
+    //----------------------------------------------------------------
+    //  Mixing
+    //----------------------------------------------------------------
+        void MixBlock( float * outl, float * outr, size_t blklen )
+        {
+            for( auto & vc : m_voices )
+            {
+                const TrkState & trk     = m_trks[vc.trkidx];
+                float            cents   = ( static_cast<float>(trk.bend) / 8192.0f ) * trk.bendrng * 100.0f;
+                float            attencb = 0.0f;
+                float            panmod  = 0.0f;
+
+                for( auto & lfo : vc.lfos )
+                {
+                    if( lfo.delay > 0 )
+                    {
+                        lfo.delay -= std::min<uint32_t>( lfo.delay, static_cast<uint32_t>(blklen) );
+                        continue;
+                    }
+                    const float val = std::sin( 2.0f * DSE_RenderPi * lfo.phase );
+                    lfo.phase = std::fmod( lfo.phase + lfo.phaseinc * blklen, 1.0f );
+
+                    if( lfo.dest == static_cast<uint8_t>(LFOTblEntry::eLFODest::Pitch) )
+                        cents += val * lfo.depth;
+                    else if( lfo.dest == static_cast<uint8_t>(LFOTblEntry::eLFODest::Volume) )
+                        attencb += (val * 0.5f + 0.5f) * lfo.depth;
+                    else
+                        panmod += val * lfo.depth;
+                }
+
+                //Resample into the scratch buffer
+                const double step   = vc.basestep * std::exp2( cents / 1200.0 );
+                const size_t nbread = Resample( vc, step, m_scratch.data(), blklen );
+                if( nbread < blklen )
+                    std::fill( m_scratch.begin() + nbread, m_scratch.begin() + blklen, 0.0f );
+
+                //Compute the gains at the end of the block
+                const float envlvl = vc.env.Advance( static_cast<uint32_t>(blklen) );
+                const float vol    = vc.gain * m_params.mastergain * envlvl * ( trk.vol / 127.0f ) * ( trk.expr / 127.0f )
+                                     * std::pow( 10.0f, -attencb / 200.0f );
+                const float pan    = utils::Clamp( static_cast<float>(trk.pan + vc.panoffset) + panmod, 0.0f, 127.0f ) / 127.0f;
+                const float gl     = vol * std::cos( pan * DSE_RenderPi * 0.5f );
+                const float gr     = vol * std::sin( pan * DSE_RenderPi * 0.5f );
+
+                if( !vc.hasgains )
+                {
+                    vc.lastgl   = gl;
+                    vc.lastgr   = gr;
+                    vc.hasgains = true;
+                }
+                MixRampStereo( m_scratch.data(), outl, outr, blklen, vc.lastgl, gl, vc.lastgr, gr );
+                vc.lastgl = gl;
+                vc.lastgr = gr;
+
+                if( vc.env.IsDone() )
+                    vc.finished = true;
+            }
+
+            m_voices.erase( std::remove_if( m_voices.begin(), m_voices.end(), [](const Voice & vc){ return vc.finished; } ), m_voices.end() );
+        }
+
+        /*
+            Resample
+                Reads from the voice's sample, wrapping around the loop as needed.
+                Returns the nb of samples produced, which is less than requested if a one-shot sample ended.
+        */
+        size_t Resample( Voice & vc, double step, float * dst, size_t len )
+        {
+            const DecodedSample & smpl = *vc.psmpl;
+            const double          end  = static_cast<double>(smpl.loopend);
+            size_t                done = 0;
+
+            while( done < len )
+            {
+                if( vc.pos >= end )
+                {
+                    if( !smpl.looped )
+                    {
+                        vc.finished = true;
+                        break;
+                    }
+                    const double looplen = end - static_cast<double>(smpl.loopbeg);
+                    vc.pos = static_cast<double>(smpl.loopbeg) + std::fmod( vc.pos - end, std::max(looplen, 1.0) );
+                }
+
+                //Run the kernel up to the loop end
+                const size_t untilend = static_cast<size_t>( std::ceil( (end - vc.pos) / step ) );
+                const size_t runlen   = std::max<size_t>( 1, std::min( len - done, untilend ) );
+                InterpolateLinear( smpl.data.data(), vc.pos, step, dst + done, runlen );
+                vc.pos += step * static_cast<double>(runlen);
+                done   += runlen;
+            }
+            return done;
+        }
+
+    private:
+        const MusicSequence   & m_seq;
+        const ProgramBank     & m_prgms;
+        RenderSampleCache     & m_cache;
+        RenderParams            m_params;
+        uint16_t                m_tpqn  = DSE_RenderDefTPQN;
+        double                  m_tempo = DSE_RenderDefTempo;
+        std::vector<TrkState>   m_trks;
+        std::vector<Voice>      m_voices;
+        std::vector<float>      m_scratch;
+        RenderedAudio           m_out;
+    };
+
+//====================================================================================================
+//  Functions
+//====================================================================================================
+    RenderedAudio RenderSequence( const MusicSequence & seq,
+                                  const ProgramBank   & prgms,
+                                  const SampleBank    & smpls,
+                                  const RenderParams  & params )
+    {
+        RenderSampleCache cache(smpls);
+        return SequenceRenderer( seq, prgms, cache, params )();
+    }
+
+    void WriteRenderToWave( const RenderedAudio & audio, const std::string & fpath )
+    {
+        wave::IEEEFloatWaveFile outwav(audio.samplerate);
+        auto & chans = outwav.GetSamples();
+        chans.push_back(audio.left);
+        chans.push_back(audio.right);
+
+        //Don't choke on silent sequences
+        if( chans.front().empty() )
+        {
+            chans[0].push_back(0.0f);
+            chans[1].push_back(0.0f);
+        }
+        outwav.WriteWaveFile(fpath);
+    }
+
+    void RenderSequencesToWave( const std::vector<RenderJob> & jobs, const RenderParams & params )
+    {
+        //Samples are shared by all the jobs using the same sample bank
+        std::map<const SampleBank*, std::unique_ptr<RenderSampleCache>> caches;
+        for( const auto & job : jobs )
+        {
+            if( job.pseq == nullptr || job.pprgms == nullptr || job.psmpls == nullptr )
+                throw std::runtime_error("RenderSequencesToWave(): A render job is missing its sequence, programs, or samples!");
+            if( caches.find(job.psmpls) == caches.end() )
+                caches.emplace( job.psmpls, std::unique_ptr<RenderSampleCache>( new RenderSampleCache(*job.psmpls) ) );
+        }
+
+        utils::AsyncTaskHandler        taskhandler;
+        std::vector<std::future<void>> taskresults;
+        std::atomic<size_t>            cntdone(0);
+        std::mutex                     mtxprogress;
+        const bool                     bprogress = utils::LibWide().ShouldDisplayProgress();
+        taskresults.reserve(jobs.size());
+
+        for( size_t cntjob = 0; cntjob < jobs.size(); ++cntjob )
+        {
+            RenderSampleCache * pcache = caches.at(jobs[cntjob].psmpls).get();
+            utils::AsyncTaskHandler::task_t task( [&jobs, &params, &cntdone, &mtxprogress, bprogress, pcache, cntjob]()
+            {
+                const RenderJob & job = jobs[cntjob];
+                WriteRenderToWave( SequenceRenderer( *job.pseq, *job.pprgms, *pcache, params )(), job.outpath );
+
+                const size_t nbdone = ++cntdone;
+                if( bprogress )
+                {
+                    std::lock_guard<std::mutex> lck(mtxprogress);
+                    cout << "\r\tRendering sequences.. " << right << setw(3) << setfill(' ') << ((nbdone * 100) / jobs.size()) << "%";
+                }
+            });
+            taskresults.push_back(task.get_future());
+            taskhandler.QueueTask(std::move(task));
+        }
+
+        if( !taskhandler.empty() )
+        {
+            taskhandler.Start();
+            taskhandler.WaitTasksFinished();
+            taskhandler.WaitStop();
+        }
+        if( bprogress )
+            cout << "\r\tRendering sequences.. 100%\n";
+
+        for( auto & fut : taskresults )
+            fut.get();
+    }
+
+};
@@ -0,0 +1,1338 @@
+#include <dse/dse_smf.hpp>
+#include <dse/dse_sequence.hpp>
+#include <utils/gbyteutils.hpp>
+#include <utils/gfileio.hpp>
+#include <utils/library_wide.hpp>
+#include <utils/poco_wrapper.hpp>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <iterator>
+#include <functional>
+#include <queue>
+#include <array>
+#include <map>
+#include <limits>
+using namespace std;
+
+#ifndef AUDIOUTIL_VER
+    #define AUDIOUTIL_VER "Poochyena"
+#endif
+
+namespace DSE
+{
+//====================================================================================================
+//  Constants
+//====================================================================================================
+    static const string  UtilityID          = "ExportedWith: ppmd_audioutil.exe ver" AUDIOUTIL_VER;
+    static const string  TXT_LoopStart      = "LoopStart";
+    static const string  TXT_LoopEnd        = "LoopEnd";
+    static const string  TXT_DSE_Event      = "DSE_Event"; //Marks DSE events that have no MIDI equivalents
+
+    static const int8_t  DSE_MaxOctave      = 9;
+    static const uint8_t NbKeysInOctave     = static_cast<uint8_t>(eNote::nbNotes);
+    static const size_t  NbMidiKeys         = 128;
+
+    //Status bytes
+    static const uint8_t SMF_StatusNoteOff  = 0x80;
+    static const uint8_t SMF_StatusNoteOn   = 0x90;
+    static const uint8_t SMF_StatusCtrlChg  = 0xB0;
+    static const uint8_t SMF_StatusPrgmChg  = 0xC0;
+    static const uint8_t SMF_StatusChanPres = 0xD0;
+    static const uint8_t SMF_StatusBend     = 0xE0;
+    static const uint8_t SMF_StatusSysEx    = 0xF0;
+    static const uint8_t SMF_StatusSysExEsc = 0xF7;
+    static const uint8_t SMF_StatusMeta     = 0xFF;
+
+    //Meta-events
+    static const uint8_t SMF_MetaText       = 0x01;
+    static const uint8_t SMF_MetaTrackName  = 0x03;
+    static const uint8_t SMF_MetaMarker     = 0x06;
+    static const uint8_t SMF_MetaEoT        = 0x2F;
+    static const uint8_t SMF_MetaTempo      = 0x51;
+    static const uint8_t SMF_MetaTimeSig    = 0x58;
+
+    //Controllers
+    static const uint8_t SMF_CC_BankMSB     = 0;
+    static const uint8_t SMF_CC_DataEntry   = 6;
+    static const uint8_t SMF_CC_Volume      = 7;
+    static const uint8_t SMF_CC_Pan         = 10;
+    static const uint8_t SMF_CC_Expression  = 11;
+    static const uint8_t SMF_CC_BankLSB     = 32;
+    static const uint8_t SMF_CC_RPN_LSB     = 100;
+    static const uint8_t SMF_CC_RPN_MSB     = 101;
+
+    static const int     SMF_BendCenter     = 0x2000;
+    static const int     SMF_BendMax        = 0x3FFF;
+
+    //The sysex messages put at the beginning of the file, minus the leading 0xF0
+    static const array<uint8_t,10> SMF_GSReset     {{ 0x41, 0x10, 0x42, 0x12, 0x40, 0x00, 0x7F, 0x00, 0x41, 0xF7 }};
+    static const array<uint8_t,10> SMF_GSDrumsOff  {{ 0x41, 0x10, 0x42, 0x12, 0x40, 0x10, 0x15, 0x00, 0x1B, 0xF7 }};
+    static const array<uint8_t, 8> SMF_XGReset     {{ 0x43, 0x10, 0x4C, 0x00, 0x00, 0x7E, 0x00, 0xF7 }};
+    static const array<uint8_t, 4> SMF_TimeSig44   {{ 0x04, 0x02, 0x18, 0x08 }};
+
+//====================================================================================================
+//  SMFTrackBuffer
+//====================================================================================================
+    /*
+        SMFTrackBuffer
+            Accumulates the encoded events of a single MIDI track chunk.
+            Events must be put in chronological order. Delta-times are encoded as they come in,
+            and running status is used for consecutive channel messages with the same status.
+    */
+    class SMFTrackBuffer
+    {
+    public:
+        SMFTrackBuffer()
+            :m_lasttick(0), m_runstatus(0)
+        {}
+
+        void PutChannelMsg( uint32_t tick, uint8_t status, uint8_t data1 )
+        {
+            PutStatus( tick, status );
+            m_data.push_back( data1 & 0x7F );
+        }
+
+        void PutChannelMsg( uint32_t tick, uint8_t status, uint8_t data1, uint8_t data2 )
+        {
+            PutStatus( tick, status );
+            m_data.push_back( data1 & 0x7F );
+            m_data.push_back( data2 & 0x7F );
+        }
+
+        void PutMeta( uint32_t tick, uint8_t type, const uint8_t * pdata, size_t len )
+        {
+            PutDelta(tick);
+            m_data.push_back(SMF_StatusMeta);
+            m_data.push_back(type);
+            PutVarLen( static_cast<uint32_t>(len) );
+            if( len != 0 )
+                m_data.insert( m_data.end(), pdata, pdata + len );
+            m_runstatus = 0;
+        }
+
+        void PutText( uint32_t tick, uint8_t type, const string & txt )
+        {
+            PutMeta( tick, type, reinterpret_cast<const uint8_t*>(txt.data()), txt.size() );
+        }
+
+        //The data must not contain the leading 0xF0, but must end with 0xF7
+        void PutSysEx( uint32_t tick, const uint8_t * pdata, size_t len )
+        {
+            PutDelta(tick);
+            m_data.push_back(SMF_StatusSysEx);
+            PutVarLen( static_cast<uint32_t>(len) );
+            m_data.insert( m_data.end(), pdata, pdata + len );
+            m_runstatus = 0;
+        }
+
+        void PutEndOfTrack( uint32_t tick )
+        {
+            PutMeta( tick, SMF_MetaEoT, nullptr, 0 );
+        }
+
+        inline uint32_t LastTick()const { return m_lasttick; }
+        inline size_t   size()const     { return m_data.size(); }
+
+        template<class _backinsit>
+            _backinsit WriteChunk( _backinsit itw )const
+        {
+            itw = utils::WriteIntToBytes( SMF_MagicTrack,                       itw, false );
+            itw = utils::WriteIntToBytes( static_cast<uint32_t>(m_data.size()), itw, false );
+            return std::copy( m_data.begin(), m_data.end(), itw );
+        }
+
+    private:
+        inline void PutDelta( uint32_t tick )
+        {
+            uint32_t delta = 0;
+            if( tick > m_lasttick )
+            {
+                delta      = tick - m_lasttick;
+                m_lasttick = tick;
+            }
+            PutVarLen(delta);
+        }
+
+        inline void PutStatus( uint32_t tick, uint8_t status )
+        {
+            PutDelta(tick);
+            if( status != m_runstatus )
+            {
+                m_data.push_back(status);
+                m_runstatus = status;
+            }
+        }
+
+        inline void PutVarLen( uint32_t value )
+        {
+            uint8_t buf[5];
+            int     cnt = 0;
+            buf[cnt++] = value & 0x7F;
+            while( (value >>= 7) != 0 )
+                buf[cnt++] = 0x80 | (value & 0x7F);
+            while( cnt > 0 )
+                m_data.push_back( buf[--cnt] );
+        }
+
+    private:
+        vector<uint8_t> m_data;
+        uint32_t        m_lasttick;
+        uint8_t         m_runstatus;
+    };
+
+//====================================================================================================
+//  DSESequenceToSMF
+//====================================================================================================
+    /*
+        DSESequenceToSMF
+            Converts a DSE sequence into a format 1 standard MIDI file.
+            Every DSE track is processed in a single pass. Since DSE notes carry their own duration,
+            note offs are queued per track, and written as soon as the track's time passes them.
+            A table of the sounding keys lets us cut a note that's re-triggered before its note off.
+    */
+    class DSESequenceToSMF
+    {
+        struct TrkState
+        {
+            uint32_t      ticks_          = 0; //The current tick count for the track
+            uint32_t      lastpause_      = 0; //Duration of the last pause event, including fixed duration pauses.
+            uint32_t      lasthold_       = 0; //Last duration a note was held
+            uint32_t      lastnoteoff_    = 0; //Tick at which the last note played will be released
+            int8_t        octave_         = 0; //The track's current octave
+            size_t        looppoint_      = 0; //The index of the event after the loop point
+            bool          hasloop_        = false;
+            bankid_t      curbank_        = 0;
+            dsepresetid_t curprgm_        = 0;
+            dsepresetid_t origdseprgm_    = 0; //The original program ID, not the one that has been remaped
+            int8_t        transpose_      = 0; //The nb of octaves to transpose the notes played by this track
+            uint32_t      maxkeydowndur_  = 0; //Longest duration a note may be held with the current preset. 0 is unlimited.
+            bool          hasinvalidbank_ = false;
+
+            //Those allows to keep track of when to revert to and from the overriden presets
+            bool          presetoverriden_= false;
+            bankid_t      ovrbank_        = InvalidBankID;
+            presetid_t    ovrprgm_        = InvalidPresetID;
+        };
+
+        struct PendingNoteOff
+        {
+            uint32_t tick;
+            uint8_t  note;
+            uint8_t  vel;
+
+            inline bool operator>( const PendingNoteOff & other )const { return tick > other.tick; }
+        };
+
+        /*
+            Keys currently held on a track, and the note offs waiting to be written.
+        */
+        struct ActiveNotes
+        {
+            ActiveNotes()
+            {
+                offtick.fill(0);
+                sounding.fill(false);
+            }
+
+            array<uint32_t, NbMidiKeys>  offtick;
+            array<bool,     NbMidiKeys>  sounding;
+            priority_queue<PendingNoteOff, vector<PendingNoteOff>, greater<PendingNoteOff>> pending;
+        };
+
+    public:
+        DSESequenceToSMF( const MusicSequence & seq, const SMDLPresetConversionInfo * premap, eMIDIMode mode, uint32_t nbloops )
+            :m_seq(seq), m_convtable(premap), m_midimode(mode), m_nbloops(nbloops), m_bLoopBegSet(false), m_bTrackLoopable(false)
+        {}
+
+        vector<uint8_t> operator()()
+        {
+            const size_t nbtrks = m_seq.getNbTracks();
+            vector<SMFTrackBuffer> trkbufs( std::max<size_t>( nbtrks, 1 ) );
+            m_trkstates       .resize(nbtrks);
+            m_beflooptrkstates.resize(nbtrks);
+            m_notes           .resize(nbtrks);
+
+            PrepareConductorTrack( trkbufs.front() );
+
+            //Play all tracks once
+            uint32_t songlsttick = 0;
+            for( size_t trkno = 0; trkno < nbtrks; ++trkno )
+            {
+                ExportATrack( trkno, 0, trkbufs[trkno] );
+                songlsttick = std::max( songlsttick, m_trkstates[trkno].ticks_ );
+            }
+
+            //Just mark the end of the loop when we're not looping ourselves. This prevents there being a delay when looping in external players!
+            //Notes still held on the first track are released first, so they're not pushed back to the marker's tick.
+            if( m_bTrackLoopable && m_nbloops == 0 )
+            {
+                FlushNoteOffs( 0, songlsttick, trkbufs.front() );
+                trkbufs.front().PutText( songlsttick, SMF_MetaMarker, TXT_LoopEnd );
+            }
+
+            WriteUnhandledEventsReport();
+
+            //Then play the looped section of each tracks again, as many times as requested
+            if( m_bTrackLoopable )
+            {
+                for( uint32_t cntloop = 0; cntloop < m_nbloops; ++cntloop )
+                {
+                    for( size_t trkno = 0; trkno < nbtrks; ++trkno )
+                    {
+                        if( !m_trkstates[trkno].hasloop_ )
+                            continue;
+                        uint32_t backticks       = m_trkstates[trkno].ticks_;
+                        uint32_t backnoteoff     = m_trkstates[trkno].lastnoteoff_;
+                        m_trkstates[trkno]              = m_beflooptrkstates[trkno];
+                        m_trkstates[trkno].ticks_       = backticks;
+                        m_trkstates[trkno].lastnoteoff_ = backnoteoff;
+                        ExportATrack( trkno, m_trkstates[trkno].looppoint_, trkbufs[trkno] );
+                    }
+                }
+            }
+
+            //Release whatever is still held, and close the tracks
+            size_t totallen = (2 * sizeof(uint32_t)) + SMF_HeaderLen;
+            for( size_t trkno = 0; trkno < trkbufs.size(); ++trkno )
+            {
+                uint32_t endtick = trkbufs[trkno].LastTick();
+                if( trkno < nbtrks )
+                {
+                    FlushNoteOffs( trkno, numeric_limits<uint32_t>::max(), trkbufs[trkno] );
+                    endtick = std::max( endtick, m_trkstates[trkno].ticks_ );
+                }
+                trkbufs[trkno].PutEndOfTrack( std::max( endtick, trkbufs[trkno].LastTick() ) );
+                totallen += (2 * sizeof(uint32_t)) + trkbufs[trkno].size();
+            }
+
+            //Assemble the file
+            vector<uint8_t> out;
+            out.reserve(totallen);
+            auto itw = back_inserter(out);
+            itw = utils::WriteIntToBytes( SMF_MagicHeader,                          itw, false );
+            itw = utils::WriteIntToBytes( SMF_HeaderLen,                            itw, false );
+            itw = utils::WriteIntToBytes( static_cast<uint16_t>(1),                 itw, false ); //Format 1
+            itw = utils::WriteIntToBytes( static_cast<uint16_t>(trkbufs.size()),    itw, false );
+            itw = utils::WriteIntToBytes( GetTPQN(),                                itw, false );
+
+            for( const auto & trk : trkbufs )
+                itw = trk.WriteChunk(itw);
+
+            return out;
+        }
+
+    private:
+
+        inline uint16_t GetTPQN()const
+        {
+            return (m_seq.metadata().tpqn != 0)? m_seq.metadata().tpqn : DefaultTickRte;
+        }
+
+        /****************************************************************************
+            PrepareConductorTrack
+                Place common messages at the beginning of the first track.
+        ****************************************************************************/
+        void PrepareConductorTrack( SMFTrackBuffer & out )
+        {
+            if( m_midimode == eMIDIMode::GS )
+            {
+                out.PutSysEx( 0, SMF_GSReset.data(),    SMF_GSReset.size() );
+                out.PutSysEx( 0, SMF_GSDrumsOff.data(), SMF_GSDrumsOff.size() );
+            }
+            else if( m_midimode == eMIDIMode::XG )
+                out.PutSysEx( 0, SMF_XGReset.data(), SMF_XGReset.size() );
+
+            out.PutMeta( 0, SMF_MetaTimeSig, SMF_TimeSig44.data(), SMF_TimeSig44.size() );
+            out.PutText( 0, SMF_MetaTrackName, m_seq.metadata().fname );
+            out.PutText( 0, SMF_MetaText,      UtilityID );
+        }
+
+        /****************************************************************************
+            ExportATrack
+                Converts the events of the DSE track, starting at event "evno".
+        ****************************************************************************/
+        void ExportATrack( size_t trkno, size_t evno, SMFTrackBuffer & out )
+        {
+            const MusicTrack & trk   = m_seq[trkno];
+            TrkState         & state = m_trkstates[trkno];
+            const uint8_t      chan  = trk.GetMidiChannel() & 0x0F;
+
+            if( utils::LibWide().isLogOn() && utils::LibWide().isVerboseOn() )
+                clog <<"---- Exporting Track#" <<trkno <<" ----\n";
+
+            for( ; evno < trk.size(); ++evno )
+            {
+                const TrkEvent & ev = trk[evno];
+                if( ev.evcode == static_cast<uint8_t>(eTrkEventCodes::EndOfTrack) )
+                    break;
+                HandleEvent( trkno, chan, evno, state, ev, out );
+            }
+        }
+
+        /****************************************************************************
+            FlushNoteOffs
+                Writes all queued note offs happening at or before "uptotick".
+        ****************************************************************************/
+        void FlushNoteOffs( size_t trkno, uint32_t uptotick, SMFTrackBuffer & out )
+        {
+            ActiveNotes & notes = m_notes[trkno];
+            const uint8_t chan  = m_seq[trkno].GetMidiChannel() & 0x0F;
+
+            while( !notes.pending.empty() && notes.pending.top().tick <= uptotick )
+            {
+                const PendingNoteOff off = notes.pending.top();
+                notes.pending.pop();
+
+                //Skip note offs for keys that were cut or re-triggered since
+                if( notes.sounding[off.note] && notes.offtick[off.note] == off.tick )
+                {
+                    out.PutChannelMsg( off.tick, SMF_StatusNoteOff | chan, off.note, off.vel );
+                    notes.sounding[off.note] = false;
+                }
+            }
+        }
+
+        /****************************************************************************
+            HandleEvent
+        ****************************************************************************/
+        void HandleEvent( size_t trkno, uint8_t chan, size_t evno, TrkState & state, const TrkEvent & ev, SMFTrackBuffer & out )
+        {
+            const eTrkEventCodes code = static_cast<eTrkEventCodes>(ev.evcode);
+
+            if( code >= eTrkEventCodes::RepeatLastPause && code <= eTrkEventCodes::PauseUntilRel )
+            {
+                HandlePauses( code, ev, state );
+                return;
+            }
+            else if( code >= eTrkEventCodes::Delay_HN && code <= eTrkEventCodes::Delay_64N )
+            {
+                state.lastpause_ = static_cast<uint8_t>( TrkDelayCodesTbl[ev.evcode - static_cast<uint8_t>(eTrkEventCodes::Delay_HN)] );
+                state.ticks_    += state.lastpause_;
+                return;
+            }
+
+            //Any note off before now must be written before the event
+            FlushNoteOffs( trkno, state.ticks_, out );
+
+            if( code >= eTrkEventCodes::NoteOnBeg && code <= eTrkEventCodes::NoteOnEnd )
+            {
+                HandlePlayNote( trkno, chan, state, ev, out );
+                return;
+            }
+
+            switch( code )
+            {
+                case eTrkEventCodes::SetTempo:
+                case eTrkEventCodes::SetTempo2:
+                {
+                    if( ev.params.front() == 0 )
+                        break;
+                    const uint32_t mpqn = ConvertTempoToMicrosecPerQuarterNote( ev.params.front() );
+                    const uint8_t  tempo[3] { static_cast<uint8_t>(mpqn >> 16), static_cast<uint8_t>(mpqn >> 8), static_cast<uint8_t>(mpqn) };
+                    out.PutMeta( state.ticks_, SMF_MetaTempo, tempo, sizeof(tempo) );
+                    break;
+                }
+                case eTrkEventCodes::SetOctave:
+                {
+                    int8_t newoctave = ev.params.front();
+                    if( newoctave > DSE_MaxOctave )
+                        clog << "New octave value set is too high !" <<static_cast<unsigned short>(newoctave) <<"\n";
+                    state.octave_ = newoctave;
+                    break;
+                }
+                case eTrkEventCodes::AddOctave:
+                {
+                    int8_t newoctave = static_cast<int8_t>(ev.params.front()) + state.octave_;
+                    if( newoctave > DSE_MaxOctave )
+                        clog << "New octave value set is too high !" <<static_cast<unsigned short>(newoctave) <<"\n";
+                    state.octave_ = newoctave;
+                    break;
+                }
+                case eTrkEventCodes::SetExpress:
+                {
+                    out.PutChannelMsg( state.ticks_, SMF_StatusCtrlChg | chan, SMF_CC_Expression, ev.params.front() );
+                    break;
+                }
+                case eTrkEventCodes::SetTrkVol:
+                {
+                    out.PutChannelMsg( state.ticks_, SMF_StatusCtrlChg | chan, SMF_CC_Volume, ev.params.front() );
+                    break;
+                }
+                case eTrkEventCodes::SetTrkPan:
+                case eTrkEventCodes::SetChanPan:
+                {
+                    out.PutChannelMsg( state.ticks_, SMF_StatusCtrlChg | chan, SMF_CC_Pan, ev.params.front() );
+                    break;
+                }
+                case eTrkEventCodes::SetPitchBend:
+                {
+                    //Both DSE and MIDI use about the same scale for the bend, but MIDI's is unsigned 14 bits
+                    const int16_t bend    = static_cast<int16_t>( (static_cast<uint16_t>(ev.params.front()) << 8) | ev.params.back() );
+                    const int     midibnd = utils::Clamp( bend + SMF_BendCenter, 0, SMF_BendMax );
+                    out.PutChannelMsg( state.ticks_, SMF_StatusBend | chan, static_cast<uint8_t>(midibnd & 0x7F), static_cast<uint8_t>(midibnd >> 7) );
+                    break;
+                }
+                case eTrkEventCodes::SetPitchBendRng:
+                {
+                    //RPN 0,0 is the pitch bend range
+                    out.PutChannelMsg( state.ticks_, SMF_StatusCtrlChg | chan, SMF_CC_RPN_LSB,   0 );
+                    out.PutChannelMsg( state.ticks_, SMF_StatusCtrlChg | chan, SMF_CC_RPN_MSB,   0 );
+                    out.PutChannelMsg( state.ticks_, SMF_StatusCtrlChg | chan, SMF_CC_DataEntry, ev.params.front() );
+                    break;
+                }
+                case eTrkEventCodes::LoopPointSet:
+                {
+                    //Only place a marker if we don't loop the track ourselves, and haven't placed it already
+                    if( m_nbloops == 0 && !m_bLoopBegSet )
+                        out.PutText( state.ticks_, SMF_MetaMarker, TXT_LoopStart );
+
+                    m_bTrackLoopable = true;
+                    m_bLoopBegSet    = true;
+
+                    state.hasloop_            = true;
+                    state.looppoint_          = evno + 1; //Add one to avoid re-processing the loop marker
+                    m_beflooptrkstates[trkno] = state;
+                    break;
+                }
+                case eTrkEventCodes::SetPreset:
+                {
+                    HandleSetPreset( ev, chan, state, out );
+                    break;
+                }
+
+                //Those are kept only for research purpose, or will require some special handling
+                case eTrkEventCodes::RepeatFrom:
+                case eTrkEventCodes::RepeatSegment:
+                case eTrkEventCodes::AfterRepeat:
+                case eTrkEventCodes::SkipNextByte:
+                case eTrkEventCodes::SkipNext2Bytes1:
+                case eTrkEventCodes::SkipNext2Bytes2:
+                {
+                    break;
+                }
+                default:
+                {
+                    HandleUnsupported( ev, trkno, state, out );
+                }
+            };
+        }
+
+        /****************************************************************************
+            HandlePauses
+        ****************************************************************************/
+        inline void HandlePauses( eTrkEventCodes code, const TrkEvent & ev, TrkState & state )
+        {
+            switch(code)
+            {
+                case eTrkEventCodes::Pause24Bits:
+                {
+                    state.lastpause_ = (static_cast<uint32_t>(ev.params[2]) << 16) | (static_cast<uint32_t>(ev.params[1]) << 8) | ev.params[0];
+                    break;
+                }
+                case eTrkEventCodes::Pause16Bits:
+                {
+                    state.lastpause_ = (static_cast<uint16_t>(ev.params.back()) << 8) | ev.params.front();
+                    break;
+                }
+                case eTrkEventCodes::Pause8Bits:
+                {
+                    state.lastpause_ = ev.params.front();
+                    break;
+                }
+                case eTrkEventCodes::AddToLastPause:
+                {
+                    const int newpause = static_cast<int>(state.lastpause_) + static_cast<int8_t>(ev.params.front());
+                    if( newpause < 0 && utils::LibWide().isLogOn() )
+                        clog << "Warning: AddToLastPause event addition resulted in a negative value! Clamping to 0!\n";
+                    state.lastpause_ = static_cast<uint32_t>( std::max( newpause, 0 ) );
+                    break;
+                }
+                case eTrkEventCodes::RepeatLastPause:
+                {
+                    break;
+                }
+                case eTrkEventCodes::PauseUntilRel:
+                {
+                    //Wait until the last note is released, or at least the check interval
+                    state.ticks_ = std::max( state.ticks_ + ev.params.front(), state.lastnoteoff_ );
+                    return;
+                }
+                default:
+                    return;
+            };
+            state.ticks_ += state.lastpause_;
+        }
+
+        /****************************************************************************
+            HandleSetPreset
+                Converts DSE preset change events into MIDI bank select and MIDI
+                program change.
+        ****************************************************************************/
+        void HandleSetPreset( const TrkEvent & ev, uint8_t chan, TrkState & state, SMFTrackBuffer & out )
+        {
+            const uint8_t originalprgm = ev.params.front();
+            state.origdseprgm_   = originalprgm;
+            state.hasinvalidbank_= false;
+            state.curbank_       = 0;
+            state.curprgm_       = originalprgm;
+            state.transpose_     = 0;
+            state.maxkeydowndur_ = 0;
+
+            if( m_convtable != nullptr )
+            {
+                auto itfound = m_convtable->FindConversionInfo( originalprgm );
+
+                //Some presets in the SMD might not even exist! Several tracks in PMD2 have this issue.
+                if( itfound != m_convtable->end() )
+                {
+                    state.curbank_       = itfound->second.midibank;
+                    state.curprgm_       = itfound->second.midipres;
+                    state.transpose_     = itfound->second.transpose;
+                    state.maxkeydowndur_ = itfound->second.maxkeydowndur;
+                }
+                else
+                {
+                    state.hasinvalidbank_ = true;
+                    state.curbank_        = 0x7F; //Set to bank 127 to mark the error
+                    clog << "Couldn't find a matching bank for preset #"
+                         << static_cast<short>(originalprgm) <<" ! Setting to bank " <<state.curbank_ <<" !\n";
+                }
+            }
+
+            //Change only if the preset/bank isn't overriden!
+            if( !state.presetoverriden_ )
+            {
+                PutBankChange( out, chan, state.ticks_, state.curbank_ );
+                out.PutChannelMsg( state.ticks_, SMF_StatusPrgmChg | chan, static_cast<uint8_t>(state.curprgm_) );
+            }
+        }
+
+        /****************************************************************************
+            HandleBankAndPresetOverrides
+                Handle placing bank+preset change messages around a few specific notes.
+        ****************************************************************************/
+        void HandleBankAndPresetOverrides( uint8_t                                         chan,
+                                           TrkState                                      & state,
+                                           SMFTrackBuffer                                & out,
+                                           midinote_t                                    & mnoteid,
+                                           const SMDLPresetConversionInfo::NoteRemapData & remapdata )
+        {
+            mnoteid = remapdata.destnote;
+
+            if( state.presetoverriden_ &&
+                remapdata.destpreset != state.ovrprgm_ &&
+                remapdata.destbank   != state.ovrbank_ )
+            {
+                //Restore the override if the current note doesn't define one
+                state.presetoverriden_ = false;
+                state.ovrprgm_         = InvalidPresetID;
+                state.ovrbank_         = InvalidBankID;
+                PutBankChange( out, chan, state.ticks_, state.curbank_ );
+                out.PutChannelMsg( state.ticks_, SMF_StatusPrgmChg | chan, static_cast<uint8_t>(state.curprgm_) );
+            }
+            else if( remapdata.destpreset != InvalidPresetID ||
+                     remapdata.destbank   != InvalidBankID )
+            {
+                if( remapdata.destbank != InvalidBankID )
+                {
+                    if( !state.presetoverriden_ || state.ovrbank_ != remapdata.destbank )
+                    {
+                        state.ovrbank_ = remapdata.destbank;
+                        PutBankChange( out, chan, state.ticks_, state.ovrbank_ );
+                    }
+                }
+                else if( state.presetoverriden_ )
+                    PutBankChange( out, chan, state.ticks_, state.curbank_ );
+
+                if( remapdata.destpreset != InvalidPresetID )
+                {
+                    if( !state.presetoverriden_ || state.ovrprgm_ != remapdata.destpreset )
+                    {
+                        state.ovrprgm_ = remapdata.destpreset;
+                        out.PutChannelMsg( state.ticks_, SMF_StatusPrgmChg | chan, state.ovrprgm_ );
+                    }
+                }
+                else if( state.presetoverriden_ )
+                    out.PutChannelMsg( state.ticks_, SMF_StatusPrgmChg | chan, static_cast<uint8_t>(state.curprgm_) );
+
+                state.presetoverriden_ = true;
+            }
+        }
+
+        /****************************************************************************
+            HandlePlayNote
+                Writes the note on right away, and queues its note off.
+        ****************************************************************************/
+        void HandlePlayNote( size_t trkno, uint8_t chan, TrkState & state, const TrkEvent & ev, SMFTrackBuffer & out )
+        {
+            int8_t  octmod    = 0;
+            uint8_t param2len = 0;
+            uint8_t parsedkey = 0;
+            ParsePlayNoteParam1( ev.params.front(), octmod, param2len, parsedkey );
+
+            if( parsedkey >= NbKeysInOctave )
+            {
+                clog <<"<!>- Event on track#" <<trkno << ", has key ID 0x" <<hex <<static_cast<short>(parsedkey) <<dec <<"! Unsupported!\n";
+                return;
+            }
+
+            state.octave_ = state.octave_ + octmod;
+            midinote_t mnoteid = static_cast<midinote_t>( (state.octave_ * NbKeysInOctave) + parsedkey );
+
+            //Parse the note hold duration bytes
+            if( param2len != 0 )
+            {
+                uint32_t holdtime = 0;
+                for( int cntby = 0; cntby < param2len; ++cntby )
+                    holdtime = (holdtime << 8) | ev.params[cntby+1];
+                state.lasthold_ = holdtime;
+            }
+
+            if( m_convtable != nullptr )
+            {
+                auto remapdata = m_convtable->RemapNote( state.origdseprgm_, (mnoteid & 0x7F) );
+                HandleBankAndPresetOverrides( chan, state, out, mnoteid, remapdata );
+
+                if( state.transpose_ != 0 )
+                {
+                    int transposed = mnoteid + (state.transpose_ * NbKeysInOctave);
+                    if( transposed >= 0 && transposed < 127 )
+                        mnoteid = transposed;
+                    else
+                        clog <<"<!>- Invalid transposition value was ignored! The transposed note " <<transposed <<" was out of the MIDI range!\n";
+                }
+            }
+            mnoteid &= 0x7F;
+
+            //If we got an invalid bank, silence the note, while leaving it there
+            const uint8_t vel      = static_cast<uint8_t>(ev.evcode & 0x7F);
+            const uint8_t onvel    = (state.hasinvalidbank_)? 0 : vel;
+            uint32_t      holddur  = state.lasthold_;
+            if( state.maxkeydowndur_ != 0 )
+                holddur = std::min( holddur, state.maxkeydowndur_ );
+            const uint32_t offtick = state.ticks_ + holddur;
+
+            //Cut the key if its still held from a previous note
+            ActiveNotes & notes = m_notes[trkno];
+            if( notes.sounding[mnoteid] )
+                out.PutChannelMsg( state.ticks_, SMF_StatusNoteOff | chan, mnoteid, vel );
+
+            out.PutChannelMsg( state.ticks_, SMF_StatusNoteOn | chan, mnoteid, onvel );
+            notes.sounding[mnoteid] = true;
+            notes.offtick [mnoteid] = offtick;
+            notes.pending.push( PendingNoteOff{ offtick, mnoteid, vel } );
+            state.lastnoteoff_ = std::max( state.lastnoteoff_, offtick );
+
+            if( utils::LibWide().isLogOn() && utils::LibWide().isVerboseOn() )
+                clog <<setw(8) <<state.ticks_ <<"t : " << MidiNoteIdToText(mnoteid) << ", hold " <<holddur <<" tick(s)\n";
+        }
+
+        /****************************************************************************
+            HandleUnsupported
+                Put DSE events without MIDI equivalents into marker meta-events,
+                so they can be recovered on import.
+        ****************************************************************************/
+        void HandleUnsupported( const TrkEvent & ev, size_t trkno, TrkState & state, SMFTrackBuffer & out )
+        {
+            stringstream evmark;
+            evmark << TXT_DSE_Event << "_Chan:0x" << hex << uppercase << trkno
+                   << "_ID:0x" << static_cast<unsigned short>(ev.evcode) << nouppercase;
+            for( const auto & param : ev.params )
+                evmark << ", 0x" << hex << uppercase << static_cast<unsigned short>(param) << nouppercase;
+            out.PutText( state.ticks_, SMF_MetaMarker, evmark.str() );
+
+            m_unhandledEvList[ev.evcode] += 1;
+        }
+
+        void WriteUnhandledEventsReport()
+        {
+            if( m_unhandledEvList.empty() || !utils::LibWide().isLogOn() )
+                return;
+
+            clog <<"<!>- Ingored the following unsupported events: \n";
+            for( const auto & ev : m_unhandledEvList )
+            {
+                clog << "\tEventID: 0x" <<hex <<uppercase <<static_cast<unsigned short>(ev.first) <<dec <<nouppercase
+                     <<", ignored " <<ev.second << " times.\n";
+            }
+        }
+
+        static void PutBankChange( SMFTrackBuffer & out, uint8_t chan, uint32_t tick, bankid_t bank )
+        {
+            out.PutChannelMsg( tick, SMF_StatusCtrlChg | chan, SMF_CC_BankMSB, static_cast<uint8_t>( bank & 0x7F ) );
+            out.PutChannelMsg( tick, SMF_StatusCtrlChg | chan, SMF_CC_BankLSB, static_cast<uint8_t>( (bank >> 8) & 0x7F ) );
+        }
+
+    private:
+        const MusicSequence            & m_seq;
+        const SMDLPresetConversionInfo * m_convtable;
+        eMIDIMode                        m_midimode;
+        uint32_t                         m_nbloops;
+        bool                             m_bLoopBegSet;
+        bool                             m_bTrackLoopable;
+
+        vector<TrkState>                 m_trkstates;
+        vector<TrkState>                 m_beflooptrkstates; //Saved states of each tracks just before the loop point event
+        vector<ActiveNotes>              m_notes;
+        map<uint8_t, int>                m_unhandledEvList;
+    };
+
+//====================================================================================================
+//  SMFToDSESequence
+//====================================================================================================
+    /*
+        SMFToDSESequence
+            Parses a standard MIDI file straight into DSE events, in a single pass over the bytes.
+            Play note events are reserved when the note on is read, and their duration is filled in
+            once all the track's note offs are known.
+    */
+    class SMFToDSESequence
+    {
+        struct NoteDuration
+        {
+            size_t   evindex;
+            uint32_t duration;
+        };
+
+        struct TrkState
+        {
+            TrkState()
+            {
+                sounding.fill(false);
+                noteslot.fill(0);
+                notestart.fill(0);
+            }
+
+            uint32_t                     ticks        = 0;    //The tick the last event was placed at
+            uint32_t                     lastpause    = 0;
+            int                          octave       = -1;   //-1 means no octave was set yet
+            bool                         haschan      = false;
+            bool                         looppointset = false;
+            bool                         ended        = false;
+            uint8_t                      rpnmsb       = 0x7F;
+            uint8_t                      rpnlsb       = 0x7F;
+            array<bool,     NbMidiKeys>  sounding;
+            array<size_t,   NbMidiKeys>  noteslot;
+            array<uint32_t, NbMidiKeys>  notestart;
+            vector<NoteDuration>         durations;
+        };
+
+    public:
+        SMFToDSESequence( const uint8_t * itbeg, const uint8_t * itend, const string & seqname )
+            :m_itbeg(itbeg), m_itend(itend), m_seqname(seqname), m_format(0), m_hasloop(false), m_looptick(0)
+        {}
+
+        MusicSequence operator()()
+        {
+            const uint8_t * itcur = m_itbeg;
+
+            //#1 - Header
+            if( std::distance(itcur, m_itend) < static_cast<ptrdiff_t>(SMF_HeaderLen + 2 * sizeof(uint32_t)) )
+                throw runtime_error("ParseSMF(): File is too small to be a MIDI file!");
+
+            uint32_t magic  = 0;
+            uint32_t hdrlen = 0;
+            uint16_t nbtrks = 0;
+            uint16_t tpqn   = 0;
+            itcur = utils::ReadIntFromBytes( magic,    itcur, m_itend, false );
+            itcur = utils::ReadIntFromBytes( hdrlen,   itcur, m_itend, false );
+            if( magic != SMF_MagicHeader || hdrlen < SMF_HeaderLen || hdrlen > static_cast<size_t>(std::distance(itcur, m_itend)) )
+                throw runtime_error("ParseSMF(): Not a standard MIDI file!");
+
+            const uint8_t * ithdrend = itcur + hdrlen;
+            itcur = utils::ReadIntFromBytes( m_format, itcur, m_itend, false );
+            itcur = utils::ReadIntFromBytes( nbtrks,   itcur, m_itend, false );
+            itcur = utils::ReadIntFromBytes( tpqn,     itcur, m_itend, false );
+            itcur = ithdrend;
+
+            if( m_format > 1 )
+                throw runtime_error("ParseSMF(): MIDI format 2 is not supported!");
+            if( (tpqn & 0x8000) != 0 )
+                throw runtime_error("ParseSMF(): SMPTE time division is not supported!");
+
+            m_meta.fname = m_seqname;
+            m_meta.tpqn  = tpqn;
+            m_meta.createtime.SetTimeToNow();
+
+            //#2 - Setup the destination tracks
+            const size_t nbdsetrks = (m_format == 0)? NB_DSETracks : std::min<size_t>( nbtrks, NB_DSETracks );
+            m_tracks.resize(nbdsetrks);
+            m_states.resize(nbdsetrks);
+            for( size_t i = 0; i < nbdsetrks; ++i )
+                m_tracks[i].SetMidiChannel( (m_format == 0 && i > 0)? static_cast<uint8_t>(i - 1) : 0 );
+
+            if( utils::LibWide().isLogOn() )
+            {
+                clog << "MIDI loaded! :\n"
+                     << "\t\t" << "Format   : " <<m_format <<"\n"
+                     << "\t\t" << "NbTracks : " <<nbtrks   <<"\n"
+                     << "\t\t" << "TPQN     : " <<tpqn     <<"\n";
+            }
+
+            //#3 - Stream through the chunks
+            size_t cnttrk = 0;
+            while( std::distance(itcur, m_itend) >= static_cast<ptrdiff_t>(2 * sizeof(uint32_t)) )
+            {
+                uint32_t chunkid  = 0;
+                uint32_t chunklen = 0;
+                itcur = utils::ReadIntFromBytes( chunkid,  itcur, m_itend, false );
+                itcur = utils::ReadIntFromBytes( chunklen, itcur, m_itend, false );
+                if( chunklen > static_cast<size_t>(std::distance(itcur, m_itend)) )
+                    throw runtime_error("ParseSMF(): Chunk goes past the end of the file!");
+
+                const uint8_t * itchunkend = itcur + chunklen;
+                if( chunkid == SMF_MagicTrack )
+                {
+                    if( m_format == 0 || cnttrk < nbdsetrks )
+                        ParseTrack( itcur, itchunkend, cnttrk );
+                    else
+                        clog << "<!>- ParseSMF(): Ignored MIDI track #" <<cnttrk <<", because DSE only supports up to " <<NB_DSETracks <<" tracks!\n";
+                    ++cnttrk;
+                }
+                itcur = itchunkend; //Unknown chunks are skipped
+            }
+
+            //#4 - Fill in the notes durations
+            for( size_t i = 0; i < m_tracks.size(); ++i )
+                FinalizeNotes( m_tracks[i], m_states[i] );
+
+            return MusicSequence( std::move(m_tracks), std::move(m_meta) );
+        }
+
+    private:
+
+        static uint32_t ReadVarLen( const uint8_t *& itcur, const uint8_t * itend )
+        {
+            uint32_t value = 0;
+            for( int cnt = 0; cnt < 4; ++cnt )
+            {
+                if( itcur == itend )
+                    throw runtime_error("ParseSMF(): Unexpected end of track while reading a variable length value!");
+                const uint8_t by = *(itcur++);
+                value = (value << 7) | (by & 0x7F);
+                if( (by & 0x80) == 0 )
+                    return value;
+            }
+            throw runtime_error("ParseSMF(): Variable length value is longer than 4 bytes!");
+        }
+
+        /****************************************************************************************
+            ParseTrack
+                Reads the events of a single MTrk chunk, and dispatch them to the DSE tracks.
+        ****************************************************************************************/
+        void ParseTrack( const uint8_t * itcur, const uint8_t * itend, size_t mtrkno )
+        {
+            uint32_t tick      = 0;
+            uint8_t  runstatus = 0;
+
+            while( itcur != itend )
+            {
+                tick += ReadVarLen( itcur, itend );
+                if( itcur == itend )
+                    throw runtime_error("ParseSMF(): Unexpected end of track after a delta-time!");
+
+                uint8_t status = *itcur;
+                if( (status & 0x80) != 0 )
+                    ++itcur;
+                else if( runstatus != 0 )
+                    status = runstatus;
+                else
+                    throw runtime_error("ParseSMF(): Got running status data without a previous status byte!");
+
+                if( status == SMF_StatusMeta )
+                {
+                    if( itcur == itend )
+                        throw runtime_error("ParseSMF(): Unexpected end of track in a meta-event!");
+                    const uint8_t  metatype = *(itcur++);
+                    const uint32_t len      = ReadVarLen( itcur, itend );
+                    if( len > static_cast<size_t>(std::distance(itcur, itend)) )
+                        throw runtime_error("ParseSMF(): Meta-event goes past the end of the track!");
+                    runstatus = 0;
+
+                    if( metatype == SMF_MetaEoT )
+                        break;
+                    HandleMeta( tick, mtrkno, metatype, itcur, len );
+                    itcur += len;
+                }
+                else if( status == SMF_StatusSysEx || status == SMF_StatusSysExEsc )
+                {
+                    const uint32_t len = ReadVarLen( itcur, itend );
+                    if( len > static_cast<size_t>(std::distance(itcur, itend)) )
+                        throw runtime_error("ParseSMF(): SysEx goes past the end of the track!");
+                    itcur    += len;
+                    runstatus = 0;
+                }
+                else
+                {
+                    const uint8_t msgty  = status & 0xF0;
+                    const size_t  nbdata = (msgty == SMF_StatusPrgmChg || msgty == SMF_StatusChanPres)? 1 : 2;
+                    if( static_cast<size_t>(std::distance(itcur, itend)) < nbdata )
+                        throw runtime_error("ParseSMF(): Unexpected end of track in a channel message!");
+
+                    const uint8_t data1 = *(itcur++) & 0x7F;
+                    const uint8_t data2 = (nbdata == 2)? (*(itcur++) & 0x7F) : 0;
+                    runstatus = status;
+
+                    //Format 0 splits the channels into tracks, skipping track 0 since its for tempo events!
+                    const size_t dsetrk = (m_format == 0)? (status & 0x0F) + 1 : mtrkno;
+                    HandleChannelMsg( tick, status, data1, data2, m_tracks[dsetrk], m_states[dsetrk] );
+                }
+            }
+
+            //Close the tracks fed by this MTrk
+            if( m_format == 0 )
+            {
+                for( size_t i = 0; i < m_tracks.size(); ++i )
+                    EndTrack( tick, m_tracks[i], m_states[i] );
+            }
+            else
+                EndTrack( tick, m_tracks[mtrkno], m_states[mtrkno] );
+        }
+
+        /****************************************************************************************
+            HandleChannelMsg
+        ****************************************************************************************/
+        void HandleChannelMsg( uint32_t tick, uint8_t status, uint8_t data1, uint8_t data2, MusicTrack & trk, TrkState & state )
+        {
+            const uint8_t msgty = status & 0xF0;
+            if( !state.haschan )
+            {
+                trk.SetMidiChannel( status & 0x0F );
+                state.haschan = true;
+            }
+
+            if( msgty == SMF_StatusNoteOn && data2 != 0 )
+                HandleNoteOn( tick, data1, data2, trk, state );
+            else if( msgty == SMF_StatusNoteOn || msgty == SMF_StatusNoteOff )
+                HandleNoteOff( tick, data1, state );
+            else if( msgty == SMF_StatusCtrlChg )
+            {
+                switch(data1)
+                {
+                    case SMF_CC_Volume:
+                        InsertEvent( tick, trk, state, eTrkEventCodes::SetTrkVol, {data2} );
+                        break;
+                    case SMF_CC_Expression:
+                        InsertEvent( tick, trk, state, eTrkEventCodes::SetExpress, {data2} );
+                        break;
+                    case SMF_CC_Pan:
+                        InsertEvent( tick, trk, state, eTrkEventCodes::SetTrkPan, {data2} );
+                        break;
+                    case SMF_CC_RPN_MSB:
+                        state.rpnmsb = data2;
+                        break;
+                    case SMF_CC_RPN_LSB:
+                        state.rpnlsb = data2;
+                        break;
+                    case SMF_CC_DataEntry:
+                    {
+                        if( state.rpnmsb == 0 && state.rpnlsb == 0 )
+                            InsertEvent( tick, trk, state, eTrkEventCodes::SetPitchBendRng, {data2} );
+                        break;
+                    }
+                    default:
+                        break; //Bank select, and anything DSE can't do
+                };
+            }
+            else if( msgty == SMF_StatusPrgmChg )
+                InsertEvent( tick, trk, state, eTrkEventCodes::SetPreset, {data1} );
+            else if( msgty == SMF_StatusBend )
+            {
+                const int16_t bend = static_cast<int16_t>( ((static_cast<int>(data2) << 7) | data1) - SMF_BendCenter );
+                InsertEvent( tick, trk, state, eTrkEventCodes::SetPitchBend,
+                             { static_cast<uint8_t>(static_cast<uint16_t>(bend) >> 8), static_cast<uint8_t>(bend & 0xFF) } );
+            }
+        }
+
+        void HandleNoteOn( uint32_t tick, uint8_t note, uint8_t vel, MusicTrack & trk, TrkState & state )
+        {
+            if( state.sounding[note] )
+                HandleNoteOff( tick, note, state );
+
+            PadToTick( tick, trk, state );
+
+            const int targetoctave = note / NbKeysInOctave;
+            int       octdiff      = targetoctave - state.octave;
+            if( state.octave < 0 || octdiff < -NoteEvOctaveShiftRange || octdiff >= NoteEvOctaveShiftRange )
+            {
+                TrkEvent octev;
+                octev.evcode = static_cast<uint8_t>(eTrkEventCodes::SetOctave);
+                octev.params.push_back( static_cast<uint8_t>(targetoctave) );
+                trk.getEvents().push_back( std::move(octev) );
+                octdiff = 0;
+            }
+            state.octave = targetoctave;
+
+            //The nb of duration bytes is set once the durations of all notes are known
+            TrkEvent noteev;
+            noteev.evcode = vel & 0x7F;
+            noteev.params.push_back( static_cast<uint8_t>( (((octdiff + NoteEvOctaveShiftRange) & 0x3) << 4) | (note % NbKeysInOctave) ) );
+            state.sounding [note] = true;
+            state.noteslot [note] = trk.size();
+            state.notestart[note] = tick;
+            trk.getEvents().push_back( std::move(noteev) );
+        }
+
+        void HandleNoteOff( uint32_t tick, uint8_t note, TrkState & state )
+        {
+            if( !state.sounding[note] )
+            {
+                if( utils::LibWide().isLogOn() && utils::LibWide().isVerboseOn() )
+                    clog <<tick << " - MIDI NoteOff event not preceeded by a NoteOn!\n";
+                return;
+            }
+            state.durations.push_back( NoteDuration{ state.noteslot[note], tick - state.notestart[note] } );
+            state.sounding[note] = false;
+        }
+
+        /****************************************************************************************
+            HandleMeta
+        ****************************************************************************************/
+        void HandleMeta( uint32_t tick, size_t mtrkno, uint8_t metatype, const uint8_t * pdata, uint32_t len )
+        {
+            if( metatype == SMF_MetaTempo && len == 3 )
+            {
+                const uint32_t mpqn   = (static_cast<uint32_t>(pdata[0]) << 16) | (static_cast<uint32_t>(pdata[1]) << 8) | pdata[2];
+                const uint32_t bpm    = (mpqn != 0)? utils::Clamp<uint32_t>( ConvertMicrosecPerQuarterNoteToBPM(mpqn), 1, 255 ) : 120;
+                const size_t   dsetrk = (m_format == 0)? 0 : mtrkno;
+                InsertEvent( tick, m_tracks[dsetrk], m_states[dsetrk], eTrkEventCodes::SetTempo, {static_cast<uint8_t>(bpm)} );
+            }
+            else if( metatype == SMF_MetaMarker )
+            {
+                const string txt( reinterpret_cast<const char*>(pdata), len );
+                if( txt == TXT_LoopStart )
+                {
+                    m_hasloop  = true;
+                    m_looptick = tick;
+                }
+                else if( txt.compare( 0, TXT_DSE_Event.size(), TXT_DSE_Event ) == 0 )
+                    HandleDSEEventMarker( tick, mtrkno, txt );
+            }
+        }
+
+        /****************************************************************************************
+            HandleDSEEventMarker
+                Parse the text of a marker containing a DSE event that has no MIDI equivalent.
+        ****************************************************************************************/
+        void HandleDSEEventMarker( uint32_t tick, size_t mtrkno, const string & evtxt )
+        {
+            vector<uint32_t> values;
+            for( size_t pos = evtxt.find("0x"); pos != string::npos; pos = evtxt.find("0x", pos + 2) )
+                values.push_back( static_cast<uint32_t>( strtoul( evtxt.c_str() + pos, nullptr, 16 ) ) );
+
+            if( values.size() < 2 )
+            {
+                clog << "<!>- Ignored text DSE event because it was lacking a channel ID or/and even ID!! :\n"
+                     << "\t" <<evtxt <<"\n";
+                return;
+            }
+
+            //In format 1 each DSE track has its own MIDI track, so the event goes where it was found
+            const size_t dsetrk = (m_format == 0)? values[0] : mtrkno;
+            if( dsetrk >= m_tracks.size() )
+            {
+                clog << "<!>- Ignored text DSE event because channel/track specified was invalid!! (" <<values[0] <<") :\n"
+                     << "\t" <<evtxt <<"\n";
+                return;
+            }
+
+            vector<uint8_t> params;
+            for( size_t i = 2; i < values.size(); ++i )
+                params.push_back( static_cast<uint8_t>(values[i]) );
+
+            //SetSwdl and SetBank are track-wide 90% of the time, so put them in the meta-data too
+            if( values[1] == static_cast<uint8_t>(eTrkEventCodes::SetSwdl) && params.size() == 1 && m_meta.unk1 == 0 )
+                m_meta.unk1 = params.front();
+            else if( values[1] == static_cast<uint8_t>(eTrkEventCodes::SetBank) && params.size() == 1 && m_meta.unk2 == 0 )
+                m_meta.unk2 = params.front();
+
+            InsertEvent( tick, m_tracks[dsetrk], m_states[dsetrk], static_cast<eTrkEventCodes>(values[1]), std::move(params) );
+        }
+
+        /****************************************************************************************
+            EndTrack
+                Pads the track to the end tick, and puts the end of track event.
+        ****************************************************************************************/
+        void EndTrack( uint32_t tick, MusicTrack & trk, TrkState & state )
+        {
+            if( state.ended )
+                return;
+
+            //Release held notes
+            for( size_t note = 0; note < NbMidiKeys; ++note )
+            {
+                if( state.sounding[note] )
+                    HandleNoteOff( tick, static_cast<uint8_t>(note), state );
+            }
+
+            if( !trk.empty() )
+                PadToTick( tick, trk, state );
+
+            TrkEvent eot;
+            eot.evcode = static_cast<uint8_t>(eTrkEventCodes::EndOfTrack);
+            trk.getEvents().push_back( std::move(eot) );
+            state.ended = true;
+        }
+
+        /****************************************************************************************
+            FinalizeNotes
+                Write the duration of each play note events, in the order they are played,
+                so the duration can be omitted when its the same as the previous note's.
+        ****************************************************************************************/
+        static void FinalizeNotes( MusicTrack & trk, TrkState & state )
+        {
+            std::sort( state.durations.begin(), state.durations.end(),
+                       []( const NoteDuration & a, const NoteDuration & b ){ return a.evindex < b.evindex; } );
+
+            uint32_t lasthold = 0;
+            for( const auto & note : state.durations )
+            {
+                TrkEvent & ev  = trk[note.evindex];
+                uint32_t   dur = std::min<uint32_t>( note.duration, 0xFFFFFF );
+                if( dur == lasthold )
+                    continue;
+
+                const uint8_t nbbytes = (dur > 0xFFFF)? 3 : (dur > 0xFF)? 2 : 1;
+                ev.params.front() |= (nbbytes << 6);
+                for( int cntby = nbbytes - 1; cntby >= 0; --cntby )
+                    ev.params.push_back( static_cast<uint8_t>( dur >> (cntby * 8) ) );
+                lasthold = dur;
+            }
+            state.durations.clear();
+        }
+
+        /****************************************************************************************
+            InsertEvent
+                Pads the track up to the tick specified and append the event.
+        ****************************************************************************************/
+        void InsertEvent( uint32_t tick, MusicTrack & trk, TrkState & state, eTrkEventCodes code, vector<uint8_t> && params )
+        {
+            if( state.ended )
+                return;
+            PadToTick( tick, trk, state );
+            TrkEvent ev;
+            ev.evcode = static_cast<uint8_t>(code);
+            ev.params = std::move(params);
+            trk.getEvents().push_back( std::move(ev) );
+        }
+
+        /****************************************************************************************
+            PadToTick
+                Inserts pauses until the track reaches the tick specified.
+                Also puts the loop point event when the track crosses it.
+        ****************************************************************************************/
+        void PadToTick( uint32_t tick, MusicTrack & trk, TrkState & state )
+        {
+            if( m_hasloop && !state.looppointset && tick >= m_looptick )
+            {
+                InsertPause( m_looptick, trk, state );
+                TrkEvent loopev;
+                loopev.evcode = static_cast<uint8_t>(eTrkEventCodes::LoopPointSet);
+                trk.getEvents().push_back( std::move(loopev) );
+                state.looppointset = true;
+            }
+            InsertPause( tick, trk, state );
+        }
+
+        static void InsertPause( uint32_t tick, MusicTrack & trk, TrkState & state )
+        {
+            while( tick > state.ticks )
+            {
+                const uint32_t delta = std::min<uint32_t>( tick - state.ticks, 0xFFFFFF );
+                TrkEvent       pauseev;
+                auto           itfound = TicksToTrkDelayID.end();
+
+                if( delta <= static_cast<uint8_t>(eTrkDelays::_half) )
+                    itfound = TicksToTrkDelayID.find( static_cast<uint8_t>(delta) );
+
+                if( itfound != TicksToTrkDelayID.end() )
+                    pauseev.evcode = TrkDelayToEvID.at(itfound->second);
+                else if( delta == state.lastpause )
+                    pauseev.evcode = static_cast<uint8_t>(eTrkEventCodes::RepeatLastPause);
+                else if( delta <= 0xFF )
+                {
+                    pauseev.evcode = static_cast<uint8_t>(eTrkEventCodes::Pause8Bits);
+                    pauseev.params.push_back( static_cast<uint8_t>(delta) );
+                }
+                else if( delta <= 0xFFFF )
+                {
+                    pauseev.evcode = static_cast<uint8_t>(eTrkEventCodes::Pause16Bits);
+                    pauseev.params.push_back( static_cast<uint8_t>(delta) );
+                    pauseev.params.push_back( static_cast<uint8_t>(delta >> 8) );
+                }
+                else
+                {
+                    pauseev.evcode = static_cast<uint8_t>(eTrkEventCodes::Pause24Bits);
+                    pauseev.params.push_back( static_cast<uint8_t>(delta) );
+                    pauseev.params.push_back( static_cast<uint8_t>(delta >> 8) );
+                    pauseev.params.push_back( static_cast<uint8_t>(delta >> 16) );
+                }
+
+                trk.getEvents().push_back( std::move(pauseev) );
+                state.lastpause = delta;
+                state.ticks    += delta;
+            }
+        }
+
+    private:
+        const uint8_t      * m_itbeg;
+        const uint8_t      * m_itend;
+        string               m_seqname;
+        uint16_t             m_format;
+        bool                 m_hasloop;
+        uint32_t             m_looptick;
+        DSE_MetaDataSMDL     m_meta;
+        vector<MusicTrack>   m_tracks;
+        vector<TrkState>     m_states;
+    };
+
+//====================================================================================================
+//  Functions
+//====================================================================================================
+    std::vector<uint8_t> SequenceToSMFData( const MusicSequence            & seq,
+                                            const SMDLPresetConversionInfo * premap,
+                                            int                              nbloop,
+                                            eMIDIMode                        midmode )
+    {
+        if( midmode == eMIDIMode::GM )
+            throw std::runtime_error("SequenceToSMFData(): GM mode is not supported by the direct MIDI writer!");
+        if( nbloop < 0 )
+        {
+            stringstream sstr;
+            sstr << "SequenceToSMFData(): Invalid number of loops " <<nbloop <<" ! The loop count can't be negative!";
+            throw std::runtime_error(sstr.str());
+        }
+        return DSESequenceToSMF( seq, premap, midmode, static_cast<uint32_t>(nbloop) )();
+    }
+
+    void SequenceToSMF( const std::string              & outmidi,
+                        const MusicSequence            & seq,
+                        const SMDLPresetConversionInfo * premap,
+                        int                              nbloop,
+                        eMIDIMode                        midmode )
+    {
+        const vector<uint8_t> data = SequenceToSMFData( seq, premap, nbloop, midmode );
+        ofstream              outf( outmidi, ios::out | ios::binary );
+
+        if( !outf.is_open() || !outf.write( reinterpret_cast<const char*>(data.data()), data.size() ) )
+        {
+            stringstream sstr;
+            sstr << "SequenceToSMF(): Couldn't write to file " <<outmidi <<" !";
+            throw std::runtime_error(sstr.str());
+        }
+    }
+
+    MusicSequence ParseSMF( const uint8_t * itbeg, const uint8_t * itend, const std::string & seqname )
+    {
+        return SMFToDSESequence( itbeg, itend, seqname )();
+    }
+
+    MusicSequence SMFToSequence( const std::string & inmidi )
+    {
+        utils::io::MappedFile midfile(inmidi);
+        return ParseSMF( midfile.begin(), midfile.end(), utils::GetBaseNameOnly(inmidi) );
+    }
+};
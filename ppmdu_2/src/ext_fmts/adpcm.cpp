@@ -1,11 +1,15 @@
 #include <ext_fmts/adpcm.hpp>
 #include <utils/audio_utilities.hpp>
 #include <utils/utility.hpp>
+#include <utils/parallel_tasks.hpp>
+#include <utils/library_wide.hpp>
 #include <vector>
 #include <array>
 #include <cstdint>
 #include <algorithm>
 #include <cassert>
+#include <cmath>
+#include <limits>
 #include <fstream>
 #include <iostream>
 
@@ -493,20 +497,303 @@ namespace audio
 //==============================================================================================
 // IMA ADPCM Encoder
 //==============================================================================================
+    /*
+        ADPCM_EncoderState
+            The state of the decoder the encoder is trying to stay in sync with.
+            Every nibble picked by the encoders is run through StepState, so the encoded
+            stream reproduces exactly what the decoder will output.
+    */
+    template<class _ADPCM_Trait>
+        struct ADPCM_EncoderState
+    {
+        typedef _ADPCM_Trait mytrait;
+        int32_t predictor = 0;
+        int32_t stepindex = 0;
+
+        //Same math as the decoders' ParseSample
+        inline int16_t StepState( uint8_t smpl )
+        {
+            const int32_t step = mytrait::StepSizes[stepindex];
+            int32_t       diff = step >> 3;
+
+            if (smpl & 1)
+                diff += ( step >> 2 );
+            if (smpl & 2)
+                diff += ( step >> 1 );
+            if (smpl & 4)
+                diff += step;
+            if (smpl & 8)
+                predictor = mytrait::ClampPredictor( predictor - diff );
+            else
+                predictor = mytrait::ClampPredictor( predictor + diff );
+
+            stepindex = mytrait::ClampStepIndex( stepindex + mytrait::IndexTable[smpl] );
+            return static_cast<int16_t>(predictor);
+        }
+
+        //The standard IMA quantization of the difference to the next sample
+        inline uint8_t PickNibble( int32_t sample )const
+        {
+            int32_t diff = sample - predictor;
+            int32_t step = mytrait::StepSizes[stepindex];
+            uint8_t nib  = 0;
+
+            if( diff < 0 )
+            {
+                nib  = 8;
+                diff = -diff;
+            }
+            if( diff >= step )
+            {
+                nib  |= 4;
+                diff -= step;
+            }
+            step >>= 1;
+            if( diff >= step )
+            {
+                nib  |= 2;
+                diff -= step;
+            }
+            step >>= 1;
+            if( diff >= step )
+                nib |= 1;
+            return nib;
+        }
+    };
+
+    /*
+        GuessInitialStepIndex
+            Pick a starting step index matching the average slope of the first few samples,
+            so the encoder doesn't waste the start of the sample ramping the step size up.
+    */
+    template<class _ADPCM_Trait, class _init>
+        int32_t GuessInitialStepIndex( _init itbeg, _init itend, size_t stride = 1 )
+    {
+        static const size_t NbSmplsToCheck = 8;
+        int64_t sumdelta = 0;
+        size_t  cnt      = 0;
+        if( itbeg == itend )
+            return 0;
+
+        int32_t prev = *itbeg;
+        while( cnt < NbSmplsToCheck && std::distance(itbeg, itend) > static_cast<ptrdiff_t>(stride) )
+        {
+            std::advance(itbeg, stride);
+            sumdelta += std::abs( static_cast<int32_t>(*itbeg) - prev );
+            prev      = *itbeg;
+            ++cnt;
+        }
+        if( cnt == 0 )
+            return 0;
+
+        const int32_t avgdelta = static_cast<int32_t>(sumdelta / cnt);
+        auto itfound = std::lower_bound( _ADPCM_Trait::StepSizes.begin(), _ADPCM_Trait::StepSizes.end(), avgdelta );
+        return _ADPCM_Trait::ClampStepIndex( static_cast<int32_t>( std::distance(_ADPCM_Trait::StepSizes.begin(), itfound) ) );
+    }
 
-    class IMA_ADPCM_Encoder
+    /*
+        IMA_ADPCM_Encoder
+            Greedy encoder. Picks for each sample the nibble that gets the predictor the closest
+            to the sample, without considering what comes after.
+            Handles interleaved multi-channel data the same way IMA_APCM_Decoder reads it.
+    */
+    template<class _ADPCM_Trait>
+        class IMA_ADPCM_Encoder
     {
+        typedef ADPCM_EncoderState<_ADPCM_Trait> state_t;
     public:
         IMA_ADPCM_Encoder( const vector<int16_t> & samples, unsigned int nbchannels = 1 )
+            :m_samples(samples), m_chan( (nbchannels != 0)? nbchannels : 1 )
         {}
 
         operator vector<uint8_t>()
         {
-            assert(false); //#TODO: Implement me !
-            return vector<uint8_t>();
+            return DoEncode();
+        }
+
+    private:
+        vector<uint8_t> DoEncode()
+        {
+            vector<uint8_t> result;
+            result.reserve( (m_chan.size() * IMA_ADPCM_PreambleLen) + (m_samples.size() / 2) + 1 );
+            auto itout = back_inserter(result);
+
+            //Write the preamble for each channels
+            for( size_t cntchan = 0; cntchan < m_chan.size(); ++cntchan )
+            {
+                state_t & ach = m_chan[cntchan];
+                if( cntchan < m_samples.size() )
+                {
+                    ach.predictor = m_samples[cntchan];
+                    ach.stepindex = GuessInitialStepIndex<_ADPCM_Trait>( m_samples.begin() + cntchan, m_samples.end(), m_chan.size() );
+                }
+                itout = WriteIntToBytes( static_cast<int16_t>(ach.predictor), itout );
+                itout = WriteIntToBytes( static_cast<int16_t>(ach.stepindex), itout );
+            }
+
+            //Encode the samples, 2 per bytes, low nibble first
+            uint8_t curbyte = 0;
+            for( size_t cntsmpl = 0; cntsmpl < m_samples.size(); ++cntsmpl )
+            {
+                state_t & ach = m_chan[cntsmpl % m_chan.size()];
+                uint8_t   nib = ach.PickNibble( m_samples[cntsmpl] );
+                ach.StepState(nib);
+
+                if( (cntsmpl & 1) == 0 )
+                    curbyte = nib;
+                else
+                    result.push_back( static_cast<uint8_t>( curbyte | (nib << 4) ) );
+            }
+            if( (m_samples.size() & 1) != 0 )
+                result.push_back(curbyte);
+            return result;
         }
 
     private:
+        const vector<int16_t> & m_samples;
+        vector<state_t>         m_chan;
+    };
+
+    /*
+        IMA_ADPCM_TrellisEncoder
+            Mono encoder that keeps several candidate decoder states alive for each sample and
+            only commits a nibble once it has looked "lookahead" samples past it.
+            The candidate with the lowest accumulated squared error wins.
+
+            The node count bounds the width of the search, the lookahead bounds its depth,
+            so the memory used doesn't depend on the length of the sample.
+    */
+    template<class _ADPCM_Trait>
+        class IMA_ADPCM_TrellisEncoder
+    {
+        typedef ADPCM_EncoderState<_ADPCM_Trait> state_t;
+        static constexpr unsigned int MaxLookahead = 32;
+        static const int32_t      NibRange     = 2; //How far from the greedy nibble's magnitude we look
+
+        struct node_t
+        {
+            uint64_t                          ssd = 0;  //Sum of the squared errors on the path
+            state_t                           state;
+            std::array<uint8_t, MaxLookahead> hist;     //Ring buffer of the uncommitted nibbles
+        };
+
+    public:
+        IMA_ADPCM_TrellisEncoder( const vector<int16_t> & samples, unsigned int lookahead, unsigned int nbnodes )
+            :m_samples(samples), 
+             m_lookahead( std::clamp<unsigned int>(lookahead, 1, MaxLookahead) ),
+             m_nbnodes( std::max<unsigned int>(nbnodes, 1) )
+        {}
+
+        operator vector<uint8_t>()
+        {
+            return DoEncode();
+        }
+
+    private:
+        vector<uint8_t> DoEncode()
+        {
+            vector<uint8_t> nibbles;
+            nibbles.reserve(m_samples.size());
+
+            //Init with the preamble state
+            state_t initstate;
+            if( !m_samples.empty() )
+            {
+                initstate.predictor = m_samples.front();
+                initstate.stepindex = GuessInitialStepIndex<_ADPCM_Trait>( m_samples.begin(), m_samples.end() );
+            }
+            vector<node_t> nodes(1);
+            nodes.front().state = initstate;
+            vector<node_t> candidates;
+            candidates.reserve( m_nbnodes * ((NibRange * 2 + 1) + 2) );
+
+            size_t committed = 0;
+            for( size_t cntsmpl = 0; cntsmpl < m_samples.size(); ++cntsmpl )
+            {
+                const int32_t smpl = m_samples[cntsmpl];
+                const size_t  slot = cntsmpl % m_lookahead;
+                candidates.resize(0);
+
+                for( const node_t & curnode : nodes )
+                {
+                    const uint8_t greedy = curnode.state.PickNibble(smpl);
+                    const uint8_t sign   = greedy & 8;
+                    const int32_t mag    = greedy & 7;
+                    for( int32_t trymag = std::max(0, mag - NibRange); trymag <= std::min(7, mag + NibRange); ++trymag )
+                        TryNibble( curnode, static_cast<uint8_t>(sign | trymag), smpl, slot, candidates );
+
+                    //Near zero the sign matters more than the magnitude
+                    if( mag <= 1 )
+                    {
+                        TryNibble( curnode, static_cast<uint8_t>( (sign ^ 8) | 0 ), smpl, slot, candidates );
+                        TryNibble( curnode, static_cast<uint8_t>( (sign ^ 8) | 1 ), smpl, slot, candidates );
+                    }
+                }
+                KeepBestNodes( candidates, nodes );
+
+                //Commit the oldest nibble once the lookahead is full, and drop the nodes that disagree with it
+                if( (cntsmpl + 1 - committed) == m_lookahead )
+                {
+                    const size_t  oldslot = committed % m_lookahead;
+                    const uint8_t chosen  = nodes.front().hist[oldslot];
+                    nibbles.push_back(chosen);
+                    nodes.erase( std::remove_if( nodes.begin(), nodes.end(), [&](const node_t & n){ return n.hist[oldslot] != chosen; } ), nodes.end() );
+                    ++committed;
+                }
+            }
+
+            //Flush what's left on the best path
+            for( ; committed < m_samples.size(); ++committed )
+                nibbles.push_back( nodes.front().hist[committed % m_lookahead] );
+
+            //Write the preamble + packed nibbles
+            vector<uint8_t> result;
+            result.reserve( IMA_ADPCM_PreambleLen + (nibbles.size() / 2) + 1 );
+            auto itout = back_inserter(result);
+            itout = WriteIntToBytes( static_cast<int16_t>(initstate.predictor), itout );
+            itout = WriteIntToBytes( static_cast<int16_t>(initstate.stepindex), itout );
+            for( size_t cntnib = 0; cntnib < nibbles.size(); cntnib += 2 )
+            {
+                uint8_t curbyte = nibbles[cntnib];
+                if( (cntnib + 1) < nibbles.size() )
+                    curbyte |= static_cast<uint8_t>(nibbles[cntnib + 1] << 4);
+                result.push_back(curbyte);
+            }
+            return result;
+        }
+
+        inline void TryNibble( const node_t & parent, uint8_t nib, int32_t smpl, size_t slot, vector<node_t> & out_candidates )const
+        {
+            node_t        cand = parent;
+            const int64_t err  = static_cast<int64_t>(cand.state.StepState(nib)) - smpl;
+            cand.ssd       += static_cast<uint64_t>(err * err);
+            cand.hist[slot] = nib;
+            out_candidates.push_back(cand);
+        }
+
+        //Keep the m_nbnodes best candidates, merging those that ended up in the same decoder state
+        inline void KeepBestNodes( vector<node_t> & candidates, vector<node_t> & out_nodes )const
+        {
+            std::sort( candidates.begin(), candidates.end(), [](const node_t & a, const node_t & b){ return a.ssd < b.ssd; } );
+            out_nodes.resize(0);
+            for( const node_t & cand : candidates )
+            {
+                auto itsame = std::find_if( out_nodes.begin(), out_nodes.end(), [&](const node_t & n)
+                { 
+                    return n.state.predictor == cand.state.predictor && n.state.stepindex == cand.state.stepindex; 
+                });
+                if( itsame != out_nodes.end() )
+                    continue; //The one already there has a lower error
+                out_nodes.push_back(cand);
+                if( out_nodes.size() >= m_nbnodes )
+                    break;
+            }
+        }
+
+    private:
+        const vector<int16_t> & m_samples;
+        unsigned int            m_lookahead;
+        unsigned int            m_nbnodes;
     };
 
 //==============================================================================================
@@ -522,7 +809,88 @@ namespace audio
     std::vector<uint8_t> EncodeADPCM_IMA( const std::vector<int16_t> & pcmdata,
                                           unsigned int                 nbchannels )
     {
-        return IMA_ADPCM_Encoder(pcmdata,nbchannels);
+        return IMA_ADPCM_Encoder<ADPCM_Trait_IMA>(pcmdata,nbchannels);
+    }
+
+    std::vector<uint8_t> EncodeADPCM_NDS( const std::vector<int16_t> & pcmdata,
+                                          const ADPCMEncoderParams   & params )
+    {
+        //Pad with the last sample so the data ends on a 32 bits boundary, since the DSE counts loop points in words
+        std::vector<int16_t> padded;
+        const std::vector<int16_t> * psmpls = &pcmdata;
+        if( (pcmdata.size() % ADPCM_NDS_SmplAlignment) != 0 )
+        {
+            padded = pcmdata;
+            padded.resize( pcmdata.size() + (ADPCM_NDS_SmplAlignment - (pcmdata.size() % ADPCM_NDS_SmplAlignment)), 
+                           (pcmdata.empty())? 0 : pcmdata.back() );
+            psmpls = &padded;
+        }
+
+        if( params.encoder == eADPCMEncoder::Trellis )
+            return IMA_ADPCM_TrellisEncoder<ADPCM_Trait_NDS>( *psmpls, params.lookahead, params.nbnodes );
+        else
+            return IMA_ADPCM_Encoder<ADPCM_Trait_NDS>( *psmpls, 1 );
+    }
+
+    double ComputeSNR( const std::vector<int16_t> & reference, const std::vector<int16_t> & decoded )
+    {
+        const size_t len      = std::min( reference.size(), decoded.size() );
+        double       signal   = 0.0;
+        double       noise    = 0.0;
+        for( size_t cnt = 0; cnt < len; ++cnt )
+        {
+            const double ref = reference[cnt];
+            const double err = ref - static_cast<double>(decoded[cnt]);
+            signal += ref * ref;
+            noise  += err * err;
+        }
+        if( noise == 0.0 )
+            return std::numeric_limits<double>::infinity();
+        if( signal == 0.0 )
+            return 0.0;
+        return 10.0 * std::log10( signal / noise );
+    }
+
+    std::vector<ADPCMEncodeResult> EncodeADPCM_NDS_Batch( const std::vector<std::vector<int16_t>> & samples,
+                                                          const ADPCMEncoderParams                & params,
+                                                          bool                                      bcomputesnr )
+    {
+        std::vector<ADPCMEncodeResult> results(samples.size());
+        utils::AsyncTaskHandler        taskhandler;
+        std::vector<std::future<void>> taskresults;
+        taskresults.reserve(samples.size());
+
+        //Each task writes only to its own result slot
+        for( size_t cntsmpl = 0; cntsmpl < samples.size(); ++cntsmpl )
+        {
+            utils::AsyncTaskHandler::task_t task( [&samples, &results, &params, bcomputesnr, cntsmpl]()
+            {
+                ADPCMEncodeResult & res = results[cntsmpl];
+                res.data = EncodeADPCM_NDS( samples[cntsmpl], params );
+                if( bcomputesnr )
+                    res.snr = ComputeSNR( samples[cntsmpl], DecodeADPCM_NDS(res.data) );
+            });
+            taskresults.push_back(task.get_future());
+            taskhandler.QueueTask(std::move(task));
+        }
+
+        if( !taskhandler.empty() )
+        {
+            taskhandler.Start();
+            taskhandler.WaitTasksFinished();
+            taskhandler.WaitStop();
+        }
+
+        //Rethrow the first exception a task might have run into
+        for( auto & fut : taskresults )
+            fut.get();
+
+        if( bcomputesnr && utils::LibWide().isLogOn() )
+        {
+            for( size_t cntsmpl = 0; cntsmpl < results.size(); ++cntsmpl )
+                logutil::slog() << "\tADPCM sample #" <<cntsmpl <<", SNR: " <<results[cntsmpl].snr <<" dB\n";
+        }
+        return results;
     }
 
     size_t ADPCMSzToPCM16Sz( size_t adpcmbytesz )
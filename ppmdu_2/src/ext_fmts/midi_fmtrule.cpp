@@ -62,6 +62,11 @@ static const uint32_t MIDI_MagicNum = 0x4D546864;
                 return (utils::ReadIntFromBytes<uint32_t>(itdatabeg, itdataend, false) == MIDI_MagicNum);
             }
 
+            virtual std::vector<uint32_t> getMagicNumbers()const
+            {
+                return { MIDI_MagicNum };
+            }
+
         private:
             cntRID_t m_myID;
         };
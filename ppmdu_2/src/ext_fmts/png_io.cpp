@@ -5,6 +5,7 @@
 #include <utils/handymath.hpp>
 #include <png++/png.hpp>
 #include <iostream>
+#include <sstream>
 using namespace std;
 
 namespace utils{ namespace io
@@ -176,19 +177,9 @@ namespace utils{ namespace io
     }
 
 
-    bool ExportTo4bppPNG( const gimg::tiled_image_i4bpp  & in_indexed,
-                          const std::string              & filepath )
+    png::image<png::index_pixel_4> MakePNG4bpp( const gimg::tiled_image_i4bpp & in_indexed )
     {
         png::image<png::index_pixel_4> output;
-        //png::palette                   palette(in_indexed.getNbColors());
-
-        ////copy palette
-        //for( unsigned int i = 0; i < palette.size(); ++i )
-        //{
-        //    palette[i].red   = in_indexed.getPalette()[i].red;
-        //    palette[i].green = in_indexed.getPalette()[i].green;
-        //    palette[i].blue  = in_indexed.getPalette()[i].blue;
-        //}
         output.set_palette( PalToPngPal(in_indexed.getPalette()) );
 
         //Copy image
@@ -200,10 +191,16 @@ namespace utils{ namespace io
             {
                 auto &  refpixel = in_indexed.getPixel( i, j );
                 uint8_t temp     = static_cast<uint8_t>( refpixel.getWholePixelData() );
-                //output[j][i] = png::index_pixel_4( temp );
                 output.set_pixel( i,j, temp ); //If only one component returns the entire pixel data
             }
         }
+        return output;
+    }
+
+    bool ExportTo4bppPNG( const gimg::tiled_image_i4bpp  & in_indexed,
+                          const std::string              & filepath )
+    {
+        png::image<png::index_pixel_4> output = MakePNG4bpp(in_indexed);
 
         try
         {
@@ -248,8 +245,7 @@ namespace utils{ namespace io
     }
 
 
-    bool ExportTo8bppPNG( const gimg::tiled_image_i8bpp & in_indexed,
-                          const std::string             & filepath )
+    png::image<png::index_pixel> MakePNG8bpp( const gimg::tiled_image_i8bpp & in_indexed )
     {
         png::image<png::index_pixel> output;
         output.set_palette( PalToPngPal(in_indexed.getPalette()) );
@@ -262,6 +258,13 @@ namespace utils{ namespace io
             for( unsigned int j = 0; j < output.get_height(); ++j )
                 output.set_pixel( i,j, static_cast<uint8_t>( in_indexed.getPixel( i, j ).getWholePixelData() ) ); //If only one component returns the entire pixel data
         }
+        return output;
+    }
+
+    bool ExportTo8bppPNG( const gimg::tiled_image_i8bpp & in_indexed,
+                          const std::string             & filepath )
+    {
+        png::image<png::index_pixel> output = MakePNG8bpp(in_indexed);
 
         try
         {
@@ -426,6 +429,33 @@ namespace utils{ namespace io
     }
 
 
+    /*
+        The stream must be passed as its own type, as png++'s std::ostream overload of write_stream calls itself.
+    */
+    template<class _pngimagepixel>
+        std::vector<uint8_t> EncodePNGImage( png::image<_pngimagepixel> & img )
+    {
+        std::ostringstream outstr( std::ios::out | std::ios::binary );
+        img.write_stream( outstr );
+        const std::string encoded = outstr.str();
+        return std::vector<uint8_t>( encoded.begin(), encoded.end() );
+    }
+
+    template<>
+        std::vector<uint8_t> EncodeToPNG( const gimg::tiled_image_i4bpp & in_indexed )
+    {
+        png::image<png::index_pixel_4> output = MakePNG4bpp(in_indexed);
+        return EncodePNGImage(output);
+    }
+
+    template<>
+        std::vector<uint8_t> EncodeToPNG( const gimg::tiled_image_i8bpp & in_indexed )
+    {
+        png::image<png::index_pixel> output = MakePNG8bpp(in_indexed);
+        return EncodePNGImage(output);
+    }
+
+
     template<>
         bool ExportToPNG_AndCrop(   const gimg::tiled_image_i8bpp     & in_indexed,
                                     const std::string                 & filepath,
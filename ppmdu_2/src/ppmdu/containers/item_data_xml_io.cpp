@@ -3,6 +3,7 @@
 #include <utils/pugixml_utils.hpp>
 #include <utils/library_wide.hpp>
 #include <utils/utility.hpp>
+#include <utils/parallel_tasks.hpp>
 #include <pugixml.hpp>
 #include <string>
 #include <iostream>
@@ -82,8 +83,8 @@ namespace pmd2 { namespace stats
     class ItemXMLWriter
     {
     public:
-        ItemXMLWriter( const ItemsDB &src, const GameText * pgtext = nullptr )
-            :m_items(src), m_pgametext(pgtext), m_bNoStrings(false)
+        ItemXMLWriter( const ItemsDB &src, const GameText * pgtext = nullptr, bool bparallel = false )
+            :m_items(src), m_pgametext(pgtext), m_bNoStrings(false), m_bParallel(bparallel)
         {}
 
 
@@ -104,44 +105,59 @@ namespace pmd2 { namespace stats
             }
             
             const string dirprefix = utils::TryAppendSlash( destdir );
-            stringstream fname;
 
-            for( size_t cntitem = 0; cntitem < m_items.size(); ++cntitem )
+            if( m_bParallel )
             {
-                fname.str(string()); //Purge stringstream
-                xml_document doc;
-                xml_node     itemdata = doc.append_child( ROOT_Item.c_str() );
-                bool         isEoS    = m_items[cntitem].Get_EoTD_ItemData() == nullptr;
-
-                if( isEoS )
-                {
-                    AppendAttribute( itemdata, ATTR_GameVer, ATTR_GameVerEoS );
-                    WriteCommentNode( itemdata, CMT_EoS );
-                }
-                else
-                {
-                    AppendAttribute( itemdata, ATTR_GameVer, ATTR_GameVerEoTD );
-                    WriteCommentNode( itemdata, CMT_EoTD );
-                }
+                //Each task gets its own copy of the writer, so the conversion buffers aren't shared
+                utils::RunIndexedTasks( m_items.size(), 
+                                        [this, &dirprefix]( size_t cntitem )
+                                        {
+                                            ItemXMLWriter( *this ).WriteEntry( dirprefix, cntitem );
+                                        },
+                                        "ItemXMLWriter::Write(): Couldn't export some items!" );
+            }
+            else
+            {
+                for( size_t cntitem = 0; cntitem < m_items.size(); ++cntitem )
+                    WriteEntry( dirprefix, cntitem );
+            }
+        }
 
-                if(!m_bNoStrings)
-                    WriteStrings( itemdata, cntitem );
-                WriteCommentNode( itemdata, CMT_Data );
-                _WriteItemData( itemdata, m_items[cntitem] );
+    private:
 
-                MakeFilename( fname, dirprefix, cntitem );
+        void WriteEntry( const string & dirprefix, size_t cntitem )
+        {
+            using namespace itemxml;
+            stringstream fname;
+            xml_document doc;
+            xml_node     itemdata = doc.append_child( ROOT_Item.c_str() );
+            bool         isEoS    = m_items[cntitem].Get_EoTD_ItemData() == nullptr;
 
-                if( ! doc.save_file( fname.str().c_str() ) )
-                {
-                    stringstream strerr;
-                    strerr << "ItemXMLWriter::Write(): Pugixml couldn't write file \"" <<fname.str() <<"\"!";
-                    throw runtime_error(strerr.str());
-                }
+            if( isEoS )
+            {
+                AppendAttribute( itemdata, ATTR_GameVer, ATTR_GameVerEoS );
+                WriteCommentNode( itemdata, CMT_EoS );
+            }
+            else
+            {
+                AppendAttribute( itemdata, ATTR_GameVer, ATTR_GameVerEoTD );
+                WriteCommentNode( itemdata, CMT_EoTD );
             }
 
-        }
+            if(!m_bNoStrings)
+                WriteStrings( itemdata, cntitem );
+            WriteCommentNode( itemdata, CMT_Data );
+            _WriteItemData( itemdata, m_items[cntitem] );
 
-    private:
+            MakeFilename( fname, dirprefix, cntitem );
+
+            if( ! doc.save_file( fname.str().c_str() ) )
+            {
+                stringstream strerr;
+                strerr << "ItemXMLWriter::Write(): Pugixml couldn't write file \"" <<fname.str() <<"\"!";
+                throw runtime_error(strerr.str());
+            }
+        }
 
         stringstream & MakeFilename( stringstream & out_fname, const string & outpathpre, unsigned int cntitem )
         {
@@ -266,6 +282,7 @@ namespace pmd2 { namespace stats
         const ItemsDB                & m_items;
         const GameText               * m_pgametext;
         bool                           m_bNoStrings;
+        bool                           m_bParallel;   //If true, the files are written on several threads
     };
 
     /**********************************************************************
@@ -274,8 +291,8 @@ namespace pmd2 { namespace stats
     class ItemXMLParser
     {
     public:
-        ItemXMLParser( GameText* pgtext )
-            :m_pgametext(pgtext), m_bNoStrings(false)
+        ItemXMLParser( GameText* pgtext, bool bparallel = false )
+            :m_pgametext(pgtext), m_bNoStrings(false), m_bParallel(bparallel)
         {}
 
         ItemsDB Parse( const string & srcdir )
@@ -318,19 +335,12 @@ namespace pmd2 { namespace stats
             resitems.resize(filelst.size());
             auto ititem = resitems.begin();
 
-            for( auto & item : filelst )
-            {
-                xml_document     doc;
-                xml_parse_result loadres = doc.load_file( item.c_str() );
-                if( ! loadres )
-                {
-                    stringstream sstr;
-                    sstr <<"Can't load XML document \"" <<filelst.front() <<"\"! Pugixml returned an error : \"" << loadres.description() <<"\"";
-                    throw std::runtime_error(sstr.str());
-                }
-
-                _ParseItem( doc.first_child(), *ititem, item );
+            //Loading and parsing the documents is the expensive part, so it can be done in parallel
+            vector<unique_ptr<xml_document>> docs = LoadXMLDocuments( filelst, m_bParallel );
 
+            for( size_t cntfile = 0; cntfile < filelst.size(); ++cntfile )
+            {
+                _ParseItem( docs[cntfile]->first_child(), *ititem, filelst[cntfile] );
                 ++ititem;
             }
 
@@ -554,6 +564,7 @@ namespace pmd2 { namespace stats
 
         GameText * m_pgametext;
         bool       m_bNoStrings;
+        bool       m_bParallel;
     };
 
 //=================================================================================
@@ -579,9 +590,10 @@ namespace pmd2 { namespace stats
     //}
     void      ExportItemsToXML     ( const ItemsDB                           & srcitems,
                                      const GameText                          * pgametext,
-                                     const std::string                       & destdir )
+                                     const std::string                       & destdir,
+                                     bool                                      bparallel )
     {
-        ItemXMLWriter(srcitems, pgametext).Write(destdir);
+        ItemXMLWriter(srcitems, pgametext, bparallel).Write(destdir);
     }
 
 
@@ -603,9 +615,10 @@ namespace pmd2 { namespace stats
 
 
     ItemsDB   ImportItemsFromXML   ( const std::string                  & srcdir, 
-                                     GameText                           * pgametext )
+                                     GameText                           * pgametext,
+                                     bool                                 bparallel )
     {
-        return std::move( ItemXMLParser(pgametext).Parse(srcdir) );
+        return std::move( ItemXMLParser(pgametext, bparallel).Parse(srcdir) );
     }
 
 };};
\ No newline at end of file
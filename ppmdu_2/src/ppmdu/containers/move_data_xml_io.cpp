@@ -3,6 +3,7 @@
 #include <utils/pugixml_utils.hpp>
 #include <utils/library_wide.hpp>
 #include <utils/utility.hpp>
+#include <utils/parallel_tasks.hpp>
 #include <pugixml.hpp>
 #include <string>
 #include <iostream>
@@ -73,9 +74,10 @@ namespace pmd2 { namespace stats
     {
     public:
         MoveDB_XMLWriter( const MoveDB      & src1,
-                          const MoveDB      * src2   = nullptr,
-                          const GameText    * pgtext = nullptr )
-            :m_src1(src1), m_psrc2(src2), m_pgametext(pgtext), m_bNoStrings(false)
+                          const MoveDB      * src2      = nullptr,
+                          const GameText    * pgtext    = nullptr,
+                          bool                bparallel = false )
+            :m_src1(src1), m_psrc2(src2), m_pgametext(pgtext), m_bNoStrings(false), m_bParallel(bparallel)
         {}
 
         void Write( const std::string & destdir )
@@ -93,15 +95,31 @@ namespace pmd2 { namespace stats
                 throw runtime_error( sstr.str() );
             }
 
-            if( m_psrc2 )
-                WriteEoS( destdir );
+            if( m_psrc2 && m_src1.size() != m_psrc2->size() )
+                throw runtime_error("Size mismatch between the two move data lists! One list of moves is longer than the other!");
+
+            const string dirprefix = utils::TryAppendSlash( destdir );
+
+            if( m_bParallel )
+            {
+                //The writer holds no per-file state, so the tasks can share it
+                utils::RunIndexedTasks( m_src1.size(), 
+                                        [this, &dirprefix]( size_t cntmv )
+                                        {
+                                            WriteEntry( dirprefix, static_cast<unsigned int>(cntmv) );
+                                        },
+                                        "MoveDB_XMLWriter::Write(): Couldn't export some moves!" );
+            }
             else
-                WriteEoTD( destdir );
+            {
+                for( unsigned int cntmv = 0; cntmv < m_src1.size(); ++cntmv )
+                    WriteEntry( dirprefix, cntmv );
+            }
         }
 
     private:
 
-        inline string PrepareMvNameFName( const string & name, eGameLanguages lang  )
+        inline string PrepareMvNameFName( const string & name, eGameLanguages lang  )const
         {
             const string * plocstr = m_pgametext->GetLocaleString(lang);
             if( plocstr )
@@ -110,7 +128,7 @@ namespace pmd2 { namespace stats
                 return utils::CleanFilename( name.substr( 0, name.find("\\0",0 ) ) );
         }
 
-        stringstream & MakeFilename( stringstream & out_fname, const string & outpathpre, unsigned int cntmv )
+        stringstream & MakeFilename( stringstream & out_fname, const string & outpathpre, unsigned int cntmv )const
         {
             const string * pfstr = nullptr;
             if( !m_bNoStrings && (pfstr = m_pgametext->GetDefaultLanguage().GetStringIfBlockExists( eStringBlocks::MvNames, cntmv )) )
@@ -125,76 +143,48 @@ namespace pmd2 { namespace stats
         }
 
 
-        void WriteEoS( const std::string & destdir )
+        void WriteEntry( const string & dirprefix, unsigned int cntmv )const
         {
             using namespace movesXML;
-            const string dirprefix = utils::TryAppendSlash( destdir );
             stringstream fname;
+            xml_document doc;
+            xml_node     movedata = doc.append_child( ROOT_Move.c_str() );
 
-            if( m_src1.size() != m_psrc2->size() )
-                throw runtime_error("Size mismatch between the two move data lists! One list of moves is longer than the other!");
-
-            for( unsigned int cntmv = 0; cntmv < m_src1.size(); ++cntmv/*, ++itcurname, ++itcurdesc*/ )
+            if( m_psrc2 )
             {
-                fname.str(string());
-                xml_document doc;
-                xml_node     movedata = doc.append_child( ROOT_Move.c_str() );
                 AppendAttribute( movedata, ATTR_GameVer, pmd2::GetGameVersionName( eGameVersion::EoS ) );
                 WriteCommentNode( movedata, "Pokemon Mystery Dungeon: Explorers of Sky move data" );
-
-                if( !m_bNoStrings )
-                    WriteStrings( movedata, cntmv );
-
-                WriteCommentNode( movedata, "Move data from waza_p.bin" );
-                WriteMove( movedata, m_src1[cntmv] );
-                WriteCommentNode( movedata, "Move data from waza_p2.bin" );
-                WriteMove( movedata, (*m_psrc2)[cntmv] );
-
-                MakeFilename(fname, dirprefix, cntmv);
-
-                if( ! doc.save_file( fname.str().c_str() ) )
-                {
-                    stringstream strerr;
-                    strerr << "Pugixml couldn't write file \"" <<fname.str() <<"\"!";
-                    throw runtime_error(strerr.str());
-                }
             }
-        }
-
-        void WriteEoTD( const std::string & destdir )
-        {
-            using namespace movesXML;
-            const string dirprefix = utils::TryAppendSlash( destdir );
-            stringstream fname;
-
-            for( unsigned int cntmv = 0; cntmv < m_src1.size(); ++cntmv/*, ++itcurname, ++itcurdesc*/ )
+            else
             {
-                fname.str(string());
-                xml_document doc;
-                xml_node     movedata = doc.append_child( ROOT_Move.c_str() );
                 AppendAttribute( movedata, ATTR_GameVer, pmd2::GetGameVersionName( eGameVersion::EoT ) );
                 AppendAttribute( movedata, ATTR_GameVer, pmd2::GetGameVersionName( eGameVersion::EoD ) );
                 WriteCommentNode( movedata, "Pokemon Mystery Dungeon: Explorers of Time/Darkness move data" );
+            }
 
-                if( !m_bNoStrings )
-                    WriteStrings( movedata, cntmv );
+            if( !m_bNoStrings )
+                WriteStrings( movedata, cntmv );
 
-                WriteCommentNode( movedata, "Move data from waza_p.bin" );
-                WriteMove   ( movedata, m_src1[cntmv] );
+            WriteCommentNode( movedata, "Move data from waza_p.bin" );
+            WriteMove( movedata, m_src1[cntmv] );
 
-                MakeFilename(fname, dirprefix, cntmv);
-                //fname <<dirprefix <<setw(4) <<setfill('0') <<dec <<i <<"_" << PrepareMvNameFName(*itcurname) <<".xml";
+            if( m_psrc2 )
+            {
+                WriteCommentNode( movedata, "Move data from waza_p2.bin" );
+                WriteMove( movedata, (*m_psrc2)[cntmv] );
+            }
 
-                if( ! doc.save_file( fname.str().c_str() ) )
-                {
-                    stringstream strerr;
-                    strerr << "Pugixml couldn't write file \"" <<fname.str() <<"\"!";
-                    throw runtime_error(strerr.str());
-                }
+            MakeFilename(fname, dirprefix, cntmv);
+
+            if( ! doc.save_file( fname.str().c_str() ) )
+            {
+                stringstream strerr;
+                strerr << "Pugixml couldn't write file \"" <<fname.str() <<"\"!";
+                throw runtime_error(strerr.str());
             }
         }
 
-        void WriteStrings( xml_node & mn, unsigned int cntmv )
+        void WriteStrings( xml_node & mn, unsigned int cntmv )const
         {
             using namespace movesXML;
             WriteCommentNode( mn, "In-game text" );
@@ -215,7 +205,7 @@ namespace pmd2 { namespace stats
             }
         }
 
-        void WriteMove( xml_node & pn, const MoveData & mvdata )
+        void WriteMove( xml_node & pn, const MoveData & mvdata )const
         {
             using namespace movesXML;
             xml_node datnode = pn.append_child( NODE_Data.c_str() );
@@ -247,6 +237,7 @@ namespace pmd2 { namespace stats
         const MoveDB                   *m_psrc2;
         const GameText                 *m_pgametext;
         bool                            m_bNoStrings;
+        bool                            m_bParallel;    //If true, the files are written on several threads
     };
 
     /**********************************************************************
@@ -259,8 +250,8 @@ namespace pmd2 { namespace stats
 
         /*
         */
-        MoveDB_XMLParser( MoveDB & out_mdb1, MoveDB * out_mdb2 = nullptr, GameText * pgtext = nullptr )
-            :m_out1(out_mdb1), m_pout2(out_mdb2), m_pgametext(pgtext),m_bNoStrings(false), m_bParseMoveId(false)
+        MoveDB_XMLParser( MoveDB & out_mdb1, MoveDB * out_mdb2 = nullptr, GameText * pgtext = nullptr, bool bparallel = false )
+            :m_out1(out_mdb1), m_pout2(out_mdb2), m_pgametext(pgtext),m_bNoStrings(false), m_bParseMoveId(false), m_bParallel(bparallel)
         {}
 
         /*
@@ -335,21 +326,16 @@ namespace pmd2 { namespace stats
             if( !m_pout2 )
                 result2.reserve(files.size());
 
+            //Loading and parsing the documents is the expensive part, so it can be done in parallel
+            vector<unique_ptr<xml_document>> docs = LoadXMLDocuments( files, m_bParallel );
+
             //Parse files
             uint32_t cntmv = 0;
-            for( auto & mv : files )
+            for( size_t cntfile = 0; cntfile < files.size(); ++cntfile )
             {
-                uint32_t         moveid = GetCurrentMoveId( mv, cntmv );
-                xml_document     doc;
-                xml_parse_result loadres = doc.load_file(mv.c_str());
-                if( ! loadres )
-                {
-                    stringstream sstr;
-                    sstr <<"Can't load XML document \"" <<mv <<"\"! Pugixml returned an error : \"" << loadres.description() <<"\"";
-                    throw std::runtime_error(sstr.str());
-                }
-
-                pugi::xml_node movenode  = doc.child(ROOT_Move.c_str());
+                const string   & mv       = files[cntfile];
+                uint32_t         moveid   = GetCurrentMoveId( mv, cntmv );
+                pugi::xml_node   movenode = docs[cntfile]->child(ROOT_Move.c_str());
                 if( !movenode )
                 {
                     clog <<"<!>- MoveDB_XML_Parser::ReadAllMoves(): No move data found in XML file \"" <<mv <<"\". Skipping..\n";
@@ -561,6 +547,7 @@ namespace pmd2 { namespace stats
         GameText    * m_pgametext;
         bool          m_bNoStrings;
         bool          m_bParseMoveId;
+        bool          m_bParallel;
     };
 
 //=================================================================================
@@ -572,9 +559,10 @@ namespace pmd2 { namespace stats
     void      ExportMovesToXML     ( const MoveDB                            & src1,
                                      const MoveDB                            * src2,
                                      const GameText                          * gtext,
-                                     const std::string                       & destdir )
+                                     const std::string                       & destdir,
+                                     bool                                      bparallel )
     {
-        MoveDB_XMLWriter(src1, src2, gtext).Write(destdir);
+        MoveDB_XMLWriter(src1, src2, gtext, bparallel).Write(destdir);
     }
 
     /**********************************************************************
@@ -583,9 +571,10 @@ namespace pmd2 { namespace stats
     void      ImportMovesFromXML   ( const std::string                  & srcdir, 
                                      MoveDB                             & out_mvdb1,
                                      MoveDB                             * out_mvdb2,
-                                     GameText                           * gtext )
+                                     GameText                           * gtext,
+                                     bool                                 bparallel )
     {
-        MoveDB_XMLParser(out_mvdb1, out_mvdb2, gtext).Parse(srcdir, false);
+        MoveDB_XMLParser(out_mvdb1, out_mvdb2, gtext, bparallel).Parse(srcdir, false);
     }
 
 
@@ -3,8 +3,10 @@
 */
 
 #include <ppmdu/containers/pokemon_stats.hpp>
+#include <utils/file_sink.hpp>
 #include <utils/parse_utils.hpp>
 #include <utils/pugixml_utils.hpp>
+#include <utils/parallel_tasks.hpp>
 #include <pugixml.hpp>
 #include <sstream>
 #include <iostream>
@@ -119,8 +121,9 @@ namespace pmd2 {namespace stats
     {
     public:
         PokemonDB_XMLWriter( const PokemonDB                         & src, 
-                             const GameText                          * gtext )
-            :m_src(src),m_pgametext(gtext), m_bNoStrings(false)
+                             const GameText                          * gtext,
+                             bool                                      bparallel = false )
+            :m_src(src),m_pgametext(gtext), m_bNoStrings(false), m_bParallel(bparallel)
         {}
 
         void Write( const std::string & outdir )
@@ -202,39 +205,46 @@ namespace pmd2 {namespace stats
         }
 
         void WriteAllEntries( const string & outdir )
+        {
+            const string        outpathpre = utils::TryAppendSlash(outdir);
+            utils::io::FileSink sink;       //The files are written in the background, while the next entries are converted
+            sink.PrepareDirectory(outdir);
+
+            if( m_bParallel )
+            {
+                //Each task gets its own copy of the writer, so the conversion buffers aren't shared
+                utils::RunIndexedTasks( m_src.size(), 
+                                        [this, &outpathpre, &sink]( size_t cntpkmn )
+                                        {
+                                            PokemonDB_XMLWriter( *this ).WriteEntry( outpathpre, static_cast<unsigned int>(cntpkmn), sink );
+                                        },
+                                        "PokemonDB_XMLWriter::WriteAllEntries(): Couldn't export some Pokemon!" );
+            }
+            else
+            {
+                for( unsigned int cntpkmn = 0; cntpkmn < m_src.size(); ++cntpkmn )
+                    WriteEntry( outpathpre, cntpkmn, sink );
+            }
+            sink.Flush();
+        }
+
+        void WriteEntry( const string & outpathpre, unsigned int cntpkmn, utils::io::FileSink & sink )
         {
             using namespace pkmnXML;
             stringstream sstrfname;
-            const string outpathpre = utils::TryAppendSlash(outdir);
+            MakeFilename(sstrfname, outpathpre, cntpkmn);
 
-            for( unsigned int cntpkmn = 0; cntpkmn < m_src.size(); ++cntpkmn )
-            {
-                sstrfname.str(string());
-                MakeFilename(sstrfname, outpathpre, cntpkmn);
-                //if( !m_bNoStrings )
-                //{
-                //    const string * pfstr = m_pgametext->begin()->second.GetStringInBlock( eStringBlocks::PkmnNames, cntpkmn );
-                //    if( pfstr )
-                //        sstrfname <<outpathpre <<setw(4) <<setfill('0') <<cntpkmn <<"_" <<PreparePokeNameFName(*pfstr, m_pgametext->begin()->first) <<".xml";
-                //    else
-                //        sstrfname <<outpathpre <<setw(4) <<setfill('0') <<cntpkmn <<".xml";
-                //}
-                //else
-                //    sstrfname <<outpathpre <<setw(4) <<setfill('0') <<cntpkmn <<".xml";
-
-                xml_document doc;
-                xml_node     pknode = doc.append_child( ROOT_Pkmn.c_str() );
-
-                if( m_src.isEoSData() )
-                    AppendAttribute( pknode, ATTR_GameVer, GameVersion_EoS );
-                else
-                    AppendAttribute( pknode, ATTR_GameVer, GameVersion_EoTD );
+            xml_document doc;
+            xml_node     pknode = doc.append_child( ROOT_Pkmn.c_str() );
 
-                WriteAPokemon( m_src[cntpkmn], pknode, cntpkmn );
+            if( m_src.isEoSData() )
+                AppendAttribute( pknode, ATTR_GameVer, GameVersion_EoS );
+            else
+                AppendAttribute( pknode, ATTR_GameVer, GameVersion_EoTD );
 
-                if( ! doc.save_file( sstrfname.str().c_str() ) )
-                    throw std::runtime_error("Can't write xml file " + sstrfname.str());
-            }
+            WriteAPokemon( m_src[cntpkmn], pknode, cntpkmn );
+
+            sink.Write( sstrfname.str(), SaveXMLToBuffer(doc) );
         }
 
         void WriteAPokemon( const CPokemon & pkmn, xml_node & pknode, unsigned int pkindex )
@@ -451,6 +461,7 @@ namespace pmd2 {namespace stats
         array<char,CBuffSZ>                      m_secConvbuffer;
 
         bool                                     m_bNoStrings; //If true, omit strings entirely, and don't write pokemon names for each files!
+        bool                                     m_bParallel;  //If true, the files are written on several threads
     };
 
     /***************************************************************************************
@@ -481,8 +492,8 @@ namespace pmd2 {namespace stats
 
         /*
         */
-        PokemonDB_XMLParser( PokemonDB & out_pkdb, GameText  * inout_gtext )
-            :m_out(out_pkdb), m_isEoS(false), m_pgametext(inout_gtext), m_bParsePokemonId(false)
+        PokemonDB_XMLParser( PokemonDB & out_pkdb, GameText  * inout_gtext, bool bparallel = false )
+            :m_out(out_pkdb), m_isEoS(false), m_pgametext(inout_gtext), m_bParsePokemonId(false), m_bParallel(bparallel)
         {
         }
         
@@ -551,22 +562,16 @@ namespace pmd2 {namespace stats
             vector<CPokemon> result;
             result.reserve(filelst.size());
 
+            //Loading and parsing the documents is the expensive part, so it can be done in parallel
+            vector<unique_ptr<xml_document>> docs = LoadXMLDocuments( filelst, m_bParallel );
+
             uint32_t cntEoSPk = 0;
             uint32_t cntPkmn  = 0;
-            for( auto & pkmn : filelst )
+            for( size_t cntfile = 0; cntfile < filelst.size(); ++cntfile )
             {
-                uint32_t         pkid = GetCurrentPokemonID(pkmn,cntPkmn);
-                xml_document     doc;
-                xml_parse_result loadres = doc.load_file(pkmn.c_str());
-                if( ! loadres )
-                {
-                    stringstream sstr;
-                    sstr <<"Can't load XML document \"" <<pkmn <<"\"! Pugixml returned an error : \"" << loadres.description() <<"\"";
-                    throw std::runtime_error(sstr.str());
-                }
-
+                uint32_t pkid            = GetCurrentPokemonID(filelst[cntfile],cntPkmn);
                 bool     hadEoSAttribute = false;
-                xml_node rootnode        = doc.child(ROOT_Pkmn.c_str());
+                xml_node rootnode        = docs[cntfile]->child(ROOT_Pkmn.c_str());
                 if( rootnode )
                     result.push_back( ReadPokemon( rootnode, cntPkmn, hadEoSAttribute ) );
                 else
@@ -963,6 +968,7 @@ namespace pmd2 {namespace stats
         bool        m_isEoS;
         bool        m_bNoStrings; //If true, omit strings entirely.
         bool        m_bParsePokemonId;
+        bool        m_bParallel;
     };
 
 //===============================================================================================
@@ -978,9 +984,10 @@ namespace pmd2 {namespace stats
 
     void      ExportPokemonsToXML  ( const PokemonDB                         & src,
                                      const GameText                          * gtext,
-                                     const std::string                       & destdir )
+                                     const std::string                       & destdir,
+                                     bool                                      bparallel )
     {
-        PokemonDB_XMLWriter( src, gtext ).Write(destdir);
+        PokemonDB_XMLWriter( src, gtext, bparallel ).Write(destdir);
     }
     
     //void      ImportPokemonsFromXML( const std::string                  & srcdir, 
@@ -996,9 +1003,10 @@ namespace pmd2 {namespace stats
 
     void      ImportPokemonsFromXML ( const std::string                 & srcdir, 
                                       PokemonDB                         & out_pkdb,
-                                      GameText                          * inout_gtext )
+                                      GameText                          * inout_gtext,
+                                      bool                                bparallel )
     {
-        PokemonDB_XMLParser( out_pkdb, inout_gtext ).Parse(srcdir);
+        PokemonDB_XMLParser( out_pkdb, inout_gtext, bparallel ).Parse(srcdir);
     }
 
 };};
\ No newline at end of file
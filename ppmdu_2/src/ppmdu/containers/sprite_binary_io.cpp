@@ -0,0 +1,653 @@
+#include <ppmdu/containers/sprite_binary_io.hpp>
+#include <utils/gbyteutils.hpp>
+#include <utils/gfileio.hpp>
+#include <utils/library_wide.hpp>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <array>
+#include <limits>
+using namespace std;
+
+namespace pmd2 { namespace graphics
+{
+//==============================================================================================
+// Constants
+//==============================================================================================
+    /*
+        Layout of the file. Everything is little endian, except the magic number.
+            - Header:
+                - magic          : uint32
+                - version        : uint16
+                - sprite type    : uint16 (eSpriteImgType)
+                - SprInfo        : 14 x uint16
+                - nb of each list: 8 x uint32 (frames, metaframes, mfgroups, animgroups,
+                                   animsequences, palette colors, part offsets, images info)
+            - Palette           : RGB24 colors
+            - Meta-frames       : Fixed 12 bytes entries
+            - Meta-frame groups : Nb of indices (uint32), followed by the indices (uint32)
+            - Anim groups       : Name, nb of indices (uint32), followed by the indices (uint32)
+            - Anim sequences    : Name, nb of frames (uint32), followed by 12 bytes frames
+            - Part offsets      : 2 x int16
+            - Images info       : zindex (uint32)
+            - Frames            : width(uint16), height(uint16), nb palette colors(uint16)
+                                  followed by the frame's palette if it differs from the
+                                  sprite's palette, and the packed pixels in tile order.
+        Names are a uint16 length followed by the characters.
+    */
+    static const size_t SprBin_MetaFrameLen = 12;
+    static const size_t SprBin_AnimFrameLen = 12;
+
+    /*
+        Bits of the flag byte in the meta-frame entries.
+    */
+    enum struct eSprBinMFFlags : uint8_t
+    {
+        vFlip    = 1 << 0,
+        hFlip    = 1 << 1,
+        Mosaic   = 1 << 2,
+        XOffbit6 = 1 << 3,
+        XOffbit7 = 1 << 4,
+        YOffbit3 = 1 << 5,
+        YOffbit5 = 1 << 6,
+        YOffbit6 = 1 << 7,
+    };
+
+    inline uint8_t MFFlag( bool state, eSprBinMFFlags flag )
+    {
+        return state? static_cast<uint8_t>(flag) : 0;
+    }
+
+    inline bool HasMFFlag( uint8_t flags, eSprBinMFFlags flag )
+    {
+        return (flags & static_cast<uint8_t>(flag)) != 0;
+    }
+
+//==============================================================================================
+// SpriteBinaryWriter
+//==============================================================================================
+    /*
+        SpriteBinaryWriter
+            Writes the content of a sprite into the binary sprite format.
+    */
+    template<class _SPRITE_t>
+        class SpriteBinaryWriter
+    {
+    public:
+        typedef _SPRITE_t                   sprite_t;
+        typedef typename sprite_t::img_t    img_t;
+
+        SpriteBinaryWriter( const sprite_t & spr )
+            :m_spr(spr)
+        {}
+
+        vector<uint8_t> Write()
+        {
+            m_out.reserve( EstimateSize() );
+            WriteHeader();
+            WritePalette( m_spr.getPalette() );
+            WriteMetaFrames();
+            WriteMetaFrameGroups();
+            WriteAnimGroups();
+            WriteAnimSequences();
+            WritePartOffsets();
+            WriteImagesInfo();
+            WriteFrames();
+            return std::move(m_out);
+        }
+
+    private:
+
+        size_t EstimateSize()const
+        {
+            size_t pixelslen = 0;
+            for( const auto & frm : m_spr.getFrames() )
+                pixelslen += frm.getSizeInBits() / 8 + 8;
+
+            return 128 + pixelslen +
+                   (m_spr.getPalette().size() * 3) +
+                   (m_spr.getMetaFrames().size() * SprBin_MetaFrameLen) +
+                   (m_spr.getPartOffsets().size() * 4) +
+                   (m_spr.getImgsInfo().size() * 4);
+        }
+
+        void WriteHeader()
+        {
+            auto            itout = back_inserter(m_out);
+            const SprInfo & info  = m_spr.getSprInfo();
+
+            itout = utils::WriteIntToBytes( SPRITE_Binary_MagicNumber,                          itout, false );
+            itout = utils::WriteIntToBytes( SPRITE_Binary_Version,                              itout );
+            itout = utils::WriteIntToBytes( static_cast<uint16_t>(m_spr.getSpriteType()),       itout );
+
+            itout = utils::WriteIntToBytes( info.Unk3,                                          itout );
+            itout = utils::WriteIntToBytes( info.nbColorsPerRow,                                itout );
+            itout = utils::WriteIntToBytes( info.Unk4,                                          itout );
+            itout = utils::WriteIntToBytes( info.Unk5,                                          itout );
+            itout = utils::WriteIntToBytes( info.Unk6,                                          itout );
+            itout = utils::WriteIntToBytes( info.Unk7,                                          itout );
+            itout = utils::WriteIntToBytes( info.Unk8,                                          itout );
+            itout = utils::WriteIntToBytes( info.Unk9,                                          itout );
+            itout = utils::WriteIntToBytes( info.Unk10,                                         itout );
+            itout = utils::WriteIntToBytes( static_cast<uint16_t>(info.spriteType),             itout );
+            itout = utils::WriteIntToBytes( info.is256Sprite,                                   itout );
+            itout = utils::WriteIntToBytes( info.Unk13,                                         itout );
+            itout = utils::WriteIntToBytes( info.Unk11,                                         itout );
+            itout = utils::WriteIntToBytes( info.Unk12,                                         itout );
+
+            itout = utils::WriteIntToBytes( static_cast<uint32_t>(m_spr.getFrames().size()),        itout );
+            itout = utils::WriteIntToBytes( static_cast<uint32_t>(m_spr.getMetaFrames().size()),    itout );
+            itout = utils::WriteIntToBytes( static_cast<uint32_t>(m_spr.getMetaFrmsGrps().size()),  itout );
+            itout = utils::WriteIntToBytes( static_cast<uint32_t>(m_spr.getAnimGroups().size()),    itout );
+            itout = utils::WriteIntToBytes( static_cast<uint32_t>(m_spr.getAnimSequences().size()), itout );
+            itout = utils::WriteIntToBytes( static_cast<uint32_t>(m_spr.getPalette().size()),       itout );
+            itout = utils::WriteIntToBytes( static_cast<uint32_t>(m_spr.getPartOffsets().size()),   itout );
+            itout = utils::WriteIntToBytes( static_cast<uint32_t>(m_spr.getImgsInfo().size()),      itout );
+        }
+
+        void WritePalette( const vector<gimg::colorRGB24> & pal )
+        {
+            for( const auto & col : pal )
+            {
+                m_out.push_back( col.red   );
+                m_out.push_back( col.green );
+                m_out.push_back( col.blue  );
+            }
+        }
+
+        void WriteName( const string & name )
+        {
+            if( name.size() > std::numeric_limits<uint16_t>::max() )
+                throw runtime_error( "SpriteBinaryWriter::WriteName(): Name \"" + name.substr(0,32) + "...\" is too long!" );
+            utils::WriteIntToBytes( static_cast<uint16_t>(name.size()), back_inserter(m_out) );
+            m_out.insert( m_out.end(), name.begin(), name.end() );
+        }
+
+        void WriteMetaFrames()
+        {
+            auto itout = back_inserter(m_out);
+            for( const auto & mf : m_spr.getMetaFrames() )
+            {
+                uint8_t flags = MFFlag( mf.vFlip,    eSprBinMFFlags::vFlip    ) | MFFlag( mf.hFlip,    eSprBinMFFlags::hFlip    ) |
+                                MFFlag( mf.Mosaic,   eSprBinMFFlags::Mosaic   ) | MFFlag( mf.XOffbit6, eSprBinMFFlags::XOffbit6 ) |
+                                MFFlag( mf.XOffbit7, eSprBinMFFlags::XOffbit7 ) | MFFlag( mf.YOffbit3, eSprBinMFFlags::YOffbit3 ) |
+                                MFFlag( mf.YOffbit5, eSprBinMFFlags::YOffbit5 ) | MFFlag( mf.YOffbit6, eSprBinMFFlags::YOffbit6 );
+
+                itout = utils::WriteIntToBytes( mf.imageIndex,                         itout );
+                itout = utils::WriteIntToBytes( mf.unk0,                               itout );
+                itout = utils::WriteIntToBytes( mf.offsetY,                            itout );
+                itout = utils::WriteIntToBytes( mf.offsetX,                            itout );
+                itout = utils::WriteIntToBytes( mf.unk15,                              itout );
+                itout = utils::WriteIntToBytes( mf.unk1,                               itout );
+                itout = utils::WriteIntToBytes( static_cast<uint8_t>(mf.resolution),   itout );
+                itout = utils::WriteIntToBytes( flags,                                 itout );
+            }
+        }
+
+        template<class _ContainerT>
+            void WriteIndexList( const _ContainerT & indices )
+        {
+            auto itout = back_inserter(m_out);
+            itout = utils::WriteIntToBytes( static_cast<uint32_t>(indices.size()), itout );
+            for( const auto & index : indices )
+                itout = utils::WriteIntToBytes( static_cast<uint32_t>(index), itout );
+        }
+
+        void WriteMetaFrameGroups()
+        {
+            for( const auto & grp : m_spr.getMetaFrmsGrps() )
+                WriteIndexList( grp.metaframes );
+        }
+
+        void WriteAnimGroups()
+        {
+            for( const auto & grp : m_spr.getAnimGroups() )
+            {
+                WriteName( grp.group_name );
+                WriteIndexList( grp.seqsIndexes );
+            }
+        }
+
+        void WriteAnimSequences()
+        {
+            for( const auto & seq : m_spr.getAnimSequences() )
+            {
+                WriteName( seq.getName() );
+                auto itout = back_inserter(m_out);
+                itout = utils::WriteIntToBytes( static_cast<uint32_t>(seq.getNbFrames()), itout );
+
+                for( unsigned int i = 0; i < seq.getNbFrames(); ++i )
+                {
+                    const AnimFrame & frm = seq.getFrame(i);
+                    itout = utils::WriteIntToBytes( frm.frameDuration,   itout );
+                    itout = utils::WriteIntToBytes( frm.metaFrmGrpIndex, itout );
+                    itout = utils::WriteIntToBytes( frm.sprOffsetX,      itout );
+                    itout = utils::WriteIntToBytes( frm.sprOffsetY,      itout );
+                    itout = utils::WriteIntToBytes( frm.shadowOffsetX,   itout );
+                    itout = utils::WriteIntToBytes( frm.shadowOffsetY,   itout );
+                }
+            }
+        }
+
+        void WritePartOffsets()
+        {
+            auto itout = back_inserter(m_out);
+            for( const auto & off : m_spr.getPartOffsets() )
+            {
+                itout = utils::WriteIntToBytes( off.offx, itout );
+                itout = utils::WriteIntToBytes( off.offy, itout );
+            }
+        }
+
+        void WriteImagesInfo()
+        {
+            auto itout = back_inserter(m_out);
+            for( const auto & info : m_spr.getImgsInfo() )
+                itout = utils::WriteIntToBytes( info.zindex, itout );
+        }
+
+        /*
+            Frames palettes are only written when they differ from the sprite's,
+            which is almost never the case. A palette length of 0 means the sprite's palette is used.
+        */
+        void WriteFrames()
+        {
+            const auto & sprpal = m_spr.getPalette();
+
+            for( const auto & frm : m_spr.getFrames() )
+            {
+                const bool bsamepal = IsSamePalette( frm.getPalette(), sprpal );
+                auto       itout    = back_inserter(m_out);
+                itout = utils::WriteIntToBytes( static_cast<uint16_t>(frm.getNbPixelWidth()),  itout );
+                itout = utils::WriteIntToBytes( static_cast<uint16_t>(frm.getNbPixelHeight()), itout );
+                itout = utils::WriteIntToBytes( static_cast<uint16_t>( bsamepal? 0 : frm.getPalette().size() ), itout );
+
+                if( !bsamepal )
+                    WritePalette( frm.getPalette() );
+                WritePixels( frm );
+            }
+        }
+
+        /*
+            4bpp pixels are packed 2 per bytes, low nybble first. 8bpp pixels are stored as-is.
+        */
+        void WritePixels( const img_t & frm )
+        {
+            const unsigned int bpp      = img_t::pixel_t::GetBitsPerPixel();
+            const unsigned int nbpixels = frm.getNbPixelWidth() * frm.getNbPixelHeight();
+
+            if( bpp == 4 )
+            {
+                for( unsigned int i = 0; i < nbpixels; i += 2 )
+                {
+                    uint8_t byte = static_cast<uint8_t>( frm[i].getWholePixelData() & 0xF );
+                    if( i + 1 < nbpixels )
+                        byte |= static_cast<uint8_t>( (frm[i + 1].getWholePixelData() & 0xF) << 4 );
+                    m_out.push_back(byte);
+                }
+            }
+            else
+            {
+                for( unsigned int i = 0; i < nbpixels; ++i )
+                    m_out.push_back( static_cast<uint8_t>(frm[i].getWholePixelData()) );
+            }
+        }
+
+        static bool IsSamePalette( const vector<gimg::colorRGB24> & first, const vector<gimg::colorRGB24> & second )
+        {
+            if( first.size() != second.size() )
+                return false;
+            for( size_t i = 0; i < first.size(); ++i )
+            {
+                if( first[i].red != second[i].red || first[i].green != second[i].green || first[i].blue != second[i].blue )
+                    return false;
+            }
+            return true;
+        }
+
+    private:
+        const sprite_t  & m_spr;
+        vector<uint8_t>   m_out;
+    };
+
+//==============================================================================================
+// SpriteBinaryParser
+//==============================================================================================
+    /*
+        SpriteBinaryParser
+            Reads a sprite from the binary sprite format.
+    */
+    class SpriteBinaryParser
+    {
+    public:
+        typedef vector<uint8_t>::const_iterator init_t;
+
+        SpriteBinaryParser( const vector<uint8_t> & data )
+            :m_itread(data.begin()), m_itend(data.end()), m_sprty(eSpriteImgType::sprInvalid), m_counts{}
+        {}
+
+        unique_ptr<BaseSprite> Parse()
+        {
+            ParseHeader();
+
+            if( m_sprty == eSpriteImgType::spr4bpp )
+            {
+                unique_ptr<SpriteData<gimg::tiled_image_i4bpp>> spr( new SpriteData<gimg::tiled_image_i4bpp> );
+                ParseContent( *spr );
+                return std::move(spr);
+            }
+            else if( m_sprty == eSpriteImgType::spr8bpp )
+            {
+                unique_ptr<SpriteData<gimg::tiled_image_i8bpp>> spr( new SpriteData<gimg::tiled_image_i8bpp> );
+                ParseContent( *spr );
+                return std::move(spr);
+            }
+
+            stringstream sstr;
+            sstr << "SpriteBinaryParser::Parse(): Unsupported sprite type " <<static_cast<short>(m_sprty) <<"!";
+            throw runtime_error(sstr.str());
+        }
+
+    private:
+        enum eCounts : size_t
+        {
+            NbFrames = 0,
+            NbMetaFrames,
+            NbMFGroups,
+            NbAnimGroups,
+            NbAnimSeqs,
+            NbColors,
+            NbPartOffsets,
+            NbImgsInfo,
+            NbCounts,
+        };
+
+        void ParseHeader()
+        {
+            uint32_t magic   = 0;
+            uint16_t version = 0;
+            uint16_t sprty   = 0;
+            m_itread = utils::ReadIntFromBytes( magic,   m_itread, m_itend, false );
+            m_itread = utils::ReadIntFromBytes( version, m_itread, m_itend );
+            m_itread = utils::ReadIntFromBytes( sprty,   m_itread, m_itend );
+
+            if( magic != SPRITE_Binary_MagicNumber )
+                throw runtime_error( "SpriteBinaryParser::ParseHeader(): Data isn't a binary sprite!" );
+            if( version != SPRITE_Binary_Version )
+            {
+                stringstream sstr;
+                sstr << "SpriteBinaryParser::ParseHeader(): Binary sprite is version " <<version
+                     <<", but only version " <<SPRITE_Binary_Version <<" is supported!";
+                throw runtime_error(sstr.str());
+            }
+            m_sprty = static_cast<eSpriteImgType>(sprty);
+
+            uint16_t spritetype = 0;
+            m_itread = utils::ReadIntFromBytes( m_info.Unk3,           m_itread, m_itend );
+            m_itread = utils::ReadIntFromBytes( m_info.nbColorsPerRow, m_itread, m_itend );
+            m_itread = utils::ReadIntFromBytes( m_info.Unk4,           m_itread, m_itend );
+            m_itread = utils::ReadIntFromBytes( m_info.Unk5,           m_itread, m_itend );
+            m_itread = utils::ReadIntFromBytes( m_info.Unk6,           m_itread, m_itend );
+            m_itread = utils::ReadIntFromBytes( m_info.Unk7,           m_itread, m_itend );
+            m_itread = utils::ReadIntFromBytes( m_info.Unk8,           m_itread, m_itend );
+            m_itread = utils::ReadIntFromBytes( m_info.Unk9,           m_itread, m_itend );
+            m_itread = utils::ReadIntFromBytes( m_info.Unk10,          m_itread, m_itend );
+            m_itread = utils::ReadIntFromBytes( spritetype,            m_itread, m_itend );
+            m_itread = utils::ReadIntFromBytes( m_info.is256Sprite,    m_itread, m_itend );
+            m_itread = utils::ReadIntFromBytes( m_info.Unk13,          m_itread, m_itend );
+            m_itread = utils::ReadIntFromBytes( m_info.Unk11,          m_itread, m_itend );
+            m_itread = utils::ReadIntFromBytes( m_info.Unk12,          m_itread, m_itend );
+            m_info.spriteType = static_cast<eSprTy>(spritetype);
+
+            for( auto & cnt : m_counts )
+                m_itread = utils::ReadIntFromBytes( cnt, m_itread, m_itend );
+        }
+
+        template<class _SPRITE_t>
+            void ParseContent( _SPRITE_t & spr )
+        {
+            spr.m_common  = m_info;
+            spr.m_palette = ParsePalette( m_counts[NbColors] );
+            ParseMetaFrames     ( spr.m_metaframes );
+            ParseMetaFrameGroups( spr.m_metafrmsgroups );
+            ParseAnimGroups     ( spr.m_animgroups );
+            ParseAnimSequences  ( spr.m_animSequences );
+            ParsePartOffsets    ( spr.m_partOffsets );
+            ParseImagesInfo     ( spr.m_imgsinfo );
+            ParseFrames         ( spr.m_frames, spr.m_palette );
+            spr.RebuildAllReferences();
+        }
+
+        /*
+            Make sure there's enough data left, so we can read fixed size entries without checking each reads.
+        */
+        void EnsureAvailable( size_t len, const char * what )const
+        {
+            if( static_cast<size_t>(std::distance( m_itread, m_itend )) < len )
+            {
+                stringstream sstr;
+                sstr << "SpriteBinaryParser: Data is truncated, while reading " <<what <<"!";
+                throw runtime_error(sstr.str());
+            }
+        }
+
+        vector<gimg::colorRGB24> ParsePalette( size_t nbcolors )
+        {
+            EnsureAvailable( nbcolors * 3, "palette" );
+            vector<gimg::colorRGB24> pal;
+            pal.reserve(nbcolors);
+            for( size_t i = 0; i < nbcolors; ++i, m_itread += 3 )
+                pal.push_back( gimg::colorRGB24( m_itread[0], m_itread[1], m_itread[2] ) );
+            return pal;
+        }
+
+        string ParseName()
+        {
+            uint16_t len = 0;
+            m_itread = utils::ReadIntFromBytes( len, m_itread, m_itend );
+            EnsureAvailable( len, "a name" );
+            string name( m_itread, m_itread + len );
+            m_itread += len;
+            return name;
+        }
+
+        template<class _IndexT>
+            void ParseIndexList( vector<_IndexT> & out_indices )
+        {
+            uint32_t nbindices = 0;
+            m_itread = utils::ReadIntFromBytes( nbindices, m_itread, m_itend );
+            EnsureAvailable( static_cast<size_t>(nbindices) * 4, "an index list" );
+            out_indices.resize(nbindices);
+            for( auto & index : out_indices )
+                index = static_cast<_IndexT>( utils::ReadIntFromBytes<uint32_t>( m_itread, m_itend ) );
+        }
+
+        void ParseMetaFrames( vector<MetaFrame> & out_mfs )
+        {
+            EnsureAvailable( static_cast<size_t>(m_counts[NbMetaFrames]) * SprBin_MetaFrameLen, "meta-frames" );
+            out_mfs.resize( m_counts[NbMetaFrames] );
+
+            for( auto & mf : out_mfs )
+            {
+                uint8_t res   = 0;
+                uint8_t flags = 0;
+                m_itread = utils::ReadIntFromBytes( mf.imageIndex, m_itread, m_itend );
+                m_itread = utils::ReadIntFromBytes( mf.unk0,       m_itread, m_itend );
+                m_itread = utils::ReadIntFromBytes( mf.offsetY,    m_itread, m_itend );
+                m_itread = utils::ReadIntFromBytes( mf.offsetX,    m_itread, m_itend );
+                m_itread = utils::ReadIntFromBytes( mf.unk15,      m_itread, m_itend );
+                m_itread = utils::ReadIntFromBytes( mf.unk1,       m_itread, m_itend );
+                m_itread = utils::ReadIntFromBytes( res,           m_itread, m_itend );
+                m_itread = utils::ReadIntFromBytes( flags,         m_itread, m_itend );
+
+                mf.resolution = static_cast<MetaFrame::eRes>(res);
+                mf.vFlip      = HasMFFlag( flags, eSprBinMFFlags::vFlip    );
+                mf.hFlip      = HasMFFlag( flags, eSprBinMFFlags::hFlip    );
+                mf.Mosaic     = HasMFFlag( flags, eSprBinMFFlags::Mosaic   );
+                mf.XOffbit6   = HasMFFlag( flags, eSprBinMFFlags::XOffbit6 );
+                mf.XOffbit7   = HasMFFlag( flags, eSprBinMFFlags::XOffbit7 );
+                mf.YOffbit3   = HasMFFlag( flags, eSprBinMFFlags::YOffbit3 );
+                mf.YOffbit5   = HasMFFlag( flags, eSprBinMFFlags::YOffbit5 );
+                mf.YOffbit6   = HasMFFlag( flags, eSprBinMFFlags::YOffbit6 );
+            }
+        }
+
+        void ParseMetaFrameGroups( vector<MetaFrameGroup> & out_grps )
+        {
+            out_grps.resize( m_counts[NbMFGroups] );
+            for( auto & grp : out_grps )
+                ParseIndexList( grp.metaframes );
+        }
+
+        void ParseAnimGroups( vector<SpriteAnimationGroup> & out_grps )
+        {
+            out_grps.resize( m_counts[NbAnimGroups] );
+            for( auto & grp : out_grps )
+            {
+                grp.group_name = ParseName();
+                ParseIndexList( grp.seqsIndexes );
+            }
+        }
+
+        void ParseAnimSequences( vector<AnimationSequence> & out_seqs )
+        {
+            out_seqs.reserve( m_counts[NbAnimSeqs] );
+            for( uint32_t cntseq = 0; cntseq < m_counts[NbAnimSeqs]; ++cntseq )
+            {
+                string   name     = ParseName();
+                uint32_t nbframes = 0;
+                m_itread = utils::ReadIntFromBytes( nbframes, m_itread, m_itend );
+                EnsureAvailable( static_cast<size_t>(nbframes) * SprBin_AnimFrameLen, "animation frames" );
+
+                AnimationSequence seq( name, nbframes );
+                for( uint32_t i = 0; i < nbframes; ++i )
+                {
+                    AnimFrame & frm = seq.getFrame(i);
+                    m_itread = utils::ReadIntFromBytes( frm.frameDuration,   m_itread, m_itend );
+                    m_itread = utils::ReadIntFromBytes( frm.metaFrmGrpIndex, m_itread, m_itend );
+                    m_itread = utils::ReadIntFromBytes( frm.sprOffsetX,      m_itread, m_itend );
+                    m_itread = utils::ReadIntFromBytes( frm.sprOffsetY,      m_itread, m_itend );
+                    m_itread = utils::ReadIntFromBytes( frm.shadowOffsetX,   m_itread, m_itend );
+                    m_itread = utils::ReadIntFromBytes( frm.shadowOffsetY,   m_itread, m_itend );
+                }
+                out_seqs.push_back( std::move(seq) );
+            }
+        }
+
+        void ParsePartOffsets( vector<sprOffParticle> & out_offsets )
+        {
+            EnsureAvailable( static_cast<size_t>(m_counts[NbPartOffsets]) * 4, "particle offsets" );
+            out_offsets.resize( m_counts[NbPartOffsets] );
+            for( auto & off : out_offsets )
+            {
+                m_itread = utils::ReadIntFromBytes( off.offx, m_itread, m_itend );
+                m_itread = utils::ReadIntFromBytes( off.offy, m_itread, m_itend );
+            }
+        }
+
+        void ParseImagesInfo( vector<ImageInfo> & out_infos )
+        {
+            EnsureAvailable( static_cast<size_t>(m_counts[NbImgsInfo]) * 4, "images info" );
+            out_infos.resize( m_counts[NbImgsInfo] );
+            for( auto & info : out_infos )
+                m_itread = utils::ReadIntFromBytes( info.zindex, m_itread, m_itend );
+        }
+
+        template<class _IMG_t>
+            void ParseFrames( vector<_IMG_t> & out_frames, const vector<gimg::colorRGB24> & sprpal )
+        {
+            out_frames.resize( m_counts[NbFrames] );
+            for( auto & frm : out_frames )
+            {
+                uint16_t width    = 0;
+                uint16_t height   = 0;
+                uint16_t nbcolors = 0;
+                m_itread = utils::ReadIntFromBytes( width,    m_itread, m_itend );
+                m_itread = utils::ReadIntFromBytes( height,   m_itread, m_itend );
+                m_itread = utils::ReadIntFromBytes( nbcolors, m_itread, m_itend );
+
+                frm.setPixelResolution( width, height );
+                frm.getPalette() = (nbcolors != 0)? ParsePalette(nbcolors) : sprpal;
+                ParsePixels( frm );
+            }
+        }
+
+        template<class _IMG_t>
+            void ParsePixels( _IMG_t & frm )
+        {
+            const unsigned int bpp      = _IMG_t::pixel_t::GetBitsPerPixel();
+            const size_t       nbpixels = static_cast<size_t>(frm.getNbPixelWidth()) * frm.getNbPixelHeight();
+
+            if( bpp == 4 )
+            {
+                EnsureAvailable( (nbpixels + 1) / 2, "frame pixels" );
+                for( size_t i = 0; i < nbpixels; i += 2, ++m_itread )
+                {
+                    frm[i] = (*m_itread) & 0xF;
+                    if( i + 1 < nbpixels )
+                        frm[i + 1] = ((*m_itread) >> 4) & 0xF;
+                }
+            }
+            else
+            {
+                EnsureAvailable( nbpixels, "frame pixels" );
+                for( size_t i = 0; i < nbpixels; ++i, ++m_itread )
+                    frm[i] = *m_itread;
+            }
+        }
+
+    private:
+        init_t                           m_itread;
+        init_t                           m_itend;
+        eSpriteImgType                   m_sprty;
+        SprInfo                          m_info;
+        std::array<uint32_t, NbCounts>   m_counts;
+    };
+
+//==============================================================================================
+// Functions
+//==============================================================================================
+    std::vector<uint8_t> SerializeSpriteToBinary( const BaseSprite * srcspr )
+    {
+        auto spritety = srcspr->getSpriteType();
+
+        if( spritety == eSpriteImgType::spr4bpp )
+        {
+            const SpriteData<gimg::tiled_image_i4bpp>* ptr = dynamic_cast<const SpriteData<gimg::tiled_image_i4bpp>*>(srcspr);
+            return SpriteBinaryWriter<SpriteData<gimg::tiled_image_i4bpp>>(*ptr).Write();
+        }
+        else if( spritety == eSpriteImgType::spr8bpp )
+        {
+            const SpriteData<gimg::tiled_image_i8bpp>* ptr = dynamic_cast<const SpriteData<gimg::tiled_image_i8bpp>*>(srcspr);
+            return SpriteBinaryWriter<SpriteData<gimg::tiled_image_i8bpp>>(*ptr).Write();
+        }
+
+        throw runtime_error( "SerializeSpriteToBinary(): Unsupported sprite type!" );
+    }
+
+    std::unique_ptr<BaseSprite> ParseSpriteFromBinary( const std::vector<uint8_t> & data )
+    {
+        return SpriteBinaryParser(data).Parse();
+    }
+
+    void ExportSpriteToBinary( const BaseSprite * srcspr, const std::string & filepath )
+    {
+        utils::io::WriteByteVectorToFile( filepath, SerializeSpriteToBinary(srcspr) );
+
+        if( utils::LibWide().isLogOn() )
+            clog << "Exported sprite with " <<srcspr->getNbFrames() <<" frames to binary sprite \"" <<filepath <<"\"\n";
+    }
+
+    std::unique_ptr<BaseSprite> ImportSpriteFromBinary( const std::string & filepath )
+    {
+        return ParseSpriteFromBinary( utils::io::ReadFileToByteVector(filepath) );
+    }
+
+    bool IsSpriteBinaryData( std::vector<uint8_t>::const_iterator itbeg, std::vector<uint8_t>::const_iterator itend )
+    {
+        if( std::distance( itbeg, itend ) < static_cast<ptrdiff_t>(sizeof(SPRITE_Binary_MagicNumber)) )
+            return false;
+        return utils::ReadIntFromBytes<uint32_t>( itbeg, itend, false ) == SPRITE_Binary_MagicNumber;
+    }
+
+};};
@@ -3,18 +3,23 @@
 #include <ppmdu/containers/tiled_image.hpp>
 #include <ext_fmts/png_io.hpp>
 #include <ext_fmts/riff_palette.hpp>
+#include <utils/file_sink.hpp>
 #include <utils/poco_wrapper.hpp>
 #include <utils/library_wide.hpp>
+#include <utils/trace_profiler.hpp>
 #include <vector>
 #include <string>
 #include <iomanip>
 #include <iostream>
 #include <sstream>
 #include <fstream>
+#include <algorithm>
+#include <cmath>
 #include <Poco/File.h>
 #include <Poco/Path.h>
 #include <Poco/DirectoryIterator.h>
 #include <Poco/Exception.h>
+#include <pugixml.hpp>
 using namespace std;
 using utils::io::eSUPPORT_IMG_IO;
 
@@ -103,6 +108,209 @@ namespace pmd2{ namespace graphics
     }
 
 
+//=============================================================================================
+//  Sprite Atlas
+//=============================================================================================
+    namespace SpriteAtlasXMLStrings
+    {
+        static const string XML_ROOT_ATLAS   = "SpriteAtlas";
+        static const string XML_NODE_PALLIST = "Palettes";
+        static const string XML_NODE_PAL     = "Palette";
+        static const string XML_NODE_FRAME   = "Frame";
+        static const string XML_ATTR_WIDTH   = "w";
+        static const string XML_ATTR_HEIGHT  = "h";
+        static const string XML_ATTR_X       = "x";
+        static const string XML_ATTR_Y       = "y";
+        static const string XML_ATTR_PAL     = "pal";
+    };
+
+    /**************************************************************
+    **************************************************************/
+    inline uint32_t RoundUpToTile( uint32_t val )
+    {
+        return (val + 7u) & ~7u;
+    }
+
+    /**************************************************************
+        Shelf packing. Frames are sorted by decreasing height, and placed
+        left to right on shelves as high as the first frame placed on them.
+        The sheet is made roughly square.
+    **************************************************************/
+    SpriteAtlasManifest PackSpriteAtlas( const std::vector<utils::Resolution> & frameres )
+    {
+        SpriteAtlasManifest manifest;
+        manifest.frames.resize( frameres.size() );
+
+        if( frameres.empty() )
+            return manifest;
+
+        uint64_t totalarea = 0;
+        uint32_t maxwidth  = 0;
+        for( const auto & res : frameres )
+        {
+            totalarea += static_cast<uint64_t>(RoundUpToTile(res.width)) * RoundUpToTile(res.height);
+            maxwidth   = std::max( maxwidth, RoundUpToTile(res.width) );
+        }
+
+        const uint32_t sheetwidth = std::max( maxwidth, RoundUpToTile( static_cast<uint32_t>( std::ceil( std::sqrt( static_cast<double>(totalarea) ) ) ) ) );
+
+        vector<size_t> order( frameres.size() );
+        for( size_t i = 0; i < order.size(); ++i )
+            order[i] = i;
+
+        std::stable_sort( order.begin(), order.end(), [&frameres]( size_t first, size_t second )->bool
+        {
+            if( frameres[first].height != frameres[second].height )
+                return frameres[first].height > frameres[second].height;
+            return frameres[first].width > frameres[second].width;
+        });
+
+        uint32_t curx        = 0;
+        uint32_t shelfy      = 0;
+        uint32_t shelfheight = 0;
+
+        for( size_t index : order )
+        {
+            const uint32_t w = RoundUpToTile(frameres[index].width);
+            const uint32_t h = RoundUpToTile(frameres[index].height);
+
+            if( curx + w > sheetwidth )
+            {
+                shelfy      += shelfheight;
+                curx         = 0;
+                shelfheight  = 0;
+            }
+
+            SpriteAtlasFrame & frm = manifest.frames[index];
+            frm.x      = curx;
+            frm.y      = shelfy;
+            frm.width  = frameres[index].width;
+            frm.height = frameres[index].height;
+
+            curx        += w;
+            shelfheight  = std::max( shelfheight, h );
+        }
+
+        manifest.sheetwidth  = sheetwidth;
+        manifest.sheetheight = std::max( 8u, shelfy + shelfheight );
+        return manifest;
+    }
+
+    /**************************************************************
+    **************************************************************/
+    SpriteAtlasManifest ParseSpriteAtlasManifest( const std::string & manifestpath )
+    {
+        using namespace SpriteAtlasXMLStrings;
+        pugi::xml_document     doc;
+        pugi::xml_parse_result loadres = doc.load_file( manifestpath.c_str() );
+        if( !loadres )
+        {
+            stringstream sstr;
+            sstr << "ParseSpriteAtlasManifest(): Couldn't parse \"" <<manifestpath <<"\": " <<loadres.description();
+            throw runtime_error( sstr.str() );
+        }
+
+        pugi::xml_node      root = doc.child( XML_ROOT_ATLAS.c_str() );
+        SpriteAtlasManifest manifest;
+        if( !root )
+            throw runtime_error( "ParseSpriteAtlasManifest(): \"" + manifestpath + "\" is missing its root node!" );
+
+        manifest.sheetwidth  = root.attribute( XML_ATTR_WIDTH.c_str()  ).as_uint();
+        manifest.sheetheight = root.attribute( XML_ATTR_HEIGHT.c_str() ).as_uint();
+
+        //Palettes are stored as a list of "RRGGBB" hex values
+        for( pugi::xml_node palnode : root.child( XML_NODE_PALLIST.c_str() ).children( XML_NODE_PAL.c_str() ) )
+        {
+            vector<gimg::colorRGB24> pal;
+            stringstream             sstr( palnode.child_value() );
+            string                   colstr;
+            while( sstr >> colstr )
+            {
+                uint32_t rgb = static_cast<uint32_t>( std::stoul( colstr, nullptr, 16 ) );
+                pal.push_back( gimg::colorRGB24( (rgb >> 16) & 0xFF, (rgb >> 8) & 0xFF, rgb & 0xFF ) );
+            }
+            manifest.palettes.push_back( std::move(pal) );
+        }
+
+        for( pugi::xml_node frmnode : root.children( XML_NODE_FRAME.c_str() ) )
+        {
+            SpriteAtlasFrame frm;
+            frm.x       = frmnode.attribute( XML_ATTR_X.c_str()      ).as_uint();
+            frm.y       = frmnode.attribute( XML_ATTR_Y.c_str()      ).as_uint();
+            frm.width   = frmnode.attribute( XML_ATTR_WIDTH.c_str()  ).as_uint();
+            frm.height  = frmnode.attribute( XML_ATTR_HEIGHT.c_str() ).as_uint();
+            frm.palette = frmnode.attribute( XML_ATTR_PAL.c_str()    ).as_int(-1);
+
+            if( frm.x + frm.width > manifest.sheetwidth || frm.y + frm.height > manifest.sheetheight )
+            {
+                stringstream sstr;
+                sstr << "ParseSpriteAtlasManifest(): Frame #" <<manifest.frames.size() <<" in \"" <<manifestpath
+                     <<"\" is out of the bounds of the sheet!";
+                throw runtime_error( sstr.str() );
+            }
+            if( frm.palette >= static_cast<int32_t>(manifest.palettes.size()) )
+            {
+                stringstream sstr;
+                sstr << "ParseSpriteAtlasManifest(): Frame #" <<manifest.frames.size() <<" in \"" <<manifestpath
+                     <<"\" refers to palette #" <<frm.palette <<", which doesn't exist!";
+                throw runtime_error( sstr.str() );
+            }
+            manifest.frames.push_back( frm );
+        }
+
+        return manifest;
+    }
+
+    /**************************************************************
+    **************************************************************/
+    void WriteSpriteAtlasManifest( const SpriteAtlasManifest & manifest, const std::string & manifestpath )
+    {
+        using namespace SpriteAtlasXMLStrings;
+        pugi::xml_document doc;
+        pugi::xml_node     root = doc.append_child( XML_ROOT_ATLAS.c_str() );
+        root.append_attribute( XML_ATTR_WIDTH.c_str()  ) = manifest.sheetwidth;
+        root.append_attribute( XML_ATTR_HEIGHT.c_str() ) = manifest.sheetheight;
+
+        if( !manifest.palettes.empty() )
+        {
+            pugi::xml_node pallist = root.append_child( XML_NODE_PALLIST.c_str() );
+            for( const auto & pal : manifest.palettes )
+            {
+                stringstream sstr;
+                sstr <<hex <<uppercase <<setfill('0');
+                for( const auto & col : pal )
+                    sstr <<setw(6) <<( (static_cast<uint32_t>(col.red) << 16) | (static_cast<uint32_t>(col.green) << 8) | col.blue ) <<" ";
+                pallist.append_child( XML_NODE_PAL.c_str() ).append_child( pugi::node_pcdata ).set_value( sstr.str().c_str() );
+            }
+        }
+
+        for( const auto & frm : manifest.frames )
+        {
+            pugi::xml_node frmnode = root.append_child( XML_NODE_FRAME.c_str() );
+            frmnode.append_attribute( XML_ATTR_X.c_str()      ) = frm.x;
+            frmnode.append_attribute( XML_ATTR_Y.c_str()      ) = frm.y;
+            frmnode.append_attribute( XML_ATTR_WIDTH.c_str()  ) = frm.width;
+            frmnode.append_attribute( XML_ATTR_HEIGHT.c_str() ) = frm.height;
+            if( frm.palette >= 0 )
+                frmnode.append_attribute( XML_ATTR_PAL.c_str() ) = frm.palette;
+        }
+
+        if( !doc.save_file( manifestpath.c_str() ) )
+            throw runtime_error( "WriteSpriteAtlasManifest(): Couldn't write to \"" + manifestpath + "\"!" );
+    }
+
+    /**************************************************************
+    **************************************************************/
+    inline bool ArePalettesEqual( const vector<gimg::colorRGB24> & first, const vector<gimg::colorRGB24> & second )
+    {
+        return first.size() == second.size() && 
+               std::equal( first.begin(), first.end(), second.begin(), []( const gimg::colorRGB24 & a, const gimg::colorRGB24 & b )
+               {
+                   return a.red == b.red && a.green == b.green && a.blue == b.blue;
+               });
+    }
+
+
 //=============================================================================================
 //  Sprite to SpriteToDirectory Writer
 //=============================================================================================
@@ -123,7 +331,8 @@ namespace pmd2{ namespace graphics
         void WriteSpriteToDir( const string          & folderpath, 
                                eSUPPORT_IMG_IO         imgty, 
                                bool                    xmlcolorpal = false/*, 
-                               std::atomic<uint32_t> * progresscnt = nullptr*/ ) 
+                               std::atomic<uint32_t> * progresscnt = nullptr*/,
+                               bool                    useatlas    = false ) 
         {
             //Create Root Folder
             m_outDirPath = Poco::Path(folderpath);
@@ -149,7 +358,7 @@ namespace pmd2{ namespace graphics
             stats.totalAnimFrms = totalnbfrms;
             stats.totalAnimSeqs = totalnbseqs;
 
-            ExportFrames(imgty, stats.propFrames );
+            ExportFrames(imgty, stats.propFrames, useatlas );
 
             if( !xmlcolorpal )
                 ExportPalette();
@@ -161,7 +370,7 @@ namespace pmd2{ namespace graphics
 
         /**************************************************************
         **************************************************************/
-        void ExportFrames( eSUPPORT_IMG_IO imgty, uint32_t proportionofwork )
+        void ExportFrames( eSUPPORT_IMG_IO imgty, uint32_t proportionofwork, bool useatlas )
         {
             Poco::Path imgdir = Poco::Path(m_outDirPath);
             imgdir.append(SPRITE_IMGs_DIR);
@@ -170,6 +379,12 @@ namespace pmd2{ namespace graphics
             if( !directory.exists() )
                 directory.createDirectory();
 
+            if( useatlas )
+            {
+                ExportFramesAsAtlas(imgdir);
+                return;
+            }
+
             switch( imgty )
             {
                 case eSUPPORT_IMG_IO::BMP:
@@ -199,6 +414,7 @@ namespace pmd2{ namespace graphics
             //uint32_t     progressBefore = 0; //Save a little snapshot of the progress
             const auto & frames         = m_inSprite.getFrames();
             Poco::Path   outimg(outdirpath);
+            utils::io::FileSink sink;   //Encode the next frames while the previous ones are written
 
             //if( m_pProgress != nullptr )
             //    progressBefore = m_pProgress->load();
@@ -209,7 +425,7 @@ namespace pmd2{ namespace graphics
                 //Build filenmame
                 sstrname <<setw(4) <<setfill('0') <<i <<"." <<utils::io::PNG_FileExtension;
                 //Export
-                utils::io::ExportToPNG( frames[i], Poco::Path(outimg).append(sstrname.str()).toString() );
+                sink.Write( Poco::Path(outimg).append(sstrname.str()).toString(), utils::io::EncodeToPNG( frames[i] ) );
 
                 if( utils::LibWide().isLogOn() )
                     clog << "Exported frame " <<i <<": " <<frames[i].getNbPixelWidth() <<"x" <<frames[i].getNbPixelHeight() <<", to " <<Poco::Path(outimg).append(sstrname.str()).toString() <<"\n";
@@ -217,6 +433,63 @@ namespace pmd2{ namespace graphics
                 //if( m_pProgress != nullptr )
                 //    m_pProgress->store( progressBefore + (proportionofwork * (i+1) ) / frames.size() ); 
             }
+            sink.Flush();
+        }
+
+        /**************************************************************
+            Packs all the frames onto a single PNG sheet, and writes the
+            position of each frames into the atlas manifest.
+            The sheet uses the first frame's palette. Frames with a 
+            different palette get theirs stored in the manifest.
+        **************************************************************/
+        void ExportFramesAsAtlas( const Poco::Path & outdirpath )
+        {
+            typedef typename sprite_t::img_t img_t;
+            const auto & frames = m_inSprite.getFrames();
+
+            vector<utils::Resolution> frameres;
+            frameres.reserve( frames.size() );
+            for( const auto & frm : frames )
+                frameres.push_back( utils::Resolution{ frm.getNbPixelWidth(), frm.getNbPixelHeight() } );
+
+            SpriteAtlasManifest manifest = PackSpriteAtlas(frameres);
+            img_t               sheet;
+            sheet.setPixelResolution( manifest.sheetwidth, manifest.sheetheight );
+
+            if( !frames.empty() )
+                sheet.getPalette() = frames.front().getPalette();
+            else
+                sheet.getPalette() = m_inSprite.getPalette();
+
+            for( size_t i = 0; i < frames.size(); ++i )
+            {
+                const img_t      & frm = frames[i];
+                SpriteAtlasFrame & rec = manifest.frames[i];
+
+                for( uint32_t y = 0; y < rec.height; ++y )
+                {
+                    for( uint32_t x = 0; x < rec.width; ++x )
+                        sheet.getPixel( rec.x + x, rec.y + y ) = frm.getPixel( x, y );
+                }
+
+                if( !ArePalettesEqual( frm.getPalette(), sheet.getPalette() ) )
+                {
+                    auto itfound = std::find_if( manifest.palettes.begin(), manifest.palettes.end(), [&frm]( const vector<gimg::colorRGB24> & pal )
+                    {
+                        return ArePalettesEqual( pal, frm.getPalette() );
+                    });
+                    rec.palette = static_cast<int32_t>( std::distance( manifest.palettes.begin(), itfound ) );
+                    if( itfound == manifest.palettes.end() )
+                        manifest.palettes.push_back( frm.getPalette() );
+                }
+            }
+
+            if( !frames.empty() )
+                utils::io::ExportToPNG( sheet, Poco::Path(outdirpath).append(SPRITE_Atlas_fname).toString() );
+            WriteSpriteAtlasManifest( manifest, Poco::Path(outdirpath).append(SPRITE_AtlasManifest_fname).toString() );
+
+            if( utils::LibWide().isLogOn() )
+                clog << "Exported " <<frames.size() <<" frames to a " <<manifest.sheetwidth <<"x" <<manifest.sheetheight <<" atlas, in " <<outdirpath.toString() <<"\n";
         }
 
         /**************************************************************
@@ -321,14 +594,26 @@ namespace pmd2{ namespace graphics
                                        bool                    parsexmlpal   = false,
                                        bool                    bNoResAutoFix = false )
         {
+            utils::TraceScope trace("sprite import directory");
             //!! This must run first !!
             m_inDirPath = Poco::Path( directorypath );
             /*m_pProgress = pProgress;*/
-            auto validimgslist = ListValidImages(readImgByIndex);
+            Poco::File atlasmanifest( Poco::Path(m_inDirPath).append(SPRITE_IMGs_DIR).append(SPRITE_AtlasManifest_fname) );
+
+            if( atlasmanifest.exists() && atlasmanifest.isFile() )
+            {
+                SpriteAtlasManifest manifest = ParseSpriteAtlasManifest( atlasmanifest.path() );
+                ParseXML(parsexmlpal, manifest.frames.size() );
+                ReadAtlas(manifest);
+            }
+            else
+            {
+                auto validimgslist = ListValidImages(readImgByIndex);
 
-            //Parse the xml first to help with reading image with some formats
-            ParseXML(parsexmlpal, validimgslist.size() );
-            ReadImages(validimgslist);
+                //Parse the xml first to help with reading image with some formats
+                ParseXML(parsexmlpal, validimgslist.size() );
+                ReadImages(validimgslist);
+            }
 
             //Check and fix missing/differing resolution between meta-frames and images
             if( !bNoResAutoFix )
@@ -484,6 +769,52 @@ namespace pmd2{ namespace graphics
             }
         }
 
+        /**************************************************************
+            Decodes the atlas sheet once, and cuts all the frames from it.
+        **************************************************************/
+        void ReadAtlas( const SpriteAtlasManifest & manifest )
+        {
+            typedef typename sprite_t::img_t img_t;
+            m_outSprite.m_frames.reserve( manifest.frames.size() );
+
+            if( manifest.frames.empty() )
+                return;
+
+            img_t  sheet;
+            string sheetpath = Poco::Path(m_inDirPath).append(SPRITE_IMGs_DIR).append(SPRITE_Atlas_fname).toString();
+            utils::io::ImportFromPNG( sheet, sheetpath );
+
+            if( sheet.getNbPixelWidth() < manifest.sheetwidth || sheet.getNbPixelHeight() < manifest.sheetheight )
+            {
+                stringstream sstrerr;
+                sstrerr << "ERROR: Atlas sheet \"" <<sheetpath <<"\" is " <<sheet.getNbPixelWidth() <<"x" <<sheet.getNbPixelHeight() 
+                        <<", but its manifest expects at least " <<manifest.sheetwidth <<"x" <<manifest.sheetheight <<" !";
+                throw runtime_error(sstrerr.str());
+            }
+
+            for( const auto & rec : manifest.frames )
+            {
+                img_t curfrm;
+                curfrm.setPixelResolution( rec.width, rec.height );
+
+                for( uint32_t y = 0; y < rec.height; ++y )
+                {
+                    for( uint32_t x = 0; x < rec.width; ++x )
+                        curfrm.getPixel( x, y ) = sheet.getPixel( rec.x + x, rec.y + y );
+                }
+
+                if( rec.palette >= 0 )
+                    curfrm.getPalette() = manifest.palettes[rec.palette];
+                else
+                    curfrm.getPalette() = sheet.getPalette();
+
+                m_outSprite.m_frames.push_back( std::move(curfrm) );
+            }
+
+            if( utils::LibWide().isLogOn() )
+                clog << "Read " <<manifest.frames.size() <<" frames from atlas " <<sheetpath <<"\n";
+        }
+
         /**************************************************************
         **************************************************************/
         void ReadAnImage( const Poco::File & imgfile )
@@ -583,10 +914,12 @@ namespace pmd2{ namespace graphics
                                       const std::string                         & outpath, 
                                       utils::io::eSUPPORT_IMG_IO                  imgtype,
                                       bool                                        usexmlpal,
-                                      std::atomic<uint32_t>                     * progresscnt ) 
+                                      std::atomic<uint32_t>                     * progresscnt,
+                                      bool                                        useatlas ) 
     {
+        utils::TraceScope trace("sprite export directory");
         SpriteToDirectory<SpriteData<gimg::tiled_image_i4bpp>> mywriter(srcspr);
-        mywriter.WriteSpriteToDir( outpath, imgtype, usexmlpal/*, progresscnt*/ ); 
+        mywriter.WriteSpriteToDir( outpath, imgtype, usexmlpal/*, progresscnt*/, useatlas ); 
     }
 
     /**************************************************************
@@ -596,10 +929,12 @@ namespace pmd2{ namespace graphics
                                      const std::string                         & outpath, 
                                      utils::io::eSUPPORT_IMG_IO                  imgtype,
                                      bool                                        usexmlpal,
-                                     std::atomic<uint32_t>                     * progresscnt )
+                                     std::atomic<uint32_t>                     * progresscnt,
+                                     bool                                        useatlas )
     {
+        utils::TraceScope trace("sprite export directory");
         SpriteToDirectory<SpriteData<gimg::tiled_image_i8bpp>> mywriter(srcspr);
-        mywriter.WriteSpriteToDir( outpath, imgtype, usexmlpal/*, progresscnt*/ ); 
+        mywriter.WriteSpriteToDir( outpath, imgtype, usexmlpal/*, progresscnt*/, useatlas ); 
     }
 
 
@@ -609,7 +944,8 @@ namespace pmd2{ namespace graphics
                                       const std::string          & outpath, 
                                       utils::io::eSUPPORT_IMG_IO   imgtype,
                                       bool                         usexmlpal,
-                                      std::atomic<uint32_t>      * progresscnt )
+                                      std::atomic<uint32_t>      * progresscnt,
+                                      bool                         useatlas )
     {
         //
         auto spritety = srcspr->getSpriteType();
@@ -617,12 +953,12 @@ namespace pmd2{ namespace graphics
         if( spritety == eSpriteImgType::spr4bpp )
         {
             const SpriteData<gimg::tiled_image_i4bpp>* ptr = dynamic_cast<const SpriteData<gimg::tiled_image_i4bpp>*>(srcspr);
-            ExportSpriteToDirectory( (*ptr), outpath, imgtype, usexmlpal/*, progresscnt*/ );
+            ExportSpriteToDirectory( (*ptr), outpath, imgtype, usexmlpal, nullptr, useatlas );
         }
         else if( spritety == eSpriteImgType::spr8bpp )
         {
             const SpriteData<gimg::tiled_image_i8bpp>* ptr = dynamic_cast<const SpriteData<gimg::tiled_image_i8bpp>*>(srcspr);
-            ExportSpriteToDirectory( (*ptr), outpath, imgtype, usexmlpal/*, progresscnt*/ );
+            ExportSpriteToDirectory( (*ptr), outpath, imgtype, usexmlpal, nullptr, useatlas );
         }
     }
 
@@ -1,6 +1,7 @@
 #include <ppmdu/fmts/at4px.hpp>
 //#include <ppmdu/pmd2/pmd2_filetypes.hpp>
 #include <ppmdu/fmts/px_compression.hpp>
+#include <ppmdu/fmts/px_compression_cache.hpp>
 //#include <ppmdu/pmd2/pmd2_palettes.hpp>
 //#include <ppmdu/pmd2/pmd2_image_formats.hpp>
 #include <types/content_type_analyser.hpp>
@@ -241,13 +242,14 @@ namespace filetypes
         buffer.reserve( at4px_header::HEADER_SZ + inputsz + (inputsz / 8u) );
 
         ////Compress data
-        pxinf = compression::CompressPX( itinputbeg, 
-                                         itinputend, 
-                                         itbuffer, 
-                                         complvl, 
-                                         bzealous, 
-                                         bdisplayProgress,
-                                         blogenable );
+        pxinf = compression::CompressPXCached( compression::ePXContainer::AT4PX,
+                                               itinputbeg, 
+                                               itinputend, 
+                                               itbuffer, 
+                                               complvl, 
+                                               bzealous, 
+                                               bdisplayProgress,
+                                               blogenable );
 
         //Write header, before the compressed data
         at4px_header headr = PXinfoToAT4PXHeader( pxinf );
@@ -277,13 +279,14 @@ namespace filetypes
         buffer.resize(at4px_header::HEADER_SZ); //Reserve the header size, to come back and write it later
         
         ////Compress data
-        pxinf = compression::CompressPX( itinputbeg, 
-                                         itinputend, 
-                                         itbuffer, 
-                                         complvl, 
-                                         bzealous, 
-                                         bdisplayProgress,
-                                         blogenable );
+        pxinf = compression::CompressPXCached( compression::ePXContainer::AT4PX,
+                                               itinputbeg, 
+                                               itinputend, 
+                                               itbuffer, 
+                                               complvl, 
+                                               bzealous, 
+                                               bdisplayProgress,
+                                               blogenable );
 
         //Write header, before the compressed data
         at4px_header headr = PXinfoToAT4PXHeader( pxinf );
@@ -493,6 +496,12 @@ namespace filetypes
                                vector<uint8_t>::const_iterator   itdataend,
                                const std::string & filext);
 
+        //Only the first 4 bytes of "AT4PX"
+        virtual std::vector<uint32_t> getMagicNumbers()const
+        {
+            return { 0x41543450 }; //"AT4P"
+        }
+
     private:
         cntRID_t m_myID;
     };
@@ -621,6 +630,12 @@ namespace filetypes
             return false;
         }
 
+        //The AT4PX sub-header
+        virtual std::vector<uint32_t> getMagicNumbers()const
+        {
+            return { 0x41543450 }; //"AT4P"
+        }
+
     private:
         cntRID_t m_myID;
     };
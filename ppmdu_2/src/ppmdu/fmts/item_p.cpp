@@ -73,11 +73,10 @@ namespace pmd2 {namespace filetypes
             vector<uint8_t> data = utils::io::ReadFileToByteVector( path );
 
             //Parse header
-            sir0_header hdr;
-            hdr.ReadFromContainer(data.begin(), data.end());
+            const SIR0View sir0(data);
 
-            const uint32_t NbEntries = (hdr.ptrPtrOffsetLst - hdr.subheaderptr) / stats::ItemDataLen_EoS;
-            vector<uint8_t>::const_iterator itCur = std::next(data.begin(), hdr.subheaderptr);
+            const uint32_t NbEntries = (sir0.ContentEnd() - sir0.SubHeaderOffset()) / stats::ItemDataLen_EoS;
+            vector<uint8_t>::const_iterator itCur = std::next(data.begin(), sir0.SubHeaderOffset());
             vector<uint8_t>::const_iterator itEnd = data.end();
             itemdat.resize(NbEntries);
 
@@ -106,11 +105,10 @@ namespace pmd2 {namespace filetypes
             vector<uint8_t> data = utils::io::ReadFileToByteVector( path );
 
             //Parse header
-            sir0_header hdr;
-            hdr.ReadFromContainer(data.begin(), data.end());
+            const SIR0View sir0(data);
 
-            const uint32_t NbEntries = (hdr.ptrPtrOffsetLst - hdr.subheaderptr) / stats::ExclusiveItemDataLen; //Nb of entries in the exclusive item data file
-            vector<uint8_t>::const_iterator itdatbeg = std::next(data.begin(), hdr.subheaderptr);
+            const uint32_t NbEntries = (sir0.ContentEnd() - sir0.SubHeaderOffset()) / stats::ExclusiveItemDataLen; //Nb of entries in the exclusive item data file
+            vector<uint8_t>::const_iterator itdatbeg = std::next(data.begin(), sir0.SubHeaderOffset());
             vector<uint8_t>::const_iterator itdatend = data.end();
 
             size_t cntitemID = ExclusiveItemBaseDataIndex; // cntitemID = Counter for the actual item id in the database (Exlusive items begin at a specific index)
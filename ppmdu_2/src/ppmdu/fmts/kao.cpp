@@ -15,6 +15,9 @@
 #include <Poco/File.h>
 #include <Poco/Path.h>
 #include <utils/gbyteutils.hpp>
+#include <utils/parallel_tasks.hpp>
+#include <mutex>
+#include <future>
 using namespace std;
 using namespace gimg;
 using namespace pmd2;
@@ -52,6 +55,7 @@ namespace filetypes
 
     void KaoParser::operator()( const std::string & importfrom, CKaomado & importto )
     {
+        utils::TraceScope trace("kao parse");
         Poco::File filein(importfrom);
         m_pImportTo  = &importto;
         m_pInputPath = &importfrom;
@@ -120,7 +124,9 @@ namespace filetypes
                                                                    // and ensuring easier/faster rebuilding of the ToC and file, by
                                                                    // avoiding having to update all references in the ToC.
 
-        if(!m_bQuiet)
+        if( m_bParallel )
+            ParseKaomadoParallel();
+        else if(!m_bQuiet)
         {
             cout<<"Parsing kaomado file..\n";
             for( std::size_t i = 0; i < toc.size(); )
@@ -143,6 +149,102 @@ namespace filetypes
 
     }
 
+    void KaoParser::ParseKaomadoParallel()
+    {
+        auto & toc    = m_pImportTo->m_tableofcontent;
+        auto & imgdat = m_pImportTo->m_imgdata;
+        auto   ittoc  = m_itInBeg;
+        vector<uint8_t>::const_iterator itend = m_kaomadoBuff.end();
+
+        //#1 - Read the whole ToC first, so we know which slot of the data vector each portraits goes into
+        vector<pair<tocsz_t,tocsubentry_t>> portraits; //Data vector index, and file offset of each portraits
+        portraits.reserve(imgdat.size());
+
+        for( tocsz_t cptentry = 0; cptentry < toc.size(); ++cptentry )
+        {
+            vector<tocsubentry_t> & currententry = toc[cptentry]._portraitsentries;
+            for( tocsz_t cptsubentry = 0; cptsubentry < currententry.size(); ++cptsubentry )
+            {
+                tocsubentry_t tocreadentry = utils::ReadIntFromBytes<tocsubentry_t>( ittoc, itend );
+
+                if( CKaomado::isToCSubEntryValid(tocreadentry) )
+                {
+                    tocsz_t entryinsertpos = (cptentry * DEF_KAO_TOC_ENTRY_NB_PTR) + cptsubentry;
+                    portraits.push_back( make_pair( entryinsertpos, tocreadentry ) );
+                    m_pImportTo->registerToCEntry( cptentry, cptsubentry, entryinsertpos );
+                }
+                else
+                    currententry[cptsubentry] = CKaomado::GetInvalidToCEntry();
+            }
+        }
+
+        //#2 - Decompress the portraits. Each tasks has its own buffer, and writes only to its own slots of the data vector.
+        if( !m_bQuiet )
+            cout<<"Parsing kaomado file..\n";
+
+        utils::AsyncTaskHandler taskhandler;
+        vector<future<void>>    taskresults;
+        mutex                   mtxprogress;
+        size_t                  cntdone = 0;
+
+        for( size_t cntbeg = 0; cntbeg < portraits.size(); cntbeg += DEF_KAO_TOC_ENTRY_NB_PTR )
+        {
+            const size_t cntend = std::min( cntbeg + DEF_KAO_TOC_ENTRY_NB_PTR, portraits.size() );
+            utils::AsyncTaskHandler::task_t task( [this, &portraits, &imgdat, &mtxprogress, &cntdone, cntbeg, cntend]()
+            {
+                vector<uint8_t> imgbuf;
+                for( size_t cnt = cntbeg; cnt < cntend; ++cnt )
+                    ParsePortrait( portraits[cnt].second, imgdat[portraits[cnt].first], imgbuf );
+
+                if( !m_bQuiet )
+                {
+                    lock_guard<mutex> lck(mtxprogress);
+                    cntdone += (cntend - cntbeg);
+                    cout<<"\r" << ((cntdone * 100) / portraits.size())  <<"%";
+                }
+            });
+            taskresults.push_back(task.get_future());
+            taskhandler.QueueTask(std::move(task));
+        }
+
+        if( !taskhandler.empty() )
+        {
+            taskhandler.Start();
+            taskhandler.WaitTasksFinished();
+            taskhandler.WaitStop();
+        }
+
+        //Rethrow the first exception a task might have run into
+        for( auto & fut : taskresults )
+            fut.get();
+
+        if( !m_bQuiet )
+            cout << "\n";
+    }
+
+    void KaoParser::ParsePortrait( tocsubentry_t offset, portrait_t & outimg, std::vector<uint8_t> & imgbuf )
+    {
+        vector<uint8_t>::const_iterator itend = m_kaomadoBuff.end();
+        uint32_t entrylen    = GetLenRawPortraitData( m_itInBeg, itend, offset );
+        auto     itentryread = m_itInBeg + offset;
+        auto     itentryend  = m_itInBeg + (offset + entrylen);
+        auto     itpalend    = m_itInBeg + (offset + KAO_PORTRAIT_PAL_NB_COL * KAO_PORTRAIT_PAL_BPC);
+
+        //A. Read the palette
+        graphics::ReadRawPalette_RGB24_As_RGB24( itentryread, itpalend, outimg.getPalette() );
+
+        //B. Read the image
+        DecompressAT4PX( itpalend, itentryend, imgbuf );
+
+        //C. Parse the image. 
+        // Image pixels seems to be in little endian, and need to be converted to big endian
+        ParseTiledImg<portrait_t>( imgbuf.begin(), 
+                                   imgbuf.end(), 
+                                   graphics::RES_PORTRAIT, 
+                                   outimg, 
+                                   KAO_PORTRAIT_PIXEL_ORDER_REVERSED );
+    }
+
     vector<uint8_t>::const_iterator KaoParser::ParseToCEntry( std::vector<kao_toc_entry>::size_type  & indexentry, vector<uint8_t>::const_iterator itrawtocentry )
     {
         //Make aliases
@@ -169,36 +271,14 @@ namespace filetypes
             //Avoid null and invalid entries
             if( CKaomado::isToCSubEntryValid(tocreadentry) )
             {
-                uint32_t entrylen       = GetLenRawPortraitData( m_itInBeg, itend, tocreadentry );
                 tocsz_t  entryinsertpos = (indexentry * DEF_KAO_TOC_ENTRY_NB_PTR) + cptsubentry; //Position to insert stuff for this entry in the data vector
-                data_t & tmpPortrait    = imgdat[entryinsertpos]; //a little reference to make things easier
-                auto     itentryread    = m_itInBeg + tocreadentry;
-                auto     itentryend     = m_itInBeg + (tocreadentry + entrylen);
-                auto     itpalend       = m_itInBeg + (tocreadentry + KAO_PORTRAIT_PAL_NB_COL * KAO_PORTRAIT_PAL_BPC);
-
-                //A. Read the palette
-                graphics::ReadRawPalette_RGB24_As_RGB24( itentryread, itpalend, tmpPortrait.getPalette() );
-
-                if(m_bVerbose)
-                    cout << " ..Pal OK!";
 
-                //B. Read the image
-                DecompressAT4PX( itpalend, itentryend, m_imgBuffer );
+                //Read the palette and decompress the image
+                ParsePortrait( tocreadentry, imgdat[entryinsertpos], m_imgBuffer );
 
                 if(m_bVerbose)
                     cout << " ..Decompress OK ("  <<m_imgBuffer.size() <<"b)!";
 
-                //C. Parse the image. 
-                // Image pixels seems to be in little endian, and need to be converted to big endian
-                ParseTiledImg<data_t>( m_imgBuffer.begin(), 
-                                       m_imgBuffer.end(), 
-                                       graphics::RES_PORTRAIT, 
-                                       tmpPortrait, 
-                                       KAO_PORTRAIT_PIXEL_ORDER_REVERSED );
-
-                if(m_bVerbose)
-                    cout << " ..Img OK!";
-
                 //Refer to the new entry
                 m_pImportTo->registerToCEntry( indexentry, cptsubentry, entryinsertpos );
 
@@ -228,6 +308,7 @@ namespace filetypes
 
     void KaoParser::ImportFromFolders()
     {
+        utils::TraceScope trace("kao import folders");
         auto & toc    =  m_pImportTo->m_tableofcontent;
         auto & imgdat =  m_pImportTo->m_imgdata;
 
@@ -420,12 +501,14 @@ namespace filetypes
         m_exportType       = eSUPPORT_IMG_IO::PNG;
         m_curOffTocSub     = 0;
         m_lastNullEntryVal = 0;
+        m_pSink            = nullptr;
         m_imgBuff.resize(0);
         m_outBuff.resize(0);
     }
 
     vector<uint8_t> KaoWriter::operator()( const CKaomado & exportfrom )
     {
+        utils::TraceScope trace("kao write");
         Reset();
         m_pExportFrom = &exportfrom;
         return WriteToKaomado();
@@ -434,6 +517,7 @@ namespace filetypes
     //This will export to a kaomado.kao file
     void KaoWriter::operator()( const CKaomado & exportfrom, const string & exportto )
     {
+        utils::TraceScope trace("kao write");
         Reset();
         m_pExportFrom  = &exportfrom;
         vector<uint8_t> result = WriteToKaomado();
@@ -455,11 +539,16 @@ namespace filetypes
 
     void KaoWriter::ExportToFolders()
     {
+        utils::TraceScope trace("kao export folders");
         //#1 - Go through the ToC, and make a sub-folder for each ToC entry
         //     with its index as name.
 
+        //The portraits are written by the sink, while the next ones are converted
+        utils::io::FileSink sink;
+        m_pSink = &sink;
+
         //Make the parent folder
-        utils::DoCreateDirectory( *m_pDestination );
+        sink.PrepareDirectory( *m_pDestination );
         
         if( !m_bQuiet )
             cout<<"Exporting entries to folder..\n";
@@ -493,6 +582,9 @@ namespace filetypes
             }
 
         }
+        sink.Flush();
+        m_pSink = nullptr;
+
         if( !m_bQuiet || m_bVerbose )
             cout<<"\n";
     }
@@ -517,7 +609,7 @@ namespace filetypes
                 //Create a folder if we haven't yet
                 if(!bmadeafolder)
                 {
-                    utils::DoCreateDirectory(directoryname);
+                    m_pSink->PrepareDirectory(directoryname);
                     bmadeafolder = true;
                 }
 
@@ -540,7 +632,7 @@ namespace filetypes
                 else //If all else fail, export to PNG !
                 {
                     strsOutputPath <<"." << PNG_FileExtension;
-                    ExportToPNG( m_pExportFrom->m_imgdata[entry[j]], strsOutputPath.str() );
+                    m_pSink->Write( strsOutputPath.str(), EncodeToPNG( m_pExportFrom->m_imgdata[entry[j]] ) );
                 }
 
                 if( m_bVerbose )
@@ -585,6 +677,11 @@ namespace filetypes
         if( !m_bQuiet )
             cout << "Building kaomado file..\n";
 
+        //In parallel mode, compress everything first. The data is then appended in order below, like in sequential mode.
+        vector<vector<uint8_t>> encoded;
+        if( m_bParallel )
+            encoded = EncodePortraitsParallel();
+
         for( const auto& tocentry : m_pExportFrom->m_tableofcontent )
         {
             m_curOffTocSub = curoffsetToc; //Where we'll be writing our next sub-entry
@@ -601,7 +698,10 @@ namespace filetypes
                 {
                     cout <<"\tSubEntry #" <<right <<setw(3) <<setfill('0') <<cptsubentry <<" : ";
                 }
-                WriteAPortrait( portrait );
+                if( m_bParallel && CKaomado::isToCSubEntryValid( portrait ) )
+                    WriteAPortrait( portrait, &encoded[portrait] );
+                else
+                    WriteAPortrait( portrait );
                 ++cptsubentry;
             }
 
@@ -632,54 +732,117 @@ namespace filetypes
         return std::move( temp );
     }
 
-    void KaoWriter::WriteAPortrait( const kao_toc_entry::subentry_t & portrait )
+    vector<vector<uint8_t>> KaoWriter::EncodePortraitsParallel()
     {
-        //First set both to the last valid end of data offset. "null" them out basically!
-        tocsubentry_t portraitpointer = m_lastNullEntryVal; //The offset from the beginning where we'll insert any new data!
+        const auto &            imgdat = m_pExportFrom->m_imgdata;
+        vector<vector<uint8_t>> encoded( imgdat.size() );
+        vector<bool>            bused  ( imgdat.size(), false );
 
-        //Make sure we output a computed file offset for valid entry, and just the entry's value if the pointer value is invalid
-        if( CKaomado::isToCSubEntryValid( portrait ) )
+        //Only compress the images the ToC refers to, and compress each of them only once
+        for( const auto & tocentry : m_pExportFrom->m_tableofcontent )
         {
-            //If we have data to write
-            auto & currentimg = m_pExportFrom->m_imgdata[portrait];
-            portraitpointer   = m_outBuff.size(); //Set the current size as the offset to insert our stuff!
-
-            if( m_bVerbose )
+            for( const auto & portrait : tocentry._portraitsentries )
             {
-                cout <<hex <<showbase <<portraitpointer <<dec <<noshowbase;
+                if( CKaomado::isToCSubEntryValid( portrait ) )
+                    bused[portrait] = true;
             }
+        }
+
+        vector<size_t> toencode;
+        for( size_t cntimg = 0; cntimg < bused.size(); ++cntimg )
+        {
+            if( bused[cntimg] )
+                toencode.push_back(cntimg);
+        }
+
+        if( !m_bQuiet )
+            cout << "Compressing " <<toencode.size() <<" portraits..\n";
 
-            //#3.1 - Write palette
-            graphics::WriteRawPalette_RGB24_As_RGB24( m_itOutBuffPushBack, currentimg.getPalette().begin(), currentimg.getPalette().end() );
+        //Each task has its own work buffer, and writes only to the output vectors of its own images
+        utils::AsyncTaskHandler taskhandler;
+        vector<future<void>>    taskresults;
+        mutex                   mtxprogress;
+        size_t                  cntdone = 0;
 
-            if( m_bVerbose )
+        for( size_t cntbeg = 0; cntbeg < toencode.size(); cntbeg += DEF_KAO_TOC_ENTRY_NB_PTR )
+        {
+            const size_t cntend = std::min( cntbeg + DEF_KAO_TOC_ENTRY_NB_PTR, toencode.size() );
+            utils::AsyncTaskHandler::task_t task( [this, &imgdat, &encoded, &toencode, &mtxprogress, &cntdone, cntbeg, cntend]()
             {
-                cout <<" ..PalOK!";
-            }
+                vector<uint8_t> imgbuf;
+                for( size_t cnt = cntbeg; cnt < cntend; ++cnt )
+                {
+                    const size_t imgindex = toencode[cnt];
+                    EncodePortrait( imgdat[imgindex], std::back_inserter(encoded[imgindex]), imgbuf );
+                }
 
-            //Keep track of where the at4px begins
-            auto offsetafterpal = m_outBuff.size();
+                if( !m_bQuiet )
+                {
+                    lock_guard<mutex> lck(mtxprogress);
+                    cntdone += (cntend - cntbeg);
+                    cout<<"\r" << (cntdone * 100) / toencode.size() <<"%";
+                }
+            });
+            taskresults.push_back(task.get_future());
+            taskhandler.QueueTask(std::move(task));
+        }
+
+        if( !taskhandler.empty() )
+        {
+            taskhandler.Start();
+            taskhandler.WaitTasksFinished();
+            taskhandler.WaitStop();
+        }
+
+        //Rethrow the first exception a task might have run into
+        for( auto & fut : taskresults )
+            fut.get();
 
-            //#3.2 - Compress the image
-            unsigned int curimgmaxsz      = (currentimg.getSizeInBits() / 8u) +
-                                            ( (currentimg.getSizeInBits() % 8u != 0)? 1u : 0u); //Add one more just in case we ever overflow a byte (fat chance..)
-            unsigned int curimgszandheadr = curimgmaxsz + at4px_header::HEADER_SZ;
+        if( !m_bQuiet )
+            cout<<"\n";
+        return encoded;
+    }
 
-            // Make a raw tiled image
-            m_imgBuff.resize(0);
-            WriteTiledImg( m_itImgBuffPushBack, currentimg, KAO_PORTRAIT_PIXEL_ORDER_REVERSED );
+    void KaoWriter::EncodePortrait( const portrait_t & img, back_insert_iterator<vector<uint8_t>> itout, vector<uint8_t> & imgbuf )const
+    {
+        //#3.1 - Write palette
+        graphics::WriteRawPalette_RGB24_As_RGB24( itout, img.getPalette().begin(), img.getPalette().end() );
+
+        //#3.2 - Make a raw tiled image
+        imgbuf.resize(0);
+        auto itimgbuf = std::back_inserter(imgbuf);
+        WriteTiledImg( itimgbuf, img, KAO_PORTRAIT_PIXEL_ORDER_REVERSED );
+
+        //#3.3 - Compress it to the output as at4px
+        CompressToAT4PX( imgbuf.begin(), 
+                         imgbuf.end(), 
+                         itout,
+                         compression::ePXCompLevel::LEVEL_3,
+                         m_bZealousStrSearch );
+    }
+
+    void KaoWriter::WriteAPortrait( const kao_toc_entry::subentry_t & portrait, const vector<uint8_t> * pencoded )
+    {
+        //First set both to the last valid end of data offset. "null" them out basically!
+        tocsubentry_t portraitpointer = m_lastNullEntryVal; //The offset from the beginning where we'll insert any new data!
+
+        //Make sure we output a computed file offset for valid entry, and just the entry's value if the pointer value is invalid
+        if( CKaomado::isToCSubEntryValid( portrait ) )
+        {
+            //If we have data to write
+            auto & currentimg = m_pExportFrom->m_imgdata[portrait];
+            portraitpointer   = m_outBuff.size(); //Set the current size as the offset to insert our stuff!
 
             if( m_bVerbose )
             {
-                cout <<" ..ImgOK!";
+                cout <<hex <<showbase <<portraitpointer <<dec <<noshowbase;
             }
 
-            //#3.3 - Expand the output to at least the raw image's length, then write at4px
-            compression::px_info_header pxinf = CompressToAT4PX( m_imgBuff.begin(), 
-                                                                 m_imgBuff.end(), 
-                                                                 m_itOutBuffPushBack,
-                                                                 compression::ePXCompLevel::LEVEL_3,
-                                                                 m_bZealousStrSearch );
+            //#3 - Write the palette and compressed image, unless it was compressed ahead of time
+            if( pencoded != nullptr )
+                m_outBuff.insert( m_outBuff.end(), pencoded->begin(), pencoded->end() );
+            else
+                EncodePortrait( currentimg, m_itOutBuffPushBack, m_imgBuff );
 
             if( m_bVerbose )
             {
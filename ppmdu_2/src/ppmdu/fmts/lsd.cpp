@@ -3,6 +3,7 @@
 #include <fstream>
 #include <sstream>
 #include <utils/utility.hpp>
+#include <utils/gfileio.hpp>
 
 using namespace std;
 using namespace utils;
@@ -64,17 +65,10 @@ namespace filetypes
     */
     void WriteLSD( const lsddata_t & lsdcontent, const std::string & fpath )
     {
-        ofstream outf( fpath, ios::out| ios::binary );
-
-        if( !outf.is_open() || outf.bad() )
-        {
-            stringstream sstr;
-            sstr << "WriteLSD(): Error, couldn't open the target file \"" <<fpath <<"\"!";
-            throw runtime_error( sstr.str() );
-        }
-
-        ostreambuf_iterator<char> oit(outf);
-        _WriteLSD( oit, lsdcontent );
+        std::vector<uint8_t> fdata;
+        fdata.reserve( sizeof(uint16_t) + (lsdcontent.size() * LSDStringLen) );
+        _WriteLSD( back_inserter(fdata), lsdcontent );
+        utils::io::WriteByteVectorToFile( fpath, fdata );
     }
 
 };
\ No newline at end of file
@@ -0,0 +1,607 @@
+#include <ppmdu/fmts/nitrofs.hpp>
+#include <utils/poco_wrapper.hpp>
+#include <utils/trace_profiler.hpp>
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <iomanip>
+#include <iterator>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+using namespace std;
+
+namespace filetypes
+{
+    static_assert( nds_header::layout_t::Size == nds_header::RomSizeOff + 8, "nds_header::layout_t doesn't match the header's offsets!" );
+
+    //Some ARM9 binaries are followed by a 12 bytes footer, which ndstool extracts along with them
+    static const uint32_t NDS_ARM9FooterMagic = 0xDEC00621;
+    static const uint32_t NDS_ARM9FooterLen   = 12;
+
+    static const uint32_t NDS_RSASignatureLen = 0x88;       //Signature right after the used part of retail images
+    static const uint32_t NDS_MinChipSize     = 0x20000;    //Chip size for a device capacity of 0
+
+    struct rom_extent
+    {
+        uint32_t beg;
+        uint32_t end;
+    };
+
+    inline uint64_t AlignOffset( uint64_t off )
+    {
+        return (off + NDS_FileAlignment - 1) & ~static_cast<uint64_t>(NDS_FileAlignment - 1);
+    }
+
+    /*
+        The header CRC, CRC16 with the 0xA001 polynomial starting from 0xFFFF.
+    */
+    static uint16_t CalcHeaderCRC16( const uint8_t * pdata, size_t len )
+    {
+        uint16_t crc = 0xFFFF;
+        for( size_t i = 0; i < len; ++i )
+        {
+            crc ^= pdata[i];
+            for( int bit = 0; bit < 8; ++bit )
+                crc = (crc & 1)? static_cast<uint16_t>((crc >> 1) ^ 0xA001) : static_cast<uint16_t>(crc >> 1);
+        }
+        return crc;
+    }
+
+    inline string ParentPath( const string & path )
+    {
+        const size_t lastslash = path.rfind('/');
+        return (lastslash == string::npos)? string() : path.substr(0, lastslash);
+    }
+
+    inline string LeafName( const string & path )
+    {
+        const size_t lastslash = path.rfind('/');
+        return (lastslash == string::npos)? path : path.substr(lastslash + 1);
+    }
+
+//======================================================================================
+//  NitroROM
+//======================================================================================
+    NitroROM::NitroROM( const std::string & rompath )
+        :m_rompath(rompath)
+    {
+        Load();
+    }
+
+    void NitroROM::Load()
+    {
+        utils::TraceScope trace("NitroROM::Load");
+        m_nodes.clear();
+        m_fat.clear();
+        m_fatpaths.clear();
+        m_image.Open(m_rompath);
+        if( m_image.size() < NDS_HeaderLen )
+            throw runtime_error("NitroROM::Load(): File \"" + m_rompath + "\" is too small to be a NDS ROM!");
+
+        m_nodes.emplace( string(), rom_node{ true, 0, 0, NoFileID, {} } );
+        try
+        {
+            ParseHeader();
+            ParseFAT();
+            ParseFNT();
+            AddDir( NDS_DirName_Overlay );
+            ParseOverlayTable( m_hdr.ovt9off, m_hdr.ovt9len, NDS_DirName_Overlay + "/overlay_" );
+            ParseOverlayTable( m_hdr.ovt7off, m_hdr.ovt7len, NDS_DirName_Overlay + "/overlay7_" );
+        }
+        catch( const std::exception & )
+        {
+            throw_with_nested( runtime_error("NitroROM::Load(): Couldn't parse the file system of \"" + m_rompath + "\"!") );
+        }
+    }
+
+    void NitroROM::ParseHeader()
+    {
+        nds_header::layout_t::Read( m_hdr, m_image.begin(), m_image.end() );
+
+        AddFile( NDS_FName_Header, 0, NDS_HeaderLen, NoFileID );
+
+        uint32_t arm9len = m_hdr.arm9len;
+        const size_t arm9end = static_cast<size_t>(m_hdr.arm9off) + m_hdr.arm9len;
+        if( arm9end + NDS_ARM9FooterLen <= m_image.size() && utils::Load<uint32_t>( m_image.data() + arm9end ) == NDS_ARM9FooterMagic )
+            arm9len += NDS_ARM9FooterLen;
+        AddFile( NDS_FName_ARM9, m_hdr.arm9off, m_hdr.arm9off + arm9len, NoFileID );
+        AddFile( NDS_FName_ARM7, m_hdr.arm7off, m_hdr.arm7off + m_hdr.arm7len, NoFileID );
+        if( m_hdr.ovt9len != 0 )
+            AddFile( NDS_FName_ARM9OvrTbl, m_hdr.ovt9off, m_hdr.ovt9off + m_hdr.ovt9len, NoFileID );
+        if( m_hdr.ovt7len != 0 )
+            AddFile( NDS_FName_ARM7OvrTbl, m_hdr.ovt7off, m_hdr.ovt7off + m_hdr.ovt7len, NoFileID );
+        if( m_hdr.banneroff != 0 )
+            AddFile( NDS_FName_Banner, m_hdr.banneroff, m_hdr.banneroff + static_cast<uint32_t>(NDS_BannerLen), NoFileID );
+    }
+
+    void NitroROM::ParseFAT()
+    {
+        if( static_cast<size_t>(m_hdr.fatoff) + m_hdr.fatlen > m_image.size() )
+            throw runtime_error("NitroROM::ParseFAT(): The FAT is out of the file's bounds!");
+
+        utils::BinaryCursor cur( m_image.data() + m_hdr.fatoff, m_image.data() + m_hdr.fatoff + m_hdr.fatlen );
+        m_fat.resize( m_hdr.fatlen / NDS_FATEntryLen );
+        m_fatpaths.resize( m_fat.size() );
+        for( auto & entry : m_fat )
+        {
+            entry.beg = cur.ReadUnchecked<uint32_t>();
+            entry.end = cur.ReadUnchecked<uint32_t>();
+        }
+    }
+
+    /*
+        The FNT starts with a table of 8 bytes entries, one per directory, the root first. Each holds
+        the offset of the directory's entry list, and the FAT id of its first file. Files in a directory
+        have consecutive ids, in the order they're listed.
+    */
+    void NitroROM::ParseFNT()
+    {
+        AddDir( NDS_DirName_Data );
+        if( m_hdr.fntlen == 0 )
+            return;
+        if( static_cast<size_t>(m_hdr.fntoff) + m_hdr.fntlen > m_image.size() )
+            throw runtime_error("NitroROM::ParseFNT(): The FNT is out of the file's bounds!");
+
+        utils::BinaryCursor cur( m_image.data() + m_hdr.fntoff, m_image.data() + m_hdr.fntoff + m_hdr.fntlen );
+        cur.Seek(6);
+        const uint16_t nbdirs = cur.Read<uint16_t>();
+
+        vector<bool>                     visited(nbdirs, false);
+        vector<pair<uint16_t, string>>   pending{ { 0, NDS_DirName_Data } };
+        while( !pending.empty() )
+        {
+            const uint16_t dirindex = pending.back().first;
+            const string   dirpath  = std::move(pending.back().second);
+            pending.pop_back();
+            if( visited[dirindex] )
+                throw runtime_error("NitroROM::ParseFNT(): Directory \"" + dirpath + "\" is listed more than once!");
+            visited[dirindex] = true;
+
+            cur.Seek( dirindex * NDS_FATEntryLen );
+            const uint32_t subtbloff = cur.Read<uint32_t>();
+            uint16_t       fileid    = cur.Read<uint16_t>();
+            cur.Seek(subtbloff);
+
+            for( uint8_t lenflag = cur.Read<uint8_t>(); lenflag != 0; lenflag = cur.Read<uint8_t>() )
+            {
+                const bool   isdir   = (lenflag & 0x80) != 0;
+                const size_t namelen = lenflag & 0x7F;
+                if( namelen == 0 )
+                    throw runtime_error("NitroROM::ParseFNT(): Invalid entry in directory \"" + dirpath + "\"!");
+                const char * pname = reinterpret_cast<const char*>( cur.Take(namelen) );
+                const string path  = dirpath + "/" + string( pname, namelen );
+
+                if( isdir )
+                {
+                    const uint16_t dirid = cur.Read<uint16_t>();
+                    if( dirid < NDS_FNTDirIDBase || (dirid - NDS_FNTDirIDBase) >= nbdirs )
+                        throw runtime_error("NitroROM::ParseFNT(): Directory \"" + path + "\" has an invalid id!");
+                    AddDir(path);
+                    pending.push_back( make_pair( static_cast<uint16_t>(dirid - NDS_FNTDirIDBase), path ) );
+                }
+                else
+                    AddFATFile( path, fileid++ );
+            }
+        }
+    }
+
+    void NitroROM::ParseOverlayTable( uint32_t tbloff, uint32_t tbllen, const std::string & prefix )
+    {
+        if( static_cast<size_t>(tbloff) + tbllen > m_image.size() )
+            throw runtime_error("NitroROM::ParseOverlayTable(): The overlay table is out of the file's bounds!");
+
+        for( size_t entoff = 0; entoff + NDS_OverlayEntryLen <= tbllen; entoff += NDS_OverlayEntryLen )
+        {
+            const uint8_t * pentry = m_image.data() + tbloff + entoff;
+            stringstream    sstrpath;
+            sstrpath <<prefix <<setfill('0') <<setw(4) <<utils::Load<uint32_t>(pentry) <<".bin";
+            AddFATFile( sstrpath.str(), utils::Load<uint32_t>(pentry + NDS_OverlayFileIDOff) );
+        }
+    }
+
+    void NitroROM::AddDir( const std::string & path )
+    {
+        auto itpar = m_nodes.find( ParentPath(path) );
+        if( itpar == m_nodes.end() || !itpar->second.isdir )
+            throw runtime_error("NitroROM::AddDir(): Parent directory of \"" + path + "\" doesn't exist!");
+        rom_node & parent = itpar->second; //Inserting can rehash, but references to the nodes stay valid
+        if( !m_nodes.emplace( path, rom_node{ true, 0, 0, NoFileID, {} } ).second )
+            throw runtime_error("NitroROM::AddDir(): \"" + path + "\" exists already!");
+        parent.children.push_back( LeafName(path) + "/" );
+    }
+
+    void NitroROM::AddFile( const std::string & path, uint32_t beg, uint32_t end, int fileid )
+    {
+        if( beg > end || end > m_image.size() )
+            throw runtime_error("NitroROM::AddFile(): File \"" + path + "\" is out of the ROM's bounds!");
+        auto itpar = m_nodes.find( ParentPath(path) );
+        if( itpar == m_nodes.end() || !itpar->second.isdir )
+            throw runtime_error("NitroROM::AddFile(): Parent directory of \"" + path + "\" doesn't exist!");
+        rom_node & parent = itpar->second;
+
+        rom_node node;
+        node.beg    = beg;
+        node.end    = end;
+        node.fileid = fileid;
+        if( !m_nodes.emplace( path, std::move(node) ).second )
+            throw runtime_error("NitroROM::AddFile(): \"" + path + "\" exists already!");
+        parent.children.push_back( LeafName(path) );
+    }
+
+    void NitroROM::AddFATFile( const std::string & path, uint32_t fileid )
+    {
+        if( fileid >= m_fat.size() )
+            throw runtime_error("NitroROM::AddFATFile(): File \"" + path + "\" refers to a FAT entry that doesn't exist!");
+        AddFile( path, m_fat[fileid].beg, m_fat[fileid].end, static_cast<int>(fileid) );
+        m_fatpaths[fileid] = path;
+    }
+
+    const NitroROM::rom_node * NitroROM::FindNode( const std::string & relpath )const
+    {
+        auto itfound = m_nodes.find(relpath);
+        if( itfound == m_nodes.end() )
+            itfound = m_nodes.find( utils::io::NormalizeVirtualPath(relpath) );
+        return (itfound != m_nodes.end())? &(itfound->second) : nullptr;
+    }
+
+    bool NitroROM::GetFile( const std::string & relpath, const uint8_t *& out_pdata, size_t & out_len )const
+    {
+        {
+            lock_guard<mutex> lck(m_stagedmtx);
+            if( !m_staged.empty() )
+            {
+                auto itfound = m_staged.find( utils::io::NormalizeVirtualPath(relpath) );
+                if( itfound != m_staged.end() )
+                {
+                    out_pdata = itfound->second.data();
+                    out_len   = itfound->second.size();
+                    return true;
+                }
+            }
+        }
+
+        const rom_node * pnode = FindNode(relpath);
+        if( pnode == nullptr || pnode->isdir )
+            return false;
+        out_pdata = m_image.data() + pnode->beg;
+        out_len   = pnode->end - pnode->beg;
+        return true;
+    }
+
+    bool NitroROM::IsDir( const std::string & relpath )const
+    {
+        const rom_node * pnode = FindNode(relpath);
+        return pnode != nullptr && pnode->isdir;
+    }
+
+    bool NitroROM::ListDir( const std::string & relpath, std::vector<std::string> & out_names )const
+    {
+        const rom_node * pnode = FindNode(relpath);
+        if( pnode == nullptr || !pnode->isdir )
+            return false;
+        out_names = pnode->children;
+        return true;
+    }
+
+    bool NitroROM::PutFile( const std::string & relpath, const uint8_t * pdata, size_t len )
+    {
+        const string normpath = utils::io::NormalizeVirtualPath(relpath);
+        auto         itnode   = m_nodes.find(normpath);
+        if( itnode == m_nodes.end() || itnode->second.isdir )
+            throw runtime_error("NitroROM::PutFile(): \"" + normpath + "\" isn't a file in \"" + m_rompath + "\". Files can't be added to a ROM image!");
+        if( normpath == NDS_FName_Header )
+            throw runtime_error("NitroROM::PutFile(): The header of \"" + m_rompath + "\" can't be replaced!");
+        if( len > numeric_limits<uint32_t>::max() )
+            throw runtime_error("NitroROM::PutFile(): \"" + normpath + "\" is too big to fit in a ROM image!");
+
+        lock_guard<mutex> lck(m_stagedmtx);
+        m_staged[normpath].assign( pdata, pdata + len );
+        return true;
+    }
+
+    bool NitroROM::HasChanges()const
+    {
+        lock_guard<mutex> lck(m_stagedmtx);
+        return !m_staged.empty();
+    }
+
+    void NitroROM::DiscardChanges()
+    {
+        lock_guard<mutex> lck(m_stagedmtx);
+        m_staged.clear();
+    }
+
+    void NitroROM::CommitChanges()
+    {
+        utils::TraceScope trace("NitroROM::CommitChanges");
+
+        //Reloading the image goes through the VFS, which reads the staged files, so the lock can't be held during the commit
+        map<string, vector<uint8_t>> staged;
+        {
+            lock_guard<mutex> lck(m_stagedmtx);
+            staged.swap(m_staged);
+        }
+        if( staged.empty() )
+            return;
+
+        //Puts back what couldn't be written, without overwriting anything staged since
+        auto lambdarestore = [&]()
+        {
+            lock_guard<mutex> lck(m_stagedmtx);
+            m_staged.insert( std::make_move_iterator(staged.begin()), std::make_move_iterator(staged.end()) );
+        };
+
+        struct placement
+        {
+            const string          * ppath;
+            const rom_node        * pnode;
+            const vector<uint8_t> * pdata;
+            uint32_t                slotend;    //How far the file can grow in place
+            uint64_t                newbeg;
+            bool                    bplaced;
+        };
+
+        //Everything that has data in the image. The FNT and FAT aren't in the tree.
+        vector<pair<rom_extent, const rom_node*>> used;
+        used.push_back( make_pair( rom_extent{ m_hdr.fntoff, m_hdr.fntoff + m_hdr.fntlen }, nullptr ) );
+        used.push_back( make_pair( rom_extent{ m_hdr.fatoff, m_hdr.fatoff + m_hdr.fatlen }, nullptr ) );
+        //Retail images have a RSA signature right after the used part, which no file may grow into
+        if( static_cast<uint64_t>(m_hdr.romsize) + NDS_RSASignatureLen <= numeric_limits<uint32_t>::max() )
+            used.push_back( make_pair( rom_extent{ m_hdr.romsize, m_hdr.romsize + NDS_RSASignatureLen }, nullptr ) );
+        for( const auto & entry : m_nodes )
+        {
+            if( !entry.second.isdir && entry.second.end > entry.second.beg )
+                used.push_back( make_pair( rom_extent{ entry.second.beg, entry.second.end }, &entry.second ) );
+        }
+
+        uint64_t usedend = static_cast<uint64_t>(m_hdr.romsize) + NDS_RSASignatureLen;
+        for( const auto & ext : used )
+            usedend = std::max<uint64_t>( usedend, ext.first.end );
+
+        //A slot goes up to the next aligned offset, unless something else starts before that.
+        //If another file overlaps it, the data is shared, and the slot can't be reused.
+        vector<placement> placements;
+        placements.reserve( staged.size() );
+        for( const auto & stagedfile : staged )
+        {
+            const rom_node & node    = m_nodes.at(stagedfile.first);
+            uint64_t         slotend = AlignOffset(node.end);
+            bool             bshared = false;
+            for( const auto & ext : used )
+            {
+                if( ext.second == &node || ext.first.end <= ext.first.beg )
+                    continue;
+                if( ext.first.beg < node.end && ext.first.end > node.beg )
+                {
+                    bshared = true;
+                    break;
+                }
+                if( ext.first.beg >= node.end && ext.first.beg < slotend )
+                    slotend = ext.first.beg;
+            }
+            placements.push_back( placement{ &stagedfile.first, &node, &stagedfile.second, static_cast<uint32_t>( bshared? node.beg : slotend ), node.beg, false } );
+        }
+
+        //Place the biggest files first, so they get the pick of the free space
+        std::sort( placements.begin(), placements.end(), []( const placement & a, const placement & b )
+        {
+            return (a.pdata->size() != b.pdata->size())? (a.pdata->size() > b.pdata->size()) : (*a.ppath < *b.ppath);
+        });
+
+        //First keep in place what fits, and free the slots of what doesn't
+        vector<rom_extent> freechunks;
+        for( auto & pl : placements )
+        {
+            const uint64_t newend = static_cast<uint64_t>(pl.pnode->beg) + pl.pdata->size();
+            if( newend <= pl.slotend )
+            {
+                pl.bplaced = true;
+                if( AlignOffset(newend) < pl.slotend )
+                    freechunks.push_back( rom_extent{ static_cast<uint32_t>(AlignOffset(newend)), pl.slotend } );
+            }
+            else if( pl.pnode->fileid == NoFileID )
+            {
+                lambdarestore();
+                throw runtime_error("NitroROM::CommitChanges(): \"" + *pl.ppath + "\" is bigger than the room it has, and only FAT files can be moved!");
+            }
+            else if( pl.slotend > pl.pnode->beg )
+                freechunks.push_back( rom_extent{ pl.pnode->beg, pl.slotend } );
+        }
+
+        //Then move the rest into the smallest free chunk they fit in, or after everything else
+        uint64_t tail = AlignOffset(usedend);
+        for( auto & pl : placements )
+        {
+            if( pl.bplaced )
+                continue;
+            const uint64_t len  = pl.pdata->size();
+            auto           best = freechunks.end();
+            for( auto itchunk = freechunks.begin(); itchunk != freechunks.end(); ++itchunk )
+            {
+                if( AlignOffset(itchunk->beg) + len <= itchunk->end &&
+                    (best == freechunks.end() || (itchunk->end - itchunk->beg) < (best->end - best->beg)) )
+                    best = itchunk;
+            }
+
+            if( best != freechunks.end() )
+            {
+                pl.newbeg = AlignOffset(best->beg);
+                best->beg = static_cast<uint32_t>( std::min<uint64_t>( AlignOffset(pl.newbeg + len), best->end ) );
+                if( best->beg == best->end )
+                    freechunks.erase(best);
+            }
+            else
+            {
+                pl.newbeg = tail;
+                tail      = AlignOffset(tail + len);
+            }
+            pl.bplaced = true;
+        }
+        if( tail > numeric_limits<uint32_t>::max() )
+        {
+            lambdarestore();
+            throw runtime_error("NitroROM::CommitChanges(): The replaced files don't fit in a ROM image!");
+        }
+
+        //The view has to go before writing, since a mapped file can't grow on all platforms
+        m_image.Close();
+        try
+        {
+            fstream romf( m_rompath, ios::in | ios::out | ios::binary );
+            if( !romf.is_open() )
+                throw runtime_error("NitroROM::CommitChanges(): Couldn't open \"" + m_rompath + "\" for writing!");
+            romf.exceptions( ios::badbit | ios::failbit );
+
+            auto lambdawriteu32 = [&romf]( uint64_t offset, uint32_t val )
+            {
+                uint8_t buf[sizeof(uint32_t)];
+                utils::Store<uint32_t>( buf, val );
+                romf.seekp( static_cast<streamoff>(offset) );
+                romf.write( reinterpret_cast<const char*>(buf), sizeof(buf) );
+            };
+
+            //All the data goes in before the tables that point to it
+            uint32_t newromsize = m_hdr.romsize;
+            for( const auto & pl : placements )
+            {
+                romf.seekp( static_cast<streamoff>(pl.newbeg) );
+                romf.write( reinterpret_cast<const char*>(pl.pdata->data()), pl.pdata->size() );
+                if( pl.newbeg != pl.pnode->beg )
+                    newromsize = std::max( newromsize, static_cast<uint32_t>(pl.newbeg + pl.pdata->size()) );
+            }
+
+            for( const auto & pl : placements )
+            {
+                const uint32_t newbeg = static_cast<uint32_t>(pl.newbeg);
+                const uint32_t len    = static_cast<uint32_t>(pl.pdata->size());
+                if( pl.pnode->fileid != NoFileID )
+                {
+                    const uint64_t entryoff = m_hdr.fatoff + static_cast<uint64_t>(pl.pnode->fileid) * NDS_FATEntryLen;
+                    lambdawriteu32( entryoff,                    newbeg );
+                    lambdawriteu32( entryoff + sizeof(uint32_t), newbeg + len );
+                }
+                else if( *pl.ppath == NDS_FName_ARM9 )
+                {
+                    //Leave the footer out of the length, if the old binary had one
+                    const uint32_t footerlen = (pl.pnode->end - pl.pnode->beg) - m_hdr.arm9len;
+                    lambdawriteu32( nds_header::ARM9LenOff, (len >= footerlen)? len - footerlen : len );
+                }
+                else if( *pl.ppath == NDS_FName_ARM7 )
+                    lambdawriteu32( nds_header::ARM7LenOff, len );
+                else if( *pl.ppath == NDS_FName_ARM9OvrTbl )
+                    lambdawriteu32( nds_header::Ovt9LenOff, len );
+                else if( *pl.ppath == NDS_FName_ARM7OvrTbl )
+                    lambdawriteu32( nds_header::Ovt7LenOff, len );
+            }
+
+            //Grow the ROM size and chip capacity if files were appended
+            vector<uint8_t> hdrdata(nds_header::HeaderCRCOff);
+            romf.seekg(0);
+            romf.read( reinterpret_cast<char*>(hdrdata.data()), hdrdata.size() );
+            if( newromsize != m_hdr.romsize )
+            {
+                utils::Store<uint32_t>( hdrdata.data() + nds_header::RomSizeOff, newromsize );
+                uint8_t & capacity = hdrdata[nds_header::DevCapacityOff];
+                while( capacity < 31 && (static_cast<uint64_t>(NDS_MinChipSize) << capacity) < newromsize )
+                    ++capacity;
+            }
+
+            uint8_t crcbuf[sizeof(uint16_t)];
+            utils::Store<uint16_t>( crcbuf, CalcHeaderCRC16( hdrdata.data(), hdrdata.size() ) );
+            romf.seekp(0);
+            romf.write( reinterpret_cast<const char*>(hdrdata.data()), hdrdata.size() );
+            romf.write( reinterpret_cast<const char*>(crcbuf), sizeof(crcbuf) );
+            romf.flush();
+        }
+        catch( const std::exception & )
+        {
+            lambdarestore();
+            try{ Load(); }catch(...){}
+            throw_with_nested( runtime_error("NitroROM::CommitChanges(): Failed to patch \"" + m_rompath + "\"!") );
+        }
+
+        Load();
+    }
+
+    int NitroROM::GetFileID( const std::string & relpath )const
+    {
+        const rom_node * pnode = FindNode(relpath);
+        return (pnode != nullptr)? pnode->fileid : NoFileID;
+    }
+
+    std::vector<std::string> NitroROM::ListAllFiles()const
+    {
+        vector<string> files;
+        files.reserve( m_nodes.size() );
+        for( const auto & path : m_fatpaths )
+        {
+            if( !path.empty() )
+                files.push_back(path);
+        }
+
+        const size_t nbfatfiles = files.size();
+        for( const auto & entry : m_nodes )
+        {
+            if( !entry.second.isdir && entry.second.fileid == NoFileID )
+                files.push_back(entry.first);
+        }
+        std::sort( files.begin() + nbfatfiles, files.end() );
+        return files;
+    }
+
+//======================================================================================
+//  Functions
+//======================================================================================
+    bool IsNitroROMPath( const std::string & path )
+    {
+        const string ext = utils::GetFileExtension(path);
+        return ext.size() == NDS_FileExt.size() &&
+               std::equal( ext.begin(), ext.end(), NDS_FileExt.begin(), []( char a, char b ){ return std::tolower(static_cast<unsigned char>(a)) == b; } );
+    }
+
+//======================================================================================
+//  NitroROMMount
+//======================================================================================
+    NitroROMMount::NitroROMMount( const std::string & path )
+    {
+        Mount(path);
+    }
+
+    NitroROMMount::~NitroROMMount()
+    {
+        Unmount();
+    }
+
+    bool NitroROMMount::Mount( const std::string & path )
+    {
+        Unmount();
+        const string normpath = utils::io::NormalizeVirtualPath(path);
+        for( size_t slashpos = normpath.find('/'); ; slashpos = normpath.find('/', slashpos + 1) )
+        {
+            const string prefix = normpath.substr(0, slashpos);
+            if( !prefix.empty() && IsNitroROMPath(prefix) && utils::isFile(prefix) )
+            {
+                m_prom = make_shared<NitroROM>(prefix);
+                utils::io::MountVirtualFS( prefix, m_prom );
+                return true;
+            }
+            if( slashpos == string::npos )
+                return false;
+        }
+    }
+
+    void NitroROMMount::Unmount()
+    {
+        if( !m_prom )
+            return;
+        utils::io::UnmountVirtualFS( m_prom->GetPath() );
+        m_prom.reset();
+    }
+
+    void NitroROMMount::Commit()
+    {
+        if( m_prom )
+            m_prom->CommitChanges();
+    }
+};
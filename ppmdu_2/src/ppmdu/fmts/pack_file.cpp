@@ -135,6 +135,7 @@ namespace filetypes
 
     void CPack::LoadPack(std::vector<uint8_t>::const_iterator beg, std::vector<uint8_t>::const_iterator end)
     {
+        utils::TraceScope trace("pack load");
         //Clear all current data
         ClearState();
 
@@ -155,6 +156,7 @@ namespace filetypes
 
     void CPack::LoadFolder( const std::string & pathdir )
     {
+        utils::TraceScope trace("pack load folder");
         //utils::MrChronometer chronofolderloader("Folder Loader");
 
         //Check folder exists
@@ -206,6 +208,7 @@ namespace filetypes
     //void CPack::OutputToFile( const std::string & pathfile )
     vector<uint8_t> CPack::OutputPack()
     {
+        utils::TraceScope trace("pack build");
         //Build the FOT
         BuildFOT();
 
@@ -223,14 +226,18 @@ namespace filetypes
 
     void CPack::OutputToFolder( const std::string & pathdir )
     {
+        utils::TraceScope trace("pack unpack to folder");
         //MrChronometer chronooutputer( "Unpacking Files" );
 
         if( !utils::DoCreateDirectory( pathdir ) )
             throw runtime_error("CPack::OutputToFolder(): Invalid output path!");
 
+        //Classify all the subfiles in one go to get their file extension
+        vector<ContentBlock> cnttypes = DetermineCntTys( m_SubFiles );
+
         //write them out
         for( unsigned int i = 0; i < m_SubFiles.size(); ++i)
-            WriteSubFileToFile( m_SubFiles[i], pathdir, i );
+            WriteSubFileToFile( m_SubFiles[i], pathdir, i, pmd2::filetypes::GetFileExtensionForContentType( cnttypes[i]._type ) );
     }
 
 
@@ -381,18 +388,10 @@ namespace filetypes
         return writeat;
     }
 
-    string SubfileGetFExtension( vector<uint8_t>::const_iterator beg, vector<uint8_t>::const_iterator end )
-    {
-        string result = pmd2::filetypes::GetAppropriateFileExtension(beg,end);
-        if( result.empty() )
-            return std::move( result );
-        else
-            return "." + result;
-    }
-
     void CPack::WriteSubFileToFile( vector<uint8_t>  & file,
                                     const std::string & path, 
-                                    unsigned int        fileindex )
+                                    unsigned int        fileindex,
+                                    const std::string & fext )
     {
         //static const string FILE_PREFIX = "file_";
 
@@ -405,7 +404,7 @@ namespace filetypes
                     <<std::setfill('0') <<std::setw(4) <<std::dec <<fileindex
                     <<"_0x" 
                     <<std::setfill('0') <<std::setw(4) <<std::hex << m_OffsetTable[fileindex]._fileOffset
-                    << SubfileGetFExtension( file.begin(), file.end() );
+                    << (fext.empty()? fext : "." + fext);
 
 		//------- 2. Output -------
         WriteByteVectorToFile( outfilename.str(), file ); 
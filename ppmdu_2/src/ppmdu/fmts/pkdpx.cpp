@@ -1,6 +1,7 @@
 #include <ppmdu/fmts/pkdpx.hpp>
 #include <iterator>
 #include <ppmdu/fmts/px_compression.hpp>
+#include <ppmdu/fmts/px_compression_cache.hpp>
 #include <types/content_type_analyser.hpp>
 #include <ppmdu/fmts/sir0.hpp>
 #include <utils/utility.hpp>
@@ -176,13 +177,14 @@ namespace filetypes
         
         //Run compression
         //Compress data
-        pxinf = compression::CompressPX( itinputbeg, 
-                                         itinputend, 
-                                         itoutputbeg, 
-                                         complvl, 
-                                         bzealous, 
-                                         bdisplayProgress,
-                                         blogenable );
+        pxinf = compression::CompressPXCached( compression::ePXContainer::PKDPX,
+                                               itinputbeg, 
+                                               itinputend, 
+                                               itbuffer, 
+                                               complvl, 
+                                               bzealous, 
+                                               bdisplayProgress,
+                                               blogenable );
 
         //Write header, before the compressed data
         pkdpx_header headr = PXinfoToPKDPXHeader( pxinf );
@@ -213,13 +215,14 @@ namespace filetypes
         buffer.resize(pkdpx_header::HEADER_SZ); //Reserve the header size, to come back and write it later
         
         //Compress data
-        pxinf = compression::CompressPX( itinputbeg, 
-                                         itinputend, 
-                                         itbuffer, 
-                                         complvl, 
-                                         bzealous, 
-                                         bdisplayProgress,
-                                         blogenable );
+        pxinf = compression::CompressPXCached( compression::ePXContainer::PKDPX,
+                                               itinputbeg, 
+                                               itinputend, 
+                                               itbuffer, 
+                                               complvl, 
+                                               bzealous, 
+                                               bdisplayProgress,
+                                               blogenable );
 
         //Write header, before the compressed data
         pkdpx_header headr = PXinfoToPKDPXHeader( pxinf );
@@ -380,6 +383,12 @@ namespace filetypes
                                vector<uint8_t>::const_iterator   itdataend,
                                const std::string    & filext );
 
+        //Only the first 4 bytes of "PKDPX"
+        virtual std::vector<uint32_t> getMagicNumbers()const
+        {
+            return { 0x504B4450 }; //"PKDP"
+        }
+
     private:
         cntRID_t m_myID;
     };
@@ -517,6 +526,12 @@ namespace filetypes
             return false;
         }
 
+        //The PKDPX sub-header
+        virtual std::vector<uint32_t> getMagicNumbers()const
+        {
+            return { 0x504B4450 }; //"PKDP"
+        }
+
     private:
         cntRID_t m_myID;
     };
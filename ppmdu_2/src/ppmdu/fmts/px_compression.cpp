@@ -1291,6 +1291,8 @@ namespace compression
 //=========================================
 //              Functions
 //=========================================
+    static utils::TraceCounter PXBytesCompressed  ("px bytes compressed");
+    static utils::TraceCounter PXBytesDecompressed("px bytes decompressed");
 
     //Print progress
     void PrintProgress( multistep_completion<2> & progressatomic, uint64_t totalsize )
@@ -1325,6 +1327,7 @@ namespace compression
                        std::vector<uint8_t>                 & out_decompresseddata,
                        bool                                   blogenabled)
     {
+        TraceScope trace("px decompress");
         //Resize the vector properly
         //out_decompresseddata.resize( info.decompressedsz );
         if(info.decompressedsz != out_decompresseddata.size()) //Those must be the same size !
@@ -1335,6 +1338,8 @@ namespace compression
             throw std::runtime_error( sstr.str() );
         }
 
+        PXBytesDecompressed.Add(info.decompressedsz);
+
         //Create our state
         px_decompressor<std::vector<uint8_t>::const_iterator, std::vector<uint8_t>::iterator>
                         ( itdatabeg, 
@@ -1352,6 +1357,7 @@ namespace compression
                        std::vector<uint8_t>::iterator         itoutend, 
                        bool                                   blogenabled)
     {
+        TraceScope trace("px decompress");
         //Resize the vector properly
         auto diff = distance( itoutbeg, itoutend );
         if(info.decompressedsz != diff ) //Those must be the same size !
@@ -1362,6 +1368,8 @@ namespace compression
             throw std::runtime_error( sstr.str() );
         }
 
+        PXBytesDecompressed.Add(info.decompressedsz);
+
         //Create our state
         px_decompressor<std::vector<uint8_t>::const_iterator, std::vector<uint8_t>::iterator>
                         ( itdatabeg, 
@@ -1383,9 +1391,11 @@ namespace compression
                                bool                              displayprogress,
                                bool                              blogenabled)
     {
+        TraceScope              trace("px compress");
         multistep_completion<2> mycompletion;
         atomic<bool>            shouldstopthread(false);
         uint64_t                origfilesize = distance(itdatabeg,itdataend);
+        PXBytesCompressed.Add(origfilesize);
         
         auto lambdaProgress = []( atomic<bool> & shouldstop, multistep_completion<2> & progressatomic, uint64_t totalsize )->bool
         {
@@ -1498,9 +1508,11 @@ namespace compression
                                bool                                            displayprogress, 
                                bool                                            blogenabled )
     {
+        TraceScope              trace("px compress");
         multistep_completion<2> mycompletion;
         atomic<bool>            shouldstopthread(false);
         uint64_t                origfilesize = distance(itdatabeg,itdataend);
+        PXBytesCompressed.Add(origfilesize);
         
         auto lambdaProgress = []( atomic<bool> & shouldstop, multistep_completion<2> & progressatomic, uint64_t totalsize )->bool
         {
@@ -0,0 +1,312 @@
+#include <ppmdu/fmts/px_compression_cache.hpp>
+#include <utils/gbyteutils.hpp>
+#include <utils/gfileio.hpp>
+#include <utils/poco_wrapper.hpp>
+#include <utils/library_wide.hpp>
+#include <algorithm>
+#include <iostream>
+#include <tuple>
+#include <stdexcept>
+using namespace std;
+
+namespace compression
+{
+//=========================================
+// Constants
+//=========================================
+    static const uint64_t PXCache_FNVOffset = 0xCBF29CE484222325ull;
+    static const uint64_t PXCache_FNVPrime  = 0x100000001B3ull;
+
+//=========================================
+// Utility
+//=========================================
+    /*
+        MixHash
+            Final mixing function from splitmix64.
+    */
+    inline uint64_t MixHash( uint64_t val )
+    {
+        val = (val ^ (val >> 30)) * 0xBF58476D1CE4E5B9ull;
+        val = (val ^ (val >> 27)) * 0x94D049BB133111EBull;
+        return val ^ (val >> 31);
+    }
+
+//=========================================
+// PXCompressionCache
+//=========================================
+    bool PXCompressionCache::key_t::operator<( const key_t & other )const
+    {
+        return std::tie( hash1, hash2, rawlen, fmt, lvl, zealous ) <
+               std::tie( other.hash1, other.hash2, other.rawlen, other.fmt, other.lvl, other.zealous );
+    }
+
+    PXCompressionCache & PXCompressionCache::GetInstance()
+    {
+        static PXCompressionCache s_instance;
+        return s_instance;
+    }
+
+    PXCompressionCache::PXCompressionCache()
+        :m_benabled(false), m_bmodified(false), m_nbhits(0), m_totalsize(0), m_maxsize(PXCache_DefMaxSize), m_usetick(0)
+    {}
+
+    void PXCompressionCache::Load( const std::string & cachefile )
+    {
+        lock_guard<mutex> lck(m_mtx);
+        m_cachefile = cachefile;
+        m_benabled  = true;
+        m_bmodified = false;
+        m_nbhits    = 0;
+        m_totalsize = 0;
+        m_usetick   = 0;
+        m_entries.clear();
+
+        if( !utils::isFile(cachefile) )
+            return;
+
+        const vector<uint8_t> filedata = utils::io::ReadFileToByteVector(cachefile);
+        if( !ReadEntries(filedata) )
+        {
+            //Keep what could be read, anything else is just compressed again
+            clog << "<!>- PXCompressionCache::Load(): \"" <<cachefile <<"\" is truncated or isn't a compatible cache file. Kept the " 
+                 <<m_entries.size() <<" entries that could be read!\n";
+            m_bmodified = true;
+        }
+        EvictOverBudget();
+
+        if( utils::LibWide().isLogOn() )
+            clog << "PXCompressionCache: Loaded " <<m_entries.size() <<" entries from \"" <<cachefile <<"\".\n";
+    }
+
+    bool PXCompressionCache::ReadEntries( const std::vector<uint8_t> & filedata )
+    {
+        auto     itread    = filedata.cbegin();
+        auto     itend     = filedata.cend();
+        uint32_t magic     = 0;
+        uint32_t version   = 0;
+        uint32_t nbentries = 0;
+        try
+        {
+            itread = utils::ReadIntFromBytes( magic,     itread, itend, false );
+            itread = utils::ReadIntFromBytes( version,   itread, itend );
+            itread = utils::ReadIntFromBytes( nbentries, itread, itend );
+            if( magic != PXCache_MagicNumber || version != PXCache_Version )
+                return false;
+
+            for( uint32_t cnt = 0; cnt < nbentries; ++cnt )
+            {
+                key_t    key;
+                cached_t cached;
+                uint8_t  fmt     = 0;
+                uint8_t  lvl     = 0;
+                uint8_t  zealous = 0;
+                uint32_t datalen = 0;
+                itread = utils::ReadIntFromBytes( key.hash1,  itread, itend );
+                itread = utils::ReadIntFromBytes( key.hash2,  itread, itend );
+                itread = utils::ReadIntFromBytes( key.rawlen, itread, itend );
+                itread = utils::ReadIntFromBytes( fmt,        itread, itend );
+                itread = utils::ReadIntFromBytes( lvl,        itread, itend );
+                itread = utils::ReadIntFromBytes( zealous,    itread, itend );
+                key.fmt     = static_cast<ePXContainer>(fmt);
+                key.lvl     = static_cast<ePXCompLevel>(lvl);
+                key.zealous = (zealous != 0);
+
+                entry_t & entry = cached.entry;
+                itread = utils::ReadIntFromBytes( entry.info.compressedsz,   itread, itend );
+                for( auto & flag : entry.info.controlflags )
+                    itread = utils::ReadIntFromBytes( flag, itread, itend );
+                itread = utils::ReadIntFromBytes( entry.info.decompressedsz, itread, itend );
+                itread = utils::ReadIntFromBytes( datalen,                   itread, itend );
+
+                if( static_cast<size_t>(std::distance(itread, itend)) < datalen )
+                    return false;
+
+                entry.data.assign( itread, itread + datalen );
+                itread += datalen;
+
+                //Entries are stored from the least to the most recently used
+                cached.lastuse = ++m_usetick;
+                m_totalsize   += datalen;
+                m_entries.emplace( key, std::move(cached) );
+            }
+        }
+        catch( const std::exception & )
+        {
+            //ReadIntFromBytes throws when the data ends in the middle of an integer
+            return false;
+        }
+        return true;
+    }
+
+    void PXCompressionCache::Save()
+    {
+        lock_guard<mutex> lck(m_mtx);
+        if( !m_benabled || !m_bmodified || m_cachefile.empty() )
+            return;
+
+        vector<const pair<const key_t, cached_t>*> byuse;
+        byuse.reserve( m_entries.size() );
+        for( const auto & ent : m_entries )
+            byuse.push_back( &ent );
+        sort( byuse.begin(), byuse.end(), []( const pair<const key_t, cached_t> * pa, const pair<const key_t, cached_t> * pb )
+        {
+            return pa->second.lastuse < pb->second.lastuse;
+        });
+
+        vector<uint8_t> filedata;
+        auto            itout = back_inserter(filedata);
+        itout = utils::WriteIntToBytes( PXCache_MagicNumber,                    itout, false );
+        itout = utils::WriteIntToBytes( PXCache_Version,                        itout );
+        itout = utils::WriteIntToBytes( static_cast<uint32_t>(m_entries.size()), itout );
+
+        for( const auto * pent : byuse )
+        {
+            const key_t   & key   = pent->first;
+            const entry_t & entry = pent->second.entry;
+            itout = utils::WriteIntToBytes( key.hash1,                              itout );
+            itout = utils::WriteIntToBytes( key.hash2,                              itout );
+            itout = utils::WriteIntToBytes( key.rawlen,                             itout );
+            itout = utils::WriteIntToBytes( static_cast<uint8_t>(key.fmt),          itout );
+            itout = utils::WriteIntToBytes( static_cast<uint8_t>(key.lvl),          itout );
+            itout = utils::WriteIntToBytes( static_cast<uint8_t>(key.zealous),      itout );
+            itout = utils::WriteIntToBytes( entry.info.compressedsz,                itout );
+            for( const auto & flag : entry.info.controlflags )
+                itout = utils::WriteIntToBytes( flag,                               itout );
+            itout = utils::WriteIntToBytes( entry.info.decompressedsz,              itout );
+            itout = utils::WriteIntToBytes( static_cast<uint32_t>(entry.data.size()), itout );
+            filedata.insert( filedata.end(), entry.data.begin(), entry.data.end() );
+        }
+
+        utils::io::WriteByteVectorToFile( m_cachefile, filedata );
+        m_bmodified = false;
+
+        if( utils::LibWide().isLogOn() )
+            clog << "PXCompressionCache: " <<m_nbhits <<" cache hits. Saved " <<m_entries.size() <<" entries to \"" <<m_cachefile <<"\".\n";
+    }
+
+    void PXCompressionCache::SetMaxSize( size_t maxbytes )
+    {
+        lock_guard<mutex> lck(m_mtx);
+        m_maxsize = maxbytes;
+        EvictOverBudget();
+    }
+
+    void PXCompressionCache::EvictOverBudget()
+    {
+        if( m_totalsize <= m_maxsize )
+            return;
+
+        //Go down to 3/4 of the budget, so inserting a few more entries doesn't trigger another eviction right away
+        vector<map<key_t, cached_t>::iterator> byuse;
+        byuse.reserve( m_entries.size() );
+        for( auto it = m_entries.begin(); it != m_entries.end(); ++it )
+            byuse.push_back(it);
+        sort( byuse.begin(), byuse.end(), []( const map<key_t, cached_t>::iterator & ita, const map<key_t, cached_t>::iterator & itb )
+        {
+            return ita->second.lastuse < itb->second.lastuse;
+        });
+
+        const size_t target   = m_maxsize - (m_maxsize / 4);
+        size_t       nbevicts = 0;
+        for( auto it : byuse )
+        {
+            if( m_totalsize <= target )
+                break;
+            m_totalsize -= it->second.entry.data.size();
+            m_entries.erase(it);
+            ++nbevicts;
+        }
+        m_bmodified = true;
+
+        if( utils::LibWide().isLogOn() )
+            clog << "PXCompressionCache: Evicted " <<nbevicts <<" least recently used entries.\n";
+    }
+
+    bool PXCompressionCache::IsEnabled()const
+    {
+        lock_guard<mutex> lck(m_mtx);
+        return m_benabled;
+    }
+
+    bool PXCompressionCache::Find( const key_t & key, entry_t & out )
+    {
+        lock_guard<mutex> lck(m_mtx);
+        auto itfound = m_entries.find(key);
+        if( itfound == m_entries.end() )
+            return false;
+        out = itfound->second.entry;
+        itfound->second.lastuse = ++m_usetick;
+        ++m_nbhits;
+        return true;
+    }
+
+    void PXCompressionCache::Insert( const key_t & key, entry_t && entry )
+    {
+        lock_guard<mutex> lck(m_mtx);
+        cached_t & cached = m_entries[key];
+        m_totalsize    -= cached.entry.data.size();
+        m_totalsize    += entry.data.size();
+        cached.entry    = std::move(entry);
+        cached.lastuse  = ++m_usetick;
+        m_bmodified     = true;
+        EvictOverBudget();
+    }
+
+    PXCompressionCache::key_t PXCompressionCache::MakeKey( vector<uint8_t>::const_iterator itbeg,
+                                                           vector<uint8_t>::const_iterator itend,
+                                                           ePXContainer                    fmt,
+                                                           ePXCompLevel                    lvl,
+                                                           bool                            bzealous )
+    {
+        key_t    key;
+        uint64_t hash1 = PXCache_FNVOffset;
+        uint64_t hash2 = 0;
+        uint64_t cnt   = 0;
+
+        for( ; itbeg != itend; ++itbeg, ++cnt )
+        {
+            hash1 = (hash1 ^ (*itbeg)) * PXCache_FNVPrime;
+            hash2 = MixHash( hash2 + (static_cast<uint64_t>(*itbeg) << ((cnt % 8) * 8)) + cnt );
+        }
+
+        key.hash1   = hash1;
+        key.hash2   = hash2;
+        key.rawlen  = static_cast<uint32_t>(cnt);
+        key.fmt     = fmt;
+        key.lvl     = lvl;
+        key.zealous = bzealous;
+        return key;
+    }
+
+//=========================================
+// Functions
+//=========================================
+    px_info_header CompressPXCached( ePXContainer                          fmt,
+                                     vector<uint8_t>::const_iterator       itdatabeg,
+                                     vector<uint8_t>::const_iterator       itdataend,
+                                     back_insert_iterator<vector<uint8_t>> itoutbeg,
+                                     ePXCompLevel                          compressionlvl,
+                                     bool                                  bZealousSearch,
+                                     bool                                  displayprogress,
+                                     bool                                  blogenabled )
+    {
+        PXCompressionCache & cache = PXCompressionCache::GetInstance();
+        if( !cache.IsEnabled() )
+            return CompressPX( itdatabeg, itdataend, itoutbeg, compressionlvl, bZealousSearch, displayprogress, blogenabled );
+
+        PXCompressionCache::key_t   key = PXCompressionCache::MakeKey( itdatabeg, itdataend, fmt, compressionlvl, bZealousSearch );
+        PXCompressionCache::entry_t entry;
+
+        if( !cache.Find( key, entry ) )
+        {
+            entry.info = CompressPX( itdatabeg, itdataend, back_inserter(entry.data), compressionlvl, bZealousSearch, displayprogress, blogenabled );
+            std::copy( entry.data.begin(), entry.data.end(), itoutbeg );
+            px_info_header result = entry.info;
+            cache.Insert( key, std::move(entry) );
+            return result;
+        }
+
+        std::copy( entry.data.begin(), entry.data.end(), itoutbeg );
+        return entry.info;
+    }
+};
@@ -0,0 +1,505 @@
+#include <ppmdu/fmts/rom_patch.hpp>
+#include <ppmdu/fmts/at4px.hpp>
+#include <ppmdu/fmts/nitrofs.hpp>
+#include <ppmdu/fmts/pkdpx.hpp>
+#include <utils/binary_delta.hpp>
+#include <utils/gfileio.hpp>
+#include <utils/library_wide.hpp>
+#include <utils/poco_wrapper.hpp>
+#include <utils/trace_profiler.hpp>
+#include <utils/virtual_fs.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <future>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+using namespace std;
+using namespace compression;
+
+namespace filetypes
+{
+//=========================================
+// Constants
+//=========================================
+    static const uint64_t RomPatch_FNVOffset = 0xCBF29CE484222325ull;
+    static const uint64_t RomPatch_FNVPrime  = 0x100000001B3ull;
+
+    /*
+        The settings the tools compress PX files with, tried in order when checking whether
+        a file can be rebuilt from its decompressed content.
+    */
+    static const pair<ePXCompLevel, bool> RomPatch_PXSettings[] =
+    {
+        { ePXCompLevel::LEVEL_3, true  },
+        { ePXCompLevel::LEVEL_3, false },
+    };
+
+    /*
+        Start of the patch file.
+    */
+    struct rompatch_header
+    {
+        uint32_t magic     = RomPatch_MagicNumber;
+        uint16_t version   = RomPatch_Version;
+        uint32_t nbentries = 0;
+
+        typedef utils::binlayout< utils::binfield<&rompatch_header::magic, utils::eByteOrder::Big>,
+                                  utils::binfield<&rompatch_header::version>,
+                                  utils::binfield<&rompatch_header::nbentries> > layout_t;
+    };
+
+//=========================================
+// Utility
+//=========================================
+    /*
+        FNV-1a over 64 bits words, then over the remaining bytes. It only checks that a
+        file is the one the patch expects, so it's made to go through large files quickly.
+    */
+    uint64_t HashFileData( const uint8_t * pdata, size_t len )
+    {
+        uint64_t hash = RomPatch_FNVOffset ^ len;
+        size_t   i    = 0;
+        for( ; i + sizeof(uint64_t) <= len; i += sizeof(uint64_t) )
+            hash = (hash ^ utils::Load<uint64_t>(pdata + i)) * RomPatch_FNVPrime;
+        for( ; i < len; ++i )
+            hash = (hash ^ pdata[i]) * RomPatch_FNVPrime;
+        return hash;
+    }
+
+    inline uint64_t HashFileData( const vector<uint8_t> & data )
+    {
+        return HashFileData( data.data(), data.size() );
+    }
+
+    /*
+        Calls fn(i) for each i in [0, count), spread over the threads the library is set to use.
+        Files vary a lot in size, so each thread takes the next index when it's done with one.
+        Stops handing out indices after a call throws, and rethrows the first exception.
+    */
+    template<class _FnTy>
+        void ParallelForEach( size_t count, _FnTy && fn )
+    {
+        atomic<size_t> nextidx(0);
+        auto lambdawork = [&]()
+        {
+            for( size_t idx = nextidx++; idx < count; idx = nextidx++ )
+            {
+                try
+                {
+                    fn(idx);
+                }
+                catch(...)
+                {
+                    nextidx = count;
+                    throw;
+                }
+            }
+        };
+
+        const size_t           nbthreads = std::max<size_t>( 1, std::min<size_t>( utils::LibWide().getNbThreadsToUse(), count ) );
+        vector<future<void>>   workers;
+        for( size_t i = 1; i < nbthreads; ++i )
+            workers.push_back( std::async( std::launch::async, lambdawork ) );
+        lambdawork();
+        for( auto & worker : workers )
+            worker.get();
+    }
+
+    inline string JoinPath( const string & root, const string & relpath )
+    {
+        if( relpath.empty() )
+            return root;
+        if( !root.empty() && (root.back() == '/' || root.back() == '\\') )
+            return root + relpath;
+        return root + "/" + relpath;
+    }
+
+    /*
+        Returns the paths of all the files under root, relative to it, sorted.
+    */
+    vector<string> ListFilesRecursive( const string & root )
+    {
+        vector<string> files;
+        vector<string> dirs{ string() };
+        while( !dirs.empty() )
+        {
+            const string reldir = std::move(dirs.back());
+            dirs.pop_back();
+            for( const auto & name : utils::ListDirContent_FilesAndDirs( JoinPath(root, reldir), true, false ) )
+            {
+                string relpath = reldir.empty()? name : reldir + "/" + name;
+                if( !relpath.empty() && relpath.back() == '/' )
+                {
+                    relpath.pop_back();
+                    dirs.push_back( std::move(relpath) );
+                }
+                else
+                    files.push_back( std::move(relpath) );
+            }
+        }
+        std::sort( files.begin(), files.end() );
+        return files;
+    }
+
+    /*
+        Patches come from elsewhere, so make sure an entry can't touch anything outside the root.
+    */
+    void ValidateEntryPath( const string & relpath )
+    {
+        bool bvalid = !relpath.empty() && relpath.front() != '/' && relpath.find_first_of("\\:") == string::npos;
+        for( size_t beg = 0; bvalid && beg <= relpath.size(); )
+        {
+            const size_t end = std::min( relpath.find('/', beg), relpath.size() );
+            const string comp = relpath.substr( beg, end - beg );
+            bvalid = !comp.empty() && comp != "." && comp != "..";
+            beg    = end + 1;
+        }
+        if( !bvalid )
+            throw runtime_error("Invalid path \"" + relpath + "\" in the patch!");
+    }
+
+//=========================================
+// PX Files
+//=========================================
+    /*
+        Returns whether the data is a AT4PX or PKDPX file, and which one.
+    */
+    bool IdentifyPXFile( const uint8_t * pdata, size_t len, ePXContainer & out_fmt )
+    {
+        if( len >= MagicNumber_PKDPX_Len && std::equal( MagicNumber_PKDPX.begin(), MagicNumber_PKDPX.end(), pdata ) )
+        {
+            out_fmt = ePXContainer::PKDPX;
+            return true;
+        }
+        if( len >= MagicNumber_AT4PX_Len && std::equal( MagicNumber_AT4PX.begin(), MagicNumber_AT4PX.end(), pdata ) )
+        {
+            out_fmt = ePXContainer::AT4PX;
+            return true;
+        }
+        return false;
+    }
+
+    vector<uint8_t> DecompressPXFile( ePXContainer fmt, const uint8_t * pdata, size_t len )
+    {
+        const vector<uint8_t> compressed( pdata, pdata + len );
+        vector<uint8_t>       raw;
+        if( fmt == ePXContainer::PKDPX )
+            DecompressPKDPX( compressed.begin(), compressed.end(), raw );
+        else
+            DecompressAT4PX( compressed.begin(), compressed.end(), raw );
+        return raw;
+    }
+
+    vector<uint8_t> CompressPXFile( ePXContainer fmt, const vector<uint8_t> & raw, ePXCompLevel lvl, bool bzealous )
+    {
+        vector<uint8_t> compressed;
+        if( fmt == ePXContainer::PKDPX )
+            CompressToPKDPX( raw.begin(), raw.end(), compressed, lvl, bzealous );
+        else
+            CompressToAT4PX( raw.begin(), raw.end(), compressed, lvl, bzealous );
+        return compressed;
+    }
+
+//=========================================
+// Making Patches
+//=========================================
+    /*
+        Replaces the plain delta in the entry with one of the decompressed content, if the
+        files are both PX compressed, the delta is smaller, and compressing the new content
+        gives back the exact same file. Otherwise leaves the entry as it was.
+    */
+    void TryMakePXDelta( const utils::io::MappedFile & oldf, const utils::io::MappedFile & newf, rompatch_entry & entry )
+    {
+        ePXContainer oldfmt;
+        ePXContainer newfmt;
+        if( !IdentifyPXFile( oldf.data(), oldf.size(), oldfmt ) || !IdentifyPXFile( newf.data(), newf.size(), newfmt ) || oldfmt != newfmt )
+            return;
+
+        try
+        {
+            utils::TraceScope     trace("TryMakePXDelta");
+            const vector<uint8_t> oldraw = DecompressPXFile( oldfmt, oldf.data(), oldf.size() );
+            const vector<uint8_t> newraw = DecompressPXFile( newfmt, newf.data(), newf.size() );
+            vector<uint8_t>       delta  = utils::MakeBinaryDelta( oldraw.data(), oldraw.size(), newraw.data(), newraw.size() );
+            if( delta.size() >= entry.payload.size() )
+                return;
+
+            for( const auto & settings : RomPatch_PXSettings )
+            {
+                const vector<uint8_t> recompressed = CompressPXFile( newfmt, newraw, settings.first, settings.second );
+                if( recompressed.size() == newf.size() && std::equal( recompressed.begin(), recompressed.end(), newf.begin() ) )
+                {
+                    entry.op        = eRomPatchOp::PXDelta;
+                    entry.pxfmt     = newfmt;
+                    entry.pxlvl     = settings.first;
+                    entry.pxzealous = settings.second? 1 : 0;
+                    entry.payload   = std::move(delta);
+                    return;
+                }
+            }
+        }
+        catch( const std::exception & )
+        {
+            //The files only look like PX files, keep the plain delta
+        }
+    }
+
+    /*
+        Compares the file at relpath in both roots. Returns false if it didn't change.
+    */
+    bool MakeRomPatchEntry( const string & oldroot, const string & newroot, const string & relpath, bool binold, bool binnew, bool bpxaware, rompatch_entry & out_entry )
+    {
+        out_entry.path = relpath;
+        if( !binold )
+        {
+            utils::io::MappedFile newf( JoinPath(newroot, relpath) );
+            if( newf.size() > numeric_limits<uint32_t>::max() )
+                throw runtime_error("MakeRomPatch(): \"" + relpath + "\" is too large!");
+            out_entry.op      = eRomPatchOp::Add;
+            out_entry.dstlen  = static_cast<uint32_t>(newf.size());
+            out_entry.dsthash = HashFileData( newf.data(), newf.size() );
+            out_entry.payload.assign( newf.begin(), newf.end() );
+            return true;
+        }
+
+        utils::io::MappedFile oldf( JoinPath(oldroot, relpath) );
+        if( oldf.size() > numeric_limits<uint32_t>::max() )
+            throw runtime_error("MakeRomPatch(): \"" + relpath + "\" is too large!");
+        out_entry.srclen  = static_cast<uint32_t>(oldf.size());
+        out_entry.srchash = HashFileData( oldf.data(), oldf.size() );
+        if( !binnew )
+        {
+            out_entry.op = eRomPatchOp::Remove;
+            return true;
+        }
+
+        utils::io::MappedFile newf( JoinPath(newroot, relpath) );
+        if( oldf.size() == newf.size() && (oldf.empty() || std::memcmp( oldf.data(), newf.data(), oldf.size() ) == 0) )
+            return false;
+        if( newf.size() > numeric_limits<uint32_t>::max() )
+            throw runtime_error("MakeRomPatch(): \"" + relpath + "\" is too large!");
+
+        out_entry.op      = eRomPatchOp::Delta;
+        out_entry.dstlen  = static_cast<uint32_t>(newf.size());
+        out_entry.dsthash = HashFileData( newf.data(), newf.size() );
+        out_entry.payload = utils::MakeBinaryDelta( oldf.data(), oldf.size(), newf.data(), newf.size() );
+        if( bpxaware )
+            TryMakePXDelta( oldf, newf, out_entry );
+        return true;
+    }
+
+    rom_patch MakeRomPatch( const std::string & oldroot, const std::string & newroot, bool bpxaware )
+    {
+        utils::TraceScope trace("MakeRomPatch");
+        NitroROMMount     oldmount(oldroot);
+        NitroROMMount     newmount(newroot);
+        if( !utils::isFolder(oldroot) )
+            throw runtime_error("MakeRomPatch(): \"" + oldroot + "\" isn't a directory or a ROM image!");
+        if( !utils::isFolder(newroot) )
+            throw runtime_error("MakeRomPatch(): \"" + newroot + "\" isn't a directory or a ROM image!");
+
+        const vector<string> oldfiles = ListFilesRecursive(oldroot);
+        const vector<string> newfiles = ListFilesRecursive(newroot);
+        vector<string>       allfiles;
+        allfiles.reserve( std::max( oldfiles.size(), newfiles.size() ) );
+        std::set_union( oldfiles.begin(), oldfiles.end(), newfiles.begin(), newfiles.end(), std::back_inserter(allfiles) );
+
+        vector<rompatch_entry> entries(allfiles.size());
+        vector<uint8_t>        bchanged(allfiles.size(), 0);   //Not a vector<bool>, since it's written from several threads
+        ParallelForEach( allfiles.size(), [&]( size_t idx )
+        {
+            const string & relpath = allfiles[idx];
+            const bool     binold  = std::binary_search( oldfiles.begin(), oldfiles.end(), relpath );
+            const bool     binnew  = std::binary_search( newfiles.begin(), newfiles.end(), relpath );
+            try
+            {
+                bchanged[idx] = MakeRomPatchEntry( oldroot, newroot, relpath, binold, binnew, bpxaware, entries[idx] )? 1 : 0;
+            }
+            catch( const std::exception & )
+            {
+                throw_with_nested( runtime_error("MakeRomPatch(): Couldn't compare \"" + relpath + "\"!") );
+            }
+        });
+
+        rom_patch patch;
+        for( size_t i = 0; i < entries.size(); ++i )
+        {
+            if( bchanged[i] != 0 )
+                patch.entries.push_back( std::move(entries[i]) );
+        }
+        return patch;
+    }
+
+//=========================================
+// Applying Patches
+//=========================================
+    /*
+        Returns the patched content of the file. Empty for removed files.
+    */
+    vector<uint8_t> PatchFile( const rompatch_entry & entry, const string & fpath )
+    {
+        vector<uint8_t> result;
+        if( entry.op == eRomPatchOp::Add )
+        {
+            if( utils::pathExists(fpath) )
+                throw runtime_error("The file to add already exists!");
+            result = entry.payload;
+        }
+        else
+        {
+            utils::io::MappedFile srcf(fpath);
+            if( srcf.size() != entry.srclen || HashFileData( srcf.data(), srcf.size() ) != entry.srchash )
+                throw runtime_error("The file isn't the one the patch was made for!");
+
+            if( entry.op == eRomPatchOp::Remove )
+                return result;
+            else if( entry.op == eRomPatchOp::Delta )
+                result = utils::ApplyBinaryDelta( srcf.data(), srcf.size(), entry.payload.data(), entry.payload.size() );
+            else
+            {
+                const vector<uint8_t> oldraw = DecompressPXFile( entry.pxfmt, srcf.data(), srcf.size() );
+                const vector<uint8_t> newraw = utils::ApplyBinaryDelta( oldraw.data(), oldraw.size(), entry.payload.data(), entry.payload.size() );
+                result = CompressPXFile( entry.pxfmt, newraw, entry.pxlvl, entry.pxzealous != 0 );
+            }
+        }
+
+        if( result.size() != entry.dstlen || HashFileData(result) != entry.dsthash )
+            throw runtime_error("The patched file isn't the one the patch expects!");
+        return result;
+    }
+
+    void ApplyRomPatch( const rom_patch & patch, const std::string & root )
+    {
+        utils::TraceScope trace("ApplyRomPatch");
+        NitroROMMount     rommount(root);
+        if( !utils::isFolder(root) )
+            throw runtime_error("ApplyRomPatch(): \"" + root + "\" isn't a directory or a ROM image!");
+
+        //A ROM image's header is rewritten when the changes are committed, so its entry is left out
+        const bool                     bromroot = rommount.IsMounted() && rommount.GetROM()->GetPath() == utils::io::NormalizeVirtualPath(root);
+        vector<const rompatch_entry *> todo;
+        todo.reserve( patch.entries.size() );
+        for( const auto & entry : patch.entries )
+        {
+            ValidateEntryPath(entry.path);
+            if( rommount.IsMounted() && (entry.op == eRomPatchOp::Add || entry.op == eRomPatchOp::Remove) )
+                throw runtime_error("ApplyRomPatch(): The patch adds or removes \"" + entry.path + "\", which can't be done to a ROM image!");
+            if( !bromroot || entry.path != NDS_FName_Header )
+                todo.push_back(&entry);
+        }
+
+        //Build everything first, so nothing is written if any file doesn't match
+        vector<vector<uint8_t>> results( todo.size() );
+        ParallelForEach( todo.size(), [&]( size_t idx )
+        {
+            const rompatch_entry & entry = *todo[idx];
+            try
+            {
+                results[idx] = PatchFile( entry, JoinPath(root, entry.path) );
+            }
+            catch( const std::exception & )
+            {
+                throw_with_nested( runtime_error("ApplyRomPatch(): Couldn't patch \"" + entry.path + "\"!") );
+            }
+        });
+
+        for( size_t i = 0; i < todo.size(); ++i )
+        {
+            const rompatch_entry & entry = *todo[i];
+            const string           fpath = JoinPath(root, entry.path);
+            if( entry.op == eRomPatchOp::Remove )
+            {
+                if( std::remove( fpath.c_str() ) != 0 )
+                    throw runtime_error("ApplyRomPatch(): Couldn't remove \"" + fpath + "\"!");
+                continue;
+            }
+
+            if( entry.op == eRomPatchOp::Add )
+            {
+                for( size_t slashpos = entry.path.find('/'); slashpos != string::npos; slashpos = entry.path.find('/', slashpos + 1) )
+                    utils::DoCreateDirectory( JoinPath( root, entry.path.substr(0, slashpos) ) );
+            }
+            utils::io::WriteByteVectorToFile( fpath, results[i] );
+            results[i] = vector<uint8_t>();
+        }
+        rommount.Commit();
+    }
+
+//=========================================
+// Patch Files
+//=========================================
+    rom_patch ReadRomPatch( const std::string & path )
+    {
+        utils::TraceScope     trace("ReadRomPatch");
+        utils::io::MappedFile patchf(path);
+        rom_patch             patch;
+        try
+        {
+            utils::BinaryCursor cursor( patchf.begin(), patchf.end() );
+            rompatch_header     hdr;
+            rompatch_header::layout_t::Read( hdr, cursor );
+            if( hdr.magic != RomPatch_MagicNumber )
+                throw runtime_error("Not a patch file!");
+            if( hdr.version != RomPatch_Version )
+                throw runtime_error("Unsupported patch version " + to_string(hdr.version) + "!");
+
+            //Don't trust the count to reserve, each entry takes at least its fixed part
+            patch.entries.reserve( std::min<size_t>( hdr.nbentries, cursor.Remaining() / rompatch_entry::layout_t::Size ) );
+            for( uint32_t i = 0; i < hdr.nbentries; ++i )
+            {
+                rompatch_entry entry;
+                rompatch_entry::layout_t::Read( entry, cursor );
+                if( entry.op > eRomPatchOp::PXDelta || entry.pxfmt > ePXContainer::PKDPX || entry.pxlvl > ePXCompLevel::LEVEL_3 )
+                    throw runtime_error("Entry #" + to_string(i) + " is invalid!");
+
+                const uint16_t pathlen = cursor.Read<uint16_t>();
+                const char *   ppath   = reinterpret_cast<const char*>( cursor.Take(pathlen) );
+                entry.path.assign( ppath, ppath + pathlen );
+                ValidateEntryPath(entry.path);
+
+                const uint32_t  payloadlen = cursor.Read<uint32_t>();
+                const uint8_t * ppayload   = cursor.Take(payloadlen);
+                entry.payload.assign( ppayload, ppayload + payloadlen );
+                patch.entries.push_back( std::move(entry) );
+            }
+        }
+        catch( const std::exception & )
+        {
+            throw_with_nested( runtime_error("ReadRomPatch(): Couldn't read patch file \"" + path + "\"!") );
+        }
+        return patch;
+    }
+
+    void WriteRomPatch( const std::string & path, const rom_patch & patch )
+    {
+        utils::TraceScope trace("WriteRomPatch");
+        size_t totallen = rompatch_header::layout_t::Size;
+        for( const auto & entry : patch.entries )
+        {
+            if( entry.path.size() > numeric_limits<uint16_t>::max() || entry.payload.size() > numeric_limits<uint32_t>::max() )
+                throw runtime_error("WriteRomPatch(): The entry for \"" + entry.path + "\" is too large!");
+            totallen += rompatch_entry::layout_t::Size + sizeof(uint16_t) + entry.path.size() + sizeof(uint32_t) + entry.payload.size();
+        }
+
+        vector<uint8_t> buffer(totallen);
+        uint8_t *       pcur = buffer.data();
+        rompatch_header hdr;
+        hdr.nbentries = static_cast<uint32_t>(patch.entries.size());
+        rompatch_header::layout_t::Store( hdr, pcur );
+        pcur += rompatch_header::layout_t::Size;
+
+        for( const auto & entry : patch.entries )
+        {
+            rompatch_entry::layout_t::Store( entry, pcur );
+            pcur += rompatch_entry::layout_t::Size;
+            utils::Store<uint16_t>( pcur, static_cast<uint16_t>(entry.path.size()) );
+            pcur  = std::copy( entry.path.begin(), entry.path.end(), pcur + sizeof(uint16_t) );
+            utils::Store<uint32_t>( pcur, static_cast<uint32_t>(entry.payload.size()) );
+            pcur  = std::copy( entry.payload.begin(), entry.payload.end(), pcur + sizeof(uint32_t) );
+        }
+        utils::io::WriteByteVectorToFile( path, buffer );
+    }
+};
@@ -68,6 +68,11 @@ namespace DSE
                 return (utils::ReadIntFromBytes<uint32_t>(itdatabeg, itdataend, false) == DSE::SEDL_MagicNumber);
             }
 
+            virtual std::vector<uint32_t> getMagicNumbers()const
+            {
+                return { DSE::SEDL_MagicNumber };
+            }
+
         private:
             cntRID_t m_myID;
         };
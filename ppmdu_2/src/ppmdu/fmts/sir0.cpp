@@ -17,12 +17,15 @@ No crappyrights. All wrongs reversed !
 #include <sstream>
 #include <iomanip>
 #include <array>
+#include <algorithm>
+#include <functional>
 using namespace std;
 using namespace utils;
 
 namespace filetypes
 {
     static const uint8_t SIR0_EncodedOffsetsHeader = 0x04u; //! #REMOVEME
+    static const uint8_t SIR0_PaddingByte          = 0xAAu;
     const ContentTy      CnTy_SIR0 {"sir0"}; 
 //========================================================================================================
 // sir0_header
@@ -135,39 +138,125 @@ namespace filetypes
 
     std::vector<uint32_t> DecodeSIR0PtrOffsetList( const std::vector<uint8_t>  &ptroffsetslst )
     {
-        vector<uint32_t> decodedptroffsets( ptroffsetslst.size() ); //worst case scenario
-        decodedptroffsets.resize(0);
+        vector<uint32_t> decodedptroffsets;
+        decodedptroffsets.reserve( ptroffsetslst.size() ); //worst case scenario
+        DecodeSIR0PtrOffsets( ptroffsetslst.data(), ptroffsetslst.data() + ptroffsetslst.size(), decodedptroffsets );
+        return std::move(decodedptroffsets);
+    }
 
-        auto itcurbyte  = ptroffsetslst.begin();
-        auto itlastbyte = ptroffsetslst.end();
+    const uint8_t * DecodeSIR0PtrOffsets( const uint8_t * pbeg, const uint8_t * pend, std::vector<uint32_t> & out_offsets )
+    {
+        static const uint64_t HighBits = 0x8080808080808080ull;
+        static const uint64_t LowBits  = 0x0101010101010101ull;
 
-        uint32_t offsetsum = 0; //This is used to sum up all offsets and obtain the offset relative to the file, and not the last offset
-        uint32_t buffer    = 0; //temp buffer to assemble longer offsets
-        uint8_t curbyte    = *itcurbyte;
-        bool    LastHadBitFlag = false; //This contains whether the byte read on the previous turn of the loop had the bit flag indicating to append the next byte!
+        const uint8_t * pcur           = pbeg;
+        uint32_t        offsetsum      = 0;     //Sum of all the offsets so far, the offsets are relative to the previous one
+        uint32_t        buffer         = 0;     //Assembles the offsets encoded on several bytes
+        bool            LastHadBitFlag = false; //Whether the previous byte had the bit flag indicating to append the next byte
 
-        while( itcurbyte != itlastbyte && ( LastHadBitFlag || (*itcurbyte) != 0 ) )
+        while( pcur != pend )
         {
-            curbyte = *itcurbyte;
-            buffer |= curbyte & 0x7Fu;
-        
-            if( (0x80u & curbyte) != 0 )
+            //Between two offsets, check 8 bytes at once. If none has the bit flag set, and none is the closing 0, they're 8 whole offsets.
+            if( !LastHadBitFlag && (pend - pcur) >= 8 )
             {
-                LastHadBitFlag = true;
-                buffer <<= 7u;
+                const uint64_t word = Load<uint64_t>(pcur);
+                if( (word & HighBits) == 0 && ((word - LowBits) & ~word & HighBits) == 0 )
+                {
+                    for( unsigned int i = 0; i < 8; ++i )
+                    {
+                        offsetsum += static_cast<uint32_t>( (word >> (i * 8)) & 0xFFu );
+                        out_offsets.push_back(offsetsum);
+                    }
+                    pcur += 8;
+                    continue;
+                }
             }
+
+            const uint8_t curbyte = *(pcur++);
+            if( !LastHadBitFlag && curbyte == 0 )
+                break;
+
+            buffer = (buffer << 7u) | (curbyte & 0x7Fu);
+            if( (0x80u & curbyte) != 0 )
+                LastHadBitFlag = true;
             else
             {
                 LastHadBitFlag = false;
                 offsetsum += buffer;
-                decodedptroffsets.push_back(offsetsum);
+                out_offsets.push_back(offsetsum);
                 buffer = 0;
             }
-        
-            ++itcurbyte;
         }
+        return pcur;
+    }
 
-        return std::move(decodedptroffsets);
+//========================================================================================================
+//  SIR0View
+//========================================================================================================
+    SIR0View::SIR0View( const uint8_t * pdata, size_t len )
+        :m_pdata(pdata), m_len(len)
+    {
+        if( len < sir0_header::HEADER_LEN )
+            throw runtime_error("SIR0View::SIR0View(): The data is too short to be a SIR0 container!");
+
+        m_hdr.ReadFromContainer( pdata, pdata + len );
+        if( m_hdr.magic != MagicNumber_SIR0 )
+            throw runtime_error("SIR0View::SIR0View(): The data is missing the SIR0 magic number!");
+        if( m_hdr.ptrPtrOffsetLst > len || m_hdr.ptrPtrOffsetLst < sir0_header::HEADER_LEN || m_hdr.subheaderptr > m_hdr.ptrPtrOffsetLst )
+        {
+            stringstream sstr;
+            sstr << "SIR0View::SIR0View(): The header's offsets are out of the data! Sub-header : 0x" <<hex <<m_hdr.subheaderptr
+                 <<", pointer offset list : 0x" <<m_hdr.ptrPtrOffsetLst <<", length : 0x" <<len <<"!";
+            throw runtime_error(sstr.str());
+        }
+
+        //Some writers put the list's alignment padding after the offset in the header. The list always begins with 0x04, so skip it.
+        size_t listbeg = m_hdr.ptrPtrOffsetLst;
+        while( listbeg < len && (listbeg % 16) != 0 && pdata[listbeg] == SIR0_PaddingByte )
+            ++listbeg;
+
+        m_ptroffsets.reserve( len - listbeg );
+        DecodeSIR0PtrOffsets( pdata + listbeg, pdata + len, m_ptroffsets );
+
+        //The offsets are a running sum, so they only stop increasing if it overflowed
+        if( std::adjacent_find( m_ptroffsets.begin(), m_ptroffsets.end(), std::greater_equal<uint32_t>() ) != m_ptroffsets.end() ||
+            (!m_ptroffsets.empty() && static_cast<size_t>(m_ptroffsets.back()) + sizeof(uint32_t) > m_hdr.ptrPtrOffsetLst) )
+            throw runtime_error("SIR0View::SIR0View(): The pointer offset list is corrupted!");
+    }
+
+    bool SIR0View::IsPointerAt( uint32_t offset )const
+    {
+        return std::binary_search( m_ptroffsets.begin(), m_ptroffsets.end(), offset );
+    }
+
+    uint32_t SIR0View::ReadPointer( size_t offset )const
+    {
+        if( offset > ContentEnd() || ContentEnd() - offset < sizeof(uint32_t) )
+        {
+            stringstream sstr;
+            sstr << "SIR0View::ReadPointer(): Offset 0x" <<hex <<offset <<" is out of the content!";
+            throw runtime_error(sstr.str());
+        }
+
+        const uint32_t ptr = Load<uint32_t>( m_pdata + offset );
+        if( ptr > ContentEnd() )
+        {
+            stringstream sstr;
+            sstr << "SIR0View::ReadPointer(): The pointer at offset 0x" <<hex <<offset <<" points out of the content, to 0x" <<ptr <<"!";
+            throw runtime_error(sstr.str());
+        }
+        return ptr;
+    }
+
+    utils::BinaryCursor SIR0View::CursorAt( size_t offset )const
+    {
+        if( offset > ContentEnd() )
+        {
+            stringstream sstr;
+            sstr << "SIR0View::CursorAt(): Offset 0x" <<hex <<offset <<" is out of the content!";
+            throw runtime_error(sstr.str());
+        }
+        return utils::BinaryCursor( m_pdata + offset, m_pdata + ContentEnd() );
     }
 
     vector<uint8_t> MakeSIR0Wrap( const vector<uint8_t>    & data, 
@@ -234,6 +323,7 @@ namespace filetypes
             rule->setRuleID( m_currentRID );
             m_rules.insert( make_pair( m_currentRID, std::unique_ptr<IContentHandlingRule>(rule) ) );
             ++m_currentRID;
+            RebuildDispatchTable();
 
             return ridbefore;
         }
@@ -248,6 +338,7 @@ namespace filetypes
         if( itfound != m_rules.end() )
         {
             m_rules.erase( itfound );
+            RebuildDispatchTable();
             return true;
         }
 
@@ -265,13 +356,26 @@ namespace filetypes
     ContentBlock SIR0DerivHandler::AnalyseContent( const analysis_parameter & parameters ) //! #REMOVEME
     {
         ContentBlock contentdetails;
+        sir0_header  headr;
+        uint32_t     magic    = 0;
+        bool         hasmagic = false;
+
+        //Get the magic number of the sub-header, to only try the rules that could match it
+        if( ContentRuleDispatchTable::ReadMagic( parameters._itdatabeg, parameters._itdataend, magic ) && magic == MagicNumber_SIR0 &&
+            static_cast<size_t>(std::distance( parameters._itdatabeg, parameters._itdataend )) >= sir0_header::HEADER_LEN )
+        {
+            headr.ReadFromContainer( parameters._itdatabeg, parameters._itdataend );
+            if( headr.subheaderptr < static_cast<size_t>(std::distance( parameters._itdatabeg, parameters._itdataend )) )
+                hasmagic = ContentRuleDispatchTable::ReadMagic( parameters._itdatabeg + headr.subheaderptr, parameters._itdataend, magic );
+        }
+
+        const ContentRuleDispatchTable::rulelist_t & candidates = (hasmagic)? m_dispatch.Candidates(magic) : m_dispatch.Generic();
 
-        //Feed the data through all the rules we have and check which one returns true
-        for( auto &rule : m_rules )
+        for( IContentHandlingRule * rule : candidates )
         {
-            if( rule.second->isMatch( parameters._itdatabeg, parameters._itdataend, parameters._filextension ) )
+            if( rule->isMatch( parameters._itdatabeg, parameters._itdataend, parameters._filextension ) )
             {
-                contentdetails = rule.second->Analyse( parameters );
+                contentdetails = rule->Analyse( parameters );
                 break;
             }
         }
@@ -279,6 +383,15 @@ namespace filetypes
         return contentdetails;
     }
 
+    void SIR0DerivHandler::RebuildDispatchTable()
+    {
+        ContentRuleDispatchTable::rulelist_t rules;
+        rules.reserve(m_rules.size());
+        for( auto & arule : m_rules )
+            rules.push_back(arule.second.get());
+        m_dispatch.Build(rules);
+    }
+
 
 //========================================================================================================
 //  sir0_rule
@@ -318,6 +431,11 @@ namespace filetypes
                                vector<uint8_t>::const_iterator   itdataend,
                                const std::string    & filext);
 
+        virtual std::vector<uint32_t> getMagicNumbers()const
+        {
+            return { MagicNumber_SIR0 };
+        }
+
     private:
         cntRID_t m_myID;
     };
@@ -11,6 +11,7 @@
 //#include <atomic>
 #include <iterator>
 #include <map>
+#include <set>
 #include <cassert>
 using namespace std;
 
@@ -626,6 +627,11 @@ namespace DSE
         return std::move( SMDL_Parser<>( itbeg, itend ));
     }
 
+    MusicSequence ParseSMDL( const uint8_t * itbeg, const uint8_t * itend )
+    {
+        return SMDL_Parser<const uint8_t*>( itbeg, itend );
+    }
+
     void WriteSMDL( const std::string & file, const MusicSequence & seq )
     {
         std::ofstream outf(file, std::ios::out | std::ios::binary );
@@ -810,6 +816,11 @@ std::ostream& operator<<(std::ostream& os, const DSE::SMDL_Header& hdr)
                 return (utils::ReadIntFromBytes<uint32_t>(itdatabeg, itdataend, false) == DSE::SMDL_MagicNumber);
             }
 
+            virtual std::vector<uint32_t> getMagicNumbers()const
+            {
+                return { DSE::SMDL_MagicNumber };
+            }
+
         private:
             cntRID_t m_myID;
         };
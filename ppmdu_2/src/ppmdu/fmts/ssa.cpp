@@ -1,8 +1,10 @@
 #include <ppmdu/fmts/ssa.hpp>
 #include <utils/utility.hpp>
+#include <utils/gfileio.hpp>
 #include <ppmdu/pmd2/pmd2_scripts.hpp>
 #include <iostream>
 #include <fstream>
+#include <sstream>
 #include <iomanip>
 using namespace std;
 using namespace pmd2;
@@ -889,14 +891,14 @@ namespace filetypes
         /*
             PrepareForWritingContent
                 Init the target container for writing and returns an iterator to write at!
+                The file is assembled in memory, and written out once complete.
                 Meant to separate file stream ops from anything that's more generic.
         */
-        inline outit_t PrepareForWritingContent(const std::string & outfname)
+        inline outit_t PrepareForWritingContent()
         {
-            m_outf.open(outfname, ios::binary | ios::out);
-            m_outf.exceptions(ofstream::badbit);
-            if( !m_outf )
-                throw std::runtime_error("SSDataWriter::Write(): Couldn't create file " + outfname);
+            m_outf.str(std::string());
+            m_outf.clear();
+            m_outf.exceptions(std::ostringstream::badbit);
             return outit_t(m_outf);
         }
 
@@ -1017,7 +1019,7 @@ namespace filetypes
             if(m_src.Layers().empty()) //Should never happen to be honest..
                 throw std::runtime_error("SSDataWriter::_Write(): We got a data file with no layers??\n");
 
-            outit_t itw(PrepareForWritingContent(outfname));
+            outit_t itw(PrepareForWritingContent());
             //#1 - Reserve Header + Allocate Layers
             itw = std::fill_n( itw, ssa_header::LEN, 0 );
             ResizeLayerTable();
@@ -1039,6 +1041,11 @@ namespace filetypes
             //#5 -Write the completed header!
             auto ithdr = PrepareForWritingHeader(); //have it start at the right position
             WriteHeader(ithdr);
+
+            //#6 -Write the file out. This goes through the VFS, so the target may be inside a mounted ROM image.
+            const std::string    filedata = m_outf.str();
+            std::vector<uint8_t> fdata( filedata.begin(), filedata.end() );
+            utils::io::WriteByteVectorToFile( outfname, fdata );
         }
 
        inline void WriteActionsTable(outit_t & itw)
@@ -1124,7 +1131,7 @@ namespace filetypes
 
     private:
         const pmd2::ScriptData & m_src;
-        std::ofstream            m_outf;
+        std::ostringstream       m_outf;
         ssa_header               m_hdr;
         std::vector<LayerEntry>  m_layertbl;
         std::vector<size_t>      m_actoffsets; //Contains the offsets of all the actions 
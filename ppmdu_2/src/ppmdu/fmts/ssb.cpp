@@ -4,6 +4,7 @@
 #include <ppmdu/pmd2/pmd2_text.hpp>
 #include <utils/utility.hpp>
 #include <utils/library_wide.hpp>
+#include <utils/gfileio.hpp>
 #include <iostream>
 #include <sstream>
 #include <fstream>
@@ -1163,7 +1164,7 @@ namespace filetypes
 
     class SSBWriter
     {
-        typedef ostreambuf_iterator<char> outit_t;
+        typedef vector<uint8_t>::iterator outit_t;
     public:
         SSBWriter(const pmd2::Script & scrdat, eGameRegion gloc, eOpCodeVersion opver, const LanguageFilesDB & langdat)
             :m_scrdat(scrdat), m_scrRegion(gloc), m_opversion(opver), m_langdat(langdat), m_opinfo(opver)
@@ -1177,16 +1178,14 @@ namespace filetypes
         void Write(const std::string & scriptfile)
         {
             //!MAKE SURE THE SCRIPT CONTAINS WHAT IT SHOULD HERE!!
-            m_outf.open(scriptfile, ios::binary | ios::out);
-            if( !m_outf )
-                throw std::runtime_error("SSBWriter::Write(): Couldn't open file " + scriptfile);
-
             m_hdrlen         = 0;
             m_datalen        = 0; 
             m_nbstrings      = 0;
+            m_codeoffset     = 0;
             m_constoffset    = 0;
             m_constblksize   = 0;
             m_stringblockbeg = 0;
+            m_filelen        = 0;
 
             m_compiledsrc = std::move( ScriptCompiler(m_scrdat, m_opversion, m_langdat ).Compile() );
 
@@ -1195,29 +1194,21 @@ namespace filetypes
             else if( m_scrRegion == eGameRegion::Europe )
                 m_hdrlen = ssb_header_pal::LEN;
 
-            outit_t oit(m_outf);
-            //#1 - Reserve data header 
-            std::fill_n( oit, m_hdrlen + ssb_data_hdr::LEN, 0 );
-            m_datalen += ssb_data_hdr::LEN; //Add to the total length immediately
-
-            //#2 - Reserve routine table
-            std::fill_n( oit, m_scrdat.Routines().size() * routine_entry::LEN, 0 );
-
-            //#3 - Pre-Alloc/pre-calc stuff
+            //#1 - Sizing pass. Every offset and length is known before writing anything, so nothing needs to be patched afterwards.
             CalcAndVerifyNbStrings();
-            m_grps.reserve( m_scrdat.Routines().size() );
-            m_datalen += m_scrdat.Routines().size() * routine_entry::LEN; //Add the routine entries length!!
-
-            //#4 - Write code for each groups, constants, strings
-            WriteCode();
-            WriteConstants();
-            WriteStrings();
+            CalcLayout();
 
-            //#5 - Header and routine table written last, since the offsets and sizes are calculated as we go.
-            m_outf.seekp(0, ios::beg);
-            outit_t ithdr(m_outf);
+            //#2 - Fill a buffer of the exact file size. Each section is written at its own offset.
+            vector<uint8_t> filedata(m_filelen, 0);
+            outit_t         ithdr = filedata.begin();
             WriteHeader      (ithdr);
             WriteRoutineTable(ithdr);
+            WriteCode        (filedata.begin() + m_codeoffset);
+            WriteConstants   (filedata.begin());
+            WriteStrings     (filedata.begin());
+
+            //#3 - Write it out in a single call. This goes through the VFS, so the target may be inside a mounted ROM image.
+            utils::io::WriteByteVectorToFile( scriptfile, filedata );
         }
 
     private:
@@ -1236,6 +1227,84 @@ namespace filetypes
             m_nbstrings = siz;
         }
 
+        /*
+            CalcLayout
+                Computes the offset and length of all the sections of the file, along with the lengths that go in the headers.
+        */
+        void CalcLayout()
+        {
+            //Header, data header and routine table
+            m_codeoffset = m_hdrlen + ssb_data_hdr::LEN + (m_compiledsrc.rawroutines.size() * routine_entry::LEN);
+            m_datalen   += ssb_data_hdr::LEN + (m_compiledsrc.rawroutines.size() * routine_entry::LEN);
+
+            //Code
+            size_t codelen = 0;
+            for( const auto & inst : m_compiledsrc.rawinstructions )
+                codelen += InstructionLen(inst);
+            m_datalen += codelen;
+            size_t curoffset = m_codeoffset + codelen;
+
+            //Constants
+            //**The constant pointer table counts as part of the script data, but not the constant strings it points to for some weird reasons!!**
+            if( !m_compiledsrc.constantstrings.empty() )
+            {
+                const size_t sizcptrtbl = m_compiledsrc.constantstrings.size() * ScriptWordLen;
+                m_constoffset  = curoffset;
+                m_datalen     += sizcptrtbl;
+                m_constblksize = CalcStringsDataLen( m_compiledsrc.constantstrings, m_constoffset + sizcptrtbl );
+                curoffset     += sizcptrtbl + m_constblksize;
+            }
+
+            //Strings
+            //**String block sizes include the ptr table!**
+            if( !m_compiledsrc.strings.empty() )
+            {
+                if( m_compiledsrc.strings.size() != m_stringblksSizes.size() )
+                {
+                    assert(false);
+                    throw std::runtime_error("SSBWriter::CalcLayout(): Mismatch in expected script string blocks to ouput!!");
+                }
+
+                const size_t szstringptrtbl = m_nbstrings * ScriptWordLen;
+                size_t       cntstrblk      = 0;
+                m_stringblockbeg = curoffset;
+                for( const auto & strblk : m_compiledsrc.strings )
+                {
+                    m_stringblksSizes[cntstrblk] = CalcStringsDataLen( strblk.second, curoffset + szstringptrtbl ) + szstringptrtbl;
+                    curoffset += m_stringblksSizes[cntstrblk];
+                    ++cntstrblk;
+                }
+            }
+            m_filelen = curoffset;
+        }
+
+        /*
+            CalcStringsDataLen
+                Returns the length in bytes of the string data of a string block, including the padding at the end.
+                "databeg" is the absolute offset the string data begins at, since the padding aligns the end of the block within the file.
+        */
+        template<class _CNT_T>
+            static size_t CalcStringsDataLen( const _CNT_T & container, size_t databeg )
+        {
+            size_t datalen = 0;
+            for( const auto & str : container )
+                datalen += str.size() + 1; //Count the terminating 0
+            return datalen + utils::CalculateLengthPadding( databeg + datalen, ScriptWordLen );
+        }
+
+        size_t InstructionLen( const ScriptInstruction & inst )
+        {
+            if( inst.type != eInstructionType::Command )
+            {
+                assert(false); //!#TODO: Error handling!!
+                throw std::logic_error("SSBWriter::InstructionLen(): Got an instruction that's not a command!! This is a programming logic error, and should be reported!");
+            }
+            size_t len = ScriptWordLen + (inst.parameters.size() * ScriptWordLen);
+            if( m_opinfo.Info(inst.value).NbParams() == -1 )
+                len += ScriptWordLen; //-1 instructions have their nb of parameters appended
+            return len;
+        }
+
         //void BuildLabelConversionTable()
         //{
         //    size_t curdataoffset = 0;
@@ -1331,85 +1400,56 @@ namespace filetypes
         }
 
 
-        inline void WriteCode()
+        inline void WriteCode( outit_t itw )
         {
             //Write the content of the group
             for( const auto & inst : m_compiledsrc.rawinstructions )
-                WriteInstruction(ostreambuf_iterator<char>(m_outf), inst);
+                itw = WriteInstruction(itw, inst);
         }
 
         outit_t WriteInstruction( outit_t itw, const ScriptInstruction & inst )
         {
-            if( inst.type == eInstructionType::Command  )
-            {
-                OpCodeInfoWrapper codeinf = m_opinfo.Info(inst.value);
-                itw = utils::WriteIntToBytes( inst.value, itw );
-                m_datalen += ScriptWordLen;
+            //The instruction was validated by the sizing pass
+            OpCodeInfoWrapper codeinf = m_opinfo.Info(inst.value);
+            itw = utils::WriteIntToBytes( inst.value, itw );
 
-                //If we're a -1 instruction, append the nb of instructions!!
-                if( codeinf.NbParams() == -1 )
-                {
-                    itw = utils::WriteIntToBytes( static_cast<uint16_t>(inst.parameters.size()), itw );
-                    m_datalen += ScriptWordLen;
-                }
+            //If we're a -1 instruction, append the nb of instructions!!
+            if( codeinf.NbParams() == -1 )
+                itw = utils::WriteIntToBytes( static_cast<uint16_t>(inst.parameters.size()), itw );
 
-                //Append the paramters
-                for( const auto & param : inst.parameters )
-                {
-                    itw = utils::WriteIntToBytes( param, itw );
-                    m_datalen += ScriptWordLen;
-                }
-            }
-            else
-            {
-                assert(false); //!#TODO: Error handling!!
-                throw std::logic_error("SSBWriter::WriteInstruction(): Got an instruction that's not a command!! This is a programming logic error, and should be reported!");
-            }
+            //Append the paramters
+            for( const auto & param : inst.parameters )
+                itw = utils::WriteIntToBytes( param, itw );
             return itw;
         }
 
 
-        void WriteConstants()
+        void WriteConstants( outit_t itfilebeg )
         {
             if( m_compiledsrc.constantstrings.empty() )
                 return;
-            //**The constant pointer table counts as part of the script data, but not the constant strings it points to for some weird reasons!!**
             //**Also, the offsets in the tables include the length of the string ptr table!**
-            const streampos befconsttbl = m_outf.tellp();
-            m_constoffset = static_cast<size_t>(befconsttbl);   //Save the location where we'll write the constant ptr table at, for the data header
-            
-            const uint16_t  sizcptrtbl     = m_compiledsrc.constantstrings.size() * ScriptWordLen;
             const uint16_t  szstringptrtbl = m_nbstrings * ScriptWordLen;
-            m_datalen += sizcptrtbl;    //Add the length of the table to the scriptdata length value for the header
-            m_constblksize = WriteTableAndStrings( m_compiledsrc.constantstrings, szstringptrtbl); //The constant strings data is not counted in datalen!
+            WriteTableAndStrings( m_compiledsrc.constantstrings, itfilebeg + m_constoffset, szstringptrtbl); //The constant strings data is not counted in datalen!
         }
 
         /*
             WriteStrings
                 Write the strings blocks
         */
-        void WriteStrings()
+        void WriteStrings( outit_t itfilebeg )
         {
             if( m_compiledsrc.strings.empty() )
                 return;
 
             size_t          cntstrblk       = 0;
-            const streampos befstrptrs      = m_outf.tellp();
+            size_t          curoffset       = m_stringblockbeg;
             const uint16_t  lengthconstdata = (m_compiledsrc.constantstrings.size() * ScriptWordLen) + m_constblksize; //The length of the constant ptr tbl and the constant data!
-            const uint16_t  szstringptrtbl = m_nbstrings * ScriptWordLen;
-            m_stringblockbeg = static_cast<size_t>(befstrptrs); //Save the starting position of the string data, for later
-
-            if( !m_compiledsrc.strings.empty() && m_compiledsrc.strings.size() != m_stringblksSizes.size() )
-            {
-                assert(false);
-                throw std::runtime_error("SSBWriter::WriteStrings(): Mismatch in expected script string blocks to ouput!!");
-            }
 
             for( const auto & strblk : m_compiledsrc.strings )
             {
-                //Write each string blocks and save the length of the data into our table for later. 
-                //**String block sizes include the ptr table!**
-                m_stringblksSizes[cntstrblk] = WriteTableAndStrings( strblk.second, lengthconstdata ) + szstringptrtbl; //We need to count the offset table too!!
+                WriteTableAndStrings( strblk.second, itfilebeg + curoffset, lengthconstdata );
+                curoffset += m_stringblksSizes[cntstrblk];
                 ++cntstrblk;
             }
         }
@@ -1417,42 +1457,28 @@ namespace filetypes
 
         /*
             WriteTableAndStrings
-                Writes a string block, either the constants' strings or strings' strings
-                Returns the length in bytes of the string data, **not counting the ptr table!**
+                Writes a string block, either the constants' strings or strings' strings, at the position the sizing pass reserved for it.
+                The padding at the end of the block is already zeroed.
         */
         template<class _CNT_T>
-            size_t WriteTableAndStrings(
-                                         const _CNT_T & container,              //What contains the strings to write(std container needs begin() end() size() and const_iterator)
-                                         size_t         ptrtbloffsebytes = 0 ) //Offset in **bytes** to add to all ptrs in the ptr table
+            void WriteTableAndStrings(
+                                       const _CNT_T & container,              //What contains the strings to write(std container needs begin() end() size() and const_iterator)
+                                       outit_t        itblock,                //Where the block's pointer table begins
+                                       size_t         ptrtbloffsebytes = 0 ) //Offset in **bytes** to add to all ptrs in the ptr table
         {
-            size_t          cntstr     = 0;
-            const streampos befptrs    = m_outf.tellp();
-            const uint16_t  sizcptrtbl = (container.size() * ScriptWordLen);
-            
-            //Reserve pointer table so we can write there as we go
-            std::fill_n( ostreambuf_iterator<char>(m_outf), sizcptrtbl, 0 );
+            const size_t sizcptrtbl = (container.size() * ScriptWordLen);
+            size_t       curoffset  = sizcptrtbl;   //Offset from the start of the ptr table
+            outit_t      itptr      = itblock;
+            outit_t      itdata     = itblock + sizcptrtbl;
 
-            //Write strings
-            const streampos befdata = m_outf.tellp();
             for( const auto & str : container )
             {
-                //Write offset in table 
-                streampos curpos = m_outf.tellp();
-
-                m_outf.seekp( static_cast<size_t>(befptrs) + (cntstr * ScriptWordLen), ios::beg ); //Seek to the const ptr tbl
-                utils::WriteIntToBytes<uint16_t>( (ptrtbloffsebytes + (curpos - befptrs)), ostreambuf_iterator<char>(m_outf) );            //Add offset to table
-                m_outf.seekp( curpos, ios::beg ); //Seek back at the position we'll write the string at
-
-                //write string
-                std::copy( str.begin(), str.end(), ostreambuf_iterator<char>(m_outf) );
-                m_outf.put('\0'); //Append zero
-                ++cntstr;
+                itptr  = utils::WriteIntToBytes<uint16_t>( static_cast<uint16_t>(ptrtbloffsebytes + curoffset), itptr ); //Add offset to table
+                itdata = std::copy( str.begin(), str.end(), itdata );
+                *itdata = 0; //Append zero
+                ++itdata;
+                curoffset += str.size() + 1;
             }
-            //Add some padding bytes if needed (padding is counted in the block's length)
-            utils::AppendPaddingBytes(ostreambuf_iterator<char>(m_outf), m_outf.tellp(), ScriptWordLen);
-
-            //Return the size of the constant strings data
-            return m_outf.tellp() - befdata;
         }
 
 
@@ -1474,12 +1500,14 @@ namespace filetypes
         uint16_t            m_hdrlen; 
 
         size_t              m_nbstrings;
-        vector<uint16_t>    m_stringblksSizes;     //in bytes //The lenghts of all strings blocks for each languages
-        uint16_t            m_constblksize;        //in bytes //The length of the constant data block
+        vector<size_t>      m_stringblksSizes;     //in bytes //The lenghts of all strings blocks for each languages
+        size_t              m_constblksize;        //in bytes //The length of the constant data block
 
         size_t              m_datalen;             //in bytes //Length of the Data block in bytes
+        size_t              m_codeoffset;          //in bytes //Start of the instructions from start of file
         size_t              m_constoffset;         //in bytes //Start of the constant block from  start of file
         size_t              m_stringblockbeg;      //in bytes //Start of strings blocks from  start of file
+        size_t              m_filelen;             //in bytes //Total length of the file
         vector<routine_entry> m_grps;
 
         unordered_map<uint16_t,uint16_t> m_labeltbl; //First is label ID, second is label offset in words
@@ -1487,7 +1515,6 @@ namespace filetypes
         eOpCodeVersion m_opversion; 
         eGameRegion    m_scrRegion;
 
-        ofstream       m_outf;
         raw_ssb_content m_compiledsrc;      //Source of the compiled data
         const LanguageFilesDB & m_langdat;
         OpCodeClassifier m_opinfo;
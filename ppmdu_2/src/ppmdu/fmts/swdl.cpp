@@ -1,10 +1,15 @@
 #include <ppmdu/fmts/swdl.hpp>
 #include <dse/dse_containers.hpp>
 #include <utils/library_wide.hpp>
+#include <utils/gfileio.hpp>
+#include <utils/poco_wrapper.hpp>
+#include <utils/virtual_fs.hpp>
 #include <iostream>
 #include <iomanip>
 #include <fstream>
 #include <sstream>
+#include <cstdio>
+#include <cstring>
 using namespace std;
 
 namespace DSE
@@ -1828,6 +1833,9 @@ namespace DSE
 // SWDLParser
 //===============================================================================
 
+    template<class _init>
+        SWDL_HeaderData ReadSwdlHeader( _init itbeg, _init itend );
+
     template<class _rait = std::vector<uint8_t>::const_iterator >
         class SWDLParser
     {
@@ -2190,6 +2198,116 @@ namespace DSE
         //const std::vector<uint8_t> & m_src;
     };
 
+//====================================================================================================
+// SWDL_IncrementalBase
+//====================================================================================================
+
+    /*
+        SWDL_IncrementalBase
+            Layout of an existing SWDL file, that an incremental write copies unchanged data from.
+            Only pointers into the source are kept, so it must stay mapped for as long as this is used.
+            Only DSE version 0x415 files are supported for now.
+    */
+    struct SWDL_IncrementalBase
+    {
+        typedef std::pair<const uint8_t*, const uint8_t*> rawrange_t;
+
+        eDSEVersion                 version  = eDSEVersion::VInvalid;
+        uint32_t                    pcmdlen  = 0;       //Value of the pcmd length field in the source's header
+        const uint8_t             * srcend   = nullptr;
+        std::vector<const uint8_t*> wavientries;        //Raw wavi entry of each sample slots, or null if empty
+        std::vector<rawrange_t>     smpldata;           //Raw data of each sample slots in the pcmd chunk, or null if empty
+        std::vector<rawrange_t>     prgientries;        //Raw prgi entry of each program slots, or null if empty
+
+        SWDL_IncrementalBase( const uint8_t * itbeg, const uint8_t * itend )
+            :srcend(itend)
+        {
+            SWDL_HeaderData hdr = ReadSwdlHeader( itbeg, itend );
+            version = intToDseVer(hdr.version);
+            pcmdlen = hdr.pcmdlen;
+
+            if( version != eDSEVersion::V415 )
+                throw runtime_error("SWDL_IncrementalBase::SWDL_IncrementalBase(): Incremental writes are only supported for DSE version 0x415 files!");
+
+            ReadWavi( itbeg, itend, hdr.nbwavislots );
+            ReadPrgi( itbeg, itend, hdr.nbprgislots );
+        }
+
+    private:
+        void ReadWavi( const uint8_t * itbeg, const uint8_t * itend, size_t nbslots )
+        {
+            wavientries.resize( nbslots, nullptr );
+            smpldata   .resize( nbslots, rawrange_t(nullptr, nullptr) );
+
+            const uint8_t * itwavi = DSE::FindNextChunk( itbeg, itend, eDSEChunks::wavi );
+            if( itwavi == itend )
+                throw runtime_error("SWDL_IncrementalBase::ReadWavi(): Couldn't find wavi chunk !!!!!");
+
+            ChunkHeader wavihdr;
+            itwavi = wavihdr.ReadFromContainer( itwavi, itend );
+
+            //Sample positions are relative to the beginning of the pcmd chunk's data
+            const uint8_t * itpcmd = DSE::FindNextChunk( itbeg, itend, eDSEChunks::pcmd );
+            if( itpcmd != itend )
+            {
+                ChunkHeader pcmdhdr;
+                itpcmd = pcmdhdr.ReadFromContainer( itpcmd, itend );
+            }
+
+            const uint8_t * itreadptr = itwavi;
+            for( size_t cntslot = 0; cntslot < nbslots; ++cntslot )
+            {
+                uint16_t smplinfoffset = 0;
+                itreadptr = utils::ReadIntFromBytes( smplinfoffset, itreadptr, itend );
+
+                if( smplinfoffset == 0 )
+                    continue;
+                if( static_cast<size_t>(itend - itwavi) < smplinfoffset + WavInfo_v415::Size )
+                    throw runtime_error("SWDL_IncrementalBase::ReadWavi(): Wavi entry #" + to_string(cntslot) + " is out of bounds!");
+
+                wavientries[cntslot] = itwavi + smplinfoffset;
+                if( itpcmd == itend )
+                    continue;
+
+                WavInfo_v415 winf;
+                winf.ReadFromContainer( wavientries[cntslot], itend );
+                size_t smpllen = DSESampleLoopOffsetToBytes( winf.loopbeg + winf.looplen );
+
+                if( static_cast<size_t>(winf.smplpos) + smpllen <= static_cast<size_t>(itend - itpcmd) )
+                    smpldata[cntslot] = rawrange_t( itpcmd + winf.smplpos, itpcmd + winf.smplpos + smpllen );
+            }
+        }
+
+        void ReadPrgi( const uint8_t * itbeg, const uint8_t * itend, size_t nbslots )
+        {
+            prgientries.resize( nbslots, rawrange_t(nullptr, nullptr) );
+
+            const uint8_t * itprgi = DSE::FindNextChunk( itbeg, itend, eDSEChunks::prgi );
+            if( itprgi == itend )
+                return; //Its possible there are no programs
+
+            ChunkHeader prgihdr;
+            itprgi = prgihdr.ReadFromContainer( itprgi, itend );
+
+            const uint8_t * itreadptr = itprgi;
+            for( size_t cntslot = 0; cntslot < nbslots; ++cntslot )
+            {
+                uint16_t prginfblk = 0;
+                itreadptr = utils::ReadIntFromBytes( prginfblk, itreadptr, itend );
+
+                if( prginfblk == 0 )
+                    continue;
+                if( static_cast<size_t>(itend - itprgi) <= prginfblk )
+                    throw runtime_error("SWDL_IncrementalBase::ReadPrgi(): Prgi entry #" + to_string(cntslot) + " is out of bounds!");
+
+                //Parse the entry just to find where it ends
+                ProgramInfo_v415 curblock;
+                const uint8_t *  itentry = itprgi + prginfblk;
+                prgientries[cntslot] = rawrange_t( itentry, curblock.ReadFromContainer( itentry, itend ) );
+            }
+        }
+    };
+
 
 
 //====================================================================================================
@@ -2200,20 +2318,78 @@ namespace DSE
         class SWDL_Writer;
 
 
+    /*
+        Writes to any output stream. The offsets and lengths are patched in by seeking back, so
+        the output is best kept in memory, and written to disk in one go once done.
+    */
     template<>
-        class SWDL_Writer<std::ofstream>
+        class SWDL_Writer<std::ostream>
     {
         typedef ostreambuf_iterator<char> writeit_t;
     public:
-        typedef std::ofstream cnty;
+        typedef std::ostream cnty;
 
         /*
             - pcmdflag : The value of the lowest 16 bits of the pcmdlen value when there is no pcmd chunk. Used in some games.
         */
         SWDL_Writer( cnty & tgtcnt, const DSE::PresetBank & srcbnk, uint16_t pcmdflag = 0x0000, uint8_t padbyte = 0xAA, eDSEVersion dseVersion = eDSEVersion::VDef )
-            :m_tgtcn(tgtcnt), m_src(srcbnk), m_pcmdflag(pcmdflag), m_padbyte(padbyte), m_version(dseVersion)
+            :m_tgtcn(tgtcnt), m_src(srcbnk), m_pcmdflag(pcmdflag), m_padbyte(padbyte), m_version(dseVersion), m_pbase(nullptr)
         {}
 
+        /*
+            Incremental write. Samples, wavi entries and programs that are identical to those in the base file
+            are copied straight from it, instead of being re-serialized.
+            - base : Layout of the source file. Must stay valid until the write is done.
+        */
+        SWDL_Writer( cnty & tgtcnt, const DSE::PresetBank & srcbnk, const SWDL_IncrementalBase & base, uint8_t padbyte = 0xAA )
+            :m_tgtcn(tgtcnt),
+             m_src(srcbnk),
+             m_pcmdflag( ((base.pcmdlen & 0xFFFF0000) == SWDL_Header_v415::ValNoPCMD)? static_cast<uint16_t>(base.pcmdlen & 0xFFFF) : 0 ),
+             m_padbyte(padbyte),
+             m_version(base.version),
+             m_pbase(&base)
+        {}
+
+        /*
+            Sizing pass. Returns the length of the file that will be written, or a bit more, due to the padding.
+        */
+        size_t CalcMaxFileLength()const
+        {
+            auto ptrsbnk = m_src.smplbank().lock();
+            if( ptrsbnk == nullptr )
+                throw runtime_error("SWDL_Writer::CalcMaxFileLength() : SWDL has no sample info or data!");
+
+            size_t flen = GetDSEHeaderLen( m_version );
+
+            //wavi
+            flen += DSE::ChunkHeader::Size + CalculateWaviTableLenWithPadding( *ptrsbnk ) + (WavInfo_v402::SzType2 * ptrsbnk->NbSlots());
+
+            //prgi + kgrp
+            auto ptrpresbnk = m_src.prgmbank().lock();
+            if( ptrpresbnk != nullptr )
+            {
+                flen += DSE::ChunkHeader::Size + (ptrpresbnk->PrgmInfo().size() * 2) + 16;
+                for( const auto & ptrprg : ptrpresbnk->PrgmInfo() )
+                {
+                    if( ptrprg != nullptr )
+                        flen += ProgramInfo_v415::PrgInfoHeader::SIZE + (ptrprg->m_lfotbl.size() * LFOTblEntry::SIZE) + 16 + (ptrprg->m_splitstbl.size() * SplitEntry_v415::SIZE);
+                }
+                flen += DSE::ChunkHeader::Size + (ptrpresbnk->Keygrps().size() * KeyGroup::SIZE) + 16;
+            }
+
+            //pcmd
+            flen += DSE::ChunkHeader::Size;
+            for( size_t i = 0; i < ptrsbnk->NbSlots(); ++i )
+            {
+                const vector<uint8_t> * ptrdata = ptrsbnk->sample(i);
+                if( ptrdata != nullptr )
+                    flen += ptrdata->size();
+            }
+
+            //eod
+            return flen + DSE::ChunkHeader::Size;
+        }
+
         void operator()()
         {
             streampos befswdl = m_tgtcn.tellp();
@@ -2306,7 +2482,8 @@ namespace DSE
                 hdr.minute   = m_src.metadata().createtime.minute;
                 hdr.second   = m_src.metadata().createtime.second;
                 hdr.centisec = m_src.metadata().createtime.centsec;
-                std::copy( begin(m_src.metadata().fname), end(m_src.metadata().fname), begin(hdr.fname) );
+                hdr.fname.fill(0);
+                std::copy_n( begin(m_src.metadata().fname), std::min( m_src.metadata().fname.size(), hdr.fname.size() ), begin(hdr.fname) );
                 hdr.unk10    = SWDL_Header_v415::DefUnk10;
                 hdr.unk11    = 0; //Always null
                 hdr.unk12    = 0; //Always null
@@ -2352,7 +2529,8 @@ namespace DSE
                 hdr.minute   = m_src.metadata().createtime.minute;
                 hdr.second   = m_src.metadata().createtime.second;
                 hdr.centisec = m_src.metadata().createtime.centsec;
-                std::copy( begin(m_src.metadata().fname), end(m_src.metadata().fname), begin(hdr.fname) );
+                hdr.fname.fill(0);
+                std::copy_n( begin(m_src.metadata().fname), std::min( m_src.metadata().fname.size(), hdr.fname.size() ), begin(hdr.fname) );
                 hdr.unk10    = SWDL_Header_v402::DefUnk10;
                 hdr.unk11    = 0; //Always null
                 hdr.unk12    = 0; //Always null
@@ -2435,7 +2613,7 @@ namespace DSE
         //    hdr.WriteToContainer(itout);
         //}
 
-        size_t CalculateWaviTableLenWithPadding( const DSE::SampleBank & smplbank )
+        size_t CalculateWaviTableLenWithPadding( const DSE::SampleBank & smplbank )const
         {
             return (smplbank.NbSlots() * 2) + ((smplbank.NbSlots() * 2) % 16);
         }
@@ -2499,23 +2677,28 @@ namespace DSE
             streampos entryoffset = m_tgtcn.tellp();
             wavientry.smplpos = pcmdsmploffset; //Set the pcmd chunk relative sample offset
 
-            if( m_version == eDSEVersion::V415 )
+            if( IsWaviEntryUnchanged( wavientry, entryindex ) )
             {
+                //Keep the source's entry as-is, only the sample's position may have moved
+                WavInfo_v415 vdwavinf;
+                vdwavinf.ReadFromContainer( m_pbase->wavientries[entryindex], m_pbase->srcend );
+                vdwavinf.smplpos = wavientry.smplpos;
+                itout = vdwavinf.WriteToContainer(itout);
+            }
+            else if( m_version == eDSEVersion::V415 )
+            {
+                //The conversion fills the fields we don't know the meaning of with their usual values
                 WavInfo_v415 vdwavinf = wavientry;
-
-                //Fill in missing data
-                assert(false);
+                KeepUnknownWaviFields( vdwavinf, entryindex );
 
                 //write
                 itout = vdwavinf.WriteToContainer(itout);
             }
             else if( m_version == eDSEVersion::V402 )
             {
+                //The conversion fills the fields we don't know the meaning of with their usual values
                 WavInfo_v402 vdwavinf( wavientry);
 
-                //Fill in missing data
-                assert(false);
-
                 //write
                 itout = vdwavinf.WriteToContainer(itout);
             }
@@ -2554,7 +2737,7 @@ namespace DSE
             //Place table padding 
             int padlen =  (m_tgtcn.tellp() % 16);
             if( padlen != 0 )
-                std::fill_n( itout, padlen, m_padbyte );
+                std::fill_n( itout, 16 - padlen, m_padbyte );
 
             //Write Entries
             for( size_t i = 0; i < prgbnk.size(); ++i )
@@ -2570,7 +2753,7 @@ namespace DSE
             //Write header
             WriteChunkHeader( itout, 
                               static_cast<uint32_t>(eDSEChunks::prgi), 
-                              static_cast<std::streamoff>(endprgi));
+                              static_cast<uint32_t>(endprgi - begtbl) );
             //ChunkHeader hdr;
             //hdr.label  = static_cast<uint32_t>(eDSEChunks::prgi);
             //hdr.param1 = SWDL_ChunksDefParam1;
@@ -2584,23 +2767,26 @@ namespace DSE
         {
             streampos befentry = m_tgtcn.tellp();
 
-            if( m_version == eDSEVersion::V415 )
+            if( IsPrgiEntryUnchanged( entry, entryindex ) )
             {
+                //Copy the source's entry verbatim
+                const auto & srcentry = m_pbase->prgientries[entryindex];
+                m_tgtcn.write( reinterpret_cast<const char*>(srcentry.first), srcentry.second - srcentry.first );
+            }
+            else if( m_version == eDSEVersion::V415 )
+            {
+                //The conversion fills the fields we don't know the meaning of with their usual values
                 ProgramInfo_v415 prginf(entry);
-
-                //!#TODO: Fill in missing data
-                assert(false);
+                KeepUnknownPrgiFields( prginf, entryindex );
 
                 //write
                 itout = prginf.WriteToContainer(itout);
             }
             else if( m_version == eDSEVersion::V402 )
             {
+                //The conversion fills the fields we don't know the meaning of with their usual values
                 ProgramInfo_v402 prginf(entry);
 
-                //!#TODO: Fill in missing data
-                assert(false);
-
                 //write
                 itout = prginf.WriteToContainer(itout);
             }
@@ -2614,7 +2800,7 @@ namespace DSE
 
             //Go write pointer in the table
             streampos afentry = m_tgtcn.tellp();
-            m_tgtcn.seekp(static_cast<std::streamoff>(beftbl) + offsbegtbl);
+            m_tgtcn.seekp( beftbl + std::streampos(entryindex * 2) );
             utils::WriteIntToBytes( static_cast<uint16_t>(offsbegtbl), itout );
 
             //Seek back to end
@@ -2633,17 +2819,43 @@ namespace DSE
             itout = std::fill_n( itout, ChunkHeader::Size, 0 );
             streampos begdata = m_tgtcn.tellp();
 
-            const size_t nbslots = smplbank.NbSlots();
+            const size_t    nbslots   = smplbank.NbSlots();
+            size_t          nbreused  = 0;
+            uint32_t        curoffset = 0;       //Offset of the next sample, relative to the start of the pcmd data
+            const uint8_t * itrunbeg  = nullptr; //Range of unchanged samples from the source file waiting to be copied
+            const uint8_t * itrunend  = nullptr;
+
             for( size_t i = 0; i < nbslots; ++i )
             {
                 const vector<uint8_t> * ptrdata = smplbank.sample(i);
-                if( ptrdata != nullptr )
+                if( ptrdata == nullptr )
+                    continue;
+
+                sampleoffsets[i] = curoffset; //Store sample offset!
+                const uint8_t * itsrc = FindUnchangedSample( *ptrdata, i );
+
+                if( itsrc != nullptr )
+                {
+                    //Unchanged samples that follow each others in the source file are copied in a single write
+                    if( itsrc != itrunend )
+                    {
+                        FlushSourceRun( itrunbeg, itrunend );
+                        itrunbeg = itsrc;
+                    }
+                    itrunend = itsrc + ptrdata->size();
+                    ++nbreused;
+                }
+                else
                 {
-                    streampos befsmpl = m_tgtcn.tellp();
-                    sampleoffsets[i]  = static_cast<uint32_t>(befsmpl); //Store sample offset!
-                    itout = std::copy( ptrdata->begin(), ptrdata->end(), itout );
+                    FlushSourceRun( itrunbeg, itrunend );
+                    m_tgtcn.write( reinterpret_cast<const char*>(ptrdata->data()), ptrdata->size() );
                 }
+                curoffset += static_cast<uint32_t>(ptrdata->size());
             }
+            FlushSourceRun( itrunbeg, itrunend );
+
+            if( m_pbase != nullptr && utils::LibWide().isLogOn() )
+                clog << "SWDL_Writer::WritePCMD(): Copied " <<nbreused <<" unchanged samples from the source file.\n";
 
             //Seek to beginning and write the header!
             //ChunkHeader hdr;
@@ -2652,7 +2864,7 @@ namespace DSE
             
             WriteChunkHeader( itout, 
                               static_cast<uint32_t>(eDSEChunks::pcmd), 
-                              static_cast<uint32_t>(afterdata) );
+                              static_cast<uint32_t>(afterdata - begdata) );
             //hdr.label  = static_cast<uint32_t>(eDSEChunks::pcmd);
             //hdr.param1 = SWDL_ChunksDefParam1;
             //hdr.param2 = SWDL_ChunksDefParam2;
@@ -2662,7 +2874,120 @@ namespace DSE
             //Seek back to end
             m_tgtcn.seekp(afterdata);
 
-            return static_cast<streamoff>(afterdata);
+            return static_cast<streamoff>(afterdata - begdata);
+        }
+
+        /*
+            Returns where the sample's data is in the source file of an incremental write, if the sample
+            in the slot specified is the same as the source's. Otherwise, returns null.
+        */
+        const uint8_t * FindUnchangedSample( const std::vector<uint8_t> & smpl, size_t slot )const
+        {
+            if( m_pbase == nullptr || slot >= m_pbase->smpldata.size() || smpl.empty() )
+                return nullptr;
+
+            const auto & srcrange = m_pbase->smpldata[slot];
+            if( static_cast<size_t>(srcrange.second - srcrange.first) != smpl.size() ||
+                std::memcmp( srcrange.first, smpl.data(), smpl.size() ) != 0 )
+                return nullptr;
+            return srcrange.first;
+        }
+
+        void FlushSourceRun( const uint8_t *& itrunbeg, const uint8_t *& itrunend )
+        {
+            if( itrunbeg != itrunend )
+                m_tgtcn.write( reinterpret_cast<const char*>(itrunbeg), itrunend - itrunbeg );
+            itrunbeg = nullptr;
+            itrunend = nullptr;
+        }
+
+        /*
+            Returns whether the sample entry in the slot specified holds the same values as the source's entry.
+            The sample's position isn't compared, since it's expected to change.
+        */
+        bool IsWaviEntryUnchanged( const DSE::WavInfo & entry, size_t slot )const
+        {
+            if( m_pbase == nullptr || slot >= m_pbase->wavientries.size() || m_pbase->wavientries[slot] == nullptr )
+                return false;
+
+            WavInfo_v415 srcentry;
+            srcentry.ReadFromContainer( m_pbase->wavientries[slot], m_pbase->srcend );
+            DSE::WavInfo srcinf = srcentry;
+            srcinf.smplpos = entry.smplpos;
+            return srcinf == entry;
+        }
+
+        /*
+            Returns whether the program in the slot specified holds the same values as the source's program.
+        */
+        bool IsPrgiEntryUnchanged( const DSE::ProgramInfo & entry, size_t slot )const
+        {
+            if( m_pbase == nullptr || slot >= m_pbase->prgientries.size() || m_pbase->prgientries[slot].first == nullptr )
+                return false;
+
+            ProgramInfo_v415 srcentry;
+            srcentry.ReadFromContainer( m_pbase->prgientries[slot].first, m_pbase->prgientries[slot].second );
+            return static_cast<DSE::ProgramInfo>(srcentry) == entry;
+        }
+
+        /*
+            When a modified sample entry replaces one from the source file of an incremental write, keep the 
+            values of the source's fields we don't know the meaning of, instead of the usual values.
+        */
+        void KeepUnknownWaviFields( WavInfo_v415 & entry, size_t slot )const
+        {
+            if( m_pbase == nullptr || slot >= m_pbase->wavientries.size() || m_pbase->wavientries[slot] == nullptr )
+                return;
+
+            WavInfo_v415 srcentry;
+            srcentry.ReadFromContainer( m_pbase->wavientries[slot], m_pbase->srcend );
+            entry.unk1  = srcentry.unk1;
+            entry.unk5  = srcentry.unk5;
+            entry.unk58 = srcentry.unk58;
+            entry.unk6  = srcentry.unk6;
+            entry.unk7  = srcentry.unk7;
+            entry.unk10 = srcentry.unk10;
+            entry.unk11 = srcentry.unk11;
+            entry.unk13 = srcentry.unk13;
+            entry.unk19 = srcentry.unk19;
+            entry.unk20 = srcentry.unk20;
+            entry.unk21 = srcentry.unk21;
+            entry.unk22 = srcentry.unk22;
+            entry.unk57 = srcentry.unk57;
+        }
+
+        /*
+            Same as above, but for a modified program. The splits are matched by their index in the split table.
+        */
+        void KeepUnknownPrgiFields( ProgramInfo_v415 & entry, size_t slot )const
+        {
+            if( m_pbase == nullptr || slot >= m_pbase->prgientries.size() || m_pbase->prgientries[slot].first == nullptr )
+                return;
+
+            ProgramInfo_v415 srcentry;
+            srcentry.ReadFromContainer( m_pbase->prgientries[slot].first, m_pbase->prgientries[slot].second );
+            entry.m_hdr.unk3 = srcentry.m_hdr.unk3;
+            entry.m_hdr.unk5 = srcentry.m_hdr.unk5;
+            entry.m_hdr.unk7 = srcentry.m_hdr.unk7;
+            entry.m_hdr.unk8 = srcentry.m_hdr.unk8;
+            entry.m_hdr.unk9 = srcentry.m_hdr.unk9;
+
+            const size_t nbsplits = std::min( entry.m_splitstbl.size(), srcentry.m_splitstbl.size() );
+            for( size_t i = 0; i < nbsplits; ++i )
+            {
+                SplitEntry_v415       & split    = entry.m_splitstbl[i];
+                const SplitEntry_v415 & srcsplit = srcentry.m_splitstbl[i];
+                split.unk16 = srcsplit.unk16;
+                split.unk17 = srcsplit.unk17;
+                split.unk22 = srcsplit.unk22;
+                split.unk23 = srcsplit.unk23;
+                split.unk24 = srcsplit.unk24;
+                split.unk37 = srcsplit.unk37;
+                split.unk38 = srcsplit.unk38;
+                split.unk39 = srcsplit.unk39;
+                split.unk40 = srcsplit.unk40;
+                split.rx    = srcsplit.rx;
+            }
         }
 
         void WriteKgrp( writeit_t & itout )
@@ -2680,12 +3005,12 @@ namespace DSE
             for( const auto & akgrp : kgrplist )
                 akgrp.WriteToContainer(itout);
 
-            uint32_t chunklen = static_cast<uint32_t>(m_tgtcn.tellp());
+            uint32_t chunklen = static_cast<uint32_t>(m_tgtcn.tellp() - befhdr) - ChunkHeader::Size;
 
             //Add padding
             int padlen =  (m_tgtcn.tellp() % 16);
             if( padlen != 0 )
-                std::fill_n( itout, padlen, m_padbyte );
+                std::fill_n( itout, 16 - padlen, m_padbyte );
 
             //Write header
             streampos aftkgrps = m_tgtcn.tellp();
@@ -2735,6 +3060,7 @@ namespace DSE
         const uint16_t          m_pcmdflag;
         const uint8_t           m_padbyte;
         eDSEVersion             m_version;
+        const SWDL_IncrementalBase * m_pbase;   //Source file to reuse data from, when doing an incremental write
     };
 
 //========================================================================================================
@@ -2757,8 +3083,14 @@ namespace DSE
         return std::move( SWDLParser<>( itbeg, itend ).Parse() );
     }
 
-    SWDL_HeaderData ReadSwdlHeader( std::vector<uint8_t>::const_iterator itbeg, 
-                                    std::vector<uint8_t>::const_iterator itend )
+    PresetBank ParseSWDL( const uint8_t * itbeg, 
+                          const uint8_t * itend )
+    {
+        return SWDLParser<const uint8_t*>( itbeg, itend ).Parse();
+    }
+
+    template<class _init>
+        SWDL_HeaderData ReadSwdlHeader( _init itbeg, _init itend )
     {
         SWDL_HeaderData hdrdata;
         auto            itbefread = itbeg;
@@ -2790,49 +3122,80 @@ namespace DSE
         return move(hdrdata);
     }
 
-    SWDL_HeaderData ReadSwdlHeader( const std::string & filename )
+    SWDL_HeaderData ReadSwdlHeader( std::vector<uint8_t>::const_iterator itbeg, 
+                                    std::vector<uint8_t>::const_iterator itend )
     {
-        SWDL_HeaderData           hdrdata;
-        ifstream                  infile( filename, ios::in | ios::binary );
-        istreambuf_iterator<char> init(infile);
-        istreambuf_iterator<char> end;
-        uint32_t                  magicn = utils::ReadIntFromBytes<uint32_t>( init, end, false );
+        return ReadSwdlHeader<std::vector<uint8_t>::const_iterator>( itbeg, itend );
+    }
 
-        if( magicn == static_cast<uint32_t>(eDSEContainers::swdl) )
-        {
-            std::advance( init, sizeof(uint32_t) * 2 ); //Skip to the version
-            uint16_t vers   = utils::ReadIntFromBytes<uint16_t>(init, end);
-            infile.seekg(0);
+    SWDL_HeaderData ReadSwdlHeader( const std::string & filename )
+    {
+        //Only the header is paged in
+        utils::io::MappedFile infile(filename);
+        return ReadSwdlHeader<const uint8_t*>( infile.begin(), infile.end() );
+    }
 
-            if( vers == static_cast<uint16_t>(eDSEVersion::V402) )
-            {
-                SWDL_Header_v402 hdr;
-                init = hdr.ReadFromContainer( init, end );
-                hdrdata = hdr;
-            }
-            else if( vers == static_cast<uint16_t>(eDSEVersion::V415) )
-            {
-                SWDL_Header_v415 hdr;
-                init = hdr.ReadFromContainer( init, end );
-                hdrdata = hdr;
-            }
-            else
-                throw std::runtime_error("ReadSwdlHeader() : Unknown DSE version!");
-        }
-        else
-            throw std::runtime_error("ReadSwdlHeader() : Not a SWDL file!");
+    /*
+        Runs the writer on a buffer sized by its sizing pass, so nothing gets reallocated and the seeks
+        stay in memory, then writes the whole file with a single call.
+    */
+    template<class... _ArgsTy>
+        static void WriteSWDLBuffered( const std::string & filename, const PresetBank & audiodata, _ArgsTy &&... args )
+    {
+        std::ostringstream        membuf( std::ios::out | std::ios::binary );
+        SWDL_Writer<std::ostream> writer( membuf, audiodata, std::forward<_ArgsTy>(args)... );
+        std::string               buf;
+        buf.reserve( writer.CalcMaxFileLength() );
+        membuf.str( std::move(buf) );
+        writer();
+
+        //The output may be inside a mounted ROM image
+        const std::string_view filedata = membuf.view();
+        if( utils::io::WriteToVirtualFS( filename, reinterpret_cast<const uint8_t*>(filedata.data()), filedata.size() ) )
+            return;
 
-        return move(hdrdata);
+        std::ofstream outf(filename, std::ios::out | std::ios::binary );
+        if( !outf.is_open() || outf.bad() )
+            throw std::runtime_error( "WriteSWDL(): Couldn't open output file " + filename );
+        outf.write( filedata.data(), filedata.size() );
+        if( outf.bad() )
+            throw std::runtime_error( "WriteSWDL(): Couldn't write to output file " + filename );
     }
 
     void WriteSWDL( const std::string & filename, const PresetBank & audiodata )
     {
-        std::ofstream outf(filename, std::ios::out | std::ios::binary );
+        WriteSWDLBuffered( filename, audiodata );
+    }
 
-        if( !outf.is_open() || outf.bad() )
-            throw std::runtime_error( "WriteSMDL(): Couldn't open output file " + filename );
+    void WriteSWDLIncremental( const std::string & filename, const PresetBank & audiodata, const std::string & basefile )
+    {
+        //Files in a mounted ROM image are only replaced when it's committed, so they can be written directly
+        std::string relpath;
+        if( utils::io::FindVirtualFS( filename, relpath ) )
+        {
+            utils::io::MappedFile srcfile(basefile);
+            SWDL_IncrementalBase  base( srcfile.begin(), srcfile.end() );
+            WriteSWDLBuffered( filename, audiodata, base );
+            return;
+        }
 
-        SWDL_Writer<std::ofstream>(outf, audiodata)();
+        //Write to a temporary file next to the target first, since the base file is likely the one being replaced.
+        // Then rename it over the target, so the target is never left half written or missing.
+        const std::string tmpfname = filename + ".tmp";
+        try
+        {
+            {
+                utils::io::MappedFile srcfile(basefile);
+                SWDL_IncrementalBase  base( srcfile.begin(), srcfile.end() );
+                WriteSWDLBuffered( tmpfname, audiodata, base );
+            }
+            utils::ReplaceFile( tmpfname, filename );
+        }
+        catch(...)
+        {
+            std::remove( tmpfname.c_str() );
+            std::throw_with_nested( std::runtime_error( "WriteSWDLIncremental(): Couldn't replace " + filename + " !" ) );
+        }
     }
 
 };
@@ -2897,6 +3260,11 @@ namespace DSE
                 return (utils::ReadIntFromBytes<uint32_t>(itdatabeg, itdataend, false) == DSE::SWDL_MagicNumber);
             }
 
+            virtual std::vector<uint32_t> getMagicNumbers()const
+            {
+                return { DSE::SWDL_MagicNumber };
+            }
+
         private:
             cntRID_t m_myID;
         };
@@ -30,6 +30,7 @@ namespace filetypes
 
     std::vector<uint8_t> WAN_Writer::write( std::atomic<uint32_t> * pProgress )
     {
+        utils::TraceScope trace("wan write");
         //Don't forget to build the SIR0 pointer offset table !
         // We must gather the offset of ALL pointers!
         m_pProgress = pProgress;
@@ -37,6 +38,12 @@ namespace filetypes
         //Fill Structures
         FillFileInfoStructures(); //Fill up the structs
 
+        //Sizing pass for the image data
+        if( m_pSprite->getSpriteType() == eSpriteImgType::spr4bpp )
+            EncodeFrames( *(m_pSprite->getFramesAs4bpp()) );
+        else if( m_pSprite->getSpriteType() == eSpriteImgType::spr8bpp )
+            EncodeFrames( *(m_pSprite->getFramesAs8bpp()) );
+
         //Allocate
         AllocateAndEstimateResultLength();
 
@@ -48,10 +55,8 @@ namespace filetypes
         WriteAnimationSequencesBlock();
         WritePaddingBytes(4); //Some 4 bytes padding is needed here
 
-        if( m_pSprite->getSpriteType() == eSpriteImgType::spr4bpp )
-            WriteFramesBlock( *(m_pSprite->getFramesAs4bpp()) );
-        else if( m_pSprite->getSpriteType() == eSpriteImgType::spr8bpp )
-            WriteFramesBlock( *(m_pSprite->getFramesAs8bpp()) );
+        WriteFramesBlock();
+        m_encodedFrms.clear();
 
         WritePaletteBlock();
         WriteMetaFrameGroupPtrTable();
@@ -141,13 +146,14 @@ namespace filetypes
         totalSize += m_pSprite->getMetaFrames().size() * WAN_LENGTH_META_FRM;
 
         //Animframes are 12 bytes each. Each sequences adds an extra 12 for the null ending frame.
-        totalSize += nbAnimFrms + (nbAnimSequences * WAN_LENGTH_ANIM_FRM);
+        totalSize += (nbAnimFrms + nbAnimSequences) * WAN_LENGTH_ANIM_FRM;
 
         // if the value isn't divisible by 4 without leftovers add 2 bytes for padding!
         totalSize = CalcClosestHighestDenominator( totalSize, 4 );
 
-        //Add worst case scenario size for each images, which is a 2 entry zero-strip table( 24 bytes ), with all bytes of the image above the table.
-        totalSize += ( m_pSprite->getNbFrames() * ( 24 + (64*64) ) ); //This is the worst case possible!
+        //The images were already encoded, so their exact length is known
+        for( const auto & afrm : m_encodedFrms )
+            totalSize += afrm.size();
 
         //Palette is nbcolors * 4 bytes + 16 bytes for the palette info!
         totalSize += ( m_pSprite->getPalette().size() * 4 ) + 16;
@@ -321,74 +327,6 @@ namespace filetypes
         }
     }
 
-    /**************************************************************
-        This insert the next sequence into the zero strip table.
-        If its a sequence of zero, it won't write into the pixel
-        strip table. If it is, it will.
-    **************************************************************/
-    WAN_Writer::ImgAsmTbl_WithOpTy WAN_Writer::MakeImgAsmTableEntry( std::vector<uint8_t>::const_iterator & itReadAt,
-                                                        std::vector<uint8_t>::const_iterator   itEnd,
-                                                        std::vector<uint8_t>                 & pixStrips,
-                                                        uint32_t                             & totalbytecnt,
-                                                        uint32_t                               imgZIndex )
-    {
-        static const unsigned int MIN_Increments = 0x20; //Minimum increments of 32 bytes
-        auto lambdaIsZero    =  []( uint8_t val )->bool{ return (val == 0); };
-        auto itReadAtBefore  = itReadAt; //This is to hold the last read position for the duration of this function
-        auto itCurPos        = itReadAt; //This is to iterate over the data, without modifying itReadAt just yet!
-        std::advance( itCurPos, MIN_Increments );
-
-        //See if we're dealing with a sequence of zeroes or not!
-        bool isZeroSeq = std::all_of( itReadAtBefore, itCurPos, lambdaIsZero );
-
-        //This is to indicate where the last sequence of 16 bytes we analyzed began at!
-        auto itLastSeqBeg = itCurPos;
-        uint32_t countAmtBytes = MIN_Increments;    //we already got 16 bytes in our sequence
-
-        //Try to get other blocks of the same kind !
-        while( itCurPos != itEnd )
-        {
-            std::advance( itCurPos, MIN_Increments ); //This will throw an exception if the pixel count isn't divisible by our ammount of increment #FIXME : No it won't past me
-
-            //Check if the newly added bytes are the same kind of bytes we're looking for!
-            if( isZeroSeq == std::all_of( itLastSeqBeg, itCurPos, lambdaIsZero ) )
-            {
-                countAmtBytes += MIN_Increments;
-                itLastSeqBeg = itCurPos;
-            }
-            else
-            {
-                break;
-            }
-        }
-        ImgAsmTbl_WithOpTy myentry;
-        myentry.pixelsrc    = ( (isZeroSeq)? 0 : pixStrips.size() );
-        myentry.isZeroEntry = isZeroSeq;
-        myentry.pixamt      = countAmtBytes;
-        myentry.zIndex      = imgZIndex; //#TODO: figure out what this thing does !
-
-        if( !isZeroSeq )
-            std::copy( itReadAtBefore, itLastSeqBeg, std::back_inserter(pixStrips) );
-
-        //auto dist = std::distance( itReadAtBefore, itLastSeqBeg );
-
-        //Get only the actual sequence's data we're sure of between itReadAtBefore and itLastSeqBeg
-
-
-        totalbytecnt += myentry.pixamt;
-
-        //Increment the iterator now!
-        itReadAt = itLastSeqBeg;
-
-        return std::move( myentry );
-
-        //1. Read 16 bytes
-        //2. If we got 16 zeroes, we're reading a zero sequence to strip!!! Try to read as much groups of 16 zeroes as possible
-        //3. If we don't have 16 zeroes, this is a pixel strip!! Try to read another block of 16 bytes, and make sure its not 16 zeroes!
-        // Once we can't read any of our resprective sequence type, return entry!
-    }
-
-
     /**************************************************************
     **************************************************************/
     WAN_Writer::ImgAsmTbl_WithOpTy WAN_Writer::MakeImgAsmTableEntryNoStripping( vector<uint8_t>::const_iterator & itReadAt,
@@ -412,35 +350,67 @@ namespace filetypes
 
     /**************************************************************
     **************************************************************/
-    void WAN_Writer::WriteACompressedFrm( const std::vector<uint8_t> & frm, uint32_t imgZIndex, bool dontStripZeros )
+    void WAN_Writer::EncodeAFrame( const std::vector<uint8_t> & frm, uint32_t imgZIndex, vector<pmd2::compression::zero_strip_run> & runs, encoded_frame & out_frm, bool dontStripZeros )
     {
-        uint32_t imgbegoffset = m_outBuffer.size(); //Keep the offset before to offset the entries in the assembly table !
-
-        vector<uint8_t>                 pixelstrips;
-        vector<ImgAsmTbl_WithOpTy>      asmtable;
-        auto                            itLaststrip  = frm.begin();
-        uint32_t                        totalbytecnt = 0;
+        vector<uint8_t>            & pixelstrips  = out_frm.pixelstrips;
+        vector<ImgAsmTbl_WithOpTy> & asmtable     = out_frm.asmtable;
+        uint32_t                     totalbytecnt = 0;
+        pixelstrips.resize(0);
+        asmtable.resize(0);
 
         //Encode image
-        auto itCurPos = frm.begin();
-        auto itEnd    = frm.end();
-
-        while( itCurPos != itEnd )
+        if( dontStripZeros )
         {
-            if( dontStripZeros )
+            auto itCurPos = frm.begin();
+            auto itEnd    = frm.end();
+            while( itCurPos != itEnd )
                 asmtable.push_back( MakeImgAsmTableEntryNoStripping(itCurPos,itEnd,pixelstrips, totalbytecnt, imgZIndex ) );
-            else
-                asmtable.push_back( MakeImgAsmTableEntry( itCurPos, itEnd, pixelstrips, totalbytecnt, imgZIndex ) );
         }
+        else
+        {
+            runs.resize(0);
+            pixelstrips.reserve( frm.size() );
+            pmd2::compression::FindZeroStripRuns( frm.data(), frm.data() + frm.size(), runs );
+
+            for( const auto & run : runs )
+            {
+                ImgAsmTbl_WithOpTy myentry;
+                myentry.isZeroEntry = run.iszero;
+                myentry.pixelsrc    = ( (run.iszero)? 0 : pixelstrips.size() );
+                myentry.pixamt      = run.length;
+                myentry.zIndex      = imgZIndex; //#TODO: figure out what this thing does !
+
+                if( !run.iszero )
+                    pixelstrips.insert( pixelstrips.end(), frm.begin() + run.offset, frm.begin() + run.offset + run.length );
+
+                totalbytecnt += run.length;
+                asmtable.push_back(myentry);
+            }
+        }
+    }
+
+    /**************************************************************
+    **************************************************************/
+    void WAN_Writer::WriteFramesBlock()
+    {
+        for( const auto & afrm : m_encodedFrms )
+            WriteACompressedFrm( afrm );
+    }
+
+    /**************************************************************
+    **************************************************************/
+    void WAN_Writer::WriteACompressedFrm( const encoded_frame & frm )
+    {
+        uint32_t imgbegoffset = m_outBuffer.size(); //Keep the offset before to offset the entries in the assembly table !
 
         //Write pixel strips
-        std::copy( pixelstrips.begin(), pixelstrips.end(), m_itbackins );
+        std::copy( frm.pixelstrips.begin(), frm.pixelstrips.end(), m_itbackins );
 
         //Save the offset of the upcoming assembly table
         m_CompImagesTblOffsets.push_back( m_outBuffer.size() );
 
         //Write table
-        for( auto & entry : asmtable )
+        for( ImgAsmTbl_WithOpTy entry : frm.asmtable )
         {
             //Offset the pointers correctly + Register ptr if non-zero
             if( !entry.isZeroEntry )
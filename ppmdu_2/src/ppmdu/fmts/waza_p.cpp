@@ -49,8 +49,10 @@ namespace pmd2 { namespace filetypes
     {
     public:
         WazaParser( const vector<uint8_t> & data )
-            :m_rawdata(data)
-        {}
+            :m_rawdata(data), m_sir0(data)
+        {
+            ParseWazaPtrs();
+        }
 
         std::pair<MoveDB, std::vector<stats::PokeMoveSet>> Parse()
         {
@@ -60,14 +62,6 @@ namespace pmd2 { namespace filetypes
         MoveDB ParseMoves()
         {
             MoveDB db;
-
-            //Read header if neccessary
-            if( !wasHeaderParsed() )
-            {
-                ParseHeader();
-                ParseWazaPtrs();
-            }
-
             auto itRead = (m_rawdata.begin() + m_wazaptrs.ptrMovesData);
             auto itEnd  = (m_rawdata.begin() + m_wazaptrs.ptrPLSTbl);
 
@@ -96,14 +90,6 @@ namespace pmd2 { namespace filetypes
         vector<stats::PokeMoveSet> ParseLearnset()
         {
             vector<stats::PokeMoveSet> ls;
-
-            //Read header if neccessary
-            if( !wasHeaderParsed() )
-            {
-                ParseHeader();
-                ParseWazaPtrs();
-            }
-
             auto itEnd  = (m_rawdata.begin() + m_wazaptrs.ptrPLSTbl);
             auto ptrtbl = ParsePtrTable();
             ls.resize( ptrtbl.size() );
@@ -128,14 +114,13 @@ namespace pmd2 { namespace filetypes
         */
         typedef array<uint32_t,3> pkmnPtrs;
 
-        void ParseHeader()
-        {
-            m_header.ReadFromContainer( m_rawdata.begin(), m_rawdata.end() );
-        }
-
         void ParseWazaPtrs()
         {
-            m_wazaptrs.ReadFromContainer( (m_rawdata.begin() + m_header.subheaderptr), m_rawdata.end() );
+            m_wazaptrs.ptrMovesData = m_sir0.ReadPointer( m_sir0.SubHeaderOffset() );
+            m_wazaptrs.ptrPLSTbl    = m_sir0.ReadPointer( m_sir0.SubHeaderOffset() + sizeof(uint32_t) );
+
+            if( m_wazaptrs.ptrMovesData > m_wazaptrs.ptrPLSTbl || m_wazaptrs.ptrPLSTbl > m_sir0.SubHeaderOffset() )
+                throw std::runtime_error("WazaParser::ParseWazaPtrs(): The moves data and learnset pointer table aren't in the expected order!");
         }
 
         vector<pkmnPtrs> ParsePtrTable()
@@ -144,30 +129,26 @@ namespace pmd2 { namespace filetypes
             static const uint32_t PaddedPointer    = 0xAAAAAAAA;
 
             vector<pkmnPtrs>      pointers; 
-            auto                  itRead        = (m_rawdata.begin() + ( m_wazaptrs.ptrPLSTbl + SkipEmptyEntries ) );
-            auto                  itEnd         = (m_rawdata.begin() + m_header.subheaderptr);
+            size_t                offRead       = m_wazaptrs.ptrPLSTbl + SkipEmptyEntries;
+            const size_t          offEnd        = m_sir0.SubHeaderOffset();
             bool                  bHitPadding   = false;
 
-            //std::count_if( itRead, itEnd, [](  ){  } );
             pointers.push_back(pkmnPtrs()); //Push the null first entry
 
-            while( itRead != itEnd )
+            while( offRead + sizeof(pkmnPtrs) <= offEnd )
             {
                 pkmnPtrs ptrsonepoke;
                 //Read a Poke's 3 pointers
-                for( unsigned int cntptr = 0; cntptr < 3; ++cntptr )
+                for( unsigned int cntptr = 0; cntptr < 3; ++cntptr, offRead += sizeof(uint32_t) )
                 {
-                    uint32_t curptr = utils::ReadIntFromBytes<uint32_t>(itRead, m_rawdata.end());
-
                     //Break if we hit padding bytes
-                    if( curptr == PaddedPointer )
+                    if( utils::Load<uint32_t>( m_sir0.Data() + offRead ) == PaddedPointer )
                     {
                         bHitPadding = true;
-                        itRead = itEnd; //Stop the loop here
                         break;
                     }
                     else
-                        ptrsonepoke[cntptr] = curptr;
+                        ptrsonepoke[cntptr] = m_sir0.ReadPointer(offRead);
                 }
 
                 //If we hit padding before the end, quit.
@@ -313,11 +294,9 @@ namespace pmd2 { namespace filetypes
             out_val = utils::ReadIntFromBytes<T>(itRead, m_rawdata.end());
         }
 
-        inline bool wasHeaderParsed()const { return (m_header.magic != 0); }
-
     private:
         const vector<uint8_t>           & m_rawdata;
-        sir0_header                       m_header;
+        SIR0View                          m_sir0;
         WazaPtrs                          m_wazaptrs;
     };
 
@@ -69,6 +69,12 @@ namespace filetypes
             return false;
         }
 
+        //The WTE sub-header
+        virtual std::vector<uint32_t> getMagicNumbers()const
+        {
+            return { WTE_MAGIC_NUMBER_INT };
+        }
+
     private:
         cntRID_t m_myID;
     };
@@ -56,6 +56,11 @@ namespace filetypes
             return myhead.magic == WTU_MAGIC_NUMBER_INT;
         }
 
+        virtual std::vector<uint32_t> getMagicNumbers()const
+        {
+            return { WTU_MAGIC_NUMBER_INT };
+        }
+
     private:
         cntRID_t m_myID;
     };
@@ -467,29 +467,29 @@ namespace pmd2
 //--------------------------------------------------------------
 //  Export/Import
 //--------------------------------------------------------------
-    void GameStats::ExportPkmn( const std::string & directory )
+    void GameStats::ExportPkmn( const std::string & directory, bool bparallel )
     {
         //cout<<"-- Exporting all Pokemon data to XML data --\n";
         if( !CheckStringsLoaded() || m_pokemonStats.empty() )
             throw runtime_error("ERROR: Tried to export an empty list of Pokemon ! Or with an empty string list!");
 
         cout<<" <*>- Writing Pokemon XML data..";
-        stats::ExportPokemonsToXML( m_pokemonStats, m_gameStrings.get(), directory );
+        stats::ExportPokemonsToXML( m_pokemonStats, m_gameStrings.get(), directory, bparallel );
         cout<<" Done!\n";
     }
 
-    void GameStats::ImportPkmn( const std::string & directory )
+    void GameStats::ImportPkmn( const std::string & directory, bool bparallel )
     {
         //cout<<"-- Importing all Pokemon from XML data --\n";
         //Need game strings loaded for this !
         _EnsureStringsLoaded();
 
         cout<<" <*>- Parsing Pokemon XML data..";
-        stats::ImportPokemonsFromXML( directory, m_pokemonStats, m_gameStrings.get() );
+        stats::ImportPokemonsFromXML( directory, m_pokemonStats, m_gameStrings.get(), bparallel );
         cout<<" Done!\n";
     }
 
-    void GameStats::ExportMoves( const std::string & directory )
+    void GameStats::ExportMoves( const std::string & directory, bool bparallel )
     {
         //cout<<"-- Exporting all moves data to XML data --\n";
         if( !CheckStringsLoaded() || m_moveData1.empty() )
@@ -497,13 +497,13 @@ namespace pmd2
 
         cout << " <*>- Writing moves to XML data.. ";
         if( m_gameVersion == eGameVersion::EoS )
-            stats::ExportMovesToXML( m_moveData1, &m_moveData2, m_gameStrings.get(), directory );
+            stats::ExportMovesToXML( m_moveData1, &m_moveData2, m_gameStrings.get(), directory, bparallel );
         else if( m_gameVersion == eGameVersion::EoT || m_gameVersion == eGameVersion::EoD )
-            stats::ExportMovesToXML( m_moveData1, nullptr, m_gameStrings.get(), directory );
+            stats::ExportMovesToXML( m_moveData1, nullptr, m_gameStrings.get(), directory, bparallel );
         cout << " Done!\n";
     }
 
-    void GameStats::ImportMoves( const std::string & directory )
+    void GameStats::ImportMoves( const std::string & directory, bool bparallel )
     {
         //cout<<"-- Importing all moves data from XML data --\n";
         //Need game strings loaded for this !
@@ -513,9 +513,9 @@ namespace pmd2
         if( m_gameVersion == eGameVersion::Invalid )
             throw runtime_error("Game version is invalid, or was not determined. Cannot import move data and format it!");
         else if( m_gameVersion == eGameVersion::EoS )
-            stats::ImportMovesFromXML( directory, m_moveData1, &m_moveData2, m_gameStrings.get() );
+            stats::ImportMovesFromXML( directory, m_moveData1, &m_moveData2, m_gameStrings.get(), bparallel );
         else if( m_gameVersion == eGameVersion::EoT || m_gameVersion == eGameVersion::EoD )
-            stats::ImportMovesFromXML( directory, m_moveData1, nullptr, m_gameStrings.get() );
+            stats::ImportMovesFromXML( directory, m_moveData1, nullptr, m_gameStrings.get(), bparallel );
         cout<<" Done!\n";
     }
 
@@ -538,17 +538,17 @@ namespace pmd2
         cout<<"Done importing strings!\n";
     }
 
-    void GameStats::ExportItems( const std::string & directory )
+    void GameStats::ExportItems( const std::string & directory, bool bparallel )
     {
         if( !CheckStringsLoaded() ||  m_itemsData.empty() )
             throw runtime_error( "No item data to export, or the strings weren't loaded!!" );
 
         cout<<" <*>- Exporting items to XML..";
-        stats::ExportItemsToXML( m_itemsData, m_gameStrings.get(), directory );
+        stats::ExportItemsToXML( m_itemsData, m_gameStrings.get(), directory, bparallel );
         cout << " Done!\n";
     }
 
-    void GameStats::ImportItems( const std::string & directory )
+    void GameStats::ImportItems( const std::string & directory, bool bparallel )
     {
         //Need game strings loaded for this !
         _EnsureStringsLoaded();
@@ -557,11 +557,11 @@ namespace pmd2
             throw runtime_error("Game version is invalid, or was not determined. Cannot import item data and format it!");
 
         cout<<" <*>- Parsing items XML data..";
-        m_itemsData = std::move( stats::ImportItemsFromXML( directory, m_gameStrings.get() ) );
+        m_itemsData = std::move( stats::ImportItemsFromXML( directory, m_gameStrings.get(), bparallel ) );
         cout<<" Done!\n";
     }
 
-    void GameStats::ExportAll( const std::string & directory )
+    void GameStats::ExportAll( const std::string & directory, bool bparallel )
     {
         cout<<"-- Exporting everything to XML --\n";
         const string pkmndir = Poco::Path(directory).makeAbsolute().append(DefPkmnDir ).makeDirectory().toString();
@@ -578,7 +578,7 @@ namespace pmd2
             utils::DoCreateDirectory(pkmndir);
 
             cout<<" <*>- Has Pokemon data to export. Exporting to \"" <<pkmndir <<"\"..\n  ";
-            ExportPkmn( pkmndir );
+            ExportPkmn( pkmndir, bparallel );
         }
         else
             cout<<" <!>- No item Pokemon data to export, skipping..\n";
@@ -588,7 +588,7 @@ namespace pmd2
             utils::DoCreateDirectory(mvdir);
 
             cout<<" <*>- Has moves data to export. Exporting to \"" <<mvdir <<"\"..\n  ";
-            ExportMoves( mvdir );
+            ExportMoves( mvdir, bparallel );
         }
         else
             cout<<" <!>- No move data to export, skipping..\n";
@@ -598,7 +598,7 @@ namespace pmd2
             utils::DoCreateDirectory(itemdir);
 
             cout<<" <*>- Has items data to export. Exporting to \"" <<itemdir <<"\"..\n  ";
-            ExportItems( itemdir );
+            ExportItems( itemdir, bparallel );
         }
         else
             cout<<" <!>- No item data to export, skipping..\n";
@@ -606,7 +606,7 @@ namespace pmd2
         cout<<"-- Export complete! --\n";
     }
 
-    void GameStats::ImportAll( const std::string & directory )
+    void GameStats::ImportAll( const std::string & directory, bool bparallel )
     {
         using namespace utils;
         cout<<"-- Importing everything from XML --\n";
@@ -643,11 +643,11 @@ namespace pmd2
 
         //Run all the import methods
         if(importPokes)
-            ImportPkmn(pkmndir);
+            ImportPkmn(pkmndir, bparallel);
         if(importMoves)
-            ImportMoves(mvdir);
+            ImportMoves(mvdir, bparallel);
         if(importItems)
-            ImportItems(itemdir);
+            ImportItems(itemdir, bparallel);
 
         cout<<"-- Import complete! --\n";
     }
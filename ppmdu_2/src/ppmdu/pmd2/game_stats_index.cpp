@@ -0,0 +1,416 @@
+#include <ppmdu/pmd2/game_stats_index.hpp>
+#include <ppmdu/pmd2/game_stats.hpp>
+#include <utils/gstringutils.hpp>
+#include <utils/utility.hpp>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <algorithm>
+using namespace std;
+using namespace pmd2::stats;
+
+namespace pmd2
+{
+//==================================================================================
+//  Constants
+//==================================================================================
+    const string StatsIndex_PkmnCSV     = "pokemon.csv";
+    const string StatsIndex_LearnsetCSV = "learnsets.csv";
+    const string StatsIndex_MovesCSV    = "moves.csv";
+    const string StatsIndex_ItemsCSV    = "items.csv";
+
+    static const uint32_t StatsIndex_NoKey = 0xFFFFFFFF; //Returned by key functions when a row has no key in a slot
+
+//==================================================================================
+//  Utility
+//==================================================================================
+    /*
+        Returns the string in the block for the default language, without its ending "\0", or an empty string.
+    */
+    inline string GetCleanString( const GameText * pstrings, eStringBlocks blk, size_t index )
+    {
+        if( !pstrings || !pstrings->AreStringsLoaded() )
+            return string();
+        const string * pstr = pstrings->GetDefaultLanguage().GetStringIfBlockExists( blk, index );
+        return (pstr)? utils::StrRemoveAfter( *pstr, "\\0" ) : string();
+    }
+
+    /*
+        CSV helpers
+    */
+    inline void WriteCSVField( ostream & out, const string & str )
+    {
+        if( str.find_first_of(",\"\n\r") == string::npos )
+        {
+            out << str;
+            return;
+        }
+        out << '"';
+        for( char c : str )
+        {
+            if( c == '"' )
+                out << '"';
+            out << c;
+        }
+        out << '"';
+    }
+
+    template<class T>
+        inline void WriteCSVField( ostream & out, T value )
+    {
+        //Promote bytes, so they're not written as characters
+        out << +value;
+    }
+
+    inline void WriteCSVField( ostream & out, eLearnMethod method )
+    {
+        switch(method)
+        {
+            case eLearnMethod::LevelUp: { out <<"levelup"; break; }
+            case eLearnMethod::HmTm:    { out <<"hmtm";    break; }
+            case eLearnMethod::Egg:     { out <<"egg";     break; }
+        };
+    }
+
+    /*
+        Writes a csv line with the fields of the row of every column passed.
+    */
+    inline void WriteCSVRow( ostream &, size_t ) {}
+
+    template<class _ColT, class ... _Rest>
+        inline void WriteCSVRow( ostream & out, size_t row, const _ColT & col, const _Rest & ... rest )
+    {
+        WriteCSVField( out, col[row] );
+        if( sizeof...(rest) != 0 )
+            out << ',';
+        WriteCSVRow( out, row, rest... );
+    }
+
+    inline ofstream OpenCSV( const string & destdir, const string & fname, const char * header )
+    {
+        const string fpath = utils::TryAppendSlash(destdir) + fname;
+        ofstream     out( fpath );
+        if( !out )
+            throw runtime_error( "GameStatsIndex::WriteCSV(): Couldn't open file \"" + fpath + "\" for writing!" );
+        out.exceptions( ios::badbit );
+        out << header << "\n";
+        return out;
+    }
+
+//==================================================================================
+//  GameStatsIndex::inverted_index
+//==================================================================================
+    GameStatsIndex::rowrange_t GameStatsIndex::inverted_index::Find( uint32_t key )const
+    {
+        if( static_cast<size_t>(key) + 1 >= offsets.size() )
+            return make_pair( rows.end(), rows.end() );
+        return make_pair( rows.begin() + offsets[key], rows.begin() + offsets[key + 1] );
+    }
+
+    /*
+        Builds the index in two passes, by first counting the rows for each keys, and then placing them.
+        Rows are placed in ascending order for each key.
+            - getkey : uint32_t(size_t row, size_t slot). Returns StatsIndex_NoKey if there's nothing in the slot.
+    */
+    template<class _KeyFun>
+        GameStatsIndex::inverted_index GameStatsIndex::BuildInvertedIndex( size_t nbrows, size_t nbkeysperrow, _KeyFun && getkey )
+    {
+        inverted_index result;
+        uint32_t       maxkey = 0;
+        bool           haskey = false;
+
+        for( size_t row = 0; row < nbrows; ++row )
+        {
+            for( size_t slot = 0; slot < nbkeysperrow; ++slot )
+            {
+                uint32_t key = getkey(row, slot);
+                if( key == StatsIndex_NoKey )
+                    continue;
+                maxkey = std::max( maxkey, key );
+                haskey = true;
+            }
+        }
+        if( !haskey )
+            return result;
+
+        result.offsets.resize( static_cast<size_t>(maxkey) + 2, 0 );
+        for( size_t row = 0; row < nbrows; ++row )
+        {
+            for( size_t slot = 0; slot < nbkeysperrow; ++slot )
+            {
+                uint32_t key = getkey(row, slot);
+                if( key != StatsIndex_NoKey )
+                    ++result.offsets[key + 1];
+            }
+        }
+
+        for( size_t i = 1; i < result.offsets.size(); ++i )
+            result.offsets[i] += result.offsets[i - 1];
+
+        result.rows.resize( result.offsets.back() );
+        vector<uint32_t> inspos( result.offsets.begin(), result.offsets.end() - 1 );
+        for( size_t row = 0; row < nbrows; ++row )
+        {
+            for( size_t slot = 0; slot < nbkeysperrow; ++slot )
+            {
+                uint32_t key = getkey(row, slot);
+                if( key != StatsIndex_NoKey )
+                    result.rows[inspos[key]++] = static_cast<uint32_t>(row);
+            }
+        }
+        return result;
+    }
+
+//==================================================================================
+//  GameStatsIndex
+//==================================================================================
+    GameStatsIndex::GameStatsIndex( const GameStats & src )
+    {
+        IndexPokemon(src);
+        IndexMoves  (src);
+        IndexItems  (src);
+    }
+
+    void GameStatsIndex::IndexPokemon( const GameStats & src )
+    {
+        const PokemonDB & pkdb     = src.Pkmn();
+        const GameText  * pstrings = src.Strings();
+        const size_t      nbpkmn   = pkdb.size();
+
+        for( size_t i = 0; i < nbpkmn; ++i )
+        {
+            const CPokemon        & pk = pkdb[static_cast<uint16_t>(i)];
+            const PokeMonsterData & md = pk.MonsterDataGender1();
+
+            m_pkmn.name        .push_back( GetCleanString( pstrings, eStringBlocks::PkmnNames, i ) );
+            m_pkmn.dexNb       .push_back( md.natPkdexNb );
+            m_pkmn.primaryTy   .push_back( md.primaryTy );
+            m_pkmn.secondaryTy .push_back( md.secondaryTy );
+            m_pkmn.primAbility .push_back( md.primAbility );
+            m_pkmn.secAbility  .push_back( md.secAbility );
+            m_pkmn.IQGrp       .push_back( md.IQGrp );
+            m_pkmn.moveTy      .push_back( md.moveTy );
+            m_pkmn.bodySize    .push_back( md.bodySize );
+            m_pkmn.expYield    .push_back( md.expYield );
+            m_pkmn.recruitRate1.push_back( md.recruitRate1 );
+            m_pkmn.recruitRate2.push_back( md.recruitRate2 );
+            m_pkmn.baseHP      .push_back( md.baseHP );
+            m_pkmn.baseAtk     .push_back( md.baseAtk );
+            m_pkmn.baseSpAtk   .push_back( md.baseSpAtk );
+            m_pkmn.baseDef     .push_back( md.baseDef );
+            m_pkmn.baseSpDef   .push_back( md.baseSpDef );
+            m_pkmn.weight      .push_back( md.weight );
+            m_pkmn.size        .push_back( md.size );
+            m_pkmn.preEvoIndex .push_back( md.evoData.preEvoIndex );
+            m_pkmn.evoMethod   .push_back( md.evoData.evoMethod );
+            m_pkmn.evoParam1   .push_back( md.evoData.evoParam1 );
+            m_pkmn.evoParam2   .push_back( md.evoData.evoParam2 );
+            m_pkmn.basePkmn    .push_back( md.BasePkmn );
+            m_pkmn.has2Genders .push_back( pk.Has2GenderEntries() );
+            for( size_t cntex = 0; cntex < md.exclusiveItems.size(); ++cntex )
+                m_pkmn.exclusiveItems[cntex].push_back( md.exclusiveItems[cntex] );
+
+            AppendMoveSet( static_cast<uint16_t>(i), 0, pk.MoveSet1() );
+            AppendMoveSet( static_cast<uint16_t>(i), 1, pk.MoveSet2() );
+        }
+
+        m_learnersByMove = BuildInvertedIndex( m_learnsets.Count(), 1, [this]( size_t row, size_t )->uint32_t
+        {
+            return m_learnsets.move[row];
+        });
+
+        m_pkmnByType = BuildInvertedIndex( nbpkmn, 2, [this]( size_t row, size_t slot )->uint32_t
+        {
+            if( slot == 0 )
+                return m_pkmn.primaryTy[row];
+            //Don't list a Pokemon twice, or under the "none" type
+            if( m_pkmn.secondaryTy[row] == 0 || m_pkmn.secondaryTy[row] == m_pkmn.primaryTy[row] )
+                return StatsIndex_NoKey;
+            return m_pkmn.secondaryTy[row];
+        });
+
+        m_pkmnByExItem = BuildInvertedIndex( nbpkmn, m_pkmn.exclusiveItems.size(), [this]( size_t row, size_t slot )->uint32_t
+        {
+            const uint16_t itemid = m_pkmn.exclusiveItems[slot][row];
+            if( itemid == 0 )
+                return StatsIndex_NoKey;
+            //Don't list a Pokemon twice for the same item
+            for( size_t prev = 0; prev < slot; ++prev )
+            {
+                if( m_pkmn.exclusiveItems[prev][row] == itemid )
+                    return StatsIndex_NoKey;
+            }
+            return itemid;
+        });
+    }
+
+    void GameStatsIndex::AppendMoveSet( uint16_t pkmn, uint8_t setid, const PokeMoveSet & mvset )
+    {
+        auto lambdaappend = [&]( moveid_t mv, level_t lvl, eLearnMethod method )
+        {
+            m_learnsets.pkmn   .push_back( pkmn );
+            m_learnsets.move   .push_back( mv );
+            m_learnsets.level  .push_back( lvl );
+            m_learnsets.method .push_back( method );
+            m_learnsets.moveset.push_back( setid );
+        };
+
+        //The multimap is already sorted by level
+        for( const auto & lvlupmv : mvset.lvlUpMoveSet )
+            lambdaappend( lvlupmv.second, lvlupmv.first, eLearnMethod::LevelUp );
+        for( const auto & tmmv : mvset.teachableHMTMs )
+            lambdaappend( tmmv, 0, eLearnMethod::HmTm );
+        for( const auto & eggmv : mvset.eggmoves )
+            lambdaappend( eggmv, 0, eLearnMethod::Egg );
+    }
+
+    void GameStatsIndex::IndexMoves( const GameStats & src )
+    {
+        const MoveDB   & mvdb     = src.Moves1();
+        const GameText * pstrings = src.Strings();
+
+        for( size_t i = 0; i < mvdb.size(); ++i )
+        {
+            const MoveData & mv = mvdb[static_cast<uint16_t>(i)];
+            m_moves.name     .push_back( GetCleanString( pstrings, eStringBlocks::MvNames, i ) );
+            m_moves.basePower.push_back( mv.basePower );
+            m_moves.type     .push_back( mv.type );
+            m_moves.category .push_back( mv.category );
+            m_moves.basePP   .push_back( mv.basePP );
+            m_moves.accuracy .push_back( mv.accuracy );
+            m_moves.moveID   .push_back( mv.moveID );
+        }
+
+        m_movesByType = BuildInvertedIndex( m_moves.Count(), 1, [this]( size_t row, size_t )->uint32_t
+        {
+            return m_moves.type[row];
+        });
+    }
+
+    void GameStatsIndex::IndexItems( const GameStats & src )
+    {
+        const ItemsDB  & itemdb   = src.Items();
+        const GameText * pstrings = src.Strings();
+
+        for( size_t i = 0; i < itemdb.size(); ++i )
+        {
+            const itemdata & item = itemdb[static_cast<uint16_t>(i)];
+            m_items.name     .push_back( GetCleanString( pstrings, eStringBlocks::ItemNames, i ) );
+            m_items.buyPrice .push_back( item.buyPrice );
+            m_items.sellPrice.push_back( item.sellPrice );
+            m_items.category .push_back( item.category );
+            m_items.spriteID .push_back( item.spriteID );
+            m_items.itemID   .push_back( item.itemID );
+            m_items.param1   .push_back( item.param1 );
+            m_items.param2   .push_back( item.param2 );
+            m_items.param3   .push_back( item.param3 );
+        }
+
+        m_itemsByCategory = BuildInvertedIndex( m_items.Count(), 1, [this]( size_t row, size_t )->uint32_t
+        {
+            return m_items.category[row];
+        });
+    }
+
+//
+//  Queries
+//
+    GameStatsIndex::rowrange_t GameStatsIndex::LearnsetRowsForMove( moveid_t mvid )const
+    {
+        return m_learnersByMove.Find(mvid);
+    }
+
+    vector<uint16_t> GameStatsIndex::PokemonLearningMove( moveid_t mvid, eLearnMethod method, level_t bylevel )const
+    {
+        vector<uint16_t> result;
+        rowrange_t       rows = m_learnersByMove.Find(mvid);
+
+        //Rows are sorted by Pokemon, so duplicates are always next to each others
+        for( auto itrow = rows.first; itrow != rows.second; ++itrow )
+        {
+            const uint32_t row = *itrow;
+            if( m_learnsets.method[row] != method )
+                continue;
+            if( method == eLearnMethod::LevelUp && m_learnsets.level[row] > bylevel )
+                continue;
+            if( result.empty() || result.back() != m_learnsets.pkmn[row] )
+                result.push_back( m_learnsets.pkmn[row] );
+        }
+        return result;
+    }
+
+    GameStatsIndex::rowrange_t GameStatsIndex::PokemonOfType( uint8_t type )const
+    {
+        return m_pkmnByType.Find(type);
+    }
+
+    GameStatsIndex::rowrange_t GameStatsIndex::PokemonWithExclusiveItem( uint16_t itemid )const
+    {
+        return m_pkmnByExItem.Find(itemid);
+    }
+
+    GameStatsIndex::rowrange_t GameStatsIndex::MovesOfType( uint8_t type )const
+    {
+        return m_movesByType.Find(type);
+    }
+
+    GameStatsIndex::rowrange_t GameStatsIndex::ItemsOfCategory( uint8_t category )const
+    {
+        return m_itemsByCategory.Find(category);
+    }
+
+//
+//  Output
+//
+    void GameStatsIndex::WriteCSV( const std::string & destdir )const
+    {
+        {
+            ofstream out = OpenCSV( destdir, StatsIndex_PkmnCSV,
+                                    "index,name,dexnb,type1,type2,ability1,ability2,iqgroup,movetype,bodysize,expyield,"
+                                    "recruitrate1,recruitrate2,hp,atk,spatk,def,spdef,weight,size,preevo,evomethod,"
+                                    "evoparam1,evoparam2,basepkmn,has2genders,exitem1,exitem2,exitem3,exitem4" );
+            for( size_t i = 0; i < m_pkmn.Count(); ++i )
+            {
+                out << i << ',';
+                WriteCSVRow( out, i, m_pkmn.name, m_pkmn.dexNb, m_pkmn.primaryTy, m_pkmn.secondaryTy, m_pkmn.primAbility,
+                             m_pkmn.secAbility, m_pkmn.IQGrp, m_pkmn.moveTy, m_pkmn.bodySize, m_pkmn.expYield,
+                             m_pkmn.recruitRate1, m_pkmn.recruitRate2, m_pkmn.baseHP, m_pkmn.baseAtk, m_pkmn.baseSpAtk,
+                             m_pkmn.baseDef, m_pkmn.baseSpDef, m_pkmn.weight, m_pkmn.size, m_pkmn.preEvoIndex,
+                             m_pkmn.evoMethod, m_pkmn.evoParam1, m_pkmn.evoParam2, m_pkmn.basePkmn, m_pkmn.has2Genders,
+                             m_pkmn.exclusiveItems[0], m_pkmn.exclusiveItems[1], m_pkmn.exclusiveItems[2], m_pkmn.exclusiveItems[3] );
+                out << '\n';
+            }
+        }
+
+        {
+            ofstream out = OpenCSV( destdir, StatsIndex_LearnsetCSV, "pkmn,moveset,method,level,move" );
+            for( size_t i = 0; i < m_learnsets.Count(); ++i )
+            {
+                WriteCSVRow( out, i, m_learnsets.pkmn, m_learnsets.moveset, m_learnsets.method, m_learnsets.level, m_learnsets.move );
+                out << '\n';
+            }
+        }
+
+        {
+            ofstream out = OpenCSV( destdir, StatsIndex_MovesCSV, "index,name,basepower,type,category,basepp,accuracy,moveid" );
+            for( size_t i = 0; i < m_moves.Count(); ++i )
+            {
+                out << i << ',';
+                WriteCSVRow( out, i, m_moves.name, m_moves.basePower, m_moves.type, m_moves.category, m_moves.basePP,
+                             m_moves.accuracy, m_moves.moveID );
+                out << '\n';
+            }
+        }
+
+        {
+            ofstream out = OpenCSV( destdir, StatsIndex_ItemsCSV, "index,name,buyprice,sellprice,category,spriteid,itemid,param1,param2,param3" );
+            for( size_t i = 0; i < m_items.Count(); ++i )
+            {
+                out << i << ',';
+                WriteCSVRow( out, i, m_items.name, m_items.buyPrice, m_items.sellPrice, m_items.category, m_items.spriteID,
+                             m_items.itemID, m_items.param1, m_items.param2, m_items.param3 );
+                out << '\n';
+            }
+        }
+    }
+};
@@ -1,6 +1,7 @@
 #include <ppmdu/pmd2/pmd2_asm.hpp>
 #include <utils/utility.hpp>
 #include <utils/gbyteutils.hpp>
+#include <utils/gfileio.hpp>
 #include <ppmdu/pmd2/pmd2_hcdata.hpp>
 #include <ppmdu/fmts/sir0.hpp>
 #include <sstream>
@@ -68,9 +69,8 @@ namespace pmd2
 
         PMD2_ASM::modinfo CheckBlockModdedTag(const binarylocatioinfo & locinfo)
         {
-            ifstream binf;
-            OpenBinFile(binf,locinfo);
-            return CheckBlockModdedTag(binf, locinfo);
+            auto pbinf = OpenBinFile(locinfo);
+            return CheckBlockModdedTag(*pbinf, locinfo);
         }
 
         /*
@@ -116,8 +116,8 @@ namespace pmd2
             void LoadData( eBinaryLocations binloc, _DataTy & out_data)
         {
             const binarylocatioinfo bininfo = m_conf.GetGameBinaryOffset(binloc);
-            ifstream                binf;
-            OpenBinFile(binf, bininfo);
+            auto                    pbinf   = OpenBinFile(bininfo);
+            istream               & binf    = *pbinf;
 
             //Check if modded tag is there, then load from the correct source!
             PMD2_ASM::modinfo modinfo = CheckBlockModdedTag( binf, bininfo );
@@ -126,9 +126,8 @@ namespace pmd2
 
             if(modinfo.ismodded())
             {
-                ifstream loosebin;
-                OpenLooseBinFile(loosebin,binloc);
-                LoadDataFromLooseBin<_DataTy,_TransType>(out_data, loosebin); //Open lose file
+                auto ploosebin = OpenLooseBinFile(binloc);
+                LoadDataFromLooseBin<_DataTy,_TransType>(out_data, *ploosebin); //Open lose file
             }
             else
                 LoadDataFromBin<_DataTy,_TransType>(out_data, bininfo, binf);
@@ -138,7 +137,7 @@ namespace pmd2
             LoadDataFromLooseBin
         */
         template<class _DataTy, class _TransType>
-            void LoadDataFromLooseBin( _DataTy & out_data, std::ifstream & binstrm )
+            void LoadDataFromLooseBin( _DataTy & out_data, std::istream & binstrm )
         {
             filetypes::sir0_header hdr;
             istreambuf_iterator<char> itb(binstrm); //istream iterators don't need to be modified since pos is held in the stream
@@ -168,7 +167,7 @@ namespace pmd2
             LoadDataFromBin
         */
         template<class _DataTy, class _TransType>
-            void LoadDataFromBin( _DataTy & out_data, const binarylocatioinfo & bininfo, std::ifstream & binstrm )
+            void LoadDataFromBin( _DataTy & out_data, const binarylocatioinfo & bininfo, std::istream & binstrm )
         {
             //2. If no modded tag, we go ahead and dump the list
             binstrm.seekg(bininfo.location.beg);
@@ -392,25 +391,38 @@ namespace pmd2
     private:
 
         /*
+            The binaries may be in a mounted ROM image, so they're opened through utils::io.
         */
-        void OpenBinFile( std::ifstream & out_strm, const binarylocatioinfo & locinfo)
+        std::unique_ptr<std::istream> OpenBinFile( const binarylocatioinfo & locinfo )
         {
             const std::string binpath = MakeBinPathString(locinfo);
-            out_strm.open(binpath, ios::in | ios::binary );
-            if( out_strm.bad() || !out_strm.is_open() )
-                throw std::runtime_error("PMD2_ASM_Impl::OpenBinFile(): Couldn't open file " + binpath + "!");
-            out_strm.exceptions(ios::badbit);
+            try
+            {
+                std::unique_ptr<std::istream> pstrm = utils::io::OpenInputFile(binpath);
+                pstrm->exceptions(ios::badbit);
+                return pstrm;
+            }
+            catch(const std::exception &)
+            {
+                throw_with_nested( std::runtime_error("PMD2_ASM_Impl::OpenBinFile(): Couldn't open file " + binpath + "!") );
+            }
         }
 
         /*
         */
-        void OpenLooseBinFile( std::ifstream & out_strm, eBinaryLocations loc )
+        std::unique_ptr<std::istream> OpenLooseBinFile( eBinaryLocations loc )
         {
             const string binpath = MakeLooseBinFileOutPath(loc);
-            out_strm.open(binpath, ios::in | ios::binary );
-            if( out_strm.bad() || !out_strm.is_open() )
-                throw std::runtime_error("PMD2_ASM_Impl::OpenLooseBinFile(): Couldn't open file " + binpath + " !");
-            out_strm.exceptions(ios::badbit);
+            try
+            {
+                std::unique_ptr<std::istream> pstrm = utils::io::OpenInputFile(binpath);
+                pstrm->exceptions(ios::badbit);
+                return pstrm;
+            }
+            catch(const std::exception &)
+            {
+                throw_with_nested( std::runtime_error("PMD2_ASM_Impl::OpenLooseBinFile(): Couldn't open file " + binpath + " !") );
+            }
         }
 
 //
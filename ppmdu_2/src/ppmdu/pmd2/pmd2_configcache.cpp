@@ -0,0 +1,478 @@
+#include <ppmdu/pmd2/pmd2_configcache.hpp>
+#include <utils/gbyteutils.hpp>
+#include <utils/gfileio.hpp>
+#include <utils/poco_wrapper.hpp>
+#include <utils/library_wide.hpp>
+#include <iostream>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+using namespace std;
+
+namespace pmd2
+{
+//========================================================================================
+//  Constants
+//========================================================================================
+    static const uint64_t ConfigCache_FNVOffset = 0xCBF29CE484222325ull;
+    static const uint64_t ConfigCache_FNVPrime  = 0x100000001B3ull;
+
+//========================================================================================
+//  Utility
+//========================================================================================
+    /*
+        cachewriter
+            Appends values to the snapshot's data.
+    */
+    class cachewriter
+    {
+    public:
+        cachewriter( vector<uint8_t> & out ) :m_out(out), m_itw(back_inserter(out)) {}
+
+        template<class _IntTy>
+            inline void Int( _IntTy val )
+        {
+            m_itw = utils::WriteIntToBytes( val, m_itw );
+        }
+
+        template<class _EnumTy>
+            inline void Enum( _EnumTy val )
+        {
+            Int( static_cast<uint32_t>(val) );
+        }
+
+        inline void Str( const string & str )
+        {
+            Int( static_cast<uint32_t>(str.size()) );
+            m_out.insert( m_out.end(), str.begin(), str.end() );
+        }
+
+    private:
+        vector<uint8_t>                          & m_out;
+        std::back_insert_iterator<vector<uint8_t>> m_itw;
+    };
+
+    /*
+        cachereader
+            Reads values from the snapshot's data. Throws if the data ends early.
+    */
+    class cachereader
+    {
+    public:
+        cachereader( const vector<uint8_t> & data ) :m_itr(data.begin()), m_itend(data.end()) {}
+
+        template<class _IntTy>
+            inline _IntTy Int()
+        {
+            return utils::ReadIntFromBytes<_IntTy>( m_itr, m_itend );
+        }
+
+        template<class _EnumTy>
+            inline _EnumTy Enum()
+        {
+            return static_cast<_EnumTy>( Int<uint32_t>() );
+        }
+
+        inline string Str()
+        {
+            const uint32_t len = Int<uint32_t>();
+            if( static_cast<size_t>(std::distance( m_itr, m_itend )) < len )
+                throw runtime_error("ConfigBinaryCache: Unexpected end of data!");
+            string str( m_itr, m_itr + len );
+            m_itr += len;
+            return str;
+        }
+
+        inline bool AtEnd()const { return m_itr == m_itend; }
+
+    private:
+        vector<uint8_t>::const_iterator m_itr;
+        vector<uint8_t>::const_iterator m_itend;
+    };
+
+//
+//  Script data entries
+//
+    inline void WriteEntry( cachewriter & w, const gamevariable_info & e )
+    {
+        w.Str(e.name);
+        w.Int(e.type); w.Int(e.unk1); w.Int(e.memoffset); w.Int(e.bitshift); w.Int(e.unk3); w.Int(e.unk4);
+    }
+    inline void ReadEntry( cachereader & r, gamevariable_info & e )
+    {
+        e.name      = r.Str();
+        e.type      = r.Int<int16_t>();
+        e.unk1      = r.Int<int16_t>();
+        e.memoffset = r.Int<int16_t>();
+        e.bitshift  = r.Int<int16_t>();
+        e.unk3      = r.Int<int16_t>();
+        e.unk4      = r.Int<int16_t>();
+    }
+
+    inline void WriteEntry( cachewriter & w, const livesent_info & e )
+    {
+        w.Str(e.name);
+        w.Int(e.type); w.Int(e.entid); w.Int(e.unk3); w.Int(e.unk4);
+    }
+    inline void ReadEntry( cachereader & r, livesent_info & e )
+    {
+        e.name  = r.Str();
+        e.type  = r.Int<int16_t>();
+        e.entid = r.Int<int16_t>();
+        e.unk3  = r.Int<int16_t>();
+        e.unk4  = r.Int<int16_t>();
+    }
+
+    inline void WriteEntry( cachewriter & w, const level_info & e )
+    {
+        w.Str(e.name);
+        w.Int(e.mapty); w.Int(e.unk2); w.Int(e.mapid); w.Int(e.unk4);
+    }
+    inline void ReadEntry( cachereader & r, level_info & e )
+    {
+        e.name  = r.Str();
+        e.mapty = r.Int<int16_t>();
+        e.unk2  = r.Int<int16_t>();
+        e.mapid = r.Int<int16_t>();
+        e.unk4  = r.Int<int16_t>();
+    }
+
+    inline void WriteEntry( cachewriter & w, const commonroutine_info & e )
+    {
+        w.Str(e.name);
+        w.Int(e.id); w.Int(e.unk1);
+    }
+    inline void ReadEntry( cachereader & r, commonroutine_info & e )
+    {
+        e.name = r.Str();
+        e.id   = r.Int<int16_t>();
+        e.unk1 = r.Int<int16_t>();
+    }
+
+    inline void WriteEntry( cachewriter & w, const object_info & e )
+    {
+        w.Str(e.name);
+        w.Int(e.unk1); w.Int(e.unk2); w.Int(e.unk3);
+    }
+    inline void ReadEntry( cachereader & r, object_info & e )
+    {
+        e.name = r.Str();
+        e.unk1 = r.Int<int16_t>();
+        e.unk2 = r.Int<int16_t>();
+        e.unk3 = r.Int<int16_t>();
+    }
+
+    inline void WriteEntry( cachewriter & w, const string & e ) { w.Str(e); }
+    inline void ReadEntry ( cachereader & r, string & e )       { e = r.Str(); }
+
+    //The xml parser uses the entry's name as lookup key for all the script data tables
+    inline const string & EntryName( const string & e ) { return e; }
+    template<class _EntryTy>
+        inline const string & EntryName( const _EntryTy & e ) { return e.name; }
+
+    template<class _EntryTy>
+        void WriteNamedEntries( cachewriter & w, const NamedDataEntry<_EntryTy> & entries )
+    {
+        w.Int( static_cast<uint32_t>(entries.size()) );
+        for( const auto & e : entries )
+            WriteEntry( w, e );
+    }
+
+    template<class _EntryTy>
+        void ReadNamedEntries( cachereader & r, NamedDataEntry<_EntryTy> & entries )
+    {
+        const uint32_t nbentries = r.Int<uint32_t>();
+        for( uint32_t i = 0; i < nbentries; ++i )
+        {
+            _EntryTy e;
+            ReadEntry( r, e );
+            entries.PushEntryPair( EntryName(e), e );
+        }
+    }
+
+//========================================================================================
+//  ConfigBinaryCache
+//========================================================================================
+    std::string ConfigBinaryCache::MakeCachePath( const std::string & configfile, const std::string & selector )
+    {
+        return configfile + "." + selector + "." + ConfigCache_FExt;
+    }
+
+    uint64_t ConfigBinaryCache::HashFile( const std::string & fpath )
+    {
+        ifstream infile( fpath, ios::in | ios::binary );
+        if( !infile )
+            throw runtime_error("ConfigBinaryCache::HashFile(): Couldn't open file \"" + fpath + "\"!");
+
+        uint64_t hash = ConfigCache_FNVOffset;
+        char     buffer[4096];
+        while( infile.read( buffer, sizeof(buffer) ) || infile.gcount() > 0 )
+        {
+            const streamsize nbread = infile.gcount();
+            for( streamsize i = 0; i < nbread; ++i )
+                hash = (hash ^ static_cast<uint8_t>(buffer[i])) * ConfigCache_FNVPrime;
+        }
+        return hash;
+    }
+
+    bool ConfigBinaryCache::Load( const std::string & cachefile, ConfigLoader & target )
+    {
+        if( !utils::isFile(cachefile) )
+            return false;
+
+        try
+        {
+            const vector<uint8_t> data = utils::io::ReadFileToByteVector(cachefile);
+            cachereader           r(data);
+
+            if( r.Int<uint32_t>() != ConfigCache_MagicNumber || r.Int<uint32_t>() != ConfigCache_Version )
+                return false;
+
+            //Check the source files first, so we don't decode anything for nothing
+            const uint32_t nbsrcfiles = r.Int<uint32_t>();
+            for( uint32_t i = 0; i < nbsrcfiles; ++i )
+            {
+                const string   srcpath = r.Str();
+                const uint64_t srchash = r.Int<uint64_t>();
+                if( !utils::isFile(srcpath) || HashFile(srcpath) != srchash )
+                {
+                    if( utils::LibWide().isLogOn() )
+                        clog << "ConfigBinaryCache: \"" <<srcpath <<"\" changed. Ignoring cache \"" <<cachefile <<"\".\n";
+                    return false;
+                }
+            }
+
+            //Version info
+            GameVersionInfo verinf;
+            verinf.id          = r.Str();
+            verinf.code        = r.Str();
+            verinf.version     = r.Enum<eGameVersion>();
+            verinf.region      = r.Enum<eGameRegion>();
+            verinf.arm9off14   = r.Int<uint16_t>();
+            verinf.defaultlang = r.Enum<eGameLanguages>();
+            verinf.issupported = r.Int<uint8_t>() != 0;
+
+            //Constants
+            GameConstants::constcnt_t consts;
+            const uint32_t nbconsts = r.Int<uint32_t>();
+            for( uint32_t i = 0; i < nbconsts; ++i )
+            {
+                eGameConstants cnst = r.Enum<eGameConstants>();
+                consts.emplace( cnst, r.Str() );
+            }
+
+            //Binaries
+            GameBinariesInfo binfo;
+            const uint32_t   nbbins = r.Int<uint32_t>();
+            for( uint32_t i = 0; i < nbbins; ++i )
+            {
+                string     binpath = r.Str();
+                binaryinfo curbin;
+                curbin.loadaddress = r.Int<uint32_t>();
+                const uint32_t nbblocks = r.Int<uint32_t>();
+                for( uint32_t j = 0; j < nbblocks; ++j )
+                {
+                    eBinaryLocations loc = r.Enum<eBinaryLocations>();
+                    binlocation      bl;
+                    bl.beg = static_cast<size_t>( r.Int<uint64_t>() );
+                    bl.end = static_cast<size_t>( r.Int<uint64_t>() );
+                    curbin.blocks.emplace( loc, bl );
+                }
+                binfo.AddBinary( std::move(binpath), std::move(curbin) );
+            }
+
+            //Languages
+            LanguageFilesDB::strfiles_t langs;
+            const uint32_t              nblangs = r.Int<uint32_t>();
+            for( uint32_t i = 0; i < nblangs; ++i )
+            {
+                string         strfname = r.Str();
+                string         locstr   = r.Str();
+                eGameLanguages lang     = r.Enum<eGameLanguages>();
+                StringsCatalog::blkcnt_t blocks;
+                const uint32_t nbblocks = r.Int<uint32_t>();
+                for( uint32_t j = 0; j < nbblocks; ++j )
+                {
+                    eStringBlocks blk = r.Enum<eStringBlocks>();
+                    strbounds_t   bnd;
+                    bnd.beg = r.Int<uint32_t>();
+                    bnd.end = r.Int<uint32_t>();
+                    blocks.emplace( blk, bnd );
+                }
+                StringsCatalog catalog;
+                catalog.SetStrFName    ( strfname );
+                catalog.SetLocaleString( locstr );
+                catalog.SetLanguage    ( lang );
+                catalog.AddStringBlocks( std::move(blocks) );
+                langs.emplace( std::move(strfname), std::move(catalog) );
+            }
+
+            //Script data
+            GameScriptData scrdata;
+            ReadNamedEntries( r, scrdata.m_gvars );
+            ReadNamedEntries( r, scrdata.m_gvarsex );
+            ReadNamedEntries( r, scrdata.m_livesent );
+            ReadNamedEntries( r, scrdata.m_levels );
+            ReadNamedEntries( r, scrdata.m_commonroutines );
+            ReadNamedEntries( r, scrdata.m_facenames );
+            ReadNamedEntries( r, scrdata.m_faceposmodes );
+            ReadNamedEntries( r, scrdata.m_directions );
+            ReadNamedEntries( r, scrdata.m_objectsinfo );
+
+            //ASM patches
+            GameASMPatchData asmdata;
+            asmdata.asmpatchdir = r.Str();
+            const uint32_t nbpatches = r.Int<uint32_t>();
+            for( uint32_t i = 0; i < nbpatches; ++i )
+            {
+                asmpatchentry patch;
+                patch.id = r.Str();
+                const uint32_t nbsteps = r.Int<uint32_t>();
+                for( uint32_t j = 0; j < nbsteps; ++j )
+                {
+                    asmpatchentry::asmpatchstep step;
+                    step.op    = r.Enum<asmpatchentry::eAsmPatchStep>();
+                    step.param = r.Str();
+                    patch.steps.push_back( std::move(step) );
+                }
+                string id = patch.id;
+                asmdata.patches.emplace( std::move(id), std::move(patch) );
+            }
+            const uint32_t nbloosebins = r.Int<uint32_t>();
+            for( uint32_t i = 0; i < nbloosebins; ++i )
+            {
+                patchloosebinfile lbf;
+                lbf.src  = r.Enum<eBinaryLocations>();
+                lbf.path = r.Str();
+                asmdata.lfentry.insert_or_assign( lbf.src, lbf );
+            }
+
+            if( !r.AtEnd() )
+                return false;
+
+            //Everything was read properly, so commit
+            target.m_versioninfo  = std::move(verinf);
+            target.m_constants.SetConstants( std::move(consts) );
+            target.m_binblocks    = std::move(binfo);
+            target.m_langdb       = LanguageFilesDB( std::move(langs) );
+            target.m_gscriptdata  = std::move(scrdata);
+            target.m_asmpatchdata = std::move(asmdata);
+        }
+        catch( const exception & e )
+        {
+            if( utils::LibWide().isLogOn() )
+                clog << "ConfigBinaryCache: Couldn't load cache \"" <<cachefile <<"\": " <<e.what() <<"\n";
+            return false;
+        }
+
+        if( utils::LibWide().isLogOn() )
+            clog << "ConfigBinaryCache: Loaded configuration from cache \"" <<cachefile <<"\".\n";
+        return true;
+    }
+
+    void ConfigBinaryCache::Save( const std::string & cachefile, const ConfigLoader & src, const std::vector<std::string> & srcfiles )
+    {
+        vector<uint8_t> data;
+        cachewriter     w(data);
+
+        w.Int( ConfigCache_MagicNumber );
+        w.Int( ConfigCache_Version );
+
+        //Source files
+        w.Int( static_cast<uint32_t>(srcfiles.size()) );
+        for( const auto & srcpath : srcfiles )
+        {
+            w.Str( srcpath );
+            w.Int( HashFile(srcpath) );
+        }
+
+        //Version info
+        const GameVersionInfo & verinf = src.m_versioninfo;
+        w.Str ( verinf.id );
+        w.Str ( verinf.code );
+        w.Enum( verinf.version );
+        w.Enum( verinf.region );
+        w.Int ( verinf.arm9off14 );
+        w.Enum( verinf.defaultlang );
+        w.Int ( static_cast<uint8_t>(verinf.issupported) );
+
+        //Constants
+        w.Int( static_cast<uint32_t>(src.m_constants.Constants().size()) );
+        for( const auto & cnst : src.m_constants.Constants() )
+        {
+            w.Enum( cnst.first );
+            w.Str ( cnst.second );
+        }
+
+        //Binaries
+        w.Int( static_cast<uint32_t>(src.m_binblocks.Binaries().size()) );
+        for( const auto & bin : src.m_binblocks.Binaries() )
+        {
+            w.Str( bin.first );
+            w.Int( bin.second.loadaddress );
+            w.Int( static_cast<uint32_t>(bin.second.blocks.size()) );
+            for( const auto & blk : bin.second.blocks )
+            {
+                w.Enum( blk.first );
+                w.Int ( static_cast<uint64_t>(blk.second.beg) );
+                w.Int ( static_cast<uint64_t>(blk.second.end) );
+            }
+        }
+
+        //Languages
+        w.Int( static_cast<uint32_t>(src.m_langdb.Languages().size()) );
+        for( const auto & lang : src.m_langdb.Languages() )
+        {
+            const StringsCatalog & cat = lang.second;
+            w.Str ( cat.GetStrFName() );
+            w.Str ( cat.GetLocaleString() );
+            w.Enum( cat.GetLanguage() );
+            w.Int ( static_cast<uint32_t>(cat.size()) );
+            for( const auto & blk : cat )
+            {
+                w.Enum( blk.first );
+                w.Int ( blk.second.beg );
+                w.Int ( blk.second.end );
+            }
+        }
+
+        //Script data
+        const GameScriptData & scrdata = src.m_gscriptdata;
+        WriteNamedEntries( w, scrdata.m_gvars );
+        WriteNamedEntries( w, scrdata.m_gvarsex );
+        WriteNamedEntries( w, scrdata.m_livesent );
+        WriteNamedEntries( w, scrdata.m_levels );
+        WriteNamedEntries( w, scrdata.m_commonroutines );
+        WriteNamedEntries( w, scrdata.m_facenames );
+        WriteNamedEntries( w, scrdata.m_faceposmodes );
+        WriteNamedEntries( w, scrdata.m_directions );
+        WriteNamedEntries( w, scrdata.m_objectsinfo );
+
+        //ASM patches
+        const GameASMPatchData & asmdata = src.m_asmpatchdata;
+        w.Str( asmdata.asmpatchdir );
+        w.Int( static_cast<uint32_t>(asmdata.patches.size()) );
+        for( const auto & patch : asmdata.patches )
+        {
+            w.Str( patch.second.id );
+            w.Int( static_cast<uint32_t>(patch.second.steps.size()) );
+            for( const auto & step : patch.second.steps )
+            {
+                w.Enum( step.op );
+                w.Str ( step.param );
+            }
+        }
+        w.Int( static_cast<uint32_t>(asmdata.lfentry.size()) );
+        for( const auto & lbf : asmdata.lfentry )
+        {
+            w.Enum( lbf.second.src );
+            w.Str ( lbf.second.path );
+        }
+
+        utils::io::WriteByteVectorToFile( cachefile, data );
+
+        if( utils::LibWide().isLogOn() )
+            clog << "ConfigBinaryCache: Saved configuration cache \"" <<cachefile <<"\".\n";
+    }
+
+};
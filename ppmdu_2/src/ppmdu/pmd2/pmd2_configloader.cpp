@@ -1,4 +1,5 @@
 #include <ppmdu/pmd2/pmd2_configloader.hpp>
+#include <ppmdu/pmd2/pmd2_configcache.hpp>
 #include <utils/pugixml_utils.hpp>
 #include <utils/parse_utils.hpp>
 #include <utils/library_wide.hpp>
@@ -8,6 +9,9 @@
 #include <deque>
 #include <regex>
 #include <string>
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
 using namespace std;
 using namespace pugi;
 
@@ -150,6 +154,7 @@ namespace pmd2
         {
             string confpath = utils::MakeAbsolutePath(configfile);
             pugi::xml_parse_result result = m_doc.load_file( confpath.c_str() );
+            m_srcfiles.push_back(confpath);
             //regex basepathex("(.+.+(?=\\b\\/))(.+\\..+)");
             //smatch sm;
             m_confbasepath = std::move( utils::GetPathOnly( confpath ) );
@@ -188,6 +193,9 @@ namespace pmd2
             }
         }
 
+        //Every xml file that was parsed so far, including external files
+        inline const std::vector<std::string> & SourceFiles()const { return m_srcfiles; }
+
     private:
 
         bool MatchesCurrentVersionID( xml_attribute_iterator itatbeg, xml_attribute_iterator itatend )
@@ -706,6 +714,8 @@ namespace pmd2
                     clog<<"<!>- ConfigXMLParser::HandleExtFile(): Couldn't open sub configuration file \"" <<extfile <<"\"!";
                     return;
                 }
+                if( std::find( m_srcfiles.begin(), m_srcfiles.end(), extfile ) == m_srcfiles.end() )
+                    m_srcfiles.push_back(extfile);
                 xml_node pmd2node = doc.child(ROOT_PMD2.c_str());
 
                 //Parse the data fields of the sub-file
@@ -873,6 +883,7 @@ namespace pmd2
         GameVersionInfo                 m_curversion;
         pugi::xml_document              m_doc;
         std::deque<std::string>         m_subdocs;
+        std::vector<std::string>        m_srcfiles;
 
         ConfigLoader::constcnt_t        m_constants;
         LanguageFilesDB::strfiles_t     m_lang;
@@ -916,12 +927,37 @@ namespace pmd2
 
     void ConfigLoader::Parse( uint16_t arm9off14 )
     {
-        ConfigXMLParser(m_conffile).ParseDataForGameVersion(arm9off14,*this);
+        stringstream sstr;
+        sstr <<"arm9_" <<hex <<setfill('0') <<setw(4) <<arm9off14;
+        ParseOrLoadCache( sstr.str(), [&]( ConfigXMLParser & parser ){ parser.ParseDataForGameVersion(arm9off14,*this); } );
     }
 
     void ConfigLoader::Parse(eGameVersion version, eGameRegion region)
     {
-        ConfigXMLParser(m_conffile).ParseDataForGameVersion(version, region, *this);
+        stringstream sstr;
+        sstr <<"v" <<static_cast<unsigned int>(version) <<"_r" <<static_cast<unsigned int>(region);
+        ParseOrLoadCache( sstr.str(), [&]( ConfigXMLParser & parser ){ parser.ParseDataForGameVersion(version, region, *this); } );
+    }
+
+    void ConfigLoader::ParseOrLoadCache( const std::string & selector, const std::function<void(ConfigXMLParser&)> & fparse )
+    {
+        const string cachefile = ConfigBinaryCache::MakeCachePath( utils::MakeAbsolutePath(m_conffile), selector );
+        if( ConfigBinaryCache::Load( cachefile, *this ) )
+            return;
+
+        ConfigXMLParser parser(m_conffile);
+        fparse(parser);
+
+        //Not being able to write the cache isn't a problem, we'll just parse the xml again next time
+        try
+        {
+            ConfigBinaryCache::Save( cachefile, *this, parser.SourceFiles() );
+        }
+        catch( const exception & e )
+        {
+            if( utils::LibWide().isLogOn() )
+                clog << "<!>- ConfigLoader::ParseOrLoadCache(): Couldn't write configuration cache \"" <<cachefile <<"\": " <<e.what() <<"\n";
+        }
     }
 
 
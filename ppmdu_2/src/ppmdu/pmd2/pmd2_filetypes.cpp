@@ -74,10 +74,7 @@ namespace pmd2 { namespace filetypes
                                              std::vector<uint8_t>::const_iterator & itdataend )
     {
         auto result = CContentHandler::GetInstance().AnalyseContent( analysis_parameter(itdatabeg, itdataend) );
-
-        auto ptrf = ContentIDManager::GetInstance().FindMatchingCnt( result._type );
-        if( ptrf != nullptr )
-            return ptrf->name();
+        return GetFileExtensionForContentType( result._type );
 
         //for( const auto & extentionty : EXT_TO_TYPES )
         //{
@@ -107,7 +104,13 @@ namespace pmd2 { namespace filetypes
         //case e_ContentType::WTE_FILE:
         //    return WTE_FILEX;
         //};
+    }
 
+    std::string GetFileExtensionForContentType( ::filetypes::cnt_t type )
+    {
+        auto ptrf = ContentIDManager::GetInstance().FindMatchingCnt( type );
+        if( ptrf != nullptr )
+            return ptrf->name();
         return string();
     }
 
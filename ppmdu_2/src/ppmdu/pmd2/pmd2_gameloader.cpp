@@ -2,6 +2,10 @@
 #include <utils/utility.hpp>
 #include <utils/library_wide.hpp>
 #include <ppmdu/pmd2/pmd2.hpp>
+#include <ppmdu/fmts/nitrofs.hpp>
+#include <utils/binary_cursor.hpp>
+#include <utils/gfileio.hpp>
+#include <utils/virtual_fs.hpp>
 #include <fstream>
 using namespace std;
 using utils::logutil::slog;
@@ -14,7 +18,9 @@ namespace pmd2
 
     GameDataLoader::GameDataLoader( const std::string & romroot, const std::string & gamelangxml )
         :m_romroot(romroot), m_configfile(gamelangxml),m_bAnalyzed(false)
-    {}
+    {
+        MountRomImage();
+    }
 
     GameDataLoader::~GameDataLoader()
     {
@@ -34,6 +40,36 @@ namespace pmd2
         if( m_text.use_count() > 0 ) 
             slog()<<"<!>- Warning! While destroying the Gameloader object, there were still " <<m_text.use_count() <<" others owner of the GameText pointer!!\n";
         m_text.reset();
+        UnmountRomImage();
+    }
+
+    /*
+        When the rom root is a .nds file, its file system is mounted over its path. Everything
+        else can then read "<rom>.nds/data/..." as if it were an extracted ROM directory.
+    */
+    void GameDataLoader::MountRomImage()
+    {
+        UnmountRomImage();
+        if( !::filetypes::IsNitroROMPath(m_romroot) || !utils::isFile(m_romroot) )
+            return;
+
+        slog()<<"<!>-GameDataLoader: Mounting ROM image \"" <<m_romroot <<"\"..\n";
+        m_rommount.reset( new ::filetypes::NitroROMMount(m_romroot) );
+    }
+
+    void GameDataLoader::UnmountRomImage()
+    {
+        if( m_rommount && m_rommount->IsMounted() && m_rommount->GetROM()->HasChanges() )
+            slog()<<"<!>- Warning! Unmounting ROM image \"" <<m_rommount->GetROM()->GetPath() <<"\" with uncommitted changes! They were discarded.\n";
+        m_rommount.reset();
+    }
+
+    void GameDataLoader::CommitRomImage()
+    {
+        if( !m_rommount || !m_rommount->IsMounted() || !m_rommount->GetROM()->HasChanges() )
+            return;
+        slog()<<"<!>-GameDataLoader: Writing changes into ROM image \"" <<m_rommount->GetROM()->GetPath() <<"\"..\n";
+        m_rommount->Commit();
     }
 
     void GameDataLoader::AnalyseGame()
@@ -141,10 +177,9 @@ namespace pmd2
         {
             uint16_t     arm9off14 = 0;
             arm9path << utils::TryAppendSlash(m_romroot) <<FName_ARM9Bin; 
-            ifstream arm9f( arm9path.str(), std::ios::in | std::ios::binary );
-            arm9f.exceptions(ifstream::badbit);
-            arm9f.seekg(14);
-            utils::ReadIntFromBytes( arm9off14, std::istreambuf_iterator<char>(arm9f.rdbuf()), std::istreambuf_iterator<char>() );
+            utils::io::MappedFile arm9f( arm9path.str() );
+            if( arm9f.size() >= 16 )
+                arm9off14 = utils::Load<uint16_t>( arm9f.data() + 14 );
             
             if( arm9off14 != 0 )
             {
@@ -328,6 +363,7 @@ namespace pmd2
 
         slog()<<"<!>-GameDataLoader: Requested writing of text data!\n";
         m_text->Write();
+        CommitRomImage();
     }
 
     void GameDataLoader::DeInitScripts()
@@ -380,6 +416,7 @@ namespace pmd2
         
         slog()<<"<!>-GameDataLoader: Requested writing of game statistics data!\n";
         m_stats->Write();
+        CommitRomImage();
     }
 
     void GameDataLoader::DeInitAudio()
@@ -393,6 +430,26 @@ namespace pmd2
         assert(false);
     }
 
+    void GameDataLoader::UnloadGameText()
+    {
+        //Stats and scripts refer to the text, so they have to be reloaded along with it
+        UnloadStats();
+        UnloadScripts();
+        m_text.reset();
+    }
+
+    void GameDataLoader::UnloadScripts()
+    {
+        //Levels depend on script via shared ptr, so delete it before deleting scripts!
+        m_levels .reset(nullptr);
+        m_scripts.reset();
+    }
+
+    void GameDataLoader::UnloadStats()
+    {
+        m_stats.reset();
+    }
+
     //void GameDataLoader::WriteAsm()
     //{
     //    if(!m_bAnalyzed)
@@ -411,7 +468,7 @@ namespace pmd2
     //}
 
 // ======================== Data Access ========================
-    void                      GameDataLoader::SetRomRoot(const std::string & romroot)   { m_romroot = romroot; }
+    void                      GameDataLoader::SetRomRoot(const std::string & romroot)   { m_romroot = romroot; MountRomImage(); }
     const std::string       & GameDataLoader::GetRomRoot() const                        { return m_romroot; }
 
     GameText                * GameDataLoader::GetGameText()                             { return m_text.get(); }
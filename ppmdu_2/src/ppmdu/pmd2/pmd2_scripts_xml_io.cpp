@@ -9,6 +9,7 @@
 #include <ppmdu/pmd2/pmd2_scripts_opcodes.hpp>
 #include <ppmdu/pmd2/pmd2_xml_sniffer.hpp>
 #include <utils/pugixml_utils.hpp>
+#include <utils/file_sink.hpp>
 #include <utils/library_wide.hpp>
 //#include <utils/multiple_task_handler.hpp>
 #include <utils/parallel_tasks.hpp>
@@ -3229,8 +3230,9 @@ namespace pmd2
     class GameScriptsXMLWriter
     {
     public:
-        GameScriptsXMLWriter( const LevelScript & set, const ConfigLoader & conf )
-            :m_scrset(set), m_gconf(conf), m_xmlflags(pugi::format_default)
+        //If psink isn't null, the xml files are queued on it, instead of being written right away.
+        GameScriptsXMLWriter( const LevelScript & set, const ConfigLoader & conf, utils::io::FileSink * psink = nullptr )
+            :m_scrset(set), m_gconf(conf), m_xmlflags(pugi::format_default), m_psink(psink)
         {}
 
         /*
@@ -3267,8 +3269,7 @@ namespace pmd2
             m_xmlflags = (m_options.bescapepcdata)? pugi::format_default  :
                                         pugi::format_indent | pugi::format_no_escapes;
             //Write doc
-            if( ! doc.save_file( sstrfname.str().c_str(), "    "/*"\t"*/, m_xmlflags, pugi::encoding_utf8 ) )
-                throw std::runtime_error("GameScriptsXMLWriter::Write(): PugiXML can't write xml file " + sstrfname.str());
+            SaveDocument( doc, sstrfname.str(), "GameScriptsXMLWriter::Write()" );
         }
 
         /*
@@ -3282,7 +3283,10 @@ namespace pmd2
             stringstream sstrdirname;
             sstrdirname << utils::TryAppendSlash(destdir) <<m_scrset.Name();
             const string newdestdir = sstrdirname.str();
-            utils::DoCreateDirectory(newdestdir);
+            if( m_psink != nullptr )
+                m_psink->PrepareDirectory(newdestdir);
+            else
+                utils::DoCreateDirectory(newdestdir);
             m_xmlflags = (m_options.bescapepcdata)? pugi::format_default  :
                            pugi::format_indent | pugi::format_no_escapes;
             //Write stuff
@@ -3294,6 +3298,18 @@ namespace pmd2
 
     private:
 
+        /*
+            SaveDocument
+                Writes the document, or queues it on the sink if there's one.
+        */
+        void SaveDocument( const xml_document & doc, const std::string & fname, const char * context )
+        {
+            if( m_psink != nullptr )
+                m_psink->Write( fname, SaveXMLToBuffer( doc, "    "/*"\t"*/, m_xmlflags, pugi::encoding_utf8 ) );
+            else if( ! doc.save_file( fname.c_str(), "    "/*"\t"*/, m_xmlflags, pugi::encoding_utf8 ) )
+                throw std::runtime_error(string(context) + ": PugiXML can't write xml file " + fname);
+        }
+
         /*
             WriteSetAsFile
                 Write a set into its own XML file named after its set identifier.
@@ -3319,8 +3335,7 @@ namespace pmd2
             WriteSet(xroot, set);
 
             //Write doc
-            if( ! doc.save_file( sstrfname.str().c_str(), "    ", m_xmlflags, pugi::encoding_utf8 ) )
-                throw std::runtime_error("GameScriptsXMLWriter::WriteSetAsFile(): PugiXML can't write xml file " + sstrfname.str());
+            SaveDocument( doc, sstrfname.str(), "GameScriptsXMLWriter::WriteSetAsFile()" );
         }
 
         /*
@@ -3343,8 +3358,7 @@ namespace pmd2
             WriteLSDTable(xroot);
 
             //Write doc
-            if( ! doc.save_file( sstrfname.str().c_str(), "    ", m_xmlflags, pugi::encoding_utf8 ) )
-                throw std::runtime_error("GameScriptsXMLWriter::WriteLSDAsFile(): PugiXML can't write xml file " + sstrfname.str());
+            SaveDocument( doc, sstrfname.str(), "GameScriptsXMLWriter::WriteLSDAsFile()" );
         }
 
         /*
@@ -3442,6 +3456,7 @@ namespace pmd2
         const ConfigLoader      & m_gconf;
         scriptprocoptions         m_options;
         unsigned int              m_xmlflags;
+        utils::io::FileSink     * m_psink;
     };
 
 //==============================================================================
@@ -3460,6 +3475,7 @@ namespace pmd2
                             CompilerReport   & reporter,
                             const scriptprocoptions & options)
     {
+        utils::TraceScope trace("script xml import level");
         if( utils::LibWide().isLogOn() )
             slog() <<"##### Importing " << fname <<" #####\n";
         try
@@ -3494,13 +3510,15 @@ namespace pmd2
                             const string            & dir, 
                             const ConfigLoader      & gs, 
                             const scriptprocoptions & options,
+                            utils::io::FileSink     & sink,
                             atomic<uint32_t>        & completed )
     {
+        utils::TraceScope trace("script xml export level");
         if( utils::LibWide().isLogOn() )
             slog() <<"##### Exporting " <<entry.path() <<" #####\n";
         try
         {
-            GameScriptsXMLWriter(entry(), gs).Write(dir, options);
+            GameScriptsXMLWriter(entry(), gs, &sink).Write(dir, options);
         }
         catch(const std::exception & e)
         {
@@ -3542,6 +3560,7 @@ namespace pmd2
                               GameScripts & out_dest, const 
                               scriptprocoptions & options )
     {
+        utils::TraceScope trace("script xml import");
         if( out_dest.m_common.Components().empty() && out_dest.m_setsindex.empty())
             throw std::runtime_error("ImportXMLGameScripts(): No script data to load to!!");
 
@@ -3700,10 +3719,13 @@ namespace pmd2
                               const GameScripts         & gs, 
                               const scriptprocoptions   & options )
     {
+        utils::TraceScope trace("script xml export");
+        utils::io::FileSink sink;   //The levels' xml files are written in the background, while the next ones are converted
+
         //Export COMMON first
         if(utils::LibWide().ShouldDisplayProgress())
             cout<<"<*>- Writing COMMOM.xml..";
-        GameScriptsXMLWriter(gs.m_common, gs.GetConfig() ).Write(dir, options);
+        GameScriptsXMLWriter(gs.m_common, gs.GetConfig(), &sink ).Write(dir, options);
 
         atomic_bool                  shouldUpdtProgress = true;
         future<void>                 updtProgress;
@@ -3720,6 +3742,7 @@ namespace pmd2
                                                                  std::cref(dir), 
                                                                  std::cref(gs.GetConfig()),
                                                                  std::cref(options),
+                                                                 std::ref(sink),
                                                                  std::ref(completed) ) ) );
             if(utils::LibWide().isLogOn())
                 slog() << "\t+ " << utils::GetBaseNameOnly(entry.first) <<"\n";
@@ -3743,6 +3766,7 @@ namespace pmd2
             taskhandler.Start();
             taskhandler.WaitTasksFinished();
             taskhandler.WaitStop();
+            sink.Flush();
 
             shouldUpdtProgress = false;
             if( updtProgress.valid() )
@@ -3,6 +3,7 @@
 #include <cstdint>
 #include <vector>
 #include <algorithm>
+#include <cstring>
 #include <iostream>
 #include <utils/utility.hpp>
 using namespace std;
@@ -23,6 +24,61 @@ namespace pmd2 { namespace compression
             (*itpos) = 0; 
     }
 
+//================================================================================================
+// Zero Strip Kernels
+//================================================================================================
+    bool IsZeroBlock( const uint8_t * pbeg, size_t len )
+    {
+        uint64_t accum = 0;
+        size_t   pos   = 0;
+
+        //OR together 4 words at a time. Compilers turn this into vector instructions.
+        for( ; (pos + 32) <= len; pos += 32 )
+        {
+            uint64_t words[4];
+            memcpy( words, pbeg + pos, sizeof(words) );
+            accum |= words[0] | words[1] | words[2] | words[3];
+            if( accum != 0 )
+                return false;
+        }
+        for( ; (pos + 8) <= len; pos += 8 )
+        {
+            uint64_t word;
+            memcpy( &word, pbeg + pos, sizeof(word) );
+            accum |= word;
+        }
+        for( ; pos < len; ++pos )
+            accum |= pbeg[pos];
+
+        return accum == 0;
+    }
+
+    void FindZeroStripRuns( const uint8_t * pbeg, const uint8_t * pend, std::vector<zero_strip_run> & out_runs, size_t blocklen )
+    {
+        const size_t totallen = static_cast<size_t>(pend - pbeg);
+        size_t       pos      = 0;
+
+        while( pos < totallen )
+        {
+            size_t         curblocklen = std::min( blocklen, totallen - pos );
+            const bool     bzero       = IsZeroBlock( pbeg + pos, curblocklen );
+            zero_strip_run run { bzero, static_cast<uint32_t>(pos), 0 };
+
+            //Extend the run for as long as the blocks are of the same kind
+            do
+            {
+                pos += curblocklen;
+                if( pos >= totallen )
+                    break;
+                curblocklen = std::min( blocklen, totallen - pos );
+            }
+            while( IsZeroBlock( pbeg + pos, curblocklen ) == bzero );
+
+            run.length = static_cast<uint32_t>(pos) - run.offset;
+            out_runs.push_back(run);
+        }
+    }
+
 //================================================================================================
 // rle_table_entry
 //================================================================================================
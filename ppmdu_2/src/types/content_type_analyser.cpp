@@ -1,5 +1,7 @@
 #include <types/content_type_analyser.hpp>
+#include <utils/parallel_tasks.hpp>
 #include <limits>
+#include <algorithm>
 
 #ifndef USE_PPMDU_CONTENT_TYPE_ANALYSER
     static_assert(false, "Possibly forgot to add the preprocessor definition USE_PPMDU_CONTENT_TYPE_ANALYSER to enable the content type analyser! Otherwise, exclude content_type_analyser.cpp from build!")
@@ -7,6 +9,63 @@
 
 namespace filetypes
 {
+//==================================================================
+// ContentRuleDispatchTable
+//==================================================================
+    void ContentRuleDispatchTable::Build( const rulelist_t & rules )
+    {
+        m_bymagic.clear();
+        m_generic.clear();
+
+        //Make a list for every magic numbers first, so rules without magic numbers placed before are added to all of them
+        for( IContentHandlingRule * prule : rules )
+        {
+            for( uint32_t magic : prule->getMagicNumbers() )
+                m_bymagic[magic];
+        }
+
+        for( IContentHandlingRule * prule : rules )
+        {
+            std::vector<uint32_t> magics = prule->getMagicNumbers();
+            if( magics.empty() )
+            {
+                m_generic.push_back(prule);
+                for( auto & entry : m_bymagic )
+                    entry.second.push_back(prule);
+            }
+            else
+            {
+                for( uint32_t magic : magics )
+                {
+                    rulelist_t & candidates = m_bymagic[magic];
+                    if( candidates.empty() || candidates.back() != prule ) //In case a rule returns the same magic twice
+                        candidates.push_back(prule);
+                }
+            }
+        }
+    }
+
+    const ContentRuleDispatchTable::rulelist_t & ContentRuleDispatchTable::Candidates( uint32_t magic )const
+    {
+        auto itfound = m_bymagic.find(magic);
+        if( itfound != m_bymagic.end() )
+            return itfound->second;
+        return m_generic;
+    }
+
+    bool ContentRuleDispatchTable::ReadMagic( std::vector<uint8_t>::const_iterator itdatabeg, 
+                                              std::vector<uint8_t>::const_iterator itdataend, 
+                                              uint32_t                           & outmagic )
+    {
+        if( std::distance(itdatabeg, itdataend) < static_cast<ptrdiff_t>(sizeof(uint32_t)) )
+            return false;
+
+        outmagic = 0;
+        for( size_t i = 0; i < sizeof(uint32_t); ++i, ++itdatabeg )
+            outmagic = (outmagic << 8) | *itdatabeg;
+        return true;
+    }
+
 //==================================================================
 // CContentHandler
 //==================================================================
@@ -40,6 +99,7 @@ namespace filetypes
             //Set the rule id
             rule->setRuleID( ++m_current_ruleid );
             m_vRules.push_back( std::unique_ptr<IContentHandlingRule>( rule ) );
+            RebuildDispatchTable();
 
             return m_current_ruleid;
         }
@@ -49,24 +109,42 @@ namespace filetypes
 
     bool CContentHandler::UnregisterRule( cntRID_t ruleid )
     {
-        for( auto &arule : m_vRules )
+        auto itfound = std::find_if( m_vRules.begin(), m_vRules.end(), [ruleid]( const std::unique_ptr<IContentHandlingRule> & arule )
+        { 
+            return arule->getRuleID() == ruleid; 
+        });
+
+        if( itfound != m_vRules.end() )
         {
-            if( arule->getRuleID() == ruleid )
-            {
-                delete arule.release();
-                return true;
-            }
+            m_vRules.erase(itfound);
+            RebuildDispatchTable();
+            return true;
         }
         return false;
     }
 
+    void CContentHandler::RebuildDispatchTable()
+    {
+        ContentRuleDispatchTable::rulelist_t rules;
+        rules.reserve(m_vRules.size());
+        for( auto & arule : m_vRules )
+            rules.push_back(arule.get());
+        m_dispatch.Build(rules);
+    }
+
     //File analysis
     ContentBlock CContentHandler::AnalyseContent( const analysis_parameter & parameters )
     {
         ContentBlock contentdetails;
+        uint32_t     magic = 0;
+
+        //Only feed the data through the rules that could match its magic number, and check which one returns true
+        const ContentRuleDispatchTable::rulelist_t & candidates = 
+            ContentRuleDispatchTable::ReadMagic( parameters._itdatabeg, parameters._itdataend, magic )? 
+                m_dispatch.Candidates(magic) : 
+                m_dispatch.Generic();
 
-        //Feed the data through all the rules we have and check which one returns true
-        for( auto &rule : m_vRules )
+        for( IContentHandlingRule * rule : candidates )
         {
             if( rule->isMatch( parameters._itdatabeg, parameters._itdataend, parameters._filextension ) )
             {
@@ -78,6 +156,26 @@ namespace filetypes
         return contentdetails;
     }
 
+    std::vector<ContentBlock> CContentHandler::AnalyseContents( const std::vector<analysis_parameter> & parameters, bool bparallel )
+    {
+        std::vector<ContentBlock> results( parameters.size() );
+
+        if( !bparallel || parameters.size() < 2 )
+        {
+            for( size_t i = 0; i < parameters.size(); ++i )
+                results[i] = AnalyseContent( parameters[i] );
+        }
+        else
+        {
+            utils::RunIndexedTasks( parameters.size(), [&]( size_t i )
+            {
+                results[i] = AnalyseContent( parameters[i] );
+            }, 
+            "CContentHandler::AnalyseContents(): Analysis failed for some of the data!");
+        }
+        return results;
+    }
+
     bool CContentHandler::isValidRule( cntRID_t theid )const 
     { 
         return (theid != INVALID_RULE_ID && theid < m_current_ruleid); 
@@ -0,0 +1,360 @@
+#include <utils/async_logger.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+using namespace std;
+
+namespace logging
+{
+    //How long the background thread sleeps when there's nothing to write
+    static const chrono::milliseconds DrainInterval(5);
+
+    static atomic<uint64_t> s_nextLoggerID(1);
+
+    //The log of the current thread, for the logger it was last used with
+    struct tls_logcache
+    {
+        uint64_t loggerid = 0;
+        void   * plog     = nullptr;
+    };
+    static thread_local tls_logcache s_logcache;
+
+//
+//  record_ring
+//
+    /*
+        Single producer, single consumer ring of records. Each record is stored as its
+        length followed by its characters, and can wrap around the end of the storage.
+        The positions only ever grow, and are wrapped when indexing.
+    */
+    class AsyncLogger::record_ring
+    {
+    public:
+        explicit record_ring( size_t capacity )
+            :m_data(capacity), m_head(0), m_tail(0)
+        {}
+
+        //Producer side
+        bool TryPush( const char * str, uint32_t len )
+        {
+            const size_t needed = sizeof(uint32_t) + len;
+            const size_t head   = m_head.load(memory_order_relaxed);
+            const size_t tail   = m_tail.load(memory_order_acquire);
+            if( m_data.size() - (head - tail) < needed )
+                return false;
+
+            Write( head, reinterpret_cast<const char*>(&len), sizeof(uint32_t) );
+            Write( head + sizeof(uint32_t), str, len );
+            m_head.store( head + needed, memory_order_release );
+            return true;
+        }
+
+        //Consumer side. Returns whether anything was written.
+        bool DrainTo( ostream & out )
+        {
+            const size_t head = m_head.load(memory_order_acquire);
+            size_t       tail = m_tail.load(memory_order_relaxed);
+            if( head == tail )
+                return false;
+
+            while( tail != head )
+            {
+                uint32_t len = 0;
+                Read( tail, reinterpret_cast<char*>(&len), sizeof(uint32_t) );
+                tail += sizeof(uint32_t);
+
+                const size_t beg   = tail % m_data.size();
+                const size_t first = std::min<size_t>( len, m_data.size() - beg );
+                out.write( m_data.data() + beg, first );
+                if( first < len )
+                    out.write( m_data.data(), len - first );
+                tail += len;
+
+                //Free the space right away, in case the producer is waiting on it
+                m_tail.store( tail, memory_order_release );
+            }
+            return true;
+        }
+
+    private:
+        void Write( size_t pos, const char * src, size_t len )
+        {
+            const size_t beg   = pos % m_data.size();
+            const size_t first = std::min( len, m_data.size() - beg );
+            memcpy( m_data.data() + beg, src, first );
+            memcpy( m_data.data(), src + first, len - first );
+        }
+
+        void Read( size_t pos, char * dest, size_t len )const
+        {
+            const size_t beg   = pos % m_data.size();
+            const size_t first = std::min( len, m_data.size() - beg );
+            memcpy( dest, m_data.data() + beg, first );
+            memcpy( dest + first, m_data.data(), len - first );
+        }
+
+        vector<char>        m_data;
+        atomic<size_t>      m_head;
+        atomic<size_t>      m_tail;
+    };
+
+//
+//  record_streambuf
+//
+    /*
+        Gathers what a thread writes into a line, and hands the line to the logger
+        once it ends. There's no put area, so every write goes through here.
+    */
+    class AsyncLogger::record_streambuf : public std::streambuf
+    {
+    public:
+        record_streambuf( AsyncLogger & owner, thread_log & tl )
+            :m_owner(owner), m_tl(tl)
+        {}
+
+    protected:
+        int_type overflow( int_type c )override;
+        streamsize xsputn( const char * s, streamsize n )override;
+        int sync()override;
+
+    private:
+        AsyncLogger & m_owner;
+        thread_log  & m_tl;
+    };
+
+//
+//  thread_log
+//
+    struct AsyncLogger::thread_log
+    {
+        thread_log( AsyncLogger & owner, size_t ringsize )
+            :threadid(this_thread::get_id()), ring(ringsize), linelen(0), nbdropped(0), nbdroppedreported(0),
+             buf(owner, *this), out(&buf), nullout(nullptr)
+        {}
+
+        thread::id          threadid;
+        record_ring         ring;
+        char                line[MaxRecordLen];
+        size_t              linelen;
+        atomic<uint64_t>    nbdropped;
+        uint64_t            nbdroppedreported;  //Only used by the background thread
+        record_streambuf    buf;
+        ostream             out;
+        ostream             nullout;            //Has no buffer, so it's always bad and formats nothing
+    };
+
+    AsyncLogger::record_streambuf::int_type AsyncLogger::record_streambuf::overflow( int_type c )
+    {
+        if( traits_type::eq_int_type( c, traits_type::eof() ) )
+            return traits_type::not_eof(c);
+
+        const char ch = traits_type::to_char_type(c);
+        m_tl.line[m_tl.linelen++] = ch;
+        if( ch == '\n' || m_tl.linelen == MaxRecordLen )
+            m_owner.Commit(m_tl);
+        return c;
+    }
+
+    streamsize AsyncLogger::record_streambuf::xsputn( const char * s, streamsize n )
+    {
+        const char * const pend = s + n;
+        while( s != pend )
+        {
+            const size_t  room      = MaxRecordLen - m_tl.linelen;
+            const char  * plineend  = static_cast<const char*>( memchr( s, '\n', static_cast<size_t>(pend - s) ) );
+            const char  * pchunkend = (plineend != nullptr)? plineend + 1 : pend;
+            const size_t  len       = std::min( room, static_cast<size_t>(pchunkend - s) );
+
+            memcpy( m_tl.line + m_tl.linelen, s, len );
+            m_tl.linelen += len;
+            s            += len;
+            if( m_tl.linelen == MaxRecordLen || (s == pchunkend && plineend != nullptr) )
+                m_owner.Commit(m_tl);
+        }
+        return n;
+    }
+
+    int AsyncLogger::record_streambuf::sync()
+    {
+        m_owner.Commit(m_tl);
+        return 0;
+    }
+
+//
+//  AsyncLogger
+//
+    AsyncLogger::AsyncLogger( const std::string & outpath, eLogLevel minlvl, eOverflowPolicy policy, size_t ringsize )
+        :m_pownedout(new ofstream(outpath)), m_pout(nullptr), m_minlvl(static_cast<int>(minlvl)), m_policy(policy),
+         m_ringsize(std::max(ringsize, MaxRecordLen * 4)), m_id(s_nextLoggerID++), m_nbdropped(0), m_brunning(false),
+         m_bwake(false), m_nbpasses(0)
+    {
+        if( !m_pownedout->good() )
+            throw runtime_error("AsyncLogger::AsyncLogger(): Couldn't open log file \"" + outpath + "\"!");
+        m_pout = m_pownedout.get();
+        Start();
+    }
+
+    AsyncLogger::AsyncLogger( std::ostream * output, eLogLevel minlvl, eOverflowPolicy policy, size_t ringsize )
+        :m_pout(output), m_minlvl(static_cast<int>(minlvl)), m_policy(policy),
+         m_ringsize(std::max(ringsize, MaxRecordLen * 4)), m_id(s_nextLoggerID++), m_nbdropped(0), m_brunning(false),
+         m_bwake(false), m_nbpasses(0)
+    {
+        if( m_pout == nullptr )
+            throw runtime_error("AsyncLogger::AsyncLogger(): Output stream is null!");
+        Start();
+    }
+
+    AsyncLogger::~AsyncLogger()
+    {
+        Stop();
+
+        //Write out the lines that were never ended
+        for( auto & ptl : m_logs )
+        {
+            if( ptl->linelen != 0 )
+                m_pout->write( ptl->line, ptl->linelen ) <<"\n";
+        }
+        m_pout->flush();
+    }
+
+    void AsyncLogger::Start()
+    {
+        m_brunning.store(true);
+        m_drainthread = thread( &AsyncLogger::DrainLoop, this );
+    }
+
+    void AsyncLogger::Stop()
+    {
+        {
+            lock_guard<mutex> lk(m_drainmtx);
+            m_brunning.store(false);
+        }
+        m_wakecv.notify_one();
+        if( m_drainthread.joinable() )
+            m_drainthread.join();
+    }
+
+    std::ostream & AsyncLogger::Log()
+    {
+        return Log(eLogLevel::Info);
+    }
+
+    std::ostream & AsyncLogger::Log( eLogLevel lvl )
+    {
+        thread_log & tl = ThisThreadLog();
+        return ShouldLog(lvl)? tl.out : tl.nullout;
+    }
+
+    bool AsyncLogger::ShouldLog( eLogLevel lvl )const
+    {
+        return static_cast<int>(lvl) >= m_minlvl.load(memory_order_relaxed);
+    }
+
+    void AsyncLogger::SetMinLevel( eLogLevel lvl )
+    {
+        m_minlvl.store( static_cast<int>(lvl), memory_order_relaxed );
+    }
+
+    eLogLevel AsyncLogger::GetMinLevel()const
+    {
+        return static_cast<eLogLevel>( m_minlvl.load(memory_order_relaxed) );
+    }
+
+    void AsyncLogger::Flush()
+    {
+        Commit( ThisThreadLog() );
+
+        //Wait for a whole pass that started after this call
+        unique_lock<mutex> lk(m_drainmtx);
+        const uint64_t waitfor = m_nbpasses + 2;
+        m_bwake = true;
+        m_wakecv.notify_one();
+        m_passcv.wait( lk, [&](){ return m_nbpasses >= waitfor || !m_brunning.load(); } );
+    }
+
+    AsyncLogger::thread_log & AsyncLogger::ThisThreadLog()
+    {
+        if( s_logcache.loggerid == m_id )
+            return *static_cast<thread_log*>(s_logcache.plog);
+
+        lock_guard<mutex> lk(m_registrymtx);
+        const thread::id thid  = this_thread::get_id();
+        auto             itfnd = std::find_if( m_logs.begin(), m_logs.end(), [&](const unique_ptr<thread_log> & ptl){ return ptl->threadid == thid; } );
+        if( itfnd == m_logs.end() )
+        {
+            m_logs.push_back( unique_ptr<thread_log>( new thread_log(*this, m_ringsize) ) );
+            itfnd = std::prev( m_logs.end() );
+        }
+        s_logcache.loggerid = m_id;
+        s_logcache.plog     = itfnd->get();
+        return **itfnd;
+    }
+
+    void AsyncLogger::Commit( thread_log & tl )
+    {
+        if( tl.linelen == 0 )
+            return;
+
+        while( !tl.ring.TryPush( tl.line, static_cast<uint32_t>(tl.linelen) ) )
+        {
+            if( m_policy == eOverflowPolicy::Drop || !m_brunning.load(memory_order_relaxed) )
+            {
+                tl.nbdropped.fetch_add( 1, memory_order_relaxed );
+                m_nbdropped.fetch_add( 1, memory_order_relaxed );
+                break;
+            }
+            m_wakecv.notify_one();
+            this_thread::yield();
+        }
+        tl.linelen = 0;
+    }
+
+    void AsyncLogger::DrainLoop()
+    {
+        unique_lock<mutex> lk(m_drainmtx);
+        for(;;)
+        {
+            //Check before draining, so there's always a last pass after Stop()
+            const bool bstop = !m_brunning.load();
+            lk.unlock();
+            DrainAll();
+            lk.lock();
+
+            ++m_nbpasses;
+            m_passcv.notify_all();
+            if( bstop )
+                break;
+
+            m_wakecv.wait_for( lk, DrainInterval, [&](){ return m_bwake || !m_brunning.load(); } );
+            m_bwake = false;
+        }
+    }
+
+    bool AsyncLogger::DrainAll()
+    {
+        {
+            lock_guard<mutex> lk(m_registrymtx);
+            m_drainlist.resize(0);
+            for( auto & ptl : m_logs )
+                m_drainlist.push_back( ptl.get() );
+        }
+
+        bool bwroteany = false;
+        for( thread_log * ptl : m_drainlist )
+        {
+            bwroteany |= ptl->ring.DrainTo( *m_pout );
+
+            const uint64_t nbdropped = ptl->nbdropped.load(memory_order_relaxed);
+            if( nbdropped != ptl->nbdroppedreported )
+            {
+                (*m_pout) <<"<!>- AsyncLogger: Dropped " <<(nbdropped - ptl->nbdroppedreported) <<" record(s) from thread " <<ptl->threadid <<"!\n";
+                ptl->nbdroppedreported = nbdropped;
+                bwroteany = true;
+            }
+        }
+        if( bwroteany )
+            m_pout->flush();
+        return bwroteany;
+    }
+};
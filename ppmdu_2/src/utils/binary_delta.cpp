@@ -0,0 +1,217 @@
+#include <utils/binary_delta.hpp>
+#include <ppmdu/fmts/integer_encoding.hpp>
+#include <utils/trace_profiler.hpp>
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+using namespace std;
+
+namespace utils
+{
+//=========================================
+// Constants
+//=========================================
+    static const uint32_t BinaryDelta_HashBase = 0x01000193;    //Multiplier of the rolling hash
+    static const uint64_t BinaryDelta_HashMul  = 0x9E3779B97F4A7C15ull;
+
+//=========================================
+// Utility
+//=========================================
+    /*
+        Polynomial hash of a block, the same as the one rolling_hash keeps up to date.
+    */
+    inline uint32_t HashBlock( const uint8_t * pblock )
+    {
+        uint32_t hash = 0;
+        for( size_t i = 0; i < BinaryDelta_BlockLen; ++i )
+            hash = (hash * BinaryDelta_HashBase) + pblock[i];
+        return hash;
+    }
+
+    /*
+        Multiplier of the byte leaving the window, BinaryDelta_HashBase^(BinaryDelta_BlockLen-1).
+    */
+    inline uint32_t HashOutMultiplier()
+    {
+        uint32_t mul = 1;
+        for( size_t i = 1; i < BinaryDelta_BlockLen; ++i )
+            mul *= BinaryDelta_HashBase;
+        return mul;
+    }
+
+    inline void EncodeDeltaInt( uint64_t val, vector<uint8_t> & out )
+    {
+        EncodeAnInteger<uint64_t>( val, std::back_inserter(out) );
+    }
+
+//=========================================
+// Delta Making
+//=========================================
+    /*
+        Index of the blocks of the old file, by hash. Only the first block with a given
+        hash is kept, so runs of repeated data match their beginning, and extend from there.
+    */
+    class delta_block_index
+    {
+    public:
+        delta_block_index( const uint8_t * psrc, size_t srclen )
+        {
+            const size_t nbblocks = srclen / BinaryDelta_BlockLen;
+            size_t       tblsize  = 16;
+            m_shift = 64 - 4;
+            while( tblsize < nbblocks * 2 )
+            {
+                tblsize <<= 1;
+                --m_shift;
+            }
+            m_table.resize( tblsize, 0 );
+
+            for( size_t i = 0; i < nbblocks; ++i )
+            {
+                uint32_t & slot = m_table[Slot( HashBlock( psrc + (i * BinaryDelta_BlockLen) ) )];
+                if( slot == 0 )
+                    slot = static_cast<uint32_t>(i + 1);
+            }
+        }
+
+        /*
+            Returns the offset of the block in the old file, or -1 if there's none with that hash.
+        */
+        inline int64_t Find( uint32_t hash )const
+        {
+            const uint32_t entry = m_table[Slot(hash)];
+            return (entry != 0)? static_cast<int64_t>(entry - 1) * BinaryDelta_BlockLen : -1;
+        }
+
+    private:
+        inline size_t Slot( uint32_t hash )const
+        {
+            return static_cast<size_t>( (hash * BinaryDelta_HashMul) >> m_shift );
+        }
+
+        vector<uint32_t> m_table;   //Index of the block plus one, 0 when empty
+        unsigned int     m_shift;
+    };
+
+    std::vector<uint8_t> MakeBinaryDelta( const uint8_t * psrc, size_t srclen, const uint8_t * pdst, size_t dstlen )
+    {
+        TraceScope trace("MakeBinaryDelta");
+        if( srclen > numeric_limits<uint32_t>::max() * static_cast<uint64_t>(BinaryDelta_BlockLen) )
+            throw runtime_error("MakeBinaryDelta(): The source data is too large!");
+
+        vector<uint8_t> delta;
+        uint64_t        prevsrcend = 0;
+        EncodeDeltaInt( dstlen, delta );
+
+        auto lambdaliteral = [&]( size_t beg, size_t end )
+        {
+            if( end == beg )
+                return;
+            EncodeDeltaInt( static_cast<uint64_t>(end - beg) << 1, delta );
+            delta.insert( delta.end(), pdst + beg, pdst + end );
+        };
+
+        auto lambdacopy = [&]( uint64_t srcoff, uint64_t len )
+        {
+            const int64_t dist = static_cast<int64_t>(srcoff) - static_cast<int64_t>(prevsrcend);
+            EncodeDeltaInt( (len << 1) | 1, delta );
+            EncodeDeltaInt( (static_cast<uint64_t>(dist) << 1) ^ static_cast<uint64_t>(dist >> 63), delta );
+            prevsrcend = srcoff + len;
+        };
+
+        size_t pos    = 0;
+        size_t litbeg = 0;
+        if( srclen >= BinaryDelta_BlockLen && dstlen >= BinaryDelta_BlockLen )
+        {
+            const delta_block_index index(psrc, srclen);
+            const uint32_t          outmul = HashOutMultiplier();
+            uint32_t                hash   = HashBlock(pdst);
+
+            while( pos + BinaryDelta_BlockLen <= dstlen )
+            {
+                const int64_t srcoff = index.Find(hash);
+                if( srcoff >= 0 && std::memcmp( psrc + srcoff, pdst + pos, BinaryDelta_BlockLen ) == 0 )
+                {
+                    //Grow the match both ways, backward only over the bytes not encoded yet
+                    const size_t maxfwd = std::min<size_t>( srclen - static_cast<size_t>(srcoff), dstlen - pos );
+                    size_t       fwd    = BinaryDelta_BlockLen;
+                    while( fwd < maxfwd && psrc[srcoff + fwd] == pdst[pos + fwd] )
+                        ++fwd;
+
+                    const size_t maxback = std::min<size_t>( pos - litbeg, static_cast<size_t>(srcoff) );
+                    size_t       back    = 0;
+                    while( back < maxback && psrc[srcoff - back - 1] == pdst[pos - back - 1] )
+                        ++back;
+
+                    lambdaliteral( litbeg, pos - back );
+                    lambdacopy( static_cast<uint64_t>(srcoff) - back, fwd + back );
+                    pos   += fwd;
+                    litbeg = pos;
+                    if( pos + BinaryDelta_BlockLen <= dstlen )
+                        hash = HashBlock(pdst + pos);
+                    continue;
+                }
+
+                if( pos + BinaryDelta_BlockLen < dstlen )
+                    hash = ((hash - (pdst[pos] * outmul)) * BinaryDelta_HashBase) + pdst[pos + BinaryDelta_BlockLen];
+                ++pos;
+            }
+        }
+        lambdaliteral( litbeg, dstlen );
+        return delta;
+    }
+
+//=========================================
+// Delta Applying
+//=========================================
+    std::vector<uint8_t> ApplyBinaryDelta( const uint8_t * psrc, size_t srclen, const uint8_t * pdelta, size_t deltalen )
+    {
+        TraceScope      trace("ApplyBinaryDelta");
+        const uint8_t * pcur = pdelta;
+        const uint8_t * pend = pdelta + deltalen;
+        vector<uint8_t> result;
+        try
+        {
+            const uint64_t dstlen = DecodeAnInteger<uint64_t>( pcur, pend );
+            if( dstlen > numeric_limits<uint32_t>::max() )
+                throw runtime_error("The output would be " + to_string(dstlen) + " bytes long!");
+            result.reserve( static_cast<size_t>(dstlen) );
+
+            uint64_t prevsrcend = 0;
+            while( result.size() < dstlen )
+            {
+                const uint64_t op  = DecodeAnInteger<uint64_t>( pcur, pend );
+                const uint64_t len = op >> 1;
+                if( len == 0 || len > dstlen - result.size() )
+                    throw runtime_error("Operation at offset " + to_string(pcur - pdelta) + " has an invalid length!");
+
+                if( (op & 1) != 0 )
+                {
+                    const uint64_t zigzag = DecodeAnInteger<uint64_t>( pcur, pend );
+                    const uint64_t srcoff = prevsrcend + ((zigzag >> 1) ^ (0 - (zigzag & 1)));
+                    if( srcoff > srclen || len > srclen - srcoff )
+                        throw runtime_error("Copy at offset " + to_string(pcur - pdelta) + " is out of the source data!");
+                    result.insert( result.end(), psrc + srcoff, psrc + srcoff + len );
+                    prevsrcend = srcoff + len;
+                }
+                else
+                {
+                    if( len > static_cast<uint64_t>(pend - pcur) )
+                        throw runtime_error("Literal at offset " + to_string(pcur - pdelta) + " goes past the end of the delta!");
+                    result.insert( result.end(), pcur, pcur + len );
+                    pcur += len;
+                }
+            }
+
+            if( pcur != pend )
+                throw runtime_error("There are " + to_string(pend - pcur) + " bytes left after the last operation!");
+        }
+        catch( const std::exception & )
+        {
+            throw_with_nested( runtime_error("ApplyBinaryDelta(): The delta is corrupted!") );
+        }
+        return result;
+    }
+};
@@ -0,0 +1,578 @@
+#include <utils/file_sink.hpp>
+#include <utils/poco_wrapper.hpp>
+#include <utils/trace_profiler.hpp>
+#include <utils/virtual_fs.hpp>
+#include <algorithm>
+#include <atomic>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#ifdef _WIN32
+    #include <fstream>
+#else
+    #include <cerrno>
+    #include <cstring>
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+    #include <linux/io_uring.h>
+    #include <sys/mman.h>
+    #include <sys/syscall.h>
+    #include <sys/uio.h>
+    #if defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter)
+        #define PPMDU_FILESINK_IOURING
+    #endif
+#endif
+using namespace std;
+
+namespace utils{ namespace io
+{
+    static TraceCounter SinkFilesWritten("sink files written");
+
+    /*
+        Reason for the last failed system call.
+    */
+    static string LastErrorStr()
+    {
+#ifdef _WIN32
+        return "I/O error";
+#else
+        return strerror(errno);
+#endif
+    }
+
+//=========================================================================================
+//  Blocking Backend
+//=========================================================================================
+    /*
+        Writes the files one after the other. Used when io_uring isn't available, and by the
+        io_uring backend for the files it couldn't write itself.
+    */
+    class FileSink::backend_t
+    {
+    public:
+        virtual ~backend_t(){}
+
+        virtual bool IsIoUring()const { return false; }
+
+        /*
+            Writes all the files, and puts an error message in out_errors for each that failed.
+        */
+        virtual void WriteBatch( vector<job_t> & batch, vector<string> & out_errors )
+        {
+            for( const job_t & job : batch )
+            {
+                try
+                {
+                    WriteFileBlocking( job );
+                    SinkFilesWritten.Add(1);
+                }
+                catch( const exception & e )
+                {
+                    out_errors.push_back( e.what() );
+                }
+            }
+        }
+
+    protected:
+        static void WriteFileBlocking( const job_t & job )
+        {
+#ifdef _WIN32
+            ofstream outputfile( job.path, ios::binary );
+            if( !outputfile )
+                throw runtime_error( "\"" + job.path + "\" : couldn't open the file!" );
+            outputfile.write( reinterpret_cast<const char*>(job.data.data()), job.data.size() );
+            outputfile.close();
+            if( !outputfile )
+                throw runtime_error( "\"" + job.path + "\" : couldn't write the file!" );
+#else
+            int fd = OpenForWriting(job.path);
+            if( fd == -1 )
+                throw runtime_error( "\"" + job.path + "\" : " + LastErrorStr() );
+
+            size_t done = 0;
+            while( done < job.data.size() )
+            {
+                const ssize_t ret = ::write( fd, job.data.data() + done, job.data.size() - done );
+                if( ret < 0 && errno == EINTR )
+                    continue;
+                if( ret <= 0 )
+                {
+                    const string err = LastErrorStr();
+                    ::close(fd);
+                    throw runtime_error( "\"" + job.path + "\" : " + err );
+                }
+                done += static_cast<size_t>(ret);
+            }
+
+            //Network filesystems report write errors on close
+            if( ::close(fd) != 0 )
+                throw runtime_error( "\"" + job.path + "\" : " + LastErrorStr() );
+#endif
+        }
+
+#ifndef _WIN32
+        static int OpenForWriting( const string & path )
+        {
+            int fd = -1;
+            do
+            {
+                fd = ::open( path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666 );
+            }while( fd == -1 && errno == EINTR );
+            return fd;
+        }
+#endif
+    };
+
+//=========================================================================================
+//  io_uring Backend
+//=========================================================================================
+#ifdef PPMDU_FILESINK_IOURING
+    /*
+        Submits the writes of a whole batch to the kernel with a single system call, and waits
+        for them all to complete. The ring is set up directly through the system calls, so it
+        doesn't need liburing.
+        Files are opened and closed the usual way, only the writes go through the ring.
+    */
+    class uring_backend : public FileSink::backend_t
+    {
+        static constexpr unsigned RingLen     = 64;
+        static constexpr size_t   MaxWriteLen = 0x7FFFF000;    //The most a single write may write on Linux
+
+        //Where each file of the batch is at
+        struct filestate_t
+        {
+            int    fd        = -1;
+            size_t done      = 0;
+            bool   binflight = false;
+            bool   bfinished = false;
+            iovec  iov       = {};
+        };
+
+    public:
+        /*
+            Returns null if the kernel doesn't support io_uring, or it's disabled.
+        */
+        static unique_ptr<FileSink::backend_t> TryMake()
+        {
+            unique_ptr<uring_backend> pbackend( new uring_backend );
+            if( !pbackend->Setup() )
+                return nullptr;
+            return pbackend;
+        }
+
+        ~uring_backend()
+        {
+            Teardown();
+        }
+
+        bool IsIoUring()const override { return m_ringfd != -1; }
+
+        void WriteBatch( vector<FileSink::job_t> & batch, vector<string> & out_errors )override
+        {
+            if( m_ringfd == -1 )
+            {
+                backend_t::WriteBatch( batch, out_errors );
+                return;
+            }
+
+            vector<filestate_t> states( batch.size() );
+            size_t              remaining = 0;
+            for( size_t i = 0; i < batch.size(); ++i )
+            {
+                states[i].fd = OpenForWriting( batch[i].path );
+                if( states[i].fd == -1 )
+                {
+                    out_errors.push_back( "\"" + batch[i].path + "\" : " + LastErrorStr() );
+                    states[i].bfinished = true;
+                }
+                else if( batch[i].data.empty() )
+                    states[i].bfinished = true;
+                else
+                    ++remaining;
+            }
+
+            try
+            {
+                while( remaining > 0 )
+                    remaining -= SubmitAndWait( batch, states, out_errors );
+            }
+            catch( const exception & e )
+            {
+                //The ring is unusable. Write what's left the usual way, and stop using it.
+                clog << "<!>- FileSink: " << e.what() << " Falling back to blocking writes.\n";
+                Teardown();
+                for( size_t i = 0; i < batch.size(); ++i )
+                {
+                    if( states[i].bfinished )
+                        continue;
+                    states[i].bfinished = true;
+                    try
+                    {
+                        ::close(states[i].fd);
+                        states[i].fd = -1;
+                        WriteFileBlocking( batch[i] );
+                        SinkFilesWritten.Add(1);
+                    }
+                    catch( const exception & e )
+                    {
+                        out_errors.push_back( e.what() );
+                    }
+                }
+            }
+
+            //Network filesystems report write errors on close
+            for( size_t i = 0; i < batch.size(); ++i )
+            {
+                if( states[i].fd == -1 )
+                    continue;
+                if( ::close(states[i].fd) != 0 )
+                    out_errors.push_back( "\"" + batch[i].path + "\" : " + LastErrorStr() );
+                else if( states[i].done == batch[i].data.size() )
+                    SinkFilesWritten.Add(1);
+            }
+        }
+
+    private:
+        uring_backend(){}
+
+        bool Setup()
+        {
+            io_uring_params params;
+            std::memset( &params, 0, sizeof(params) );
+            const int fd = static_cast<int>( ::syscall( __NR_io_uring_setup, RingLen, &params ) );
+            if( fd < 0 )
+                return false;
+            m_ringfd = fd;
+
+            m_sqringlen = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+            m_cqringlen = params.cq_off.cqes  + params.cq_entries * sizeof(io_uring_cqe);
+            const bool bsinglemap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+            if( bsinglemap )
+                m_sqringlen = m_cqringlen = std::max( m_sqringlen, m_cqringlen );
+
+            m_psqring = ::mmap( nullptr, m_sqringlen, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING );
+            if( m_psqring == MAP_FAILED )
+            {
+                m_psqring = nullptr;
+                Teardown();
+                return false;
+            }
+            if( bsinglemap )
+                m_pcqring = m_psqring;
+            else
+            {
+                m_pcqring = ::mmap( nullptr, m_cqringlen, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING );
+                if( m_pcqring == MAP_FAILED )
+                {
+                    m_pcqring = nullptr;
+                    Teardown();
+                    return false;
+                }
+            }
+            m_sqeslen = params.sq_entries * sizeof(io_uring_sqe);
+            void * psqes = ::mmap( nullptr, m_sqeslen, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES );
+            if( psqes == MAP_FAILED )
+            {
+                Teardown();
+                return false;
+            }
+            m_psqes = static_cast<io_uring_sqe*>(psqes);
+
+            uint8_t * psq = static_cast<uint8_t*>(m_psqring);
+            uint8_t * pcq = static_cast<uint8_t*>(m_pcqring);
+            m_psqtail  = reinterpret_cast<unsigned*>( psq + params.sq_off.tail );
+            m_sqmask   = *reinterpret_cast<unsigned*>( psq + params.sq_off.ring_mask );
+            m_psqarray = reinterpret_cast<unsigned*>( psq + params.sq_off.array );
+            m_sqlen    = params.sq_entries;
+            m_pcqhead  = reinterpret_cast<unsigned*>( pcq + params.cq_off.head );
+            m_pcqtail  = reinterpret_cast<unsigned*>( pcq + params.cq_off.tail );
+            m_cqmask   = *reinterpret_cast<unsigned*>( pcq + params.cq_off.ring_mask );
+            m_pcqes    = reinterpret_cast<io_uring_cqe*>( pcq + params.cq_off.cqes );
+            return true;
+        }
+
+        void Teardown()
+        {
+            if( m_psqes != nullptr )
+                ::munmap( m_psqes, m_sqeslen );
+            if( m_pcqring != nullptr && m_pcqring != m_psqring )
+                ::munmap( m_pcqring, m_cqringlen );
+            if( m_psqring != nullptr )
+                ::munmap( m_psqring, m_sqringlen );
+            if( m_ringfd != -1 )
+                ::close( m_ringfd );
+            m_psqes   = nullptr;
+            m_pcqring = nullptr;
+            m_psqring = nullptr;
+            m_ringfd  = -1;
+        }
+
+        /*
+            Queues a write for each file that still has data left, as many as the ring fits,
+            then submits them and waits for all of them. Short writes are queued again on the
+            next call. Returns the number of files that were finished, or failed.
+        */
+        size_t SubmitAndWait( vector<FileSink::job_t> & batch, vector<filestate_t> & states, vector<string> & out_errors )
+        {
+            unsigned tail   = *m_psqtail;     //Only this thread writes the tail
+            unsigned queued = 0;
+            for( size_t i = 0; i < states.size() && queued < m_sqlen; ++i )
+            {
+                filestate_t & st = states[i];
+                if( st.bfinished || st.binflight )
+                    continue;
+
+                st.iov.iov_base = batch[i].data.data() + st.done;
+                st.iov.iov_len  = std::min( batch[i].data.size() - st.done, MaxWriteLen );
+
+                const unsigned  index = tail & m_sqmask;
+                io_uring_sqe  & sqe   = m_psqes[index];
+                std::memset( &sqe, 0, sizeof(sqe) );
+                sqe.opcode    = IORING_OP_WRITEV;
+                sqe.fd        = st.fd;
+                sqe.addr      = reinterpret_cast<uint64_t>( &st.iov );
+                sqe.len       = 1;
+                sqe.off       = st.done;
+                sqe.user_data = i;
+                m_psqarray[index] = index;
+                st.binflight  = true;
+                ++tail;
+                ++queued;
+            }
+            std::atomic_ref<unsigned>(*m_psqtail).store( tail, std::memory_order_release );
+
+            size_t   nbfinished = 0;
+            unsigned tosubmit   = queued;
+            unsigned towait     = queued;
+            while( towait > 0 )
+            {
+                const int ret = static_cast<int>( ::syscall( __NR_io_uring_enter, m_ringfd, tosubmit, 1, IORING_ENTER_GETEVENTS, nullptr, 0 ) );
+                if( ret < 0 )
+                {
+                    if( errno == EINTR || errno == EAGAIN || errno == EBUSY )
+                        continue;
+                    throw runtime_error( "io_uring_enter failed : " + LastErrorStr() + "." );
+                }
+                tosubmit -= std::min( static_cast<unsigned>(ret), tosubmit );
+
+                unsigned       head    = std::atomic_ref<unsigned>(*m_pcqhead).load( std::memory_order_relaxed );
+                const unsigned cqtail  = std::atomic_ref<unsigned>(*m_pcqtail).load( std::memory_order_acquire );
+                for( ; head != cqtail; ++head, --towait )
+                {
+                    const io_uring_cqe & cqe = m_pcqes[head & m_cqmask];
+                    filestate_t        & st  = states[static_cast<size_t>(cqe.user_data)];
+                    st.binflight = false;
+
+                    if( cqe.res <= 0 )
+                    {
+                        out_errors.push_back( "\"" + batch[static_cast<size_t>(cqe.user_data)].path + "\" : " +
+                                              ((cqe.res < 0)? string(strerror(-cqe.res)) : string("nothing was written")) );
+                        st.bfinished = true;
+                        st.done      = 0;
+                        ++nbfinished;
+                        continue;
+                    }
+
+                    st.done += static_cast<size_t>(cqe.res);
+                    if( st.done == batch[static_cast<size_t>(cqe.user_data)].data.size() )
+                    {
+                        st.bfinished = true;
+                        ++nbfinished;
+                    }
+                }
+                std::atomic_ref<unsigned>(*m_pcqhead).store( head, std::memory_order_release );
+            }
+            return nbfinished;
+        }
+
+    private:
+        int            m_ringfd    = -1;
+        void         * m_psqring   = nullptr;
+        void         * m_pcqring   = nullptr;
+        size_t         m_sqringlen = 0;
+        size_t         m_cqringlen = 0;
+        size_t         m_sqeslen   = 0;
+        io_uring_sqe * m_psqes     = nullptr;
+        unsigned     * m_psqtail   = nullptr;
+        unsigned     * m_psqarray  = nullptr;
+        unsigned       m_sqmask    = 0;
+        unsigned       m_sqlen     = 0;
+        unsigned     * m_pcqhead   = nullptr;
+        unsigned     * m_pcqtail   = nullptr;
+        unsigned       m_cqmask    = 0;
+        io_uring_cqe * m_pcqes     = nullptr;
+    };
+#endif
+
+    static unique_ptr<FileSink::backend_t> MakeSinkBackend()
+    {
+#ifdef PPMDU_FILESINK_IOURING
+        unique_ptr<FileSink::backend_t> puring = uring_backend::TryMake();
+        if( puring )
+            return puring;
+#endif
+        return unique_ptr<FileSink::backend_t>( new FileSink::backend_t );
+    }
+
+//=========================================================================================
+//  FileSink
+//=========================================================================================
+    FileSink::FileSink( size_t maxinflight, size_t batchlen, size_t nbwriters )
+        :m_inflight(0), m_nbpending(0), m_maxinflight(maxinflight), m_batchlen( std::max<size_t>(batchlen, 1) ), m_bexit(false)
+    {
+        nbwriters = std::max<size_t>( nbwriters, 1 );
+        for( size_t i = 0; i < nbwriters; ++i )
+            m_backends.push_back( MakeSinkBackend() );
+
+        try
+        {
+            for( size_t i = 0; i < nbwriters; ++i )
+                m_writers.push_back( std::thread( &FileSink::WriterThread, this, std::ref(*m_backends[i]) ) );
+        }
+        catch( ... )
+        {
+            {
+                lock_guard<mutex> lck(m_mtx);
+                m_bexit = true;
+            }
+            m_cvjobs.notify_all();
+            for( auto & writer : m_writers )
+                writer.join();
+            throw;
+        }
+    }
+
+    FileSink::~FileSink()
+    {
+        {
+            lock_guard<mutex> lck(m_mtx);
+            m_bexit = true;
+        }
+        m_cvjobs.notify_all();
+        for( auto & writer : m_writers )
+            writer.join();
+
+        for( const auto & err : m_errors )
+            cerr << "<!>- FileSink::~FileSink(): Couldn't write " << err << "\n";
+    }
+
+    void FileSink::Write( const std::string & path, std::vector<uint8_t> && data )
+    {
+        if( WriteToVirtualFS( path, data.data(), data.size() ) )
+            return;
+
+        const size_t sep = path.find_last_of("/\\");
+        if( sep != string::npos && sep > 0 )
+            PrepareDirectory( path.substr(0, sep) );
+
+        const size_t len = data.size();
+        {
+            unique_lock<mutex> lck(m_mtx);
+            //Let a single file over the cap through when nothing else is queued, or it would wait forever
+            m_cvdone.wait( lck, [&](){ return m_inflight == 0 || (m_inflight + len) <= m_maxinflight; } );
+            m_inflight += len;
+            ++m_nbpending;
+            m_jobs.push_back( job_t{ path, std::move(data) } );
+        }
+        m_cvjobs.notify_one();
+    }
+
+    void FileSink::PrepareDirectory( const std::string & dirpath )
+    {
+        lock_guard<mutex> lck(m_dirmtx);
+        CreateDirectories(dirpath);
+    }
+
+    void FileSink::CreateDirectories( const std::string & dirpath )
+    {
+        string dir = dirpath;
+        while( !dir.empty() && (dir.back() == '/' || dir.back() == '\\') )
+            dir.pop_back();
+        if( dir.empty() || m_knowndirs.count(dir) != 0 )
+            return;
+
+        if( !utils::isFolder(dir) )
+        {
+            const size_t sep = dir.find_last_of("/\\");
+            if( sep != string::npos && sep > 0 )
+                CreateDirectories( dir.substr(0, sep) );
+            if( !utils::DoCreateDirectory(dir) && !utils::isFolder(dir) )
+                throw runtime_error( "FileSink::PrepareDirectory(): Couldn't create directory \"" + dir + "\"!" );
+        }
+        m_knowndirs.insert( std::move(dir) );
+    }
+
+    void FileSink::Flush()
+    {
+        TraceScope     trace("FileSink::Flush");
+        vector<string> errors;
+        {
+            unique_lock<mutex> lck(m_mtx);
+            m_cvdone.wait( lck, [&](){ return m_nbpending == 0; } );
+            errors.swap(m_errors);
+        }
+
+        if( !errors.empty() )
+        {
+            static const size_t MaxListed = 10;
+            stringstream sstr;
+            sstr << "FileSink::Flush(): Couldn't write " << errors.size() << " file(s)!";
+            for( size_t i = 0; i < errors.size() && i < MaxListed; ++i )
+                sstr << "\n\t" << errors[i];
+            if( errors.size() > MaxListed )
+                sstr << "\n\t...";
+            throw runtime_error( sstr.str() );
+        }
+    }
+
+    bool FileSink::UsesIoUring()const
+    {
+        return !m_backends.empty() && m_backends.front()->IsIoUring();
+    }
+
+    void FileSink::WriterThread( backend_t & backend )
+    {
+        if( Profiler().IsEnabled() )
+            Profiler().SetThreadName("file sink");
+
+        vector<job_t>  batch;
+        vector<string> errors;
+        batch.reserve(m_batchlen);
+        for(;;)
+        {
+            {
+                unique_lock<mutex> lck(m_mtx);
+                m_cvjobs.wait( lck, [&](){ return m_bexit || !m_jobs.empty(); } );
+                if( m_jobs.empty() )
+                    return; //Only exit once everything was written
+
+                while( !m_jobs.empty() && batch.size() < m_batchlen )
+                {
+                    batch.push_back( std::move(m_jobs.front()) );
+                    m_jobs.pop_front();
+                }
+            }
+
+            size_t batchbytes = 0;
+            for( const auto & job : batch )
+                batchbytes += job.data.size();
+
+            {
+                TraceScope trace("FileSink batch");
+                backend.WriteBatch( batch, errors );
+            }
+
+            {
+                lock_guard<mutex> lck(m_mtx);
+                m_inflight  -= batchbytes;
+                m_nbpending -= batch.size();
+                m_errors.insert( m_errors.end(), errors.begin(), errors.end() );
+            }
+            m_cvdone.notify_all();
+            batch.clear();
+            errors.clear();
+        }
+    }
+};};
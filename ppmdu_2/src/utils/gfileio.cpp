@@ -1,15 +1,104 @@
 #include <utils/gfileio.hpp>
+#include <utils/trace_profiler.hpp>
+#include <utils/virtual_fs.hpp>
 #include <cassert>
 #include <iostream>
 #include <fstream>
 #include <sstream>
 #include <exception>
+#ifdef _WIN32
+    #ifndef NOMINMAX
+        #define NOMINMAX
+    #endif
+    #ifndef WIN32_LEAN_AND_MEAN
+        #define WIN32_LEAN_AND_MEAN
+    #endif
+    #include <windows.h>
+#else
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
 using namespace std;
 
 namespace utils{ namespace io
 {
+    static TraceCounter FilesWritten("files written");
+
+    /*
+        Looks for the file in the mounted VirtualFS. Returns null if it's not in one.
+    */
+    static shared_ptr<const VirtualFS> FindVirtualFile( const std::string & path, const uint8_t *& out_pdata, size_t & out_len )
+    {
+        string                      relpath;
+        shared_ptr<const VirtualFS> pvfs = FindVirtualFS( path, relpath );
+        if( pvfs && pvfs->GetFile( relpath, out_pdata, out_len ) )
+            return pvfs;
+        return nullptr;
+    }
+
+    /*
+        Read-only stream buffer over a block of memory, that supports seeking.
+    */
+    class membuf_istream : public std::istream
+    {
+        class seekable_membuf : public std::streambuf
+        {
+        public:
+            seekable_membuf( const uint8_t * pdata, size_t len )
+            {
+                char * pbeg = const_cast<char*>( reinterpret_cast<const char*>(pdata) ); //The get area is never written to
+                setg( pbeg, pbeg, pbeg + len );
+            }
+
+        protected:
+            pos_type seekoff( off_type off, ios_base::seekdir dir, ios_base::openmode which )override
+            {
+                if( (which & ios_base::in) == 0 )
+                    return pos_type(off_type(-1));
+
+                off_type base = 0;
+                if( dir == ios_base::cur )
+                    base = gptr() - eback();
+                else if( dir == ios_base::end )
+                    base = egptr() - eback();
+
+                const off_type newpos = base + off;
+                if( newpos < 0 || newpos > (egptr() - eback()) )
+                    return pos_type(off_type(-1));
+                setg( eback(), eback() + newpos, egptr() );
+                return pos_type(newpos);
+            }
+
+            pos_type seekpos( pos_type pos, ios_base::openmode which )override
+            {
+                return seekoff( off_type(pos), ios_base::beg, which );
+            }
+        };
+
+    public:
+        membuf_istream( shared_ptr<const VirtualFS> && powner, const uint8_t * pdata, size_t len )
+            :std::istream(nullptr), m_buf(pdata, len), m_powner(std::move(powner))
+        {
+            rdbuf(&m_buf);
+        }
+
+    private:
+        seekable_membuf             m_buf;
+        shared_ptr<const VirtualFS> m_powner;
+    };
+
     void ReadFileToByteVector(const std::string & path, std::vector<uint8_t> & out_filedata)
     {
+        const uint8_t * pvdata = nullptr;
+        size_t          vlen   = 0;
+        if( FindVirtualFile( path, pvdata, vlen ) )
+        {
+            out_filedata.assign( pvdata, pvdata + vlen );
+            return;
+        }
+
         ifstream inputfile(path, ios::in | ios::binary | ios::ate); //ate : Opens the file, with the read pos at the end, to allow getting the file size
 
         if (!inputfile)
@@ -35,7 +124,7 @@ namespace utils{ namespace io
     {
         std::vector<uint8_t> output;
         ReadFileToByteVector(path, output);
-        return std::move( output );
+        return output;
     }
 
     /*
@@ -44,6 +133,12 @@ namespace utils{ namespace io
     */
     void WriteByteVectorToFile(const std::string & path, const std::vector<uint8_t> & filedata)
     {
+        if( WriteToVirtualFS( path, filedata.data(), filedata.size() ) )
+        {
+            FilesWritten.Add(1);
+            return;
+        }
+
         ofstream outputfile(path, ios::binary);
         outputfile.exceptions( ofstream::badbit );
 
@@ -55,6 +150,146 @@ namespace utils{ namespace io
         }
 
         outputfile.write(reinterpret_cast<const char*>(filedata.data()), filedata.size());
+        FilesWritten.Add(1);
+    }
+
+//
+//  MappedFile
+//
+    MappedFile::MappedFile( const std::string & path )
+    {
+        Open(path);
+    }
+
+    MappedFile::MappedFile( MappedFile && mv )
+        :m_pdata(mv.m_pdata), m_size(mv.m_size), m_pvfs(std::move(mv.m_pvfs))
+    {
+        mv.m_pdata = nullptr;
+        mv.m_size  = 0;
+    }
+
+    MappedFile & MappedFile::operator=( MappedFile && mv )
+    {
+        if( this != &mv )
+        {
+            Close();
+            m_pdata    = mv.m_pdata;
+            m_size     = mv.m_size;
+            m_pvfs     = std::move(mv.m_pvfs);
+            mv.m_pdata = nullptr;
+            mv.m_size  = 0;
+        }
+        return *this;
+    }
+
+    MappedFile::~MappedFile()
+    {
+        Close();
+    }
+
+    void MappedFile::Open( const std::string & path )
+    {
+        Close();
+        const uint8_t * pvdata = nullptr;
+        size_t          vlen   = 0;
+        m_pvfs = FindVirtualFile( path, pvdata, vlen );
+        if( m_pvfs )
+        {
+            m_pdata = pvdata;
+            m_size  = vlen;
+            return;
+        }
+
+        //The file and mapping handles can be closed as soon as the view exists, the view keeps the mapping alive.
+#ifdef _WIN32
+        HANDLE hfile = CreateFileA( path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr );
+        if( hfile == INVALID_HANDLE_VALUE )
+            throw runtime_error( "MappedFile::Open() : impossible to open file \"" + path + "\"!" );
+
+        LARGE_INTEGER fsize;
+        if( !GetFileSizeEx( hfile, &fsize ) )
+        {
+            CloseHandle(hfile);
+            throw runtime_error( "MappedFile::Open() : couldn't get the size of file \"" + path + "\"!" );
+        }
+        if( fsize.QuadPart == 0 )
+        {
+            CloseHandle(hfile);
+            return;
+        }
+
+        HANDLE hmap = CreateFileMappingA( hfile, nullptr, PAGE_READONLY, 0, 0, nullptr );
+        CloseHandle(hfile);
+        if( hmap == nullptr )
+            throw runtime_error( "MappedFile::Open() : couldn't create a file mapping for \"" + path + "\"!" );
+
+        const void * pview = MapViewOfFile( hmap, FILE_MAP_READ, 0, 0, 0 );
+        CloseHandle(hmap);
+        if( pview == nullptr )
+            throw runtime_error( "MappedFile::Open() : couldn't map file \"" + path + "\"!" );
+
+        m_pdata = static_cast<const uint8_t*>(pview);
+        m_size  = static_cast<size_t>(fsize.QuadPart);
+#else
+        int fd = ::open( path.c_str(), O_RDONLY );
+        if( fd == -1 )
+            throw runtime_error( "MappedFile::Open() : impossible to open file \"" + path + "\"!" );
+
+        struct stat fstats;
+        if( ::fstat( fd, &fstats ) != 0 )
+        {
+            ::close(fd);
+            throw runtime_error( "MappedFile::Open() : couldn't get the size of file \"" + path + "\"!" );
+        }
+        if( fstats.st_size == 0 )
+        {
+            ::close(fd);
+            return;
+        }
+
+        void * pview = ::mmap( nullptr, static_cast<size_t>(fstats.st_size), PROT_READ, MAP_PRIVATE, fd, 0 );
+        ::close(fd);
+        if( pview == MAP_FAILED )
+            throw runtime_error( "MappedFile::Open() : couldn't map file \"" + path + "\"!" );
+
+        ::madvise( pview, static_cast<size_t>(fstats.st_size), MADV_SEQUENTIAL );
+        m_pdata = static_cast<const uint8_t*>(pview);
+        m_size  = static_cast<size_t>(fstats.st_size);
+#endif
+    }
+
+    void MappedFile::Close()
+    {
+        if( m_pvfs )
+        {
+            m_pvfs.reset();
+            m_pdata = nullptr;
+            m_size  = 0;
+            return;
+        }
+        if( m_pdata == nullptr )
+            return;
+#ifdef _WIN32
+        UnmapViewOfFile( m_pdata );
+#else
+        ::munmap( const_cast<uint8_t*>(m_pdata), m_size );
+#endif
+        m_pdata = nullptr;
+        m_size  = 0;
+    }
+
+    std::unique_ptr<std::istream> OpenInputFile( const std::string & path )
+    {
+        const uint8_t *             pvdata = nullptr;
+        size_t                      vlen   = 0;
+        shared_ptr<const VirtualFS> pvfs   = FindVirtualFile( path, pvdata, vlen );
+        if( pvfs )
+            return unique_ptr<istream>( new membuf_istream( std::move(pvfs), pvdata, vlen ) );
+
+        unique_ptr<ifstream> pinf( new ifstream( path, ios::in | ios::binary ) );
+        if( !pinf->is_open() || pinf->bad() )
+            throw runtime_error( "OpenInputFile() : impossible to open file \"" + path + "\"!" );
+        return pinf;
     }
 
     std::vector<std::string> ReadTextFileLineByLine( const std::string & filepath, const std::locale & txtloc )
@@ -79,7 +314,7 @@ namespace utils{ namespace io
             stringlist.push_back(tmp);
         }
 
-        return std::move(stringlist);
+        return stringlist;
     }
 
     void WriteTextFileLineByLine( const std::vector<std::string> & data, const std::string & filepath, const std::locale & txtloc )
@@ -0,0 +1,197 @@
+#include <utils/local_server.hpp>
+#include <utils/library_wide.hpp>
+#include <iostream>
+#include <stdexcept>
+#include <cstring>
+#include <cerrno>
+#ifndef _WIN32
+    #include <sys/socket.h>
+    #include <sys/stat.h>
+    #include <sys/un.h>
+    #include <unistd.h>
+#endif
+using namespace std;
+
+namespace utils
+{
+    //Reject lines longer than this, so a misbehaving client can't make us buffer forever
+    static const size_t LocalServer_MaxLineLen = 64 * 1024;
+
+#ifndef _WIN32
+    inline string ErrnoStr()
+    {
+        return string(strerror(errno));
+    }
+
+    inline bool SendAll( int fd, const string & data )
+    {
+        size_t sent = 0;
+        while( sent < data.size() )
+        {
+    #ifdef MSG_NOSIGNAL
+            ssize_t res = ::send( fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL );
+    #else
+            ssize_t res = ::send( fd, data.data() + sent, data.size() - sent, 0 );
+    #endif
+            if( res < 0 && errno == EINTR )
+                continue;
+            if( res <= 0 )
+                return false;
+            sent += static_cast<size_t>(res);
+        }
+        return true;
+    }
+
+    //Returns whether something accepts connections on the socket at the specified address
+    inline bool IsSocketLive( const sockaddr_un & addr )
+    {
+        int probefd = ::socket( AF_UNIX, SOCK_STREAM, 0 );
+        if( probefd < 0 )
+            throw runtime_error("LocalLineServer::LocalLineServer(): Couldn't create socket! " + ErrnoStr());
+
+        //A stale socket refuses the connection, a live one accepts it
+        const bool blive = ::connect( probefd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr) ) == 0;
+        ::close(probefd);
+        return blive;
+    }
+
+    LocalLineServer::LocalLineServer( const std::string & sockpath )
+        :m_sockpath(sockpath), m_listenfd(-1)
+    {
+        sockaddr_un addr;
+        memset( &addr, 0, sizeof(addr) );
+        addr.sun_family = AF_UNIX;
+        if( sockpath.empty() || sockpath.size() >= sizeof(addr.sun_path) )
+            throw runtime_error("LocalLineServer::LocalLineServer(): Socket path is empty or too long! \"" + sockpath + "\"");
+        memcpy( addr.sun_path, sockpath.c_str(), sockpath.size() );
+
+        //Remove a stale socket left behind by a previous instance, but never anything else,
+        // and never a socket another instance is still listening on.
+        struct stat st;
+        if( ::lstat( sockpath.c_str(), &st ) == 0 )
+        {
+            if( !S_ISSOCK(st.st_mode) )
+                throw runtime_error("LocalLineServer::LocalLineServer(): Path exists and isn't a socket! \"" + sockpath + "\"");
+            if( IsSocketLive(addr) )
+                throw runtime_error("LocalLineServer::LocalLineServer(): Another server is already listening on \"" + sockpath + "\"!");
+            ::unlink( sockpath.c_str() );
+        }
+
+        m_listenfd = ::socket( AF_UNIX, SOCK_STREAM, 0 );
+        if( m_listenfd < 0 )
+            throw runtime_error("LocalLineServer::LocalLineServer(): Couldn't create socket! " + ErrnoStr());
+
+        if( ::bind( m_listenfd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr) ) != 0 || ::listen( m_listenfd, 8 ) != 0 )
+        {
+            const string err = ErrnoStr();
+            ::close(m_listenfd);
+            m_listenfd = -1;
+            throw runtime_error("LocalLineServer::LocalLineServer(): Couldn't listen on \"" + sockpath + "\"! " + err);
+        }
+    }
+
+    LocalLineServer::~LocalLineServer()
+    {
+        if( m_listenfd >= 0 )
+        {
+            ::close(m_listenfd);
+            ::unlink( m_sockpath.c_str() );
+        }
+    }
+
+    void LocalLineServer::Run( handler_t handler )
+    {
+        bool bcontinue = true;
+        while( bcontinue )
+        {
+            int clientfd = ::accept( m_listenfd, nullptr, nullptr );
+            if( clientfd < 0 )
+            {
+                if( errno == EINTR || errno == ECONNABORTED )
+                    continue;
+                throw runtime_error("LocalLineServer::Run(): accept() failed! " + ErrnoStr());
+            }
+
+            try
+            {
+                bcontinue = ServeClient( clientfd, handler );
+            }
+            catch(...)
+            {
+                ::close(clientfd);
+                throw;
+            }
+            ::close(clientfd);
+        }
+    }
+
+    bool LocalLineServer::ServeClient( int clientfd, handler_t & handler )
+    {
+        string pending;
+        char   buffer[4096];
+        while(true)
+        {
+            ssize_t nbread = ::recv( clientfd, buffer, sizeof(buffer), 0 );
+            if( nbread < 0 && errno == EINTR )
+                continue;
+            if( nbread <= 0 )
+                return true; //Client disconnected
+            pending.append( buffer, static_cast<size_t>(nbread) );
+
+            size_t eol = 0;
+            while( (eol = pending.find('\n')) != string::npos )
+            {
+                string request = pending.substr( 0, eol );
+                pending.erase( 0, eol + 1 );
+                if( !request.empty() && request.back() == '\r' )
+                    request.pop_back();
+                if( request.empty() )
+                    continue;
+
+                string reply;
+                const bool bcontinue = handler( request, reply );
+                //Replies are a single line
+                for( char & c : reply )
+                {
+                    if( c == '\n' || c == '\r' )
+                        c = ' ';
+                }
+                reply.push_back('\n');
+
+                if( !SendAll( clientfd, reply ) )
+                {
+                    if( utils::LibWide().isLogOn() )
+                        clog <<"LocalLineServer: Client went away before the reply could be sent.\n";
+                    return bcontinue;
+                }
+                if( !bcontinue )
+                    return false;
+            }
+
+            if( pending.size() > LocalServer_MaxLineLen )
+            {
+                SendAll( clientfd, "error request line too long\n" );
+                return true;
+            }
+        }
+    }
+
+#else
+    LocalLineServer::LocalLineServer( const std::string & sockpath )
+        :m_sockpath(sockpath), m_listenfd(-1)
+    {
+        throw runtime_error("LocalLineServer::LocalLineServer(): Local sockets aren't supported on this platform!");
+    }
+
+    LocalLineServer::~LocalLineServer()
+    {}
+
+    void LocalLineServer::Run( handler_t handler )
+    {}
+
+    bool LocalLineServer::ServeClient( int clientfd, handler_t & handler )
+    {
+        return false;
+    }
+#endif
+};
@@ -18,6 +18,8 @@ using namespace utils;
 
 namespace multitask
 {
+    static TraceCounter MultiTasksQueued("multitask tasks queued");
+
 //================================================================================================
 // Constants
 //================================================================================================
@@ -70,6 +72,7 @@ namespace multitask
             m_tasks.push_back( std::move(task) );
         }
         catch( exception e ){SimpleHandleException(e);}
+        MultiTasksQueued.Add(1);
 
         try
         {
@@ -134,6 +137,8 @@ namespace multitask
 
     bool CMultiTaskHandler::WorkerThread( thRunParam & taskSlot )
     {
+        if( Profiler().IsEnabled() )
+            Profiler().SetThreadName("multitask worker");
         while( !( m_stopWorkers.load() ) )
         {
             packaged_task<pktaskret_t()> mytask;
@@ -160,6 +165,7 @@ namespace multitask
                 try
                 {
                     future<pktaskret_t> myfuture = mytask.get_future();
+                    TraceScope          trace("multitask task");
                     mytask();
                     myfuture.get();
                     ++m_taskcompleted;
@@ -1,4 +1,7 @@
 #include <utils/parallel_tasks.hpp>
+#include <sstream>
+#include <stdexcept>
+#include <atomic>
 
 using namespace std;
 
@@ -9,13 +12,18 @@ namespace utils
 //  TaskQueue
 //======================================================================================================================================
     const std::chrono::microseconds TaskQueue::WaitForNewTaskTime(100);
+    static TraceCounter TasksQueued("tasks queued");
+
     /*
         Push a task at the back of the queue.
     */
     void TaskQueue::Push( TaskQueue::task_t && task )
     {
-        std::lock_guard<std::mutex> lck(m_queuemtx);
-        m_taskqueue.push_back(std::forward<task_t>(task));
+        {
+            std::lock_guard<std::mutex> lck(m_queuemtx);
+            m_taskqueue.push_back(std::forward<task_t>(task));
+        }
+        TasksQueued.Add(1);
     }
 
     /*
@@ -110,6 +118,8 @@ namespace utils
     */
     void Worker::Work()
     {
+        if( Profiler().IsEnabled() )
+            Profiler().SetThreadName("worker");
         do
         {
             TaskQueue::task_t mytask;
@@ -179,6 +189,7 @@ namespace utils
         try
         {
             m_bisbusy = true;
+            TraceScope trace("task");
             curtask();
         }
         catch(...)
@@ -200,4 +211,51 @@ namespace utils
 //  
 //======================================================================================================================================
 
-};
\ No newline at end of file
+
+//======================================================================================================================================
+//  Functions
+//======================================================================================================================================
+    void RunIndexedTasks( size_t nbtasks, const std::function<void(size_t)> & task, const std::string & errorheader )
+    {
+        vector<string>   errors(nbtasks); //Each task only ever touches its own slot
+        atomic<size_t>   nbfailed(0);
+        AsyncTaskHandler taskhandler;
+
+        for( size_t i = 0; i < nbtasks; ++i )
+        {
+            taskhandler.QueueTask( AsyncTaskHandler::task_t( [&task, &errors, &nbfailed, i]()
+            {
+                try
+                {
+                    task(i);
+                }
+                catch( const exception & e )
+                {
+                    errors[i] = e.what();
+                    ++nbfailed;
+                }
+                catch(...)
+                {
+                    errors[i] = "Unknown exception!";
+                    ++nbfailed;
+                }
+            }));
+        }
+
+        taskhandler.Start();
+        taskhandler.WaitTasksFinished();
+        taskhandler.WaitStop();
+
+        if( nbfailed == 0 )
+            return;
+
+        stringstream sstr;
+        sstr << errorheader <<" " <<nbfailed <<" of " <<nbtasks <<" task(s) failed:\n";
+        for( size_t i = 0; i < nbtasks; ++i )
+        {
+            if( !errors[i].empty() )
+                sstr << "  [" <<i <<"] " <<errors[i] <<"\n";
+        }
+        throw runtime_error(sstr.str());
+    }
+};
@@ -1,9 +1,12 @@
 #include <utils/poco_wrapper.hpp>
+#include <utils/gfileutils.hpp>
+#include <utils/virtual_fs.hpp>
 #include <Poco/File.h>
 #include <Poco/DirectoryIterator.h>
 #include <Poco/Util/Application.h>
 #include <Poco/Util/OptionSet.h>
 #include <cassert>
+#include <algorithm>
 #include <iostream>
 #include <sstream>
 #include <vector>
@@ -33,21 +36,50 @@ namespace utils
             return outfolder.createDirectory();
     }
 
+    /*
+        Paths under a mounted VirtualFS are looked up in it first. Returns whether the path is under one.
+    */
+    static bool IsVirtualPath( const std::string & inputpath, bool & out_isfile, bool & out_isdir )
+    {
+        string relpath;
+        auto   pvfs = io::FindVirtualFS( inputpath, relpath );
+        if( !pvfs )
+            return false;
+
+        const uint8_t * pdata = nullptr;
+        size_t          len   = 0;
+        out_isdir  = pvfs->IsDir(relpath);
+        out_isfile = !out_isdir && pvfs->GetFile(relpath, pdata, len);
+        return true;
+    }
+
     //From the first path specified in the arguments its possible to detect whether we must unpack or pack a file.
     bool isFolder( const string & inputpath )
     {
+        bool visfile = false;
+        bool visdir  = false;
+        if( IsVirtualPath( inputpath, visfile, visdir ) )
+            return visdir;
         Poco::File test(inputpath);
         return test.exists() && test.isDirectory();
     }
 
     bool isFile( const string & inputpath )
     {
+        bool visfile = false;
+        bool visdir  = false;
+        if( IsVirtualPath( inputpath, visfile, visdir ) )
+            return visfile;
         Poco::File test(inputpath);
         return test.exists() && test.isFile();
     }
 
     bool pathExists( const std::string & inputpath )
     {
+        bool visfile = false;
+        bool visdir  = false;
+        if( IsVirtualPath( inputpath, visfile, visdir ) )
+            return visfile || visdir;
         return Poco::File(inputpath).exists();
     }
 
@@ -70,6 +102,23 @@ namespace utils
     std::vector<std::string> ListDirContent_FilesAndDirs( const std::string & dirpath, bool bFilenameOnly, bool noslashaftdir )
     {
         vector<string>          dircontent;
+        string                  relpath;
+        auto                    pvfs = io::FindVirtualFS( dirpath, relpath );
+        if( pvfs && pvfs->ListDir( relpath, dircontent ) )
+        {
+            //Names from a VirtualFS have a slash after directories, match what Poco gives for real ones
+            const string parentpath = TryAppendSlash(dirpath);
+            for( auto & entry : dircontent )
+            {
+                const bool isdir = !entry.empty() && entry.back() == '/';
+                if( isdir && (noslashaftdir || !bFilenameOnly) )
+                    entry.pop_back();
+                if( !bFilenameOnly )
+                    entry = parentpath + entry;
+            }
+            return dircontent;
+        }
+
         Poco::DirectoryIterator itdir(dirpath);
         Poco::DirectoryIterator itdirend;
 
@@ -147,6 +196,49 @@ namespace utils
         return std::move(relative.makeAbsolute().toString());
     }
 
+    inline void HashPathState( const Poco::File & file, const std::string & relpath, uint64_t & hash )
+    {
+        auto fnvmix = [&hash]( uint64_t val )
+        {
+            for( int i = 0; i < 8; ++i, val >>= 8 )
+                hash = (hash ^ (val & 0xFF)) * 0x100000001B3ull;
+        };
+        for( char c : relpath )
+            hash = (hash ^ static_cast<uint8_t>(c)) * 0x100000001B3ull;
+
+        if( file.isDirectory() )
+        {
+            //Directory iteration order isn't guaranteed, so sort the entries
+            vector<Poco::File> entries;
+            file.list(entries);
+            sort( entries.begin(), entries.end(), []( const Poco::File & a, const Poco::File & b ){ return a.path() < b.path(); } );
+            fnvmix( entries.size() );
+            for( const auto & entry : entries )
+                HashPathState( entry, Poco::Path(entry.path()).getFileName(), hash );
+        }
+        else
+        {
+            fnvmix( file.getSize() );
+            fnvmix( static_cast<uint64_t>(file.getLastModified().epochMicroseconds()) );
+        }
+    }
+
+    uint64_t GetPathStateStamp( const std::string & path )
+    {
+        Poco::File target(path);
+        if( !target.exists() )
+            return 0;
+        uint64_t hash = 0xCBF29CE484222325ull;
+        HashPathState( target, string(), hash );
+        return hash;
+    }
+
+    void ReplaceFile( const std::string & srcpath, const std::string & destpath )
+    {
+        //Poco renames with rename() on posix, and with MoveFileEx and MOVEFILE_REPLACE_EXISTING on windows
+        Poco::File(srcpath).renameTo(destpath);
+    }
+
 //#ifndef POCO_STATIC
 //    /*
 //        StubApp
@@ -1,4 +1,6 @@
 #include <utils/pugixml_utils.hpp>
+#include <utils/parallel_tasks.hpp>
+#include <stdexcept>
 
 namespace pugixmlutils
 {
@@ -92,4 +94,51 @@ namespace pugixmlutils
             throw runtime_error( sstr.str() );
         }
     }
-};
\ No newline at end of file
+
+    /*
+        LoadXMLDocuments
+    */
+    std::vector<std::unique_ptr<pugi::xml_document>> LoadXMLDocuments( const std::vector<std::string> & files, bool bparallel )
+    {
+        using namespace std;
+        using namespace pugi;
+        vector<unique_ptr<xml_document>> docs(files.size());
+
+        auto lambdaload = [&files, &docs]( size_t index )
+        {
+            unique_ptr<xml_document> pdoc( new xml_document );
+            HandleParsingError( pdoc->load_file(files[index].c_str()), files[index] );
+            docs[index] = std::move(pdoc);
+        };
+
+        if( bparallel )
+            utils::RunIndexedTasks( files.size(), lambdaload, "LoadXMLDocuments(): Couldn't load some XML files!" );
+        else
+        {
+            for( size_t i = 0; i < files.size(); ++i )
+                lambdaload(i);
+        }
+        return docs;
+    }
+
+    /*
+        SaveXMLToBuffer
+    */
+    std::vector<uint8_t> SaveXMLToBuffer( const pugi::xml_document & doc, const pugi::char_t * indent, unsigned int flags, pugi::xml_encoding encoding )
+    {
+        struct buffer_writer : public pugi::xml_writer
+        {
+            std::vector<uint8_t> data;
+
+            void write( const void * pdata, size_t size )override
+            {
+                const uint8_t * pbytes = static_cast<const uint8_t*>(pdata);
+                data.insert( data.end(), pbytes, pbytes + size );
+            }
+        };
+
+        buffer_writer writer;
+        doc.save( writer, indent, flags, encoding );
+        return std::move(writer.data);
+    }
+};
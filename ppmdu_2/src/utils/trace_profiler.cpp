@@ -0,0 +1,184 @@
+#include <utils/trace_profiler.hpp>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+using namespace std;
+
+namespace utils
+{
+    //The buffer of the current thread, once it recorded anything
+    static thread_local void * s_pThreadTraceBuffer = nullptr;
+
+    inline void WriteJSONString( ostream & os, const char * str )
+    {
+        os <<'"';
+        for( ; str != nullptr && *str != 0; ++str )
+        {
+            const char c = *str;
+            if( c == '"' || c == '\\' )
+                os <<'\\' <<c;
+            else if( static_cast<unsigned char>(c) < 0x20 )
+                os <<"\\u" <<hex <<setfill('0') <<setw(4) <<static_cast<unsigned int>(c) <<dec <<setfill(' ');
+            else
+                os <<c;
+        }
+        os <<'"';
+    }
+
+    //Chrome traces are in microseconds, but take fractions
+    inline void WriteMicroseconds( ostream & os, uint64_t ns )
+    {
+        os <<(ns / 1000) <<'.' <<setfill('0') <<setw(3) <<(ns % 1000) <<setfill(' ');
+    }
+
+//
+//
+//
+    TraceProfiler & TraceProfiler::GetInstance()
+    {
+        static TraceProfiler s_profiler;
+        return s_profiler;
+    }
+
+    TraceProfiler::TraceProfiler()
+        :m_benabled(false), m_start(clock_t::now())
+    {}
+
+    void TraceProfiler::Enable( const std::string & outputpath )
+    {
+        m_outpath = outputpath;
+        m_start   = clock_t::now();
+        SetThreadName("main");
+        m_benabled.store(true);
+    }
+
+    void TraceProfiler::Finish()
+    {
+        if( !m_benabled.exchange(false) )
+            return;
+
+        ofstream outf( m_outpath );
+        if( !outf.good() )
+            throw runtime_error("TraceProfiler::Finish(): Couldn't open trace file \"" + m_outpath + "\"!");
+        WriteChromeTrace(outf);
+        cout <<"<*>- Wrote profiling trace to \"" <<m_outpath <<"\"\n";
+    }
+
+    void TraceProfiler::WriteChromeTrace( std::ostream & os )const
+    {
+        lock_guard<mutex> lck(m_registrymtx);
+        bool bfirst = true;
+        auto lambdasep = [&]()
+        {
+            os <<( bfirst? "\n" : ",\n" );
+            bfirst = false;
+        };
+
+        os <<"{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+        for( const auto & pbuf : m_buffers )
+        {
+            const char * tname = pbuf->tname.load(memory_order_acquire);
+            if( tname != nullptr )
+            {
+                lambdasep();
+                os <<"{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" <<pbuf->tid <<",\"args\":{\"name\":";
+                WriteJSONString(os, tname);
+                os <<"}}";
+            }
+
+            for( const trace_chunk * pchunk = pbuf->pfirst; pchunk != nullptr; pchunk = pchunk->next.load(memory_order_acquire) )
+            {
+                const size_t nbused = pchunk->nbused.load(memory_order_acquire);
+                for( size_t i = 0; i < nbused; ++i )
+                {
+                    const trace_event & ev = pchunk->events[i];
+                    lambdasep();
+                    os <<"{\"name\":";
+                    WriteJSONString(os, ev.name);
+                    os <<",\"ph\":\"" <<ev.phase <<"\",\"pid\":1,\"tid\":" <<pbuf->tid <<",\"ts\":";
+                    WriteMicroseconds(os, ev.tsns);
+                    if( ev.phase == 'X' )
+                    {
+                        os <<",\"dur\":";
+                        WriteMicroseconds(os, static_cast<uint64_t>(ev.durorval));
+                        os <<"}";
+                    }
+                    else
+                        os <<",\"args\":{\"value\":" <<ev.durorval <<"}}";
+                }
+            }
+        }
+        os <<"\n]}\n";
+    }
+
+    void TraceProfiler::RecordSpan( const char * name, clock_t::time_point beg, clock_t::time_point end )
+    {
+        if( !IsEnabled() || beg < m_start )
+            return;
+        trace_event ev;
+        ev.name     = name;
+        ev.tsns     = static_cast<uint64_t>( chrono::duration_cast<chrono::nanoseconds>(beg - m_start).count() );
+        ev.durorval = chrono::duration_cast<chrono::nanoseconds>(end - beg).count();
+        ev.phase    = 'X';
+        Push(ev);
+    }
+
+    void TraceProfiler::RecordCounter( const char * name, int64_t value )
+    {
+        if( !IsEnabled() )
+            return;
+        trace_event ev;
+        ev.name     = name;
+        ev.tsns     = static_cast<uint64_t>( chrono::duration_cast<chrono::nanoseconds>(clock_t::now() - m_start).count() );
+        ev.durorval = value;
+        ev.phase    = 'C';
+        Push(ev);
+    }
+
+    void TraceProfiler::SetThreadName( const std::string & name )
+    {
+        ThisThreadBuffer().tname.store( InternName(name), memory_order_release );
+    }
+
+    const char * TraceProfiler::InternName( const std::string & name )
+    {
+        lock_guard<mutex> lck(m_namesmtx);
+        return m_names.insert(name).first->c_str();
+    }
+
+    TraceProfiler::thread_buffer & TraceProfiler::ThisThreadBuffer()
+    {
+        if( s_pThreadTraceBuffer != nullptr )
+            return *static_cast<thread_buffer*>(s_pThreadTraceBuffer);
+
+        //First event from this thread, register a buffer for it
+        unique_ptr<thread_buffer> pbuf( new thread_buffer );
+        pbuf->chunks.push_back( unique_ptr<trace_chunk>(new trace_chunk) );
+        pbuf->pfirst = pbuf->chunks.back().get();
+        pbuf->pcur   = pbuf->pfirst;
+
+        lock_guard<mutex> lck(m_registrymtx);
+        pbuf->tid = static_cast<uint32_t>( m_buffers.size() + 1 );
+        s_pThreadTraceBuffer = pbuf.get();
+        m_buffers.push_back( std::move(pbuf) );
+        return *m_buffers.back();
+    }
+
+    void TraceProfiler::Push( const trace_event & ev )
+    {
+        thread_buffer & buf    = ThisThreadBuffer();
+        size_t          nbused = buf.pcur->nbused.load(memory_order_relaxed);
+        if( nbused == trace_chunk::Capacity )
+        {
+            buf.chunks.push_back( unique_ptr<trace_chunk>(new trace_chunk) );
+            trace_chunk * pnext = buf.chunks.back().get();
+            buf.pcur->next.store( pnext, memory_order_release );
+            buf.pcur = pnext;
+            nbused   = 0;
+        }
+        buf.pcur->events[nbused] = ev;
+        buf.pcur->nbused.store( nbused + 1, memory_order_release );
+    }
+};
@@ -0,0 +1,121 @@
+#include <utils/virtual_fs.hpp>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <stdexcept>
+using namespace std;
+
+namespace utils{ namespace io
+{
+    struct vfs_mount
+    {
+        string                mountpoint;
+        shared_ptr<VirtualFS> vfs;
+    };
+
+    static mutex             s_mountsmtx;
+    static vector<vfs_mount> s_mounts;
+    static atomic<size_t>    s_nbmounts(0);   //Lets lookups skip the lock when nothing is mounted, which is the usual case
+
+    std::string NormalizeVirtualPath( const std::string & path )
+    {
+        string result;
+        result.reserve(path.size());
+        size_t compbeg = 0;
+        for( char c : path )
+        {
+            if( c == '\\' )
+                c = '/';
+
+            if( c == '/' )
+            {
+                const size_t complen = result.size() - compbeg;
+                if( complen == 0 && !result.empty() )
+                    continue;                               //Repeated slash
+                if( complen == 1 && result.back() == '.' )
+                {
+                    result.pop_back();                      //"." component
+                    continue;
+                }
+                result.push_back(c);
+                compbeg = result.size();
+            }
+            else
+                result.push_back(c);
+        }
+
+        if( result.size() - compbeg == 1 && result.back() == '.' )
+            result.pop_back();
+        if( result.size() > 1 && result.back() == '/' )
+            result.pop_back();
+        return result;
+    }
+
+    void MountVirtualFS( const std::string & mountpoint, std::shared_ptr<VirtualFS> vfs )
+    {
+        if( !vfs )
+            throw runtime_error("MountVirtualFS(): Tried to mount a null VirtualFS on \"" + mountpoint + "\"!");
+
+        const string      normmp = NormalizeVirtualPath(mountpoint);
+        lock_guard<mutex> lck(s_mountsmtx);
+        auto itfound = std::find_if( s_mounts.begin(), s_mounts.end(), [&](const vfs_mount & m){ return m.mountpoint == normmp; } );
+        if( itfound != s_mounts.end() )
+            itfound->vfs = std::move(vfs);
+        else
+        {
+            s_mounts.push_back( vfs_mount{ normmp, std::move(vfs) } );
+            s_nbmounts.store( s_mounts.size(), memory_order_release );
+        }
+    }
+
+    void UnmountVirtualFS( const std::string & mountpoint )
+    {
+        const string      normmp = NormalizeVirtualPath(mountpoint);
+        lock_guard<mutex> lck(s_mountsmtx);
+        s_mounts.erase( std::remove_if( s_mounts.begin(), s_mounts.end(), [&](const vfs_mount & m){ return m.mountpoint == normmp; } ),
+                        s_mounts.end() );
+        s_nbmounts.store( s_mounts.size(), memory_order_release );
+    }
+
+    std::shared_ptr<VirtualFS> FindVirtualFS( const std::string & path, std::string & out_relpath )
+    {
+        if( s_nbmounts.load(memory_order_acquire) == 0 )
+            return nullptr;
+
+        const string      normpath = NormalizeVirtualPath(path);
+        lock_guard<mutex> lck(s_mountsmtx);
+        const vfs_mount * pbest    = nullptr;
+        for( const auto & mnt : s_mounts )
+        {
+            //Only match on whole path components, and keep the deepest mount point
+            const size_t mplen = mnt.mountpoint.size();
+            if( normpath.compare( 0, mplen, mnt.mountpoint ) != 0 )
+                continue;
+            if( normpath.size() != mplen && normpath[mplen] != '/' && mnt.mountpoint.back() != '/' )
+                continue;
+            if( pbest == nullptr || mplen > pbest->mountpoint.size() )
+                pbest = &mnt;
+        }
+
+        if( pbest == nullptr )
+            return nullptr;
+
+        const size_t mplen = pbest->mountpoint.size();
+        if( normpath.size() <= mplen )
+            out_relpath.clear();
+        else
+            out_relpath = normpath.substr( (normpath[mplen] == '/')? mplen + 1 : mplen );
+        return pbest->vfs;
+    }
+
+    bool WriteToVirtualFS( const std::string & path, const uint8_t * pdata, size_t len )
+    {
+        string                relpath;
+        shared_ptr<VirtualFS> pvfs = FindVirtualFS( path, relpath );
+        if( !pvfs )
+            return false;
+        if( !pvfs->PutFile( relpath, pdata, len ) )
+            throw runtime_error("WriteToVirtualFS(): Can't write \"" + path + "\", it's in a read-only virtual file system!");
+        return true;
+    }
+};};
@@ -122,6 +122,9 @@ namespace audioutil
     const string OPTION_BgmCntPath  = "bgmcntpath";
     const string OPTION_BgmBlobPath = "blobpath";
 
+    //Name of the XML file a directory exported from a SWDL contains, used to recognize one
+    const string SWDL_XMLProgramsFname = "programs.xml";
+
     /*
         Information on all the switches / options to allow the automated parser 
         to parse them.
@@ -214,7 +217,7 @@ namespace audioutil
             "mbank",
             1,
             "Use this to specify the path to the main sample bank that the SMDL to export will use, if applicable!"
-            "Is also used to specify where to put the assembled ",
+            "Is also used to specify the SWDL file the XML data is applied over, when building a SWDL from a directory!",
             "-mbank \"SOUND/BGM/bgm.swd\"",
             std::bind( &CAudioUtil::ParseOptionMBank, &GetInstance(), placeholders::_1 ),
         },
@@ -301,6 +304,15 @@ namespace audioutil
             std::bind( &CAudioUtil::ParseOptionOutputXML, &GetInstance(), placeholders::_1 ),
         },
 
+        //wav -> Render the sequences using their instruments, for quick listening tests
+        {
+            "wav",
+            0,
+            "Specifying this will render the sequences to 32 bits float .wav files, using the samples from the swd soundbanks.",
+            "-wav",
+            std::bind( &CAudioUtil::ParseOptionOutputWAV, &GetInstance(), placeholders::_1 ),
+        },
+
         //nobake -> This disables sample baking
         {
             "nobake",
@@ -356,6 +368,15 @@ namespace audioutil
             "-v",
             std::bind( &CAudioUtil::ParseOptionVerbose, &GetInstance(), placeholders::_1 ),
         },
+
+        //Record a trace of the run
+        {
+            "profile",
+            1,
+            "Record a Chrome trace of the run, and write it to the specified file.",
+            "-profile \"trace.json\"",
+            std::bind( &CAudioUtil::ParseOptionProfile, &GetInstance(), placeholders::_1 ),
+        },
     }};
 
 
@@ -597,7 +618,9 @@ namespace audioutil
             return true;
         else
         {
-            if( m_nbloops > MaxNbLoops )
+            if( m_nbloops < 0 )
+                cerr <<"Invalid number of loops " <<m_nbloops <<" ! The number of loops can't be negative!\n";
+            else if( m_nbloops >= MaxNbLoops )
                 cerr <<"Too many loops requested! " <<m_nbloops <<" loops is a little too much to handle !! Use a number below " <<MaxNbLoops <<" please !\n";
             return false;
         }
@@ -647,6 +670,13 @@ namespace audioutil
         return true;
     }
 
+    bool CAudioUtil::ParseOptionProfile( const std::vector<std::string> & optdata )
+    {
+        cout <<"<*>-Recording a trace of the run to \"" <<optdata[1] <<"\"!\n";
+        utils::Profiler().Enable( optdata[1] );
+        return true;
+    }
+
     bool CAudioUtil::ParseOptionPathToCvInfo( const std::vector<std::string> & optdata )
     {
         Poco::File cvinfof( Poco::Path( optdata[1] ).makeAbsolute() );
@@ -727,6 +757,12 @@ namespace audioutil
         return true;
     }
 
+    bool CAudioUtil::ParseOptionOutputWAV( const std::vector<std::string> & optdata )
+    {
+        m_outtype = eOutputType::WAV;
+        return true;
+    }
+
     bool CAudioUtil::ParseOptionNoSampleBake( const std::vector<std::string> & optdata )
     {
         m_bBakeSamples = false;
@@ -942,6 +978,11 @@ namespace audioutil
                     else
                         throw std::runtime_error("Couldn't find the directory \"./SOUND\" under the path specified!");
                 }
+                else if( Poco::File( Poco::Path(inpath).makeDirectory().setFileName(SWDL_XMLProgramsFname) ).exists() )
+                {
+                    //A directory exported from a SWDL
+                    m_operationMode = eOpMode::BuildSWDL;
+                }
                 else
                 {
                     //Handle assembling things
@@ -1241,7 +1282,7 @@ namespace audioutil
 
         //Load SWDL
         PresetBank swd = move( DSE::ParseSWDL( inputfile.toString() ) );
-        ExportPresetBank( outNewDir, swd, true, m_useHexaNumbers, !m_bConvertSamples );
+        ExportPresetBank( outNewDir, swd, false, m_useHexaNumbers, !m_bConvertSamples );
 
         return 0;
     }
@@ -1357,8 +1398,29 @@ namespace audioutil
 
     int CAudioUtil::BuildSWDL()
     {
-        cout<< "Not implemented!\n";
-        assert(false);
+        Poco::Path inputdir(m_inputPath);
+        Poco::Path outputfile;
+        inputdir.makeDirectory();
+
+        if( ! m_outputPath.empty() )
+            outputfile = Poco::Path(m_outputPath);
+        else
+            outputfile = Poco::Path(inputdir).popDirectory().setFileName( inputdir[inputdir.depth() - 1] ).setExtension("swd");
+
+        //The XML files don't contain the samples, so they're applied over the SWDL they were exported from
+        const string basepath = (!m_mbankpath.empty())? m_mbankpath : outputfile.toString();
+        if( !Poco::File(basepath).exists() )
+            throw runtime_error("CAudioUtil::BuildSWDL(): No SWDL file to apply the XML data over! Specify one with -mbank, or make sure the output file \"" + basepath + "\" exists!");
+
+        cout << "Building SWDL:\n"
+             << "\t\"" << inputdir.toString() <<"\"\n"
+             << "Over:\n"
+             << "\t\"" << basepath <<"\"\n"
+             << "To:\n"
+             << "\t\"" << outputfile.toString() <<"\"\n";
+
+        PresetBank swd = DSE::XMLToPresetBank( inputdir.toString(), DSE::ParseSWDL(basepath) );
+        DSE::WriteSWDLIncremental( outputfile.toString(), swd, basepath );
         return 0;
     }
 
@@ -1871,6 +1933,11 @@ namespace audioutil
             cout << "Exporting MIDI files only to " <<outputpath <<"..\n";
             bal.ExportMIDIs( outputpath, m_convinfopath, m_nbloops );
         }
+        else if( m_outtype == eOutputType::WAV )
+        {
+            cout << "Rendering sequences to WAV files in " <<outputpath <<"..\n";
+            bal.ExportWAVs( outputpath, m_nbloops );
+        }
         else
         {
             cerr << "Internal Error: Output type is invalid!\n"
@@ -1895,6 +1962,7 @@ namespace audioutil
         
         //Execute the utility
         returnval = Execute();
+        utils::Profiler().Finish();
 
 #ifdef _DEBUG
         utils::PortablePause();
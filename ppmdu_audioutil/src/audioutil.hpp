@@ -62,6 +62,7 @@ namespace audioutil
         bool ParseOptionMBAT       ( const std::vector<std::string> & optdata ); //Export Master Bank And Tracks using the specified folder.
         bool ParseOptionLog        ( const std::vector<std::string> & optdata ); //Redirects clog to the file specified
         bool ParseOptionVerbose    ( const std::vector<std::string> & optdata ); //Write more info to the log file!
+        bool ParseOptionProfile    ( const std::vector<std::string> & optdata ); //Record a trace of the run to the file specified
 
         bool ParseOptionMBank      ( const std::vector<std::string> & optdata );
         bool ParseOptionSWDLPath   ( const std::vector<std::string> & optdata );
@@ -72,6 +73,7 @@ namespace audioutil
 
         bool ParseOptionOutputSF2  ( const std::vector<std::string> & optdata );
         bool ParseOptionOutputXML  ( const std::vector<std::string> & optdata );
+        bool ParseOptionOutputWAV  ( const std::vector<std::string> & optdata );
 
         bool ParseOptionNoSampleBake( const std::vector<std::string> & optdata );
 
@@ -148,7 +150,7 @@ namespace audioutil
 
             ExportPMD2,     //Export the entire content of the PMD2's "SOUND" folder
 
-            BuildSWDL,      //Build a SWDL from a folder. Must contain XML info file. If no preset data present builds a simple wav bank.(samples are imported in the slot corresponding to their file name)
+            BuildSWDL,      //Build a SWDL from a folder exported from a SWDL. The XML files it contains are applied over the original SWDL, which provides the samples.
             BuildSMDL,      //Build a SMDL from a midi file and a similarly named XML file. XML file used to remap instruments from GM to the game's format, and to set the 2 unknown variables.
             BuildSEDL,      //Build SEDL from a folder a midi file and XML.
 
@@ -164,6 +166,7 @@ namespace audioutil
             SF2,        // For exporting a Sounfont
             DLS,        // For possible DLS support in the future
             MIDI_Only,  // For exporting only MIDIs
+            WAV,        // For rendering the sequences to wave files
         };
 
         //Default filenames names
@@ -0,0 +1,371 @@
+#include "bench_corpora.hpp"
+#include <ppmdu/fmts/sir0.hpp>
+#include <ppmdu/fmts/swdl.hpp>
+#include <ppmdu/fmts/smdl.hpp>
+#include <ppmdu/pmd2/pmd2_scripts_opcodes.hpp>
+#include <utils/utility.hpp>
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+using namespace std;
+using namespace pmd2;
+
+namespace ppmdu_bench
+{
+    static const uint32_t TileWidth  = 8;
+    static const uint32_t TileHeight = 8;
+
+    static const char * const Syllables[] =
+    {
+        "ka", "po", "mi", "chu", "ra", "zu", "ne", "to", "shi", "ba", "ro", "ku", "le", "da", "mo", "pi",
+    };
+    static const size_t NbSyllables = sizeof(Syllables) / sizeof(Syllables[0]);
+
+//
+//
+//
+    vector<uint8_t> MakeRandomBytes( CorpusRNG & rng, size_t len )
+    {
+        vector<uint8_t> out;
+        out.reserve(len);
+        for( size_t i = 0; i < len; ++i )
+            out.push_back( rng.Byte() );
+        return out;
+    }
+
+//
+//
+//
+    vector<uint8_t> MakeSpriteLikeImg( CorpusRNG & rng, uint32_t width, uint32_t height, unsigned int bpp )
+    {
+        if( bpp != 4 && bpp != 8 )
+            throw runtime_error("MakeSpriteLikeImg(): Unsupported bit depth!");
+        if( width == 0 || height == 0 || (width % TileWidth) != 0 || (height % TileHeight) != 0 )
+            throw runtime_error("MakeSpriteLikeImg(): Resolution must be a non-zero multiple of the tile size!");
+
+        const uint32_t maxcolor = (bpp == 4)? 15 : 255;
+        const uint32_t nbcolors = (bpp == 4)? 6  : 24;   //Sprites only use a handful of colors of their palette
+        vector<uint8_t> colors;
+        for( uint32_t i = 0; i < nbcolors; ++i )
+            colors.push_back( static_cast<uint8_t>( 1 + rng.Below(maxcolor) ) );
+
+        //Draw an ellipse shaped blob, covering roughly the middle half of the image, made of runs of the same color
+        const int64_t cx = width  / 2;
+        const int64_t cy = height / 2;
+        const int64_t rx = max<int64_t>( 1, width  / 4 + rng.Below(width  / 8 + 1) );
+        const int64_t ry = max<int64_t>( 1, height / 4 + rng.Below(height / 8 + 1) );
+        vector<uint8_t> linear( static_cast<size_t>(width) * height, 0 );
+        for( uint32_t y = 0; y < height; ++y )
+        {
+            uint8_t  curcolor = colors[rng.Below(nbcolors)];
+            uint32_t runleft  = 0;
+            for( uint32_t x = 0; x < width; ++x )
+            {
+                const int64_t dx = static_cast<int64_t>(x) - cx;
+                const int64_t dy = static_cast<int64_t>(y) - cy;
+                if( (dx * dx * ry * ry) + (dy * dy * rx * rx) > (rx * rx * ry * ry) )
+                    continue;
+                if( runleft == 0 )
+                {
+                    curcolor = colors[rng.Below(nbcolors)];
+                    runleft  = 1 + rng.Below(6);
+                }
+                linear[static_cast<size_t>(y) * width + x] = curcolor;
+                --runleft;
+            }
+        }
+
+        //Then pack the pixels into tiles, the way the game stores them
+        vector<uint8_t> out;
+        out.reserve( (linear.size() * bpp) / 8 );
+        for( uint32_t ty = 0; ty < height; ty += TileHeight )
+        {
+            for( uint32_t tx = 0; tx < width; tx += TileWidth )
+            {
+                for( uint32_t y = ty; y < ty + TileHeight; ++y )
+                {
+                    const uint8_t * prow = linear.data() + static_cast<size_t>(y) * width + tx;
+                    if( bpp == 8 )
+                        out.insert( out.end(), prow, prow + TileWidth );
+                    else
+                    {
+                        for( uint32_t x = 0; x < TileWidth; x += 2 )
+                            out.push_back( static_cast<uint8_t>( prow[x] | (prow[x + 1] << 4) ) );
+                    }
+                }
+            }
+        }
+        return out;
+    }
+
+//
+//
+//
+    vector<string> MakeTextTable( CorpusRNG & rng, size_t nbstrings )
+    {
+        vector<string> out;
+        out.reserve(nbstrings);
+        for( size_t i = 0; i < nbstrings; ++i )
+        {
+            string         str;
+            const uint32_t nbwords = 1 + rng.Below(24);
+            for( uint32_t w = 0; w < nbwords; ++w )
+            {
+                if( w != 0 )
+                    str.push_back( rng.Chance(8)? '\n' : ' ' );
+
+                const uint32_t nbsyl  = 1 + rng.Below(3);
+                const size_t   wordbeg = str.size();
+                for( uint32_t s = 0; s < nbsyl; ++s )
+                    str.append( Syllables[rng.Below(NbSyllables)] );
+                if( w == 0 )
+                    str[wordbeg] = static_cast<char>( str[wordbeg] - 'a' + 'A' );
+            }
+            str.push_back( rng.Chance(30)? '!' : '.' );
+            out.push_back( std::move(str) );
+        }
+        return out;
+    }
+
+    vector<uint8_t> FlattenTextTable( const vector<string> & strings )
+    {
+        vector<uint8_t> out;
+        for( const auto & str : strings )
+        {
+            out.insert( out.end(), str.begin(), str.end() );
+            out.push_back(0);
+        }
+        return out;
+    }
+
+//
+//
+//
+    vector<uint8_t> MakeSIR0Blob( CorpusRNG & rng, size_t nbentries )
+    {
+        static const uint32_t EntryLen = 16;
+        filetypes::FixedSIR0DataWrapper<vector<uint8_t>> wrap;
+        auto itw = back_inserter(wrap.Data());
+
+        //Decide on the length of each entry's data first, so the table can point at it
+        vector<uint32_t> datalens;
+        datalens.reserve(nbentries);
+        for( size_t i = 0; i < nbentries; ++i )
+            datalens.push_back( 4 * (1 + rng.Below(16)) );
+
+        uint32_t dataoffset = static_cast<uint32_t>(nbentries * EntryLen);
+        for( size_t i = 0; i < nbentries; ++i )
+        {
+            wrap.pushpointer(dataoffset);
+            utils::WriteIntToBytes( datalens[i], itw );
+            utils::WriteIntToBytes( rng.Next(),  itw );
+            utils::WriteIntToBytes( static_cast<uint32_t>(i), itw );
+            dataoffset += datalens[i];
+        }
+
+        for( size_t i = 0; i < nbentries; ++i )
+        {
+            for( uint32_t j = 0; j < datalens[i]; ++j )
+                *(itw++) = rng.Byte();
+        }
+
+        //Sub-header: pointer to the table, then the amount of entries
+        wrap.SetDataPointerOffset( static_cast<uint32_t>(wrap.Data().size()) );
+        wrap.pushpointer(0);
+        utils::WriteIntToBytes( static_cast<uint32_t>(nbentries), itw );
+
+        vector<uint8_t> out;
+        auto itout = back_inserter(out);
+        wrap.Write(itout);
+        return out;
+    }
+
+//
+//
+//
+    vector<uint8_t> MakeSWDLShaped( CorpusRNG & rng, size_t len )
+    {
+        if( len < DSE::SWDL_Header_v415::Size )
+            throw runtime_error("MakeSWDLShaped(): Length smaller than the header!");
+        DSE::SWDL_Header_v415 hdr;
+        hdr.magicn      = DSE::SWDL_MagicNumber;
+        hdr.flen        = static_cast<uint32_t>(len);
+        hdr.version     = DSE::SWDL_Header_v415::DefVersion;
+        hdr.nbwavislots = static_cast<uint16_t>( rng.Below(64) );
+        hdr.nbprgislots = static_cast<uint16_t>( rng.Below(64) );
+        hdr.fname.fill(0);
+        copy_n( "bench.swd", 9, hdr.fname.begin() );
+
+        vector<uint8_t> out;
+        out.reserve(len);
+        hdr.WriteToContainer( back_inserter(out) );
+        while( out.size() < len )
+            out.push_back( rng.Byte() );
+        return out;
+    }
+
+    vector<uint8_t> MakeSMDLShaped( CorpusRNG & rng, size_t len )
+    {
+        if( len < DSE::SMDL_Header::Size )
+            throw runtime_error("MakeSMDLShaped(): Length smaller than the header!");
+        DSE::SMDL_Header hdr;
+        hdr.magicn  = DSE::SMDL_MagicNumber;
+        hdr.flen    = static_cast<uint32_t>(len);
+        hdr.version = DSE::SMDL_Header::DefVers;
+        hdr.unk5    = DSE::SMDL_Header::DefUnk5;
+        hdr.unk6    = DSE::SMDL_Header::DefUnk6;
+        hdr.fname.fill(0);
+        copy_n( "bench.smd", 9, hdr.fname.begin() );
+
+        vector<uint8_t> out;
+        out.reserve(len);
+        hdr.WriteToContainer( back_inserter(out) );
+        while( out.size() < len )
+            out.push_back( rng.Byte() );
+        return out;
+    }
+
+//
+//
+//
+    vector<int16_t> MakePCM16( CorpusRNG & rng, size_t nbsamples )
+    {
+        //Triangle waves with integer math only, so the samples don't depend on the platform's libm
+        static const size_t NbVoices = 3;
+        struct voice
+        {
+            uint32_t period;
+            uint32_t phase;
+            int32_t  amplitude;
+            uint32_t decay;     //Amplitude lost every 256 samples
+        };
+
+        vector<voice> voices;
+        for( size_t i = 0; i < NbVoices; ++i )
+            voices.push_back( voice{ 16 + rng.Below(400), 0, static_cast<int32_t>(4000 + rng.Below(6000)), 1 + rng.Below(64) } );
+
+        vector<int16_t> out;
+        out.reserve(nbsamples);
+        for( size_t i = 0; i < nbsamples; ++i )
+        {
+            int32_t smpl = static_cast<int32_t>(rng.Below(512)) - 256; //A little noise
+            for( auto & v : voices )
+            {
+                //Retrigger notes now and then
+                if( v.amplitude <= 0 && rng.Chance(1) )
+                {
+                    v.period    = 16 + rng.Below(400);
+                    v.amplitude = static_cast<int32_t>(4000 + rng.Below(6000));
+                }
+                if( v.amplitude > 0 )
+                {
+                    const int32_t half = static_cast<int32_t>(v.period / 2);
+                    const int32_t pos  = static_cast<int32_t>(v.phase % v.period);
+                    const int32_t tri  = (pos < half)? pos : (static_cast<int32_t>(v.period) - pos);
+                    smpl += ((tri * 2 - half) * v.amplitude) / max<int32_t>(half, 1);
+                    if( (i & 0xFF) == 0 )
+                        v.amplitude -= static_cast<int32_t>(v.decay);
+                }
+                ++v.phase;
+            }
+            out.push_back( static_cast<int16_t>( max<int32_t>( -32768, min<int32_t>( 32767, smpl ) ) ) );
+        }
+        return out;
+    }
+
+//
+//
+//
+    DSE::PresetBank MakePresetBank( CorpusRNG & rng, size_t nbsamples )
+    {
+        static const uint32_t SmplRate = 22050;
+        static const int8_t   RootKey  = 60;
+        vector<DSE::SampleBank::smpldata_t>     smpls(nbsamples);
+        vector<unique_ptr<DSE::ProgramInfo>>    prgms;
+        for( size_t i = 0; i < nbsamples; ++i )
+        {
+            const vector<int16_t> pcm = MakePCM16( rng, 2048 + rng.Below(8192) );
+            unique_ptr<vector<uint8_t>> pdata( new vector<uint8_t> );
+            pdata->reserve( pcm.size() * sizeof(int16_t) );
+            for( int16_t smpl : pcm )
+                utils::WriteIntToBytes( smpl, back_inserter(*pdata) );
+
+            unique_ptr<DSE::WavInfo> pinfo( new DSE::WavInfo );
+            pinfo->id       = static_cast<uint16_t>(i);
+            pinfo->rootkey  = RootKey;
+            pinfo->vol      = 127;
+            pinfo->pan      = 64;
+            pinfo->smplfmt  = DSE::eDSESmplFmt::pcm16;
+            pinfo->smplrate = SmplRate;
+            pinfo->looplen  = static_cast<uint32_t>( pdata->size() / sizeof(int32_t) );
+            smpls[i].pinfo_ = std::move(pinfo);
+            smpls[i].pdata_ = std::move(pdata);
+
+            DSE::SplitEntry split;
+            split.id      = 0;
+            split.lowkey  = 0;
+            split.hikey   = 127;
+            split.lowkey2 = 0;
+            split.hikey2  = 127;
+            split.hivel   = 127;
+            split.hivel2  = 127;
+            split.smplid  = static_cast<uint16_t>(i);
+            split.rootkey = RootKey;
+            split.smplvol = 127;
+            split.smplpan = 64;
+
+            unique_ptr<DSE::ProgramInfo> pprg( new DSE::ProgramInfo );
+            pprg->id     = static_cast<uint16_t>(i);
+            pprg->prgvol = 127;
+            pprg->prgpan = 64;
+            pprg->m_splitstbl.push_back(split);
+            prgms.push_back( std::move(pprg) );
+        }
+
+        DSE::KeyGroup globalgrp;
+        globalgrp.poly     = DSE::KeyGroup::DefPoly;
+        globalgrp.priority = DSE::KeyGroup::DefPrio;
+        globalgrp.vchigh   = DSE::KeyGroup::DefVcHi;
+
+        DSE::DSE_MetaDataSWDL meta;
+        meta.fname       = "bench.swd";
+        meta.origversion = DSE::eDSEVersion::V415;
+        meta.nbwavislots = static_cast<uint16_t>(nbsamples);
+        meta.nbprgislots = static_cast<uint16_t>(nbsamples);
+        return DSE::PresetBank( std::move(meta),
+                                unique_ptr<DSE::ProgramBank>( new DSE::ProgramBank( std::move(prgms), vector<DSE::KeyGroup>{ globalgrp } ) ),
+                                unique_ptr<DSE::SampleBank>( new DSE::SampleBank( std::move(smpls) ) ) );
+    }
+
+//
+//
+//
+    Script MakeScript( CorpusRNG & rng, size_t nbroutines, size_t nbinstperroutine, size_t nbstrings )
+    {
+        Script scr("bench");
+        for( size_t i = 0; i < nbroutines; ++i )
+        {
+            ScriptRoutine routine;
+            routine.isalias   = false;
+            routine.type      = static_cast<uint16_t>(eRoutineTy::Standard);
+            routine.parameter = 0;
+            for( size_t j = 0; j < nbinstperroutine; ++j )
+            {
+                ScriptInstruction inst;
+                inst.value          = static_cast<uint16_t>(eScriptOpCodesEoS::Wait);
+                inst.type           = eInstructionType::Command;
+                inst.dbg_origoffset = 0;
+                inst.parameters.push_back( static_cast<uint16_t>( 1 + rng.Below(120) ) );
+                routine.instructions.push_back( std::move(inst) );
+            }
+            ScriptInstruction endinst;
+            endinst.value          = static_cast<uint16_t>(eScriptOpCodesEoS::End);
+            endinst.type           = eInstructionType::Command;
+            endinst.dbg_origoffset = 0;
+            routine.instructions.push_back( std::move(endinst) );
+            scr.Routines().push_back( std::move(routine) );
+        }
+        scr.InsertStrLanguage( eGameLanguages::english, MakeTextTable(rng, nbstrings) );
+        return scr;
+    }
+};
@@ -0,0 +1,91 @@
+#ifndef BENCH_CORPORA_HPP
+#define BENCH_CORPORA_HPP
+/*
+bench_corpora.hpp
+2016/07/17
+psycommando@gmail.com
+Description: Generators for the synthetic data the benchmarks run on.
+             Everything is generated from a seed, so a given seed always produces the exact same bytes,
+             on any platform. No game data is needed.
+*/
+#include <ppmdu/containers/script_content.hpp>
+#include <dse/dse_containers.hpp>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace ppmdu_bench
+{
+    /*
+        CorpusRNG
+            Only uses the raw output of the mersenne twister, which is fully specified by the standard.
+            The standard distributions aren't, and would give different data with different standard libraries.
+    */
+    class CorpusRNG
+    {
+    public:
+        explicit CorpusRNG( uint32_t seed ) :m_gen(seed) {}
+
+        inline uint32_t Next()                  { return static_cast<uint32_t>(m_gen()); }
+        inline uint32_t Below( uint32_t bound ) { return static_cast<uint32_t>( (static_cast<uint64_t>(Next()) * bound) >> 32 ); }
+        inline uint8_t  Byte()                  { return static_cast<uint8_t>(Next() >> 24); }
+        inline bool     Chance( uint32_t pct )  { return Below(100) < pct; }
+
+    private:
+        std::mt19937 m_gen;
+    };
+
+    /*
+        Bytes with no structure at all. Worst case for compression.
+    */
+    std::vector<uint8_t> MakeRandomBytes( CorpusRNG & rng, size_t len );
+
+    /*
+        Tiled indexed pixels shaped like a character sprite: a blob of opaque pixels in the middle,
+        made of horizontal runs of a few colors, surrounded by fully transparent tiles.
+        - bpp : 4 or 8.
+    */
+    std::vector<uint8_t> MakeSpriteLikeImg( CorpusRNG & rng, uint32_t width, uint32_t height, unsigned int bpp );
+
+    /*
+        Dialogue-like strings made of pseudo words, with the odd line break and text tag.
+    */
+    std::vector<std::string> MakeTextTable( CorpusRNG & rng, size_t nbstrings );
+
+    /*
+        The strings of the table, each followed by a 0, as they'd be in a string block.
+    */
+    std::vector<uint8_t> FlattenTextTable( const std::vector<std::string> & strings );
+
+    /*
+        A table of "nbentries" 16 bytes entries, each containing a pointer to some variable length data
+        after the table, wrapped in a SIR0 container with the list of all those pointers.
+    */
+    std::vector<uint8_t> MakeSIR0Blob( CorpusRNG & rng, size_t nbentries );
+
+    /*
+        Valid SWDL and SMDL headers, followed by random data up to the length in the header.
+    */
+    std::vector<uint8_t> MakeSWDLShaped( CorpusRNG & rng, size_t len );
+    std::vector<uint8_t> MakeSMDLShaped( CorpusRNG & rng, size_t len );
+
+    /*
+        Mono PCM16 samples: a few overlapping tones with decaying envelopes, plus a little noise.
+    */
+    std::vector<int16_t> MakePCM16( CorpusRNG & rng, size_t nbsamples );
+
+    /*
+        A DSE 0x415 bank of "nbsamples" PCM16 samples made with MakePCM16, each played by its own
+        single split program, all in the global keygroup.
+    */
+    DSE::PresetBank MakePresetBank( CorpusRNG & rng, size_t nbsamples );
+
+    /*
+        An EoS script with "nbroutines" routines of "nbinstperroutine" Wait instructions ending on End,
+        and "nbstrings" english strings.
+    */
+    pmd2::Script MakeScript( CorpusRNG & rng, size_t nbroutines, size_t nbinstperroutine, size_t nbstrings );
+};
+
+#endif
@@ -0,0 +1,590 @@
+#include "ppmdu_bench.hpp"
+#include "bench_corpora.hpp"
+#include <ppmdu/fmts/px_compression.hpp>
+#include <ppmdu/fmts/pack_file.hpp>
+#include <ppmdu/fmts/sir0.hpp>
+#include <ppmdu/fmts/text_str.hpp>
+#include <ppmdu/fmts/ssb.hpp>
+#include <ppmdu/fmts/swdl.hpp>
+#include <ppmdu/containers/tiled_image.hpp>
+#include <ppmdu/pmd2/pmd2_configloader.hpp>
+#include <ppmdu/pmd2/sprite_rle.hpp>
+#include <types/content_type_analyser.hpp>
+#include <ext_fmts/adpcm.hpp>
+#include <ext_fmts/sf2.hpp>
+#include <utils/cmdline_util.hpp>
+#include <utils/library_wide.hpp>
+#include <utils/utility.hpp>
+#include <utils/whereami_wrapper.hpp>
+#include <Poco/Exception.h>
+#include <Poco/File.h>
+#include <Poco/Path.h>
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <numeric>
+#include <sstream>
+using namespace std;
+using namespace utils::cmdl;
+
+namespace ppmdu_bench
+{
+//=================================================================================================
+// Constants
+//=================================================================================================
+    static const string OPTION_RUNS   = "runs";
+    static const string OPTION_SEED   = "seed";
+    static const string OPTION_FILTER = "filter";
+    static const string OPTION_CFG    = "cfg";
+    static const string OPTION_PROFILE = "profile";
+
+    static const std::vector<optionparsing_t> MY_OPTIONS =
+    {{
+        { OPTION_RUNS,   1, "Nb of timed runs for each benchmark. Defaults to 10.", },
+        { OPTION_SEED,   1, "Seed used to generate the test data. Defaults to 1.", },
+        { OPTION_FILTER, 1, "Only run the benchmarks whose name contains this string.", },
+        { OPTION_CFG,    1, "Path to the pmd2data.xml file, needed by the script benchmarks.", },
+        { OPTION_PROFILE,1, "Record a Chrome trace of the run, and write it to the specified file.", },
+    }};
+
+    static const string EXE_NAME         = "ppmdu_bench";
+    static const string PVERSION         = PPMDU_BENCH_VER;
+    static const string DefOutputFName   = "ppmdu_bench.json";
+
+    //Corpus sizes. PX compressed data must stay under 64 KiB, since its length is stored on 16 bits.
+    static const size_t   PXCorpusLen    = 32 * 1024;
+    static const uint32_t SpriteWidth    = 128;
+    static const uint32_t SpriteHeight   = 128;
+    static const size_t   NbTextStrings  = 2000;
+    static const size_t   NbPackEntries  = 256;
+    static const size_t   NbSIR0Entries  = 4096;
+    static const size_t   NbClassified   = 256;
+    static const size_t   NbPCMSamples   = 64 * 1024;
+    static const size_t   NbSF2Samples   = 16;
+    static const size_t   NbSWDLSamples  = 64;
+
+    struct bench_params
+    {
+        size_t      nbruns  = 10;
+        uint32_t    seed    = 1;
+        string      filter;
+        string      cfgpath;
+        string      outpath = DefOutputFName;
+    };
+
+    //Results of the benchmarked functions are folded into this, so the work can't be optimized away
+    static volatile size_t Sink = 0;
+
+    inline void KeepResult( size_t value )
+    {
+        Sink = Sink + value;    //Compound assignment to a volatile is deprecated since C++20
+    }
+
+//=================================================================================================
+// BenchRunner
+//=================================================================================================
+    inline string JSONEscape( const string & str )
+    {
+        stringstream sstr;
+        for( char c : str )
+        {
+            switch(c)
+            {
+                case '"':  { sstr <<"\\\""; break; }
+                case '\\': { sstr <<"\\\\"; break; }
+                case '\n': { sstr <<"\\n";  break; }
+                case '\t': { sstr <<"\\t";  break; }
+                default:
+                {
+                    if( static_cast<unsigned char>(c) < 0x20 )
+                        sstr <<"\\u" <<hex <<setfill('0') <<setw(4) <<static_cast<unsigned int>(c) <<dec;
+                    else
+                        sstr <<c;
+                }
+            };
+        }
+        return sstr.str();
+    }
+
+    void BenchRunner::AddResult( const string & name, const string & corpus, size_t nbbytes, vector<uint64_t> && samples )
+    {
+        bench_result res;
+        res.name    = name;
+        res.corpus  = corpus;
+        res.nbbytes = nbbytes;
+        res.nbruns  = samples.size();
+        if( !samples.empty() )
+        {
+            sort( samples.begin(), samples.end() );
+            res.minns    = samples.front();
+            res.medianns = samples[samples.size() / 2];
+            res.meanns   = static_cast<double>( accumulate( samples.begin(), samples.end(), uint64_t(0) ) ) / samples.size();
+        }
+
+        cout <<"  " <<left <<setw(28) <<name <<setw(10) <<corpus <<right
+             <<setw(12) <<(res.medianns / 1000) <<" us";
+        if( nbbytes != 0 )
+            cout <<setw(10) <<fixed <<setprecision(2) <<res.MBPerSec() <<" MB/s";
+        cout <<"\n";
+        m_results.push_back( std::move(res) );
+    }
+
+    void BenchRunner::Skip( const string & name, const string & corpus, const string & reason )
+    {
+        if( !IsSelected(name) )
+            return;
+        bench_result res;
+        res.name       = name;
+        res.corpus     = corpus;
+        res.bskipped   = true;
+        res.skipreason = reason;
+        cout <<"  " <<left <<setw(28) <<name <<setw(10) <<corpus <<right <<"skipped: " <<reason <<"\n";
+        m_results.push_back( std::move(res) );
+    }
+
+    void BenchRunner::WriteJSON( ostream & os, uint32_t seed )const
+    {
+        os <<"{\n"
+           <<"  \"tool\": \"" <<EXE_NAME <<"\",\n"
+           <<"  \"version\": \"" <<JSONEscape(PVERSION) <<"\",\n"
+           <<"  \"seed\": " <<seed <<",\n"
+           <<"  \"runs\": " <<m_nbruns <<",\n"
+           <<"  \"results\": [\n";
+        for( size_t i = 0; i < m_results.size(); ++i )
+        {
+            const bench_result & res = m_results[i];
+            os <<"    { \"name\": \"" <<JSONEscape(res.name) <<"\", \"corpus\": \"" <<JSONEscape(res.corpus) <<"\", ";
+            if( res.bskipped )
+                os <<"\"skipped\": true, \"reason\": \"" <<JSONEscape(res.skipreason) <<"\" }";
+            else
+            {
+                os <<"\"bytes\": " <<res.nbbytes <<", \"runs\": " <<res.nbruns
+                   <<", \"min_ns\": " <<res.minns <<", \"median_ns\": " <<res.medianns
+                   <<", \"mean_ns\": " <<fixed <<setprecision(1) <<res.meanns
+                   <<", \"mb_per_s\": " <<setprecision(3) <<res.MBPerSec() <<" }";
+            }
+            os <<( (i + 1 < m_results.size())? ",\n" : "\n" );
+        }
+        os <<"  ]\n"
+           <<"}\n";
+    }
+
+//=================================================================================================
+// Benchmarks
+//=================================================================================================
+    void BenchPX( BenchRunner & runner, CorpusRNG & rng )
+    {
+        using namespace ::compression;
+        const vector<pair<string, vector<uint8_t>>> corpora =
+        {
+            { "random", MakeRandomBytes( rng, PXCorpusLen ) },
+            { "sprite", MakeSpriteLikeImg( rng, SpriteWidth, SpriteHeight * 4, 4 ) },
+            { "text",   FlattenTextTable( MakeTextTable( rng, 800 ) ) },
+        };
+
+        for( const auto & corpus : corpora )
+        {
+            const vector<uint8_t> & data = corpus.second;
+            vector<uint8_t> compressed;
+            runner.Run( "px/compress", corpus.first, data.size(), [&]()
+            {
+                compressed.clear();
+                KeepResult( CompressPX( data.begin(), data.end(), compressed, ePXCompLevel::LEVEL_3, false, false ).compressedsz );
+            });
+
+            //Compress once more in case the compression benchmark was filtered out
+            compressed.clear();
+            const px_info_header info = CompressPX( data.begin(), data.end(), compressed, ePXCompLevel::LEVEL_3, false, false );
+            vector<uint8_t> decompressed( info.decompressedsz );
+            runner.Run( "px/decompress", corpus.first, data.size(), [&]()
+            {
+                DecompressPX( info, compressed.begin(), compressed.end(), decompressed.begin(), decompressed.end() );
+                KeepResult( decompressed.back() );
+            });
+        }
+    }
+
+    void BenchPack( BenchRunner & runner, CorpusRNG & rng )
+    {
+        vector<vector<uint8_t>> subfiles;
+        size_t                  totalsz = 0;
+        for( size_t i = 0; i < NbPackEntries; ++i )
+        {
+            subfiles.push_back( MakeRandomBytes( rng, 16 + rng.Below(4096) ) );
+            totalsz += subfiles.back().size();
+        }
+
+        runner.Run( "pack/write", "random", totalsz, [&]()
+        {
+            ::filetypes::CPack pack{ vector<vector<uint8_t>>(subfiles) };
+            KeepResult( pack.OutputPack().size() );
+        });
+
+        const vector<uint8_t> packdata = ::filetypes::CPack( vector<vector<uint8_t>>(subfiles) ).OutputPack();
+        runner.Run( "pack/load", "random", packdata.size(), [&]()
+        {
+            ::filetypes::CPack pack;
+            pack.LoadPack( packdata.begin(), packdata.end() );
+            KeepResult( pack.getNbSubFiles() );
+        });
+    }
+
+    void BenchTiledImg( BenchRunner & runner, CorpusRNG & rng )
+    {
+        const utils::Resolution res{ SpriteWidth, SpriteHeight };
+        const vector<uint8_t>   img4 = MakeSpriteLikeImg( rng, SpriteWidth, SpriteHeight, 4 );
+        const vector<uint8_t>   img8 = MakeSpriteLikeImg( rng, SpriteWidth, SpriteHeight, 8 );
+
+        runner.Run( "tiledimg/parse_4bpp", "sprite", img4.size(), [&]()
+        {
+            gimg::tiled_image_i4bpp out;
+            gimg::ParseTiledImg<gimg::tiled_image_i4bpp>( img4.begin(), img4.end(), res, out );
+            KeepResult( out.getNbPixelWidth() );
+        });
+
+        runner.Run( "tiledimg/parse_8bpp", "sprite", img8.size(), [&]()
+        {
+            gimg::tiled_image_i8bpp out;
+            gimg::ParseTiledImg<gimg::tiled_image_i8bpp>( img8.begin(), img8.end(), res, out );
+            KeepResult( out.getNbPixelWidth() );
+        });
+
+        vector<pmd2::compression::zero_strip_run> runs;
+        runner.Run( "zerostrip/find_runs", "sprite", img8.size(), [&]()
+        {
+            runs.clear();
+            pmd2::compression::FindZeroStripRuns( img8.data(), img8.data() + img8.size(), runs );
+            KeepResult( runs.size() );
+        });
+    }
+
+    void BenchTextStr( BenchRunner & runner, CorpusRNG & rng, const string & tempdir )
+    {
+        const vector<string> strings = MakeTextTable( rng, NbTextStrings );
+        const string         fpath   = Poco::Path(tempdir).setFileName("text_e.str").toString();
+        pmd2::filetypes::WriteTextStrFile( fpath, strings, pmd2::eGameRegion::NorthAmerica );
+        const size_t         fsize   = static_cast<size_t>( Poco::File(fpath).getSize() );
+
+        runner.Run( "text_str/write", "text", fsize, [&]()
+        {
+            pmd2::filetypes::WriteTextStrFile( fpath, strings, pmd2::eGameRegion::NorthAmerica );
+        });
+
+        runner.Run( "text_str/load", "text", fsize, [&]()
+        {
+            KeepResult( pmd2::filetypes::ParseTextStrFile( fpath, pmd2::eGameRegion::NorthAmerica ).size() );
+        });
+    }
+
+    void BenchSIR0( BenchRunner & runner, CorpusRNG & rng )
+    {
+        //Building the blob covers filling the wrapper, and encoding the pointer list. Reseed every run so each run builds the same blob.
+        const uint32_t        blobseed = rng.Next();
+        CorpusRNG             blobrng( blobseed );
+        const vector<uint8_t> blob     = MakeSIR0Blob( blobrng, NbSIR0Entries );
+
+        runner.Run( "sir0/build", "sir0", blob.size(), [&]()
+        {
+            CorpusRNG runrng( blobseed );
+            KeepResult( MakeSIR0Blob( runrng, NbSIR0Entries ).size() );
+        });
+
+        ::filetypes::sir0_header hdr;
+        hdr.ReadFromContainer( blob.begin(), blob.end() );
+        const vector<uint8_t> encodedlst( blob.begin() + hdr.ptrPtrOffsetLst, blob.end() );
+        runner.Run( "sir0/decode_ptrlist", "sir0", encodedlst.size(), [&]()
+        {
+            KeepResult( ::filetypes::DecodeSIR0PtrOffsetList( encodedlst ).size() );
+        });
+    }
+
+    void BenchContentTypes( BenchRunner & runner, CorpusRNG & rng )
+    {
+        vector<vector<uint8_t>> files;
+        size_t                  totalsz = 0;
+        for( size_t i = 0; i < NbClassified; ++i )
+        {
+            switch( i % 4 )
+            {
+                case 0:  { files.push_back( MakeSWDLShaped( rng, 256 + rng.Below(8192) ) ); break; }
+                case 1:  { files.push_back( MakeSMDLShaped( rng, 256 + rng.Below(8192) ) ); break; }
+                case 2:  { files.push_back( MakeSIR0Blob( rng, 8 + rng.Below(64) ) );       break; }
+                default: { files.push_back( MakeRandomBytes( rng, 256 + rng.Below(8192) ) ); }
+            };
+            totalsz += files.back().size();
+        }
+
+        runner.Run( "content/classify", "mixed", totalsz, [&]()
+        {
+            KeepResult( ::filetypes::DetermineCntTys( files, false ).size() );
+        });
+        runner.Run( "content/classify_parallel", "mixed", totalsz, [&]()
+        {
+            KeepResult( ::filetypes::DetermineCntTys( files, true ).size() );
+        });
+    }
+
+    void BenchADPCM( BenchRunner & runner, CorpusRNG & rng )
+    {
+        const vector<int16_t> pcm   = MakePCM16( rng, NbPCMSamples );
+        audio::ADPCMEncoderParams fastparams;
+        fastparams.encoder = audio::eADPCMEncoder::Greedy;
+
+        runner.Run( "adpcm/encode_nds", "pcm16", pcm.size() * sizeof(int16_t), [&]()
+        {
+            KeepResult( audio::EncodeADPCM_NDS( pcm, fastparams ).size() );
+        });
+
+        const vector<uint8_t> adpcm = audio::EncodeADPCM_NDS( pcm, fastparams );
+        runner.Run( "adpcm/decode_nds", "pcm16", adpcm.size(), [&]()
+        {
+            KeepResult( audio::DecodeADPCM_NDS( adpcm ).size() );
+        });
+    }
+
+    void BenchSF2( BenchRunner & runner, CorpusRNG & rng, const string & tempdir )
+    {
+        vector<vector<int16_t>> samples;
+        size_t                  totalsz = 0;
+        for( size_t i = 0; i < NbSF2Samples; ++i )
+        {
+            samples.push_back( MakePCM16( rng, 4096 + rng.Below(16384) ) );
+            totalsz += samples.back().size() * sizeof(int16_t);
+        }
+        const string fpath = Poco::Path(tempdir).setFileName("bench.sf2").toString();
+
+        runner.Run( "sf2/write", "pcm16", totalsz, [&]()
+        {
+            sf2::SoundFont sf("bench");
+            for( size_t i = 0; i < samples.size(); ++i )
+            {
+                const string name   = "smpl_" + to_string(i);
+                const size_t smplid = sf.AddSample( sf2::Sample( samples[i].begin(), samples[i].end(), name, 0, static_cast<uint32_t>(samples[i].size()) ) );
+
+                sf2::ZoneBag instzone;
+                instzone.SetSampleId(smplid);
+                sf2::Instrument inst(name);
+                inst.AddZone( std::move(instzone) );
+                const size_t instid = sf.AddInstrument( std::move(inst) );
+
+                sf2::ZoneBag preszone;
+                preszone.SetInstrumentId(instid);
+                sf2::Preset pres( name, static_cast<uint16_t>(i) );
+                pres.AddZone( std::move(preszone) );
+                sf.AddPreset( std::move(pres) );
+            }
+            KeepResult( sf.Write(fpath) );
+        });
+    }
+
+    void BenchSWDL( BenchRunner & runner, CorpusRNG & rng, const string & tempdir )
+    {
+        DSE::PresetBank bank     = MakePresetBank( rng, NbSWDLSamples );
+        const string    basepath = Poco::Path(tempdir).setFileName("bench_base.swd").toString();
+        const string    fpath    = Poco::Path(tempdir).setFileName("bench.swd").toString();
+        DSE::WriteSWDL( basepath, bank );
+        const size_t    fsize    = static_cast<size_t>( Poco::File(basepath).getSize() );
+
+        runner.Run( "swdl/write", "swdl", fsize, [&]()
+        {
+            DSE::WriteSWDL( fpath, bank );
+        });
+
+        //Edit a single sample, so everything else gets copied from the base file
+        vector<uint8_t> & editedsmpl = *( bank.smplbank().lock()->sample(0) );
+        for( size_t i = 0; i < editedsmpl.size(); i += 2 )
+            editedsmpl[i] ^= 0x55;
+
+        runner.Run( "swdl/write_incremental", "swdl", fsize, [&]()
+        {
+            DSE::WriteSWDLIncremental( fpath, bank, basepath );
+        });
+    }
+
+    void BenchSSB( BenchRunner & runner, CorpusRNG & rng, const string & tempdir, const string & cfgpath )
+    {
+        static const char * const BenchSSBNames[] = { "ssb/compile", "ssb/decompile", };
+        if( !Poco::File(cfgpath).exists() )
+        {
+            for( const char * name : BenchSSBNames )
+                runner.Skip( name, "script", "Configuration file \"" + cfgpath + "\" not found" );
+            return;
+        }
+        if( !runner.IsSelected("ssb/") )
+            return;
+
+        pmd2::ConfigLoader          conf( pmd2::eGameVersion::EoS, pmd2::eGameRegion::NorthAmerica, cfgpath );
+        const pmd2::LanguageFilesDB & langdb = conf.GetLanguageFilesDB();
+        const pmd2::Script          scr     = MakeScript( rng, 64, 48, 400 );
+        const string          fpath   = Poco::Path(tempdir).setFileName("bench.ssb").toString();
+
+        ::filetypes::WriteScript( fpath, scr, pmd2::eGameRegion::NorthAmerica, pmd2::eGameVersion::EoS, langdb );
+        const size_t fsize = static_cast<size_t>( Poco::File(fpath).getSize() );
+
+        runner.Run( "ssb/compile", "script", fsize, [&]()
+        {
+            ::filetypes::WriteScript( fpath, scr, pmd2::eGameRegion::NorthAmerica, pmd2::eGameVersion::EoS, langdb );
+        });
+
+        runner.Run( "ssb/decompile", "script", fsize, [&]()
+        {
+            KeepResult( ::filetypes::ParseScript( fpath, pmd2::eGameRegion::NorthAmerica, pmd2::eGameVersion::EoS, langdb, false, false ).Routines().size() );
+        });
+    }
+
+//=================================================================================================
+// Utility
+//=================================================================================================
+    void PrintUsage()
+    {
+        cout << EXE_NAME <<" (option \"optionvalue\") \"outputpath\"\n\n"
+             << "-> option(opt)     : An optional option from the list below..\n"
+             << "-> optionvalue     : An optional value for the specified option..\n"
+             << "-> outputpath(opt) : Path to the JSON file to write the results to.\n"
+             << "                     Defaults to \"" <<DefOutputFName <<"\" in the current directory.\n\n"
+             << "Options:\n";
+        for( const auto & opt : MY_OPTIONS )
+            cout << "   -" <<left <<setw(8) <<opt.optionsymbol <<right <<": " <<opt.description <<"\n";
+        cout << "\nExample:\n"
+             << EXE_NAME <<" -" <<OPTION_RUNS <<" 20 -" <<OPTION_FILTER <<" px/ ./px_results.json\n\n"
+             << "All the data the benchmarks run on is generated from the seed, so no game files are needed,\n"
+             << "except the configuration file for the script benchmarks, which are skipped without it.\n"
+             << endl;
+    }
+
+    bool HandleArguments( int argc, const char * argv[], bench_params & params )
+    {
+        CArgsParser argsparser( vector<optionparsing_t>( MY_OPTIONS.begin(), MY_OPTIONS.end() ), argv, argc );
+        auto        optionsfound = argsparser.getAllFoundOptions();
+        string      firstarg     = argsparser.getNextParam();
+
+        if( !firstarg.empty() )
+        {
+            if( firstarg == "-h" || firstarg == "--help" )
+            {
+                PrintUsage();
+                return false;
+            }
+            params.outpath = firstarg;
+        }
+
+        for( auto & anoption : optionsfound )
+        {
+            if( anoption.size() != 2 )
+                continue;
+
+            if( anoption.front() == OPTION_RUNS )
+            {
+                stringstream sstr(anoption[1]);
+                sstr >> params.nbruns;
+                if( sstr.fail() || params.nbruns == 0 )
+                {
+                    cerr << "<!>-Invalid number of runs \"" <<anoption[1] <<"\"!\n";
+                    return false;
+                }
+            }
+            else if( anoption.front() == OPTION_SEED )
+            {
+                stringstream sstr(anoption[1]);
+                sstr >> params.seed;
+                if( sstr.fail() )
+                {
+                    cerr << "<!>-Invalid seed \"" <<anoption[1] <<"\"!\n";
+                    return false;
+                }
+            }
+            else if( anoption.front() == OPTION_FILTER )
+                params.filter = anoption[1];
+            else if( anoption.front() == OPTION_CFG )
+                params.cfgpath = anoption[1];
+            else if( anoption.front() == OPTION_PROFILE )
+                utils::Profiler().Enable( anoption[1] );
+        }
+
+        if( params.cfgpath.empty() )
+            params.cfgpath = Poco::Path(utils::GetPathExeDirectory()).setFileName(pmd2::DefConfigFileName).toString();
+        return true;
+    }
+
+    void RunBenchmarks( const bench_params & params )
+    {
+        BenchRunner runner( params.nbruns, params.filter );
+        CorpusRNG   rng( params.seed );
+
+        //Some formats are only read and written through files
+        Poco::Path tempdir( Poco::Path::temp() );
+        tempdir.pushDirectory( "ppmdu_bench_" + to_string(params.seed) );
+        Poco::File( tempdir ).createDirectories();
+        const string tempdirstr = tempdir.toString();
+
+        cout <<"Running benchmarks, " <<params.nbruns <<" runs each, seed " <<params.seed <<"..\n";
+        try
+        {
+            //Each benchmark gets its own generator, so filtering some out doesn't change the data of the others
+            { CorpusRNG brng( rng.Next() ); BenchPX          ( runner, brng ); }
+            { CorpusRNG brng( rng.Next() ); BenchPack        ( runner, brng ); }
+            { CorpusRNG brng( rng.Next() ); BenchTiledImg    ( runner, brng ); }
+            { CorpusRNG brng( rng.Next() ); BenchTextStr     ( runner, brng, tempdirstr ); }
+            { CorpusRNG brng( rng.Next() ); BenchSIR0        ( runner, brng ); }
+            { CorpusRNG brng( rng.Next() ); BenchContentTypes( runner, brng ); }
+            { CorpusRNG brng( rng.Next() ); BenchADPCM       ( runner, brng ); }
+            { CorpusRNG brng( rng.Next() ); BenchSF2         ( runner, brng, tempdirstr ); }
+            { CorpusRNG brng( rng.Next() ); BenchSSB         ( runner, brng, tempdirstr, params.cfgpath ); }
+            { CorpusRNG brng( rng.Next() ); BenchSWDL        ( runner, brng, tempdirstr ); }
+        }
+        catch(...)
+        {
+            Poco::File( tempdir ).remove(true);
+            throw;
+        }
+        Poco::File( tempdir ).remove(true);
+
+        ofstream outf( params.outpath );
+        if( !outf.good() )
+            throw runtime_error("RunBenchmarks(): Couldn't open output file \"" + params.outpath + "\"!");
+        runner.WriteJSON( outf, params.seed );
+        cout <<"\nWrote " <<runner.Results().size() <<" results to \"" <<params.outpath <<"\"\n";
+    }
+};
+
+//=================================================================================================
+// Main Function
+//=================================================================================================
+int main( int argc, const char * argv[] )
+{
+    using namespace ppmdu_bench;
+    int          returnval = 0;
+    bench_params params;
+
+    cout <<"==================================================\n"
+         <<"==  ppmdu benchmarks - " <<PVERSION <<"\n"
+         <<"==================================================\n"
+         <<endl;
+
+    try
+    {
+        if( HandleArguments( argc, argv, params ) )
+        {
+            RunBenchmarks( params );
+            utils::Profiler().Finish();
+        }
+        else
+            returnval = -1;
+    }
+    catch( Poco::Exception & e )
+    {
+        cerr << "<!>-Poco Exception : " <<e.message() <<endl;
+        returnval = e.code();
+    }
+    catch( exception & e )
+    {
+        cerr << "<!>-Exception : " << e.what() <<endl;
+        returnval = -1;
+    }
+
+#ifdef _DEBUG
+    utils::PortablePause();
+#endif
+
+    return returnval;
+}
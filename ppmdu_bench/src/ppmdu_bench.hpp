@@ -0,0 +1,94 @@
+#ifndef PPMDU_BENCH_HPP
+#define PPMDU_BENCH_HPP
+/*
+ppmdu_bench.hpp
+2016/07/17
+psycommando@gmail.com
+Description: Times the library's parsers, writers and codecs on synthetic data, and writes the results as JSON.
+             Meant for comparing builds and changes against each other, without needing a ROM.
+*/
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace ppmdu_bench
+{
+    /*
+        bench_result
+            Timings of a single benchmark, in nanoseconds per run.
+    */
+    struct bench_result
+    {
+        std::string name;
+        std::string corpus;
+        size_t      nbbytes     = 0;    //Amount of input bytes processed by a single run, used for the throughput
+        size_t      nbruns      = 0;
+        uint64_t    minns       = 0;
+        uint64_t    medianns    = 0;
+        double      meanns      = 0.0;
+        bool        bskipped    = false;
+        std::string skipreason;
+
+        inline double MBPerSec()const
+        {
+            return (medianns != 0)? (static_cast<double>(nbbytes) * 1000.0) / static_cast<double>(medianns) : 0.0;
+        }
+    };
+
+    /*
+        BenchRunner
+            Runs each benchmark once to warm up, then "nbruns" times while timing each run.
+            Only the benchmarks whose name contains the filter string are run. An empty filter runs everything.
+    */
+    class BenchRunner
+    {
+    public:
+        BenchRunner( size_t nbruns, const std::string & filter )
+            :m_nbruns(nbruns), m_filter(filter)
+        {}
+
+        inline bool IsSelected( const std::string & name )const
+        {
+            return m_filter.empty() || name.find(m_filter) != std::string::npos;
+        }
+
+        template<class _FUN>
+            void Run( const std::string & name, const std::string & corpus, size_t nbbytes, _FUN && fun )
+        {
+            if( !IsSelected(name) )
+                return;
+            fun();
+
+            std::vector<uint64_t> samples;
+            samples.reserve(m_nbruns);
+            for( size_t i = 0; i < m_nbruns; ++i )
+            {
+                const auto tstart = std::chrono::steady_clock::now();
+                fun();
+                const auto tend   = std::chrono::steady_clock::now();
+                samples.push_back( static_cast<uint64_t>( std::chrono::duration_cast<std::chrono::nanoseconds>(tend - tstart).count() ) );
+            }
+            AddResult( name, corpus, nbbytes, std::move(samples) );
+        }
+
+        /*
+            Records a benchmark that couldn't run, so it still shows up in the results.
+        */
+        void Skip( const std::string & name, const std::string & corpus, const std::string & reason );
+
+        void WriteJSON( std::ostream & os, uint32_t seed )const;
+
+        inline const std::vector<bench_result> & Results()const { return m_results; }
+
+    private:
+        void AddResult( const std::string & name, const std::string & corpus, size_t nbbytes, std::vector<uint64_t> && samples );
+
+        size_t                    m_nbruns;
+        std::string               m_filter;
+        std::vector<bench_result> m_results;
+    };
+};
+
+#endif
@@ -4,15 +4,18 @@
 //#include <ppmdu/pmd2/pmd2_sprites.hpp>
 #include <ppmdu/pmd2/pmd2_filetypes.hpp>
 #include <ppmdu/containers/sprite_data.hpp>
+#include <ppmdu/containers/sprite_binary_io.hpp>
 #include <utils/multiple_task_handler.hpp>
 #include <utils/library_wide.hpp>
 #include <ppmdu/fmts/wan.hpp>
 #include <ppmdu/fmts/pack_file.hpp>
 #include <ppmdu/fmts/pkdpx.hpp>
 #include <ppmdu/fmts/at4px.hpp>
+#include <ppmdu/fmts/px_compression_cache.hpp>
 #include <ppmdu/fmts/wte.hpp>
 #include <ppmdu/fmts/bgp.hpp>
 #include <ppmdu/fmts/kao.hpp>
+#include <ppmdu/fmts/nitrofs.hpp>
 #include <ppmdu/containers/level_tileset.hpp>
 #include <ppmdu/fmts/bpc.hpp>
 #include <ppmdu/fmts/bpl.hpp>
@@ -195,10 +198,14 @@ namespace gfx_util
     {
         cout <<"Parsing sprites..\n";
         out_table.resize( srcpack.getNbSubFiles() );
+
+        //Classify all subfiles at once
+        vector<ContentBlock> cnttypes = DetermineCntTys( srcpack.SubFiles() );
+
         for( unsigned int i = 0; i < srcpack.getNbSubFiles(); )
         {
             auto & curSubFile = srcpack.getSubFile(i);
-            auto   cnttype    = DetermineCntTy( curSubFile.begin(), curSubFile.end() );
+            auto & cnttype    = cnttypes[i];
 
             //
             if( cnttype._type == CnTy_WAN )
@@ -375,6 +382,14 @@ namespace gfx_util
             "-log",
             std::bind( &CGfxUtil::ParseOptionLog, &GetInstance(), placeholders::_1 ),
         },
+        //Record a trace of the run
+        {
+            "profile",
+            1,
+            "Record a Chrome trace of the run, and write it to the specified file.",
+            "-profile \"trace.json\"",
+            std::bind( &CGfxUtil::ParseOptionProfile, &GetInstance(), placeholders::_1 ),
+        },
         //Image Format For Export
         {
             "f",
@@ -455,6 +470,30 @@ namespace gfx_util
             "-noresfix",
             std::bind( &CGfxUtil::ParseOptionNoResFix,  &GetInstance(), placeholders::_1 ),
         },
+        //Cache compressed images between runs
+        {
+            "pxcache",
+            1,
+            "Sets the path to a file where compressed images are cached between runs. Images that didn't change since the last run are not compressed again.",
+            "-pxcache \"PathToFile\"",
+            std::bind( &CGfxUtil::ParseOptionPXCache,  &GetInstance(), placeholders::_1 ),
+        },
+        //Export sprite frames to a single sheet
+        {
+            "atlas",
+            0,
+            "If specified, the frames of exported sprites are packed into a single PNG sheet, with a manifest of the position of each frames, instead of one image per frame. Sprites exported this way are rebuilt from the sheet automatically.",
+            "-atlas",
+            std::bind( &CGfxUtil::ParseOptionSpriteAtlas,  &GetInstance(), placeholders::_1 ),
+        },
+        //Export sprites to the binary sprite format
+        {
+            "sprbin",
+            0,
+            "If specified, sprites are exported to a single binary sprite file, instead of a directory. Binary sprites are much faster to read and write, but can't be edited by hand. Binary sprite files can be built back into sprites. Not supported when exporting pack files.",
+            "-sprbin",
+            std::bind( &CGfxUtil::ParseOptionSpriteBinary,  &GetInstance(), placeholders::_1 ),
+        },
 
 
     //=====================
@@ -569,6 +608,8 @@ namespace gfx_util
         m_ImportByIndex = false;
         m_bRedirectClog = false;
         m_bNoResAutoFix = false;
+        m_bSpriteAtlas  = false;
+        m_bSpriteBinary = false;
         m_execMode      = eExecMode::INVALID_Mode;
         m_PrefOutFormat = utils::io::eSUPPORT_IMG_IO::PNG;
 
@@ -647,14 +688,20 @@ namespace gfx_util
         {
             clog <<"4 bpp\n";
             auto sprite = parser.ParseAs4bpp();
-            graphics::ExportSpriteToDirectory( sprite, outpath.toString(), m_PrefOutFormat, false );
+            if( m_bSpriteBinary )
+                graphics::ExportSpriteToBinary( &sprite, outpath.toString() + "." + graphics::SPRITE_Binary_FileExtension );
+            else
+                graphics::ExportSpriteToDirectory( sprite, outpath.toString(), m_PrefOutFormat, false, nullptr, m_bSpriteAtlas );
             
         }
         else if( sprty == graphics::eSpriteImgType::spr8bpp )
         {
             clog <<"8 bpp\n";
             auto sprite = parser.ParseAs8bpp();
-            graphics::ExportSpriteToDirectory( sprite, outpath.toString(), m_PrefOutFormat, false );
+            if( m_bSpriteBinary )
+                graphics::ExportSpriteToBinary( &sprite, outpath.toString() + "." + graphics::SPRITE_Binary_FileExtension );
+            else
+                graphics::ExportSpriteToDirectory( sprite, outpath.toString(), m_PrefOutFormat, false, nullptr, m_bSpriteAtlas );
         }
 
         //draw one last time
@@ -683,6 +730,31 @@ namespace gfx_util
 
         outpath = m_outputPath;
 
+        if( infileinfo.isFile() )
+        {
+            //Binary sprites already have everything in a single file
+            auto       sprite = graphics::ImportSpriteFromBinary( infileinfo.path() );
+            WAN_Writer writer( sprite.get() );
+
+            if( m_compressToPKDPX )
+            {
+                vector<uint8_t> result  = writer.write();
+                vector<uint8_t> outdata;
+                CompressToPKDPX( result.begin(), result.end(), outdata );
+                utils::io::WriteByteVectorToFile( outpath.setExtension(PKDPX_FILEX).toString(), outdata );
+            }
+            else
+                writer.write( outpath.setExtension(WAN_FILEX).toString() );
+
+            if( ! m_bQuiet )
+            {
+                cout << "\nIts super-effective!!\n"
+                     <<"\"" <<inputPath.getFileName() <<"\" fainted!\n"
+                     <<"You got \"" <<outpath.getFileName() <<"\" for your victory!\n";
+            }
+            return 0;
+        }
+
         auto sprty = graphics::QuerySpriteImgTypeFromDirectory( infileinfo.path() );
 
         if( sprty == graphics::eSpriteImgType::spr4bpp )
@@ -749,9 +821,16 @@ namespace gfx_util
         //Currently, we do not support raw image export on sprites !
         ChkAndHndlUnsupportedRawOutput();
 
+        //Packs are only built back from sprite directories, so binary sprites would be a dead end
+        if( m_bSpriteBinary )
+        {
+            cerr << "<!>-ERROR: -sprbin can't be used when exporting a pack file! Packs can only be rebuilt from sprite directories.\n";
+            return -1;
+        }
+
         auto lambdaExpSpriteWrap = [&]( const graphics::BaseSprite * srcspr, const std::string & outpath )->bool
         {
-            graphics::ExportSpriteToDirectoryPtr(srcspr, outpath, m_PrefOutFormat);
+            graphics::ExportSpriteToDirectoryPtr(srcspr, outpath, m_PrefOutFormat, false, nullptr, m_bSpriteAtlas);
             ++completed;
             return true;
         };
@@ -1042,7 +1121,9 @@ namespace gfx_util
 
         string outfilepath = outpath.toString();
         cout <<"\n\nBuilding \"" <<outfilepath <<"\"...\n";
+        ::filetypes::NitroROMMount rommount( outfilepath ); //The pack may be written straight into a ROM image
         utils::io::WriteByteVectorToFile( outfilepath, mypack.OutputPack() );
+        rommount.Commit();
         cout <<"\nDone!\n";
 
         return 0;
@@ -1087,7 +1168,7 @@ namespace gfx_util
         ParseASprite( decompBuf, targetptr );
 
         //Write it out
-        graphics::ExportSpriteToDirectoryPtr( targetptr.get(), outpath.toString(), m_PrefOutFormat );
+        graphics::ExportSpriteToDirectoryPtr( targetptr.get(), outpath.toString(), m_PrefOutFormat, false, nullptr, m_bSpriteAtlas );
 
         //write output message
         if( ! m_bQuiet )
@@ -1250,6 +1331,13 @@ namespace gfx_util
         {
             //Working on a file
             vector<uint8_t> tmp    = utils::io::ReadFileToByteVector(theinput.path());
+
+            if( graphics::IsSpriteBinaryData( tmp.begin(), tmp.end() ) )
+            {
+                m_execMode = eExecMode::BUILD_WAN_Mode;
+                return true;
+            }
+
             auto            result = DetermineCntTy(tmp.begin(), tmp.end(), inputPath.getExtension());
 
             if( result._type == CnTy_WAN )
@@ -1529,12 +1617,43 @@ namespace gfx_util
         return m_bRedirectClog = true;
     }
 
+    bool CGfxUtil::ParseOptionProfile( const std::vector<std::string> & optdata )
+    {
+        cout <<"<*>-Recording a trace of the run to \"" <<optdata[1] <<"\"!\n";
+        utils::Profiler().Enable( optdata[1] );
+        return true;
+    }
+
     bool CGfxUtil::ParseOptionNoResFix( const std::vector<std::string> & optdata )
     {
         cout <<"<*>-noresfix specified. Utility will not attempt to get correct resolution from the images in case of mismatch. Data from the XML file will be forced!\n";
         return m_bNoResAutoFix = true;
     }
 
+    bool CGfxUtil::ParseOptionSpriteAtlas( const std::vector<std::string> & optdata )
+    {
+        cout <<"<*>-atlas specified. Sprite frames will be exported to a single sheet!\n";
+        return m_bSpriteAtlas = true;
+    }
+
+    bool CGfxUtil::ParseOptionSpriteBinary( const std::vector<std::string> & optdata )
+    {
+        cout <<"<*>-sprbin specified. Sprites will be exported to binary sprite files!\n";
+        return m_bSpriteBinary = true;
+    }
+
+    bool CGfxUtil::ParseOptionPXCache( const std::vector<std::string> & optdata )
+    {
+        if( optdata.size() == 2 )
+        {
+            cout <<"<*>-Using compression cache \"" <<optdata.back() <<"\"!\n";
+            ::compression::PXCompressionCache::GetInstance().Load( optdata.back() );
+            return true;
+        }
+        else
+            return false;
+    }
+
 
     //New System
     bool CGfxUtil::ParseOptionForceExport( const std::vector<std::string> & optdata )
@@ -1642,6 +1761,9 @@ namespace gfx_util
             else
                 returnval = ExecOld();
 
+            //Keep whatever got compressed for the next run
+            ::compression::PXCompressionCache::GetInstance().Save();
+
             if( ! m_bQuiet && returnval == 0 )
                 cout << "\n\nPoochyena used Rest! ...zZz..zZz...\n";
         }
@@ -1918,7 +2040,7 @@ namespace gfx_util
     const std::string Monster_Dir     = "MONSTER";
 
 
-    void ExportASpritePackFile( const std::string & fpath, const std::string & outdir, utils::io::eSUPPORT_IMG_IO imgty, const std::vector<string> & pokesprnames )
+    void ExportASpritePackFile( const std::string & fpath, const std::string & outdir, utils::io::eSUPPORT_IMG_IO imgty, const std::vector<string> & pokesprnames, bool useatlas )
     {
         future<void>                 updtProgress;
         atomic<bool>                 shouldUpdtProgress = true;
@@ -1937,7 +2059,7 @@ namespace gfx_util
 
             auto lambdaExpSpriteWrap = [&]( const graphics::BaseSprite * srcspr, const std::string & outpath )->bool
             {
-                graphics::ExportSpriteToDirectoryPtr(srcspr, outpath, imgty);
+                graphics::ExportSpriteToDirectoryPtr(srcspr, outpath, imgty, false, nullptr, useatlas);
                 ++completed;
                 return true;
             };
@@ -2039,7 +2161,7 @@ namespace gfx_util
             outdir.createDirectory();
 
         CKaomado kao;
-        KaoParser()( inpath.toString(), kao );
+        KaoParser( false, false, utils::LibWide().getNbThreadsToUse() > 1 )( inpath.toString(), kao );
 
         //Load pokemon name and face names from the game text!
         auto gamedetails = pmd2::DetermineGameVersionAndLocale( m_inputPath );
@@ -2119,9 +2241,13 @@ namespace gfx_util
             throw runtime_error(sstr.str());
         }
 
-        CKaomado kao;
-        KaoParser()( inkao.toString(), kao );
-        KaoWriter()( kao, outkao.toString() );
+        //Compressing the portraits is slow, so spread it over threads when we can
+        const bool bparallel = utils::LibWide().getNbThreadsToUse() > 1;
+        CKaomado   kao;
+        KaoParser( false, false, bparallel )( inkao.toString(), kao );
+        ::filetypes::NitroROMMount rommount( outkao.toString() );
+        KaoWriter( nullptr, nullptr, true, false, false, bparallel )( kao, outkao.toString() );
+        rommount.Commit();
     }
 
     void CGfxUtil::DoExportPokeSprites()
@@ -2202,7 +2328,7 @@ namespace gfx_util
             }
             else
             {
-                ExportASpritePackFile( inspr.path(), outsubdirfile.path(), m_PrefOutFormat, pknames );
+                ExportASpritePackFile( inspr.path(), outsubdirfile.path(), m_PrefOutFormat, pknames, m_bSpriteAtlas );
             }
         }
 
@@ -2416,6 +2542,7 @@ namespace gfx_util
         
         //Execute the utility
         returnval = Execute();
+        utils::Profiler().Finish();
 
 #ifdef _DEBUG
         utils::PortablePause();
@@ -71,8 +71,12 @@ namespace gfx_util
         bool ParseOptionBuildPack       ( const std::vector<std::string> & optdata );
         bool ParseOptionNbThreads       ( const std::vector<std::string> & optdata );
         bool ParseOptionLog             ( const std::vector<std::string> & optdata );
+        bool ParseOptionProfile         ( const std::vector<std::string> & optdata );
 
         bool ParseOptionNoResFix        ( const std::vector<std::string> & optdata );
+        bool ParseOptionPXCache         ( const std::vector<std::string> & optdata );
+        bool ParseOptionSpriteAtlas     ( const std::vector<std::string> & optdata );
+        bool ParseOptionSpriteBinary    ( const std::vector<std::string> & optdata );
 
         bool ParseOptionForceExport     ( const std::vector<std::string> & optdata );
         bool ParseOptionForceImport     ( const std::vector<std::string> & optdata );
@@ -174,6 +178,8 @@ namespace gfx_util
         bool                           m_bRedirectClog;   //Whether we should redirect clog to a file
         bool                           m_bNoResAutoFix;   //Whether in case of resolution mismatch between the sprite XML data and the images, the utility will autofix
                                                           // the content of meta-frames with the resolution of the corresponding image!
+        bool                           m_bSpriteAtlas;    //Whether sprite frames are exported to a single sheet instead of one image per frame
+        bool                           m_bSpriteBinary;   //Whether sprites are exported to a binary sprite file instead of a directory
         eExecMode                      m_execMode;        //This is set after reading the input path.
 
         std::string                    m_inputPath;      //This is the input path that was parsed 
@@ -9,6 +9,7 @@ Description:
 #include "ppmd_packfileutil.hpp"
 #include <ppmdu/pmd2/pmd2_filetypes.hpp>
 #include <ppmdu/fmts/pack_file.hpp>
+#include <ppmdu/fmts/px_compression_cache.hpp>
 #include <utils/utility.hpp>
 #include <utils/library_wide.hpp>
 #include <utils/cmdline_util.hpp>
@@ -30,10 +31,14 @@ namespace ppmd_packfileutil
 // Constants 
 //=================================================================================================
     static const string                    ALIGN_FIRST_OFFSET_SYMBOL = "a";
-    static const array<optionparsing_t, 1> MY_OPTIONS =
-    {
+    static const string                    PROFILE_SYMBOL            = "profile";
+    static const string                    PXCACHE_SYMBOL            = "pxcache";
+    static const array<optionparsing_t, 3> MY_OPTIONS =
+    {{
         { ALIGN_FIRST_OFFSET_SYMBOL, 1 }, //Align first entry to forced offset
-    };
+        { PROFILE_SYMBOL,            1 }, //Record a trace of the run
+        { PXCACHE_SYMBOL,            1 }, //Cache PX compressed data between runs
+    }};
 
     static const string OUTPUT_FOLDER_SUFFIX; //= "_out";
     static const string EXE_NAME             = "ppmd_packfileutil.exe";
@@ -93,6 +98,10 @@ namespace ppmd_packfileutil
              << "      -" <<ALIGN_FIRST_OFFSET_SYMBOL <<" \"offset\" : Specifying this will make the program attempt to\n"
              << "                      align the first file to the specified offset\n"
              << "                      (offset is in heaxadecimal !) !\n"
+             << "      -" <<PROFILE_SYMBOL <<" \"file\" : Record a Chrome trace of the run, and write\n"
+             << "                      it to the specified file.\n"
+             << "      -" <<PXCACHE_SYMBOL <<" \"file\" : Cache any PX compressed data in the specified\n"
+             << "                      file, so it isn't compressed again on the next run.\n"
              << "\n"
 		     << "Example:\n"
              << "---------\n"
@@ -171,21 +180,31 @@ namespace ppmd_packfileutil
             if( !paramTwo.empty() )
                 outputpath = paramTwo;
 
-            if( !validoptsfound.empty() && validoptsfound.front().size() == 2 )
+            for( const auto & anoption : validoptsfound )
             {
-                stringstream sstr;
-                unsigned int foffset = 0;
-
-                sstr << validoptsfound.front()[1];
-                if( validoptsfound.front()[1].find( "0x", 0 ) != string::npos )
-                    sstr >> hex >> foffset;
-                else
-                    sstr >> foffset;
-
-                if( foffset != 0 )
-                    forcedoffset = foffset;
-                else
-                    cerr << "!-WARNING: Forced offset of 0 is invalid and will be ignored !!\n";
+                if( anoption.size() != 2 )
+                    continue;
+
+                if( anoption.front() == ALIGN_FIRST_OFFSET_SYMBOL )
+                {
+                    stringstream sstr;
+                    unsigned int foffset = 0;
+
+                    sstr << anoption[1];
+                    if( anoption[1].find( "0x", 0 ) != string::npos )
+                        sstr >> hex >> foffset;
+                    else
+                        sstr >> foffset;
+
+                    if( foffset != 0 )
+                        forcedoffset = foffset;
+                    else
+                        cerr << "!-WARNING: Forced offset of 0 is invalid and will be ignored !!\n";
+                }
+                else if( anoption.front() == PROFILE_SYMBOL )
+                    Profiler().Enable( anoption[1] );
+                else if( anoption.front() == PXCACHE_SYMBOL )
+                    ::compression::PXCompressionCache::GetInstance().Load( anoption[1] );
             }
 
             return true;
@@ -303,6 +322,8 @@ int main( int argc, const char * argv[] )
             DoUnpack( inputpath, PrepareOutputPath( false, inputpath, outputpath ) );
         }
     }
+    ::compression::PXCompressionCache::GetInstance().Save();
+    Profiler().Finish();
 
 #ifdef _DEBUG
         utils::PortablePause();
@@ -0,0 +1,267 @@
+#include "ppmdu_patchutil.hpp"
+#include <ppmdu/fmts/rom_patch.hpp>
+#include <utils/cmdline_util.hpp>
+#include <utils/library_wide.hpp>
+#include <utils/poco_wrapper.hpp>
+#include <utils/trace_profiler.hpp>
+#include <utils/utility.hpp>
+#include <Poco/Exception.h>
+#include <array>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+using namespace utils::cmdl;
+using namespace std;
+using namespace utils;
+
+namespace patchutil
+{
+//=================================================================================================
+// Constants
+//=================================================================================================
+    static const string                          OPTION_THREADS = "th";
+    static const string                          OPTION_NOPX    = "nopx";
+    static const string                          OPTION_PROFILE = "profile";
+    static const std::vector<optionparsing_t>    MY_OPTIONS     =
+    {{
+        //Sets the number of threads to use
+        {
+            OPTION_THREADS,
+            1,
+            "Set the maximum number of threads to use.",
+        },
+        //Disables comparing PX compressed files decompressed
+        {
+            OPTION_NOPX,
+            0,
+            "Compare PX compressed files as they are, instead of decompressed.",
+        },
+        //Option to record a trace of the run
+        {
+            OPTION_PROFILE,
+            1,
+            "Record a Chrome trace of the run, and write it to the specified file.",
+        },
+    }};
+
+    static const string EXE_NAME             = "ppmd_patchutil.exe";
+    static const string PVERSION             = PATCHUTIL_VER;
+
+    //The parsed parameters
+    struct patchutil_params
+    {
+        string patchpath;     //Patch to write when making one, or to read when applying one
+        string oldroot;       //Root to make the patch from
+        string newroot;       //Root to make the patch to
+        string targetroot;    //Root to apply the patch to
+        bool   bapply;
+        bool   bpxaware;
+    };
+
+//=================================================================================================
+// Handlers
+//=================================================================================================
+    void PrintPatchSummary( const ::filetypes::rom_patch & patch )
+    {
+        static const array<const char*,4> OpNames{{ "added", "removed", "changed", "changed (PX)" }};
+        array<size_t,4> nbentries{};
+        size_t          payloadlen = 0;
+        for( const auto & entry : patch.entries )
+        {
+            ++nbentries[static_cast<size_t>(entry.op)];
+            payloadlen += entry.payload.size();
+        }
+
+        for( size_t i = 0; i < OpNames.size(); ++i )
+            cout << "\t" <<nbentries[i] <<" file(s) " <<OpNames[i] <<"\n";
+        cout << "\t" <<payloadlen <<" bytes of patch data\n";
+    }
+
+    void DoMakePatch( const patchutil_params & params )
+    {
+        cout << "Comparing \"" <<params.oldroot <<"\" to \"" <<params.newroot <<"\" on "
+             <<LibWide().getNbThreadsToUse() <<" thread(s)..\n";
+        ::filetypes::rom_patch patch = ::filetypes::MakeRomPatch( params.oldroot, params.newroot, params.bpxaware );
+        PrintPatchSummary(patch);
+
+        cout << "Writing patch to \"" <<params.patchpath <<"\"..\n";
+        ::filetypes::WriteRomPatch( params.patchpath, patch );
+    }
+
+    void DoApplyPatch( const patchutil_params & params )
+    {
+        cout << "Reading patch \"" <<params.patchpath <<"\"..\n";
+        ::filetypes::rom_patch patch = ::filetypes::ReadRomPatch( params.patchpath );
+        PrintPatchSummary(patch);
+
+        cout << "Patching \"" <<params.targetroot <<"\" on " <<LibWide().getNbThreadsToUse() <<" thread(s)..\n";
+        ::filetypes::ApplyRomPatch( patch, params.targetroot );
+    }
+
+//=================================================================================================
+// Utility
+//=================================================================================================
+    void PrintUsage()
+    {
+	    cout << EXE_NAME <<"  (option \"optionvalue\") \"oldroot\" \"newroot\" \"patchpath\"\n"
+             << EXE_NAME <<"  (option \"optionvalue\") \"patchpath\" \"romroot\"\n\n"
+             << "-> option(opt)     : An optional option from the list below..\n"
+             << "-> optionvalue     : An optional value for the specified option..\n"
+		     << "-> oldroot         : Extracted ROM directory, or .nds file, to make the patch from.\n"
+		     << "-> newroot         : Extracted ROM directory, or .nds file, to make the patch to.\n"
+		     << "-> patchpath       : The patch file. Ends with \"." <<::filetypes::RomPatch_FileExt <<"\".\n"
+		     << "-> romroot         : Extracted ROM directory, or .nds file, to apply the patch to.\n\n\n"
+             << "Options:\n"
+             << "   -" <<OPTION_THREADS <<" (nb threads)       : Sets the maximum number of threads to use.\n"
+             << "                            Defaults to all the cores.\n"
+             << "   -" <<OPTION_NOPX <<"                  : Compare PX compressed files as they are,\n"
+             << "                            instead of decompressed.\n"
+             << "   -" <<OPTION_PROFILE <<" (trace file)      : Record a Chrome trace of the run, and write\n"
+             << "                            it to the specified file.\n"
+		     << "Example:\n"
+             <<EXE_NAME <<" ./rom_original ./rom_modded ./mymod." <<::filetypes::RomPatch_FileExt <<"\n"
+		     <<EXE_NAME <<" ./original.nds ./modded.nds ./mymod." <<::filetypes::RomPatch_FileExt <<"\n"
+             <<EXE_NAME <<" ./mymod." <<::filetypes::RomPatch_FileExt <<" ./rom_original\n"
+             << "\n\n"
+             << "Makes a patch containing only the differences between two versions of\n"
+             << "the game's files, or applies one. Every file is checked before it is\n"
+             << "patched, so a patch applied to the wrong files changes nothing.\n"
+             << "Files can't be added to, or removed from a .nds file.\n"
+             << "----------------------------------------------------------\n"
+		     << "No crappyrights, all wrongs reversed !\n"
+             << "(In short, consider this Public Domain, or CC0!)\n"
+             << "Sources and specs Included in original package!\n" <<endl;
+    }
+
+
+    bool HandleArguments( int argc, const char * argv[], patchutil_params & params )
+    {
+        //#0 - Handle options
+        CArgsParser        argsparser( vector<optionparsing_t>( MY_OPTIONS.begin(), MY_OPTIONS.end() ), argv, argc );
+        auto               optionsfound = argsparser.getAllFoundOptions();
+        string             firstarg     = argsparser.getNextParam(),
+                           secondarg    = argsparser.getNextParam(),
+                           thirdarg     = argsparser.getNextParam();
+
+        if( firstarg.empty() || secondarg.empty() )
+        {
+            PrintUsage();
+            return false;
+        }
+
+        //#1 - Handle the parameters
+        if( thirdarg.empty() )
+        {
+            if( !utils::isFile(firstarg) || utils::GetFileExtension(firstarg) != ::filetypes::RomPatch_FileExt )
+            {
+                cerr << "<!>-Fatal Error: The patch file \"" <<firstarg <<"\" doesn't exist, or isn't a ." <<::filetypes::RomPatch_FileExt <<" file!\n";
+                return false;
+            }
+            if( !utils::pathExists(secondarg) )
+            {
+                cerr << "<!>-Fatal Error: The rom root \"" <<secondarg <<"\" doesn't exist!\n";
+                return false;
+            }
+            params.bapply     = true;
+            params.patchpath  = firstarg;
+            params.targetroot = secondarg;
+        }
+        else
+        {
+            if( !utils::pathExists(firstarg) || !utils::pathExists(secondarg) )
+            {
+                cerr << "<!>-Fatal Error: Old or new rom root path invalid!\n";
+                return false;
+            }
+            params.bapply    = false;
+            params.oldroot   = firstarg;
+            params.newroot   = secondarg;
+            params.patchpath = thirdarg;
+        }
+
+        //#2 - Get all valid command line options !
+        for( auto & anoption : optionsfound )
+        {
+            if( anoption.size() == 2 && anoption.front().compare(OPTION_THREADS) == 0 )
+            {
+                stringstream sstr;
+                unsigned int nbthreads = 1;
+                sstr << anoption[1];
+                sstr >> nbthreads;
+
+                if( nbthreads > 0 && nbthreads < thread::hardware_concurrency() )
+                    LibWide().setNbThreadsToUse(nbthreads);
+                else
+                    LibWide().setNbThreadsToUse(thread::hardware_concurrency());
+            }
+            else if( anoption.size() == 2 && anoption.front().compare(OPTION_PROFILE) == 0 )
+                Profiler().Enable( anoption[1] );
+            else if( anoption.size() == 1 && anoption.front().compare(OPTION_NOPX) == 0 )
+            {
+                params.bpxaware = false;
+                cout<<"-" <<OPTION_NOPX <<" specified, comparing PX compressed files as they are!\n";
+            }
+        }
+
+        return true;
+    }
+
+};
+//=================================================================================================
+// Main Function
+//=================================================================================================
+int main( int argc, const char * argv[] )
+{
+    using namespace patchutil;
+    int returnval = 0;
+    patchutil_params params =
+    {
+        "",     //Patch path
+        "",     //Old root
+        "",     //New root
+        "",     //Target root
+        false,  //Apply a patch ?
+        true,   //Compare PX files decompressed ?
+    };
+
+	cout <<"==================================================\n"
+            <<"==  PMD:EoS/T/D Patch Utility - "<<PVERSION <<" ==\n"
+            <<"==================================================\n"
+            <<"Makes and applies patches to the game's files.\n"
+            <<endl;
+
+    try
+    {
+        if( HandleArguments( argc, argv, params ) )
+        {
+            {
+                MrChronometer mychrono("Total");
+                if( params.bapply )
+                    DoApplyPatch( params );
+                else
+                    DoMakePatch( params );
+            }
+            Profiler().Finish();
+        }
+        else
+            returnval = -1;
+    }
+    catch( Poco::Exception & e )
+    {
+        cerr << "<!>-Poco Exception : " <<e.message() <<endl;
+        returnval = e.code();
+    }
+    catch( exception & e )
+    {
+        cerr << "<!>-Exception : " << e.what() <<endl;
+        returnval = -1;
+    }
+
+#ifdef _DEBUG
+    utils::PortablePause();
+#endif
+
+    return returnval;
+}
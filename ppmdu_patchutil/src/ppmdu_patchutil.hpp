@@ -0,0 +1,15 @@
+#ifndef PPMDU_PATCHUTIL_HPP
+#define PPMDU_PATCHUTIL_HPP
+/*
+ppmdu_patchutil.hpp
+2016/08/09
+psycommando@gmail.com
+Description:  Code for running the ROM patch utility! Makes patches between two versions of
+              the game's files, and applies them.
+*/
+
+
+namespace patchutil
+{
+};
+#endif
@@ -12,6 +12,7 @@
 #include <ppmdu/fmts/at4px.hpp>
 #include <ppmdu/fmts/pkdpx.hpp>
 #include <ppmdu/fmts/px_compression.hpp>
+#include <ppmdu/fmts/px_compression_cache.hpp>
 #include <utils/utility.hpp>
 #include <utils/utility.hpp>
 #include <utils/library_wide.hpp>
@@ -42,6 +43,8 @@ namespace ppx_compress
     static const string                          OPTION_COMPRESSION_LVL = "l";
     static const string                          OPTION_ZEALOUS         = "z";
     static const string                          OPTION_QUIET           = "q";
+    static const string                          OPTION_PROFILE         = "profile";
+    static const string                          OPTION_PXCACHE         = "pxcache";
     static const std::vector<optionparsing_t>    MY_OPTIONS     = 
     {{
         //Option to disable progress output
@@ -62,6 +65,18 @@ namespace ppx_compress
             0,
             "Prioritize compression efficiency over speed.\n Search for matching strings first, instead of\ntrying faster methods of compression first !", 
         },
+        //Option to record a trace of the run
+        {
+            OPTION_PROFILE,
+            1,
+            "Record a Chrome trace of the run, and write it to the specified file.",
+        },
+        //Option to cache compressed data between runs
+        {
+            OPTION_PXCACHE,
+            1,
+            "Sets the path to a file where compressed data is cached between runs.",
+        },
     }};
 
     static const string EXE_NAME             = "ppmd_pxcomp.exe";
@@ -173,6 +188,11 @@ namespace ppx_compress
              << "                            cost of speed!\n"
              << "   -"<<OPTION_QUIET  <<"                     : Disable console progress output.\n"
              << "                            This will make the whole thing a little faster!\n"
+             << "   -"<<OPTION_PROFILE <<" (trace file)      : Record a Chrome trace of the run, and write\n"
+             << "                            it to the specified file.\n"
+             << "   -"<<OPTION_PXCACHE <<" (cache file)      : Cache the compressed data in the specified\n"
+             << "                            file, so unchanged files aren't compressed\n"
+             << "                            again on the next run.\n"
 		     << "Example:\n"
              <<EXE_NAME <<" ./file.txt\n"
 		     <<EXE_NAME <<" ./file.sir0 ./\n"
@@ -250,6 +270,10 @@ namespace ppx_compress
                         }
 
                     }
+                    else if( anoption.size() == 2 && anoption.front().compare(OPTION_PROFILE) == 0 )
+                        Profiler().Enable( anoption[1] );
+                    else if( anoption.size() == 2 && anoption.front().compare(OPTION_PXCACHE) == 0 )
+                        PXCompressionCache::GetInstance().Load( anoption[1] );
 
                     if( anoption.size() == 1 )
                     {
@@ -310,8 +334,12 @@ int main( int argc, const char * argv[] )
     {
         if( HandleArguments( argc, argv, params ) )
         {
-            MrChronometer mychrono("Total");
-            ReadAndCompressFile( params );
+            {
+                MrChronometer mychrono("Total");
+                ReadAndCompressFile( params );
+            }
+            PXCompressionCache::GetInstance().Save();
+            Profiler().Finish();
         }
         else
             returnval = -1;
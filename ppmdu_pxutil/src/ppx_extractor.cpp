@@ -36,7 +36,8 @@ namespace ppx_extract
     static const string                          OPT_WRITE_LOG_SYMBOL          = "wl";
     static const string                          OPT_FORCE_FILEXTENSION_SYMBOL = "fext";
     static const string                          OPT_QUIET_SYMBOL              = "q";
-    static const array<optionparsing_t,3>        MY_OPTIONS     = 
+    static const string                          OPT_PROFILE_SYMBOL            = "profile";
+    static const array<optionparsing_t,4>        MY_OPTIONS     = 
     {{
         //Switch to enable logging the decompression process
         { 
@@ -58,6 +59,12 @@ namespace ppx_extract
             0,
             "Disable progress output to console! (faster!)",
         },
+        //Switch to record a trace of the run
+        {
+            OPT_PROFILE_SYMBOL,
+            1,
+            "Record a Chrome trace of the run, and write it to the specified file.",
+        },
     }};
 
     static const string EXE_NAME             = "ppmd_unpx.exe";
@@ -246,6 +253,8 @@ namespace ppx_extract
                     params.forcedextension = anoption[1];
                     cout <<"-" <<OPT_FORCE_FILEXTENSION_SYMBOL <<" was specified. Forcing output file extension to \"*." <<params.forcedextension <<"\"!\n";
                 }
+                else if( anoption.front().compare( OPT_PROFILE_SYMBOL ) == 0 )
+                    Profiler().Enable( anoption[1] );
                 else
                     cerr<<"Ecountered invalid option " <<anoption.front() <<" !\n";
             }
@@ -514,8 +523,11 @@ int main( int argc, const char * argv[] )
     {
         if( HandleArguments( argc, argv, params ) )//inputpaths, outputpaths, benablelogging ) )
         {
-            MrChronometer mychrono("Total");
-            DecompressAll( params );// inputpaths, outputpaths, benablelogging );
+            {
+                MrChronometer mychrono("Total");
+                DecompressAll( params );// inputpaths, outputpaths, benablelogging );
+            }
+            Profiler().Finish();
         }
         else
             return -1;
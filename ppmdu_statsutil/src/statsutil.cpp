@@ -6,10 +6,16 @@
 #include <ppmdu/fmts/waza_p.hpp>
 #include <ppmdu/fmts/text_str.hpp>
 #include <utils/library_wide.hpp>
+#include <utils/async_logger.hpp>
 #include <ppmdu/pmd2/pmd2_xml_sniffer.hpp>
 #include <ppmdu/pmd2/pmd2_asm.hpp>
+#include <ppmdu/pmd2/game_stats_index.hpp>
+#include <ppmdu/fmts/nitrofs.hpp>
+#include <ppmdu/fmts/px_compression_cache.hpp>
 #include <utils/poco_wrapper.hpp>
 #include <utils/whereami_wrapper.hpp>
+#include <utils/local_server.hpp>
+#include <utils/gfileutils.hpp>
 #include <iostream>
 #include <iomanip>
 #include <sstream>
@@ -57,6 +63,7 @@ namespace statsutil
     //const std::string CStatsUtil::DefExportMvDir     = "moves_data";
     //const std::string CStatsUtil::DefExportItemsDir  = "items_data";
     const std::string CStatsUtil::DefExportAllDir        = "exported_data";
+    const std::string CStatsUtil::DefLibLogName          = "log_lib.txt";
     //const std::string CStatsUtil::DefLangConfFile        = "gamelang.xml";
 
     //const std::string CStatsUtil::DefExportScriptsDir = "exported_scripts";
@@ -249,6 +256,29 @@ namespace statsutil
             std::bind( &CStatsUtil::ParseOptionDumpActorList, &GetInstance(), placeholders::_1 ),
         },
 
+        //statsindex
+        {
+            "statsindex",
+            0,
+            "Dump the Pokemon, learnset, move and item data as csv tables, to the output directory specified. "
+            "Meant to be used along with \"-romroot\".",
+            "-romroot \"path/to/extracted/rom/root/directory\" -statsindex \"path/to/output/directory\"",
+            std::bind( &CStatsUtil::ParseOptionStatsIndex, &GetInstance(), placeholders::_1 ),
+        },
+
+        //serve
+        {
+            "serve",
+            0,
+            "Keep the game data loaded, and process import/export requests received on the local socket at the path specified, "
+            "one line per request. Meant to be used along with \"-romroot\". Not available on Windows. "
+            "Requests: \"export <what> <dir>\", \"import <what> <dir>\", \"statsindex <dir>\", \"reload\", \"ping\" and \"shutdown\". "
+            "<what> is a comma separated list of \"all\", \"pokemon\", \"moves\", \"items\", \"text\" and \"scripts\". "
+            "Paths containing spaces must be double quoted. Each request gets a single line reply, starting with either \"ok\" or \"error\".",
+            "-romroot \"path/to/extracted/rom/root/directory\" -serve \"path/to/socket\"",
+            std::bind( &CStatsUtil::ParseOptionServe, &GetInstance(), placeholders::_1 ),
+        },
+
 ////////////////////////////////////////////////////////////////////////////////////////////
         //Set nb threads to use
         {
@@ -266,6 +296,22 @@ namespace statsutil
             "-log",
             std::bind( &CStatsUtil::ParseOptionLog, &GetInstance(), placeholders::_1 ),
         },
+        //Record a trace of the run
+        {
+            "profile",
+            1,
+            "Record a Chrome trace of the run, and write it to the specified file.",
+            "-profile \"trace.json\"",
+            std::bind( &CStatsUtil::ParseOptionProfile, &GetInstance(), placeholders::_1 ),
+        },
+        //Cache compressed data between runs
+        {
+            "pxcache",
+            1,
+            "Sets the path to a file where compressed data is cached between runs. Data that didn't change since the last run is not compressed again.",
+            "-pxcache \"PathToFile\"",
+            std::bind( &CStatsUtil::ParseOptionPXCache, &GetInstance(), placeholders::_1 ),
+        },
     }};
 
 
@@ -461,6 +507,20 @@ namespace statsutil
         return true;
     }
 
+    bool CStatsUtil::ParseOptionProfile( const std::vector<std::string> & optdata )
+    {
+        cout <<"<*>-Recording a trace of the run to \"" <<optdata[1] <<"\"!\n";
+        utils::Profiler().Enable( optdata[1] );
+        return true;
+    }
+
+    bool CStatsUtil::ParseOptionPXCache( const std::vector<std::string> & optdata )
+    {
+        cout <<"<*>-Using compression cache \"" <<optdata[1] <<"\"!\n";
+        ::compression::PXCompressionCache::GetInstance().Load( optdata[1] );
+        return true;
+    }
+
     bool CStatsUtil::ParseOptionRomRoot( const std::vector<std::string> & optdata )
     {
         if( optdata.size() > 1 )
@@ -518,6 +578,19 @@ namespace statsutil
         return m_dumpactorlist = true;
     }
 
+    bool CStatsUtil::ParseOptionStatsIndex( const std::vector<std::string> & optdata )
+    {
+        cout << "<!>- Dumping stats index from the rom's data!\n";
+        m_operationMode = eOpMode::DumpStatsIndex;
+        return true;
+    }
+
+    bool CStatsUtil::ParseOptionServe( const std::vector<std::string> & optdata )
+    {
+        m_operationMode = eOpMode::Serve;
+        return true;
+    }
+
     bool CStatsUtil::ParseOptionScriptAsDir(const std::vector<std::string> & optdata )
     {
         cout << "<!>- Exporting/Importing Script XML as Directories!\n";
@@ -558,7 +631,9 @@ namespace statsutil
             //Now that the command line is parsed, do stuff with it
             if(utils::LibWide().isLogOn())
             {
-                utils::LibWide().Logger(new logging::SingleOutMTLogger);
+                //The library's log is written from a background thread, so it can't share clog's file
+                const string liblogpath = Poco::Path( utils::LibWide().StringValue(utils::lwData::eBasicValues::ProgramLogDir) ).setFileName(DefLibLogName).toString();
+                utils::LibWide().Logger(new logging::AsyncLogger(liblogpath));
                 utils::LibWide().Logger() << "Logger initiated!\n";
             }
             SetupCFGPath(m_pmd2cfg);
@@ -744,6 +819,8 @@ namespace statsutil
     {
         if( m_romrootdir.empty() )
             throw runtime_error("No extracted ROM root directory was specified using the \"-romroot\" option!");
+        if( ::filetypes::IsNitroROMPath( m_romrootdir ) && utils::isFile( m_romrootdir ) )
+            return; //The game loader mounts ROM images
         if( !utils::isFolder( m_romrootdir ) )
             throw runtime_error("Extracted ROM root directory path doesn't exist, or isn't a directory!");
     }
@@ -769,6 +846,7 @@ namespace statsutil
                              <<"================================================\n\n"
                             ;
                         returnval = HandleImport(m_firstparam, gloader);
+                        gloader.CommitRomImage();
                         break;
                     }
                     case eOpForce::Export:
@@ -785,6 +863,9 @@ namespace statsutil
             else if(!m_romrootdir.empty())
             {
                 ValidateRomRoot();
+                if( m_operationMode == eOpMode::Serve )
+                    return DoServe(m_firstparam);
+
                 GameDataLoader gloader( m_romrootdir, m_pmd2cfg );
                 gloader.AnalyseGame();
 
@@ -801,6 +882,11 @@ namespace statsutil
                         ValidateRomRoot();
                         return DoDumpActorList(m_firstparam, gloader );
                     }
+
+                    case eOpMode::DumpStatsIndex:
+                    {
+                        return DoDumpStatsIndex(m_firstparam, gloader );
+                    }
                 };
             }
             else //This is for mainly drag and drop stuff!!
@@ -1026,7 +1112,7 @@ namespace statsutil
             Pkmndatadir.append(pmd2::GameStats::DefPkmnDir);
             if( utils::isFolder(Pkmndatadir.toString()) )
             {
-                pgamestats->ImportPkmn(Pkmndatadir.toString());
+                pgamestats->ImportPkmn(Pkmndatadir.toString(), true);
                 pgamestats->WritePkmn();
             }
             else
@@ -1045,7 +1131,7 @@ namespace statsutil
 
             if( utils::isFolder(mvdatadir.toString()) )
             {
-                pgamestats->ImportMoves(mvdatadir.toString());
+                pgamestats->ImportMoves(mvdatadir.toString(), true);
                 pgamestats->WriteMoves ();
             }
             else
@@ -1064,7 +1150,7 @@ namespace statsutil
 
             if( utils::isFolder(itemdatadir.toString()) )
             {
-                pgamestats->ImportItems(itemdatadir.toString());
+                pgamestats->ImportItems(itemdatadir.toString(), true);
                 pgamestats->WriteItems();
             }
             else
@@ -1146,7 +1232,7 @@ namespace statsutil
 
             const string targetdir = Poco::Path(outpath).append(GameStats::DefPkmnDir).toString();
             CreateDirIfDoesntExist(targetdir);
-            pgamestats->ExportPkmn( targetdir );
+            pgamestats->ExportPkmn( targetdir, true );
         }
 
         if(m_hndlMoves || bhandleall)
@@ -1156,7 +1242,7 @@ namespace statsutil
 
             const string targetdir = Poco::Path(outpath).append(GameStats::DefMvDir).toString();
             CreateDirIfDoesntExist(targetdir);
-            pgamestats->ExportMoves(targetdir);
+            pgamestats->ExportMoves(targetdir, true);
         }
 
         if(m_hndlItems || bhandleall)
@@ -1166,7 +1252,7 @@ namespace statsutil
 
             const string targetdir = Poco::Path(outpath).append(GameStats::DefItemsDir).toString();
             CreateDirIfDoesntExist(targetdir);
-            pgamestats->ExportItems(targetdir);
+            pgamestats->ExportItems(targetdir, true);
         }
 
         return 0;
@@ -1282,6 +1368,270 @@ namespace statsutil
     }
 
 
+    int CStatsUtil::DoDumpStatsIndex( std::string fpath, pmd2::GameDataLoader & gloader )
+    {
+        if( fpath.empty() )
+            fpath = "stats_index";
+
+        Poco::File outdir(fpath);
+        if( !outdir.exists() )
+            outdir.createDirectories();
+
+        cout<<"Loading game data..\n";
+        GameStats * pstats = gloader.InitStats();
+        if( !pstats )
+            throw runtime_error("CStatsUtil::DoDumpStatsIndex(): Couldn't load game stats!");
+
+        cout<<"Indexing..\n";
+        GameStatsIndex index(*pstats);
+        cout<<"\t" <<index.Pokemon().Count() <<" Pokemon, " <<index.Learnsets().Count() <<" learnset entries, "
+            <<index.Moves().Count() <<" moves, " <<index.Items().Count() <<" items.\n";
+
+        cout<<"Writing csv tables to \"" <<fpath <<"\"..\n";
+        index.WriteCSV(fpath);
+        cout<<"Done with stats index!\n";
+        return 0;
+    }
+
+//--------------------------------------------
+//  Server Mode
+//--------------------------------------------
+    /*
+        State of the files the resident game data was loaded from.
+        Each value changes whenever anything in the files it covers changes.
+    */
+    struct serverstamps
+    {
+        uint64_t base    = 0; //Configuration xml files, arm9 and overlays. The whole loader is rebuilt when those change.
+        uint64_t text    = 0;
+        uint64_t stats   = 0;
+        uint64_t scripts = 0;
+    };
+
+    struct CStatsUtil::serverstate
+    {
+        unique_ptr<GameDataLoader> gloader;
+        serverstamps               stamps;
+        unsigned int               nbrequests = 0;
+    };
+
+    inline serverstamps GetServerStamps( const string & romroot, const string & cfgpath )
+    {
+        serverstamps stamps;
+        const string romdir  = utils::TryAppendSlash(romroot);
+        const string datadir = romdir + DirName_DefData + "/";
+
+        //The main config file may refer to other xml files next to it
+        uint64_t cfgstamp = 0;
+        for( const auto & fname : utils::ListDirContent_FilesAndDirs( utils::GetPathOnly(cfgpath), false, true ) )
+        {
+            if( utils::GetFileExtension(fname) == XML_FExt )
+                cfgstamp = (cfgstamp * 31) ^ utils::GetPathStateStamp(fname);
+        }
+        //The files inside a ROM image can't be stamped one by one, so any change to the image reloads everything
+        if( ::filetypes::IsNitroROMPath(romroot) && utils::isFile(romroot) )
+        {
+            stamps.base    = (cfgstamp * 31) ^ utils::GetPathStateStamp(romroot);
+            stamps.text    = stamps.base;
+            stamps.stats   = stamps.base;
+            stamps.scripts = stamps.base;
+            return stamps;
+        }
+
+        stamps.base    = (cfgstamp * 31) ^ utils::GetPathStateStamp( romdir + "arm9.bin" );
+        stamps.base    = (stamps.base * 31) ^ utils::GetPathStateStamp( romdir + DirName_DefOverlay );
+        stamps.text    = utils::GetPathStateStamp( datadir + DirName_MESSAGE );
+        stamps.stats   = utils::GetPathStateStamp( datadir + DirName_BALANCE );
+        stamps.scripts = utils::GetPathStateStamp( datadir + DirName_SCRIPT );
+        return stamps;
+    }
+
+    /*
+        Splits a request line on whitespaces. Double quotes group words together.
+    */
+    inline vector<string> SplitServerRequest( const string & request )
+    {
+        vector<string> tokens;
+        string         cur;
+        bool           bintoken = false;
+        bool           binquote = false;
+        for( char c : request )
+        {
+            if( c == '"' )
+            {
+                binquote = !binquote;
+                bintoken = true;
+            }
+            else if( !binquote && isspace(static_cast<unsigned char>(c)) )
+            {
+                if( bintoken )
+                    tokens.push_back( std::move(cur) );
+                cur.clear();
+                bintoken = false;
+            }
+            else
+            {
+                cur.push_back(c);
+                bintoken = true;
+            }
+        }
+        if( binquote )
+            throw runtime_error("Unterminated double quote!");
+        if( bintoken )
+            tokens.push_back( std::move(cur) );
+        return tokens;
+    }
+
+    /*
+        Makes sure the resident game data matches what's on disk, dropping whatever changed since it was loaded.
+    */
+    void CStatsUtil::RefreshServerGameLoader( serverstate & state )
+    {
+        const serverstamps cur = GetServerStamps( m_romrootdir, m_pmd2cfg );
+
+        if( !state.gloader || cur.base != state.stamps.base )
+        {
+            if( state.gloader )
+                cout <<"<*>-Configuration or binaries changed, reloading everything..\n";
+            state.gloader.reset();
+            state.gloader.reset( new GameDataLoader( m_romrootdir, m_pmd2cfg ) );
+            state.gloader->AnalyseGame();
+        }
+        else
+        {
+            if( cur.text != state.stamps.text && state.gloader->GetGameText() )
+            {
+                cout <<"<*>-Game text changed, unloading it..\n";
+                state.gloader->UnloadGameText();
+            }
+            if( cur.stats != state.stamps.stats && state.gloader->GetStats() )
+            {
+                cout <<"<*>-Game stats changed, unloading them..\n";
+                state.gloader->UnloadStats();
+            }
+            if( cur.scripts != state.stamps.scripts && state.gloader->GetScripts() )
+            {
+                cout <<"<*>-Scripts changed, unloading them..\n";
+                state.gloader->UnloadScripts();
+            }
+        }
+        state.stamps = cur;
+    }
+
+    bool CStatsUtil::HandleServerRequest( const std::string & request, std::string & reply, serverstate & state )
+    {
+        ++state.nbrequests;
+        cout <<"\n<*>-Request #" <<state.nbrequests <<" : " <<request <<"\n";
+        try
+        {
+            const vector<string> args = SplitServerRequest(request);
+            if( args.empty() )
+                throw runtime_error("Empty request!");
+            const string & cmd = args.front();
+
+            if( cmd == "ping" )
+            {
+                reply = "ok pong";
+                return true;
+            }
+            else if( cmd == "shutdown" )
+            {
+                reply = "ok";
+                return false;
+            }
+            else if( cmd == "reload" )
+            {
+                state.gloader.reset();
+                RefreshServerGameLoader(state);
+                reply = "ok";
+                return true;
+            }
+
+            int returnval = 0;
+            if( cmd == "import" || cmd == "export" )
+            {
+                if( args.size() != 3 )
+                    throw runtime_error("Expected \"" + cmd + " <what> <dir>\"!");
+
+                m_hndlPkmn = m_hndlMoves = m_hndlItems = m_hndlStrings = m_hndlScripts = false;
+                stringstream sstrwhat(args[1]);
+                string       what;
+                while( getline( sstrwhat, what, ',' ) )
+                {
+                    if     ( what == "pokemon" ) m_hndlPkmn    = true;
+                    else if( what == "moves"   ) m_hndlMoves   = true;
+                    else if( what == "items"   ) m_hndlItems   = true;
+                    else if( what == "text"    ) m_hndlStrings = true;
+                    else if( what == "scripts" ) m_hndlScripts = true;
+                    else if( what != "all" )
+                        throw runtime_error("Unknown data type \"" + what + "\"!");
+                }
+
+                RefreshServerGameLoader(state);
+                if( cmd == "import" )
+                {
+                    if( !utils::isFolder(args[2]) )
+                        throw runtime_error("Input directory \"" + args[2] + "\" doesn't exist!");
+                    returnval = HandleImport( args[2], *state.gloader );
+                    state.gloader->CommitRomImage();
+                    //Imported scripts are written straight to disk, so reload them when next needed
+                    state.gloader->UnloadScripts();
+                }
+                else
+                    returnval = HandleExport( args[2], *state.gloader );
+            }
+            else if( cmd == "statsindex" )
+            {
+                if( args.size() != 2 )
+                    throw runtime_error("Expected \"statsindex <dir>\"!");
+                RefreshServerGameLoader(state);
+                returnval = DoDumpStatsIndex( args[1], *state.gloader );
+            }
+            else
+                throw runtime_error("Unknown request \"" + cmd + "\"!");
+
+            //Our own writes shouldn't count as changes, the resident data already matches them
+            state.stamps = GetServerStamps( m_romrootdir, m_pmd2cfg );
+            reply = "ok " + to_string(returnval);
+        }
+        catch( const Poco::Exception & e )
+        {
+            reply = "error POCO Exception - " + string(e.name()) + " : " + e.message();
+            cerr <<"\n<!>- " <<reply <<"\n";
+        }
+        catch( const exception & e )
+        {
+            stringstream strex;
+            utils::PrintNestedExceptions( strex, e );
+            reply = "error " + strex.str();
+            cerr <<"\n<!>- Exception caught! :\n" <<strex.str();
+            //Whatever was loaded might be in a half modified state now
+            state.gloader.reset();
+        }
+        return true;
+    }
+
+    int CStatsUtil::DoServe( const std::string & sockpath )
+    {
+        if( sockpath.empty() )
+            throw runtime_error("CStatsUtil::DoServe(): No socket path specified!");
+
+        serverstate state;
+        cout <<"Loading game data..\n";
+        RefreshServerGameLoader(state);
+
+        utils::LocalLineServer server(sockpath);
+        cout <<"================================================\n"
+             <<"Listening on \"" <<sockpath <<"\"\n"
+             <<"================================================\n";
+        server.Run( [this, &state]( const string & request, string & reply )
+        {
+            return HandleServerRequest( request, reply, state );
+        });
+        cout <<"Shutting down after " <<state.nbrequests <<" requests.\n";
+        return 0;
+    }
+
     int CStatsUtil::DoDumpActorList( std::string fpath, pmd2::GameDataLoader & gloader )
     {
         const pmd2::ConfigLoader & confload = MainPMD2ConfigWrapper::CfgInstance();
@@ -1603,15 +1953,18 @@ namespace statsutil
         
         if( m_outputPath.empty() )
             throw runtime_error("Output path is empty!");
-            
+
+        //The output may be a .nds file, or a directory in one
+        ::filetypes::NitroROMMount rommount( m_outputPath );
         if( !utils::isFolder( m_outputPath ) )
             throw runtime_error("Output path doesn't exist, or isn't a directory!");
 
         outpath = Poco::Path(m_outputPath);
 
         GameStats gstats ( m_outputPath, m_langconf );
-        gstats.ImportAll( m_firstparam );
+        gstats.ImportAll( m_firstparam, true );
         gstats.Write();
+        rommount.Commit();
         return 0;
     }
 
@@ -1639,7 +1992,7 @@ namespace statsutil
             cout << "Created output directory \"" << fTestOut.path() <<"\"!\n";
             fTestOut.createDirectory();
         }
-        gstats.ExportAll(outpath.toString());
+        gstats.ExportAll(outpath.toString(), true);
         return 0;
     }
 
@@ -1720,6 +2073,10 @@ namespace statsutil
         //Execute the utility
         returnval = Execute();
 
+        //Keep whatever got compressed for the next run
+        ::compression::PXCompressionCache::GetInstance().Save();
+        utils::Profiler().Finish();
+
         return returnval;
     }
 };
@@ -50,6 +50,8 @@ namespace statsutil
         bool ParseOptionForceExport( const std::vector<std::string> & optdata );
         bool ParseOptionLocaleStr  ( const std::vector<std::string> & optdata );
         bool ParseOptionLog        ( const std::vector<std::string> & optdata );
+        bool ParseOptionProfile    ( const std::vector<std::string> & optdata );
+        bool ParseOptionPXCache    ( const std::vector<std::string> & optdata );
         bool ParseOptionScripts    ( const std::vector<std::string> & optdata );
         bool ParseOptionConfig     ( const std::vector<std::string> & optdata );
         bool ParseOptionRomRoot    ( const std::vector<std::string> & optdata );
@@ -58,6 +60,8 @@ namespace statsutil
         bool ParseOptionScriptEnableDebugInstr( const std::vector<std::string> & optdata );
         bool ParseOptionDumpLvlList( const std::vector<std::string> & optdata );
         bool ParseOptionDumpActorList( const std::vector<std::string> & optdata );
+        bool ParseOptionStatsIndex   ( const std::vector<std::string> & optdata );
+        bool ParseOptionServe        ( const std::vector<std::string> & optdata );
         bool ParseOptionScriptAsDir(const std::vector<std::string> & optdata ); 
 
         //Execution
@@ -98,6 +102,13 @@ namespace statsutil
 
         int DoDumpLevelList( std::string fpath, pmd2::GameDataLoader & gloader );
         int DoDumpActorList( std::string fpath, pmd2::GameDataLoader & gloader );
+        int DoDumpStatsIndex( std::string fpath, pmd2::GameDataLoader & gloader );
+
+        //Server mode
+        struct serverstate;
+        int  DoServe                ( const std::string & sockpath );
+        bool HandleServerRequest    ( const std::string & request, std::string & reply, serverstate & state );
+        void RefreshServerGameLoader( serverstate & state );
 
         int HandleImport( const std::string & frompath, pmd2::GameDataLoader & gloader );
         int HandleExport( const std::string & topath,   pmd2::GameDataLoader & gloader );
@@ -123,6 +134,7 @@ namespace statsutil
         //static const std::string                                 DefExportMvDir;
         //static const std::string                                 DefExportItemsDir;
         static const std::string                                 DefExportAllDir;
+        static const std::string                                 DefLibLogName;
 //        static const std::string                                 DefExportScriptsDir;
 
         //static const std::string                                 DefLangConfFile;
@@ -163,6 +175,8 @@ namespace statsutil
 
             DumpLevelList,
             DumpActorList,
+            DumpStatsIndex,
+            Serve,
 
             ImportAll,
             ExportAll,